@@ -1,8 +1,11 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 #include <pthread.h>
 
+#include "rkav/wait.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -14,6 +17,7 @@ typedef struct {
     size_t          head;
     size_t          tail;
     int             closed;
+    RkavWait        wait;           // 等待策略（见 rkav/wait.h）
     pthread_mutex_t mtx;
     pthread_cond_t  not_empty;
     pthread_cond_t  not_full;
@@ -22,14 +26,17 @@ typedef struct {
 // 返回值约定：
 //  - push: 0=成功, 1=队列满(try_push), -1=队列已关闭
 //  - pop:  1=成功取到元素, 0=队列已关闭且已空, -1=错误
+//  - pop_timeout: 同 pop，另外 2=超时仍无元素
 
-int    bq_init(BQueue *q, size_t capacity);
+int    bq_init(BQueue *q, size_t capacity);                    // 等价于 bq_init_wait(q, capacity, RKAV_WAIT_PARK)
+int    bq_init_wait(BQueue *q, size_t capacity, RkavWait wait);
 void   bq_close(BQueue *q);
 void   bq_destroy(BQueue *q);
 
 int    bq_push(BQueue *q, void *item);      // 阻塞直到有空间 / 或 close
 int    bq_try_push(BQueue *q, void *item);  // 不阻塞
 int    bq_pop(BQueue *q, void **out);       // 阻塞直到有元素 / 或 close
+int    bq_pop_timeout(BQueue *q, void **out, uint64_t timeout_us); // 最多等待 timeout_us
 
 size_t bq_size(BQueue *q);
 size_t bq_capacity(BQueue *q);
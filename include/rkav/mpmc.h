@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rkav/wait.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 有界无锁 MPMC 队列（Vyukov：每个槽位一个序号，入队/出队各自 CAS 一个游标）。
+// 用于多路管线共享的工作池（写盘 / 分析），生产者与消费者之间、同侧线程之间都不争锁；
+// 阻塞等待走 futex，只有真正有线程在等时才进内核。
+// 接口与 BQueue 一一对应，close 语义相同。
+
+typedef struct {
+    atomic_size_t   seq;
+    void           *item;
+} MpmcCell;
+
+typedef struct {
+    MpmcCell       *cells;
+    size_t          mask;           // 容量 - 1（容量向上取 2 的幂）
+    RkavWait        wait;           // 等待策略（见 rkav/wait.h）
+    char            pad0[64];
+    atomic_size_t   enq_pos;        // 入队游标（生产者之间 CAS）；最高位为关闭标志
+    char            pad1[64];
+    atomic_size_t   deq_pos;        // 出队游标（消费者之间 CAS）
+    char            pad2[64];
+    atomic_uint_least64_t not_empty;    // 事件字：低 32 位为 futex 序号，高 32 位为等待者数
+    atomic_uint_least64_t not_full;
+} MpmcQueue;
+
+// 返回值约定（同 BQueue）：
+//  - push: 0=成功, 1=队列满(try_push), -1=队列已关闭
+//  - pop:  1=成功取到元素, 0=队列已关闭且已空, -1=错误
+//  - pop_timeout / try_pop: 同 pop，另外 2=超时（或当前为空）仍无元素
+
+int    mpmc_init(MpmcQueue *q, size_t capacity);               // 等价于 mpmc_init_wait(q, capacity, RKAV_WAIT_PARK)
+int    mpmc_init_wait(MpmcQueue *q, size_t capacity, RkavWait wait);
+void   mpmc_close(MpmcQueue *q);
+void   mpmc_destroy(MpmcQueue *q);
+
+int    mpmc_push(MpmcQueue *q, void *item);         // 阻塞直到有空间 / 或 close
+int    mpmc_try_push(MpmcQueue *q, void *item);     // 不阻塞
+int    mpmc_push_timeout(MpmcQueue *q, void *item, uint64_t timeout_us); // 满时最多等待 timeout_us，超时返回 1
+int    mpmc_pop(MpmcQueue *q, void **out);          // 阻塞直到有元素 / 或 close
+int    mpmc_try_pop(MpmcQueue *q, void **out);      // 不阻塞
+int    mpmc_pop_timeout(MpmcQueue *q, void **out, uint64_t timeout_us); // 最多等待 timeout_us
+
+size_t mpmc_size(MpmcQueue *q);                     // 近似值（并发下只作统计用）
+size_t mpmc_capacity(MpmcQueue *q);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "rkav/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 分配一个空 EncodedPacket，引用计数为 1（data 由调用者填入，须为 malloc 所得）
+EncodedPacket *encoded_packet_alloc(void);
+
+// 增加一个引用，返回 p 本身
+EncodedPacket *encoded_packet_ref(EncodedPacket *p);
+
+// 释放一个引用；计数归零时释放 data 与结构体本身。p 可为 NULL
+void encoded_packet_unref(EncodedPacket *p);
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,6 +8,9 @@ extern "C" {
 // CLOCK_MONOTONIC 微秒
 uint64_t rkav_now_monotonic_us(void);
 
+// CLOCK_MONOTONIC 纳秒（用于测量微秒以下的开销）
+uint64_t rkav_now_monotonic_ns(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,11 +3,30 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// VideoFrameImg::flags / alarms（帧统计阶段写入，见 frame_stats.h）
+#define RKAV_IMG_F_VALID    0x01u   // 本帧已分析
+#define RKAV_IMG_F_DARK     0x02u   // 过暗
+#define RKAV_IMG_F_OVEREXP  0x04u   // 过曝（大面积饱和）
+#define RKAV_IMG_F_FLAT     0x08u   // 低对比度（镜头被遮挡 / 起雾）
+#define RKAV_IMG_F_BLUR     0x10u   // 清晰度相对基线骤降（失焦 / 镜头脏污）
+#define RKAV_IMG_F_CHANGED  0x20u   // 亮度直方图相对参考突变（转动 / 遮挡 / 喷涂）
+
+// 帧图像统计（帧元数据；未启用帧统计时全 0）
+typedef struct {
+    uint16_t  flags;      // 本帧即时判断，RKAV_IMG_F_*
+    uint16_t  alarms;     // 持续成立的告警（去抖后），RKAV_IMG_F_*
+    uint8_t   mean;       // 亮度均值
+    uint8_t   stddev;     // 亮度标准差
+    uint16_t  change;     // 与参考直方图的距离（千分比）
+    uint16_t  sharpness;  // 拉普拉斯响应 RMS（x16 定点）
+} VideoFrameImg;
+
 // 连续 NV12：Y(WH) + UV(WH/2)
 typedef struct {
     uint8_t  *data;
@@ -17,8 +36,17 @@ typedef struct {
     int       stride;     // bytes per line (Y)
     uint64_t  pts_us;     // CLOCK_MONOTONIC timestamp (microseconds)
     uint64_t  frame_id;
+    uint16_t  fps;        // 采集时的标称帧率（0 = 未知），实时切换帧率时编码线程据此同步
+    VideoFrameImg img;    // 编码线程帧统计阶段写入
 } VideoFrame;
 
+// 管线内部 PCM 采样格式（均为小端、交错）
+typedef enum {
+    RKAV_SAMPLE_S16 = 0,        // S16LE
+    RKAV_SAMPLE_S32,            // S32LE（满幅 32 bit）
+    RKAV_SAMPLE_F32,            // FLOAT_LE，范围 [-1.0, 1.0]
+} RkavSampleFmt;
+
 // 交错 PCM (LRLR...)，frames 表示“每声道采样帧数”
 typedef struct {
     uint8_t  *data;
@@ -26,16 +54,31 @@ typedef struct {
     int       sample_rate;
     int       channels;
     int       bytes_per_sample; // e.g. 2 for S16LE
+    RkavSampleFmt sample_fmt;   // data 的实际格式（与 bytes_per_sample 一致）
     uint32_t  frames;           // per-channel frames
     uint64_t  pts_us;           // base + accumulated by sample count
+    uint32_t  crc32c;           // data 的 CRC32C（采集/混音处计算，写盘前复核并记入索引）
 } AudioChunk;
 
+// EncodedPacket::flags
+#define RKAV_PKT_F_PARTIAL  0x1u    // 低延迟模式下的帧内分片，且不是该帧最后一片
+
 // 编码后的 H264（AnnexB）包
+// 引用计数：写盘线程与直播服务共享同一份 data，最后一个持有者释放（见 rkav/packet.h）
+// 低延迟模式下一帧拆成多个 slice 包依次下发，同帧各片 pts_us / dts_us 相同，最后一片不带 PARTIAL
+// 包按解码顺序（DTS 单调不减）下发；编码器重排序时 PTS 可能不单调，封装时间戳以 DTS 为准
 typedef struct {
     uint8_t  *data;
     size_t    size;
-    uint64_t  pts_us;
+    uint64_t  pts_us;     // 显示时间戳（源帧采集 PTS，随帧穿过编码器取回）
+    uint64_t  dts_us;     // 解码时间戳（<= pts_us；无 B 帧时等于 pts_us）
     bool      is_keyframe;
+    uint32_t  crc32c;     // data 的 CRC32C（编码输出拷贝时计算，写盘前复核并记入索引）
+    uint8_t   temporal_id;// 时间层 ID（SVC-T，0 为基础层；未分层时恒为 0）
+    uint8_t   flags;      // RKAV_PKT_F_*
+    uint16_t  slice_idx;  // 帧内分片序号（整帧输出时为 0）
+    uint64_t  enc_us;     // 编码器吐出该包的时刻（monotonic），用于分段延迟统计
+    atomic_int refs;      // 引用计数（encoded_packet_alloc 置 1）
 } EncodedPacket;
 
 #ifdef __cplusplus
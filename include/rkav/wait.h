@@ -0,0 +1,72 @@
+#pragma once
+
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 队列等待策略（BQueue / MpmcQueue 初始化时选定）。
+// 延迟敏感的一跳（低延迟模式下采集 -> 编码）用自旋换唤醒延迟，省电的一跳保持睡眠。
+typedef enum {
+    RKAV_WAIT_PARK = 0,     // 直接睡眠（条件变量 / futex）：不占 CPU，唤醒延迟为调度器延迟（A55 上数十微秒）
+    RKAV_WAIT_SPIN_PARK,    // 先自旋 RKAV_SPIN_NS，仍未就绪再睡眠：短间隔的交接不进内核
+    RKAV_WAIT_SPIN,         // 只自旋，每 RKAV_SPIN_YIELD_EVERY 轮 sched_yield：最低延迟，等待期间占满一个核
+} RkavWait;
+
+// SPIN_PARK 的自旋预算
+#define RKAV_SPIN_NS            50000u
+
+// SPIN 模式每多少轮让出一次 CPU（同核还有其他可运行线程时不至于饿死对方）
+#define RKAV_SPIN_YIELD_EVERY   256u
+
+static inline const char *rkav_wait_name(RkavWait w)
+{
+    switch (w) {
+    case RKAV_WAIT_SPIN_PARK: return "spin-park";
+    case RKAV_WAIT_SPIN:      return "spin";
+    default:                  return "park";
+    }
+}
+
+static inline uint64_t rkav_spin_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// 自旋等待一轮：*addr 可能已不等于 old 时返回。
+// arm64：sevl + wfe + ldxr 监视该缓存行，其他核写入即唤醒，否则由内核开启的
+// 架构定时器事件流（默认 100us）兜底唤醒；CPU 在 wfe 中处于低功耗状态，而不是空转。
+// x86：pause。其他平台：编译器屏障。
+static inline void rkav_spin_wait(const size_t *addr, size_t old)
+{
+#if defined(__aarch64__)
+    size_t tmp;
+    __asm__ volatile(
+        "   sevl\n"
+        "   wfe\n"
+        "   ldxr    %[tmp], %[v]\n"
+        "   eor     %[tmp], %[tmp], %[old]\n"
+        "   cbnz    %[tmp], 1f\n"
+        "   wfe\n"
+        "1:"
+        : [tmp] "=&r"(tmp)
+        : [v] "Q"(*addr), [old] "r"(old)
+        : "memory");
+#elif defined(__x86_64__) || defined(__i386__)
+    (void)addr; (void)old;
+    __builtin_ia32_pause();
+#else
+    (void)addr; (void)old;
+    __asm__ volatile("" ::: "memory");
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,323 @@
+/**
+ * @file aes256.c
+ * @brief AES-256 / CTR 模式模块实现
+ *
+ * 硬件路径每轮交错 4 个计数器块（AESE/AESMC 与 AESENC 都有多周期延迟，单块串行跑不满流水线），
+ * 密钥流与输入的异或在向量寄存器内完成，数据只读写一遍。
+ * 查表路径为 FIPS-197 的逐字节实现，只作为没有加密扩展时的兜底与自检基准。
+ */
+#include "aes256.h"
+
+#include <string.h>
+
+#if defined(__aarch64__) && (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+#  include <arm_neon.h>
+#  define AES_ARMV8 1
+#elif defined(__AES__) && defined(__SSE2__)
+#  include <wmmintrin.h>
+#  include <emmintrin.h>
+#  define AES_NI 1
+#endif
+
+/* ============================================================================
+ * 查表实现
+ * ============================================================================ */
+
+static const uint8_t s_sbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+static inline uint8_t xtime(uint8_t x)
+{
+    return (uint8_t)((x << 1) ^ ((x >> 7) * 0x1b));
+}
+
+/* 状态按列存放：s[col * 4 + row]，与输入字节顺序一致 */
+static void block_portable(const Aes256Key *k, const uint8_t in[16], uint8_t out[16])
+{
+    uint8_t s[16], t[16];
+    for (int i = 0; i < 16; i++) s[i] = in[i] ^ k->rk[0][i];
+
+    for (int r = 1; r <= AES256_ROUNDS; r++) {
+        /* SubBytes + ShiftRows：第 row 行循环左移 row 列 */
+        for (int c = 0; c < 4; c++)
+            for (int row = 0; row < 4; row++)
+                t[c * 4 + row] = s_sbox[s[((c + row) & 3) * 4 + row]];
+
+        /* MixColumns（最后一轮没有） */
+        if (r < AES256_ROUNDS) {
+            for (int c = 0; c < 4; c++) {
+                uint8_t *a = &t[c * 4];
+                uint8_t a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3];
+                uint8_t x = a0 ^ a1 ^ a2 ^ a3;
+                a[0] = a0 ^ x ^ xtime(a0 ^ a1);
+                a[1] = a1 ^ x ^ xtime(a1 ^ a2);
+                a[2] = a2 ^ x ^ xtime(a2 ^ a3);
+                a[3] = a3 ^ x ^ xtime(a3 ^ a0);
+            }
+        }
+        for (int i = 0; i < 16; i++) s[i] = t[i] ^ k->rk[r][i];
+    }
+    memcpy(out, s, 16);
+}
+
+void aes256_init(Aes256Key *k, const uint8_t key[32])
+{
+    static const uint8_t rcon[8] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+    uint8_t *w = &k->rk[0][0];      /* 60 个 4 字节字 */
+
+    memcpy(w, key, 32);
+    for (int i = 8; i < 4 * (AES256_ROUNDS + 1); i++) {
+        uint8_t t[4];
+        memcpy(t, &w[(i - 1) * 4], 4);
+        if (i % 8 == 0) {
+            uint8_t t0 = t[0];
+            t[0] = s_sbox[t[1]] ^ rcon[i / 8 - 1];
+            t[1] = s_sbox[t[2]];
+            t[2] = s_sbox[t[3]];
+            t[3] = s_sbox[t0];
+        } else if (i % 8 == 4) {
+            for (int j = 0; j < 4; j++) t[j] = s_sbox[t[j]];
+        }
+        for (int j = 0; j < 4; j++) w[i * 4 + j] = w[(i - 8) * 4 + j] ^ t[j];
+    }
+}
+
+/* 计数器块：nonce || 大端块号 */
+static inline void ctr_block(uint8_t blk[16], const uint8_t nonce[8], uint64_t ctr)
+{
+    memcpy(blk, nonce, 8);
+    for (int i = 0; i < 8; i++) blk[8 + i] = (uint8_t)(ctr >> (56 - 8 * i));
+}
+
+static inline void xor_bytes(uint8_t *out, const uint8_t *in, const uint8_t *ks, size_t n)
+{
+    while (n >= 8) {
+        uint64_t a, b;
+        memcpy(&a, in, 8);
+        memcpy(&b, ks, 8);
+        a ^= b;
+        memcpy(out, &a, 8);
+        in += 8; ks += 8; out += 8; n -= 8;
+    }
+    while (n--) *out++ = *in++ ^ *ks++;
+}
+
+/* 生成 n（1~4）个连续计数器块的密钥流 */
+typedef void (*KeystreamFn)(const Aes256Key *k, const uint8_t nonce[8], uint64_t ctr,
+                            uint8_t *ks, int n);
+
+static void keystream_portable(const Aes256Key *k, const uint8_t nonce[8], uint64_t ctr,
+                               uint8_t *ks, int n)
+{
+    for (int i = 0; i < n; i++) {
+        ctr_block(ks + 16 * i, nonce, ctr + (uint64_t)i);
+        block_portable(k, ks + 16 * i, ks + 16 * i);
+    }
+}
+
+/*
+ * CTR 主循环：不对齐的首块与不足 64 字节的尾部走 ks_fn，整 64 字节走 bulk（可为 NULL）。
+ * bulk 处理 nblk4 组 4 块，返回后计数器前进 4 * nblk4。
+ */
+typedef void (*BulkFn)(const Aes256Key *k, const uint8_t nonce[8], uint64_t ctr,
+                       const uint8_t *in, uint8_t *out, size_t nblk4);
+
+static void ctr_run(KeystreamFn ks_fn, BulkFn bulk, const Aes256Key *k, const uint8_t nonce[8],
+                    uint64_t offset, const uint8_t *in, uint8_t *out, size_t len)
+{
+    uint8_t  ks[64];
+    uint64_t ctr  = offset >> 4;
+    size_t   skip = (size_t)(offset & 15u);
+
+    if (skip && len) {
+        size_t n = 16 - skip;
+        if (n > len) n = len;
+        ks_fn(k, nonce, ctr, ks, 1);
+        xor_bytes(out, in, ks + skip, n);
+        in += n; out += n; len -= n;
+        ctr++;
+    }
+
+    size_t nblk4 = len / 64;
+    if (nblk4 && bulk) {
+        bulk(k, nonce, ctr, in, out, nblk4);
+        ctr += 4 * nblk4;
+        in  += 64 * nblk4;
+        out += 64 * nblk4;
+        len -= 64 * nblk4;
+    }
+    while (len) {
+        size_t n = len > 64 ? 64 : len;
+        ks_fn(k, nonce, ctr, ks, (int)((n + 15) / 16));
+        xor_bytes(out, in, ks, n);
+        in += n; out += n; len -= n;
+        ctr += 4;
+    }
+}
+
+void aes256_ctr_portable(const Aes256Key *k, const uint8_t nonce[8], uint64_t offset,
+                         const uint8_t *in, uint8_t *out, size_t len)
+{
+    ctr_run(keystream_portable, NULL, k, nonce, offset, in, out, len);
+}
+
+/* ============================================================================
+ * 硬件实现
+ * ============================================================================ */
+
+#if defined(AES_ARMV8)
+
+/* AESE = AddRoundKey + SubBytes + ShiftRows，AESMC = MixColumns；最后一轮单独异或轮密钥 */
+#define ARM_ROUNDS(S)                                                   \
+    do {                                                                \
+        for (int r_ = 0; r_ < AES256_ROUNDS - 1; r_++)                  \
+            S = vaesmcq_u8(vaeseq_u8(S, rk[r_]));                       \
+        S = veorq_u8(vaeseq_u8(S, rk[AES256_ROUNDS - 1]), rk[AES256_ROUNDS]); \
+    } while (0)
+
+static inline uint8x16_t ctr_vec(const uint8_t nonce[8], uint64_t ctr)
+{
+    return vcombine_u8(vld1_u8(nonce), vrev64_u8(vcreate_u8(ctr)));
+}
+
+static void keystream_hw(const Aes256Key *k, const uint8_t nonce[8], uint64_t ctr,
+                         uint8_t *ks, int n)
+{
+    uint8x16_t rk[AES256_ROUNDS + 1];
+    for (int i = 0; i <= AES256_ROUNDS; i++) rk[i] = vld1q_u8(k->rk[i]);
+    for (int i = 0; i < n; i++) {
+        uint8x16_t s = ctr_vec(nonce, ctr + (uint64_t)i);
+        ARM_ROUNDS(s);
+        vst1q_u8(ks + 16 * i, s);
+    }
+}
+
+static void bulk_hw(const Aes256Key *k, const uint8_t nonce[8], uint64_t ctr,
+                    const uint8_t *in, uint8_t *out, size_t nblk4)
+{
+    uint8x16_t rk[AES256_ROUNDS + 1];
+    for (int i = 0; i <= AES256_ROUNDS; i++) rk[i] = vld1q_u8(k->rk[i]);
+
+    while (nblk4--) {
+        uint8x16_t s0 = ctr_vec(nonce, ctr);
+        uint8x16_t s1 = ctr_vec(nonce, ctr + 1);
+        uint8x16_t s2 = ctr_vec(nonce, ctr + 2);
+        uint8x16_t s3 = ctr_vec(nonce, ctr + 3);
+        for (int r = 0; r < AES256_ROUNDS - 1; r++) {
+            s0 = vaesmcq_u8(vaeseq_u8(s0, rk[r]));
+            s1 = vaesmcq_u8(vaeseq_u8(s1, rk[r]));
+            s2 = vaesmcq_u8(vaeseq_u8(s2, rk[r]));
+            s3 = vaesmcq_u8(vaeseq_u8(s3, rk[r]));
+        }
+        s0 = veorq_u8(vaeseq_u8(s0, rk[AES256_ROUNDS - 1]), rk[AES256_ROUNDS]);
+        s1 = veorq_u8(vaeseq_u8(s1, rk[AES256_ROUNDS - 1]), rk[AES256_ROUNDS]);
+        s2 = veorq_u8(vaeseq_u8(s2, rk[AES256_ROUNDS - 1]), rk[AES256_ROUNDS]);
+        s3 = veorq_u8(vaeseq_u8(s3, rk[AES256_ROUNDS - 1]), rk[AES256_ROUNDS]);
+        vst1q_u8(out,      veorq_u8(vld1q_u8(in),      s0));
+        vst1q_u8(out + 16, veorq_u8(vld1q_u8(in + 16), s1));
+        vst1q_u8(out + 32, veorq_u8(vld1q_u8(in + 32), s2));
+        vst1q_u8(out + 48, veorq_u8(vld1q_u8(in + 48), s3));
+        in  += 64;
+        out += 64;
+        ctr += 4;
+    }
+}
+
+#elif defined(AES_NI)
+
+static inline __m128i ctr_vec(const uint8_t nonce[8], uint64_t ctr)
+{
+    uint64_t lo;
+    memcpy(&lo, nonce, 8);
+    return _mm_set_epi64x((long long)__builtin_bswap64(ctr), (long long)lo);
+}
+
+static void keystream_hw(const Aes256Key *k, const uint8_t nonce[8], uint64_t ctr,
+                         uint8_t *ks, int n)
+{
+    __m128i rk[AES256_ROUNDS + 1];
+    for (int i = 0; i <= AES256_ROUNDS; i++) rk[i] = _mm_loadu_si128((const __m128i *)k->rk[i]);
+    for (int i = 0; i < n; i++) {
+        __m128i s = _mm_xor_si128(ctr_vec(nonce, ctr + (uint64_t)i), rk[0]);
+        for (int r = 1; r < AES256_ROUNDS; r++) s = _mm_aesenc_si128(s, rk[r]);
+        s = _mm_aesenclast_si128(s, rk[AES256_ROUNDS]);
+        _mm_storeu_si128((__m128i *)(ks + 16 * i), s);
+    }
+}
+
+static void bulk_hw(const Aes256Key *k, const uint8_t nonce[8], uint64_t ctr,
+                    const uint8_t *in, uint8_t *out, size_t nblk4)
+{
+    __m128i rk[AES256_ROUNDS + 1];
+    for (int i = 0; i <= AES256_ROUNDS; i++) rk[i] = _mm_loadu_si128((const __m128i *)k->rk[i]);
+
+    while (nblk4--) {
+        __m128i s0 = _mm_xor_si128(ctr_vec(nonce, ctr),     rk[0]);
+        __m128i s1 = _mm_xor_si128(ctr_vec(nonce, ctr + 1), rk[0]);
+        __m128i s2 = _mm_xor_si128(ctr_vec(nonce, ctr + 2), rk[0]);
+        __m128i s3 = _mm_xor_si128(ctr_vec(nonce, ctr + 3), rk[0]);
+        for (int r = 1; r < AES256_ROUNDS; r++) {
+            s0 = _mm_aesenc_si128(s0, rk[r]);
+            s1 = _mm_aesenc_si128(s1, rk[r]);
+            s2 = _mm_aesenc_si128(s2, rk[r]);
+            s3 = _mm_aesenc_si128(s3, rk[r]);
+        }
+        s0 = _mm_aesenclast_si128(s0, rk[AES256_ROUNDS]);
+        s1 = _mm_aesenclast_si128(s1, rk[AES256_ROUNDS]);
+        s2 = _mm_aesenclast_si128(s2, rk[AES256_ROUNDS]);
+        s3 = _mm_aesenclast_si128(s3, rk[AES256_ROUNDS]);
+        const __m128i *pi = (const __m128i *)in;
+        __m128i       *po = (__m128i *)out;
+        _mm_storeu_si128(po,     _mm_xor_si128(_mm_loadu_si128(pi),     s0));
+        _mm_storeu_si128(po + 1, _mm_xor_si128(_mm_loadu_si128(pi + 1), s1));
+        _mm_storeu_si128(po + 2, _mm_xor_si128(_mm_loadu_si128(pi + 2), s2));
+        _mm_storeu_si128(po + 3, _mm_xor_si128(_mm_loadu_si128(pi + 3), s3));
+        in  += 64;
+        out += 64;
+        ctr += 4;
+    }
+}
+
+#endif
+
+void aes256_encrypt_block(const Aes256Key *k, const uint8_t in[16], uint8_t out[16])
+{
+    block_portable(k, in, out);
+}
+
+void aes256_ctr(const Aes256Key *k, const uint8_t nonce[8], uint64_t offset,
+                const uint8_t *in, uint8_t *out, size_t len)
+{
+#if defined(AES_ARMV8) || defined(AES_NI)
+    ctr_run(keystream_hw, bulk_hw, k, nonce, offset, in, out, len);
+#else
+    ctr_run(keystream_portable, NULL, k, nonce, offset, in, out, len);
+#endif
+}
+
+const char *aes256_impl_name(void)
+{
+#if defined(AES_ARMV8)
+    return "armv8-aes";
+#elif defined(AES_NI)
+    return "aes-ni";
+#else
+    return "table";
+#endif
+}
@@ -0,0 +1,61 @@
+/**
+ * @file aes256.h
+ * @brief AES-256 / CTR 模式模块头文件
+ *
+ * 用于录像落盘加密（见 rec_crypt.h）。只需要加密方向：CTR 模式加解密是同一个操作。
+ *
+ * 特性：
+ * - ARMv8 Crypto 扩展（AESE/AESMC，需 -march=armv8-a+crypto）/ x86 AES-NI（需 -maes）硬件实现，
+ *   每次交错处理 4 个计数器块；其余情况回退逐字节查表实现（S 盒 + xtime）
+ * - 计数器块 = 8 字节 nonce || 64 位大端块号（offset / 16），任意字节偏移都可直接定位，
+ *   解密时无需从文件头顺序处理
+ * - 输入输出可以是同一块缓冲（原地加解密）
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** AES-256 轮数 */
+#define AES256_ROUNDS  14
+
+/**
+ * @brief 扩展后的加密轮密钥（FIPS-197 字节序，各实现共用）
+ */
+typedef struct {
+    uint8_t rk[AES256_ROUNDS + 1][16];
+} Aes256Key;
+
+/** 由 32 字节密钥生成轮密钥 */
+void aes256_init(Aes256Key *k, const uint8_t key[32]);
+
+/** 加密一个 16 字节块（in 与 out 可相同） */
+void aes256_encrypt_block(const Aes256Key *k, const uint8_t in[16], uint8_t out[16]);
+
+/**
+ * @brief CTR 模式加 / 解密
+ *
+ * @param k      轮密钥
+ * @param nonce  8 字节 nonce（每个文件不同）
+ * @param offset in[0] 在整个数据流中的字节偏移（决定计数器起点，可不按 16 对齐）
+ * @param in     输入
+ * @param out    输出（可与 in 相同）
+ * @param len    字节数
+ */
+void aes256_ctr(const Aes256Key *k, const uint8_t nonce[8], uint64_t offset,
+                const uint8_t *in, uint8_t *out, size_t len);
+
+/** 纯查表实现的 CTR（用于自检与基准对比） */
+void aes256_ctr_portable(const Aes256Key *k, const uint8_t nonce[8], uint64_t offset,
+                         const uint8_t *in, uint8_t *out, size_t len);
+
+/** 当前编译进来的实现名称："armv8-aes" / "aes-ni" / "table" */
+const char *aes256_impl_name(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,6 +6,8 @@
  * 使用 POSIX getopt_long 解析命令行长短选项。
  */
 #include "app_config.h"
+#include "audio_capture.h"
+#include "audio_convert.h"
 #include "log.h"
 
 #include <string.h>
@@ -32,6 +34,32 @@ static int parse_size(const char *s, int *w, int *h)
     return 0;
 }
 
+/*
+ * 解析音频采样格式字符串："s16" / "s32" / "f32"（也接受 ffmpeg 风格的 s16le 等）。
+ *
+ * @return 0 成功；-1 无法识别
+ */
+static int parse_sample_fmt(const char *s, RkavSampleFmt *out)
+{
+    if (!s || !out) return -1;
+    if (strncmp(s, "s16", 3) == 0) { *out = RKAV_SAMPLE_S16; return 0; }
+    if (strncmp(s, "s32", 3) == 0) { *out = RKAV_SAMPLE_S32; return 0; }
+    if (strncmp(s, "f32", 3) == 0 || strcmp(s, "float") == 0) {
+        *out = RKAV_SAMPLE_F32;
+        return 0;
+    }
+    return -1;
+}
+
+static int parse_queue_wait(const char *s, RkavWait *out)
+{
+    if (!s || !out) return -1;
+    if (strcmp(s, "park") == 0)      { *out = RKAV_WAIT_PARK;      return 0; }
+    if (strcmp(s, "spin-park") == 0) { *out = RKAV_WAIT_SPIN_PARK; return 0; }
+    if (strcmp(s, "spin") == 0)      { *out = RKAV_WAIT_SPIN;      return 0; }
+    return -1;
+}
+
 /*
  * 加载默认配置。
  *
@@ -50,23 +78,71 @@ int app_config_load_default(AppConfig *cfg)
 
     /* ============ 视频采集默认配置 ============ */
     cfg->video_device = "/dev/video0";   /* 默认使用第一个视频设备 */
+    cfg->video_enabled = 1;
     cfg->width        = 1280;            /* 720P 宽度 */
     cfg->height       = 720;             /* 720P 高度 */
     cfg->fps          = 30;              /* 30 帧/秒 */
     cfg->bitrate      = 2000000;         /* 2Mbps 码率 */
     cfg->v4l2_fourcc  = 0;               /* 自动选择像素格式 */
+    cfg->cap_map      = 0;               /* 驱动 mmap */
+    cfg->svc_layers   = 1;               /* 默认不分层 */
+    cfg->smart_gop    = 0;               /* 默认固定 GOP（fps*2） */
+    cfg->idr_interval_sec = 60;          /* 智能 GOP 下每分钟至少一个 IDR */
+    cfg->low_latency  = 0;               /* 默认整帧输出 */
+    cfg->slices       = 4;               /* 低延迟模式每帧 4 个 slice */
+    cfg->cfr          = 0;               /* 默认保留采集时间戳（VFR） */
+    cfg->video_q_wait = RKAV_WAIT_PARK;  /* 视频队列睡眠等待 */
+    cfg->privacy_mask = NULL;            /* 默认无遮挡 */
+    cfg->frame_stats  = 1;               /* 默认开启（每帧固定采样预算） */
+    cfg->idle_fps     = 0;               /* 默认不降帧 */
+    cfg->idle_sec     = 10;              /* 静止 10 秒后降帧 */
 
     /* ============ 音频采集默认配置 ============ */
     cfg->audio_device   = "hw:0,0";      /* 默认 ALSA 设备 */
     cfg->sample_rate    = 48000;         /* 48kHz 采样率 */
     cfg->channels       = 2;             /* 立体声 */
     cfg->audio_chunk_ms = 20;            /* 20ms 每块 */
+    cfg->audio_sample_fmt = RKAV_SAMPLE_S16; /* 管线默认 S16LE */
+    cfg->audio_dither   = 0;             /* 默认不抖动 */
+    cfg->audio_period_us = 0;            /* 按延迟档位 */
+    cfg->audio_buffer_us = 0;
+    cfg->audio_xrun_fill = 1;            /* overrun 缺口补静音 */
 
     /* ============ 输出默认配置 ============ */
     cfg->sink_type        = "file";      /* 输出到文件 */
     cfg->output_path_h264 = "out.h264";  /* H.264 输出文件名 */
     cfg->output_path_pcm  = "out.pcm";   /* PCM 输出文件名 */
     cfg->duration_sec     = 10;          /* 默认录制 10 秒 */
+    cfg->rec_index        = 1;           /* 默认写 .idx 索引 */
+    cfg->segment_sec      = 0;           /* 默认不分段 */
+    cfg->catalog_path     = NULL;        /* 默认不写录像目录 */
+    cfg->retain_sec       = 0;
+    cfg->retain_mb        = 0;
+    cfg->encrypt_key_path = NULL;        /* 默认明文录像 */
+    cfg->store_dir_count  = 0;           /* 默认直接写输出路径 */
+    cfg->store_mode       = STORAGE_FAILOVER;
+    cfg->store_slow_ms    = 500;         /* 单次写超过 0.5 秒判为慢盘 */
+    cfg->store_min_free_mb = 512;
+
+    /* ============ 直播预览默认配置 ============ */
+    cfg->live_port       = 0;            /* 默认不启用 */
+    cfg->live_max_lag_ms = 2000;         /* 滞后超过 2 秒断开 */
+
+    /* ============ RTP 输出默认配置 ============ */
+    cfg->rtp_dest = NULL;                /* 默认不启用 */
+    cfg->fec      = FEC_NONE;
+    rtp_default_prot(cfg->fec_prot);     /* key=50,t0=25,t1=10,t2=5,t3=0 */
+
+    /* ============ 自监控默认配置 ============ */
+    cfg->procmon = 1;                    /* 默认开启 */
+    cfg->boot_serial = 0;                /* 默认设备与主线程初始化并行启动 */
+
+    /* ============ 控制通道默认配置 ============ */
+    cfg->ctl_path = NULL;                /* 默认不启用 */
+
+    /* ============ 时序轨迹默认配置 ============ */
+    cfg->trace_path  = NULL;             /* 默认不记录 */
+    cfg->replay_path = NULL;             /* 默认正常采集 */
 
     return 0;
 }
@@ -82,21 +158,65 @@ void app_config_print_usage(const char *prog)
         "Usage:\n"
         "  %s [options]\n\n"
         "Options:\n"
-        "  --video-dev <path>       视频设备节点 (默认: /dev/video0)\n"
+        "  --video-dev <path|none>  视频设备节点，none 表示只采集音频 (默认: /dev/video0)\n"
         "  --size <WxH>             采集分辨率 (默认: 1280x720)\n"
         "  --fps <n>                采集帧率 (默认: 30)\n"
         "  --bitrate <bps>          H.264 目标码率 (默认: 2000000)\n"
-        "  --audio-dev <dev>        ALSA 采集设备 (默认: hw:0,0)\n"
+        "  --queue-wait <park|spin-park|spin> 视频交接队列等待策略：睡眠 / 先自旋 50us 再睡眠 / 只自旋 (默认: park)\n"
+        "  --cfr                    恒定帧率输出：PTS 对齐 1/fps 网格，缺帧重复上一帧（P_Skip），多余帧丢弃\n"
+        "  --mask <spec>            隐私遮挡，编码前原地处理，如 'rect:0,0,320,180;poly:900,400,1100,380,1120,600@pix24'\n"
+        "                           样式 @black(默认)|@gray|@pix<N>；运行时可经 --ctl 的 mask 命令修改\n"
+        "  --no-frame-stats         关闭帧统计（[IMG] 曝光/清晰度/画面突变告警及 /metrics 中的 rkav_image_*）\n"
+        "  --idle-fps <n>           画面静止后把采集帧率降到 n（传感器 + 编码码控同步切换），出现运动立即恢复 (默认: 0 关闭)\n"
+        "  --idle-sec <n>           进入空闲降帧前需连续静止的秒数 (默认: 10)\n"
+        "  --cap-map <mmap|dmabuf>  采集缓冲映射：驱动 mmap，或导出 dma-buf 缓存映射 + DMA_BUF_IOCTL_SYNC (默认: mmap)\n"
+        "  --svc-t <1-4>            时间分层数，拥塞时先丢最高层，帧率逐级减半 (默认: 1 不分层)\n"
+        "  --smart-gop              智能 GOP：长期参考 + 虚拟 I 帧，场景切换/运动起始时插 IDR\n"
+        "  --idr-sec <n>            智能 GOP 的最长 IDR 间隔秒数 (默认: 60)\n"
+        "  --low-latency            低延迟模式：按 slice 输出，队列深度 2，写出不缓冲\n"
+        "  --slices <n>             低延迟模式每帧 slice 数 1-16 (默认: 4)\n"
+        "  --audio-dev <dev>        ALSA 采集设备，synth:<hz>[@<ppm>] 为合成正弦源 (默认: hw:0,0)\n"
         "  --sr <hz>                音频采样率 (默认: 48000)\n"
         "  --ch <n>                 音频声道数 (默认: 2)\n"
+        "  --audio-fmt <s16|s32|f32> 管线音频采样格式，设备格式不同时自动转换 (默认: s16)\n"
+        "  --dither                 转换到 s16 时加 TPDF 抖动\n"
+        "  --audio-period-ms <ms>   采集 period 时长 (默认: 低延迟 5，否则 1024 帧)\n"
+        "  --audio-buffer-ms <ms>   采集环形缓冲时长，读线程卡顿超过它即 overrun (默认: 低延迟 100，否则 250)\n"
+        "  --audio-xrun <fill|skip> overrun 丢失的时长补静音，或让 PTS 直接跳过 (默认: fill)\n"
+        "  --mic-dev <dev>          额外采集设备，与 --audio-dev 对齐混音，可重复指定最多 %d 个\n"
+        "  --mic-ch <n>             每个采集设备的声道数 (默认: 与 --ch 相同)\n"
+        "  --mic-map <spec>         声道映射，如 0:0+1:0,0:1+1:1 (默认: 逐声道相加/单声道分路)\n"
         "  --sec <n>                录制时长秒数 (默认: 10)\n"
         "  --out-h264 <file>        H.264 输出文件 (默认: out.h264)\n"
         "  --out-pcm <file>         PCM 输出文件 (默认: out.pcm)\n"
+        "  --no-index               不写 <out>.idx 索引（每包偏移/PTS/CRC32C）\n"
+        "  --segment-sec <n>        每 n 秒切一个新文件 <out>_<时间>.<扩展名>（视频在关键帧处切）(默认: 0 不分段)\n"
+        "  --catalog <file>         录像目录：按 流+时间 查段文件与关键帧偏移（tools/rkav_catalog 查询）\n"
+        "  --retain-sec <n>         删除结束时间早于 n 秒前的段 (默认: 0 不限，需要 --catalog)\n"
+        "  --retain-mb <n>          录像总量超过 n MiB 时删除最早的段 (默认: 0 不限，需要 --catalog)\n"
+        "  --encrypt-key <file>     录像落盘加密 AES-256-CTR（密钥文件：32 字节或 64 位十六进制）\n"
+        "  --store <dir>            存储目标目录，可重复指定最多 %d 个（按优先级），输出文件按文件名写到其下\n"
+        "  --store-mode <mirror|stripe|failover> 多目标写入：镜像 / 按段轮换均衡 / 主备切换 (默认: failover)\n"
+        "  --store-slow-ms <n>      单次写超过 n 毫秒即把目标判为慢盘，流量迁走 30 秒 (默认: 500, 0 不检测)\n"
+        "  --store-min-free-mb <n>  可用空间低于 n MiB 的目标不再写入 (默认: 512)\n"
+        "  --live-port <n>          浏览器预览端口：/live.flv (HTTP-FLV)、/live.mp4 (WebSocket fMP4) (默认: 0 不启用)\n"
+        "  --live-max-lag-ms <n>    预览客户端滞后超过该值即断开 (默认: 2000)\n"
+        "  --rtp <host:port>        RTP/UDP 输出 H.264（RFC 6184，负载类型 96）(默认: 不启用)\n"
+        "  --fec <off|xor|rs>       RTP 修复包：XOR 奇偶 / Reed-Solomon (默认: off)\n"
+        "  --fec-prot <spec>        各帧类别冗余百分比，如 key=50,t0=25,t1=10 (默认: key=50,t0=25,t1=10,t2=5,t3=0)\n"
+        "  --no-procmon             关闭每秒 [CPU]/[MEM] 线程与进程资源自监控及 /metrics\n"
+        "  --boot-serial            设备在其余初始化完成后逐个启动（对照 [BOOT] 启动耗时，默认并行）\n"
+        "  --ctl <path>             运行时控制套接字（tools/rkav_ctl <path> help 查看命令）(默认: 不启用)\n"
+        "  --trace <path>           记录各环节逐事件时序（帧到达 / 编码 / 写盘耗时），tools/rkav_trace 查看\n"
+        "  --replay <path>          按轨迹回放：合成源、模拟编码器与写盘耗时驱动真实队列和线程（忽略 --sec）\n"
+        "  --sync-dev <path>        额外同步摄像头（只参与对齐统计，不编码录像），可重复指定最多 %d 个 (默认: 无)\n"
+        "  --sync-tol-ms <n>        同组帧 PTS 容差毫秒 (默认: 半个帧周期)\n"
+        "  --sync-wait-ms <n>       迟到帧最长等待毫秒 (默认: 一个帧周期)\n"
         "  -h, --help               显示此帮助信息\n\n"
         "Examples:\n"
         "  %s --video-dev /dev/video0 --size 1920x1080 --fps 30 --bitrate 4000000 --sec 10\n"
         "  %s --out-h264 out.h264 --out-pcm out.pcm --sec 10\n",
-        prog, prog, prog);
+        prog, APP_MAX_MIC_DEVS, APP_MAX_STORE_DIRS, APP_MAX_SYNC_DEVS, prog, prog);
 }
 
 /*
@@ -132,6 +252,49 @@ int app_config_parse_args(AppConfig *cfg, int argc, char **argv)
         OPT_SEC,
         OPT_OUT_H264,
         OPT_OUT_PCM,
+        OPT_SYNC_DEV,
+        OPT_SYNC_TOL_MS,
+        OPT_SYNC_WAIT_MS,
+        OPT_AUDIO_FMT,
+        OPT_DITHER,
+        OPT_AUDIO_PERIOD_MS,
+        OPT_AUDIO_BUFFER_MS,
+        OPT_AUDIO_XRUN,
+        OPT_MIC_DEV,
+        OPT_MIC_CH,
+        OPT_MIC_MAP,
+        OPT_NO_INDEX,
+        OPT_SEGMENT_SEC,
+        OPT_CATALOG,
+        OPT_RETAIN_SEC,
+        OPT_RETAIN_MB,
+        OPT_ENCRYPT_KEY,
+        OPT_LIVE_PORT,
+        OPT_LIVE_MAX_LAG_MS,
+        OPT_SVC_T,
+        OPT_SMART_GOP,
+        OPT_IDR_SEC,
+        OPT_LOW_LATENCY,
+        OPT_SLICES,
+        OPT_CAP_MAP,
+        OPT_QUEUE_WAIT,
+        OPT_CFR,
+        OPT_NO_PROCMON,
+        OPT_BOOT_SERIAL,
+        OPT_MASK,
+        OPT_CTL,
+        OPT_NO_FRAME_STATS,
+        OPT_IDLE_FPS,
+        OPT_IDLE_SEC,
+        OPT_TRACE,
+        OPT_REPLAY,
+        OPT_STORE,
+        OPT_STORE_MODE,
+        OPT_STORE_SLOW_MS,
+        OPT_STORE_MIN_FREE,
+        OPT_RTP,
+        OPT_FEC,
+        OPT_FEC_PROT,
     };
 
     /*
@@ -152,6 +315,49 @@ int app_config_parse_args(AppConfig *cfg, int argc, char **argv)
         {"sec",       required_argument, 0, OPT_SEC},
         {"out-h264",  required_argument, 0, OPT_OUT_H264},
         {"out-pcm",   required_argument, 0, OPT_OUT_PCM},
+        {"sync-dev",     required_argument, 0, OPT_SYNC_DEV},
+        {"sync-tol-ms",  required_argument, 0, OPT_SYNC_TOL_MS},
+        {"sync-wait-ms", required_argument, 0, OPT_SYNC_WAIT_MS},
+        {"audio-fmt",    required_argument, 0, OPT_AUDIO_FMT},
+        {"dither",       no_argument,       0, OPT_DITHER},
+        {"audio-period-ms", required_argument, 0, OPT_AUDIO_PERIOD_MS},
+        {"audio-buffer-ms", required_argument, 0, OPT_AUDIO_BUFFER_MS},
+        {"audio-xrun",   required_argument, 0, OPT_AUDIO_XRUN},
+        {"mic-dev",      required_argument, 0, OPT_MIC_DEV},
+        {"mic-ch",       required_argument, 0, OPT_MIC_CH},
+        {"mic-map",      required_argument, 0, OPT_MIC_MAP},
+        {"no-index",     no_argument,       0, OPT_NO_INDEX},
+        {"segment-sec",  required_argument, 0, OPT_SEGMENT_SEC},
+        {"catalog",      required_argument, 0, OPT_CATALOG},
+        {"retain-sec",   required_argument, 0, OPT_RETAIN_SEC},
+        {"retain-mb",    required_argument, 0, OPT_RETAIN_MB},
+        {"encrypt-key",  required_argument, 0, OPT_ENCRYPT_KEY},
+        {"live-port",    required_argument, 0, OPT_LIVE_PORT},
+        {"live-max-lag-ms", required_argument, 0, OPT_LIVE_MAX_LAG_MS},
+        {"svc-t",        required_argument, 0, OPT_SVC_T},
+        {"smart-gop",    no_argument,       0, OPT_SMART_GOP},
+        {"idr-sec",      required_argument, 0, OPT_IDR_SEC},
+        {"low-latency",  no_argument,       0, OPT_LOW_LATENCY},
+        {"slices",       required_argument, 0, OPT_SLICES},
+        {"cap-map",      required_argument, 0, OPT_CAP_MAP},
+        {"queue-wait",   required_argument, 0, OPT_QUEUE_WAIT},
+        {"cfr",          no_argument,       0, OPT_CFR},
+        {"no-procmon",   no_argument,       0, OPT_NO_PROCMON},
+        {"boot-serial",  no_argument,       0, OPT_BOOT_SERIAL},
+        {"mask",         required_argument, 0, OPT_MASK},
+        {"ctl",          required_argument, 0, OPT_CTL},
+        {"no-frame-stats", no_argument,     0, OPT_NO_FRAME_STATS},
+        {"idle-fps",     required_argument, 0, OPT_IDLE_FPS},
+        {"idle-sec",     required_argument, 0, OPT_IDLE_SEC},
+        {"trace",        required_argument, 0, OPT_TRACE},
+        {"replay",       required_argument, 0, OPT_REPLAY},
+        {"store",        required_argument, 0, OPT_STORE},
+        {"store-mode",   required_argument, 0, OPT_STORE_MODE},
+        {"store-slow-ms", required_argument, 0, OPT_STORE_SLOW_MS},
+        {"store-min-free-mb", required_argument, 0, OPT_STORE_MIN_FREE},
+        {"rtp",          required_argument, 0, OPT_RTP},
+        {"fec",          required_argument, 0, OPT_FEC},
+        {"fec-prot",     required_argument, 0, OPT_FEC_PROT},
         {"help",      no_argument,       0, 'h'},
         {0,0,0,0}
     };
@@ -179,6 +385,106 @@ int app_config_parse_args(AppConfig *cfg, int argc, char **argv)
         case OPT_SEC:       cfg->duration_sec = (unsigned int)atoi(optarg); break;
         case OPT_OUT_H264:  cfg->output_path_h264 = optarg; break;
         case OPT_OUT_PCM:   cfg->output_path_pcm = optarg; break;
+        case OPT_SYNC_DEV:
+            if (cfg->sync_device_count >= APP_MAX_SYNC_DEVS) {
+                LOGE("[CFG] too many --sync-dev (max %d)", APP_MAX_SYNC_DEVS);
+                return -1;
+            }
+            cfg->sync_devices[cfg->sync_device_count++] = optarg;
+            break;
+        case OPT_SYNC_TOL_MS:  cfg->sync_tolerance_us = (unsigned int)(atof(optarg) * 1000.0); break;
+        case OPT_SYNC_WAIT_MS: cfg->sync_max_wait_us  = (unsigned int)(atof(optarg) * 1000.0); break;
+        case OPT_AUDIO_FMT:
+            if (parse_sample_fmt(optarg, &cfg->audio_sample_fmt) != 0) {
+                LOGE("[CFG] invalid --audio-fmt: %s", optarg);
+                return -1;
+            }
+            break;
+        case OPT_DITHER:    cfg->audio_dither = 1; break;
+        case OPT_AUDIO_PERIOD_MS: cfg->audio_period_us = (unsigned int)(atof(optarg) * 1000.0); break;
+        case OPT_AUDIO_BUFFER_MS: cfg->audio_buffer_us = (unsigned int)(atof(optarg) * 1000.0); break;
+        case OPT_AUDIO_XRUN:
+            if (strcmp(optarg, "fill") == 0)      cfg->audio_xrun_fill = 1;
+            else if (strcmp(optarg, "skip") == 0) cfg->audio_xrun_fill = 0;
+            else {
+                LOGE("[CFG] invalid --audio-xrun: %s (fill|skip)", optarg);
+                return -1;
+            }
+            break;
+        case OPT_MIC_DEV:
+            if (cfg->mic_device_count >= APP_MAX_MIC_DEVS) {
+                LOGE("[CFG] too many --mic-dev (max %d)", APP_MAX_MIC_DEVS);
+                return -1;
+            }
+            cfg->mic_devices[cfg->mic_device_count++] = optarg;
+            break;
+        case OPT_MIC_CH:    cfg->mic_channels = (unsigned int)atoi(optarg); break;
+        case OPT_MIC_MAP:   cfg->mic_map = optarg; break;
+        case OPT_NO_INDEX:  cfg->rec_index = 0; break;
+        case OPT_SEGMENT_SEC: cfg->segment_sec = (unsigned int)atoi(optarg); break;
+        case OPT_CATALOG:   cfg->catalog_path = optarg; break;
+        case OPT_RETAIN_SEC: cfg->retain_sec = (unsigned int)atoi(optarg); break;
+        case OPT_RETAIN_MB: cfg->retain_mb = (unsigned int)atoi(optarg); break;
+        case OPT_ENCRYPT_KEY: cfg->encrypt_key_path = optarg; break;
+        case OPT_LIVE_PORT: cfg->live_port = atoi(optarg); break;
+        case OPT_LIVE_MAX_LAG_MS: cfg->live_max_lag_ms = (unsigned int)atoi(optarg); break;
+        case OPT_SVC_T:     cfg->svc_layers = atoi(optarg); break;
+        case OPT_SMART_GOP: cfg->smart_gop = 1; break;
+        case OPT_IDR_SEC:   cfg->idr_interval_sec = (unsigned int)atoi(optarg); break;
+        case OPT_LOW_LATENCY: cfg->low_latency = 1; break;
+        case OPT_SLICES:    cfg->slices = atoi(optarg); break;
+        case OPT_CAP_MAP:
+            if (strcmp(optarg, "mmap") == 0)        cfg->cap_map = 0;
+            else if (strcmp(optarg, "dmabuf") == 0) cfg->cap_map = 1;
+            else {
+                LOGE("[CFG] invalid --cap-map: %s (mmap|dmabuf)", optarg);
+                return -1;
+            }
+            break;
+        case OPT_QUEUE_WAIT:
+            if (parse_queue_wait(optarg, &cfg->video_q_wait) != 0) {
+                LOGE("[CFG] invalid --queue-wait: %s (park|spin-park|spin)", optarg);
+                return -1;
+            }
+            break;
+        case OPT_CFR:       cfg->cfr = 1; break;
+        case OPT_NO_PROCMON: cfg->procmon = 0; break;
+        case OPT_BOOT_SERIAL: cfg->boot_serial = 1; break;
+        case OPT_MASK:      cfg->privacy_mask = optarg; break;
+        case OPT_CTL:       cfg->ctl_path = optarg; break;
+        case OPT_NO_FRAME_STATS: cfg->frame_stats = 0; break;
+        case OPT_IDLE_FPS:  cfg->idle_fps = atoi(optarg); break;
+        case OPT_IDLE_SEC:  cfg->idle_sec = (unsigned int)atoi(optarg); break;
+        case OPT_TRACE:     cfg->trace_path = optarg; break;
+        case OPT_REPLAY:    cfg->replay_path = optarg; break;
+        case OPT_STORE:
+            if (cfg->store_dir_count >= APP_MAX_STORE_DIRS) {
+                LOGE("[CFG] too many --store (max %d)", APP_MAX_STORE_DIRS);
+                return -1;
+            }
+            cfg->store_dirs[cfg->store_dir_count++] = optarg;
+            break;
+        case OPT_STORE_MODE:
+            if (storage_parse_mode(optarg, &cfg->store_mode) != 0) {
+                LOGE("[CFG] invalid --store-mode: %s (mirror|stripe|failover)", optarg);
+                return -1;
+            }
+            break;
+        case OPT_STORE_SLOW_MS:  cfg->store_slow_ms = (unsigned int)atoi(optarg); break;
+        case OPT_STORE_MIN_FREE: cfg->store_min_free_mb = (unsigned int)atoi(optarg); break;
+        case OPT_RTP: cfg->rtp_dest = optarg; break;
+        case OPT_FEC:
+            if (fec_parse_scheme(optarg, &cfg->fec) != 0) {
+                LOGE("[CFG] invalid --fec: %s (off|xor|rs)", optarg);
+                return -1;
+            }
+            break;
+        case OPT_FEC_PROT:
+            if (rtp_parse_prot(optarg, cfg->fec_prot) != 0) {
+                LOGE("[CFG] invalid --fec-prot: %s (e.g. key=50,t0=25,t1=10; 0-100)", optarg);
+                return -1;
+            }
+            break;
         case 'h':
         default:
             /* -h/--help 或未知参数：打印用法并退出进程。 */
@@ -194,8 +500,84 @@ int app_config_parse_args(AppConfig *cfg, int argc, char **argv)
         return -1;
     }
     if (cfg->bitrate <= 0) cfg->bitrate = 2000000;
+    if (cfg->svc_layers < 1 || cfg->svc_layers > 4) {
+        LOGE("[CFG] invalid --svc-t: %d (1-4)", cfg->svc_layers);
+        return -1;
+    }
+    if (cfg->smart_gop && cfg->svc_layers > 1) {
+        LOGE("[CFG] --smart-gop cannot be combined with --svc-t");
+        return -1;
+    }
+    if (cfg->idr_interval_sec < 2) cfg->idr_interval_sec = 2;
+    if (cfg->slices < 1 || cfg->slices > 16) {
+        LOGE("[CFG] invalid --slices: %d (1-16)", cfg->slices);
+        return -1;
+    }
     if (cfg->sample_rate == 0) cfg->sample_rate = 48000;
     if (cfg->channels == 0) cfg->channels = 2;
+    if (cfg->sync_tolerance_us == 0) cfg->sync_tolerance_us = 500000u / (unsigned int)cfg->fps;
+    if (cfg->sync_max_wait_us == 0)  cfg->sync_max_wait_us  = 1000000u / (unsigned int)cfg->fps;
+    if (cfg->mic_channels == 0) cfg->mic_channels = cfg->channels;
+    /* 采集缓冲按延迟档位：低延迟 period 小、缓冲浅（overrun 后的缺口也短）；
+     * 默认档位用较深的缓冲吸收写盘 / 调度抖动 */
+    if (cfg->audio_period_us == 0 && cfg->low_latency) cfg->audio_period_us = 5000;
+    if (cfg->audio_buffer_us == 0) cfg->audio_buffer_us = cfg->low_latency ? 100000 : 250000;
+    if (cfg->audio_period_us && cfg->audio_buffer_us < 2 * cfg->audio_period_us) {
+        LOGE("[CFG] --audio-buffer-ms must be at least two periods (%.1fms)",
+             (double)cfg->audio_period_us * 2.0 / 1000.0);
+        return -1;
+    }
+    if (cfg->mic_device_count > 0 && cfg->audio_sample_fmt == RKAV_SAMPLE_S32) {
+        LOGE("[CFG] --mic-dev requires --audio-fmt s16 or f32");
+        return -1;
+    }
+
+    cfg->video_enabled = cfg->video_device && strcmp(cfg->video_device, "none") != 0;
+    if (!cfg->video_enabled && cfg->sync_device_count > 0) {
+        LOGE("[CFG] --sync-dev requires a video device");
+        return -1;
+    }
+    if ((cfg->retain_sec || cfg->retain_mb) && !cfg->catalog_path) {
+        LOGE("[CFG] --retain-sec / --retain-mb require --catalog");
+        return -1;
+    }
+    if (cfg->live_port < 0 || cfg->live_port > 65535) {
+        LOGE("[CFG] invalid --live-port: %d", cfg->live_port);
+        return -1;
+    }
+    if (cfg->idle_fps < 0 || cfg->idle_fps >= cfg->fps) {
+        LOGE("[CFG] invalid --idle-fps: %d (0 or 1-%d)", cfg->idle_fps, cfg->fps - 1);
+        return -1;
+    }
+    if (cfg->idle_sec < 1) cfg->idle_sec = 1;
+    if (cfg->idle_fps && !cfg->video_enabled) {
+        LOGW("[CFG] --idle-fps ignored without a video device");
+        cfg->idle_fps = 0;
+    }
+    if (cfg->store_mode == STORAGE_STRIPE && cfg->store_dir_count > 1 && !cfg->segment_sec) {
+        LOGE("[CFG] --store-mode stripe requires --segment-sec");
+        return -1;
+    }
+    if (cfg->trace_path && cfg->replay_path && strcmp(cfg->trace_path, cfg->replay_path) == 0) {
+        LOGE("[CFG] --trace must not overwrite the --replay input: %s", cfg->trace_path);
+        return -1;
+    }
+    if (cfg->privacy_mask && !cfg->video_enabled) {
+        LOGE("[CFG] --mask requires a video device");
+        return -1;
+    }
+    if (cfg->live_port > 0 && !cfg->video_enabled) {
+        LOGW("[CFG] --live-port ignored without a video device");
+        cfg->live_port = 0;
+    }
+    if (cfg->fec != FEC_NONE && !cfg->rtp_dest) {
+        LOGE("[CFG] --fec requires --rtp");
+        return -1;
+    }
+    if (cfg->rtp_dest && !cfg->video_enabled) {
+        LOGW("[CFG] --rtp ignored without a video device");
+        cfg->rtp_dest = NULL;
+    }
 
     return 0;
 }
@@ -208,13 +590,102 @@ int app_config_parse_args(AppConfig *cfg, int argc, char **argv)
 void app_config_print_summary(const AppConfig *cfg)
 {
     if (!cfg) return;
-    LOGI("[CFG] video=%s %dx%d@%d bitrate=%d | audio=%s %uHz ch=%u | out=%s,%s | sec=%u",
+    LOGI("[CFG] video=%s %dx%d@%d bitrate=%d | audio=%s %uHz ch=%u fmt=%s%s | out=%s,%s%s | sec=%u",
          cfg->video_device ? cfg->video_device : "(null)",
          cfg->width, cfg->height, cfg->fps,
          cfg->bitrate,
          cfg->audio_device ? cfg->audio_device : "(null)",
          cfg->sample_rate, cfg->channels,
+         rkav_sample_fmt_name(cfg->audio_sample_fmt), cfg->audio_dither ? "+dither" : "",
          cfg->output_path_h264 ? cfg->output_path_h264 : "(null)",
          cfg->output_path_pcm ? cfg->output_path_pcm : "(null)",
+         cfg->rec_index ? " +idx" : "",
          cfg->duration_sec);
+    if (cfg->sync_device_count > 0) {
+        LOGI("[CFG] sync cams=%d tol=%.1fms wait=%.1fms",
+             cfg->sync_device_count + 1,
+             (double)cfg->sync_tolerance_us / 1000.0,
+             (double)cfg->sync_max_wait_us / 1000.0);
+    }
+    {
+        char period[24];
+        if (cfg->audio_period_us)
+            snprintf(period, sizeof(period), "%.1fms", (double)cfg->audio_period_us / 1000.0);
+        else
+            snprintf(period, sizeof(period), "%dfr", AUDIO_CAP_PERIOD_FRAMES);
+        LOGI("[CFG] audio period=%s buffer=%.1fms xrun=%s", period,
+             (double)cfg->audio_buffer_us / 1000.0, cfg->audio_xrun_fill ? "fill" : "skip");
+    }
+    if (cfg->mic_device_count > 0) {
+        LOGI("[CFG] mics=%d ch=%u map=%s",
+             cfg->mic_device_count + 1, cfg->mic_channels,
+             cfg->mic_map ? cfg->mic_map : "default");
+    }
+    if (cfg->cap_map) {
+        LOGI("[CFG] capture map=dmabuf (cached + DMA_BUF_IOCTL_SYNC)");
+    }
+    if (cfg->svc_layers > 1) {
+        LOGI("[CFG] svc-t layers=%d base_fps=%.1f",
+             cfg->svc_layers, (double)cfg->fps / (double)(1 << (cfg->svc_layers - 1)));
+    }
+    if (cfg->smart_gop) {
+        LOGI("[CFG] smart gop idr<=%us virtual_i=%dframes", cfg->idr_interval_sec, cfg->fps * 2);
+    }
+    if (cfg->low_latency) {
+        LOGI("[CFG] low latency slices=%d budget=%.1fms", cfg->slices, 1000.0 / (double)cfg->fps);
+    }
+    if (cfg->video_q_wait != RKAV_WAIT_PARK) {
+        LOGI("[CFG] video queue wait=%s", rkav_wait_name(cfg->video_q_wait));
+    }
+    if (cfg->cfr) {
+        LOGI("[CFG] cfr pts grid=%.3fms (repeat missing / drop extra)", 1000.0 / (double)cfg->fps);
+    }
+    if (cfg->live_port > 0) {
+        LOGI("[CFG] live preview :%d max_lag=%ums", cfg->live_port, cfg->live_max_lag_ms);
+    }
+    if (cfg->rtp_dest) {
+        LOGI("[CFG] rtp %s fec=%s prot key=%u t0=%u t1=%u t2=%u t3=%u", cfg->rtp_dest,
+             fec_scheme_name(cfg->fec), cfg->fec_prot[RTP_CLS_KEY], cfg->fec_prot[RTP_CLS_T0],
+             cfg->fec_prot[RTP_CLS_T1], cfg->fec_prot[RTP_CLS_T2], cfg->fec_prot[RTP_CLS_T3]);
+    }
+    if (cfg->segment_sec || cfg->catalog_path) {
+        LOGI("[CFG] record segment=%us catalog=%s retain=%us/%uMB", cfg->segment_sec,
+             cfg->catalog_path ? cfg->catalog_path : "off", cfg->retain_sec, cfg->retain_mb);
+    }
+    if (cfg->store_dir_count > 0) {
+        char dirs[256];
+        int off = 0;
+        for (int i = 0; i < cfg->store_dir_count && off < (int)sizeof(dirs); i++)
+            off += snprintf(dirs + off, sizeof(dirs) - (size_t)off, "%s%s", i ? "," : "",
+                            cfg->store_dirs[i]);
+        LOGI("[CFG] store %s mode=%s slow=%ums min_free=%uMB", dirs,
+             storage_mode_name(cfg->store_mode), cfg->store_slow_ms, cfg->store_min_free_mb);
+    }
+    if (cfg->encrypt_key_path) {
+        LOGI("[CFG] encrypt aes-256-ctr key=%s", cfg->encrypt_key_path);
+    }
+    if (!cfg->procmon) {
+        LOGI("[CFG] procmon off");
+    }
+    if (cfg->boot_serial) {
+        LOGI("[CFG] boot serial");
+    }
+    if (cfg->privacy_mask) {
+        LOGI("[CFG] privacy mask %s", cfg->privacy_mask);
+    }
+    if (cfg->idle_fps) {
+        LOGI("[CFG] idle fps=%d after %us still", cfg->idle_fps, cfg->idle_sec);
+    }
+    if (!cfg->frame_stats) {
+        LOGI("[CFG] frame stats off");
+    }
+    if (cfg->ctl_path) {
+        LOGI("[CFG] control socket %s", cfg->ctl_path);
+    }
+    if (cfg->trace_path) {
+        LOGI("[CFG] timing trace %s", cfg->trace_path);
+    }
+    if (cfg->replay_path) {
+        LOGI("[CFG] replay %s (synthetic sources, mock encoder / sink timing)", cfg->replay_path);
+    }
 }
@@ -9,10 +9,24 @@
 
 #include <stdint.h>
 
+#include "rkav/types.h"
+#include "rkav/wait.h"
+#include "rtp.h"
+#include "storage.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** 除主摄像头外，最多可参与帧同步的额外摄像头数 */
+#define APP_MAX_SYNC_DEVS  3
+
+/** 除主音频设备外，最多可参与混音的额外采集设备数 */
+#define APP_MAX_MIC_DEVS   3
+
+/** 最多存储目标数 */
+#define APP_MAX_STORE_DIRS STORAGE_MAX_TARGETS
+
 /**
  * @brief 应用配置结构体
  * 
@@ -23,12 +37,32 @@ extern "C" {
 typedef struct {
     /* ============ 视频相关配置 ============ */
     
-    const char *video_device;   /**< V4L2 视频设备节点路径，例如 "/dev/video0" */
+    const char *video_device;   /**< V4L2 视频设备节点路径，例如 "/dev/video0"；"none" 表示不采集视频 */
+    int         video_enabled;  /**< 是否启用视频采集/编码/输出（--video-dev none 时为 0） */
     int         width;          /**< 采集宽度（像素） */
     int         height;         /**< 采集高度（像素） */
     int         fps;            /**< 目标帧率 */
     int         bitrate;        /**< H.264 编码目标码率（bps），例如 2000000 表示 2Mbps */
     uint32_t    v4l2_fourcc;    /**< V4L2 像素格式（FOURCC），0=自动选择（预留） */
+    int         cap_map;        /**< 采集缓冲映射方式（V4L2MapMode）：0=驱动 mmap，1=dma-buf 缓存映射 + 显式同步 */
+    int         svc_layers;     /**< 时间分层数（SVC-T），1=不分层；拥塞时从最高层开始丢 */
+    int         smart_gop;      /**< 智能 GOP：LTR + 虚拟 I 帧，场景/运动/按需触发 IDR */
+    unsigned int idr_interval_sec; /**< 智能 GOP 模式下的最长 IDR 间隔（秒） */
+    int         low_latency;    /**< 低延迟模式：slice 输出、浅队列、无缓冲写出 */
+    int         slices;         /**< 低延迟模式下每帧 slice 数 */
+    int         cfr;            /**< 恒定帧率输出：PTS 吸附到 1/fps 网格，缺帧重复上一帧，多余帧丢弃 */
+    RkavWait    video_q_wait;   /**< 视频交接队列（采集 -> 编码 -> 写盘）的等待策略；音频队列始终睡眠等待 */
+    const char *privacy_mask;   /**< 隐私遮挡区域描述（见 privacy_mask.h），NULL 表示启动时无遮挡 */
+    int         idle_fps;       /**< 空闲降帧：画面静止 idle_sec 秒后的采集帧率，0=关闭 */
+    unsigned int idle_sec;      /**< 进入空闲降帧前需连续静止的秒数 */
+    int         frame_stats;    /**< 帧统计：亮度直方图 / 曝光 / 清晰度评分与遮挡、篡改告警（见 frame_stats.h） */
+
+    /* ============ 多摄像头帧同步配置 ============ */
+
+    const char *sync_devices[APP_MAX_SYNC_DEVS]; /**< 额外摄像头设备节点（与主摄像头同分辨率） */
+    int         sync_device_count;  /**< 额外摄像头数量，0 表示不启用帧同步 */
+    unsigned int sync_tolerance_us; /**< 同组帧 PTS 容差（微秒），0=自动取半个帧周期 */
+    unsigned int sync_max_wait_us;  /**< 迟到帧最长等待（微秒），0=自动取一个帧周期 */
 
     /* ============ 音频相关配置 ============ */
     
@@ -36,6 +70,18 @@ typedef struct {
     unsigned int sample_rate;   /**< 采样率（Hz），例如 48000 */
     unsigned int channels;      /**< 声道数，例如 2（立体声） */
     unsigned int audio_chunk_ms;/**< 音频块时长（毫秒），用于统计和调试 */
+    RkavSampleFmt audio_sample_fmt; /**< 管线音频采样格式（设备格式不同时自动转换） */
+    int          audio_dither;  /**< 位宽缩减到 S16 时是否加 TPDF 抖动 */
+    unsigned int audio_period_us; /**< 采集 period 时长（微秒），0=按延迟档位（低延迟 5ms，否则 1024 帧） */
+    unsigned int audio_buffer_us; /**< 采集环形缓冲时长（微秒），0=按延迟档位（低延迟 100ms，否则 250ms） */
+    int          audio_xrun_fill; /**< overrun 丢失的时长：1=补静音保持连续，0=PTS 直接跳过 */
+
+    /* ============ 多麦克风混音配置 ============ */
+
+    const char *mic_devices[APP_MAX_MIC_DEVS]; /**< 额外采集设备（与主音频设备同采样率），混成一条音轨 */
+    int          mic_device_count; /**< 额外采集设备数量，0 表示不启用混音 */
+    unsigned int mic_channels;     /**< 每个采集设备的声道数，0=与 --ch 相同 */
+    const char  *mic_map;          /**< 声道映射，NULL 使用默认映射（见 audio_mix.h） */
 
     /* ============ 输出相关配置 ============ */
     
@@ -43,6 +89,42 @@ typedef struct {
     const char *output_path_h264;/**< H.264 输出文件路径，例如 "out.h264" */
     const char *output_path_pcm; /**< PCM 音频输出文件路径，例如 "out.pcm" */
     unsigned int duration_sec;   /**< 录制时长（秒），0 表示无限制 */
+    int          rec_index;      /**< 是否为输出文件写 .idx 索引（含每包 CRC32C） */
+    unsigned int segment_sec;    /**< 分段时长（秒），0 表示不分段；分段文件名为 <out>_<年月日-时分秒>.<扩展名> */
+    const char  *catalog_path;   /**< 录像目录文件（时间 -> 段文件/关键帧偏移），NULL 表示不启用 */
+    unsigned int retain_sec;     /**< 保留时长（秒），超过即删除最早的段，0 不限（需要目录） */
+    unsigned int retain_mb;      /**< 保留容量（MiB），超过即删除最早的段，0 不限（需要目录） */
+    const char  *encrypt_key_path; /**< 落盘加密密钥文件（AES-256-CTR），NULL 表示不加密 */
+    const char  *store_dirs[APP_MAX_STORE_DIRS]; /**< 存储目标目录（按优先级），输出文件按文件名写到其下 */
+    int          store_dir_count;  /**< 存储目标数，0 表示直接写输出路径 */
+    StorageMode  store_mode;       /**< 多目标写入模式（见 storage.h） */
+    unsigned int store_slow_ms;    /**< 单次写耗时超过该值即把目标判为慢盘 */
+    unsigned int store_min_free_mb; /**< 可用空间低于该值即不再往目标上开新文件 */
+
+    /* ============ 直播预览配置 ============ */
+
+    int          live_port;       /**< HTTP-FLV / WebSocket 预览端口，0 表示不启用 */
+    unsigned int live_max_lag_ms; /**< 预览客户端最大允许滞后（毫秒），超过即断开 */
+
+    /* ============ RTP 输出配置 ============ */
+
+    const char  *rtp_dest;        /**< RTP/UDP 输出目标 host:port（见 rtp.h），NULL 表示不启用 */
+    FecScheme    fec;             /**< 修复包方式：off / xor / rs */
+    uint8_t      fec_prot[RTP_CLS_COUNT]; /**< 各帧类别（key、t0 ~ t3）冗余百分比 */
+
+    /* ============ 自监控配置 ============ */
+
+    int          procmon;         /**< 每秒输出 [CPU]/[MEM] 线程与进程资源，并在预览端口提供 /metrics */
+    int          boot_serial;     /**< 设备在主线程初始化完成后逐个启动（对照并行启动的 [BOOT] 耗时） */
+
+    /* ============ 控制通道配置 ============ */
+
+    const char  *ctl_path;        /**< 运行时控制套接字路径（见 ctl.h），NULL 表示不启用 */
+
+    /* ============ 时序轨迹配置 ============ */
+
+    const char  *trace_path;      /**< 记录各环节逐事件时序（见 timing_trace.h），NULL 表示不记录 */
+    const char  *replay_path;     /**< 按轨迹回放：合成源 + 模拟编码器 / 写盘耗时，NULL 表示正常采集 */
 } AppConfig;
 
 /**
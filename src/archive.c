@@ -0,0 +1,906 @@
+/**
+ * @file archive.c
+ * @brief 离线归档转码实现
+ *
+ * 单线程顺序处理：读取器给出访问单元 -> 解码器（输入满时先取帧）-> 每个输出帧换算到编码器输入布局
+ * （可选缩放）后立即归还解码缓冲 -> 编码 -> 写出 + 索引 -> 限速。
+ * 输入文件用 mmap 只读映射（MADV_SEQUENTIAL），按索引 / 起始码切出的访问单元直接指向映射区，
+ * 只有低延迟分片需要拼接时才拷贝。
+ *
+ * 编解码后端按 ArchBackend 分派（codec_*），MPP 与模拟实现对上层完全相同：
+ * 解码输出都来自固定缓冲池，编码输入都是 16 对齐 stride 的 NV12。
+ */
+#include "archive.h"
+#include "crc32c.h"
+#include "decoder_mpp.h"
+#include "encoder_mpp.h"
+#include "log.h"
+#include "rec_index.h"
+
+#include "rkav/time.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/** 模块日志标签 */
+#define TAG "archive"
+
+/** 加密录像文件头魔数（见 rec_crypt.h） */
+#define ARCH_CRYPT_MAGIC  "RKEN"
+
+/** 结束标记发出后等待解码器吐完剩余帧的最长时间 */
+#define ARCH_DRAIN_TIMEOUT_US  2000000ULL
+
+/* ioprio_set(2)：glibc 没有封装，常量取自内核 include/uapi/linux/ioprio.h */
+#define ARCH_IOPRIO_WHO_PROCESS  1
+#define ARCH_IOPRIO_CLASS_BE     2
+#define ARCH_IOPRIO_CLASS_IDLE   3
+#define ARCH_IOPRIO_CLASS_SHIFT  13
+
+/* ============================================================================
+ * 参数与优先级
+ * ============================================================================ */
+
+void archive_default_opts(ArchiveOpts *o)
+{
+    memset(o, 0, sizeof(*o));
+    o->backend     = ARCH_BACKEND_MPP;
+    o->bitrate     = 500000;
+    o->fps         = 30;
+    o->max_fps     = 60.0;
+    o->cpu_pct     = 25;
+    o->mock_width  = 1280;
+    o->mock_height = 720;
+}
+
+const char *arch_backend_name(ArchBackend b)
+{
+    return b == ARCH_BACKEND_MOCK ? "mock" : "mpp";
+}
+
+int arch_parse_backend(const char *s, ArchBackend *out)
+{
+    if (!s) return -1;
+    if (strcmp(s, "mpp") == 0)  { *out = ARCH_BACKEND_MPP;  return 0; }
+    if (strcmp(s, "mock") == 0) { *out = ARCH_BACKEND_MOCK; return 0; }
+    return -1;
+}
+
+int arch_parse_prio(const char *s, ArchPrio *out)
+{
+    if (!s) return -1;
+    if (strcmp(s, "idle") == 0)   { *out = ARCH_PRIO_IDLE;   return 0; }
+    if (strcmp(s, "low") == 0)    { *out = ARCH_PRIO_LOW;    return 0; }
+    if (strcmp(s, "normal") == 0) { *out = ARCH_PRIO_NORMAL; return 0; }
+    return -1;
+}
+
+static int set_ioprio(int cls, int level)
+{
+#ifdef SYS_ioprio_set
+    return (int)syscall(SYS_ioprio_set, ARCH_IOPRIO_WHO_PROCESS, 0,
+                        (cls << ARCH_IOPRIO_CLASS_SHIFT) | level);
+#else
+    (void)cls;
+    (void)level;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+int archive_set_priority(ArchPrio prio)
+{
+    int rc = 0;
+    if (prio == ARCH_PRIO_IDLE) {
+        /* SCHED_IDLE：只有 CPU 没有其他可运行任务时才调度，实时录像线程永远优先 */
+        struct sched_param sp = { 0 };
+        if (sched_setscheduler(0, SCHED_IDLE, &sp) != 0) {
+            LOGW("[%s] SCHED_IDLE failed: %s", TAG, strerror(errno));
+            rc = -1;
+        }
+        if (set_ioprio(ARCH_IOPRIO_CLASS_IDLE, 0) != 0) {
+            LOGW("[%s] ioprio idle failed: %s", TAG, strerror(errno));
+            rc = -1;
+        }
+    } else if (prio == ARCH_PRIO_LOW) {
+        if (setpriority(PRIO_PROCESS, 0, 19) != 0) {
+            LOGW("[%s] nice 19 failed: %s", TAG, strerror(errno));
+            rc = -1;
+        }
+        if (set_ioprio(ARCH_IOPRIO_CLASS_BE, 7) != 0) {
+            LOGW("[%s] ioprio be/7 failed: %s", TAG, strerror(errno));
+            rc = -1;
+        }
+    }
+    return rc;
+}
+
+/* ============================================================================
+ * 读取器：按索引或起始码切出访问单元
+ * ============================================================================ */
+
+typedef struct {
+    int            fd;
+    const uint8_t *base;
+    size_t         size;
+    RecIndexEntry *ent;         /* 有效的索引记录 */
+    size_t         n_ent;
+    size_t         ent_pos;
+    size_t         scan;        /* 起始码切帧位置（索引用完后从最后一条记录之后继续） */
+    size_t         pos;         /* 已读到的文件位置（进度） */
+    uint8_t       *join;        /* 低延迟分片拼接缓冲 */
+    size_t         join_cap;
+    bool           have_pts;
+    uint64_t       last_pts;
+    uint64_t       frame_us;
+} ArchReader;
+
+/* 从 from 起查找 00 00 01，返回其位置（找不到返回 n） */
+static size_t next_sc(const uint8_t *d, size_t n, size_t from)
+{
+    for (size_t i = from; i + 2 < n; i++) {
+        if (d[i + 2] > 1) { i += 2; continue; }
+        if (d[i] == 0 && d[i + 1] == 0 && d[i + 2] == 1) return i;
+    }
+    return n;
+}
+
+/* 起始码 at 的真实起点（4 字节起始码多一个前导 0） */
+static size_t sc_begin(const uint8_t *d, size_t at)
+{
+    return at > 0 && d[at - 1] == 0 ? at - 1 : at;
+}
+
+static int reader_load_index(ArchReader *r, const char *path)
+{
+    char idx[512];
+    snprintf(idx, sizeof(idx), "%s.idx", path);
+    FILE *fp = fopen(idx, "rb");
+    if (!fp) return 0;
+
+    RecIndexHeader hdr;
+    if (rec_index_read_header(fp, &hdr) != 0 || hdr.kind != REC_INDEX_H264 ||
+        hdr.rec_size != sizeof(RecIndexEntry)) {
+        LOGW("[%s] %s: not an H.264 index, scanning start codes", TAG, idx);
+        fclose(fp);
+        return 0;
+    }
+
+    size_t cap = 0, bad = 0;
+    RecIndexEntry e;
+    while (fread(&e, sizeof(e), 1, fp) == 1) {
+        if (!rec_index_entry_valid(&e) || e.size == 0 || e.offset + e.size > r->size) {
+            bad++;
+            continue;
+        }
+        if (r->n_ent == cap) {
+            size_t nc = cap ? cap * 2 : 4096;
+            RecIndexEntry *ne = (RecIndexEntry *)realloc(r->ent, nc * sizeof(*ne));
+            if (!ne) {
+                fclose(fp);
+                return -1;
+            }
+            r->ent = ne;
+            cap = nc;
+        }
+        r->ent[r->n_ent++] = e;
+        if (e.offset + e.size > r->scan) r->scan = (size_t)(e.offset + e.size);
+    }
+    fclose(fp);
+    if (bad) LOGW("[%s] %s: skipped %zu invalid records", TAG, idx, bad);
+    return 0;
+}
+
+static int reader_open(ArchReader *r, const char *path, int fps)
+{
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+    r->frame_us = 1000000ULL / (uint64_t)(fps > 0 ? fps : 30);
+
+    r->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (r->fd < 0) {
+        LOGE("[%s] open %s: %s", TAG, path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat(r->fd, &st) != 0 || st.st_size < 4) {
+        LOGE("[%s] %s: empty or unreadable", TAG, path);
+        return -1;
+    }
+    r->size = (size_t)st.st_size;
+    void *m = mmap(NULL, r->size, PROT_READ, MAP_PRIVATE, r->fd, 0);
+    if (m == MAP_FAILED) {
+        LOGE("[%s] mmap %s: %s", TAG, path, strerror(errno));
+        return -1;
+    }
+    r->base = (const uint8_t *)m;
+    madvise(m, r->size, MADV_SEQUENTIAL);
+
+    if (memcmp(r->base, ARCH_CRYPT_MAGIC, 4) == 0) {
+        LOGE("[%s] %s: encrypted recording, decrypt with rkav_crypt first", TAG, path);
+        return -1;
+    }
+    if (next_sc(r->base, r->size < 64 ? r->size : 64, 0) > 1) {
+        LOGE("[%s] %s: not an H.264 Annex-B stream", TAG, path);
+        return -1;
+    }
+    return reader_load_index(r, path);
+}
+
+/*
+ * 下一个访问单元。
+ * @return 1 取到；0 文件结束；-1 内存不足
+ */
+static int reader_next(ArchReader *r, const uint8_t **data, size_t *size, uint64_t *pts)
+{
+    if (r->ent_pos < r->n_ent) {
+        const RecIndexEntry *e = &r->ent[r->ent_pos++];
+        *pts = e->pts_us;
+        r->have_pts = true;
+        r->last_pts = e->pts_us;
+        r->pos = (size_t)(e->offset + e->size);
+        if (!(e->flags & RECIDX_F_PARTIAL)) {
+            *data = r->base + e->offset;
+            *size = e->size;
+            return 1;
+        }
+
+        /* 低延迟分片：同一 PTS 的连续记录拼回整帧（最后一片不带 PARTIAL） */
+        size_t len = 0;
+        for (;;) {
+            if (len + e->size > r->join_cap) {
+                size_t nc = (len + e->size) * 2;
+                uint8_t *nb = (uint8_t *)realloc(r->join, nc);
+                if (!nb) return -1;
+                r->join = nb;
+                r->join_cap = nc;
+            }
+            memcpy(r->join + len, r->base + e->offset, e->size);
+            len += e->size;
+            if (!(e->flags & RECIDX_F_PARTIAL) || r->ent_pos >= r->n_ent ||
+                r->ent[r->ent_pos].pts_us != *pts)
+                break;
+            e = &r->ent[r->ent_pos++];
+            r->pos = (size_t)(e->offset + e->size);
+        }
+        *data = r->join;
+        *size = len;
+        return 1;
+    }
+
+    /* 起始码切帧：已有 VCL 后遇到 AUD / SPS / PPS / SEI，或新一帧的首个 slice（first_mb_in_slice == 0） */
+    const uint8_t *d = r->base;
+    size_t n = r->size;
+    size_t at = next_sc(d, n, r->scan);
+    if (at >= n) return 0;
+    size_t begin = sc_begin(d, at);
+    bool vcl = false;
+    while (at < n) {
+        size_t h = at + 3;
+        if (h >= n) break;
+        int type = d[h] & 0x1f;
+        bool is_vcl = type == 1 || type == 5;
+        if (vcl && (!is_vcl || (h + 1 < n && (d[h + 1] & 0x80))))
+            break;
+        if (is_vcl) vcl = true;
+        at = next_sc(d, n, h);
+    }
+    size_t end = at < n ? sc_begin(d, at) : n;
+    r->scan = end;
+    r->pos  = end;
+
+    *data = d + begin;
+    *size = end - begin;
+    *pts  = r->have_pts ? r->last_pts + r->frame_us : 0;
+    r->have_pts = true;
+    r->last_pts = *pts;
+    return 1;
+}
+
+static void reader_close(ArchReader *r)
+{
+    if (r->base) munmap((void *)r->base, r->size);
+    if (r->fd >= 0) close(r->fd);
+    free(r->ent);
+    free(r->join);
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+}
+
+/* ============================================================================
+ * 模拟编解码器（主机联调）
+ * ============================================================================ */
+
+/*
+ * 模拟解码器：每个访问单元输出一帧测试图（随帧号平移的斜向渐变），一帧解码延迟，
+ * 输出缓冲取自 ARCH_MOCK_POOL 块的池，全部被持有时不再输出（与 MPP 缓冲池行为一致）。
+ */
+typedef struct {
+    int      w, h, hs, vs;
+    uint8_t *pool[ARCH_MOCK_POOL];
+    bool     busy[ARCH_MOCK_POOL];
+    uint64_t pend_pts[2];
+    int      pend_n;
+    bool     eos_in;
+    bool     eos_out;
+    uint64_t frames;
+} MockDec;
+
+static int mock_dec_open(MockDec *m, int w, int h)
+{
+    memset(m, 0, sizeof(*m));
+    m->w  = w & ~1;
+    m->h  = h & ~1;
+    m->hs = (m->w + 15) & ~15;
+    m->vs = (m->h + 15) & ~15;
+    for (int i = 0; i < ARCH_MOCK_POOL; i++) {
+        m->pool[i] = (uint8_t *)malloc((size_t)m->hs * (size_t)m->vs * 3 / 2);
+        if (!m->pool[i]) return -1;
+    }
+    LOGI("[%s] mock decoder %dx%d pool=%d frames", TAG, m->w, m->h, ARCH_MOCK_POOL);
+    return 0;
+}
+
+static int mock_dec_put(MockDec *m, uint64_t pts, bool have_data, bool eos)
+{
+    if (have_data) {
+        if (m->pend_n == 2) return 1;
+        m->pend_pts[m->pend_n++] = pts;
+    }
+    if (eos) m->eos_in = true;
+    return 0;
+}
+
+static int mock_dec_get(MockDec *m, DecFrame *out)
+{
+    memset(out, 0, sizeof(*out));
+    /* 一帧延迟：输入结束前只在积压两帧时输出 */
+    if (m->pend_n == 2 || (m->pend_n > 0 && m->eos_in)) {
+        int slot = -1;
+        for (int i = 0; i < ARCH_MOCK_POOL && slot < 0; i++)
+            if (!m->busy[i]) slot = i;
+        if (slot < 0) return 0;
+
+        uint8_t *y = m->pool[slot];
+        uint8_t *uv = y + (size_t)m->hs * (size_t)m->vs;
+        uint32_t shift = (uint32_t)(m->frames * 2);
+        for (int r = 0; r < m->h; r++) {
+            uint8_t *row = y + (size_t)r * (size_t)m->hs;
+            for (int c = 0; c < m->w; c++)
+                row[c] = (uint8_t)((uint32_t)(c + r) + shift);
+        }
+        for (int r = 0; r < m->h / 2; r++)
+            memset(uv + (size_t)r * (size_t)m->hs, 128, (size_t)m->w);
+
+        m->busy[slot]   = true;
+        out->handle     = (void *)(intptr_t)(slot + 1);
+        out->data       = y;
+        out->width      = m->w;
+        out->height     = m->h;
+        out->hor_stride = m->hs;
+        out->ver_stride = m->vs;
+        out->pts_us     = m->pend_pts[0];
+        m->pend_pts[0]  = m->pend_pts[1];
+        m->pend_n--;
+        m->frames++;
+        return 1;
+    }
+    if (m->eos_in && !m->eos_out) {
+        m->eos_out = true;
+        out->eos = true;
+        return 1;
+    }
+    return 0;
+}
+
+static void mock_dec_release(MockDec *m, DecFrame *f)
+{
+    int slot = (int)(intptr_t)f->handle - 1;
+    if (slot >= 0 && slot < ARCH_MOCK_POOL) m->busy[slot] = false;
+    f->handle = NULL;
+    f->data = NULL;
+}
+
+static void mock_dec_close(MockDec *m)
+{
+    for (int i = 0; i < ARCH_MOCK_POOL; i++) free(m->pool[i]);
+    memset(m, 0, sizeof(*m));
+}
+
+/*
+ * 模拟编码器：按目标码率输出 Annex-B 包，GOP 2 秒，IDR 约 3 倍平均帧大小并带 SPS/PPS；
+ * 帧大小随输入首行内容 ±25% 浮动。负载字节最高位恒为 1，不会出现起始码，
+ * first_mb_in_slice 为 0，输出可被起始码切帧再次读入。
+ */
+typedef struct {
+    int      fps;
+    int      bitrate;
+    int      gop;
+    uint64_t n;
+} MockEnc;
+
+static int mock_enc_frame(MockEnc *e, const uint8_t *y, int width, uint8_t **out, size_t *out_size,
+                          bool *key)
+{
+    static const uint8_t sps[] = { 0, 0, 0, 1, 0x67, 0x42, 0xc0, 0x1f, 0x8c, 0x8d, 0x40 };
+    static const uint8_t pps[] = { 0, 0, 0, 1, 0x68, 0xce, 0x3c, 0x80 };
+
+    *key = e->n % (uint64_t)e->gop == 0;
+    uint32_t h = crc32c(y, (size_t)width);
+    size_t avg = (size_t)e->bitrate / 8u / (size_t)e->fps;
+    size_t body = avg * (*key ? 3u : 1u) * (100u + h % 51u - 25u) / 100u;
+    if (body < 8) body = 8;
+
+    size_t len = (*key ? sizeof(sps) + sizeof(pps) : 0) + 5 + body;
+    uint8_t *p = (uint8_t *)malloc(len);
+    if (!p) return -1;
+
+    size_t o = 0;
+    if (*key) {
+        memcpy(p, sps, sizeof(sps));
+        memcpy(p + sizeof(sps), pps, sizeof(pps));
+        o = sizeof(sps) + sizeof(pps);
+    }
+    p[o++] = 0; p[o++] = 0; p[o++] = 0; p[o++] = 1;
+    p[o++] = *key ? 0x65 : 0x41;
+    for (size_t i = 0; i < body; i++) {
+        h = h * 1664525u + 1013904223u;
+        p[o++] = (uint8_t)(0x80u | (h >> 25));
+    }
+    e->n++;
+    *out = p;
+    *out_size = len;
+    return 0;
+}
+
+/* ============================================================================
+ * 后端分派
+ * ============================================================================ */
+
+typedef struct {
+    ArchBackend be;
+    DecoderMPP  dec;
+    MockDec     mdec;
+    EncoderMPP  enc;
+    MockEnc     menc;
+    bool        dec_open;
+    bool        enc_open;
+    int         out_w;
+    int         out_h;
+    int         hs;             /* 编码器输入布局 */
+    int         vs;
+    size_t      frame_size;
+    uint8_t    *in_buf;         /* 编码器输入（缩放 / stride 换算结果），整个文件复用 */
+} ArchCodec;
+
+static int codec_dec_open(ArchCodec *c, const ArchiveOpts *o)
+{
+    int rc = c->be == ARCH_BACKEND_MOCK ? mock_dec_open(&c->mdec, o->mock_width, o->mock_height)
+                                        : decoder_mpp_init(&c->dec, MPP_VIDEO_CodingAVC, o->pool_frames);
+    c->dec_open = rc == 0;
+    return rc;
+}
+
+static int codec_dec_put(ArchCodec *c, const uint8_t *data, size_t size, uint64_t pts, bool eos)
+{
+    if (c->be == ARCH_BACKEND_MOCK) return mock_dec_put(&c->mdec, pts, data != NULL, eos);
+    return decoder_mpp_put_packet(&c->dec, data, size, pts, eos);
+}
+
+static int codec_dec_get(ArchCodec *c, DecFrame *f)
+{
+    if (c->be == ARCH_BACKEND_MOCK) return mock_dec_get(&c->mdec, f);
+    return decoder_mpp_get_frame(&c->dec, f);
+}
+
+static void codec_dec_release(ArchCodec *c, DecFrame *f)
+{
+    if (c->be == ARCH_BACKEND_MOCK) mock_dec_release(&c->mdec, f);
+    else decoder_mpp_release_frame(&c->dec, f);
+}
+
+static int codec_enc_open(ArchCodec *c, const ArchiveOpts *o, int w, int h)
+{
+    c->out_w = w;
+    c->out_h = h;
+    if (c->be == ARCH_BACKEND_MOCK) {
+        c->menc.fps     = o->fps;
+        c->menc.bitrate = o->bitrate;
+        c->menc.gop     = o->fps * 2;
+        c->menc.n       = 0;
+        c->hs = (w + 15) & ~15;
+        c->vs = (h + 15) & ~15;
+    } else {
+        if (encoder_mpp_init(&c->enc, w, h, o->fps, o->bitrate, MPP_VIDEO_CodingAVC) != 0)
+            return -1;
+        /* 智能 GOP：IDR 60 秒一次，每 2 秒一个只参考长期参考帧的虚拟 I 帧 */
+        if (o->smart_gop &&
+            encoder_mpp_set_smart_gop(&c->enc, o->fps * 60, o->fps * 2, o->bitrate) != 0)
+            LOGW("[%s] smart gop unavailable, using fixed gop", TAG);
+        c->hs = c->enc.hor_stride;
+        c->vs = c->enc.ver_stride;
+    }
+    c->enc_open   = true;
+    c->frame_size = (size_t)c->hs * (size_t)c->vs * 3 / 2;
+    c->in_buf     = (uint8_t *)calloc(1, c->frame_size);
+    return c->in_buf ? 0 : -1;
+}
+
+static int codec_encode(ArchCodec *c, uint64_t pts, uint8_t **out, size_t *out_size, bool *key,
+                        uint32_t *crc, uint64_t *out_pts)
+{
+    *out = NULL;
+    *out_size = 0;
+    if (c->be == ARCH_BACKEND_MOCK) {
+        if (mock_enc_frame(&c->menc, c->in_buf, c->out_w, out, out_size, key) != 0) return -1;
+        *crc = crc32c(*out, *out_size);
+        *out_pts = pts;
+        return 0;
+    }
+    if (encoder_mpp_encode_packet(&c->enc, c->in_buf, c->frame_size, pts, out, out_size, key, crc,
+                                  NULL) != 0)
+        return -1;
+    *out_pts = c->enc.frame_pts_us;
+    return 0;
+}
+
+static void codec_close(ArchCodec *c)
+{
+    if (c->be == ARCH_BACKEND_MOCK) {
+        if (c->dec_open) mock_dec_close(&c->mdec);
+    } else {
+        if (c->enc_open) encoder_mpp_deinit(&c->enc);
+        if (c->dec_open) decoder_mpp_deinit(&c->dec);
+    }
+    free(c->in_buf);
+    c->in_buf = NULL;
+    c->dec_open = c->enc_open = false;
+}
+
+/* ============================================================================
+ * NV12 缩放 / stride 换算
+ * ============================================================================ */
+
+/*
+ * 双线性缩放一个平面（comps = 1 为 Y，2 为交错 UV，宽度按像素对计），16.16 定点，
+ * 采样点按像素中心对齐。整数倍缩小时等价于相邻像素平均。
+ */
+static void plane_scale(const uint8_t *src, int sw, int sh, int sstride,
+                        uint8_t *dst, int dw, int dh, int dstride, int comps)
+{
+    int64_t xstep = ((int64_t)sw << 16) / dw;
+    int64_t ystep = ((int64_t)sh << 16) / dh;
+
+    for (int y = 0; y < dh; y++) {
+        int64_t fy = (int64_t)y * ystep + ystep / 2 - 0x8000;
+        if (fy < 0) fy = 0;
+        int y0 = (int)(fy >> 16);
+        int y1 = y0 + 1 < sh ? y0 + 1 : sh - 1;
+        uint32_t wy = (uint32_t)(fy >> 8) & 0xff;
+        const uint8_t *r0 = src + (size_t)y0 * (size_t)sstride;
+        const uint8_t *r1 = src + (size_t)y1 * (size_t)sstride;
+        uint8_t *d = dst + (size_t)y * (size_t)dstride;
+
+        for (int x = 0; x < dw; x++) {
+            int64_t fx = (int64_t)x * xstep + xstep / 2 - 0x8000;
+            if (fx < 0) fx = 0;
+            int x0 = (int)(fx >> 16);
+            int x1 = x0 + 1 < sw ? x0 + 1 : sw - 1;
+            uint32_t wx = (uint32_t)(fx >> 8) & 0xff;
+            for (int k = 0; k < comps; k++) {
+                uint32_t a = r0[x0 * comps + k], b = r0[x1 * comps + k];
+                uint32_t p = r1[x0 * comps + k], q = r1[x1 * comps + k];
+                uint32_t top = a * (256 - wx) + b * wx;
+                uint32_t bot = p * (256 - wx) + q * wx;
+                d[x * comps + k] = (uint8_t)((top * (256 - wy) + bot * wy + 32768) >> 16);
+            }
+        }
+    }
+}
+
+/* 解码帧 -> 编码器输入布局（同尺寸时逐行拷贝） */
+static void frame_to_enc(ArchCodec *c, const DecFrame *f)
+{
+    const uint8_t *sy  = f->data;
+    const uint8_t *suv = f->data + (size_t)f->hor_stride * (size_t)f->ver_stride;
+    uint8_t *dy  = c->in_buf;
+    uint8_t *duv = c->in_buf + (size_t)c->hs * (size_t)c->vs;
+
+    if (f->width == c->out_w && f->height == c->out_h) {
+        for (int r = 0; r < c->out_h; r++)
+            memcpy(dy + (size_t)r * (size_t)c->hs, sy + (size_t)r * (size_t)f->hor_stride,
+                   (size_t)c->out_w);
+        for (int r = 0; r < c->out_h / 2; r++)
+            memcpy(duv + (size_t)r * (size_t)c->hs, suv + (size_t)r * (size_t)f->hor_stride,
+                   (size_t)c->out_w);
+        return;
+    }
+    plane_scale(sy, f->width, f->height, f->hor_stride, dy, c->out_w, c->out_h, c->hs, 1);
+    plane_scale(suv, f->width / 2, f->height / 2, f->hor_stride, duv, c->out_w / 2, c->out_h / 2,
+                c->hs, 2);
+}
+
+/* ============================================================================
+ * 限速
+ * ============================================================================ */
+
+typedef struct {
+    double   max_fps;
+    int      cpu_pct;
+    uint64_t win_t0;        /* 窗口起点（墙钟） */
+    uint64_t win_cpu0;      /* 窗口起点的进程 CPU 时间 */
+    uint64_t win_n;         /* 窗口内帧数 */
+    uint64_t slept_us;
+} ArchThrottle;
+
+static uint64_t cpu_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static void throttle_reset(ArchThrottle *t, uint64_t now)
+{
+    t->win_t0   = now;
+    t->win_cpu0 = cpu_now_us();
+    t->win_n    = 0;
+}
+
+/*
+ * 每编完一帧调用：吞吐上限要求本窗口第 n 帧不早于 t0 + n / max_fps，
+ * CPU 上限要求窗口墙钟不短于 CPU 时间 × 100 / cpu_pct，取较晚者休眠。
+ */
+static void throttle_frame(ArchThrottle *t)
+{
+    uint64_t now = rkav_now_monotonic_us();
+    if (now - t->win_t0 >= ARCH_THROTTLE_WIN_US) throttle_reset(t, now);
+    t->win_n++;
+
+    uint64_t due = now;
+    if (t->max_fps > 0.0) {
+        uint64_t d = t->win_t0 + (uint64_t)((double)t->win_n * 1e6 / t->max_fps);
+        if (d > due) due = d;
+    }
+    if (t->cpu_pct > 0) {
+        uint64_t cpu = cpu_now_us() - t->win_cpu0;
+        uint64_t d = t->win_t0 + cpu * 100ULL / (uint64_t)t->cpu_pct;
+        if (d > due) due = d;
+    }
+    if (due > now) {
+        uint64_t s = due - now;
+        if (s > ARCH_THROTTLE_WIN_US) s = ARCH_THROTTLE_WIN_US;
+        usleep((useconds_t)s);
+        t->slept_us += s;
+    }
+}
+
+/* ============================================================================
+ * 转码
+ * ============================================================================ */
+
+typedef struct {
+    const ArchiveOpts *o;
+    const char   *name;
+    ArchCodec     codec;
+    ArchReader    rd;
+    ArchThrottle  thr;
+    ArchiveResult *res;
+    FILE         *out;
+    RecIndex      idx;
+    bool          idx_open;
+    bool          eos;
+    int           err;
+    uint64_t      t0;
+    uint64_t      cpu0;
+    uint64_t      tick_us;
+    uint64_t      tick_frames;
+} ArchJob;
+
+static void job_progress(ArchJob *j, uint64_t now)
+{
+    if (now - j->tick_us < 1000000ULL) return;
+    double sec = (double)(now - j->tick_us) / 1e6;
+    LOGI("[ARCH] %s %.0f%% frames=%llu %.1ffps out=%.2fMB", j->name,
+         j->rd.size ? (double)j->rd.pos * 100.0 / (double)j->rd.size : 0.0,
+         (unsigned long long)j->res->frames, (double)(j->res->frames - j->tick_frames) / sec,
+         (double)j->res->bytes_out / 1e6);
+    j->tick_us = now;
+    j->tick_frames = j->res->frames;
+}
+
+/* 处理一个解码输出帧（调用方已取到，本函数负责归还） */
+static void job_frame(ArchJob *j, DecFrame *f)
+{
+    if (f->eos) j->eos = true;
+    if (!f->data || f->corrupt) {
+        if (f->data) j->res->dec_errors++;
+        codec_dec_release(&j->codec, f);
+        return;
+    }
+
+    ArchCodec *c = &j->codec;
+    if (!c->enc_open) {
+        const ArchiveOpts *o = j->o;
+        int w = o->width  > 0 && o->width  < f->width  ? o->width  : f->width;
+        int h = o->height > 0 && o->height < f->height ? o->height : f->height;
+        if ((o->width > f->width) || (o->height > f->height))
+            LOGW("[%s] %s: output size clamped to source %dx%d (no upscaling)", TAG, j->name,
+                 f->width, f->height);
+        j->res->src_width  = f->width;
+        j->res->src_height = f->height;
+        j->res->out_width  = w & ~1;
+        j->res->out_height = h & ~1;
+        if (codec_enc_open(c, o, w & ~1, h & ~1) != 0) {
+            LOGE("[%s] %s: encoder init failed", TAG, j->name);
+            codec_dec_release(c, f);
+            j->err = 1;
+            return;
+        }
+    }
+
+    /* 换算到编码器输入后立即归还解码缓冲，池中的帧只在解码器内部周转 */
+    uint64_t pts = f->pts_us;
+    frame_to_enc(c, f);
+    codec_dec_release(c, f);
+
+    uint8_t *pkt = NULL;
+    size_t size = 0;
+    bool key = false;
+    uint32_t crc = 0;
+    uint64_t out_pts = pts;
+    if (codec_encode(c, pts, &pkt, &size, &key, &crc, &out_pts) != 0) {
+        LOGE("[%s] %s: encode failed", TAG, j->name);
+        j->err = 1;
+        return;
+    }
+    if (pkt && size > 0) {
+        uint64_t off = j->res->bytes_out;
+        if (fwrite(pkt, 1, size, j->out) != size ||
+            (j->idx_open && rec_index_append(&j->idx, off, (uint32_t)size, crc, out_pts,
+                                             key ? RECIDX_F_KEYFRAME : 0) != 0)) {
+            LOGE("[%s] %s: write failed: %s", TAG, j->name, strerror(errno));
+            j->err = 1;
+        }
+        j->res->bytes_out += size;
+        j->res->frames++;
+    }
+    free(pkt);
+
+    throttle_frame(&j->thr);
+    job_progress(j, rkav_now_monotonic_us());
+}
+
+/* 取完解码器当前能给出的帧，返回取到的帧数（-1 出错） */
+static int job_drain(ArchJob *j)
+{
+    int got = 0;
+    while (!j->err) {
+        DecFrame f;
+        int r = codec_dec_get(&j->codec, &f);
+        if (r < 0) return -1;
+        if (r == 0) break;
+        job_frame(j, &f);
+        got++;
+    }
+    return j->err ? -1 : got;
+}
+
+/* 投递一个访问单元（解码器输入满时先取帧） */
+static int job_put(ArchJob *j, const uint8_t *data, size_t size, uint64_t pts, bool eos)
+{
+    for (;;) {
+        int r = codec_dec_put(&j->codec, data, size, pts, eos);
+        if (r == 0) return 0;
+        if (r < 0) return -1;
+        int got = job_drain(j);
+        if (got < 0) return -1;
+        if (got == 0) usleep(1000);
+    }
+}
+
+int archive_file(const ArchiveOpts *o, const char *in_path, const char *out_path,
+                 ArchiveResult *res)
+{
+    ArchiveResult local;
+    if (!res) res = &local;
+    memset(res, 0, sizeof(*res));
+
+    ArchJob j;
+    memset(&j, 0, sizeof(j));
+    j.o    = o;
+    j.res  = res;
+    j.name = strrchr(in_path, '/') ? strrchr(in_path, '/') + 1 : in_path;
+    j.codec.be = o->backend;
+    j.t0   = rkav_now_monotonic_us();
+    j.cpu0 = cpu_now_us();
+    j.tick_us = j.t0;
+    j.thr.max_fps = o->max_fps;
+    j.thr.cpu_pct = o->cpu_pct;
+    throttle_reset(&j.thr, j.t0);
+
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", out_path);
+
+    int rc = -1;
+    if (reader_open(&j.rd, in_path, o->fps) != 0) goto out;
+    res->from_index = j.rd.n_ent > 0;
+    res->bytes_in   = j.rd.size;
+
+    j.out = fopen(tmp, "wb");
+    if (!j.out) {
+        LOGE("[%s] open %s: %s", TAG, tmp, strerror(errno));
+        goto out;
+    }
+    j.idx_open = rec_index_open(&j.idx, tmp, REC_INDEX_H264) == 0;
+    if (codec_dec_open(&j.codec, o) != 0) goto out;
+
+    LOGI("[%s] %s: %.2fMB %s -> %s %dkbps", TAG, j.name, (double)j.rd.size / 1e6,
+         res->from_index ? "indexed" : "scanned", arch_backend_name(o->backend), o->bitrate / 1000);
+
+    for (;;) {
+        const uint8_t *au = NULL;
+        size_t au_len = 0;
+        uint64_t pts = 0;
+        int r = reader_next(&j.rd, &au, &au_len, &pts);
+        if (r < 0) goto out;
+        if (r == 0) break;
+        res->units++;
+        if (job_put(&j, au, au_len, pts, false) != 0 || job_drain(&j) < 0) goto out;
+    }
+
+    /* 结束标记：取完解码器缓存的帧，直到结束帧或超时 */
+    if (job_put(&j, NULL, 0, 0, true) != 0) goto out;
+    uint64_t deadline = rkav_now_monotonic_us() + ARCH_DRAIN_TIMEOUT_US;
+    while (!j.eos && rkav_now_monotonic_us() < deadline) {
+        int got = job_drain(&j);
+        if (got < 0) goto out;
+        if (got == 0) usleep(1000);
+    }
+    if (!j.eos)
+        LOGW("[%s] %s: decoder did not signal end of stream", TAG, j.name);
+    if (res->frames == 0) {
+        LOGE("[%s] %s: no frames decoded", TAG, j.name);
+        goto out;
+    }
+
+    /* 落盘后再改名：调用方据此删除 / 替换原录像是安全的 */
+    if (fflush(j.out) != 0 || fsync(fileno(j.out)) != 0) {
+        LOGE("[%s] %s: flush failed: %s", TAG, tmp, strerror(errno));
+        goto out;
+    }
+    rc = 0;
+
+out:
+    codec_close(&j.codec);
+    reader_close(&j.rd);
+    if (j.out && fclose(j.out) != 0) rc = -1;
+    if (j.idx_open) rec_index_close(&j.idx);
+
+    char tmp_idx[600], out_idx[600];
+    snprintf(tmp_idx, sizeof(tmp_idx), "%s.idx", tmp);
+    snprintf(out_idx, sizeof(out_idx), "%s.idx", out_path);
+    if (rc == 0 && (rename(tmp, out_path) != 0 || (j.idx_open && rename(tmp_idx, out_idx) != 0))) {
+        LOGE("[%s] rename %s: %s", TAG, out_path, strerror(errno));
+        rc = -1;
+    }
+    if (rc != 0) {
+        unlink(tmp);
+        unlink(tmp_idx);
+    }
+
+    res->wall_us  = rkav_now_monotonic_us() - j.t0;
+    res->cpu_us   = cpu_now_us() - j.cpu0;
+    res->sleep_us = j.thr.slept_us;
+    return rc;
+}
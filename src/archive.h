@@ -0,0 +1,130 @@
+/**
+ * @file archive.h
+ * @brief 离线归档转码：已有录像解码 -> （缩放）-> 低码率重新编码
+ *
+ * 录像保留期较长时，超过一天的段文件不再需要录制码率（默认 2 Mbps）。本模块在板子上
+ * 后台把 Annex-B 录像重新编码到归档码率（默认 500 kbps），与实时录像共用 VPU：
+ * - 读取：有 "<录像>.idx" 时按索引逐包读取（PTS 取自索引，低延迟分片按 RECIDX_F_PARTIAL 拼回整帧，
+ *   索引比媒体文件短时剩余部分按起始码切帧）；没有索引时按访问单元切帧，PTS 按 fps 推算
+ * - 解码：MPP 解码器，输出帧来自固定大小的缓冲池（见 decoder_mpp.h）
+ * - 缩放：可选，NV12 双线性缩小，结果直接写成编码器输入布局（16 对齐 stride）；
+ *   不缩放时只做 stride 换算
+ * - 编码：MPP 编码器（CBR，可选智能 GOP），输出写 "<输出>.idx"，先写临时文件，成功后改名
+ * - 限速：每帧按吞吐上限（帧/秒，限制占用的 VPU 时间）与 CPU 上限（进程 CPU 时间 / 墙钟，
+ *   按 2 秒窗口计算）中较严的一个休眠；进程调度优先级另由 archive_set_priority() 降低
+ *
+ * 后端（ArchBackend）：
+ * - ARCH_BACKEND_MPP：真实硬件编解码
+ * - ARCH_BACKEND_MOCK：主机联调用的模拟编解码器，解码按 mock 尺寸生成测试图（同样走缓冲池），
+ *   编码按目标码率生成合法的 Annex-B 包（IDR 带 SPS/PPS），其输出可再次作为输入
+ *
+ * 典型使用流程：
+ * 1. archive_default_opts() 后按需修改
+ * 2. 进程启动时 archive_set_priority()（须在创建编解码器之前，MPP 内部线程继承调度策略）
+ * 3. 逐个文件 archive_file()，读取 ArchiveResult 汇总
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 模拟解码器缓冲池帧数 */
+#define ARCH_MOCK_POOL       4
+
+/** 限速窗口（微秒）：CPU / 吞吐按窗口内的平均值计算，避免长时间空闲后突发 */
+#define ARCH_THROTTLE_WIN_US 2000000ULL
+
+/**
+ * @brief 编解码后端
+ */
+typedef enum {
+    ARCH_BACKEND_MPP = 0,   /**< Rockchip MPP 硬件编解码 */
+    ARCH_BACKEND_MOCK,      /**< 模拟编解码器（主机联调） */
+} ArchBackend;
+
+/**
+ * @brief 进程调度优先级
+ */
+typedef enum {
+    ARCH_PRIO_IDLE = 0,     /**< SCHED_IDLE + IO 优先级 idle：只用空闲 CPU / 磁盘时间 */
+    ARCH_PRIO_LOW,          /**< nice 19 + IO best-effort 最低档 */
+    ARCH_PRIO_NORMAL,       /**< 不调整 */
+} ArchPrio;
+
+/**
+ * @brief 转码参数
+ */
+typedef struct {
+    ArchBackend backend;
+    int         width;          /**< 输出宽度，0 = 与源相同（只缩小，不放大） */
+    int         height;         /**< 输出高度，0 = 与源相同 */
+    int         bitrate;        /**< 目标码率（bps） */
+    int         fps;            /**< 码控帧率；没有索引时也用于推算 PTS */
+    bool        smart_gop;      /**< 智能 GOP（长期参考 + 虚拟 I 帧，AVBR），静止画面更省 */
+    int         pool_frames;    /**< 解码输出缓冲池帧数（<= 0 取 DEC_POOL_FRAMES） */
+    double      max_fps;        /**< 吞吐上限（帧/秒），0 = 不限 */
+    int         cpu_pct;        /**< CPU 占用上限（占单核百分比），0 = 不限 */
+    int         mock_width;     /**< 模拟解码器输出尺寸 */
+    int         mock_height;
+} ArchiveOpts;
+
+/**
+ * @brief 单个文件的转码结果
+ */
+typedef struct {
+    bool     from_index;        /**< 按 .idx 读取（否则按起始码切帧） */
+    int      src_width;
+    int      src_height;
+    int      out_width;
+    int      out_height;
+    uint64_t units;             /**< 读入的访问单元数 */
+    uint64_t frames;            /**< 编码输出的帧数 */
+    uint64_t dec_errors;        /**< 解码出错 / 被丢弃而跳过的帧 */
+    uint64_t bytes_in;          /**< 输入文件大小 */
+    uint64_t bytes_out;         /**< 输出文件大小 */
+    uint64_t wall_us;           /**< 总耗时 */
+    uint64_t cpu_us;            /**< 进程 CPU 时间（含 MPP 内部线程） */
+    uint64_t sleep_us;          /**< 限速休眠时间 */
+} ArchiveResult;
+
+/** 默认参数：MPP 后端、源尺寸、500 kbps、30 fps、吞吐 60 fps、CPU 25% */
+void archive_default_opts(ArchiveOpts *o);
+
+/**
+ * @brief 降低本进程的 CPU / IO 调度优先级
+ *
+ * @return int 0 成功，-1 部分设置失败（已告警，不影响转码）
+ */
+int  archive_set_priority(ArchPrio prio);
+
+/**
+ * @brief 转码一个录像文件
+ *
+ * 输出先写 "<out_path>.tmp"（及其 .idx），成功后改名为 out_path / "<out_path>.idx"；
+ * 失败时删除临时文件。
+ *
+ * @param o         转码参数
+ * @param in_path   输入录像（H.264 Annex-B）
+ * @param out_path  输出路径（不能与输入相同）
+ * @param res       输出：结果统计（可为 NULL）
+ * @return int 0 成功，-1 失败
+ */
+int  archive_file(const ArchiveOpts *o, const char *in_path, const char *out_path,
+                  ArchiveResult *res);
+
+/** 后端名称（mpp / mock） */
+const char *arch_backend_name(ArchBackend b);
+
+/** 解析后端名称，-1 无效 */
+int  arch_parse_backend(const char *s, ArchBackend *out);
+
+/** 解析优先级名称（idle / low / normal），-1 无效 */
+int  arch_parse_prio(const char *s, ArchPrio *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,11 +8,21 @@
  * - audio_capture_close: 关闭设备并释放资源
  * 
  * 当编译环境缺少 ALSA 时，提供占位实现。
+ * 
+ * 设备名以 "synth:" 开头时使用合成音源（正弦波，按墙钟节拍输出），
+ * 不依赖 ALSA，用于主机上联调多麦克风对齐/混音等逻辑。
  */
 #include "audio_capture.h"
+#include "boot_trace.h"
 #include "log.h"
 
+#include "rkav/time.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 /**
  * ssize_t 在不同平台的声明位置不同：
@@ -29,6 +39,26 @@ typedef SSIZE_T ssize_t;
 /** 模块日志标签 */
 #define TAG "audio"
 
+/*
+ * 由选项换算 period / 环形缓冲帧数（缓冲至少 2 个 period）。
+ */
+static void buffer_geometry(const AudioCaptureOpts *opts, unsigned int rate,
+                            snd_pcm_uframes_t *period, snd_pcm_uframes_t *buffer)
+{
+    snd_pcm_uframes_t p = AUDIO_CAP_PERIOD_FRAMES;
+    if (opts && opts->period_us)
+        p = (snd_pcm_uframes_t)((uint64_t)rate * opts->period_us / 1000000u);
+    if (p < 16) p = 16;
+
+    snd_pcm_uframes_t b = p * AUDIO_CAP_PERIODS;
+    if (opts && opts->buffer_us)
+        b = (snd_pcm_uframes_t)((uint64_t)rate * opts->buffer_us / 1000000u);
+    if (b < 2 * p) b = 2 * p;
+
+    *period = p;
+    *buffer = b;
+}
+
 #if !RK_ALSA_AVAILABLE
 
 /*
@@ -40,17 +70,20 @@ typedef SSIZE_T ssize_t;
  * @param device      ALSA 设备名（未使用）
  * @param sample_rate 采样率（未使用）
  * @param channels    声道数（未使用）
+ * @param opts        采集选项（未使用）
  * @return            -1 表示不可用
  */
-int audio_capture_open(AudioCapture *ac,
-                       const char *device,
-                       unsigned int sample_rate,
-                       int channels)
+static int alsa_open(AudioCapture *ac,
+                     const char *device,
+                     unsigned int sample_rate,
+                     int channels,
+                     const AudioCaptureOpts *opts)
 {
     (void)ac;
     (void)device;
     (void)sample_rate;
     (void)channels;
+    (void)opts;
     LOGE("[%s] ALSA headers not found. Please install ALSA dev package.", TAG);
     return -1;
 }
@@ -63,7 +96,7 @@ int audio_capture_open(AudioCapture *ac,
  * @param bytes  期望读取字节数（未使用）
  * @return       -1 表示不可用
  */
-ssize_t audio_capture_read(AudioCapture *ac, uint8_t *buf, size_t bytes)
+static ssize_t alsa_read(AudioCapture *ac, uint8_t *buf, size_t bytes)
 {
     (void)ac;
     (void)buf;
@@ -75,65 +108,154 @@ ssize_t audio_capture_read(AudioCapture *ac, uint8_t *buf, size_t bytes)
 /*
  * 关闭音频采集（当 ALSA 不可用时为 no-op）。
  */
-void audio_capture_close(AudioCapture *ac)
+static void alsa_close(AudioCapture *ac)
 {
     (void)ac;
 }
 
 #else
 
+/*
+ * 记录一次成功读取：now 时刻读出 n 帧后，缓冲中还有 pending 帧已采集未读。
+ * 这一块首帧的采集时刻 = now - (pending + n) / rate；刚从 overrun 恢复时与恢复前
+ * 记下的 next_us 比较，差值即丢失的时长（测量抖动为一次调度延迟，远小于一个 period）。
+ */
+static void note_read(AudioCapture *ac, uint64_t now, uint64_t n, uint64_t pending)
+{
+    uint64_t rate  = ac->sample_rate ? ac->sample_rate : 1;
+    uint64_t back  = (pending + n) * 1000000ull / rate;
+    uint64_t start = now > back ? now - back : 0;
+
+    if (ac->resync && ac->next_us && start > ac->next_us) {
+        uint64_t lost = (start - ac->next_us) * rate / 1000000ull;
+        ac->gap_frames       += lost;
+        ac->xrun_lost_frames += lost;
+    }
+    ac->resync  = 0;
+    ac->next_us = start + n * 1000000ull / rate;
+}
+
+/*
+ * ALSA 格式与转换器格式的对应表。
+ * 顺序即“无偏好时”的协商顺序：高位宽优先，FLOAT 最后。
+ */
+static const struct {
+    snd_pcm_format_t alsa;
+    AudioRawFmt      raw;
+} k_formats[] = {
+    { SND_PCM_FORMAT_S32_LE,   AUDIO_RAW_S32   },
+    { SND_PCM_FORMAT_S24_LE,   AUDIO_RAW_S24   },
+    { SND_PCM_FORMAT_S24_3LE,  AUDIO_RAW_S24_3 },
+    { SND_PCM_FORMAT_S16_LE,   AUDIO_RAW_S16   },
+    { SND_PCM_FORMAT_FLOAT_LE, AUDIO_RAW_F32   },
+};
+
+/*
+ * 管线格式对应的“免转换”设备格式。
+ */
+static snd_pcm_format_t preferred_format(RkavSampleFmt f)
+{
+    switch (f) {
+    case RKAV_SAMPLE_S32: return SND_PCM_FORMAT_S32_LE;
+    case RKAV_SAMPLE_F32: return SND_PCM_FORMAT_FLOAT_LE;
+    case RKAV_SAMPLE_S16:
+    default:              return SND_PCM_FORMAT_S16_LE;
+    }
+}
+
+/*
+ * 协商设备采样格式：先试与管线一致的格式（直通），再按 k_formats 顺序逐个尝试。
+ *
+ * @return 0 成功（ac->format / ac->raw_fmt 已设置）；-1 设备不支持任何已知格式
+ */
+static int negotiate_format(AudioCapture *ac, snd_pcm_hw_params_t *hwparams)
+{
+    snd_pcm_format_t pref = preferred_format(ac->sample_fmt);
+
+    for (size_t i = 0; i < sizeof(k_formats) / sizeof(k_formats[0]); i++) {
+        if (k_formats[i].alsa != pref) continue;
+        if (snd_pcm_hw_params_test_format(ac->handle, hwparams, pref) == 0) {
+            ac->format  = pref;
+            ac->raw_fmt = k_formats[i].raw;
+            return 0;
+        }
+    }
+    for (size_t i = 0; i < sizeof(k_formats) / sizeof(k_formats[0]); i++) {
+        if (snd_pcm_hw_params_test_format(ac->handle, hwparams, k_formats[i].alsa) == 0) {
+            ac->format  = k_formats[i].alsa;
+            ac->raw_fmt = k_formats[i].raw;
+            return 0;
+        }
+    }
+    return -1;
+}
+
 /*
  * 打开并初始化 ALSA PCM 采集。
  *
  * 典型流程：
  * 1) snd_pcm_open 打开采集设备
- * 2) 配置硬件参数（交错格式/采样格式/声道/采样率/period size）
- * 3) 计算 bytes_per_frame（每个采样帧字节数）
+ * 2) 协商采样格式（优先与管线格式一致）
+ * 3) 配置硬件参数（交错格式/采样格式/声道/采样率/period 与 buffer 大小）
+ * 4) 配置软件参数（avail_min / start_threshold / stop_threshold）
+ * 5) 计算设备/输出两侧的 bytes_per_frame，非直通时准备转换器与读缓冲
  *
  * @param ac          输出：采集上下文
  * @param device      ALSA 设备名（例如 "hw:0,0"）
  * @param sample_rate 期望采样率（驱动可能会近似调整）
  * @param channels    声道数
+ * @param opts        采集选项（NULL 表示 S16、不抖动、默认缓冲）
  * @return            0 成功；-1 失败
  */
-int audio_capture_open(AudioCapture *ac,
-                       const char *device,
-                       unsigned int sample_rate,
-                       int channels)
+static int alsa_open(AudioCapture *ac,
+                     const char *device,
+                     unsigned int sample_rate,
+                     int channels,
+                     const AudioCaptureOpts *opts)
 {
     if (!ac || !device) return -1;
     memset(ac, 0, sizeof(*ac));
 
     ac->sample_rate = sample_rate;
     ac->channels    = channels;
-    /* 当前固定为 16-bit little-endian，交错格式（LRLR...）。 */
-    ac->format      = SND_PCM_FORMAT_S16_LE;  // 16bit 小端
-    /* period 可以按延迟/吞吐需求调整：越小延迟越低但系统开销越大。 */
-    ac->frames_per_period = 1024;            // 可以随便调
+    ac->sample_fmt  = opts ? opts->sample_fmt : RKAV_SAMPLE_S16;
+    /* period 越小唤醒越频繁、采集延迟越低；buffer 越大，读线程卡顿越久才会 overrun。 */
+    buffer_geometry(opts, sample_rate, &ac->frames_per_period, &ac->buffer_frames);
 
     int err;
 
     /* 1) 打开 PCM 采集设备 */
+    boot_trace_begin(BOOT_ALSA_OPEN);
     if ((err = snd_pcm_open(&ac->handle, device,
                             SND_PCM_STREAM_CAPTURE, 0)) < 0) {
         LOGE("[%s] snd_pcm_open(%s) failed: %s",
              TAG, device, snd_strerror(err));
         return -1;
     }
+    boot_trace_end(BOOT_ALSA_OPEN);
 
     /* 2) 配置硬件参数 */
+    boot_trace_begin(BOOT_ALSA_HW);
     snd_pcm_hw_params_t *hwparams = NULL;
     snd_pcm_hw_params_alloca(&hwparams);
 
     snd_pcm_hw_params_any(ac->handle, hwparams);
     snd_pcm_hw_params_set_access(ac->handle, hwparams,
                                  SND_PCM_ACCESS_RW_INTERLEAVED);
+    if (negotiate_format(ac, hwparams) != 0) {
+        LOGE("[%s] %s: no supported sample format (S16/S24/S24_3/S32/FLOAT)",
+             TAG, device);
+        snd_pcm_close(ac->handle);
+        ac->handle = NULL;
+        return -1;
+    }
     snd_pcm_hw_params_set_format(ac->handle, hwparams, ac->format);
     snd_pcm_hw_params_set_channels(ac->handle, hwparams, ac->channels);
     snd_pcm_hw_params_set_rate_near(ac->handle, hwparams,
                                     &ac->sample_rate, NULL);
     snd_pcm_hw_params_set_period_size_near(ac->handle, hwparams,
                                            &ac->frames_per_period, NULL);
+    snd_pcm_hw_params_set_buffer_size_near(ac->handle, hwparams, &ac->buffer_frames);
 
     if ((err = snd_pcm_hw_params(ac->handle, hwparams)) < 0) {
         LOGE("[%s] snd_pcm_hw_params failed: %s",
@@ -142,27 +264,64 @@ int audio_capture_open(AudioCapture *ac,
         ac->handle = NULL;
         return -1;
     }
+    snd_pcm_hw_params_get_period_size(hwparams, &ac->frames_per_period, NULL);
+    snd_pcm_hw_params_get_buffer_size(hwparams, &ac->buffer_frames);
 
-    /* bytes_per_frame：每个“采样帧”的字节数 = (位宽/8) * 声道数 */
-    ac->bytes_per_frame =
-        snd_pcm_format_width(ac->format) / 8 * ac->channels; // e.g. 2ch*2B = 4B
+    /* 3) 软件参数：一个 period 就绪即唤醒，首次读即启动，缓冲写满才判 overrun */
+    snd_pcm_sw_params_t *swparams = NULL;
+    snd_pcm_sw_params_alloca(&swparams);
+    snd_pcm_sw_params_current(ac->handle, swparams);
+    snd_pcm_sw_params_set_avail_min(ac->handle, swparams, ac->frames_per_period);
+    snd_pcm_sw_params_set_start_threshold(ac->handle, swparams, 1);
+    snd_pcm_sw_params_set_stop_threshold(ac->handle, swparams, ac->buffer_frames);
+    if ((err = snd_pcm_sw_params(ac->handle, swparams)) < 0)
+        LOGW("[%s] snd_pcm_sw_params failed: %s (driver defaults)", TAG, snd_strerror(err));
 
-    LOGI("[%s] opened device=%s, %u Hz, ch=%d, period=%lu frames, %zu B/frame",
+    /*
+     * bytes_per_frame：每个“采样帧”的字节数 = 样本字节 * 声道数
+     * 设备侧按物理位宽（S24_3LE 为 3 字节，S24_LE 为 4 字节容器），输出侧按管线格式。
+     */
+    ac->dev_bytes_per_frame = audio_raw_fmt_bytes(ac->raw_fmt) * (size_t)ac->channels;
+    ac->bytes_per_frame     = rkav_sample_fmt_bytes(ac->sample_fmt) * (size_t)ac->channels;
+
+    audio_converter_init(&ac->conv, ac->raw_fmt, ac->sample_fmt, opts ? opts->dither : 0);
+    if (!audio_converter_is_passthrough(&ac->conv)) {
+        ac->scratch_bytes = (size_t)ac->frames_per_period * ac->dev_bytes_per_frame;
+        ac->scratch = (uint8_t *)malloc(ac->scratch_bytes);
+        if (!ac->scratch) {
+            LOGE("[%s] malloc scratch failed", TAG);
+            snd_pcm_close(ac->handle);
+            ac->handle = NULL;
+            return -1;
+        }
+    }
+
+    boot_trace_end(BOOT_ALSA_HW);
+    LOGI("[%s] opened device=%s, %u Hz, ch=%d, period=%lu frames (%.1fms), buffer=%lu frames (%.1fms), %zu B/frame",
          TAG, device, ac->sample_rate, ac->channels,
-         (unsigned long)ac->frames_per_period, ac->bytes_per_frame);
+         (unsigned long)ac->frames_per_period,
+         (double)ac->frames_per_period * 1000.0 / (double)ac->sample_rate,
+         (unsigned long)ac->buffer_frames,
+         (double)ac->buffer_frames * 1000.0 / (double)ac->sample_rate, ac->bytes_per_frame);
+    LOGI("[%s] format: device=%s -> pipeline=%s (%s%s)", TAG,
+         audio_raw_fmt_name(ac->raw_fmt), rkav_sample_fmt_name(ac->sample_fmt),
+         audio_converter_is_passthrough(&ac->conv) ? "passthrough" : audio_convert_simd_name(),
+         ac->conv.dither ? ", dither" : "");
 
     return 0;
 }
 
 /*
- * 从 ALSA 采集设备读取音频数据。
+ * 从 ALSA 采集设备读取音频数据，并转换为管线采样格式。
+ *
+ * 直通时直接读入 buf；否则先读入 scratch（设备格式），再转换到 buf。
  *
  * @param ac     采集上下文
- * @param buf    输出缓冲
- * @param bytes  期望读取字节数（会按 bytes_per_frame 换算为帧数读取）
- * @return       >0 实际读取字节数；0 表示本次请求不足以构成 1 帧；-1 失败
+ * @param buf    输出缓冲（管线格式）
+ * @param bytes  期望输出字节数（会按 bytes_per_frame 换算为帧数读取）
+ * @return       >0 实际输出字节数；0 表示本次请求不足以构成 1 帧；-1 失败
  */
-ssize_t audio_capture_read(AudioCapture *ac, uint8_t *buf, size_t bytes)
+static ssize_t alsa_read(AudioCapture *ac, uint8_t *buf, size_t bytes)
 {
     if (!ac || !ac->handle || !buf || bytes == 0) return -1;
 
@@ -170,9 +329,24 @@ ssize_t audio_capture_read(AudioCapture *ac, uint8_t *buf, size_t bytes)
     size_t frames_to_read = bytes / ac->bytes_per_frame;
     if (frames_to_read == 0) return 0;
 
-    snd_pcm_sframes_t n = snd_pcm_readi(ac->handle, buf, frames_to_read);
+    uint8_t *dst = buf;
+    if (ac->scratch) {
+        size_t need = frames_to_read * ac->dev_bytes_per_frame;
+        if (need > ac->scratch_bytes) {
+            uint8_t *p = (uint8_t *)realloc(ac->scratch, need);
+            if (!p) return -1;
+            ac->scratch = p;
+            ac->scratch_bytes = need;
+        }
+        dst = ac->scratch;
+    }
+
+    snd_pcm_sframes_t n = snd_pcm_readi(ac->handle, dst, frames_to_read);
     if (n < 0) {
-        /* 发生 underrun/设备暂停等错误时，尝试恢复一次（允许重启 stream）。 */
+        if (n == -EPIPE) ac->xrun_count++;
+        /* overrun / 挂起恢复后缓冲内容已丢弃，下一块重新测量采集时刻以计算缺口 */
+        if (n == -EPIPE || n == -ESTRPIPE) ac->resync = 1;
+        /* 发生 overrun/设备暂停等错误时，尝试恢复一次（允许重启 stream）。 */
         n = snd_pcm_recover(ac->handle, n, 1);
         if (n < 0) {
             LOGE("[%s] snd_pcm_readi failed: %s",
@@ -180,15 +354,25 @@ ssize_t audio_capture_read(AudioCapture *ac, uint8_t *buf, size_t bytes)
             return -1;
         }
     }
+    if (n > 0) {
+        uint64_t now = rkav_now_monotonic_us();
+        snd_pcm_sframes_t pending = 0;
+        if (snd_pcm_delay(ac->handle, &pending) < 0 || pending < 0)
+            pending = 0;
+        note_read(ac, now, (uint64_t)n, (uint64_t)pending);
+    }
+
+    if (ac->scratch && n > 0)
+        audio_convert(&ac->conv, buf, ac->scratch, (size_t)n * (size_t)ac->channels);
 
-    /* 返回实际读取到的字节数。 */
+    /* 返回实际输出的字节数（管线格式）。 */
     return n * ac->bytes_per_frame;
 }
 
 /*
  * 关闭 ALSA 采集并清理上下文。
  */
-void audio_capture_close(AudioCapture *ac)
+static void alsa_close(AudioCapture *ac)
 {
     if (!ac) return;
 
@@ -196,9 +380,154 @@ void audio_capture_close(AudioCapture *ac)
         snd_pcm_close(ac->handle);
         ac->handle = NULL;
     }
+    free(ac->scratch);
 
     memset(ac, 0, sizeof(*ac));
     LOGI("[%s] audio capture closed", TAG);
 }
 
 #endif
+
+/* ============================================================================
+ * 合成音源：synth:<freq>[@<ppm>]
+ *
+ * - 输出正弦波（各声道同频，幅度 0.25），先生成 FLOAT 再转换为管线格式
+ * - 按墙钟节拍输出：第 k 帧在 t0 + k / (rate × (1 + ppm×1e-6)) 时刻“可读”，
+ *   ppm 用于模拟两块声卡晶振的微小频偏
+ * - 调用方落后超过环形缓冲时长（buffer_frames）时，模拟 overrun：
+ *   丢弃积压样本并计入 xrun_count 与丢失帧数，与 ALSA 行为一致
+ * ============================================================================ */
+
+static int synth_open(AudioCapture *ac, const char *spec,
+                      unsigned int sample_rate, int channels,
+                      const AudioCaptureOpts *opts)
+{
+    memset(ac, 0, sizeof(*ac));
+    boot_trace_begin(BOOT_ALSA_OPEN);
+
+    double freq = 440.0, ppm = 0.0;
+    const char *p = spec + strlen("synth:");
+    if (*p) freq = atof(p);
+    const char *at = strchr(p, '@');
+    if (at) ppm = atof(at + 1);
+    if (freq <= 0.0) freq = 440.0;
+
+    ac->is_synth          = 1;
+    ac->sample_rate       = sample_rate;
+    ac->channels          = channels;
+    ac->sample_fmt        = opts ? opts->sample_fmt : RKAV_SAMPLE_S16;
+    ac->raw_fmt           = AUDIO_RAW_F32;
+    buffer_geometry(opts, sample_rate, &ac->frames_per_period, &ac->buffer_frames);
+    ac->dev_bytes_per_frame = audio_raw_fmt_bytes(ac->raw_fmt) * (size_t)channels;
+    ac->bytes_per_frame     = rkav_sample_fmt_bytes(ac->sample_fmt) * (size_t)channels;
+
+    audio_converter_init(&ac->conv, ac->raw_fmt, ac->sample_fmt, opts ? opts->dither : 0);
+    if (!audio_converter_is_passthrough(&ac->conv)) {
+        ac->scratch_bytes = (size_t)ac->frames_per_period * ac->dev_bytes_per_frame;
+        ac->scratch = (uint8_t *)malloc(ac->scratch_bytes);
+        if (!ac->scratch) return -1;
+    }
+
+    ac->synth_step  = 2.0 * M_PI * freq / (double)sample_rate;
+    ac->synth_rate  = (double)sample_rate * (1.0 + ppm * 1e-6);
+    ac->synth_t0_us = rkav_now_monotonic_us();
+    boot_trace_end(BOOT_ALSA_OPEN);
+
+    LOGI("[%s] opened synth %.1fHz rate=%uHz%+.1fppm ch=%d fmt=%s", TAG,
+         freq, sample_rate, ppm, channels, rkav_sample_fmt_name(ac->sample_fmt));
+    return 0;
+}
+
+static ssize_t synth_read(AudioCapture *ac, uint8_t *buf, size_t bytes)
+{
+    size_t frames = bytes / ac->bytes_per_frame;
+    if (frames == 0) return 0;
+
+    /* 节拍：等到这批样本“采集完成”的时刻 */
+    uint64_t due = ac->synth_t0_us +
+        (uint64_t)((double)(ac->synth_frames + frames) * 1e6 / ac->synth_rate);
+    uint64_t now = rkav_now_monotonic_us();
+    uint64_t buffer_us = (uint64_t)((double)ac->buffer_frames * 1e6 / ac->synth_rate);
+
+    if (now < due) {
+        struct timespec ts;
+        ts.tv_sec  = (time_t)(due / 1000000ULL);
+        ts.tv_nsec = (long)(due % 1000000ULL) * 1000L;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        }
+    } else if (now > due + buffer_us) {
+        /* 模拟 overrun：积压的样本丢失，从“现在”重新开始 */
+        uint64_t resume = (uint64_t)((double)(now - ac->synth_t0_us) * ac->synth_rate / 1e6) - frames;
+        ac->xrun_count++;
+        ac->gap_frames       += resume - ac->synth_frames;
+        ac->xrun_lost_frames += resume - ac->synth_frames;
+        ac->synth_frames = resume;
+    }
+
+    size_t need = frames * ac->dev_bytes_per_frame;
+    if (ac->scratch && need > ac->scratch_bytes) {
+        uint8_t *p = (uint8_t *)realloc(ac->scratch, need);
+        if (!p) return -1;
+        ac->scratch = p;
+        ac->scratch_bytes = need;
+    }
+
+    float *out = (float *)(ac->scratch ? ac->scratch : buf);
+    for (size_t i = 0; i < frames; i++) {
+        float v = 0.25f * (float)sin(ac->synth_phase);
+        ac->synth_phase += ac->synth_step;
+        if (ac->synth_phase > 2.0 * M_PI) ac->synth_phase -= 2.0 * M_PI;
+        for (int c = 0; c < ac->channels; c++)
+            out[i * (size_t)ac->channels + (size_t)c] = v;
+    }
+    ac->synth_frames += frames;
+
+    if (ac->scratch)
+        audio_convert(&ac->conv, buf, ac->scratch, frames * (size_t)ac->channels);
+
+    return (ssize_t)(frames * ac->bytes_per_frame);
+}
+
+/* ============================================================================
+ * 对外接口：按设备名分发到 ALSA 或合成音源
+ * ============================================================================ */
+
+int audio_capture_open(AudioCapture *ac,
+                       const char *device,
+                       unsigned int sample_rate,
+                       int channels,
+                       const AudioCaptureOpts *opts)
+{
+    if (!ac || !device) return -1;
+    if (strncmp(device, "synth:", 6) == 0)
+        return synth_open(ac, device, sample_rate, channels, opts);
+    return alsa_open(ac, device, sample_rate, channels, opts);
+}
+
+uint64_t audio_capture_take_gap(AudioCapture *ac)
+{
+    if (!ac) return 0;
+    uint64_t g = ac->gap_frames;
+    ac->gap_frames = 0;
+    return g;
+}
+
+ssize_t audio_capture_read(AudioCapture *ac, uint8_t *buf, size_t bytes)
+{
+    if (!ac || !buf || bytes == 0) return -1;
+    if (ac->is_synth)
+        return synth_read(ac, buf, bytes);
+    return alsa_read(ac, buf, bytes);
+}
+
+void audio_capture_close(AudioCapture *ac)
+{
+    if (!ac) return;
+    if (ac->is_synth) {
+        free(ac->scratch);
+        memset(ac, 0, sizeof(*ac));
+        LOGI("[%s] synth closed", TAG);
+        return;
+    }
+    alsa_close(ac);
+}
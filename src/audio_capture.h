@@ -8,12 +8,22 @@
  * 特性：
  * - 支持编译时检测 ALSA 可用性（使用 __has_include）
  * - 当 ALSA 不可用时，提供占位实现并输出错误信息
- * - 固定使用 S16_LE（16位小端）采样格式
+ * - 采样格式协商：依次尝试设备原生的 S16/S32/S24/S24_3/FLOAT，
+ *   读出后由 audio_convert 转换为管线配置的格式（RkavSampleFmt）
+ * - 缓冲配置：period（唤醒粒度，决定采集延迟）与环形缓冲（读线程卡顿的容忍时长）显式设置，
+ *   sw_params 的 avail_min = 1 个 period、start_threshold = 1（首次读即启动）、
+ *   stop_threshold = 缓冲大小（缓冲写满才 overrun）
+ * - xrun 计量：overrun 恢复后，由恢复前最后一次读到的帧与恢复后第一块的采集时刻
+ *   （读返回时刻减去缓冲中尚未读出的帧）之差估算丢失的帧数，调用方经
+ *   audio_capture_take_gap() 取走后补静音或让 PTS 跳变，时间轴不再假装连续
  */
 #pragma once
 
 #include <stdint.h>
 #include <stddef.h>
+#include <sys/types.h>
+
+#include "audio_convert.h"
 
 /* ============================================================================
  * ALSA 可用性检测
@@ -41,6 +51,22 @@ typedef unsigned long snd_pcm_uframes_t;  /**< 帧数占位类型 */
 typedef long snd_pcm_sframes_t;           /**< 有符号帧数占位类型 */
 #endif
 
+/**
+ * @brief 音频采集选项
+ */
+typedef struct {
+    RkavSampleFmt sample_fmt;   /**< 管线采样格式（读出后转换成该格式） */
+    int           dither;       /**< 缩减到 S16 时是否加 TPDF 抖动 */
+    unsigned int  period_us;    /**< period 时长（0 = AUDIO_CAP_PERIOD_FRAMES 帧） */
+    unsigned int  buffer_us;    /**< 环形缓冲时长（0 = AUDIO_CAP_PERIODS 个 period；至少 2 个） */
+} AudioCaptureOpts;
+
+/** 默认 period 帧数（48kHz 约 21ms） */
+#define AUDIO_CAP_PERIOD_FRAMES  1024
+
+/** 默认环形缓冲包含的 period 数 */
+#define AUDIO_CAP_PERIODS        8
+
 /**
  * @brief 音频采集上下文结构体
  * 
@@ -50,37 +76,74 @@ typedef struct {
     snd_pcm_t          *handle;           /**< ALSA PCM 设备句柄 */
     unsigned int        sample_rate;      /**< 实际采样率（驱动可能会调整） */
     int                 channels;         /**< 声道数 */
-    snd_pcm_format_t    format;           /**< 采样格式（当前固定 S16_LE） */
+    snd_pcm_format_t    format;           /**< 设备实际采样格式（协商结果） */
+    AudioRawFmt         raw_fmt;          /**< 设备格式（转换器视角） */
+    RkavSampleFmt       sample_fmt;       /**< 输出（管线）采样格式 */
     snd_pcm_uframes_t   frames_per_period;/**< 每个 period 的帧数 */
-    size_t              bytes_per_frame;  /**< 每帧字节数 = (位宽/8) × 声道数 */
+    snd_pcm_uframes_t   buffer_frames;    /**< 环形缓冲帧数 */
+    size_t              bytes_per_frame;  /**< 输出每帧字节数 = 管线样本字节 × 声道数 */
+    size_t              dev_bytes_per_frame; /**< 设备每帧字节数 */
+
+    AudioConverter      conv;             /**< 设备格式 -> 管线格式转换器 */
+    uint8_t            *scratch;          /**< 非直通时的设备格式读缓冲 */
+    size_t              scratch_bytes;    /**< scratch 容量 */
+
+    uint64_t            xrun_count;       /**< 累计 overrun 次数（读线程写，其他线程仅做统计读取） */
+    uint64_t            xrun_lost_frames; /**< 累计因 overrun 丢失的帧数（估算） */
+    uint64_t            gap_frames;       /**< 尚未被 audio_capture_take_gap() 取走的丢失帧数 */
+    int                 resync;           /**< 刚从 overrun 恢复，下一块重新测量采集时刻 */
+    uint64_t            next_us;          /**< 下一个未读帧的采集时刻（估算，0 = 尚未读过） */
+
+    /* 合成音源（设备名 "synth:<freq>[@<ppm>]"），用于无声卡的主机联调 */
+    int                 is_synth;         /**< 1 表示合成音源 */
+    double              synth_phase;      /**< 正弦相位 */
+    double              synth_step;       /**< 每样本相位增量 */
+    double              synth_rate;       /**< 实际输出速率（含 ppm 偏差） */
+    uint64_t            synth_t0_us;      /**< 起始时刻 */
+    uint64_t            synth_frames;     /**< 已输出帧数 */
 } AudioCapture;
 
 /**
  * @brief 打开 ALSA 采集设备
  * 
  * 初始化 PCM 采集，配置硬件参数（采样率、声道、格式等）。
+ * 采样格式按设备支持情况协商，优先选择与管线格式一致的格式（免转换）。
  * 
  * @param ac          输出：采集上下文
- * @param device      ALSA 设备名，例如 "hw:0,0"、"default"
+ * @param device      ALSA 设备名，例如 "hw:0,0"、"default"；
+ *                    "synth:<freq>[@<ppm>]" 为合成音源（例如 "synth:440@+200"）
  * @param sample_rate 期望采样率（驱动可能会近似调整）
  * @param channels    声道数
+ * @param opts        采集选项（NULL 表示 S16、不抖动）
  * @return int        0 成功，-1 失败
  */
 int audio_capture_open(AudioCapture *ac,
                        const char *device,
                        unsigned int sample_rate,
-                       int channels);
+                       int channels,
+                       const AudioCaptureOpts *opts);
 
 /**
- * @brief 从设备读取 PCM 数据（阻塞）
+ * @brief 从设备读取 PCM 数据（阻塞），输出为管线采样格式
  * 
  * @param ac    采集上下文
- * @param buf   输出缓冲区
+ * @param buf   输出缓冲区（管线格式）
  * @param bytes 期望读取的字节数（建议是 frames_per_period × bytes_per_frame 的整数倍）
- * @return ssize_t 实际读取的字节数，<0 表示出错
+ * @return ssize_t 实际输出的字节数，<0 表示出错
  */
 ssize_t audio_capture_read(AudioCapture *ac, uint8_t *buf, size_t bytes);
 
+/**
+ * @brief 取走自上次调用以来因 overrun 丢失的帧数（采集线程每次读成功后调用）
+ *
+ * 返回值非 0 时，刚读出的这一块与上一块之间缺了这么多帧：调用方应在这一块之前
+ * 补等长静音，或把这一块的 PTS 后移相应时长。
+ *
+ * @param ac 采集上下文
+ * @return uint64_t 丢失帧数（0 表示连续）
+ */
+uint64_t audio_capture_take_gap(AudioCapture *ac);
+
 /**
  * @brief 关闭设备并释放资源
  * 
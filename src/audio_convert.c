@@ -0,0 +1,446 @@
+/**
+ * @file audio_convert.c
+ * @brief PCM 采样格式转换模块实现
+ *
+ * 转换路径：
+ * - 同格式：memcpy 直通
+ * - FLOAT 输入：直接 f32 -> s16 / s32
+ * - 整数输入：按 256 样本分块，先规整为满幅 s32（栈上临时块），
+ *   再由 s32 -> s16 / s32 / f32 内核输出；S32 输入跳过规整步骤
+ *
+ * 抖动（TPDF）：
+ * - 在 24 bit 域（s32 >> 8）加上 [-255, 255] 的三角分布噪声（约 ±1 LSB@16bit），
+ *   再做带舍入的饱和右移 8 位得到 s16
+ * - 随机数来自 4 路并行 xorshift32，一次输出拆两个 8 bit 均匀分布相加
+ *
+ * 每个内核都是“向量主循环 + 标量尾部”，不加抖动时标量实现与向量实现逐样本一致：
+ * FLOAT 输入的标量尾部用 lrintf（按当前舍入模式，默认就近取偶），与 vcvtnq / cvtps 相同，
+ * 同一个样本不会因为落在块尾而转换出不同的值（rkav_bench aconv 校验）。
+ */
+#include "audio_convert.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#  include <arm_neon.h>
+#  define AC_NEON 1
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#  define AC_SSE2 1
+#  if defined(__SSSE3__)
+#    include <tmmintrin.h>
+#    define AC_SSSE3 1
+#  endif
+#endif
+
+/** 整数路径的分块大小（样本数） */
+#define AC_BLOCK  256
+
+/** FLOAT -> S32 时的输入上限：小于 1.0 的最大 float（1 - 2^-24），乘 2^31 后不溢出 */
+#define AC_F32_MAX_BELOW_ONE  0.99999994f
+
+/* ============================================================================
+ * 格式信息
+ * ============================================================================ */
+
+size_t audio_raw_fmt_bytes(AudioRawFmt f)
+{
+    switch (f) {
+    case AUDIO_RAW_S16:   return 2;
+    case AUDIO_RAW_S24_3: return 3;
+    case AUDIO_RAW_S24:
+    case AUDIO_RAW_S32:
+    case AUDIO_RAW_F32:   return 4;
+    }
+    return 0;
+}
+
+const char *audio_raw_fmt_name(AudioRawFmt f)
+{
+    switch (f) {
+    case AUDIO_RAW_S16:   return "S16_LE";
+    case AUDIO_RAW_S24:   return "S24_LE";
+    case AUDIO_RAW_S24_3: return "S24_3LE";
+    case AUDIO_RAW_S32:   return "S32_LE";
+    case AUDIO_RAW_F32:   return "FLOAT_LE";
+    }
+    return "?";
+}
+
+size_t rkav_sample_fmt_bytes(RkavSampleFmt f)
+{
+    switch (f) {
+    case RKAV_SAMPLE_S16: return 2;
+    case RKAV_SAMPLE_S32:
+    case RKAV_SAMPLE_F32: return 4;
+    }
+    return 0;
+}
+
+const char *rkav_sample_fmt_name(RkavSampleFmt f)
+{
+    switch (f) {
+    case RKAV_SAMPLE_S16: return "s16le";
+    case RKAV_SAMPLE_S32: return "s32le";
+    case RKAV_SAMPLE_F32: return "f32le";
+    }
+    return "?";
+}
+
+const char *audio_convert_simd_name(void)
+{
+#if defined(AC_NEON)
+    return "neon";
+#elif defined(AC_SSSE3)
+    return "ssse3";
+#elif defined(AC_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+/* ============================================================================
+ * 标量辅助
+ * ============================================================================ */
+
+static inline int16_t sat16(int32_t v)
+{
+    if (v > 32767)  return 32767;
+    if (v < -32768) return -32768;
+    return (int16_t)v;
+}
+
+/* 单路 xorshift32 + TPDF：返回 [-255, 255] */
+static inline int32_t tpdf_scalar(uint32_t *st)
+{
+    uint32_t x = *st;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *st = x;
+    return (int32_t)((x >> 24) + ((x >> 16) & 0xff)) - 255;
+}
+
+/* ============================================================================
+ * 规整到满幅 s32
+ * ============================================================================ */
+
+static void s16_to_s32(int32_t *d, const int16_t *s, size_t n)
+{
+    size_t i = 0;
+#if defined(AC_NEON)
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t v = vld1q_s16(s + i);
+        vst1q_s32(d + i,     vshll_n_s16(vget_low_s16(v), 16));
+        vst1q_s32(d + i + 4, vshll_n_s16(vget_high_s16(v), 16));
+    }
+#elif defined(AC_SSE2)
+    const __m128i z = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        _mm_storeu_si128((__m128i *)(d + i),     _mm_unpacklo_epi16(z, v));
+        _mm_storeu_si128((__m128i *)(d + i + 4), _mm_unpackhi_epi16(z, v));
+    }
+#endif
+    for (; i < n; i++)
+        d[i] = (int32_t)((uint32_t)(uint16_t)s[i] << 16);
+}
+
+static void s24_to_s32(int32_t *d, const int32_t *s, size_t n)
+{
+    size_t i = 0;
+#if defined(AC_NEON)
+    for (; i + 4 <= n; i += 4)
+        vst1q_s32(d + i, vshlq_n_s32(vld1q_s32(s + i), 8));
+#elif defined(AC_SSE2)
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        _mm_storeu_si128((__m128i *)(d + i), _mm_slli_epi32(v, 8));
+    }
+#endif
+    for (; i < n; i++)
+        d[i] = (int32_t)((uint32_t)s[i] << 8);
+}
+
+static void s24_3_to_s32(int32_t *d, const uint8_t *s, size_t n)
+{
+    size_t i = 0;
+#if defined(AC_NEON)
+    /* vld3 按字节三路解交织：val[0]=低字节, val[1]=中字节, val[2]=高字节 */
+    const uint8x16_t z = vdupq_n_u8(0);
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x3_t t  = vld3q_u8(s + 3 * i);
+        uint8x16x2_t lo = vzipq_u8(z, t.val[0]);           /* u16 = b0 << 8 */
+        uint8x16x2_t hi = vzipq_u8(t.val[1], t.val[2]);    /* u16 = b1 | b2 << 8 */
+        uint16x8x2_t w0 = vzipq_u16(vreinterpretq_u16_u8(lo.val[0]),
+                                    vreinterpretq_u16_u8(hi.val[0]));
+        uint16x8x2_t w1 = vzipq_u16(vreinterpretq_u16_u8(lo.val[1]),
+                                    vreinterpretq_u16_u8(hi.val[1]));
+        vst1q_s32(d + i,      vreinterpretq_s32_u16(w0.val[0]));
+        vst1q_s32(d + i + 4,  vreinterpretq_s32_u16(w0.val[1]));
+        vst1q_s32(d + i + 8,  vreinterpretq_s32_u16(w1.val[0]));
+        vst1q_s32(d + i + 12, vreinterpretq_s32_u16(w1.val[1]));
+    }
+#elif defined(AC_SSSE3)
+    /* 每次 4 个样本（12 字节）；加载 16 字节，要求后面至少还有 6 个样本可读 */
+    const __m128i m = _mm_setr_epi8(-1, 0, 1, 2,  -1, 3, 4, 5,
+                                    -1, 6, 7, 8,  -1, 9, 10, 11);
+    for (; i + 6 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + 3 * i));
+        _mm_storeu_si128((__m128i *)(d + i), _mm_shuffle_epi8(v, m));
+    }
+#endif
+    for (; i < n; i++) {
+        const uint8_t *p = s + 3 * i;
+        d[i] = (int32_t)(((uint32_t)p[0] << 8) |
+                         ((uint32_t)p[1] << 16) |
+                         ((uint32_t)p[2] << 24));
+    }
+}
+
+/* ============================================================================
+ * s32 -> 管线格式
+ * ============================================================================ */
+
+#if defined(AC_NEON)
+static inline int32x4_t tpdf_neon(uint32x4_t *st)
+{
+    uint32x4_t x = *st;
+    x = veorq_u32(x, vshlq_n_u32(x, 13));
+    x = veorq_u32(x, vshrq_n_u32(x, 17));
+    x = veorq_u32(x, vshlq_n_u32(x, 5));
+    *st = x;
+    uint32x4_t a = vshrq_n_u32(x, 24);
+    uint32x4_t b = vandq_u32(vshrq_n_u32(x, 16), vdupq_n_u32(0xff));
+    return vsubq_s32(vreinterpretq_s32_u32(vaddq_u32(a, b)), vdupq_n_s32(255));
+}
+#elif defined(AC_SSE2)
+static inline __m128i tpdf_sse2(__m128i *st)
+{
+    __m128i x = *st;
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+    *st = x;
+    __m128i a = _mm_srli_epi32(x, 24);
+    __m128i b = _mm_and_si128(_mm_srli_epi32(x, 16), _mm_set1_epi32(0xff));
+    return _mm_sub_epi32(_mm_add_epi32(a, b), _mm_set1_epi32(255));
+}
+#endif
+
+static void s32_to_s16(AudioConverter *cv, int16_t *d, const int32_t *s, size_t n)
+{
+    size_t i = 0;
+    const int dither = cv->dither;
+#if defined(AC_NEON)
+    uint32x4_t st = vld1q_u32(cv->rng);
+    for (; i + 8 <= n; i += 8) {
+        int32x4_t a = vshrq_n_s32(vld1q_s32(s + i), 8);
+        int32x4_t b = vshrq_n_s32(vld1q_s32(s + i + 4), 8);
+        if (dither) {
+            a = vaddq_s32(a, tpdf_neon(&st));
+            b = vaddq_s32(b, tpdf_neon(&st));
+        }
+        vst1q_s16(d + i, vcombine_s16(vqrshrn_n_s32(a, 8), vqrshrn_n_s32(b, 8)));
+    }
+    vst1q_u32(cv->rng, st);
+#elif defined(AC_SSE2)
+    __m128i st = _mm_loadu_si128((const __m128i *)cv->rng);
+    const __m128i half = _mm_set1_epi32(128);
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)(s + i)), 8);
+        __m128i b = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)(s + i + 4)), 8);
+        if (dither) {
+            a = _mm_add_epi32(a, tpdf_sse2(&st));
+            b = _mm_add_epi32(b, tpdf_sse2(&st));
+        }
+        a = _mm_srai_epi32(_mm_add_epi32(a, half), 8);
+        b = _mm_srai_epi32(_mm_add_epi32(b, half), 8);
+        _mm_storeu_si128((__m128i *)(d + i), _mm_packs_epi32(a, b));
+    }
+    _mm_storeu_si128((__m128i *)cv->rng, st);
+#endif
+    for (; i < n; i++) {
+        int32_t x = s[i] >> 8;
+        if (dither) x += tpdf_scalar(&cv->rng[i & 3]);
+        d[i] = sat16((x + 128) >> 8);
+    }
+}
+
+static void s32_to_f32(float *d, const int32_t *s, size_t n)
+{
+    const float k = 1.0f / 2147483648.0f;
+    size_t i = 0;
+#if defined(AC_NEON)
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(d + i, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(s + i)), k));
+#elif defined(AC_SSE2)
+    const __m128 vk = _mm_set1_ps(k);
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        _mm_storeu_ps(d + i, _mm_mul_ps(_mm_cvtepi32_ps(v), vk));
+    }
+#endif
+    for (; i < n; i++)
+        d[i] = (float)s[i] * k;
+}
+
+/* ============================================================================
+ * f32 -> 管线格式
+ * ============================================================================ */
+
+static void f32_to_s16(AudioConverter *cv, int16_t *d, const float *s, size_t n)
+{
+    size_t i = 0;
+    const int dither = cv->dither;
+    const float dk = 1.0f / 256.0f;    /* TPDF [-255,255] -> 约 ±1 LSB */
+#if defined(AC_NEON)
+    uint32x4_t st = vld1q_u32(cv->rng);
+    const float32x4_t lo = vdupq_n_f32(-1.0f), hi = vdupq_n_f32(1.0f);
+    for (; i + 8 <= n; i += 8) {
+        float32x4_t a = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(s + i), lo), hi), 32767.0f);
+        float32x4_t b = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(s + i + 4), lo), hi), 32767.0f);
+        if (dither) {
+            a = vmlaq_n_f32(a, vcvtq_f32_s32(tpdf_neon(&st)), dk);
+            b = vmlaq_n_f32(b, vcvtq_f32_s32(tpdf_neon(&st)), dk);
+        }
+        vst1q_s16(d + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a)),
+                                      vqmovn_s32(vcvtnq_s32_f32(b))));
+    }
+    vst1q_u32(cv->rng, st);
+#elif defined(AC_SSE2)
+    __m128i st = _mm_loadu_si128((const __m128i *)cv->rng);
+    const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+    const __m128 sc = _mm_set1_ps(32767.0f), vdk = _mm_set1_ps(dk);
+    for (; i + 8 <= n; i += 8) {
+        __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(s + i), lo), hi), sc);
+        __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(s + i + 4), lo), hi), sc);
+        if (dither) {
+            a = _mm_add_ps(a, _mm_mul_ps(_mm_cvtepi32_ps(tpdf_sse2(&st)), vdk));
+            b = _mm_add_ps(b, _mm_mul_ps(_mm_cvtepi32_ps(tpdf_sse2(&st)), vdk));
+        }
+        _mm_storeu_si128((__m128i *)(d + i),
+                         _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    }
+    _mm_storeu_si128((__m128i *)cv->rng, st);
+#endif
+    for (; i < n; i++) {
+        float v = s[i];
+        if (v > 1.0f)  v = 1.0f;
+        if (v < -1.0f) v = -1.0f;
+        v *= 32767.0f;
+        if (dither) v += (float)tpdf_scalar(&cv->rng[i & 3]) * dk;
+        d[i] = sat16((int32_t)lrintf(v));
+    }
+}
+
+static void f32_to_s32(int32_t *d, const float *s, size_t n)
+{
+    const float k = 2147483648.0f;
+    size_t i = 0;
+#if defined(AC_NEON)
+    const float32x4_t lo = vdupq_n_f32(-1.0f), hi = vdupq_n_f32(AC_F32_MAX_BELOW_ONE);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t v = vminq_f32(vmaxq_f32(vld1q_f32(s + i), lo), hi);
+        vst1q_s32(d + i, vcvtnq_s32_f32(vmulq_n_f32(v, k)));
+    }
+#elif defined(AC_SSE2)
+    const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(AC_F32_MAX_BELOW_ONE);
+    const __m128 vk = _mm_set1_ps(k);
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(s + i), lo), hi);
+        _mm_storeu_si128((__m128i *)(d + i), _mm_cvtps_epi32(_mm_mul_ps(v, vk)));
+    }
+#endif
+    for (; i < n; i++) {
+        float v = s[i];
+        if (v > AC_F32_MAX_BELOW_ONE) v = AC_F32_MAX_BELOW_ONE;
+        if (v < -1.0f) v = -1.0f;
+        float x = v * k;
+        d[i] = (int32_t)lrintf(x);
+    }
+}
+
+/* ============================================================================
+ * 对外接口
+ * ============================================================================ */
+
+int audio_converter_init(AudioConverter *cv, AudioRawFmt src,
+                         RkavSampleFmt dst, int dither)
+{
+    if (!cv) return -1;
+    if (audio_raw_fmt_bytes(src) == 0 || rkav_sample_fmt_bytes(dst) == 0)
+        return -1;
+
+    memset(cv, 0, sizeof(*cv));
+    cv->src    = src;
+    cv->dst    = dst;
+    cv->dither = dither;
+
+    /* xorshift 状态不能为 0；4 路取不同种子，避免各 lane 噪声相关 */
+    cv->rng[0] = 0x9e3779b9u;
+    cv->rng[1] = 0x7f4a7c15u;
+    cv->rng[2] = 0x85ebca6bu;
+    cv->rng[3] = 0xc2b2ae35u;
+    return 0;
+}
+
+int audio_converter_is_passthrough(const AudioConverter *cv)
+{
+    if (!cv) return 0;
+    return (cv->src == AUDIO_RAW_S16 && cv->dst == RKAV_SAMPLE_S16) ||
+           (cv->src == AUDIO_RAW_S32 && cv->dst == RKAV_SAMPLE_S32) ||
+           (cv->src == AUDIO_RAW_F32 && cv->dst == RKAV_SAMPLE_F32);
+}
+
+void audio_convert(AudioConverter *cv, void *dst, const void *src, size_t samples)
+{
+    if (!cv || !dst || !src || samples == 0) return;
+
+    const size_t ib = audio_raw_fmt_bytes(cv->src);
+    const size_t ob = rkav_sample_fmt_bytes(cv->dst);
+
+    if (audio_converter_is_passthrough(cv)) {
+        memcpy(dst, src, samples * ob);
+        return;
+    }
+
+    /* FLOAT 输入：直接转换，无需经过 s32 */
+    if (cv->src == AUDIO_RAW_F32) {
+        if (cv->dst == RKAV_SAMPLE_S16)
+            f32_to_s16(cv, (int16_t *)dst, (const float *)src, samples);
+        else
+            f32_to_s32((int32_t *)dst, (const float *)src, samples);
+        return;
+    }
+
+    /* 整数输入：分块规整到 s32，再输出 */
+    int32_t tmp[AC_BLOCK];
+    const uint8_t *sp = (const uint8_t *)src;
+    uint8_t *dp = (uint8_t *)dst;
+
+    while (samples > 0) {
+        size_t n = samples < AC_BLOCK ? samples : AC_BLOCK;
+        const int32_t *s32 = tmp;
+
+        switch (cv->src) {
+        case AUDIO_RAW_S16:   s16_to_s32(tmp, (const int16_t *)sp, n); break;
+        case AUDIO_RAW_S24:   s24_to_s32(tmp, (const int32_t *)sp, n); break;
+        case AUDIO_RAW_S24_3: s24_3_to_s32(tmp, sp, n); break;
+        case AUDIO_RAW_S32:   s32 = (const int32_t *)sp; break;
+        case AUDIO_RAW_F32:   return; /* 已在上面处理 */
+        }
+
+        switch (cv->dst) {
+        case RKAV_SAMPLE_S16: s32_to_s16(cv, (int16_t *)dp, s32, n); break;
+        case RKAV_SAMPLE_S32: memcpy(dp, s32, n * sizeof(int32_t)); break;
+        case RKAV_SAMPLE_F32: s32_to_f32((float *)dp, s32, n); break;
+        }
+
+        sp += n * ib;
+        dp += n * ob;
+        samples -= n;
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ * @file audio_convert.h
+ * @brief PCM 采样格式转换模块头文件
+ *
+ * 将 ALSA 设备的原生采样格式（S16/S24/S24_3/S32/FLOAT）转换为
+ * 管线配置的采样格式（RkavSampleFmt：S16 / S32 / F32）。
+ *
+ * 特性：
+ * - NEON（aarch64）/ SSE2（x86，S24_3 解包额外使用 SSSE3）向量化内核，
+ *   其余情况回退标量实现
+ * - 位宽缩减到 S16 时可选 TPDF 抖动（±1 LSB），避免低电平量化失真
+ * - 同格式直通时为单次 memcpy
+ */
+#pragma once
+
+#include "rkav/types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 设备侧原始采样格式（小端、交错）
+ */
+typedef enum {
+    AUDIO_RAW_S16 = 0,   /**< S16_LE */
+    AUDIO_RAW_S24,       /**< S24_LE：24 bit 放在 4 字节容器的低 3 字节 */
+    AUDIO_RAW_S24_3,     /**< S24_3LE：24 bit 紧凑打包，3 字节/样本 */
+    AUDIO_RAW_S32,       /**< S32_LE */
+    AUDIO_RAW_F32,       /**< FLOAT_LE */
+} AudioRawFmt;
+
+/**
+ * @brief 转换器上下文
+ */
+typedef struct {
+    AudioRawFmt   src;        /**< 输入（设备）格式 */
+    RkavSampleFmt dst;        /**< 输出（管线）格式 */
+    int           dither;     /**< 缩减到 S16 时是否加 TPDF 抖动 */
+    uint32_t      rng[4];     /**< 4 路 xorshift32 状态（与向量宽度一致） */
+} AudioConverter;
+
+/** 设备格式每样本字节数 */
+size_t audio_raw_fmt_bytes(AudioRawFmt f);
+
+/** 设备格式名称（日志用） */
+const char *audio_raw_fmt_name(AudioRawFmt f);
+
+/** 管线格式每样本字节数 */
+size_t rkav_sample_fmt_bytes(RkavSampleFmt f);
+
+/** 管线格式名称（日志用），与 ffmpeg -f 参数一致：s16le/s32le/f32le */
+const char *rkav_sample_fmt_name(RkavSampleFmt f);
+
+/** 当前编译进来的 SIMD 实现名称："neon" / "sse2" / "scalar" */
+const char *audio_convert_simd_name(void);
+
+/**
+ * @brief 初始化转换器
+ *
+ * @param cv     转换器
+ * @param src    设备格式
+ * @param dst    管线格式
+ * @param dither 缩减到 S16 时是否抖动
+ * @return int   0 成功，-1 参数非法
+ */
+int  audio_converter_init(AudioConverter *cv, AudioRawFmt src,
+                          RkavSampleFmt dst, int dither);
+
+/**
+ * @brief 判断转换是否为直通（格式相同，可以直接读入目标缓冲）
+ */
+int  audio_converter_is_passthrough(const AudioConverter *cv);
+
+/**
+ * @brief 转换 samples 个样本（注意是“样本数”=帧数×声道数）
+ *
+ * @param cv      转换器
+ * @param dst     输出缓冲（samples × rkav_sample_fmt_bytes(dst)）
+ * @param src     输入缓冲（samples × audio_raw_fmt_bytes(src)）
+ * @param samples 样本数
+ */
+void audio_convert(AudioConverter *cv, void *dst, const void *src, size_t samples);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,588 @@
+/**
+ * @file audio_mix.c
+ * @brief 多麦克风对齐与混音模块实现
+ *
+ * 每次 audio_mixer_pull 输出一个 period：
+ * 1. 起点对齐（只做一次）：等待所有设备出数（最多 max_wait_us），
+ *    取各路首帧 PTS 的最大值作为输出起点；更早的样本丢弃，更晚的设备先补静音
+ * 2. 按 dev0 出一个 period；次设备数据不够时最多等 max_wait_us，超时补静音（underrun）
+ * 3. 每个设备：FIFO -> 按声道映射重排成输出布局 -> 与累加结果饱和相加
+ * 4. 次设备与 dev0 的实测速率差按 period 累积，满 1 帧时本 period 多读 1 帧（丢弃）
+ *    或少读 1 帧（重复）；采集块粒度使 FIFO 水位呈台阶状，因此水位只作兜底：
+ *    指数平均偏离锁定目标超过一个 period 时才额外滑动
+ *
+ * 输出 PTS = 起点 + 已输出帧数 / 采样率（跟随 dev0 的样本计数，不受次设备影响）。
+ */
+#include "audio_mix.h"
+#include "audio_convert.h"
+#include "log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#  include <arm_neon.h>
+#  define AM_NEON 1
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#  define AM_SSE2 1
+#endif
+
+/** 模块日志标签 */
+#define TAG "mix"
+
+/** 每个设备 FIFO 的容量（period 数） */
+#define MIX_FIFO_PERIODS   8
+
+/** 水位预热：前 N 个 period 只做平均，之后锁定为目标水位 */
+#define MIX_LEVEL_WARMUP   64
+
+/** 水位指数平均系数 */
+#define MIX_LEVEL_ALPHA    0.05
+
+/** 速率估计至少需要的观测时长（微秒） */
+#define MIX_RATE_MIN_US    2000000ULL
+
+/* ============================================================================
+ * 混音内核
+ * ============================================================================ */
+
+void audio_mix_add_s16(int16_t *dst, const int16_t *src, size_t n)
+{
+    size_t i = 0;
+#if defined(AM_NEON)
+    for (; i + 8 <= n; i += 8)
+        vst1q_s16(dst + i, vqaddq_s16(vld1q_s16(dst + i), vld1q_s16(src + i)));
+#elif defined(AM_SSE2)
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_adds_epi16(a, b));
+    }
+#endif
+    for (; i < n; i++) {
+        int32_t v = (int32_t)dst[i] + (int32_t)src[i];
+        if (v >  32767) v =  32767;
+        if (v < -32768) v = -32768;
+        dst[i] = (int16_t)v;
+    }
+}
+
+void audio_mix_add_f32(float *dst, const float *src, size_t n)
+{
+    size_t i = 0;
+#if defined(AM_NEON)
+    const float32x4_t lo = vdupq_n_f32(-1.0f), hi = vdupq_n_f32(1.0f);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t v = vaddq_f32(vld1q_f32(dst + i), vld1q_f32(src + i));
+        vst1q_f32(dst + i, vminq_f32(vmaxq_f32(v, lo), hi));
+    }
+#elif defined(AM_SSE2)
+    const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i));
+        _mm_storeu_ps(dst + i, _mm_min_ps(_mm_max_ps(v, lo), hi));
+    }
+#endif
+    for (; i < n; i++) {
+        float v = dst[i] + src[i];
+        if (v < -1.0f) v = -1.0f;
+        if (v >  1.0f) v =  1.0f;
+        dst[i] = v;
+    }
+}
+
+/* ============================================================================
+ * 声道映射
+ * ============================================================================ */
+
+/*
+ * 默认映射：
+ * - 设备声道数 == 输出声道数：逐声道相加
+ * - 单声道设备且有多个设备：dev d 路由到输出声道 d % out（前/后麦分到 L/R）
+ * - 单设备单声道：复制到所有输出声道
+ * - 其它：out k 取设备声道 k（设备声道不足的输出声道不参与）
+ */
+static void default_map(AudioMixer *m, int d)
+{
+    AudioMixInput *in = &m->in[d];
+    for (int k = 0; k < m->out_channels; k++) {
+        if (in->channels == 1 && m->ndev > 1)
+            in->map[k] = (k == d % m->out_channels) ? 0 : -1;
+        else if (in->channels == 1)
+            in->map[k] = 0;
+        else
+            in->map[k] = k < in->channels ? k : -1;
+    }
+}
+
+/*
+ * 解析 "0:0+1:0,0:1+1:1"：逗号分隔输出声道，加号分隔来源 dev:ch。
+ * 未列出的输出声道静音；同一设备对同一输出声道只能有一个来源。
+ */
+static int parse_map(AudioMixer *m, const char *spec)
+{
+    for (int d = 0; d < m->ndev; d++)
+        for (int k = 0; k < AUDIO_MIX_MAX_CH; k++)
+            m->in[d].map[k] = -1;
+
+    const char *p = spec;
+    int k = 0;
+    while (*p) {
+        if (k >= m->out_channels) {
+            LOGE("[%s] map '%s': more than %d output channels", TAG, spec, m->out_channels);
+            return -1;
+        }
+        for (;;) {
+            char *end = NULL;
+            long d = strtol(p, &end, 10);
+            if (end == p || *end != ':') goto bad;
+            p = end + 1;
+            long c = strtol(p, &end, 10);
+            if (end == p) goto bad;
+            p = end;
+
+            if (d < 0 || d >= m->ndev || c < 0 || c >= m->in[d].channels) {
+                LOGE("[%s] map '%s': dev%ld.ch%ld out of range", TAG, spec, d, c);
+                return -1;
+            }
+            if (m->in[d].map[k] >= 0) {
+                LOGE("[%s] map '%s': out%d uses dev%ld twice", TAG, spec, k, d);
+                return -1;
+            }
+            m->in[d].map[k] = (int)c;
+
+            if (*p == '+') { p++; continue; }
+            break;
+        }
+        if (*p == ',') p++;
+        else if (*p) goto bad;
+        k++;
+    }
+    return 0;
+
+bad:
+    LOGE("[%s] invalid map '%s' (expect e.g. 0:0+1:0,0:1+1:1)", TAG, spec);
+    return -1;
+}
+
+/* ============================================================================
+ * FIFO
+ * ============================================================================ */
+
+static inline size_t in_frame_bytes(const AudioMixer *m, const AudioMixInput *in)
+{
+    return (size_t)in->channels * m->bps;
+}
+
+static inline uint64_t frames_to_us(const AudioMixer *m, uint64_t frames)
+{
+    return frames * 1000000ULL / (uint64_t)m->sample_rate;
+}
+
+static inline uint64_t us_to_frames(const AudioMixer *m, uint64_t us)
+{
+    return us * (uint64_t)m->sample_rate / 1000000ULL;
+}
+
+/* 从 FIFO 头部丢弃 n 帧 */
+static void fifo_drop(AudioMixer *m, AudioMixInput *in, size_t n)
+{
+    if (n > in->count) n = in->count;
+    in->head = (in->head + n) % in->cap_frames;
+    in->count -= n;
+    in->head_pts_us += frames_to_us(m, n);
+}
+
+/* 帧写入 FIFO 尾部；空间不足时先丢最旧的帧 */
+static void fifo_write(AudioMixer *m, AudioMixInput *in, const uint8_t *src, size_t n)
+{
+    size_t fb = in_frame_bytes(m, in);
+
+    if (n > in->cap_frames) {
+        /* 单块比整个 FIFO 还大：只保留最新的部分 */
+        size_t skip = n - in->cap_frames;
+        atomic_fetch_add_explicit(&in->overflow, skip, memory_order_relaxed);
+        src += skip * fb;
+        n = in->cap_frames;
+    }
+    if (in->count + n > in->cap_frames) {
+        size_t over = in->count + n - in->cap_frames;
+        fifo_drop(m, in, over);
+        atomic_fetch_add_explicit(&in->overflow, over, memory_order_relaxed);
+    }
+
+    size_t tail  = (in->head + in->count) % in->cap_frames;
+    size_t first = in->cap_frames - tail;
+    if (first > n) first = n;
+    memcpy(in->fifo + tail * fb, src, first * fb);
+    if (n > first) memcpy(in->fifo, src + first * fb, (n - first) * fb);
+    in->count += n;
+}
+
+/*
+ * 把第 d 个设备的 nsrc 帧（FIFO 头部）重排成 out_frames 帧输出布局写入 dst：
+ * - 先输出 lead_silence 帧静音（起点对齐）
+ * - nsrc == want + 1：跳过中间 1 帧（丢弃）；nsrc == want - 1：中间 1 帧重复
+ * - 数据不足的尾部补静音
+ * 返回实际消耗的 FIFO 帧数。
+ */
+static size_t gather(AudioMixer *m, AudioMixInput *in, uint8_t *dst,
+                     size_t out_frames, int slip)
+{
+    const size_t bps = m->bps;
+    const size_t ofb = (size_t)m->out_channels * bps;
+    const size_t ifb = in_frame_bytes(m, in);
+
+    size_t lead = in->lead_silence < out_frames ? in->lead_silence : out_frames;
+    if (lead) {
+        memset(dst, 0, lead * ofb);
+        in->lead_silence -= lead;
+        dst += lead * ofb;
+        out_frames -= lead;
+        slip = 0;
+    }
+    if (!out_frames) return 0;
+
+    size_t want = slip > 0 ? out_frames + 1 : (slip < 0 ? out_frames - 1 : out_frames);
+    size_t nsrc = want < in->count ? want : in->count;
+    if (nsrc < want) slip = 0;              /* 数据不足时不做滑动，直接补静音 */
+    size_t ncopy = slip > 0 ? nsrc - 1 : (slip < 0 ? nsrc + 1 : nsrc);
+    if (ncopy > out_frames) ncopy = out_frames;
+    size_t mid = out_frames / 2;
+
+    if (in->identity && slip == 0) {
+        size_t first = in->cap_frames - in->head;
+        if (first > ncopy) first = ncopy;
+        memcpy(dst, in->fifo + in->head * ifb, first * ifb);
+        if (ncopy > first) memcpy(dst + first * ifb, in->fifo, (ncopy - first) * ifb);
+    } else {
+        for (size_t j = 0; j < ncopy; j++) {
+            size_t s = j;
+            if (slip > 0 && j >= mid) s = j + 1;
+            else if (slip < 0 && j > mid) s = j - 1;
+            const uint8_t *sf = in->fifo + ((in->head + s) % in->cap_frames) * ifb;
+            uint8_t *df = dst + j * ofb;
+            for (int k = 0; k < m->out_channels; k++) {
+                int c = in->map[k];
+                if (c >= 0) memcpy(df + (size_t)k * bps, sf + (size_t)c * bps, bps);
+                else        memset(df + (size_t)k * bps, 0, bps);
+            }
+        }
+    }
+    if (ncopy < out_frames)
+        memset(dst + ncopy * ofb, 0, (out_frames - ncopy) * ofb);
+
+    fifo_drop(m, in, nsrc);
+    return nsrc;
+}
+
+/*
+ * 起点对齐：把输入的第一帧对到输出时间线上的 target_pts。
+ */
+static void align_input(AudioMixer *m, int d, uint64_t target_pts)
+{
+    AudioMixInput *in = &m->in[d];
+    if (in->head_pts_us < target_pts) {
+        fifo_drop(m, in, (size_t)us_to_frames(m, target_pts - in->head_pts_us));
+    } else if (in->head_pts_us > target_pts) {
+        in->lead_silence = (size_t)us_to_frames(m, in->head_pts_us - target_pts);
+    }
+    in->aligned = 1;
+    LOGI("[%s] dev%d aligned: first_pts=%llu target=%llu lead_silence=%zu",
+         TAG, d, (unsigned long long)in->head_pts_us,
+         (unsigned long long)target_pts, in->lead_silence);
+}
+
+/* ============================================================================
+ * 公共接口
+ * ============================================================================ */
+
+int audio_mixer_init(AudioMixer *m, int ndev, const int *dev_channels,
+                     int out_channels, int sample_rate, RkavSampleFmt fmt,
+                     uint32_t period_frames, const char *map_spec)
+{
+    if (!m || !dev_channels || ndev < 1 || ndev > AUDIO_MIX_MAX_DEVS ||
+        out_channels < 1 || out_channels > AUDIO_MIX_MAX_CH ||
+        sample_rate <= 0 || period_frames == 0)
+        return -1;
+    if (fmt != RKAV_SAMPLE_S16 && fmt != RKAV_SAMPLE_F32) {
+        LOGE("[%s] unsupported sample format %s (use s16 or f32)", TAG,
+             rkav_sample_fmt_name(fmt));
+        return -1;
+    }
+
+    memset(m, 0, sizeof(*m));
+    m->fmt           = fmt;
+    m->sample_rate   = sample_rate;
+    m->out_channels  = out_channels;
+    m->period_frames = period_frames;
+    m->bps           = rkav_sample_fmt_bytes(fmt);
+    m->ndev          = ndev;
+    /* 次设备最长等待：2 个 period */
+    m->max_wait_us   = frames_to_us(m, 2ULL * period_frames);
+
+    for (int d = 0; d < ndev; d++) {
+        AudioMixInput *in = &m->in[d];
+        if (dev_channels[d] < 1 || dev_channels[d] > AUDIO_MIX_MAX_CH) {
+            LOGE("[%s] dev%d: invalid channel count %d", TAG, d, dev_channels[d]);
+            goto fail;
+        }
+        in->channels   = dev_channels[d];
+        in->cap_frames = (size_t)period_frames * MIX_FIFO_PERIODS;
+        in->fifo       = (uint8_t *)malloc(in->cap_frames * in_frame_bytes(m, in));
+        if (!in->fifo) goto fail;
+    }
+
+    if (map_spec && *map_spec) {
+        if (parse_map(m, map_spec) != 0) goto fail;
+    } else {
+        for (int d = 0; d < ndev; d++) default_map(m, d);
+    }
+
+    for (int d = 0; d < ndev; d++) {
+        AudioMixInput *in = &m->in[d];
+        in->identity = (in->channels == out_channels);
+        for (int k = 0; k < out_channels && in->identity; k++)
+            if (in->map[k] != k) in->identity = 0;
+
+        char desc[64];
+        int off = 0;
+        for (int k = 0; k < out_channels && off < (int)sizeof(desc) - 4; k++)
+            off += snprintf(desc + off, sizeof(desc) - (size_t)off, "%s%d",
+                            k ? "," : "", in->map[k]);
+        LOGI("[%s] dev%d: %d ch, map out<-ch [%s]%s", TAG, d, in->channels, desc,
+             in->identity ? " (identity)" : "");
+    }
+
+    m->tmp = (uint8_t *)malloc((size_t)period_frames * (size_t)out_channels * m->bps);
+    if (!m->tmp) goto fail;
+
+    LOGI("[%s] %d devs -> %d ch %s @ %d Hz, period=%u frames (simd=%s)", TAG,
+         ndev, out_channels, rkav_sample_fmt_name(fmt), sample_rate, period_frames,
+#if defined(AM_NEON)
+         "neon"
+#elif defined(AM_SSE2)
+         "sse2"
+#else
+         "scalar"
+#endif
+         );
+    return 0;
+
+fail:
+    audio_mixer_deinit(m);
+    return -1;
+}
+
+int audio_mixer_feed(AudioMixer *m, int dev, const AudioChunk *chunk, uint64_t now_us)
+{
+    if (!m || !chunk || dev < 0 || dev >= m->ndev) return -1;
+    AudioMixInput *in = &m->in[dev];
+
+    if (chunk->channels != in->channels || chunk->sample_fmt != m->fmt ||
+        chunk->sample_rate != m->sample_rate) {
+        LOGE("[%s] dev%d: chunk format mismatch (%d ch %s %d Hz)", TAG, dev,
+             chunk->channels, rkav_sample_fmt_name(chunk->sample_fmt), chunk->sample_rate);
+        return -1;
+    }
+    if (chunk->frames == 0) return 0;
+
+    if (!in->started) {
+        in->started       = 1;
+        in->first_feed_us = now_us;
+    }
+    /* FIFO 为空时以本块 PTS 为准，否则认为样本连续 */
+    if (in->count == 0) in->head_pts_us = chunk->pts_us;
+
+    fifo_write(m, in, chunk->data, chunk->frames);
+    in->last_feed_us = now_us;
+    return 0;
+}
+
+/*
+ * 次设备漂移补偿：决定本 period 的滑动方向。
+ * - 前馈：(ppm_dev - ppm_dev0) × period 累积，满 ±1 帧滑动一次
+ * - 兜底：水位指数平均偏离目标超过一个 period（前馈估计误差累积）
+ * @return +1 多读 1 帧（设备偏快），-1 少读 1 帧（设备偏慢），0 不滑动
+ */
+static int slip_decision(AudioMixer *m, AudioMixInput *in)
+{
+    AudioMixInput *master = &m->in[0];
+    if (atomic_load_explicit(&in->rate_valid, memory_order_acquire) &&
+        atomic_load_explicit(&master->rate_valid, memory_order_acquire)) {
+        int64_t d10 = (int64_t)atomic_load_explicit(&in->rate_ppm_x10, memory_order_relaxed) -
+                      (int64_t)atomic_load_explicit(&master->rate_ppm_x10, memory_order_relaxed);
+        in->slip_acc += (double)d10 * 1e-7 * (double)m->period_frames;
+    }
+
+    double level = (double)(in->count + in->lead_silence);
+    if (in->level_samples == 0) in->level_avg = level;
+    else in->level_avg += MIX_LEVEL_ALPHA * (level - in->level_avg);
+    in->level_samples++;
+
+    if (in->level_samples < MIX_LEVEL_WARMUP) return 0;
+    if (in->level_samples == MIX_LEVEL_WARMUP) {
+        in->level_target = in->level_avg;
+        return 0;
+    }
+
+    double band = (double)m->period_frames;
+    if (in->level_avg > in->level_target + band) {
+        in->level_avg -= 1.0;
+        return 1;
+    }
+    if (in->level_avg < in->level_target - band) {
+        in->level_avg += 1.0;
+        return -1;
+    }
+    if (in->slip_acc >= 1.0)  { in->slip_acc -= 1.0; return 1; }
+    if (in->slip_acc <= -1.0) { in->slip_acc += 1.0; return -1; }
+    return 0;
+}
+
+int audio_mixer_pull(AudioMixer *m, uint64_t now_us, AudioChunk **out)
+{
+    if (!m || !out) return -1;
+    *out = NULL;
+
+    const uint32_t F = m->period_frames;
+    AudioMixInput *master = &m->in[0];
+
+    /* 1) 全局起点对齐 */
+    if (!m->started) {
+        if (!master->started) return 0;
+        for (int d = 1; d < m->ndev; d++) {
+            if (!m->in[d].started && now_us < master->first_feed_us + m->max_wait_us)
+                return 0;
+        }
+        uint64_t start = 0;
+        for (int d = 0; d < m->ndev; d++) {
+            if (m->in[d].started && m->in[d].head_pts_us > start)
+                start = m->in[d].head_pts_us;
+        }
+        m->start_pts_us = start;
+        m->started = 1;
+    }
+    uint64_t out_pts = m->start_pts_us + frames_to_us(m, m->out_frames);
+    for (int d = 0; d < m->ndev; d++) {
+        if (m->in[d].started && !m->in[d].aligned) align_input(m, d, out_pts);
+    }
+
+    /* 2) 主设备够一个 period 才输出；次设备最多等 max_wait_us */
+    if (master->count + master->lead_silence < F) return 0;
+    for (int d = 1; d < m->ndev; d++) {
+        AudioMixInput *in = &m->in[d];
+        if (!in->started) continue;
+        if (in->count + in->lead_silence < F && now_us < in->last_feed_us + m->max_wait_us)
+            return 0;
+    }
+
+    const size_t samples = (size_t)F * (size_t)m->out_channels;
+    const size_t bytes   = samples * m->bps;
+
+    AudioChunk *c = (AudioChunk *)calloc(1, sizeof(AudioChunk));
+    if (!c) return -1;
+    c->data = (uint8_t *)malloc(bytes);
+    if (!c->data) { free(c); return -1; }
+
+    /* 3) dev0 直接重排到输出缓冲，其余设备经 tmp 混入 */
+    gather(m, master, c->data, F, 0);
+    for (int d = 1; d < m->ndev; d++) {
+        AudioMixInput *in = &m->in[d];
+        if (!in->started) continue;
+
+        if (in->count + in->lead_silence < F)
+            atomic_fetch_add_explicit(&in->underrun, 1, memory_order_relaxed);
+
+        int slip = slip_decision(m, in);
+        if (slip > 0 && in->count >= (size_t)F + 1)
+            atomic_fetch_add_explicit(&in->slip_drop, 1, memory_order_relaxed);
+        else if (slip < 0 && in->count >= (size_t)F - 1)
+            atomic_fetch_add_explicit(&in->slip_dup, 1, memory_order_relaxed);
+        else
+            slip = 0;
+
+        gather(m, in, m->tmp, F, slip);
+        if (m->fmt == RKAV_SAMPLE_S16)
+            audio_mix_add_s16((int16_t *)c->data, (const int16_t *)m->tmp, samples);
+        else
+            audio_mix_add_f32((float *)c->data, (const float *)m->tmp, samples);
+    }
+
+    c->bytes            = bytes;
+    c->sample_rate      = m->sample_rate;
+    c->channels         = m->out_channels;
+    c->bytes_per_sample = (int)m->bps;
+    c->sample_fmt       = m->fmt;
+    c->frames           = F;
+    c->pts_us           = out_pts;
+    m->out_frames      += F;
+
+    *out = c;
+    return 1;
+}
+
+void audio_mixer_note_capture(AudioMixer *m, int dev, uint32_t frames,
+                              uint64_t xrun_total, uint64_t now_us)
+{
+    if (!m || dev < 0 || dev >= AUDIO_MIX_MAX_DEVS) return;
+    AudioMixInput *in = &m->in[dev];
+
+    atomic_store_explicit(&in->xruns, xrun_total, memory_order_relaxed);
+    if (!frames) return;
+
+    /* 实测速率：首块之后的帧数 / 首块之后的时长（首块本身的读取时长未知，不计入） */
+    if (!in->cap_t0_us) {
+        in->cap_t0_us = now_us;
+        return;
+    }
+    in->cap_read_frames += frames;
+
+    uint64_t elapsed = now_us - in->cap_t0_us;
+    if (elapsed >= MIX_RATE_MIN_US) {
+        double rate = (double)in->cap_read_frames * 1e6 / (double)elapsed;
+        double ppm  = (rate / (double)m->sample_rate - 1.0) * 1e6;
+        atomic_store_explicit(&in->rate_ppm_x10, (int_fast64_t)(ppm * 10.0),
+                              memory_order_relaxed);
+        atomic_store_explicit(&in->rate_valid, 1, memory_order_release);
+    }
+}
+
+/*
+ * 每秒打印：
+ * [MIX] devN rate=<实测偏差>ppm level=<水位> slip=+<重复>/-<丢弃> underrun=.. overflow=.. xrun=..
+ */
+void audio_mixer_tick_print(AudioMixer *m)
+{
+    if (!m || m->ndev == 0) return;
+
+    for (int d = 0; d < m->ndev; d++) {
+        AudioMixInput *in = &m->in[d];
+        int64_t  ppm10 = (int64_t)atomic_load_explicit(&in->rate_ppm_x10, memory_order_relaxed);
+        uint64_t dup   = atomic_exchange(&in->slip_dup, 0);
+        uint64_t drop  = atomic_exchange(&in->slip_drop, 0);
+        uint64_t under = atomic_exchange(&in->underrun, 0);
+        uint64_t over  = atomic_exchange(&in->overflow, 0);
+        uint64_t xr    = atomic_load_explicit(&in->xruns, memory_order_relaxed);
+
+        LOGI("[MIX] dev%d rate=%+.1fppm slip=+%llu/-%llu underrun=%llu overflow=%llu xrun=%llu",
+             d, (double)ppm10 / 10.0,
+             (unsigned long long)dup, (unsigned long long)drop,
+             (unsigned long long)under, (unsigned long long)over,
+             (unsigned long long)xr);
+    }
+}
+
+void audio_mixer_deinit(AudioMixer *m)
+{
+    if (!m) return;
+    for (int d = 0; d < AUDIO_MIX_MAX_DEVS; d++) {
+        free(m->in[d].fifo);
+        m->in[d].fifo = NULL;
+    }
+    free(m->tmp);
+    m->tmp  = NULL;
+    m->ndev = 0;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file audio_mix.h
+ * @brief 多麦克风对齐与混音模块头文件
+ *
+ * 把多个采集设备（例如前/后两路麦克风各一块 ALSA 设备）的 AudioChunk
+ * 合并成一条交错 PCM 音轨。
+ *
+ * 特性：
+ * - 对齐：启动时按 PTS 丢弃/补静音使各路起点一致，之后按样本数推进
+ * - 声道映射：每个输出声道 = 各设备某一声道之和（路由 = 只有一个来源的映射）
+ * - 混音：S16 饱和加（NEON vqaddq_s16 / SSE2 _mm_adds_epi16），F32 相加后限幅
+ * - 漂移补偿：以 dev0 为主时钟，按实测速率差均匀地丢弃/重复单帧（sample slip），
+ *   FIFO 水位偏离目标超过一个 period 时再额外纠偏；每 period 最多 1 帧，可补偿约 1/period_frames 的偏差
+ * - 统计：每设备实测速率（ppm）、slip 次数、欠载补静音、xrun
+ *
+ * 线程模型：由单个混音线程调用 feed/pull；统计字段为原子量，stats 线程读取。
+ */
+#pragma once
+
+#include "rkav/types.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 最大输入设备数 */
+#define AUDIO_MIX_MAX_DEVS  4
+
+/** 最大声道数（输入/输出） */
+#define AUDIO_MIX_MAX_CH    8
+
+/**
+ * @brief 单个输入设备的状态
+ */
+typedef struct {
+    int       channels;         /**< 该设备声道数 */
+    int       map[AUDIO_MIX_MAX_CH]; /**< 输出声道 k 取该设备的哪一声道，-1 表示不参与 */
+    int       identity;         /**< 映射是否为恒等（可跳过重排） */
+
+    uint8_t  *fifo;             /**< 环形缓冲（按帧，设备交错格式） */
+    size_t    cap_frames;       /**< 环形缓冲容量（帧） */
+    size_t    head;             /**< 读位置（帧） */
+    size_t    count;            /**< 当前帧数 */
+    uint64_t  head_pts_us;      /**< FIFO 第一帧的 PTS */
+    size_t    lead_silence;     /**< 起点对齐需要先补的静音帧数 */
+    int       started;          /**< 是否收到过数据 */
+    int       aligned;          /**< 是否已完成起点对齐 */
+
+    uint64_t  first_feed_us;    /**< 首次 feed 的墙钟时间 */
+    uint64_t  last_feed_us;     /**< 最近一次 feed 的墙钟时间 */
+    double    level_avg;        /**< FIFO 水位（帧）的指数平均 */
+    double    level_target;     /**< 目标水位（对齐稳定后锁定） */
+    uint64_t  level_samples;    /**< 水位采样次数 */
+    double    slip_acc;         /**< 按速率差累积的待滑动帧数（满 ±1 执行一次） */
+
+    /* 速率估计（仅由该设备的采集线程写，见 audio_mixer_note_capture） */
+    uint64_t  cap_t0_us;        /**< 首次读完成时刻 */
+    uint64_t  cap_read_frames;  /**< 首次之后累计读到的帧数 */
+
+    /* 统计（原子，stats 线程读取） */
+    atomic_int_fast64_t  rate_ppm_x10;  /**< 实测速率相对标称的偏差（0.1 ppm） */
+    atomic_int           rate_valid;    /**< 速率估计是否已有足够观测时长 */
+    atomic_uint_fast64_t slip_drop;     /**< 为追赶而丢弃的帧数（设备偏快） */
+    atomic_uint_fast64_t slip_dup;      /**< 为补齐而重复的帧数（设备偏慢） */
+    atomic_uint_fast64_t underrun;      /**< 数据不足、补静音的 period 数 */
+    atomic_uint_fast64_t overflow;      /**< FIFO 溢出丢弃的帧数 */
+    atomic_uint_fast64_t xruns;         /**< 采集端上报的 overrun 次数 */
+} AudioMixInput;
+
+/**
+ * @brief 混音器上下文
+ */
+typedef struct {
+    RkavSampleFmt fmt;              /**< 采样格式（S16 或 F32） */
+    int           sample_rate;      /**< 采样率 */
+    int           out_channels;     /**< 输出声道数 */
+    uint32_t      period_frames;    /**< 每次输出的帧数 */
+    uint64_t      max_wait_us;      /**< 次设备数据不足时最长等待 */
+    size_t        bps;              /**< 每样本字节数 */
+
+    int           ndev;             /**< 输入设备数 */
+    AudioMixInput in[AUDIO_MIX_MAX_DEVS];
+
+    uint8_t      *tmp;              /**< 次设备重排缓冲（一个 period，混音前） */
+
+    uint64_t      start_pts_us;     /**< 输出时间线起点 */
+    uint64_t      out_frames;       /**< 已输出帧数（PTS = 起点 + 帧数 / 采样率） */
+    int           started;          /**< 是否已完成全局起点对齐 */
+} AudioMixer;
+
+/**
+ * @brief 初始化混音器
+ *
+ * @param m             混音器
+ * @param ndev          输入设备数（1..AUDIO_MIX_MAX_DEVS）
+ * @param dev_channels  每个设备的声道数
+ * @param out_channels  输出声道数
+ * @param sample_rate   采样率（所有设备一致）
+ * @param fmt           采样格式（仅支持 RKAV_SAMPLE_S16 / RKAV_SAMPLE_F32）
+ * @param period_frames 每个输出块的帧数
+ * @param map_spec      声道映射，NULL/空串使用默认映射；
+ *                      语法："0:0+1:0,0:1+1:1" 表示 out0 = dev0.ch0 + dev1.ch0，out1 = dev0.ch1 + dev1.ch1
+ * @return int          0 成功，-1 失败
+ */
+int  audio_mixer_init(AudioMixer *m, int ndev, const int *dev_channels,
+                      int out_channels, int sample_rate, RkavSampleFmt fmt,
+                      uint32_t period_frames, const char *map_spec);
+
+/**
+ * @brief 投递某个设备的一块音频（样本被拷入内部 FIFO，chunk 仍归调用者）
+ *
+ * @param m      混音器
+ * @param dev    设备序号
+ * @param chunk  音频块（格式须与混音器一致）
+ * @param now_us 当前墙钟（monotonic）
+ * @return int   0 成功，-1 失败
+ */
+int  audio_mixer_feed(AudioMixer *m, int dev, const AudioChunk *chunk, uint64_t now_us);
+
+/**
+ * @brief 尝试输出一个混音块
+ *
+ * 主设备（dev0）数据够一个 period 时输出；次设备数据不足时最多等待 max_wait_us，
+ * 超时则该设备本块补静音。
+ *
+ * @param m      混音器
+ * @param now_us 当前墙钟（monotonic）
+ * @param out    输出：新分配的 AudioChunk（调用者释放 data 与结构体）
+ * @return int   1 有输出，0 暂无输出，-1 失败
+ */
+int  audio_mixer_pull(AudioMixer *m, uint64_t now_us, AudioChunk **out);
+
+/**
+ * @brief 采集线程每读完一块调用一次：上报读到的帧数与 xrun 累计值
+ *
+ * 读完成时刻比混音线程取到数据的时刻精确得多，实测速率（ppm）以此估计。
+ * 每个设备只能由一个采集线程调用。
+ *
+ * @param m          混音器
+ * @param dev        设备序号
+ * @param frames     本次读到的帧数（出错时为 0）
+ * @param xrun_total 该设备累计 xrun 次数
+ * @param now_us     读完成时刻（monotonic）
+ */
+void audio_mixer_note_capture(AudioMixer *m, int dev, uint32_t frames,
+                              uint64_t xrun_total, uint64_t now_us);
+
+/**
+ * @brief 打印每设备统计（每秒调用一次；slip/underrun 为窗口值，速率为累计估计）
+ */
+void audio_mixer_tick_print(AudioMixer *m);
+
+/**
+ * @brief 释放混音器内部缓冲
+ */
+void audio_mixer_deinit(AudioMixer *m);
+
+/**
+ * @brief 饱和混音内核：dst[i] = sat(dst[i] + src[i])，共 n 个样本
+ */
+void audio_mix_add_s16(int16_t *dst, const int16_t *src, size_t n);
+
+/**
+ * @brief F32 混音内核：dst[i] = clamp(dst[i] + src[i], -1, 1)，共 n 个样本
+ */
+void audio_mix_add_f32(float *dst, const float *src, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
@@ -10,6 +10,10 @@
  */
 #include "av_stats.h"
 #include "log.h"
+#include "crc32c.h"
+#include "aes256.h"
+
+#include <stdio.h>
 
 /*
  * 初始化统计结构体：将各计数器清零。
@@ -25,6 +29,31 @@ void av_stats_init(AvStats *s)
     atomic_store(&s->enc_bytes, 0);
     atomic_store(&s->audio_chunks, 0);
     atomic_store(&s->drop_count, 0);
+    atomic_store(&s->crc_count, 0);
+    atomic_store(&s->crc_bytes, 0);
+    atomic_store(&s->crc_ns, 0);
+    atomic_store(&s->crc_errors, 0);
+    for (int i = 0; i < AV_STATS_MAX_TLAYERS; i++) {
+        atomic_store(&s->tl_frames[i], 0);
+        atomic_store(&s->tl_shed[i], 0);
+    }
+    atomic_store(&s->lat_frames, 0);
+    atomic_store(&s->lat_enc_us, 0);
+    atomic_store(&s->lat_first_us, 0);
+    atomic_store(&s->lat_frame_us, 0);
+    atomic_store(&s->lat_frame_max, 0);
+    atomic_store(&s->cap_frames, 0);
+    atomic_store(&s->cap_bytes, 0);
+    atomic_store(&s->cap_ns, 0);
+    atomic_store(&s->cfr_repeat, 0);
+    atomic_store(&s->cfr_drop, 0);
+    atomic_store(&s->aes_bytes, 0);
+    atomic_store(&s->aes_ns, 0);
+    atomic_store(&s->xrun_count, 0);
+    atomic_store(&s->xrun_lost_us, 0);
+    atomic_store(&s->xrun_fill_us, 0);
+    atomic_store(&s->xrun_total, 0);
+    atomic_store(&s->xrun_total_us, 0);
 }
 
 /*
@@ -61,4 +90,84 @@ void av_stats_tick_print(AvStats *s)
          (unsigned long long)kbps,
          (unsigned long long)achk,
          (unsigned long long)drops);
+
+    /* CRC32C 每包开销：平均纳秒/包与吞吐（有计算时才打印） */
+    uint64_t ccnt  = atomic_exchange(&s->crc_count, 0);
+    uint64_t cbyte = atomic_exchange(&s->crc_bytes, 0);
+    uint64_t cns   = atomic_exchange(&s->crc_ns, 0);
+    uint64_t cerr  = atomic_exchange(&s->crc_errors, 0);
+    if (ccnt) {
+        LOGI("[CRC] impl=%s n=%llu avg=%lluns/pkt %.0fMB/s prewrite_err=%llu",
+             crc32c_impl_name(), (unsigned long long)ccnt,
+             (unsigned long long)(cns / ccnt),
+             cns ? (double)cbyte * 1000.0 / (double)cns : 0.0,
+             (unsigned long long)cerr);
+    }
+
+    /* 时间分层：各层实际送达帧率与丢弃数（只有分层编码时才会出现 L1 以上） */
+    uint64_t tf[AV_STATS_MAX_TLAYERS], ts[AV_STATS_MAX_TLAYERS];
+    int top = -1;
+    for (int i = 0; i < AV_STATS_MAX_TLAYERS; i++) {
+        tf[i] = atomic_exchange(&s->tl_frames[i], 0);
+        ts[i] = atomic_exchange(&s->tl_shed[i], 0);
+        if (i > 0 && (tf[i] || ts[i])) top = i;
+    }
+    if (top > 0) {
+        char line[160];
+        int off = 0;
+        for (int i = 0; i <= top && off < (int)sizeof(line); i++)
+            off += snprintf(line + off, sizeof(line) - (size_t)off, " L%d=%llu/-%llu",
+                            i, (unsigned long long)tf[i], (unsigned long long)ts[i]);
+        LOGI("[SVC] fps(sent/-shed)%s", line);
+    }
+
+    /* 分段延迟（均值，毫秒）：采集 -> 编出首片 -> 首片写出 -> 整帧写出 */
+    uint64_t ln = atomic_exchange(&s->lat_frames, 0);
+    uint64_t le = atomic_exchange(&s->lat_enc_us, 0);
+    uint64_t lf = atomic_exchange(&s->lat_first_us, 0);
+    uint64_t lw = atomic_exchange(&s->lat_frame_us, 0);
+    uint64_t lm = atomic_exchange(&s->lat_frame_max, 0);
+    if (ln) {
+        LOGI("[LAT] n=%llu enc_first=%.2fms out_first=%.2fms out_frame=%.2fms max=%.2fms",
+             (unsigned long long)ln, (double)le / (double)ln / 1000.0,
+             (double)lf / (double)ln / 1000.0, (double)lw / (double)ln / 1000.0,
+             (double)lm / 1000.0);
+    }
+
+    /* 采集合帧拷贝：驱动映射为非缓存时这里是采集线程的主要开销 */
+    uint64_t cn = atomic_exchange(&s->cap_frames, 0);
+    uint64_t cb = atomic_exchange(&s->cap_bytes, 0);
+    uint64_t cs = atomic_exchange(&s->cap_ns, 0);
+    if (cn && cs) {
+        LOGI("[CAP] copy=%.2fms/frame %.0fMB/s",
+             (double)cs / (double)cn / 1e6, (double)cb * 1e3 / (double)cs);
+    }
+
+    /* CFR：补帧（采集慢 / 丢帧）与丢帧（采集快）分开计数，只在有修正时输出 */
+    uint64_t fr = atomic_exchange(&s->cfr_repeat, 0);
+    uint64_t fd = atomic_exchange(&s->cfr_drop, 0);
+    if (fr || fd) {
+        LOGI("[CFR] repeat=%llu drop=%llu", (unsigned long long)fr, (unsigned long long)fd);
+    }
+
+    /* 落盘加密：吞吐、占单核比例与每 Mbit 的 CPU 开销（码率无关的成本指标） */
+    uint64_t ab = atomic_exchange(&s->aes_bytes, 0);
+    uint64_t an = atomic_exchange(&s->aes_ns, 0);
+    if (ab) {
+        LOGI("[AES] impl=%s %.2fMbit/s cpu=%.3f%% %.1fus/Mbit %.0fMB/s",
+             aes256_impl_name(), (double)ab * 8.0 / 1e6, (double)an / 1e7,
+             (double)an / 1000.0 / ((double)ab * 8.0 / 1e6),
+             an ? (double)ab * 1000.0 / (double)an : 0.0);
+    }
+
+    /* 音频 overrun：本秒次数、丢失时长（补静音 / PTS 跳过）与累计，只在发生时输出 */
+    uint64_t xn = atomic_exchange(&s->xrun_count, 0);
+    uint64_t xl = atomic_exchange(&s->xrun_lost_us, 0);
+    uint64_t xf = atomic_exchange(&s->xrun_fill_us, 0);
+    if (xn) {
+        LOGW("[XRUN] audio overruns=%llu lost=%.1fms fill=%.1fms skip=%.1fms | total=%llu %.1fms",
+             (unsigned long long)xn, (double)xl / 1000.0, (double)xf / 1000.0,
+             (double)(xl - xf) / 1000.0, (unsigned long long)atomic_load(&s->xrun_total),
+             (double)atomic_load(&s->xrun_total_us) / 1000.0);
+    }
 }
@@ -19,6 +19,9 @@
 extern "C" {
 #endif
 
+/** 统计的最大时间层数（与 ENC_MAX_TEMPORAL_LAYERS 一致） */
+#define AV_STATS_MAX_TLAYERS  4
+
 /**
  * @brief 音视频统计结构体
  * 
@@ -30,6 +33,29 @@ typedef struct {
     atomic_uint_fast64_t enc_bytes;     /**< 过去 1 秒编码输出的字节数 */
     atomic_uint_fast64_t audio_chunks;  /**< 过去 1 秒写入的音频块数 */
     atomic_uint_fast64_t drop_count;    /**< 过去 1 秒检测到的丢帧/异常次数 */
+    atomic_uint_fast64_t crc_count;     /**< 过去 1 秒计算 CRC32C 的包/块数 */
+    atomic_uint_fast64_t crc_bytes;     /**< 过去 1 秒参与 CRC32C 的字节数 */
+    atomic_uint_fast64_t crc_ns;        /**< 过去 1 秒 CRC32C 耗时（纳秒） */
+    atomic_uint_fast64_t crc_errors;    /**< 过去 1 秒写盘前复核 CRC 不一致的次数 */
+    atomic_uint_fast64_t tl_frames[AV_STATS_MAX_TLAYERS]; /**< 过去 1 秒各时间层进入 H264 队列的帧数 */
+    atomic_uint_fast64_t tl_shed[AV_STATS_MAX_TLAYERS];   /**< 过去 1 秒各时间层因拥塞被丢弃的帧数 */
+    atomic_uint_fast64_t lat_frames;    /**< 过去 1 秒写出的完整帧数（延迟样本数） */
+    atomic_uint_fast64_t lat_enc_us;    /**< Σ 采集 -> 编码器吐出首片 */
+    atomic_uint_fast64_t lat_first_us;  /**< Σ 采集 -> 首片写出 */
+    atomic_uint_fast64_t lat_frame_us;  /**< Σ 采集 -> 整帧写出 */
+    atomic_uint_fast64_t lat_frame_max; /**< 采集 -> 整帧写出的最大值 */
+    atomic_uint_fast64_t cap_frames;    /**< 过去 1 秒采集合帧次数 */
+    atomic_uint_fast64_t cap_bytes;     /**< 过去 1 秒合帧拷贝的字节数 */
+    atomic_uint_fast64_t cap_ns;        /**< 过去 1 秒合帧耗时（纳秒，含 dma-buf 同步） */
+    atomic_uint_fast64_t cfr_repeat;    /**< 过去 1 秒 CFR 重复上一帧填补的槽位数 */
+    atomic_uint_fast64_t cfr_drop;      /**< 过去 1 秒 CFR 因槽位已占用丢弃的帧数 */
+    atomic_uint_fast64_t aes_bytes;     /**< 过去 1 秒落盘加密的字节数 */
+    atomic_uint_fast64_t aes_ns;        /**< 过去 1 秒落盘加密耗时（纳秒） */
+    atomic_uint_fast64_t xrun_count;    /**< 过去 1 秒音频采集 overrun 次数 */
+    atomic_uint_fast64_t xrun_lost_us;  /**< 过去 1 秒 overrun 丢失的音频时长 */
+    atomic_uint_fast64_t xrun_fill_us;  /**< 过去 1 秒补入的静音时长 */
+    atomic_uint_fast64_t xrun_total;    /**< 累计 overrun 次数（不清零） */
+    atomic_uint_fast64_t xrun_total_us; /**< 累计丢失时长（不清零） */
 } AvStats;
 
 /**
@@ -93,6 +119,114 @@ static inline void av_stats_add_drop(AvStats *s, uint64_t n) {
     atomic_fetch_add_explicit(&s->drop_count, n, memory_order_relaxed);
 }
 
+/**
+ * @brief 累加一次 CRC32C 计算的字节数与耗时
+ * 
+ * @param s     统计对象指针
+ * @param bytes 参与计算的字节数
+ * @param ns    耗时（纳秒）
+ */
+static inline void av_stats_add_crc(AvStats *s, uint64_t bytes, uint64_t ns) {
+    atomic_fetch_add_explicit(&s->crc_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->crc_bytes, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->crc_ns, ns, memory_order_relaxed);
+}
+
+/**
+ * @brief 写盘前复核 CRC 不一致计数 +1
+ * 
+ * @param s 统计对象指针
+ */
+static inline void av_stats_inc_crc_error(AvStats *s) {
+    atomic_fetch_add_explicit(&s->crc_errors, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief 某时间层送达/丢弃计数 +1
+ * 
+ * @param s    统计对象指针
+ * @param tid  时间层 ID
+ * @param shed 1=因拥塞丢弃，0=已送入 H264 队列
+ */
+static inline void av_stats_inc_tlayer(AvStats *s, int tid, int shed) {
+    if (tid < 0 || tid >= AV_STATS_MAX_TLAYERS) return;
+    atomic_fetch_add_explicit(shed ? &s->tl_shed[tid] : &s->tl_frames[tid], 1,
+                              memory_order_relaxed);
+}
+
+/**
+ * @brief 记录一帧的分段延迟（写盘线程在整帧写出后调用）
+ * 
+ * @param s        统计对象指针
+ * @param enc_us   采集 -> 编码器吐出首片
+ * @param first_us 采集 -> 首片写出
+ * @param frame_us 采集 -> 整帧写出
+ */
+static inline void av_stats_add_latency(AvStats *s, uint64_t enc_us, uint64_t first_us,
+                                        uint64_t frame_us) {
+    atomic_fetch_add_explicit(&s->lat_frames, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->lat_enc_us, enc_us, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->lat_first_us, first_us, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->lat_frame_us, frame_us, memory_order_relaxed);
+    uint64_t cur = atomic_load_explicit(&s->lat_frame_max, memory_order_relaxed);
+    while (frame_us > cur &&
+           !atomic_compare_exchange_weak_explicit(&s->lat_frame_max, &cur, frame_us,
+                                                  memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+
+/**
+ * @brief 记录一次采集合帧拷贝（采集线程在 DQBUF 后调用）
+ * 
+ * @param s     统计对象指针
+ * @param bytes 拷贝字节数
+ * @param ns    耗时（纳秒，见 V4L2Capture::last_copy_ns）
+ */
+static inline void av_stats_add_cap_copy(AvStats *s, uint64_t bytes, uint64_t ns) {
+    atomic_fetch_add_explicit(&s->cap_frames, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->cap_bytes, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->cap_ns, ns, memory_order_relaxed);
+}
+
+/**
+ * @brief 记录 CFR 节拍器的判定结果（编码线程每帧调用）
+ * 
+ * @param s      统计对象指针
+ * @param repeat 本帧之前重复填补的槽位数
+ * @param drop   丢弃的重复帧数
+ */
+static inline void av_stats_add_cfr(AvStats *s, uint64_t repeat, uint64_t drop) {
+    if (repeat) atomic_fetch_add_explicit(&s->cfr_repeat, repeat, memory_order_relaxed);
+    if (drop)   atomic_fetch_add_explicit(&s->cfr_drop, drop, memory_order_relaxed);
+}
+
+/**
+ * @brief 记录一次落盘加密的开销（sink 线程每包/块调用）
+ * 
+ * @param s     统计对象指针
+ * @param bytes 加密的字节数
+ * @param ns    耗时（纳秒）
+ */
+static inline void av_stats_add_aes(AvStats *s, uint64_t bytes, uint64_t ns) {
+    atomic_fetch_add_explicit(&s->aes_bytes, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->aes_ns, ns, memory_order_relaxed);
+}
+
+/**
+ * @brief 记录一次音频采集 overrun（音频采集线程调用）
+ * 
+ * @param s       统计对象指针
+ * @param lost_us 丢失的时长（微秒）
+ * @param fill_us 其中补入静音的时长（其余由 PTS 跳过）
+ */
+static inline void av_stats_add_xrun(AvStats *s, uint64_t lost_us, uint64_t fill_us) {
+    atomic_fetch_add_explicit(&s->xrun_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->xrun_lost_us, lost_us, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->xrun_fill_us, fill_us, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->xrun_total, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->xrun_total_us, lost_us, memory_order_relaxed);
+}
+
 #ifdef __cplusplus
 }
 #endif
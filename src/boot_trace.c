@@ -0,0 +1,201 @@
+/**
+ * @file boot_trace.c
+ * @brief 启动阶段计时实现
+ *
+ * 每个阶段 / 实例一对原子时间戳（相对启动时刻的微秒数 + 1，0 表示未记录）。
+ * 开始时刻只在首次写入（compare-exchange），结束时刻以最后一次为准，
+ * 调用方可在模块内阶段之后追加同一阶段的后续步骤。报告按开始时刻排序输出。
+ */
+#include "boot_trace.h"
+#include "log.h"
+
+#include "rkav/time.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/** 模块日志标签 */
+#define TAG "boot"
+
+/** 设备初始化类阶段：参与“串行耗时之和 / 墙钟跨度”汇总 */
+#define BOOT_DEVICE_MASK  ((1u << BOOT_V4L2_OPEN) | (1u << BOOT_V4L2_FMT) | (1u << BOOT_V4L2_BUFS) | \
+                           (1u << BOOT_V4L2_STREAMON) | (1u << BOOT_MPP_CREATE) |                    \
+                           (1u << BOOT_MPP_INIT) | (1u << BOOT_MPP_CFG) | (1u << BOOT_ALSA_OPEN) |   \
+                           (1u << BOOT_ALSA_HW) | (1u << BOOT_FILE_OPEN))
+
+typedef struct {
+    const char *name;
+    bool        mark;       /**< 里程碑 */
+    BootPhase   ref;        /**< 里程碑的前置阶段（耗时列 = 本时刻 - 前置阶段结束） */
+    BootPhase   alt;        /**< 前置阶段未记录时改用的阶段（如合成音源没有 hw_params） */
+} BootPhaseInfo;
+
+static const BootPhaseInfo s_info[BOOT_PHASE_COUNT] = {
+    [BOOT_CONFIG]        = { "config",       false, BOOT_CONFIG,        BOOT_CONFIG },
+    [BOOT_SETUP]         = { "setup",        false, BOOT_SETUP,         BOOT_SETUP },
+    [BOOT_V4L2_OPEN]     = { "v4l2_open",    false, BOOT_V4L2_OPEN,     BOOT_V4L2_OPEN },
+    [BOOT_V4L2_FMT]      = { "v4l2_fmt",     false, BOOT_V4L2_FMT,      BOOT_V4L2_FMT },
+    [BOOT_V4L2_BUFS]     = { "v4l2_bufs",    false, BOOT_V4L2_BUFS,     BOOT_V4L2_BUFS },
+    [BOOT_V4L2_STREAMON] = { "streamon",     false, BOOT_V4L2_STREAMON, BOOT_V4L2_STREAMON },
+    [BOOT_FIRST_DQBUF]   = { "first_dqbuf",  true,  BOOT_V4L2_STREAMON, BOOT_V4L2_STREAMON },
+    [BOOT_MPP_CREATE]    = { "mpp_create",   false, BOOT_MPP_CREATE,    BOOT_MPP_CREATE },
+    [BOOT_MPP_INIT]      = { "mpp_init",     false, BOOT_MPP_INIT,      BOOT_MPP_INIT },
+    [BOOT_MPP_CFG]       = { "mpp_cfg",      false, BOOT_MPP_CFG,       BOOT_MPP_CFG },
+    [BOOT_ALSA_OPEN]     = { "alsa_open",    false, BOOT_ALSA_OPEN,     BOOT_ALSA_OPEN },
+    [BOOT_ALSA_HW]       = { "alsa_hw",      false, BOOT_ALSA_HW,       BOOT_ALSA_HW },
+    [BOOT_FILE_OPEN]     = { "file_open",    false, BOOT_FILE_OPEN,     BOOT_FILE_OPEN },
+    [BOOT_FIRST_PACKET]  = { "first_packet", true,  BOOT_FIRST_DQBUF,   BOOT_SETUP },
+    [BOOT_FIRST_WRITE]   = { "first_write",  true,  BOOT_FIRST_PACKET,  BOOT_FIRST_PACKET },
+    [BOOT_FIRST_AUDIO]   = { "first_audio",  true,  BOOT_ALSA_HW,       BOOT_ALSA_OPEN },
+};
+
+static uint64_t             s_t0;       /**< 启动时刻（init 之后只读） */
+static atomic_uint_fast64_t s_beg[BOOT_PHASE_COUNT][BOOT_MAX_INST];
+static atomic_uint_fast64_t s_end[BOOT_PHASE_COUNT][BOOT_MAX_INST];
+static const char *_Atomic  s_thr[BOOT_PHASE_COUNT][BOOT_MAX_INST];
+static atomic_int           s_goal = BOOT_FIRST_WRITE;
+static atomic_int           s_printed;
+
+static _Thread_local const char *t_name = "main";
+static _Thread_local int         t_inst;
+
+void boot_trace_init(void)
+{
+    s_t0 = rkav_now_monotonic_us();
+}
+
+void boot_trace_thread(const char *name, int inst)
+{
+    t_name = name ? name : "?";
+    t_inst = inst;
+}
+
+static bool slot_ok(BootPhase ph)
+{
+    return s_t0 && (unsigned)ph < BOOT_PHASE_COUNT && t_inst >= 0 && t_inst < BOOT_MAX_INST;
+}
+
+void boot_trace_begin(BootPhase ph)
+{
+    if (!slot_ok(ph)) return;
+    uint_fast64_t expect = 0;
+    if (atomic_compare_exchange_strong(&s_beg[ph][t_inst], &expect,
+                                       rkav_now_monotonic_us() - s_t0 + 1))
+        atomic_store(&s_thr[ph][t_inst], t_name);
+}
+
+void boot_trace_end(BootPhase ph)
+{
+    if (!slot_ok(ph) || !atomic_load(&s_beg[ph][t_inst])) return;
+    atomic_store(&s_end[ph][t_inst], rkav_now_monotonic_us() - s_t0 + 1);
+}
+
+void boot_trace_mark(BootPhase ph)
+{
+    if (!slot_ok(ph) || atomic_load(&s_beg[ph][t_inst])) return;
+    boot_trace_begin(ph);
+    uint64_t v = atomic_load(&s_beg[ph][t_inst]);
+    uint_fast64_t expect = 0;
+    atomic_compare_exchange_strong(&s_end[ph][t_inst], &expect, v);
+}
+
+void boot_trace_set_goal(BootPhase ph)
+{
+    if ((unsigned)ph < BOOT_PHASE_COUNT)
+        atomic_store(&s_goal, (int)ph);
+}
+
+const char *boot_phase_name(BootPhase ph)
+{
+    return (unsigned)ph < BOOT_PHASE_COUNT ? s_info[ph].name : "?";
+}
+
+typedef struct {
+    BootPhase ph;
+    int       inst;
+    uint64_t  beg;      /**< 微秒 + 1 */
+    uint64_t  end;
+} BootRow;
+
+static int row_cmp(const void *a, const void *b)
+{
+    const BootRow *x = (const BootRow *)a, *y = (const BootRow *)b;
+    if (x->beg != y->beg) return x->beg < y->beg ? -1 : 1;
+    return (int)x->ph - (int)y->ph;
+}
+
+static double ms(uint64_t us)
+{
+    return (double)us / 1000.0;
+}
+
+void boot_trace_report(void)
+{
+    if (!s_t0 || atomic_exchange(&s_printed, 1)) return;
+
+    BootRow rows[BOOT_PHASE_COUNT * BOOT_MAX_INST];
+    int n = 0;
+    for (int p = 0; p < BOOT_PHASE_COUNT; p++) {
+        for (int i = 0; i < BOOT_MAX_INST; i++) {
+            uint64_t b = atomic_load(&s_beg[p][i]);
+            if (!b) continue;
+            rows[n++] = (BootRow){ (BootPhase)p, i, b, atomic_load(&s_end[p][i]) };
+        }
+    }
+    qsort(rows, (size_t)n, sizeof(rows[0]), row_cmp);
+
+    LOGI("[BOOT] startup trace (ms since process start):");
+    LOGI("[BOOT]   %-13s %-12s %9s %9s", "phase", "thread", "at", "took");
+
+    uint64_t dev_sum = 0, dev_first = UINT64_MAX, dev_last = 0;
+    for (int r = 0; r < n; r++) {
+        const BootRow *row = &rows[r];
+        const BootPhaseInfo *info = &s_info[row->ph];
+        const char *thr = atomic_load(&s_thr[row->ph][row->inst]);
+        char took[24];
+
+        if (info->mark) {
+            uint64_t ref = atomic_load(&s_end[info->ref][row->inst]);
+            if (!ref)
+                ref = atomic_load(&s_end[info->alt][row->inst]);
+            if (ref && ref <= row->beg)
+                snprintf(took, sizeof(took), "+%.2f", ms(row->beg - ref));
+            else
+                snprintf(took, sizeof(took), "-");
+        } else if (row->end) {
+            snprintf(took, sizeof(took), "%.2f", ms(row->end - row->beg));
+            if (BOOT_DEVICE_MASK & (1u << row->ph)) {
+                dev_sum += row->end - row->beg;
+                if (row->beg < dev_first) dev_first = row->beg;
+                if (row->end > dev_last)  dev_last = row->end;
+            }
+        } else {
+            snprintf(took, sizeof(took), "unfinished");
+        }
+        LOGI("[BOOT]   %-13s %-12s %9.2f %9s", info->name, thr ? thr : "?", ms(row->beg - 1), took);
+    }
+
+    uint64_t pkt = atomic_load(&s_beg[BOOT_FIRST_PACKET][0]);
+    uint64_t wr  = atomic_load(&s_beg[BOOT_FIRST_WRITE][0]);
+    uint64_t au  = atomic_load(&s_beg[BOOT_FIRST_AUDIO][0]);
+    char f_pkt[24] = "-", f_wr[24] = "-", f_au[24] = "-";
+    if (pkt) snprintf(f_pkt, sizeof(f_pkt), "%.2f ms", ms(pkt - 1));
+    if (wr)  snprintf(f_wr, sizeof(f_wr), "%.2f ms", ms(wr - 1));
+    if (au)  snprintf(f_au, sizeof(f_au), "%.2f ms", ms(au - 1));
+    LOGI("[BOOT] first frame %s, first write %s, first audio %s", f_pkt, f_wr, f_au);
+    if (dev_last > dev_first) {
+        uint64_t wall = dev_last - dev_first;
+        LOGI("[BOOT] device init %.2f ms serial, %.2f ms wall (overlap saved %.2f ms)",
+             ms(dev_sum), ms(wall), dev_sum > wall ? ms(dev_sum - wall) : 0.0);
+    }
+}
+
+void boot_trace_tick_print(void)
+{
+    if (!s_t0 || atomic_load(&s_printed)) return;
+    int goal = atomic_load(&s_goal);
+    if (atomic_load(&s_end[goal][0]))
+        boot_trace_report();
+}
@@ -0,0 +1,97 @@
+/**
+ * @file boot_trace.h
+ * @brief 启动阶段计时：从进程启动到第一帧落盘
+ *
+ * 事件触发录像（移动侦测 / 外部触发后才拉起进程）时，首帧出现前的时间直接决定漏录多少。
+ * 启动涉及的设备初始化分散在各工作线程里（V4L2 S_FMT / REQBUFS / mmap / STREAMON、
+ * MPP create / init / cfg、ALSA hw_params、录像文件打开），原先没有任何耗时可见性。
+ *
+ * 本模块记录每个阶段相对进程启动（boot_trace_init）的开始时刻、耗时和所在线程，
+ * 目标里程碑（默认首次写盘）到达后由统计线程输出一次 [BOOT] 报告：
+ * - 区间阶段：begin / end 成对调用，开始取第一次，结束取最后一次
+ * - 里程碑（首次 DQBUF、首个编码包、首次写盘、首个音频块）：boot_trace_mark()，只记录第一次，
+ *   耗时列为距前置阶段结束的间隔（如 STREAMON 完成到首帧出队 = 传感器起转时间）
+ * - 汇总：首帧时间（首个编码包）、首次写盘时间，以及设备初始化的串行耗时之和与实际墙钟跨度，
+ *   两者之差即并行启动节省的时间
+ *
+ * 多路设备（多摄像头 / 多麦克风）按实例号分开记录，实例号与线程名由所在线程声明
+ * （boot_trace_thread()，线程局部）。未调用 boot_trace_init() 时所有接口都是空操作，
+ * 工具程序链接设备模块不受影响。
+ *
+ * 典型使用流程：
+ * 1. main 入口: boot_trace_init()
+ * 2. 各线程: boot_trace_thread()，之后 boot_trace_begin() / boot_trace_end() / boot_trace_mark()
+ * 3. 统计线程: boot_trace_tick_print()（目标到达后输出一次）
+ * 4. 退出前: boot_trace_report()（尚未输出时补一次）
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 每个阶段最多记录的实例数（摄像头 / 麦克风路数） */
+#define BOOT_MAX_INST  4
+
+/**
+ * @brief 启动阶段
+ */
+typedef enum {
+    BOOT_CONFIG = 0,        /**< 命令行解析与配置校验 */
+    BOOT_SETUP,             /**< 主线程其余初始化（队列、服务、录像目录、存储目标） */
+    BOOT_V4L2_OPEN,         /**< open() 设备节点 */
+    BOOT_V4L2_FMT,          /**< S_FMT + 帧间隔协商 */
+    BOOT_V4L2_BUFS,         /**< REQBUFS + EXPBUF / mmap + QBUF */
+    BOOT_V4L2_STREAMON,     /**< STREAMON */
+    BOOT_FIRST_DQBUF,       /**< 里程碑：首帧出队 */
+    BOOT_MPP_CREATE,        /**< mpp_create */
+    BOOT_MPP_INIT,          /**< mpp_init + 输入缓冲 */
+    BOOT_MPP_CFG,           /**< 编码参数（GET_CFG / SET_CFG 及分层 / GOP / 切片） */
+    BOOT_ALSA_OPEN,         /**< snd_pcm_open（或合成源） */
+    BOOT_ALSA_HW,           /**< hw_params 协商与格式转换准备 */
+    BOOT_FILE_OPEN,         /**< 录像文件打开 */
+    BOOT_FIRST_PACKET,      /**< 里程碑：首个编码包 */
+    BOOT_FIRST_WRITE,       /**< 里程碑：首次写盘 */
+    BOOT_FIRST_AUDIO,       /**< 里程碑：首个音频块 */
+    BOOT_PHASE_COUNT
+} BootPhase;
+
+/** 记录进程启动时刻（main 第一条语句调用） */
+void boot_trace_init(void);
+
+/**
+ * @brief 声明当前线程的名称与实例号（线程局部，未声明时为 "main" / 0）
+ *
+ * @param name  线程名（须在整个进程生命周期内有效，通常为字符串常量）
+ * @param inst  实例号（0 ~ BOOT_MAX_INST-1，超出的不记录）
+ */
+void boot_trace_thread(const char *name, int inst);
+
+/** 阶段开始（同一阶段 / 实例只记录第一次） */
+void boot_trace_begin(BootPhase ph);
+
+/** 阶段结束（以最后一次调用为准） */
+void boot_trace_end(BootPhase ph);
+
+/** 里程碑（只记录第一次） */
+void boot_trace_mark(BootPhase ph);
+
+/**
+ * @brief 设置报告的目标里程碑（默认 BOOT_FIRST_WRITE；纯音频录像用 BOOT_FIRST_AUDIO）
+ */
+void boot_trace_set_goal(BootPhase ph);
+
+/** 目标里程碑到达后输出一次报告（统计线程每秒调用） */
+void boot_trace_tick_print(void);
+
+/** 输出报告（已输出过则忽略；退出前调用，覆盖目标始终未到达的情况） */
+void boot_trace_report(void);
+
+/** 阶段名称 */
+const char *boot_phase_name(BootPhase ph);
+
+#ifdef __cplusplus
+}
+#endif
@@ -13,23 +13,78 @@
  * - 使用环形缓冲区（循环数组）存储元素
  * - 使用 pthread_mutex 保护临界区
  * - 使用 pthread_cond 实现阻塞等待
+ * - 可选等待策略（rkav/wait.h）：加锁前先无锁窥视 size 并自旋（wfe/pause），
+ *   SPIN_PARK 自旋预算用完再进条件变量，SPIN 从不睡眠
  */
 #include "rkav/bqueue.h"
 
 #include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+/*
+ * 无锁窥视：入队 / 出队是否可能立即成功（或已关闭）。
+ * size、closed 只在锁内修改；这里用 __atomic 读取对齐的字段，结果只作自旋提示，以加锁后为准。
+ */
+static int bq_ready(BQueue *q, int pop)
+{
+    if (__atomic_load_n(&q->closed, __ATOMIC_RELAXED)) return 1;
+    size_t n = __atomic_load_n(&q->size, __ATOMIC_RELAXED);
+    return pop ? n > 0 : n < q->capacity;
+}
+
+/*
+ * 加锁前的自旋阶段（PARK 策略直接返回）。
+ *
+ * @param q           队列
+ * @param pop         1 等待有元素，0 等待有空位
+ * @param deadline_ns 截止时间（CLOCK_MONOTONIC 纳秒，0 = 无）
+ * @return            1 可能已就绪；0 自旋预算或截止时间已到
+ */
+static int bq_spin(BQueue *q, int pop, uint64_t deadline_ns)
+{
+    if (q->wait == RKAV_WAIT_PARK) return 0;
+
+    /* 截止时间已到（含 timeout 0 的非阻塞调用）：只看一眼，不进入自旋 */
+    uint64_t now = rkav_spin_now_ns();
+    if (deadline_ns && now >= deadline_ns) return bq_ready(q, pop);
+
+    uint64_t end = q->wait == RKAV_WAIT_SPIN_PARK ? now + RKAV_SPIN_NS : UINT64_MAX;
+    if (deadline_ns && deadline_ns < end) end = deadline_ns;
+
+    for (unsigned i = 1;; i++) {
+        size_t n = __atomic_load_n(&q->size, __ATOMIC_RELAXED);
+        if (bq_ready(q, pop)) return 1;
+        rkav_spin_wait(&q->size, n);
+        if ((i & 15) == 0 && end != UINT64_MAX && rkav_spin_now_ns() >= end) return 0;
+        if (q->wait == RKAV_WAIT_SPIN && i % RKAV_SPIN_YIELD_EVERY == 0) sched_yield();
+    }
+}
 
 /**
- * @brief 初始化阻塞队列
+ * @brief 初始化阻塞队列（PARK 策略）
+ * 
+ * @param q        队列指针
+ * @param capacity 队列容量（最大元素个数）
+ * @return int     0 成功，-1 失败
+ */
+int bq_init(BQueue *q, size_t capacity)
+{
+    return bq_init_wait(q, capacity, RKAV_WAIT_PARK);
+}
+
+/**
+ * @brief 初始化阻塞队列并指定等待策略
  * 
  * 分配内存并初始化互斥锁和条件变量。
  * 
  * @param q        队列指针
  * @param capacity 队列容量（最大元素个数）
+ * @param wait     等待策略
  * @return int     0 成功，-1 失败
  */
-int bq_init(BQueue *q, size_t capacity)
+int bq_init_wait(BQueue *q, size_t capacity, RkavWait wait)
 {
     if (!q || capacity == 0)
         return -1;
@@ -46,11 +101,17 @@ int bq_init(BQueue *q, size_t capacity)
     q->head = 0;      /* 出队位置 */
     q->tail = 0;      /* 入队位置 */
     q->closed = 0;
+    q->wait = wait;
+
+    /* 初始化同步原语：条件变量绑定 CLOCK_MONOTONIC，供 bq_pop_timeout 使用 */
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
 
-    /* 初始化同步原语 */
     pthread_mutex_init(&q->mtx, NULL);
-    pthread_cond_init(&q->not_empty, NULL);  /* 队列非空条件 */
-    pthread_cond_init(&q->not_full, NULL);   /* 队列非满条件 */
+    pthread_cond_init(&q->not_empty, &ca);   /* 队列非空条件 */
+    pthread_cond_init(&q->not_full, &ca);    /* 队列非满条件 */
+    pthread_condattr_destroy(&ca);
 
     return 0;
 }
@@ -116,8 +177,17 @@ void bq_destroy(BQueue *q)
 int bq_push(BQueue *q, void *item)
 {
     if (!q) return -1;
-    
-    pthread_mutex_lock(&q->mtx);
+
+    for (;;) {
+        bq_spin(q, 0, 0);
+        pthread_mutex_lock(&q->mtx);
+        if (q->wait == RKAV_WAIT_SPIN && !q->closed && q->size == q->capacity) {
+            /* 被其他生产者抢先：继续自旋，不睡眠 */
+            pthread_mutex_unlock(&q->mtx);
+            continue;
+        }
+        break;
+    }
 
     /* 等待队列非满 */
     while (!q->closed && q->size == q->capacity) {
@@ -188,8 +258,16 @@ int bq_try_push(BQueue *q, void *item)
 int bq_pop(BQueue *q, void **out)
 {
     if (!q || !out) return -1;
-    
-    pthread_mutex_lock(&q->mtx);
+
+    for (;;) {
+        bq_spin(q, 1, 0);
+        pthread_mutex_lock(&q->mtx);
+        if (q->wait == RKAV_WAIT_SPIN && !q->closed && q->size == 0) {
+            pthread_mutex_unlock(&q->mtx);
+            continue;
+        }
+        break;
+    }
 
     /* 等待队列非空 */
     while (!q->closed && q->size == 0) {
@@ -216,6 +294,70 @@ int bq_pop(BQueue *q, void **out)
     return 1;
 }
 
+/**
+ * @brief 带超时的出队
+ * 
+ * 与 bq_pop 相同，但最多等待 timeout_us 微秒（基于 CLOCK_MONOTONIC）。
+ * SPIN 策略自旋到截止时间，不睡眠。
+ * timeout_us 为 0 时等价于非阻塞 try_pop。
+ * 
+ * @param q          队列指针
+ * @param out        输出：取出的元素
+ * @param timeout_us 最长等待时间（微秒）
+ * @return int 1 成功取出元素，0 队列已关闭且为空，2 超时，-1 失败
+ */
+int bq_pop_timeout(BQueue *q, void **out, uint64_t timeout_us)
+{
+    if (!q || !out) return -1;
+
+    /* 计算绝对截止时间 */
+    struct timespec dl;
+    clock_gettime(CLOCK_MONOTONIC, &dl);
+    dl.tv_sec  += (time_t)(timeout_us / 1000000ULL);
+    dl.tv_nsec += (long)(timeout_us % 1000000ULL) * 1000L;
+    if (dl.tv_nsec >= 1000000000L) {
+        dl.tv_sec++;
+        dl.tv_nsec -= 1000000000L;
+    }
+
+    uint64_t dl_ns = (uint64_t)dl.tv_sec * 1000000000ull + (uint64_t)dl.tv_nsec;
+    for (;;) {
+        if (timeout_us) bq_spin(q, 1, dl_ns);
+        pthread_mutex_lock(&q->mtx);
+        if (q->wait == RKAV_WAIT_SPIN && !q->closed && q->size == 0) {
+            pthread_mutex_unlock(&q->mtx);
+            if (rkav_spin_now_ns() >= dl_ns) return 2;
+            continue;
+        }
+        break;
+    }
+
+    while (!q->closed && q->size == 0) {
+        if (pthread_cond_timedwait(&q->not_empty, &q->mtx, &dl) != 0 && q->size == 0) {
+            /* ETIMEDOUT：截止时间已到仍为空 */
+            int closed = q->closed;
+            pthread_mutex_unlock(&q->mtx);
+            return closed ? 0 : 2;
+        }
+    }
+
+    if (q->size == 0 && q->closed) {
+        pthread_mutex_unlock(&q->mtx);
+        return 0;
+    }
+
+    void *item = q->items[q->head];
+    q->items[q->head] = NULL;
+    q->head = (q->head + 1) % q->capacity;
+    q->size--;
+
+    pthread_cond_signal(&q->not_full);
+    pthread_mutex_unlock(&q->mtx);
+
+    *out = item;
+    return 1;
+}
+
 /**
  * @brief 获取队列当前元素个数
  * 
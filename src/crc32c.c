@@ -0,0 +1,181 @@
+/**
+ * @file crc32c.c
+ * @brief CRC32C（Castagnoli）校验模块实现
+ *
+ * 硬件路径每次处理 8 字节（ARMv8 crc32cx / x86 crc32q），首尾不对齐部分逐字节。
+ * 查表路径为 slicing-by-8，表在首次使用时生成（pthread_once）。
+ */
+#include "crc32c.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#  include <arm_acle.h>
+#  define CRC_ARMV8 1
+#elif defined(__SSE4_2__)
+#  include <nmmintrin.h>
+#  define CRC_SSE42 1
+#endif
+
+/** CRC32C 多项式（反射形式） */
+#define CRC32C_POLY  0x82F63B78u
+
+/* ============================================================================
+ * slicing-by-8 查表实现
+ * ============================================================================ */
+
+static uint32_t       s_table[8][256];
+static pthread_once_t s_table_once = PTHREAD_ONCE_INIT;
+
+static void table_init(void)
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+            c = (c >> 1) ^ (CRC32C_POLY & (0u - (c & 1u)));
+        s_table[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = s_table[0][i];
+        for (int t = 1; t < 8; t++) {
+            c = s_table[0][c & 0xFF] ^ (c >> 8);
+            s_table[t][i] = c;
+        }
+    }
+}
+
+/* 对已取反的寄存器值 c 处理 len 字节 */
+static uint32_t table_run(uint32_t c, const uint8_t *p, size_t len)
+{
+    while (len && ((uintptr_t)p & 7u)) {
+        c = s_table[0][(c ^ *p++) & 0xFF] ^ (c >> 8);
+        len--;
+    }
+    while (len >= 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, p, 4);
+        memcpy(&hi, p + 4, 4);
+        lo ^= c;
+        c = s_table[7][lo & 0xFF] ^ s_table[6][(lo >> 8) & 0xFF] ^
+            s_table[5][(lo >> 16) & 0xFF] ^ s_table[4][lo >> 24] ^
+            s_table[3][hi & 0xFF] ^ s_table[2][(hi >> 8) & 0xFF] ^
+            s_table[1][(hi >> 16) & 0xFF] ^ s_table[0][hi >> 24];
+        p   += 8;
+        len -= 8;
+    }
+    while (len--)
+        c = s_table[0][(c ^ *p++) & 0xFF] ^ (c >> 8);
+    return c;
+}
+
+uint32_t crc32c_update_table(uint32_t crc, const void *buf, size_t len)
+{
+    pthread_once(&s_table_once, table_init);
+    return ~table_run(~crc, (const uint8_t *)buf, len);
+}
+
+/* ============================================================================
+ * 硬件实现
+ * ============================================================================ */
+
+#if defined(CRC_ARMV8)
+#  define HW_U8(c, b)   __crc32cb((c), (b))
+#  define HW_U64(c, v)  __crc32cd((c), (v))
+#elif defined(CRC_SSE42)
+#  define HW_U8(c, b)   _mm_crc32_u8((c), (b))
+#  if defined(__x86_64__)
+#    define HW_U64(c, v)  ((uint32_t)_mm_crc32_u64((c), (v)))
+#  else
+#    define HW_U64(c, v)  _mm_crc32_u32(_mm_crc32_u32((c), (uint32_t)(v)), (uint32_t)((v) >> 32))
+#  endif
+#endif
+
+uint32_t crc32c_update(uint32_t crc, const void *buf, size_t len)
+{
+#if defined(HW_U64)
+    const uint8_t *p = (const uint8_t *)buf;
+    uint32_t c = ~crc;
+    while (len && ((uintptr_t)p & 7u)) {
+        c = HW_U8(c, *p++);
+        len--;
+    }
+    while (len >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        c = HW_U64(c, v);
+        p   += 8;
+        len -= 8;
+    }
+    while (len--)
+        c = HW_U8(c, *p++);
+    return ~c;
+#else
+    return crc32c_update_table(crc, buf, len);
+#endif
+}
+
+uint32_t crc32c_copy(uint32_t crc, void *dst, const void *src, size_t len)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    uint8_t       *d = (uint8_t *)dst;
+#if defined(HW_U64)
+    uint32_t c = ~crc;
+    while (len && ((uintptr_t)s & 7u)) {
+        *d = *s;
+        c = HW_U8(c, *s);
+        d++; s++; len--;
+    }
+    /* 每轮 32 字节：4 次 8 字节读 -> crc -> 写，读写都只发生一次 */
+    while (len >= 32) {
+        uint64_t v0, v1, v2, v3;
+        memcpy(&v0, s,      8);
+        memcpy(&v1, s + 8,  8);
+        memcpy(&v2, s + 16, 8);
+        memcpy(&v3, s + 24, 8);
+        c = HW_U64(c, v0);
+        c = HW_U64(c, v1);
+        c = HW_U64(c, v2);
+        c = HW_U64(c, v3);
+        memcpy(d,      &v0, 8);
+        memcpy(d + 8,  &v1, 8);
+        memcpy(d + 16, &v2, 8);
+        memcpy(d + 24, &v3, 8);
+        s += 32; d += 32; len -= 32;
+    }
+    while (len >= 8) {
+        uint64_t v;
+        memcpy(&v, s, 8);
+        c = HW_U64(c, v);
+        memcpy(d, &v, 8);
+        s += 8; d += 8; len -= 8;
+    }
+    while (len--) {
+        *d = *s;
+        c = HW_U8(c, *s);
+        d++; s++;
+    }
+    return ~c;
+#else
+    /* 查表路径没有融合收益：分块拷贝，块内数据仍在 L1 中 */
+    uint32_t c = crc;
+    while (len) {
+        size_t n = len > 4096 ? 4096 : len;
+        memcpy(d, s, n);
+        c = crc32c_update_table(c, d, n);
+        s += n; d += n; len -= n;
+    }
+    return c;
+#endif
+}
+
+const char *crc32c_impl_name(void)
+{
+#if defined(CRC_ARMV8)
+    return "armv8-crc";
+#elif defined(CRC_SSE42)
+    return "sse4.2";
+#else
+    return "table";
+#endif
+}
@@ -0,0 +1,58 @@
+/**
+ * @file crc32c.h
+ * @brief CRC32C（Castagnoli）校验模块头文件
+ *
+ * 用于给每个 EncodedPacket / AudioChunk 打完整性标签，写入录像索引（见 rec_index.h），
+ * 事后可区分“写盘前已损坏”与“落盘后损坏”。
+ *
+ * 特性：
+ * - ARMv8 CRC 扩展（__crc32cd，需 -march=armv8-a+crc）/ SSE4.2（_mm_crc32_u64）硬件实现，
+ *   其余情况回退 slicing-by-8 查表
+ * - 拷贝与校验融合（crc32c_copy），数据只过一遍缓存
+ * - 与 iSCSI / ext4 / Btrfs 使用的 CRC32C 结果一致（初值与结果均取反）
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 增量计算 CRC32C
+ *
+ * @param crc 之前的结果（首次传 0）
+ * @param buf 数据
+ * @param len 字节数
+ * @return uint32_t 累计到本段为止的 CRC32C
+ */
+uint32_t crc32c_update(uint32_t crc, const void *buf, size_t len);
+
+/** 一次性计算 CRC32C */
+static inline uint32_t crc32c(const void *buf, size_t len)
+{
+    return crc32c_update(0, buf, len);
+}
+
+/**
+ * @brief 拷贝的同时计算 CRC32C（等价于 memcpy + crc32c_update，但只读一遍源数据）
+ *
+ * @param crc 之前的结果（首次传 0）
+ * @param dst 目标缓冲（不可与 src 重叠）
+ * @param src 源数据
+ * @param len 字节数
+ * @return uint32_t 累计 CRC32C
+ */
+uint32_t crc32c_copy(uint32_t crc, void *dst, const void *src, size_t len);
+
+/** 当前编译进来的实现名称："armv8-crc" / "sse4.2" / "table" */
+const char *crc32c_impl_name(void);
+
+/** 纯查表实现（用于自检与基准对比） */
+uint32_t crc32c_update_table(uint32_t crc, const void *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,193 @@
+/**
+ * @file ctl.c
+ * @brief 运行时控制通道实现
+ *
+ * 单线程：poll 监听套接字与 eventfd；每次 accept 一个连接，读一条命令（带超时），
+ * 分发给登记的处理函数，回复后关闭连接。命令都是低频操作，串行处理即可。
+ */
+#include "ctl.h"
+#include "log.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/** 模块日志标签 */
+#define TAG "ctl"
+
+int ctl_init(Ctl *c, const char *path)
+{
+    if (!c || !path) return -1;
+    memset(c, 0, sizeof(*c));
+    c->listen_fd = c->evfd = -1;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        LOGE("[%s] socket path too long: %s", TAG, path);
+        return -1;
+    }
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    snprintf(c->path, sizeof(c->path), "%s", path);
+
+    /* 只清理残留的套接字，不误删同名普通文件 */
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            LOGE("[%s] %s exists and is not a socket", TAG, path);
+            return -1;
+        }
+        unlink(path);
+    }
+
+    c->listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    c->evfd      = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (c->listen_fd < 0 || c->evfd < 0) {
+        LOGE("[%s] socket/eventfd failed: %s", TAG, strerror(errno));
+        goto fail;
+    }
+
+    /* 控制命令可改变录像内容（如隐私遮挡），只允许属主连接 */
+    mode_t old = umask(0177);
+    int br = bind(c->listen_fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(old);
+    if (br != 0 || listen(c->listen_fd, 4) != 0) {
+        LOGE("[%s] bind/listen %s failed: %s", TAG, path, strerror(errno));
+        goto fail;
+    }
+
+    LOGI("[%s] listening on %s", TAG, path);
+    return 0;
+
+fail:
+    if (c->listen_fd >= 0) close(c->listen_fd);
+    if (c->evfd >= 0) close(c->evfd);
+    c->listen_fd = c->evfd = -1;
+    return -1;
+}
+
+int ctl_register(Ctl *c, const char *name, const char *help, CtlFn fn, void *ud)
+{
+    if (!c || !name || !fn) return -1;
+    if (c->ncmds >= CTL_MAX_CMDS) {
+        LOGE("[%s] command table full, cannot register '%s'", TAG, name);
+        return -1;
+    }
+    for (int i = 0; i < c->ncmds; i++) {
+        if (strcmp(c->cmds[i].name, name) == 0) {
+            LOGE("[%s] duplicate command '%s'", TAG, name);
+            return -1;
+        }
+    }
+    c->cmds[c->ncmds++] = (CtlCmd){ name, help ? help : "", fn, ud };
+    return 0;
+}
+
+/* 执行一条命令，把完整回复（含 ok / err 前缀）写入 out */
+static void ctl_dispatch(Ctl *c, char *msg, char *out, size_t cap)
+{
+    /* 去掉首尾空白与换行 */
+    while (*msg == ' ' || *msg == '\t') msg++;
+    size_t n = strlen(msg);
+    while (n > 0 && (msg[n - 1] == '\n' || msg[n - 1] == '\r' || msg[n - 1] == ' ' || msg[n - 1] == '\t'))
+        msg[--n] = '\0';
+
+    char *args = msg + strcspn(msg, " \t");
+    if (*args) {
+        *args++ = '\0';
+        while (*args == ' ' || *args == '\t') args++;
+    }
+
+    if (strcmp(msg, "help") == 0 || msg[0] == '\0') {
+        int off = snprintf(out, cap, "ok commands:");
+        for (int i = 0; i < c->ncmds && off > 0 && (size_t)off < cap; i++)
+            off += snprintf(out + off, cap - (size_t)off, "\n  %-8s %s", c->cmds[i].name, c->cmds[i].help);
+        return;
+    }
+
+    for (int i = 0; i < c->ncmds; i++) {
+        if (strcmp(c->cmds[i].name, msg) != 0) continue;
+        char reply[CTL_MSG_MAX - 8];
+        reply[0] = '\0';
+        int r = c->cmds[i].fn(c->cmds[i].ud, args, reply, sizeof(reply));
+        snprintf(out, cap, "%s%s%s", r == 0 ? "ok" : "err", reply[0] ? " " : "", reply);
+        if (r != 0) atomic_fetch_add(&c->failed, 1);
+        LOGI("[%s] %s %s -> %s", TAG, msg, args, r == 0 ? "ok" : reply);
+        return;
+    }
+    snprintf(out, cap, "err unknown command '%s' (try help)", msg);
+    atomic_fetch_add(&c->failed, 1);
+}
+
+static void ctl_serve(Ctl *c, int fd)
+{
+    struct timeval tv = { CTL_RECV_TIMEOUT_MS / 1000, (CTL_RECV_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    char msg[CTL_MSG_MAX], out[CTL_MSG_MAX];
+    ssize_t n = recv(fd, msg, sizeof(msg) - 1, 0);
+    if (n <= 0) return;
+    msg[n] = '\0';
+
+    ctl_dispatch(c, msg, out, sizeof(out));
+    atomic_fetch_add(&c->handled, 1);
+    if (send(fd, out, strlen(out), MSG_NOSIGNAL) < 0)
+        LOGW("[%s] reply failed: %s", TAG, strerror(errno));
+}
+
+void ctl_run(Ctl *c)
+{
+    if (!c || c->listen_fd < 0) return;
+
+    struct pollfd pfd[2] = {
+        { .fd = c->listen_fd, .events = POLLIN },
+        { .fd = c->evfd,      .events = POLLIN },
+    };
+    while (!atomic_load(&c->stop)) {
+        int n = poll(pfd, 2, 500);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOGE("[%s] poll failed: %s", TAG, strerror(errno));
+            break;
+        }
+        if (n == 0 || !(pfd[0].revents & POLLIN)) continue;
+
+        int fd = accept4(c->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        ctl_serve(c, fd);
+        close(fd);
+    }
+}
+
+void ctl_stop(Ctl *c)
+{
+    if (!c) return;
+    atomic_store(&c->stop, 1);
+    if (c->evfd >= 0) {
+        uint64_t one = 1;
+        ssize_t w = write(c->evfd, &one, sizeof(one));
+        (void)w;
+    }
+}
+
+void ctl_deinit(Ctl *c)
+{
+    if (!c) return;
+    if (c->listen_fd >= 0) {
+        close(c->listen_fd);
+        unlink(c->path);
+    }
+    if (c->evfd >= 0) close(c->evfd);
+    c->listen_fd = c->evfd = -1;
+    LOGI("[%s] closed: %llu command(s), %llu failed", TAG,
+         (unsigned long long)atomic_load(&c->handled), (unsigned long long)atomic_load(&c->failed));
+}
@@ -0,0 +1,102 @@
+/**
+ * @file ctl.h
+ * @brief 运行时控制通道头文件
+ *
+ * 本机 Unix 域 SOCK_SEQPACKET 套接字（--ctl <path>，权限 0600）：一次连接 = 一条命令 + 一条回复，
+ * 消息边界由内核保证，不需要自定义分帧。tools/rkav_ctl 是配套客户端，也可用
+ * `socat - UNIX-CONNECT:<path>,type=5`。
+ *
+ * 命令为一行文本："<名称> [参数...]"；回复以 "ok" 或 "err" 开头，后跟说明。
+ * 各模块在服务线程启动前用 ctl_register() 登记命令（如隐私遮挡的 mask），
+ * 处理函数在控制线程中执行，需自行保证与工作线程之间的线程安全。
+ * 内置命令 help 列出全部已登记命令。
+ *
+ * 典型使用流程：
+ * 1. ctl_init()      - 创建并监听套接字
+ * 2. ctl_register()  - 登记命令
+ * 3. 控制线程: ctl_run()
+ * 4. ctl_stop() -> join -> ctl_deinit()
+ */
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 最多可登记的命令数 */
+#define CTL_MAX_CMDS   16
+
+/** 命令 / 回复的最大长度 */
+#define CTL_MSG_MAX    2048
+
+/** 单个客户端发送命令的最长等待（毫秒），防止空连接卡住控制线程 */
+#define CTL_RECV_TIMEOUT_MS  1000
+
+/**
+ * @brief 命令处理函数
+ *
+ * @param ud    登记时的用户数据
+ * @param args  命令名之后的参数（已去掉首尾空白，可为 ""）
+ * @param reply 回复正文（不含 ok / err 前缀）
+ * @param cap   reply 容量
+ * @return int  0 成功（回复 "ok ..."），-1 失败（回复 "err ..."）
+ */
+typedef int (*CtlFn)(void *ud, const char *args, char *reply, size_t cap);
+
+/**
+ * @brief 已登记的命令
+ */
+typedef struct {
+    const char *name;
+    const char *help;       /**< 一行用法说明（help 命令输出） */
+    CtlFn       fn;
+    void       *ud;
+} CtlCmd;
+
+/**
+ * @brief 控制通道上下文
+ */
+typedef struct {
+    int         listen_fd;
+    int         evfd;               /**< 停止通知 */
+    char        path[108];          /**< 套接字路径（sun_path 上限） */
+    CtlCmd      cmds[CTL_MAX_CMDS];
+    int         ncmds;
+    atomic_int  stop;
+
+    atomic_uint_fast64_t handled;   /**< 累计处理的命令数 */
+    atomic_uint_fast64_t failed;    /**< 累计返回 err 的命令数 */
+} Ctl;
+
+/**
+ * @brief 创建并监听控制套接字
+ *
+ * 路径已存在且是套接字（上次异常退出的残留）时先删除；是其他类型文件时失败。
+ *
+ * @return int 0 成功，-1 失败
+ */
+int  ctl_init(Ctl *c, const char *path);
+
+/**
+ * @brief 登记一条命令（须在控制线程启动前调用）
+ *
+ * @return int 0 成功，-1 表已满或重名
+ */
+int  ctl_register(Ctl *c, const char *name, const char *help, CtlFn fn, void *ud);
+
+/** 控制线程主循环，直到 ctl_stop() */
+void ctl_run(Ctl *c);
+
+/** 请求控制线程退出（任意线程可调用） */
+void ctl_stop(Ctl *c);
+
+/** 关闭并删除套接字 */
+void ctl_deinit(Ctl *c);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,218 @@
+/**
+ * @file decoder_mpp.c
+ * @brief Rockchip MPP 硬件解码器实现
+ *
+ * 按 MPP 参考解码流程（mpi_dec_test）封装：
+ * - 关闭解析器分帧（调用方按访问单元投递，PTS 与帧一一对应）
+ * - 首次输出信息变化时创建 ION buffer group，limit_config 限定为 pool_frames 块，
+ *   作为外部缓冲池交给解码器（MPP_DEC_SET_EXT_BUF_GROUP），随后 INFO_CHANGE_READY
+ * - decode_put_packet / decode_get_frame 均为非阻塞，由调用方交替驱动
+ *
+ * 条件编译：
+ * - 当 RK_MPP_AVAILABLE=1 时，编译真正的 MPP 解码功能
+ * - 当 RK_MPP_AVAILABLE=0 时，编译占位实现（返回错误，主机上请用模拟后端）
+ */
+#include "decoder_mpp.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** 日志标签 */
+#define TAG "mpp_dec"
+
+#if !RK_MPP_AVAILABLE
+
+int decoder_mpp_init(DecoderMPP *dec, MppCodingType type, int pool_frames)
+{
+    (void)type;
+    (void)pool_frames;
+    if (dec) memset(dec, 0, sizeof(*dec));
+    LOGE("[%s] MPP headers not found. Please install MPP dev package (or use the mock backend).", TAG);
+    return -1;
+}
+
+int decoder_mpp_put_packet(DecoderMPP *dec, const uint8_t *data, size_t size, uint64_t pts_us,
+                           bool eos)
+{
+    (void)dec;
+    (void)data;
+    (void)size;
+    (void)pts_us;
+    (void)eos;
+    return -1;
+}
+
+int decoder_mpp_get_frame(DecoderMPP *dec, DecFrame *out)
+{
+    (void)dec;
+    (void)out;
+    return -1;
+}
+
+void decoder_mpp_release_frame(DecoderMPP *dec, DecFrame *f)
+{
+    (void)dec;
+    (void)f;
+}
+
+void decoder_mpp_deinit(DecoderMPP *dec)
+{
+    if (dec) memset(dec, 0, sizeof(*dec));
+}
+
+#else  // RK_MPP_AVAILABLE
+
+int decoder_mpp_init(DecoderMPP *dec, MppCodingType type, int pool_frames)
+{
+    if (!dec) return -1;
+    memset(dec, 0, sizeof(*dec));
+    dec->pool_frames = pool_frames > 0 ? pool_frames : DEC_POOL_FRAMES;
+
+    MPP_RET ret = mpp_create(&dec->ctx, &dec->mpi);
+    if (ret) {
+        LOGE("[%s] mpp_create failed: %d", TAG, ret);
+        return -1;
+    }
+
+    /* 输入已是完整访问单元：关闭解析器分帧，PTS 随包对应到帧 */
+    RK_U32 need_split = 0;
+    dec->mpi->control(dec->ctx, MPP_DEC_SET_PARSER_SPLIT_MODE, &need_split);
+
+    ret = mpp_init(dec->ctx, MPP_CTX_DEC, type);
+    if (ret) {
+        LOGE("[%s] mpp_init failed: %d", TAG, ret);
+        mpp_destroy(dec->ctx);
+        dec->ctx = NULL;
+        dec->mpi = NULL;
+        return -1;
+    }
+
+    LOGI("[%s] init ok pool=%d frames", TAG, dec->pool_frames);
+    return 0;
+}
+
+int decoder_mpp_put_packet(DecoderMPP *dec, const uint8_t *data, size_t size, uint64_t pts_us,
+                           bool eos)
+{
+    if (!dec || !dec->ctx) return -1;
+
+    MppPacket pkt = NULL;
+    if (mpp_packet_init(&pkt, (void *)data, data ? size : 0) != MPP_OK || !pkt) {
+        LOGE("[%s] mpp_packet_init failed", TAG);
+        return -1;
+    }
+    mpp_packet_set_pts(pkt, (RK_S64)pts_us);
+    if (eos) mpp_packet_set_eos(pkt);
+
+    /* 解码器内部输入队列满时不接收，数据由调用方保留重投 */
+    MPP_RET ret = dec->mpi->decode_put_packet(dec->ctx, pkt);
+    mpp_packet_deinit(&pkt);
+    return ret == MPP_OK ? 0 : 1;
+}
+
+/*
+ * 处理分辨率信息变化：按新尺寸配置输出缓冲池，通知解码器继续。
+ */
+static int dec_info_change(DecoderMPP *dec, MppFrame frame)
+{
+    dec->width      = (int)mpp_frame_get_width(frame);
+    dec->height     = (int)mpp_frame_get_height(frame);
+    dec->hor_stride = (int)mpp_frame_get_hor_stride(frame);
+    dec->ver_stride = (int)mpp_frame_get_ver_stride(frame);
+    size_t buf_size = mpp_frame_get_buf_size(frame);
+
+    MPP_RET ret;
+    if (!dec->frm_grp) {
+        ret = mpp_buffer_group_get_internal(&dec->frm_grp, MPP_BUFFER_TYPE_ION);
+        if (ret) {
+            LOGE("[%s] mpp_buffer_group_get_internal failed: %d", TAG, ret);
+            return -1;
+        }
+        ret = dec->mpi->control(dec->ctx, MPP_DEC_SET_EXT_BUF_GROUP, dec->frm_grp);
+        if (ret) {
+            LOGE("[%s] MPP_DEC_SET_EXT_BUF_GROUP failed: %d", TAG, ret);
+            return -1;
+        }
+    } else {
+        /* 尺寸变化：旧尺寸的缓冲全部释放后按新尺寸重新分配 */
+        mpp_buffer_group_clear(dec->frm_grp);
+    }
+
+    ret = mpp_buffer_group_limit_config(dec->frm_grp, buf_size, dec->pool_frames);
+    if (ret) {
+        LOGE("[%s] mpp_buffer_group_limit_config failed: %d", TAG, ret);
+        return -1;
+    }
+    dec->mpi->control(dec->ctx, MPP_DEC_SET_INFO_CHANGE_READY, NULL);
+
+    LOGI("[%s] stream %dx%d stride %dx%d, pool %d x %zu B", TAG, dec->width, dec->height,
+         dec->hor_stride, dec->ver_stride, dec->pool_frames, buf_size);
+    return 0;
+}
+
+int decoder_mpp_get_frame(DecoderMPP *dec, DecFrame *out)
+{
+    if (!dec || !dec->ctx || !out) return -1;
+    memset(out, 0, sizeof(*out));
+
+    for (;;) {
+        MppFrame frame = NULL;
+        MPP_RET ret = dec->mpi->decode_get_frame(dec->ctx, &frame);
+        if (ret != MPP_OK || !frame) return 0;
+
+        if (mpp_frame_get_info_change(frame)) {
+            int rc = dec_info_change(dec, frame);
+            mpp_frame_deinit(&frame);
+            if (rc != 0) return -1;
+            continue;
+        }
+
+        MppBuffer buf = mpp_frame_get_buffer(frame);
+        out->handle     = frame;
+        out->data       = buf ? (const uint8_t *)mpp_buffer_get_ptr(buf) : NULL;
+        out->width      = (int)mpp_frame_get_width(frame);
+        out->height     = (int)mpp_frame_get_height(frame);
+        out->hor_stride = (int)mpp_frame_get_hor_stride(frame);
+        out->ver_stride = (int)mpp_frame_get_ver_stride(frame);
+        out->pts_us     = (uint64_t)mpp_frame_get_pts(frame);
+        out->eos        = mpp_frame_get_eos(frame) != 0;
+        out->corrupt    = mpp_frame_get_errinfo(frame) || mpp_frame_get_discard(frame);
+        if (out->data) {
+            dec->frames++;
+            if (out->corrupt) dec->errors++;
+        }
+        return 1;
+    }
+}
+
+void decoder_mpp_release_frame(DecoderMPP *dec, DecFrame *f)
+{
+    (void)dec;
+    if (!f || !f->handle) return;
+    MppFrame frame = (MppFrame)f->handle;
+    mpp_frame_deinit(&frame);
+    f->handle = NULL;
+    f->data = NULL;
+}
+
+void decoder_mpp_deinit(DecoderMPP *dec)
+{
+    if (!dec) return;
+
+    if (dec->ctx) {
+        dec->mpi->reset(dec->ctx);
+        mpp_destroy(dec->ctx);
+        dec->ctx = NULL;
+        dec->mpi = NULL;
+    }
+    if (dec->frm_grp) {
+        mpp_buffer_group_put(dec->frm_grp);
+        dec->frm_grp = NULL;
+    }
+    LOGI("[%s] decoder_mpp_deinit frames=%llu errors=%llu", TAG,
+         (unsigned long long)dec->frames, (unsigned long long)dec->errors);
+    memset(dec, 0, sizeof(*dec));
+}
+
+#endif  // RK_MPP_AVAILABLE
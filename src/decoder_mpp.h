@@ -0,0 +1,97 @@
+/**
+ * @file decoder_mpp.h
+ * @brief Rockchip MPP 硬解码模块头文件
+ *
+ * 封装 MPP H.264 解码器，供离线转码（archive.h）使用：
+ * - 输入按访问单元（一帧的全部 NAL）投递，PTS 随包进入解码器，输出帧按显示顺序带回
+ * - 输出帧来自固定大小的缓冲池（MPP 内部 buffer group + limit_config），不逐帧分配；
+ *   调用方持有的帧在 decoder_mpp_release_frame() 之前不会被复用，池耗尽时解码器暂停输出
+ * - 分辨率信息变化（首个 SPS）在内部处理：按新尺寸配置缓冲池后通知解码器继续
+ *
+ * 典型使用流程：
+ * 1. decoder_mpp_init()
+ * 2. 循环：decoder_mpp_put_packet()（返回 1 时先取帧再重试）-> decoder_mpp_get_frame() -> 使用 -> decoder_mpp_release_frame()
+ * 3. 输入结束：decoder_mpp_put_packet(eos = true)，取帧直到 DecFrame::eos
+ * 4. decoder_mpp_deinit()
+ */
+#pragma once
+
+#include "encoder_mpp.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 默认缓冲池帧数（覆盖 H.264 最大 DPB 16 帧 + 在途 / 调用方持有的帧） */
+#define DEC_POOL_FRAMES  24
+
+/**
+ * @brief 解码输出帧（NV12，Y 平面后紧跟 UV 平面）
+ */
+typedef struct {
+    void          *handle;      /**< MppFrame（释放时用） */
+    const uint8_t *data;        /**< Y 平面起点；UV 平面在 data + hor_stride * ver_stride */
+    int            width;
+    int            height;
+    int            hor_stride;
+    int            ver_stride;
+    uint64_t       pts_us;
+    bool           eos;         /**< 流结束标记帧（可能不带图像，data 为 NULL） */
+    bool           corrupt;     /**< 解码器报告错误 / 丢弃（图像可能不完整） */
+} DecFrame;
+
+/**
+ * @brief MPP 解码器上下文
+ */
+typedef struct {
+    MppCtx         ctx;
+    MppApi        *mpi;
+    MppBufferGroup frm_grp;     /**< 输出帧缓冲池 */
+    int            pool_frames;
+    int            width;       /**< 当前码流尺寸（首个信息变化后有效） */
+    int            height;
+    int            hor_stride;
+    int            ver_stride;
+    uint64_t       frames;      /**< 已输出帧数 */
+    uint64_t       errors;      /**< 出错 / 被丢弃的帧数 */
+} DecoderMPP;
+
+/**
+ * @brief 初始化 MPP 解码器
+ *
+ * @param dec          输出：解码器实例
+ * @param type         码流类型（MPP_VIDEO_CodingAVC）
+ * @param pool_frames  输出帧缓冲池大小（<= 0 取 DEC_POOL_FRAMES）
+ * @return int 0 成功，-1 失败（含 MPP 不可用）
+ */
+int  decoder_mpp_init(DecoderMPP *dec, MppCodingType type, int pool_frames);
+
+/**
+ * @brief 投递一个访问单元（Annex-B，一帧的全部 NAL）
+ *
+ * @param eos  是否为最后一个（data 可为 NULL 表示只发结束标记）
+ * @return int 0 已接收；1 解码器输入已满，先取帧再重试；-1 失败
+ */
+int  decoder_mpp_put_packet(DecoderMPP *dec, const uint8_t *data, size_t size, uint64_t pts_us,
+                            bool eos);
+
+/**
+ * @brief 取一帧解码输出（不阻塞）
+ *
+ * @return int 1 取到（用完须 decoder_mpp_release_frame()），0 暂无输出，-1 失败
+ */
+int  decoder_mpp_get_frame(DecoderMPP *dec, DecFrame *out);
+
+/** 归还输出帧（缓冲回到池中） */
+void decoder_mpp_release_frame(DecoderMPP *dec, DecFrame *f);
+
+/** 释放解码器资源 */
+void decoder_mpp_deinit(DecoderMPP *dec);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,101 @@
+/**
+ * @file dmabuf.c
+ * @brief dma-buf 缓存同步与 dma-heap 分配实现
+ */
+#include "dmabuf.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#if defined(__has_include)
+#  if __has_include(<linux/dma-buf.h>)
+#    include <linux/dma-buf.h>
+#  endif
+#  if __has_include(<linux/dma-heap.h>)
+#    include <linux/dma-heap.h>
+#  endif
+#endif
+
+/* 同 v4l2_capture.c：被信号打断时重试 */
+static int xioctl(int fd, unsigned long req, void *arg)
+{
+    int r;
+    do {
+        r = ioctl(fd, req, arg);
+    } while (r == -1 && errno == EINTR);
+    return r;
+}
+
+#ifdef DMA_BUF_IOCTL_SYNC
+static int dmabuf_sync(int fd, int dir, uint64_t phase)
+{
+    struct dma_buf_sync s;
+    memset(&s, 0, sizeof(s));
+    s.flags = phase;
+    if (dir & DMABUF_SYNC_READ)  s.flags |= DMA_BUF_SYNC_READ;
+    if (dir & DMABUF_SYNC_WRITE) s.flags |= DMA_BUF_SYNC_WRITE;
+    return xioctl(fd, DMA_BUF_IOCTL_SYNC, &s);
+}
+
+int dmabuf_sync_begin(int fd, int dir)
+{
+    return dmabuf_sync(fd, dir, DMA_BUF_SYNC_START);
+}
+
+int dmabuf_sync_end(int fd, int dir)
+{
+    return dmabuf_sync(fd, dir, DMA_BUF_SYNC_END);
+}
+#else
+int dmabuf_sync_begin(int fd, int dir)
+{
+    (void)fd; (void)dir;
+    errno = ENOSYS;
+    return -1;
+}
+
+int dmabuf_sync_end(int fd, int dir)
+{
+    (void)fd; (void)dir;
+    errno = ENOSYS;
+    return -1;
+}
+#endif
+
+int dmabuf_heap_alloc(const char *heap, size_t len)
+{
+#ifdef DMA_HEAP_IOCTL_ALLOC
+    if (!heap || len == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    char path[128];
+    snprintf(path, sizeof(path), "/dev/dma_heap/%s", heap);
+    int hfd = open(path, O_RDONLY | O_CLOEXEC);
+    if (hfd < 0) return -1;
+
+    struct dma_heap_allocation_data a;
+    memset(&a, 0, sizeof(a));
+    a.len      = len;
+    a.fd_flags = O_RDWR | O_CLOEXEC;
+
+    int r = xioctl(hfd, DMA_HEAP_IOCTL_ALLOC, &a);
+    int err = errno;
+    close(hfd);
+    if (r < 0) {
+        errno = err;
+        return -1;
+    }
+    return (int)a.fd;
+#else
+    (void)heap; (void)len;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
@@ -0,0 +1,59 @@
+/**
+ * @file dmabuf.h
+ * @brief dma-buf 辅助：显式缓存同步与 dma-heap 分配
+ *
+ * RK 平台上 V4L2 / dma-heap 的 CPU 映射经常是非缓存或写合并（write-combine）的，
+ * CPU 逐字节读这类映射只有 DRAM 带宽的几分之一。改为缓存映射后，
+ * CPU 访问必须用 DMA_BUF_IOCTL_SYNC 显式包围，由内核完成缓存失效 / 回写：
+ *
+ *   dmabuf_sync_begin(fd, DMABUF_SYNC_READ);
+ *   memcpy(dst, map, len);            // 读到的是设备刚写入的数据
+ *   dmabuf_sync_end(fd, DMABUF_SYNC_READ);
+ *
+ * 头文件不提供 dma-buf / dma-heap 接口（老内核头）时，函数返回 -1 且 errno = ENOSYS。
+ */
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** CPU 访问方向（可按位或） */
+#define DMABUF_SYNC_READ   0x1
+#define DMABUF_SYNC_WRITE  0x2
+
+/**
+ * @brief 开始 CPU 访问（DMA_BUF_IOCTL_SYNC | SYNC_START）
+ *
+ * 读方向会使 CPU 缓存中对应行失效，之后读到设备写入的最新数据。
+ *
+ * @param fd  dma-buf 文件描述符
+ * @param dir DMABUF_SYNC_READ / DMABUF_SYNC_WRITE 的组合
+ * @return int 0 成功，-1 失败（errno）
+ */
+int dmabuf_sync_begin(int fd, int dir);
+
+/**
+ * @brief 结束 CPU 访问（DMA_BUF_IOCTL_SYNC | SYNC_END）
+ *
+ * 写方向会把 CPU 缓存中的脏行回写，之后设备可见。
+ * 参数与返回值同 dmabuf_sync_begin()，dir 必须与 begin 一致。
+ */
+int dmabuf_sync_end(int fd, int dir);
+
+/**
+ * @brief 从 /dev/dma_heap/<heap> 分配一块 dma-buf
+ *
+ * 常见堆：system / cma（缓存映射），system-uncached / cma-uncached（arm64 上为写合并映射）。
+ *
+ * @param heap 堆名称
+ * @param len  字节数
+ * @return int dma-buf fd，-1 失败（堆不存在时 errno = ENOENT）
+ */
+int dmabuf_heap_alloc(const char *heap, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
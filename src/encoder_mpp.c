@@ -20,8 +20,11 @@
  * - ION 内存分配器
  */
 #include "encoder_mpp.h"
+#include "boot_trace.h"
 #include "log.h"
+#include "crc32c.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 /** 日志标签 */
@@ -84,19 +87,103 @@ int encoder_mpp_encode(EncoderMPP *enc,
     return -1;
 }
 
+int encoder_mpp_set_temporal_layers(EncoderMPP *enc, int layers)
+{
+    (void)enc;
+    (void)layers;
+    LOGE("[%s] MPP not available.", TAG);
+    return -1;
+}
+
+int encoder_mpp_set_smart_gop(EncoderMPP *enc, int idr_interval, int vi_interval, int bitrate_bps)
+{
+    (void)enc;
+    (void)idr_interval;
+    (void)vi_interval;
+    (void)bitrate_bps;
+    LOGE("[%s] MPP not available.", TAG);
+    return -1;
+}
+
+int encoder_mpp_set_low_latency(EncoderMPP *enc, int slices)
+{
+    (void)enc;
+    (void)slices;
+    LOGE("[%s] MPP not available.", TAG);
+    return -1;
+}
+
+int encoder_mpp_set_fps(EncoderMPP *enc, int fps, int bitrate_bps)
+{
+    (void)enc;
+    (void)fps;
+    (void)bitrate_bps;
+    LOGE("[%s] MPP not available.", TAG);
+    return -1;
+}
+
+int encoder_mpp_put_frame(EncoderMPP *enc, const uint8_t *frame_data, size_t frame_size,
+                          uint64_t pts_us)
+{
+    (void)enc;
+    (void)frame_data;
+    (void)frame_size;
+    (void)pts_us;
+    LOGE("[%s] MPP not available.", TAG);
+    return -1;
+}
+
+int encoder_mpp_put_repeat(EncoderMPP *enc, uint64_t pts_us)
+{
+    (void)enc;
+    (void)pts_us;
+    LOGE("[%s] MPP not available.", TAG);
+    return -1;
+}
+
+int encoder_mpp_get_slice(EncoderMPP *enc,
+                          uint8_t **out_data,
+                          size_t *out_size,
+                          bool *out_keyframe,
+                          uint32_t *out_crc,
+                          uint8_t *out_tlayer,
+                          bool *out_eoi)
+{
+    (void)enc;
+    if (out_data) *out_data = NULL;
+    if (out_size) *out_size = 0;
+    if (out_keyframe) *out_keyframe = false;
+    if (out_crc) *out_crc = 0;
+    if (out_tlayer) *out_tlayer = 0;
+    if (out_eoi) *out_eoi = true;
+    return -1;
+}
+
+int encoder_mpp_request_idr(EncoderMPP *enc)
+{
+    (void)enc;
+    return -1;
+}
+
 int encoder_mpp_encode_packet(EncoderMPP *enc,
                               const uint8_t *frame_data,
                               size_t frame_size,
+                              uint64_t pts_us,
                               uint8_t **out_data,
                               size_t *out_size,
-                              bool *out_keyframe)
+                              bool *out_keyframe,
+                              uint32_t *out_crc,
+                              uint8_t *out_tlayer)
 {
     (void)enc;
     (void)frame_data;
     (void)frame_size;
+    (void)pts_us;
     if (out_data) *out_data = NULL;
     if (out_size) *out_size = 0;
     if (out_keyframe) *out_keyframe = false;
+    if (out_crc) *out_crc = 0;
+    if (out_tlayer) *out_tlayer = 0;
     LOGE("[%s] MPP not available.", TAG);
     return -1;
 }
@@ -142,6 +229,7 @@ int encoder_mpp_init(EncoderMPP *enc,
     enc->width  = width;
     enc->height = height;
     enc->type   = type;
+    enc->tsvc_layers = 1;
 
     /* MPP 通常要求 stride 16 对齐（便于硬件处理）。 */
     enc->hor_stride = (width  + 15) & (~15);
@@ -150,12 +238,15 @@ int encoder_mpp_init(EncoderMPP *enc,
 
     MPP_RET ret;
 
+    boot_trace_begin(BOOT_MPP_CREATE);
     ret = mpp_create(&enc->ctx, &enc->mpi);
     if (ret) {
         LOGE("[%s] mpp_create failed: %d", TAG, ret);
         return -1;
     }
+    boot_trace_end(BOOT_MPP_CREATE);
 
+    boot_trace_begin(BOOT_MPP_INIT);
     ret = mpp_init(enc->ctx, MPP_CTX_ENC, type);
     if (ret) {
         LOGE("[%s] mpp_init failed: %d", TAG, ret);
@@ -187,7 +278,10 @@ int encoder_mpp_init(EncoderMPP *enc,
         return -1;
     }
 
+    boot_trace_end(BOOT_MPP_INIT);
+
     /* 获取编码器配置句柄。 */
+    boot_trace_begin(BOOT_MPP_CFG);
     MppEncCfg cfg = NULL;
 
     ret = mpp_enc_cfg_init(&cfg);
@@ -231,10 +325,212 @@ int encoder_mpp_init(EncoderMPP *enc,
         return -1;
     }
 
+    /* 每个 IDR 前都带 SPS/PPS：直播预览的新客户端从任意关键帧起播都能拿到参数集。 */
+    MppEncHeaderMode hdr_mode = MPP_ENC_HEADER_MODE_EACH_IDR;
+    ret = enc->mpi->control(enc->ctx, MPP_ENC_SET_HEADER_MODE, &hdr_mode);
+    if (ret)
+        LOGW("[%s] MPP_ENC_SET_HEADER_MODE failed: %d (SPS/PPS only in first packet)", TAG, ret);
+
+    boot_trace_end(BOOT_MPP_CFG);
     LOGI("[%s] init ok %dx%d fps=%d bitrate=%d", TAG, enc->width, enc->height, fps, bps);
     return 0;
 }
 
+/*
+ * 配置 SVC-T 分层参考结构（与 MPP mpi_enc_utils 中 tsvc2/3/4 示例同构，仅用短期参考）：
+ *
+ *   3 层（周期 4）：
+ *        /-> P1      /-> P3
+ *       /           /
+ *      //--------> P2
+ *     //
+ *    P0/---------------------> P4
+ *
+ * 周期内第 i 帧的层号 tid(i) 见 encoder_tsvc_layer_of()，参考的是最近一个更低层的帧
+ * （i 去掉最低位 1 后的位置），最高层帧标记为非参考帧。
+ * st_cfg 共 period+1 项：第 0 项是起始帧，之后 1..period 循环。
+ */
+int encoder_mpp_set_temporal_layers(EncoderMPP *enc, int layers)
+{
+    if (!enc || !enc->ctx || !enc->mpi) return -1;
+    if (layers < 1 || layers > ENC_MAX_TEMPORAL_LAYERS) {
+        LOGE("[%s] invalid temporal layers: %d", TAG, layers);
+        return -1;
+    }
+
+    enc->tsvc_layers = layers;
+    enc->tsvc_pos    = 0;
+    if (layers == 1) return 0;
+
+    int period = 1 << (layers - 1);
+    MppEncRefStFrmCfg st_ref[(1 << (ENC_MAX_TEMPORAL_LAYERS - 1)) + 1];
+    memset(st_ref, 0, sizeof(st_ref));
+    for (int i = 0; i <= period; i++) {
+        int tid = encoder_tsvc_layer_of(layers, (uint32_t)i);
+        int pos = i % period;
+        st_ref[i].is_non_ref  = (tid == layers - 1) ? 1 : 0;
+        st_ref[i].temporal_id = tid;
+        st_ref[i].ref_mode    = REF_TO_TEMPORAL_LAYER;
+        st_ref[i].ref_arg     = pos ? encoder_tsvc_layer_of(layers, (uint32_t)(pos & (pos - 1))) : 0;
+        st_ref[i].repeat      = 0;
+    }
+
+    MppEncRefCfg ref = NULL;
+    MPP_RET ret = mpp_enc_ref_cfg_init(&ref);
+    if (ret || !ref) {
+        LOGE("[%s] mpp_enc_ref_cfg_init failed: %d", TAG, ret);
+        enc->tsvc_layers = 1;
+        return -1;
+    }
+    ret = mpp_enc_ref_cfg_set_cfg_cnt(ref, 0, period + 1);
+    if (!ret) ret = mpp_enc_ref_cfg_add_st_cfg(ref, period + 1, st_ref);
+    /* 保留 CPB：高层帧回头参考的低层帧不能被编码器按滑动窗口提前淘汰 */
+    if (!ret) ret = mpp_enc_ref_cfg_set_keep_cpb(ref, 1);
+    if (!ret) ret = mpp_enc_ref_cfg_check(ref);
+    if (!ret) ret = enc->mpi->control(enc->ctx, MPP_ENC_SET_REF_CFG, ref);
+    mpp_enc_ref_cfg_deinit(&ref);
+
+    if (ret) {
+        LOGE("[%s] temporal layer config failed: %d", TAG, ret);
+        enc->tsvc_layers = 1;
+        return -1;
+    }
+
+    LOGI("[%s] SVC-T %d layers (period %d frames)", TAG, layers, period);
+    return 0;
+}
+
+/*
+ * 配置智能 GOP（与 MPP mpi_enc_utils 中 smart gop 示例同构）：
+ *
+ *   IDR(LTR) P P ... P VI P P ... P VI ...  IDR(LTR) ...
+ *   |<----- vi_interval ----->|
+ *   |<---------------- idr_interval ---------------->|
+ *
+ * - lt_cfg：只有 IDR 成为 LTR（lt_gap = 0，不周期刷新），任意虚拟 I 帧只依赖最近的 IDR
+ * - st_cfg[0]：起始帧；st_cfg[1]：参考前一帧，重复 vi_interval-1 次；st_cfg[2]：虚拟 I 帧，参考 LTR
+ * - 码控改为 AVBR：静止画面码率降到 bps_min，运动时回到目标码率
+ */
+int encoder_mpp_set_smart_gop(EncoderMPP *enc, int idr_interval, int vi_interval, int bitrate_bps)
+{
+    if (!enc || !enc->ctx || !enc->mpi) return -1;
+    if (vi_interval < 2 || idr_interval < vi_interval) {
+        LOGE("[%s] invalid smart gop: idr=%d vi=%d", TAG, idr_interval, vi_interval);
+        return -1;
+    }
+
+    MppEncCfg cfg = NULL;
+    MPP_RET ret = mpp_enc_cfg_init(&cfg);
+    if (ret || !cfg) {
+        LOGE("[%s] mpp_enc_cfg_init failed: %d", TAG, ret);
+        return -1;
+    }
+    ret = enc->mpi->control(enc->ctx, MPP_ENC_GET_CFG, cfg);
+    if (!ret) {
+        RK_S32 bps = (bitrate_bps > 0) ? bitrate_bps : (enc->width * enc->height * 5);
+        mpp_enc_cfg_set_s32(cfg, "rc:mode",     MPP_ENC_RC_MODE_AVBR);
+        mpp_enc_cfg_set_s32(cfg, "rc:bps_max",  bps * 17 / 16);
+        mpp_enc_cfg_set_s32(cfg, "rc:bps_min",  bps / 8);
+        mpp_enc_cfg_set_s32(cfg, "rc:gop",      idr_interval);
+        ret = enc->mpi->control(enc->ctx, MPP_ENC_SET_CFG, cfg);
+    }
+    mpp_enc_cfg_deinit(cfg);
+    if (ret) {
+        LOGE("[%s] smart gop rc config failed: %d", TAG, ret);
+        return -1;
+    }
+
+    MppEncRefLtFrmCfg lt_ref[1];
+    MppEncRefStFrmCfg st_ref[3];
+    memset(lt_ref, 0, sizeof(lt_ref));
+    memset(st_ref, 0, sizeof(st_ref));
+
+    lt_ref[0].lt_idx      = 0;
+    lt_ref[0].temporal_id = 0;
+    lt_ref[0].ref_mode    = REF_TO_PREV_LT_REF;
+    lt_ref[0].lt_gap      = 0;
+    lt_ref[0].lt_delay    = 0;
+
+    st_ref[0].ref_mode    = REF_TO_PREV_INTRA;
+    st_ref[1].ref_mode    = REF_TO_PREV_REF_FRM;
+    st_ref[1].repeat      = vi_interval - 2;
+    st_ref[2].ref_mode    = REF_TO_PREV_LT_REF;
+
+    MppEncRefCfg ref = NULL;
+    ret = mpp_enc_ref_cfg_init(&ref);
+    if (ret || !ref) {
+        LOGE("[%s] mpp_enc_ref_cfg_init failed: %d", TAG, ret);
+        return -1;
+    }
+    ret = mpp_enc_ref_cfg_set_cfg_cnt(ref, 1, 3);
+    if (!ret) ret = mpp_enc_ref_cfg_add_lt_cfg(ref, 1, lt_ref);
+    if (!ret) ret = mpp_enc_ref_cfg_add_st_cfg(ref, 3, st_ref);
+    if (!ret) ret = mpp_enc_ref_cfg_set_keep_cpb(ref, 1);
+    if (!ret) ret = mpp_enc_ref_cfg_check(ref);
+    if (!ret) ret = enc->mpi->control(enc->ctx, MPP_ENC_SET_REF_CFG, ref);
+    mpp_enc_ref_cfg_deinit(&ref);
+
+    if (ret) {
+        LOGE("[%s] smart gop ref config failed: %d", TAG, ret);
+        return -1;
+    }
+
+    enc->smart_gop = true;
+    LOGI("[%s] smart gop: idr every %d frames, virtual I every %d frames", TAG,
+         idr_interval, vi_interval);
+    return 0;
+}
+
+/*
+ * 运行中切换帧率：GET_CFG 取回当前配置，只改 rc 中与帧率相关的字段再 SET_CFG，
+ * 码控模式（CBR / 智能 GOP 的 AVBR）保持不变。
+ */
+int encoder_mpp_set_fps(EncoderMPP *enc, int fps, int bitrate_bps)
+{
+    if (!enc || !enc->ctx || !enc->mpi || fps <= 0) return -1;
+
+    MppEncCfg cfg = NULL;
+    MPP_RET ret = mpp_enc_cfg_init(&cfg);
+    if (ret || !cfg) {
+        LOGE("[%s] mpp_enc_cfg_init failed: %d", TAG, ret);
+        return -1;
+    }
+    RK_S32 bps = (bitrate_bps > 0) ? bitrate_bps : (enc->width * enc->height * 5);
+    ret = enc->mpi->control(enc->ctx, MPP_ENC_GET_CFG, cfg);
+    if (!ret) {
+        mpp_enc_cfg_set_s32(cfg, "rc:fps_in_flex",   0);
+        mpp_enc_cfg_set_s32(cfg, "rc:fps_in_num",    fps);
+        mpp_enc_cfg_set_s32(cfg, "rc:fps_in_denorm", 1);
+        mpp_enc_cfg_set_s32(cfg, "rc:fps_out_num",   fps);
+        mpp_enc_cfg_set_s32(cfg, "rc:fps_out_denorm",1);
+        mpp_enc_cfg_set_s32(cfg, "rc:bps_target",    bps);
+        mpp_enc_cfg_set_s32(cfg, "rc:bps_max",       bps * 17 / 16);
+        mpp_enc_cfg_set_s32(cfg, "rc:bps_min",       enc->smart_gop ? bps / 8 : bps * 15 / 16);
+        if (!enc->smart_gop)
+            mpp_enc_cfg_set_s32(cfg, "rc:gop",       fps * 2);
+        ret = enc->mpi->control(enc->ctx, MPP_ENC_SET_CFG, cfg);
+    }
+    mpp_enc_cfg_deinit(cfg);
+    if (ret) {
+        LOGE("[%s] fps switch to %d failed: %d", TAG, fps, ret);
+        return -1;
+    }
+    LOGI("[%s] rate control now %d fps, %d bps", TAG, fps, bps);
+    return 0;
+}
+
+/* 下一帧编成 IDR（编码线程调用，与 encode_packet 串行） */
+int encoder_mpp_request_idr(EncoderMPP *enc)
+{
+    if (!enc || !enc->ctx || !enc->mpi) return -1;
+    MPP_RET ret = enc->mpi->control(enc->ctx, MPP_ENC_SET_IDR_FRAME, NULL);
+    if (ret) {
+        LOGW("[%s] MPP_ENC_SET_IDR_FRAME failed: %d", TAG, ret);
+        return -1;
+    }
+    return 0;
+}
+
 /*
  * 编码一帧 NV12 数据：
  * 1) 将输入 frame_data 复制到 MPP buffer（不足则补 0）
@@ -325,6 +621,109 @@ int encoder_mpp_encode(EncoderMPP *enc,
     return 0;
 }
 
+/*
+ * 拷贝输入到 MPP buffer（不足补 0），构造 MppFrame 并投递给编码器。
+ * frame_data 为 NULL 时不拷贝，frm_buf 中的上一帧原样重投，并标记为 P_Skip。
+ * pts_us 同时作为帧的 PTS / DTS 交给编码器，由编码器在重排序时改写输出包的 DTS。
+ */
+static int enc_put_frame(EncoderMPP *enc, const uint8_t *frame_data, size_t frame_size,
+                         uint64_t pts_us)
+{
+    if (frame_data) {
+        void  *dst = mpp_buffer_get_ptr(enc->frm_buf);
+        size_t copy_size = frame_size > enc->frame_size ? enc->frame_size : frame_size;
+        memcpy(dst, frame_data, copy_size);
+        if (copy_size < enc->frame_size)
+            memset((uint8_t *)dst + copy_size, 0, enc->frame_size - copy_size);
+    }
+
+    MppFrame frame = NULL;
+    MPP_RET ret = mpp_frame_init(&frame);
+    if (ret) {
+        LOGE("[%s] mpp_frame_init failed: %d", TAG, ret);
+        return -1;
+    }
+
+    mpp_frame_set_width(frame, enc->width);
+    mpp_frame_set_height(frame, enc->height);
+    mpp_frame_set_hor_stride(frame, enc->hor_stride);
+    mpp_frame_set_ver_stride(frame, enc->ver_stride);
+    mpp_frame_set_fmt(frame, ENC_INPUT_FMT);
+    mpp_frame_set_buffer(frame, enc->frm_buf);
+    mpp_frame_set_eos(frame, 0);
+    mpp_frame_set_pts(frame, (RK_S64)pts_us);
+    mpp_frame_set_dts(frame, (RK_S64)pts_us);
+    if (!frame_data) {
+        /* 输入与参考帧完全相同，即使编码器忽略该 meta，RDO 也会把宏块全选为跳过 */
+        MppMeta meta = mpp_frame_get_meta(frame);
+        if (meta) mpp_meta_set_s32(meta, KEY_INPUT_PSKIP, 1);
+    }
+
+    ret = enc->mpi->encode_put_frame(enc->ctx, frame);
+    mpp_frame_deinit(&frame);
+    if (ret) {
+        LOGE("[%s] encode_put_frame failed: %d", TAG, ret);
+        return -1;
+    }
+    enc->has_input = true;
+    enc->in_pts_us = pts_us;
+    return 0;
+}
+
+/*
+ * 每帧调用一次：判断是否为关键帧、确定时间层，并取回该帧的 PTS / DTS。
+ * packet 不带 PTS（旧版 MPP）时按最近投递的帧兜底；DTS 缺失或晚于 PTS 时取 PTS，且保证单调不减。
+ */
+static void enc_frame_info(EncoderMPP *enc, MppPacket pkt, bool *key_out, int *tid_out)
+{
+    RK_S64 pts = mpp_packet_get_pts(pkt);
+    RK_S64 dts = mpp_packet_get_dts(pkt);
+    uint64_t pts_us = pts > 0 ? (uint64_t)pts : enc->in_pts_us;
+    uint64_t dts_us = (dts > 0 && (uint64_t)dts <= pts_us) ? (uint64_t)dts : pts_us;
+    if (dts_us < enc->last_dts_us) dts_us = enc->last_dts_us;
+    enc->frame_pts_us = pts_us;
+    enc->frame_dts_us = dts_us;
+    enc->last_dts_us  = dts_us;
+
+    /* 检测是否为关键帧（I 帧） */
+    bool key = false;
+#ifdef MPP_PACKET_FLAG_INTRA
+    RK_U32 flag = mpp_packet_get_flag(pkt);
+    if (flag & MPP_PACKET_FLAG_INTRA) key = true;
+#endif
+
+    /* 时间层：优先取 MPP 写入的 packet meta，取不到时按分层周期位置推算（IDR 处周期归零） */
+    int tid = 0;
+    if (enc->tsvc_layers > 1) {
+        if (key) enc->tsvc_pos = 0;
+        tid = encoder_tsvc_layer_of(enc->tsvc_layers, enc->tsvc_pos);
+        MppMeta meta = mpp_packet_get_meta(pkt);
+        RK_S32 meta_tid = 0;
+        if (meta && mpp_meta_get_s32(meta, KEY_TEMPORAL_ID, &meta_tid) == MPP_OK &&
+            meta_tid >= 0 && meta_tid < enc->tsvc_layers)
+            tid = meta_tid;
+        enc->tsvc_pos++;
+    }
+    *key_out = key;
+    *tid_out = tid;
+}
+
+/* 拷出 packet 数据（拷贝与 CRC32C 融合，数据只读一遍）；空 packet 时 *out_data 为 NULL */
+static int enc_copy_packet(MppPacket pkt, uint8_t **out_data, size_t *out_size, uint32_t *out_crc)
+{
+    void  *ptr = mpp_packet_get_pos(pkt);
+    size_t len = mpp_packet_get_length(pkt);
+    if (!ptr || len == 0 || !out_data) return 0;
+
+    uint8_t *cpy = (uint8_t *)malloc(len);
+    if (!cpy) return -1;
+    uint32_t crc = crc32c_copy(0, cpy, ptr, len);
+    *out_data = cpy;
+    if (out_size) *out_size = len;
+    if (out_crc) *out_crc = crc;
+    return 0;
+}
+
 /**
  * @brief 编码一帧并返回数据包
  *
@@ -334,6 +733,7 @@ int encoder_mpp_encode(EncoderMPP *enc,
  * @param enc          编码器实例
  * @param frame_data   输入帧数据（NV12 格式）
  * @param frame_size   输入帧大小
+ * @param pts_us       输入帧 PTS（随帧穿过编码器，输出包的 PTS / DTS 见 enc->frame_pts_us / frame_dts_us）
  * @param out_data     输出：编码后数据指针（需要 free）
  * @param out_size     输出：编码后数据大小
  * @param out_keyframe 输出：是否为关键帧（I 帧）
@@ -342,13 +742,18 @@ int encoder_mpp_encode(EncoderMPP *enc,
 int encoder_mpp_encode_packet(EncoderMPP *enc,
                               const uint8_t *frame_data,
                               size_t frame_size,
+                              uint64_t pts_us,
                               uint8_t **out_data,
                               size_t *out_size,
-                              bool *out_keyframe)
+                              bool *out_keyframe,
+                              uint32_t *out_crc,
+                              uint8_t *out_tlayer)
 {
     if (out_data) *out_data = NULL;
     if (out_size) *out_size = 0;
     if (out_keyframe) *out_keyframe = false;
+    if (out_crc) *out_crc = 0;
+    if (out_tlayer) *out_tlayer = 0;
 
     if (!enc || !enc->ctx || !enc->mpi || !enc->frm_buf) {
         LOGE("[%s] encoder_mpp_encode_packet: invalid encoder", TAG);
@@ -359,39 +764,13 @@ int encoder_mpp_encode_packet(EncoderMPP *enc,
         return -1;
     }
 
-    /* 步骤 1：将输入数据拷贝到 MPP 输入缓冲 */
-    void  *dst = mpp_buffer_get_ptr(enc->frm_buf);
-    size_t copy_size = frame_size > enc->frame_size ? enc->frame_size : frame_size;
-    memcpy(dst, frame_data, copy_size);
-    if (copy_size < enc->frame_size)
-        memset((uint8_t *)dst + copy_size, 0, enc->frame_size - copy_size);
-
-    /* 步骤 2：构建 MppFrame 并投递给编码器 */
-    MppFrame frame = NULL;
-    MPP_RET ret = mpp_frame_init(&frame);
-    if (ret) {
-        LOGE("[%s] mpp_frame_init failed: %d", TAG, ret);
-        return -1;
-    }
-
-    mpp_frame_set_width(frame, enc->width);
-    mpp_frame_set_height(frame, enc->height);
-    mpp_frame_set_hor_stride(frame, enc->hor_stride);
-    mpp_frame_set_ver_stride(frame, enc->ver_stride);
-    mpp_frame_set_fmt(frame, ENC_INPUT_FMT);
-    mpp_frame_set_buffer(frame, enc->frm_buf);
-    mpp_frame_set_eos(frame, 0);
-
-    ret = enc->mpi->encode_put_frame(enc->ctx, frame);
-    mpp_frame_deinit(&frame);
-    if (ret) {
-        LOGE("[%s] encode_put_frame failed: %d", TAG, ret);
+    /* 步骤 1/2：拷贝输入并投递给编码器 */
+    if (enc_put_frame(enc, frame_data, frame_size, pts_us) != 0)
         return -1;
-    }
 
     /* 步骤 3：获取编码输出包 */
     MppPacket pkt = NULL;
-    ret = enc->mpi->encode_get_packet(enc->ctx, &pkt);
+    MPP_RET ret = enc->mpi->encode_get_packet(enc->ctx, &pkt);
     if (ret) {
         /* 暂时没有输出 packet，正常情况 */
         return 0;
@@ -400,35 +779,126 @@ int encoder_mpp_encode_packet(EncoderMPP *enc,
     if (!pkt)
         return 0;
 
-    void  *ptr = mpp_packet_get_pos(pkt);
-    size_t len = mpp_packet_get_length(pkt);
+    bool key;
+    int  tid;
+    enc_frame_info(enc, pkt, &key, &tid);
 
-    /* 检测是否为关键帧（I 帧） */
-    bool key = false;
-#ifdef MPP_PACKET_FLAG_INTRA
-    RK_U32 flag = mpp_packet_get_flag(pkt);
-    if (flag & MPP_PACKET_FLAG_INTRA) key = true;
-#else
-    (void)key; /* 无法判断时默认 false */
-#endif
-
-    /* 分配内存并拷贝编码结果 */
-    if (ptr && len > 0 && out_data) {
-        uint8_t *cpy = (uint8_t *)malloc(len);
-        if (!cpy) {
-            mpp_packet_deinit(&pkt);
-            return -1;
-        }
-        memcpy(cpy, ptr, len);
-        *out_data = cpy;
-        if (out_size) *out_size = len;
+    if (enc_copy_packet(pkt, out_data, out_size, out_crc) != 0) {
+        mpp_packet_deinit(&pkt);
+        return -1;
+    }
+    if (out_data && *out_data) {
         if (out_keyframe) *out_keyframe = key;
+        if (out_tlayer) *out_tlayer = (uint8_t)tid;
     }
 
     mpp_packet_deinit(&pkt);
     return 0;
 }
 
+/*
+ * 低延迟输出：split:mode = BY_CTU 按宏块数切 slice，split:out = LOWDELAY 让每个 slice
+ * 编完即可由 encode_get_packet 取出（packet 带 partition 标记，最后一片带 eoi）。
+ */
+int encoder_mpp_set_low_latency(EncoderMPP *enc, int slices)
+{
+    if (!enc || !enc->ctx || !enc->mpi) return -1;
+    if (slices < 1 || slices > ENC_MAX_SLICES) {
+        LOGE("[%s] invalid slice count: %d", TAG, slices);
+        return -1;
+    }
+
+    int mb_w = (enc->width + 15) / 16;
+    int mb_h = (enc->height + 15) / 16;
+    int rows = (mb_h + slices - 1) / slices;    /* 按整行切，slice 边界与行对齐 */
+
+    MppEncCfg cfg = NULL;
+    MPP_RET ret = mpp_enc_cfg_init(&cfg);
+    if (ret || !cfg) {
+        LOGE("[%s] mpp_enc_cfg_init failed: %d", TAG, ret);
+        return -1;
+    }
+    ret = enc->mpi->control(enc->ctx, MPP_ENC_GET_CFG, cfg);
+    if (!ret) {
+        mpp_enc_cfg_set_u32(cfg, "split:mode", slices > 1 ? MPP_ENC_SPLIT_BY_CTU : MPP_ENC_SPLIT_NONE);
+        mpp_enc_cfg_set_u32(cfg, "split:arg",  (RK_U32)(rows * mb_w));
+        mpp_enc_cfg_set_u32(cfg, "split:out",  MPP_ENC_SPLIT_OUT_LOWDELAY);
+        ret = enc->mpi->control(enc->ctx, MPP_ENC_SET_CFG, cfg);
+    }
+    mpp_enc_cfg_deinit(cfg);
+    if (ret) {
+        LOGE("[%s] low latency split config failed: %d", TAG, ret);
+        return -1;
+    }
+
+    enc->low_delay = true;
+    enc->in_frame  = false;
+    LOGI("[%s] low latency: %d slices/frame (%d MB rows each)", TAG, slices, rows);
+    return 0;
+}
+
+int encoder_mpp_put_frame(EncoderMPP *enc, const uint8_t *frame_data, size_t frame_size,
+                          uint64_t pts_us)
+{
+    if (!enc || !enc->ctx || !enc->mpi || !enc->frm_buf || !frame_data || frame_size == 0) {
+        LOGE("[%s] encoder_mpp_put_frame: invalid args", TAG);
+        return -1;
+    }
+    enc->in_frame = false;
+    return enc_put_frame(enc, frame_data, frame_size, pts_us);
+}
+
+int encoder_mpp_put_repeat(EncoderMPP *enc, uint64_t pts_us)
+{
+    if (!enc || !enc->ctx || !enc->mpi || !enc->frm_buf || !enc->has_input) {
+        LOGE("[%s] encoder_mpp_put_repeat: no previous frame", TAG);
+        return -1;
+    }
+    enc->in_frame = false;
+    return enc_put_frame(enc, NULL, 0, pts_us);
+}
+
+int encoder_mpp_get_slice(EncoderMPP *enc,
+                          uint8_t **out_data,
+                          size_t *out_size,
+                          bool *out_keyframe,
+                          uint32_t *out_crc,
+                          uint8_t *out_tlayer,
+                          bool *out_eoi)
+{
+    if (out_data) *out_data = NULL;
+    if (out_size) *out_size = 0;
+    if (out_crc) *out_crc = 0;
+    if (out_eoi) *out_eoi = true;
+    if (!enc || !enc->ctx || !enc->mpi) return -1;
+
+    MppPacket pkt = NULL;
+    MPP_RET ret = enc->mpi->encode_get_packet(enc->ctx, &pkt);
+    if (ret || !pkt) {
+        enc->in_frame = false;
+        return 0;
+    }
+
+    /* 首片决定整帧的关键帧 / 时间层属性 */
+    if (!enc->in_frame) {
+        enc_frame_info(enc, pkt, &enc->frame_key, &enc->frame_tid);
+        enc->in_frame = true;
+    }
+    bool eoi = !enc->low_delay || !mpp_packet_is_partition(pkt) || mpp_packet_is_eoi(pkt);
+
+    if (enc_copy_packet(pkt, out_data, out_size, out_crc) != 0) {
+        mpp_packet_deinit(&pkt);
+        return -1;
+    }
+    mpp_packet_deinit(&pkt);
+
+    if (out_keyframe) *out_keyframe = enc->frame_key;
+    if (out_tlayer) *out_tlayer = (uint8_t)enc->frame_tid;
+    if (out_eoi) *out_eoi = eoi;
+    if (eoi) enc->in_frame = false;
+    return 1;
+}
+
 /*
  * 释放编码器资源：buffer、buffer group、MPP ctx，并将 enc 清零。
  */
@@ -53,8 +53,26 @@ typedef struct {
     int            ver_stride;    /**< 垂直步长（16 对齐后） */
     size_t         frame_size;    /**< 帧大小 */
     MppCodingType  type;          /**< 编码类型 */
+    int            tsvc_layers;   /**< 时间层数（1 = 不分层） */
+    uint32_t       tsvc_pos;      /**< 当前包在分层周期中的位置（IDR 处归零） */
+    bool           low_delay;     /**< 是否按 slice 低延迟输出 */
+    bool           frame_key;     /**< 低延迟输出时当前帧是否为 IDR（首片决定） */
+    int            frame_tid;     /**< 低延迟输出时当前帧的时间层（首片决定） */
+    bool           in_frame;      /**< 低延迟输出时是否处于一帧的中间 */
+    bool           has_input;     /**< frm_buf 中是否已有一帧输入（可供重复） */
+    bool           smart_gop;     /**< 已配置智能 GOP（gop 由参考结构决定，切换帧率时不改） */
+    uint64_t       in_pts_us;     /**< 最近投递帧的 PTS（packet 不带 PTS 时兜底） */
+    uint64_t       frame_pts_us;  /**< 最近取出帧的 PTS（随 MppFrame -> MppPacket 穿过编码器） */
+    uint64_t       frame_dts_us;  /**< 最近取出帧的 DTS（编码器重排序时 <= PTS，否则等于 PTS） */
+    uint64_t       last_dts_us;   /**< 上一帧 DTS，保证 DTS 单调不减 */
 } EncoderMPP;
 
+/** 低延迟模式下每帧最多的 slice 数 */
+#define ENC_MAX_SLICES  16
+
+/** 支持的最大时间层数（周期 2^(n-1) 帧） */
+#define ENC_MAX_TEMPORAL_LAYERS  4
+
 /** 初始化 MPP 编码器 */
 int encoder_mpp_init(EncoderMPP *enc,
                      int width, int height,
@@ -69,13 +87,124 @@ int encoder_mpp_encode(EncoderMPP *enc,
                        EncSink *sink,
                        size_t *out_bytes);
 
-/** 编码一帧并返回数据包（调用者负责 free） */
+/**
+ * @brief 配置分层时间参考结构（SVC-T），须在 init 之后、第一帧之前调用
+ *
+ * n 层时周期为 2^(n-1) 帧，例如 3 层：L0 L2 L1 L2 | L0 ...
+ * 最高层帧不被参考，丢掉任意“最高若干层”后剩余码流仍可正常解码，帧率逐级减半。
+ *
+ * @param enc    编码器实例
+ * @param layers 时间层数 1..ENC_MAX_TEMPORAL_LAYERS（1 表示普通 IPPP）
+ * @return int   0 成功，-1 失败
+ */
+int encoder_mpp_set_temporal_layers(EncoderMPP *enc, int layers);
+
+/**
+ * @brief 配置智能 GOP（长期参考帧 + 虚拟 I 帧），须在 init 之后、第一帧之前调用
+ *
+ * IDR 间隔拉长到 idr_interval，IDR 作为长期参考帧；每 vi_interval 帧一个只参考 LTR 的
+ * 虚拟 I 帧，随机访问只需 LTR + 虚拟 I 帧。码控切换为 AVBR，静止画面自动降码率。
+ * 与 encoder_mpp_set_temporal_layers() 互斥（两者都配置参考结构）。
+ *
+ * @param enc          编码器实例
+ * @param idr_interval IDR 间隔（帧）
+ * @param vi_interval  虚拟 I 帧间隔（帧，>= 2）
+ * @param bitrate_bps  目标码率（<=0 则按分辨率估算，与 init 一致）
+ * @return int         0 成功，-1 失败
+ */
+int encoder_mpp_set_smart_gop(EncoderMPP *enc, int idr_interval, int vi_interval, int bitrate_bps);
+
+/**
+ * @brief 开启低延迟 slice 输出，须在 init 之后、第一帧之前调用
+ *
+ * 每帧按宏块行均分为 slices 个 slice（split:mode = BY_CTU），并开启 low-delay 输出：
+ * 编码器每完成一个 slice 即可取出，无需等整帧编完。之后用
+ * encoder_mpp_put_frame() + encoder_mpp_get_slice() 代替 encoder_mpp_encode_packet()。
+ *
+ * @param enc    编码器实例
+ * @param slices 每帧 slice 数 1..ENC_MAX_SLICES
+ * @return int   0 成功，-1 失败
+ */
+int encoder_mpp_set_low_latency(EncoderMPP *enc, int slices);
+
+/**
+ * @brief 运行中切换帧率（编码线程调用，与编码串行）
+ *
+ * 同步更新码控的 fps_in / fps_out 与目标码率（调用方按帧率等比缩放，保持每帧比特数），
+ * 固定 GOP 时 gop 同步改为 fps*2（保持 2 秒）；智能 GOP 的参考结构不变。
+ * 已在编码器中的帧不受影响，从下一帧起生效。
+ *
+ * @param enc         编码器实例
+ * @param fps         新帧率（> 0）
+ * @param bitrate_bps 新目标码率（<=0 则按分辨率估算，与 init 一致）
+ * @return int        0 成功，-1 失败
+ */
+int encoder_mpp_set_fps(EncoderMPP *enc, int fps, int bitrate_bps);
+
+/**
+ * 投递一帧 NV12 给编码器（低延迟模式），随后循环 encoder_mpp_get_slice() 直到 eoi。
+ * pts_us 经 mpp_frame_set_pts 随帧进入编码器，输出时从 packet 取回（见 frame_pts_us / frame_dts_us）。
+ */
+int encoder_mpp_put_frame(EncoderMPP *enc, const uint8_t *frame_data, size_t frame_size,
+                          uint64_t pts_us);
+
+/**
+ * @brief 重复上一帧（CFR 补帧），随后同样循环 encoder_mpp_get_slice() 直到 eoi
+ *
+ * 不拷贝、不重新采集：输入缓冲 frm_buf 仍是上一帧内容，原样再投递一次，并通过帧 meta
+ * KEY_INPUT_PSKIP 要求编码器输出全跳过（P_Skip）帧，码流只增加几十字节。
+ * 整帧模式与低延迟模式均可用；尚未投递过任何帧时返回 -1。
+ */
+int encoder_mpp_put_repeat(EncoderMPP *enc, uint64_t pts_us);
+
+/**
+ * @brief 取出当前帧的下一个 slice（低延迟模式，阻塞到该 slice 编完）
+ *
+ * out_keyframe / out_tlayer 对同一帧的所有 slice 相同（取自首片），
+ * 该帧的 PTS / DTS 同样由首片决定，取完后见 enc->frame_pts_us / enc->frame_dts_us。
+ *
+ * @param out_eoi 是否为该帧最后一个 slice
+ * @return int    1 取到，0 本帧没有更多输出，-1 失败
+ */
+int encoder_mpp_get_slice(EncoderMPP *enc,
+                          uint8_t **out_data,
+                          size_t *out_size,
+                          bool *out_keyframe,
+                          uint32_t *out_crc,
+                          uint8_t *out_tlayer,
+                          bool *out_eoi);
+
+/** 请求下一帧编成 IDR（场景切换 / 下游按需），只能在编码线程调用 */
+int encoder_mpp_request_idr(EncoderMPP *enc);
+
+/**
+ * 编码一帧并返回数据包（调用者负责 free）；拷出数据时顺带计算 CRC32C（out_crc 可为 NULL），
+ * out_tlayer 返回该包的时间层 ID（可为 NULL）。
+ * 返回的包不一定是本次投递的帧（编码器有多帧在途时），其 PTS / DTS 见 enc->frame_pts_us / frame_dts_us。
+ */
 int encoder_mpp_encode_packet(EncoderMPP *enc,
                               const uint8_t *frame_data,
                               size_t frame_size,
+                              uint64_t pts_us,
                               uint8_t **out_data,
                               size_t *out_size,
-                              bool *out_keyframe);
+                              bool *out_keyframe,
+                              uint32_t *out_crc,
+                              uint8_t *out_tlayer);
+
+/**
+ * @brief 按分层周期位置计算时间层 ID
+ *
+ * 周期内第 pos 帧：pos 为 0 时属于 L0，否则层号 = layers-1-ctz(pos)。
+ */
+static inline int encoder_tsvc_layer_of(int layers, uint32_t pos)
+{
+    if (layers <= 1) return 0;
+    uint32_t period = 1u << (layers - 1);
+    pos %= period;
+    if (pos == 0) return 0;
+    return layers - 1 - __builtin_ctz(pos);
+}
 
 /** 释放编码器资源 */
 void encoder_mpp_deinit(EncoderMPP *enc);
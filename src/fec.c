@@ -0,0 +1,291 @@
+/**
+ * @file fec.c
+ * @brief XOR / Reed-Solomon 块编解码实现
+ *
+ * GF(256) 乘加 dst ^= c · src：c 固定时乘法对字节是线性的，
+ * c · b = c · (b & 0x0f) ^ c · (b & 0xf0)，两张 16 项表（lo / hi）即可覆盖，
+ * 向量实现用一次表查找指令处理 16 字节的低 / 高 4 bit。表在每次调用时由对数表生成（32 次查表），
+ * 相对一个 RTP 包（~1KB）的处理量可忽略。对数 / 指数表在首次使用时生成（pthread_once）。
+ *
+ * 解码：缺失 e 个媒体符号时取 e 个收到的修复行，先从修复符号中减去（异或掉）已收到媒体符号的贡献，
+ * 再用 e×e 系数子矩阵的逆（Gauss-Jordan）组合出缺失符号。每个内核都是“向量主循环 + 标量尾部”。
+ */
+#include "fec.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#  include <arm_neon.h>
+#  define FEC_NEON 1
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#  define FEC_SSE2 1
+#  if defined(__SSSE3__)
+#    include <tmmintrin.h>
+#    define FEC_SSSE3 1
+#  endif
+#endif
+
+/** GF(256) 本原多项式 x^8 + x^4 + x^3 + x^2 + 1 */
+#define GF_POLY  0x11d
+
+static uint8_t        s_exp[512];
+static uint8_t        s_log[256];
+static pthread_once_t s_gf_once = PTHREAD_ONCE_INIT;
+
+static void gf_init(void)
+{
+    unsigned x = 1;
+    for (int i = 0; i < 255; i++) {
+        s_exp[i] = (uint8_t)x;
+        s_log[x] = (uint8_t)i;
+        x <<= 1;
+        if (x & 0x100) x ^= GF_POLY;
+    }
+    /* 指数表复制一遍，log(a) + log(b) 不必取模 */
+    for (int i = 255; i < 512; i++)
+        s_exp[i] = s_exp[i - 255];
+}
+
+uint8_t fec_gf_mul(uint8_t a, uint8_t b)
+{
+    pthread_once(&s_gf_once, gf_init);
+    if (!a || !b) return 0;
+    return s_exp[s_log[a] + s_log[b]];
+}
+
+uint8_t fec_gf_inv(uint8_t a)
+{
+    pthread_once(&s_gf_once, gf_init);
+    return a ? s_exp[255 - s_log[a]] : 0;
+}
+
+/* ============================================================================
+ * 内核
+ * ============================================================================ */
+
+void fec_xor(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    size_t i = 0;
+#if defined(FEC_NEON)
+    for (; i + 32 <= len; i += 32) {
+        vst1q_u8(dst + i,      veorq_u8(vld1q_u8(dst + i),      vld1q_u8(src + i)));
+        vst1q_u8(dst + i + 16, veorq_u8(vld1q_u8(dst + i + 16), vld1q_u8(src + i + 16)));
+    }
+#elif defined(FEC_SSE2)
+    for (; i + 32 <= len; i += 32) {
+        __m128i a0 = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i a1 = _mm_loadu_si128((const __m128i *)(dst + i + 16));
+        __m128i b0 = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i b1 = _mm_loadu_si128((const __m128i *)(src + i + 16));
+        _mm_storeu_si128((__m128i *)(dst + i),      _mm_xor_si128(a0, b0));
+        _mm_storeu_si128((__m128i *)(dst + i + 16), _mm_xor_si128(a1, b1));
+    }
+#endif
+    for (; i + 8 <= len; i += 8) {
+        uint64_t a, b;
+        memcpy(&a, dst + i, 8);
+        memcpy(&b, src + i, 8);
+        a ^= b;
+        memcpy(dst + i, &a, 8);
+    }
+    for (; i < len; i++)
+        dst[i] ^= src[i];
+}
+
+void fec_gf_mul_add_portable(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len)
+{
+    pthread_once(&s_gf_once, gf_init);
+    if (c == 0) return;
+    if (c == 1) {
+        for (size_t i = 0; i < len; i++) dst[i] ^= src[i];
+        return;
+    }
+    unsigned lc = s_log[c];
+    for (size_t i = 0; i < len; i++) {
+        if (src[i]) dst[i] ^= s_exp[lc + s_log[src[i]]];
+    }
+}
+
+void fec_gf_mul_add(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len)
+{
+    if (c == 0) return;
+    if (c == 1) {
+        fec_xor(dst, src, len);
+        return;
+    }
+#if defined(FEC_NEON) || defined(FEC_SSSE3)
+    uint8_t lo[16], hi[16];
+    for (int x = 0; x < 16; x++) {
+        lo[x] = fec_gf_mul(c, (uint8_t)x);
+        hi[x] = fec_gf_mul(c, (uint8_t)(x << 4));
+    }
+    size_t i = 0;
+#  if defined(FEC_NEON)
+    const uint8x16_t tlo = vld1q_u8(lo), thi = vld1q_u8(hi), mask = vdupq_n_u8(0x0f);
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t s = vld1q_u8(src + i);
+        uint8x16_t p = veorq_u8(vqtbl1q_u8(tlo, vandq_u8(s, mask)), vqtbl1q_u8(thi, vshrq_n_u8(s, 4)));
+        vst1q_u8(dst + i, veorq_u8(vld1q_u8(dst + i), p));
+    }
+#  else
+    const __m128i tlo  = _mm_loadu_si128((const __m128i *)lo);
+    const __m128i thi  = _mm_loadu_si128((const __m128i *)hi);
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    for (; i + 16 <= len; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i p = _mm_xor_si128(_mm_shuffle_epi8(tlo, _mm_and_si128(s, mask)),
+                                  _mm_shuffle_epi8(thi, _mm_and_si128(_mm_srli_epi64(s, 4), mask)));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(d, p));
+    }
+#  endif
+    for (; i < len; i++)
+        dst[i] ^= lo[src[i] & 0x0f] ^ hi[src[i] >> 4];
+#else
+    fec_gf_mul_add_portable(dst, src, c, len);
+#endif
+}
+
+/* ============================================================================
+ * 块编解码
+ * ============================================================================ */
+
+uint8_t fec_rs_coef(int k, int j, int i)
+{
+    return fec_gf_inv((uint8_t)((k + j) ^ i));
+}
+
+static bool params_ok(FecScheme s, int k, int m)
+{
+    if (k < 1 || k > FEC_MAX_K) return false;
+    if (s == FEC_XOR) return m == 1;
+    if (s == FEC_RS)  return m >= 1 && m <= FEC_MAX_M;
+    return false;
+}
+
+int fec_encode(FecScheme s, int k, int m, const uint8_t *const *data, uint8_t *const *parity,
+               size_t len)
+{
+    if (!params_ok(s, k, m) || !data || !parity) return -1;
+
+    for (int j = 0; j < m; j++) {
+        memset(parity[j], 0, len);
+        for (int i = 0; i < k; i++) {
+            if (s == FEC_XOR) fec_xor(parity[j], data[i], len);
+            else              fec_gf_mul_add(parity[j], data[i], fec_rs_coef(k, j, i), len);
+        }
+    }
+    return 0;
+}
+
+/* n×n 矩阵求逆（Gauss-Jordan，原地），奇异返回 -1 */
+static int gf_invert(uint8_t a[FEC_MAX_M][FEC_MAX_M], uint8_t inv[FEC_MAX_M][FEC_MAX_M], int n)
+{
+    for (int r = 0; r < n; r++) {
+        memset(inv[r], 0, (size_t)n);
+        inv[r][r] = 1;
+    }
+    for (int c = 0; c < n; c++) {
+        int p = c;
+        while (p < n && a[p][c] == 0) p++;
+        if (p == n) return -1;
+        if (p != c) {
+            uint8_t t[FEC_MAX_M];
+            memcpy(t, a[p], (size_t)n);   memcpy(a[p], a[c], (size_t)n);   memcpy(a[c], t, (size_t)n);
+            memcpy(t, inv[p], (size_t)n); memcpy(inv[p], inv[c], (size_t)n); memcpy(inv[c], t, (size_t)n);
+        }
+        uint8_t f = fec_gf_inv(a[c][c]);
+        for (int x = 0; x < n; x++) {
+            a[c][x]   = fec_gf_mul(a[c][x], f);
+            inv[c][x] = fec_gf_mul(inv[c][x], f);
+        }
+        for (int r = 0; r < n; r++) {
+            if (r == c || a[r][c] == 0) continue;
+            uint8_t g = a[r][c];
+            for (int x = 0; x < n; x++) {
+                a[r][x]   ^= fec_gf_mul(g, a[c][x]);
+                inv[r][x] ^= fec_gf_mul(g, inv[c][x]);
+            }
+        }
+    }
+    return 0;
+}
+
+int fec_decode(FecScheme s, int k, int m, uint8_t *const *data, const bool *have,
+               uint8_t *const *parity, const bool *phave, size_t len)
+{
+    if (!params_ok(s, k, m) || !data || !have || !parity || !phave) return -1;
+
+    int miss[FEC_MAX_M], rows[FEC_MAX_M];
+    int ne = 0, nr = 0;
+    for (int i = 0; i < k; i++) {
+        if (have[i]) continue;
+        if (ne == m) return -1;
+        miss[ne++] = i;
+    }
+    if (ne == 0) return 0;
+    for (int j = 0; j < m && nr < ne; j++)
+        if (phave[j]) rows[nr++] = j;
+    if (nr < ne) return -1;
+
+    /* 修复符号减去已收到媒体符号的贡献，只剩缺失符号的线性组合 */
+    for (int r = 0; r < ne; r++) {
+        for (int i = 0; i < k; i++) {
+            if (!have[i]) continue;
+            if (s == FEC_XOR) fec_xor(parity[rows[r]], data[i], len);
+            else              fec_gf_mul_add(parity[rows[r]], data[i], fec_rs_coef(k, rows[r], i), len);
+        }
+    }
+    if (s == FEC_XOR) {
+        memcpy(data[miss[0]], parity[rows[0]], len);
+        return 1;
+    }
+
+    uint8_t a[FEC_MAX_M][FEC_MAX_M], inv[FEC_MAX_M][FEC_MAX_M];
+    for (int r = 0; r < ne; r++)
+        for (int c = 0; c < ne; c++)
+            a[r][c] = fec_rs_coef(k, rows[r], miss[c]);
+    if (gf_invert(a, inv, ne) != 0) return -1;
+
+    for (int c = 0; c < ne; c++) {
+        memset(data[miss[c]], 0, len);
+        for (int r = 0; r < ne; r++)
+            fec_gf_mul_add(data[miss[c]], parity[rows[r]], inv[c][r], len);
+    }
+    return ne;
+}
+
+const char *fec_impl_name(void)
+{
+#if defined(FEC_NEON)
+    return "neon";
+#elif defined(FEC_SSSE3)
+    return "ssse3";
+#elif defined(FEC_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+const char *fec_scheme_name(FecScheme s)
+{
+    switch (s) {
+    case FEC_NONE: return "off";
+    case FEC_XOR:  return "xor";
+    case FEC_RS:   return "rs";
+    default:       return "?";
+    }
+}
+
+int fec_parse_scheme(const char *name, FecScheme *s)
+{
+    if (!name || !s) return -1;
+    if (strcmp(name, "off") == 0)      *s = FEC_NONE;
+    else if (strcmp(name, "xor") == 0) *s = FEC_XOR;
+    else if (strcmp(name, "rs") == 0)  *s = FEC_RS;
+    else return -1;
+    return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file fec.h
+ * @brief 前向纠错（FEC）块编解码：XOR 奇偶校验与 GF(256) Reed-Solomon
+ *
+ * 用于 RTP 输出（见 rtp.h）：无线链路丢包时，重传的往返延迟对实时预览来说太长，
+ * 发送端为每组 k 个媒体包附加 m 个修复包，接收端收到任意 k 个即可还原整组。
+ *
+ * - XOR：m = 1，修复符号为各媒体符号按字节异或（ULPFEC / FlexFEC 的单行保护），每组恢复 1 个丢包
+ * - RS：系统码，修复行系数取 Cauchy 矩阵 1 / (x_j ^ y_i)（x_j = k + j，y_i = i），
+ *   任意 k 行可逆，每组最多恢复 m 个丢包（需 k + m <= 256）
+ *
+ * 符号长度相同（调用方把较短的媒体符号补零到组内最长）。
+ * 内核：GF(256) 乘加用 4 bit 拆分查表（NEON vqtbl1q / SSSE3 pshufb，一次 16 字节），
+ * XOR 用 NEON / SSE2 整寄存器异或；其余情况回退对数表 / 64 位字实现。
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 每组最多媒体符号数 */
+#define FEC_MAX_K  48
+
+/** 每组最多修复符号数 */
+#define FEC_MAX_M  16
+
+/**
+ * @brief 纠错方式
+ */
+typedef enum {
+    FEC_NONE = 0,
+    FEC_XOR  = 1,       /**< 单个异或修复符号 */
+    FEC_RS   = 2,       /**< Reed-Solomon（Cauchy），m 个修复符号 */
+} FecScheme;
+
+/** GF(256) 乘法（本原多项式 0x11d） */
+uint8_t fec_gf_mul(uint8_t a, uint8_t b);
+
+/** GF(256) 乘法逆元（a != 0） */
+uint8_t fec_gf_inv(uint8_t a);
+
+/** dst ^= src */
+void fec_xor(uint8_t *dst, const uint8_t *src, size_t len);
+
+/** dst ^= c · src（GF(256)） */
+void fec_gf_mul_add(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len);
+
+/** 对数表实现的乘加（用于自检与基准对比） */
+void fec_gf_mul_add_portable(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len);
+
+/** RS 修复行 j 对媒体符号 i 的系数 */
+uint8_t fec_rs_coef(int k, int j, int i);
+
+/**
+ * @brief 编码一组
+ *
+ * @param k       媒体符号数（1 ~ FEC_MAX_K）
+ * @param m       修复符号数（XOR 必须为 1；RS 为 1 ~ FEC_MAX_M）
+ * @param data    k 个媒体符号
+ * @param parity  输出：m 个修复符号
+ * @param len     符号长度
+ * @return int 0 成功，-1 参数错误
+ */
+int  fec_encode(FecScheme s, int k, int m, const uint8_t *const *data, uint8_t *const *parity,
+                size_t len);
+
+/**
+ * @brief 还原一组中缺失的媒体符号
+ *
+ * 收到的修复符号缓冲会被改写（用作中间结果）。
+ *
+ * @param data    k 个媒体符号缓冲（缺失的位置写入还原结果）
+ * @param have    k 个标志：媒体符号是否收到
+ * @param parity  m 个修复符号缓冲
+ * @param phave   m 个标志：修复符号是否收到
+ * @return int 还原的符号数（0 表示无缺失），-1 收到的符号不足或参数错误
+ */
+int  fec_decode(FecScheme s, int k, int m, uint8_t *const *data, const bool *have,
+                uint8_t *const *parity, const bool *phave, size_t len);
+
+/** 当前编译进来的内核名称："neon" / "ssse3" / "sse2" / "scalar" */
+const char *fec_impl_name(void);
+
+/** 纠错方式名称 */
+const char *fec_scheme_name(FecScheme s);
+
+/** 解析纠错方式（off / xor / rs），失败返回 -1 */
+int  fec_parse_scheme(const char *name, FecScheme *s);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,67 @@
+/**
+ * @file frame_pacer.c
+ * @brief 恒定帧率（CFR）节拍器实现
+ */
+#include "frame_pacer.h"
+
+void frame_pacer_init(FramePacer *p, int fps)
+{
+    if (!p) return;
+    p->fps       = fps > 0 ? fps : 30;
+    p->started   = false;
+    p->base_us   = 0;
+    p->next_slot = 0;
+    p->repeated  = 0;
+    p->dropped   = 0;
+    p->resyncs   = 0;
+}
+
+void frame_pacer_set_fps(FramePacer *p, int fps)
+{
+    if (!p || fps <= 0 || fps == p->fps) return;
+    if (p->started) {
+        p->base_us   = frame_pacer_slot_pts(p, p->next_slot - 1);
+        p->next_slot = 1;
+    }
+    p->fps = fps;
+}
+
+uint64_t frame_pacer_slot_pts(const FramePacer *p, uint64_t slot)
+{
+    return p->base_us + slot * 1000000ull / (uint64_t)p->fps;
+}
+
+bool frame_pacer_place(FramePacer *p, uint64_t pts_us, uint64_t *slot, uint32_t *fill)
+{
+    *fill = 0;
+    if (!p->started) {
+        p->started   = true;
+        p->base_us   = pts_us;
+        p->next_slot = 1;
+        *slot = 0;
+        return true;
+    }
+
+    /* 四舍五入到最近的槽位：半个帧周期以内的抖动不改变槽位 */
+    uint64_t k = 0;
+    if (pts_us > p->base_us)
+        k = ((pts_us - p->base_us) * (uint64_t)p->fps + 500000ull) / 1000000ull;
+
+    if (k < p->next_slot) {
+        p->dropped++;
+        return false;
+    }
+
+    uint64_t gap = k - p->next_slot;
+    if (gap > (uint64_t)p->fps * FRAME_PACER_MAX_FILL_SEC) {
+        /* 采集中断：PTS 跟随真实时间跳过空缺（仍在网格上），不补帧 */
+        p->resyncs++;
+        gap = 0;
+    }
+
+    *slot = k;
+    *fill = (uint32_t)gap;
+    p->repeated += gap;
+    p->next_slot = k + 1;
+    return true;
+}
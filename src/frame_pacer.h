@@ -0,0 +1,71 @@
+/**
+ * @file frame_pacer.h
+ * @brief 恒定帧率（CFR）节拍器头文件
+ *
+ * 采集时间戳随驱动调度抖动（video_delta 在 32.6 ~ 34.0ms 之间），偶有 sequence 跳变，
+ * 直接编码得到的是可变帧率码流。本模块把每帧的采集 PTS 吸附到严格的 1/fps 网格上：
+ *
+ *   slot(k) = base + k * 1000000 / fps        （整数计算，不累积误差）
+ *
+ * - 采集 PTS 四舍五入到最近的槽位；该槽位之前空出的槽位由编码器重复上一帧填补
+ * - 槽位已被占用（采集比标称帧率快）的帧直接丢弃
+ * - 空缺超过 FRAME_PACER_MAX_FILL_SEC 秒（采集停顿）不再填补，网格整体跳过，保持与音频的对齐
+ *
+ * 节拍器只做判定，不持有帧；由编码线程在取帧后、编码前调用（见 main.c）。
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 单次最多填补的时长（秒），超过则视为采集中断，网格跳过空缺 */
+#define FRAME_PACER_MAX_FILL_SEC  1
+
+/**
+ * @brief 节拍器状态
+ */
+typedef struct {
+    int      fps;           /**< 目标帧率 */
+    bool     started;       /**< 是否已由首帧确定网格起点 */
+    uint64_t base_us;       /**< 网格起点（首帧采集 PTS） */
+    uint64_t next_slot;     /**< 下一个待填的槽位号 */
+    uint64_t repeated;      /**< 累计重复填补的槽位数 */
+    uint64_t dropped;       /**< 累计丢弃的重复帧数 */
+    uint64_t resyncs;       /**< 累计跳过空缺（采集中断）次数 */
+} FramePacer;
+
+/** 初始化（fps <= 0 时按 30） */
+void frame_pacer_init(FramePacer *p, int fps);
+
+/**
+ * @brief 运行中切换帧率
+ *
+ * 新网格从最后一个已占用槽位起算：已分配的 PTS 不变，之后的槽位按新周期排列，
+ * 切换点前后不会出现重复或倒退的 PTS。
+ */
+void frame_pacer_set_fps(FramePacer *p, int fps);
+
+/** 槽位 slot 的网格 PTS（微秒） */
+uint64_t frame_pacer_slot_pts(const FramePacer *p, uint64_t slot);
+
+/**
+ * @brief 为一帧分配槽位
+ *
+ * 返回 true 时，槽位 [*slot - *fill, *slot) 应先各重复一次上一帧，再以
+ * frame_pacer_slot_pts(p, *slot) 作为本帧 PTS 编码。
+ *
+ * @param p       节拍器
+ * @param pts_us  采集 PTS（微秒）
+ * @param slot    输出：本帧槽位号
+ * @param fill    输出：本帧之前需要重复填补的槽位数
+ * @return true   保留本帧；false 表示槽位已被占用，应丢弃（已计入 dropped）
+ */
+bool frame_pacer_place(FramePacer *p, uint64_t pts_us, uint64_t *slot, uint32_t *fill);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,442 @@
+/**
+ * @file frame_stats.c
+ * @brief 帧统计阶段实现
+ *
+ * 每个采样行做两遍：
+ * - fs_row()：一次读入本行及上下两行，同时累加像素和、平方和与拉普拉斯平方和（向量主循环 + 标量尾部）
+ * - fs_hist_row()：4 份子表交错累加直方图，相邻像素落在同一档时不会串行等待同一计数器
+ */
+#include "frame_stats.h"
+#include "log.h"
+
+#include "rkav/time.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#  include <arm_neon.h>
+#  define FS_NEON 1
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#  define FS_SSE2 1
+#endif
+
+/** 模块日志标签 */
+#define TAG "fstats"
+
+/** 低于该亮度计为暗部像素 */
+#define FS_DARK_Y       32
+
+/** 不低于该亮度计为饱和像素 */
+#define FS_CLIP_Y       248
+
+/** 均值低于该值判为过暗 */
+#define FS_DARK_MEAN    28.0
+
+/** 饱和像素占比超过该值判为过曝 */
+#define FS_CLIP_RATIO   0.25
+
+/** 标准差低于该值判为低对比度（镜头被挡、起雾、对着墙） */
+#define FS_FLAT_STD     6.0
+
+/** 清晰度低于基线的该比例判为失焦 */
+#define FS_BLUR_RATIO   0.5
+
+/** 基线低于该值（纹理太少）时不做失焦判断 */
+#define FS_SHARP_MIN    2.0
+
+/** 直方图距离超过该值判为画面突变 */
+#define FS_CHANGE_MAX   0.4
+
+/** 向量 32 位累加器每多少次迭代归约一次（防止溢出） */
+#define FS_FLUSH        128
+
+/** 一行的累加结果 */
+typedef struct {
+    uint64_t sum;   /**< 像素和 */
+    uint64_t sq;    /**< 像素平方和 */
+    uint64_t lap;   /**< 拉普拉斯平方和 */
+} FsRowAcc;
+
+static const char *const g_check_names[FS_NCHECKS] = {
+    "dark", "overexposed", "flat", "blur", "changed",
+};
+
+const char *frame_stats_flag_name(uint16_t flag)
+{
+    for (int i = 0; i < FS_NCHECKS; i++)
+        if (flag == (uint16_t)(RKAV_IMG_F_DARK << i)) return g_check_names[i];
+    return "none";
+}
+
+int frame_stats_init(FrameStats *fs, int fps)
+{
+    if (!fs) return -1;
+    memset(fs, 0, sizeof(*fs));
+    fs->fps       = fps > 0 ? fps : 30;
+    fs->budget_px = FS_BUDGET_PX;
+    fs->hold      = fs->fps * FS_HOLD_SEC;
+    fs->adopt     = fs->fps * FS_ADOPT_SEC;
+    fs->alpha     = 1.0 / (double)(fs->fps * FS_REF_SEC);
+    if (pthread_mutex_init(&fs->mtx, NULL) != 0) return -1;
+    LOGI("[%s] budget=%u px/frame hold=%ds adopt=%ds", TAG, fs->budget_px, FS_HOLD_SEC, FS_ADOPT_SEC);
+    return 0;
+}
+
+/* ============================================================================
+ * 向量内核
+ * ============================================================================ */
+
+/* 行 c 的像素和、平方和（x ∈ [0, w)）与拉普拉斯平方和（x ∈ [1, w-1)），up / dn 为上下两行 */
+static void fs_row(const uint8_t *up, const uint8_t *c, const uint8_t *dn, int w, FsRowAcc *a)
+{
+    uint64_t sum = c[0], sq = (uint64_t)c[0] * c[0], lap = 0;
+    int x = 1;
+#if FS_NEON
+    while (x + 16 <= w - 1) {
+        uint32x4_t vs = vdupq_n_u32(0), vq = vdupq_n_u32(0);
+        int32x4_t  vl = vdupq_n_s32(0);
+        for (int k = 0; k < FS_FLUSH && x + 16 <= w - 1; k++, x += 16) {
+            uint8x16_t cc = vld1q_u8(c + x);
+            uint8x16_t l  = vld1q_u8(c + x - 1), r = vld1q_u8(c + x + 1);
+            uint8x16_t u  = vld1q_u8(up + x),    d = vld1q_u8(dn + x);
+            vs = vpadalq_u16(vs, vpaddlq_u8(cc));
+            vq = vpadalq_u16(vq, vmull_u8(vget_low_u8(cc), vget_low_u8(cc)));
+            vq = vpadalq_u16(vq, vmull_high_u8(cc, cc));
+            uint16x8_t n0 = vaddq_u16(vaddl_u8(vget_low_u8(l), vget_low_u8(r)),
+                                      vaddl_u8(vget_low_u8(u), vget_low_u8(d)));
+            uint16x8_t n1 = vaddq_u16(vaddl_high_u8(l, r), vaddl_high_u8(u, d));
+            int16x8_t l0 = vreinterpretq_s16_u16(vsubq_u16(vshll_n_u8(vget_low_u8(cc), 2), n0));
+            int16x8_t l1 = vreinterpretq_s16_u16(vsubq_u16(vshll_high_n_u8(cc, 2), n1));
+            vl = vmlal_s16(vl, vget_low_s16(l0), vget_low_s16(l0));
+            vl = vmlal_high_s16(vl, l0, l0);
+            vl = vmlal_s16(vl, vget_low_s16(l1), vget_low_s16(l1));
+            vl = vmlal_high_s16(vl, l1, l1);
+        }
+        sum += vaddvq_u32(vs);
+        sq  += vaddvq_u32(vq);
+        lap += vaddvq_u32(vreinterpretq_u32_s32(vl));
+    }
+#elif FS_SSE2
+    const __m128i z = _mm_setzero_si128();
+    while (x + 16 <= w - 1) {
+        __m128i vs = z, vq = z, vl = z;
+        for (int k = 0; k < FS_FLUSH && x + 16 <= w - 1; k++, x += 16) {
+            __m128i cc = _mm_loadu_si128((const __m128i *)(c + x));
+            __m128i l  = _mm_loadu_si128((const __m128i *)(c + x - 1));
+            __m128i r  = _mm_loadu_si128((const __m128i *)(c + x + 1));
+            __m128i u  = _mm_loadu_si128((const __m128i *)(up + x));
+            __m128i d  = _mm_loadu_si128((const __m128i *)(dn + x));
+            vs = _mm_add_epi64(vs, _mm_sad_epu8(cc, z));
+            __m128i c0 = _mm_unpacklo_epi8(cc, z), c1 = _mm_unpackhi_epi8(cc, z);
+            vq = _mm_add_epi32(vq, _mm_madd_epi16(c0, c0));
+            vq = _mm_add_epi32(vq, _mm_madd_epi16(c1, c1));
+            __m128i n0 = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(l, z), _mm_unpacklo_epi8(r, z)),
+                                       _mm_add_epi16(_mm_unpacklo_epi8(u, z), _mm_unpacklo_epi8(d, z)));
+            __m128i n1 = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(l, z), _mm_unpackhi_epi8(r, z)),
+                                       _mm_add_epi16(_mm_unpackhi_epi8(u, z), _mm_unpackhi_epi8(d, z)));
+            __m128i l0 = _mm_sub_epi16(_mm_slli_epi16(c0, 2), n0);
+            __m128i l1 = _mm_sub_epi16(_mm_slli_epi16(c1, 2), n1);
+            vl = _mm_add_epi32(vl, _mm_madd_epi16(l0, l0));
+            vl = _mm_add_epi32(vl, _mm_madd_epi16(l1, l1));
+        }
+        sum += (uint64_t)_mm_cvtsi128_si32(vs) + (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(vs, 8));
+        vq = _mm_add_epi32(vq, _mm_srli_si128(vq, 8));
+        vq = _mm_add_epi32(vq, _mm_srli_si128(vq, 4));
+        sq += (uint32_t)_mm_cvtsi128_si32(vq);
+        vl = _mm_add_epi32(vl, _mm_srli_si128(vl, 8));
+        vl = _mm_add_epi32(vl, _mm_srli_si128(vl, 4));
+        lap += (uint32_t)_mm_cvtsi128_si32(vl);
+    }
+#endif
+    for (; x < w - 1; x++) {
+        int v = c[x];
+        int e = 4 * v - c[x - 1] - c[x + 1] - up[x] - dn[x];
+        sum += (uint64_t)v;
+        sq  += (uint64_t)(v * v);
+        lap += (uint64_t)(e * e);
+    }
+    sum += c[w - 1];
+    sq  += (uint64_t)c[w - 1] * c[w - 1];
+
+    a->sum += sum;
+    a->sq  += sq;
+    a->lap += lap;
+}
+
+static void fs_hist_row(uint32_t sub[4][256], const uint8_t *c, int w)
+{
+    int x = 0;
+    for (; x + 4 <= w; x += 4) {
+        sub[0][c[x]]++;
+        sub[1][c[x + 1]]++;
+        sub[2][c[x + 2]]++;
+        sub[3][c[x + 3]]++;
+    }
+    for (; x < w; x++) sub[0][c[x]]++;
+}
+
+/* ============================================================================
+ * 分析与告警
+ * ============================================================================ */
+
+/* 各判断的去抖：连续成立 hold 帧置位告警，连续不成立 hold 帧解除；返回本帧新触发的告警 */
+static uint16_t fs_update_alarms(FrameStats *fs, const FrameStatsSnap *s)
+{
+    uint16_t raised = 0;
+    for (int i = 0; i < FS_NCHECKS; i++) {
+        uint16_t bit = (uint16_t)(RKAV_IMG_F_DARK << i);
+        if (s->flags & bit) {
+            fs->on_run[i]++;
+            fs->off_run[i] = 0;
+            if (!(fs->alarms & bit) && fs->on_run[i] >= fs->hold) {
+                fs->alarms |= bit;
+                raised |= bit;
+                LOGW("[%s] alarm %s: mean=%.1f std=%.1f clip=%.1f%% sharp=%.2f/%.2f change=%.2f",
+                     TAG, g_check_names[i], s->mean, s->stddev, s->clip_ratio * 100.0,
+                     s->sharpness, s->sharp_base, s->change);
+            }
+        } else {
+            fs->off_run[i]++;
+            fs->on_run[i] = 0;
+            if ((fs->alarms & bit) && fs->off_run[i] >= fs->hold) {
+                fs->alarms &= (uint16_t)~bit;
+                LOGI("[%s] alarm %s cleared", TAG, g_check_names[i]);
+            }
+        }
+    }
+    return raised;
+}
+
+/* 参考直方图与清晰度基线：正常时慢速跟随，突变时冻结，突变持续 adopt 帧后整体替换 */
+static void fs_update_baseline(FrameStats *fs, const double *p, const FrameStatsSnap *s)
+{
+    const int ci = 4, bi = 3;   /* CHANGED / BLUR 在 on_run 中的下标 */
+
+    if (!fs->have_ref) {
+        memcpy(fs->ref, p, sizeof(fs->ref));
+        fs->have_ref = true;
+    } else if (!(s->flags & RKAV_IMG_F_CHANGED)) {
+        for (int i = 0; i < FS_HIST_BINS; i++) fs->ref[i] += (p[i] - fs->ref[i]) * fs->alpha;
+    } else if (fs->on_run[ci] == fs->adopt) {
+        memcpy(fs->ref, p, sizeof(fs->ref));
+        LOGI("[%s] scene changed for %ds, re-learning reference", TAG, FS_ADOPT_SEC);
+    }
+
+    if (!(s->flags & (RKAV_IMG_F_BLUR | RKAV_IMG_F_FLAT | RKAV_IMG_F_DARK))) {
+        fs->sharp_base = fs->sharp_base > 0.0
+                       ? fs->sharp_base + (s->sharpness - fs->sharp_base) * fs->alpha
+                       : s->sharpness;
+    } else if ((s->flags & RKAV_IMG_F_BLUR) && fs->on_run[bi] == fs->adopt) {
+        fs->sharp_base = s->sharpness;
+        LOGI("[%s] sharpness low for %ds, re-learning baseline", TAG, FS_ADOPT_SEC);
+    }
+}
+
+void frame_stats_process(FrameStats *fs, VideoFrame *vf)
+{
+    if (!fs || !vf || !vf->data || vf->w < 3 || vf->h < 3) return;
+    uint64_t t0 = rkav_now_monotonic_ns();
+
+    int    w      = vf->w, h = vf->h;
+    size_t stride = (size_t)(vf->stride > 0 ? vf->stride : w);
+
+    /* 行步长：采样量不超过预算；首行偏移半个步长，避开第 0 行（拉普拉斯需要上下邻行） */
+    uint64_t px   = (uint64_t)w * (uint64_t)h;
+    uint32_t step = (uint32_t)((px + fs->budget_px - 1) / (fs->budget_px ? fs->budget_px : 1));
+    if (step < 1) step = 1;
+    int y0 = (int)(step / 2) > 0 ? (int)(step / 2) : 1;
+
+    memset(fs->sub, 0, sizeof(fs->sub));
+    FsRowAcc acc = { 0, 0, 0 };
+    uint32_t rows = 0;
+    for (int y = y0; y < h - 1; y += (int)step) {
+        const uint8_t *c = vf->data + (size_t)y * stride;
+        fs_row(c - stride, c, c + stride, w, &acc);
+        fs_hist_row(fs->sub, c, w);
+        rows++;
+    }
+    if (rows == 0) return;
+
+    FrameStatsSnap s;
+    memset(&s, 0, sizeof(s));
+    s.frame_id = vf->frame_id;
+    s.pts_us   = vf->pts_us;
+    s.samples  = rows * (uint32_t)w;
+    s.row_step = step;
+
+    uint32_t dark = 0, clip = 0;
+    for (int v = 0; v < 256; v++) {
+        uint32_t n = fs->sub[0][v] + fs->sub[1][v] + fs->sub[2][v] + fs->sub[3][v];
+        s.hist[v >> 2] += n;
+        if (v < FS_DARK_Y) dark += n;
+        if (v >= FS_CLIP_Y) clip += n;
+    }
+    double n  = (double)s.samples;
+    s.mean       = (double)acc.sum / n;
+    s.stddev     = sqrt(fmax(0.0, (double)acc.sq / n - s.mean * s.mean));
+    s.dark_ratio = dark / n;
+    s.clip_ratio = clip / n;
+    s.sharpness  = sqrt((double)acc.lap / ((double)rows * (double)(w - 2)));
+    s.sharp_base = fs->sharp_base;
+
+    double p[FS_HIST_BINS], dist = 0.0;
+    for (int i = 0; i < FS_HIST_BINS; i++) {
+        p[i] = s.hist[i] / n;
+        if (fs->have_ref) dist += fabs(p[i] - fs->ref[i]);
+    }
+    s.change = dist * 0.5;
+
+    /* 即时判断；基线需要约 1 秒积累后才判断失焦 / 突变 */
+    bool warm = fs->frames >= (uint64_t)fs->fps;
+    s.flags = RKAV_IMG_F_VALID;
+    if (s.mean < FS_DARK_MEAN)      s.flags |= RKAV_IMG_F_DARK;
+    if (s.clip_ratio > FS_CLIP_RATIO) s.flags |= RKAV_IMG_F_OVEREXP;
+    if (s.stddev < FS_FLAT_STD)     s.flags |= RKAV_IMG_F_FLAT;
+    if (warm && fs->sharp_base >= FS_SHARP_MIN && s.sharpness < fs->sharp_base * FS_BLUR_RATIO)
+        s.flags |= RKAV_IMG_F_BLUR;
+    if (warm && s.change > FS_CHANGE_MAX)
+        s.flags |= RKAV_IMG_F_CHANGED;
+
+    uint16_t raised = fs_update_alarms(fs, &s);
+    fs_update_baseline(fs, p, &s);
+    s.alarms = fs->alarms;
+    fs->frames++;
+
+    /* 帧元数据 */
+    vf->img.flags     = s.flags;
+    vf->img.alarms    = s.alarms;
+    vf->img.mean      = (uint8_t)lrint(s.mean);
+    vf->img.stddev    = (uint8_t)lrint(fmin(s.stddev, 255.0));
+    vf->img.change    = (uint16_t)lrint(s.change * 1000.0);
+    vf->img.sharpness = (uint16_t)lrint(fmin(s.sharpness * 16.0, 65535.0));
+
+    uint64_t dt = rkav_now_monotonic_ns() - t0;
+    pthread_mutex_lock(&fs->mtx);
+    fs->last = s;
+    fs->win_frames++;
+    fs->win_ns   += dt;
+    fs->total_ns += dt;
+    if (dt > fs->win_max_ns) fs->win_max_ns = dt;
+    for (int i = 0; i < FS_NCHECKS; i++)
+        if (raised & (RKAV_IMG_F_DARK << i)) fs->raised[i]++;
+    pthread_mutex_unlock(&fs->mtx);
+}
+
+void frame_stats_get(FrameStats *fs, FrameStatsSnap *out)
+{
+    if (!fs || !out) return;
+    pthread_mutex_lock(&fs->mtx);
+    *out = fs->last;
+    pthread_mutex_unlock(&fs->mtx);
+}
+
+/* 把告警位列成 "blur,changed"；无告警为 "none" */
+static void fs_alarm_list(uint16_t alarms, char *buf, size_t cap)
+{
+    size_t off = 0;
+    buf[0] = '\0';
+    for (int i = 0; i < FS_NCHECKS && off < cap; i++) {
+        if (!(alarms & (RKAV_IMG_F_DARK << i))) continue;
+        int n = snprintf(buf + off, cap - off, "%s%s", off ? "," : "", g_check_names[i]);
+        if (n < 0) break;
+        off += (size_t)n;
+    }
+    if (buf[0] == '\0') snprintf(buf, cap, "none");
+}
+
+void frame_stats_tick_print(FrameStats *fs)
+{
+    if (!fs) return;
+
+    pthread_mutex_lock(&fs->mtx);
+    FrameStatsSnap s = fs->last;
+    uint64_t frames = fs->win_frames, ns = fs->win_ns, max_ns = fs->win_max_ns;
+    fs->win_frames = fs->win_ns = fs->win_max_ns = 0;
+    pthread_mutex_unlock(&fs->mtx);
+    if (!(s.flags & RKAV_IMG_F_VALID)) return;
+
+    char alarms[64];
+    fs_alarm_list(s.alarms, alarms, sizeof(alarms));
+    LOGI("[IMG] mean=%.1f std=%.1f dark=%.1f%% clip=%.1f%% sharp=%.2f/%.2f change=%.2f alarms=%s "
+         "frames=%llu avg=%.3fms max=%.3fms",
+         s.mean, s.stddev, s.dark_ratio * 100.0, s.clip_ratio * 100.0, s.sharpness, s.sharp_base,
+         s.change, alarms, (unsigned long long)frames,
+         frames ? (double)ns / (double)frames / 1e6 : 0.0, (double)max_ns / 1e6);
+}
+
+static size_t fmt_append(char *buf, size_t cap, size_t off, const char *fmt, ...)
+{
+    if (off + 1 >= cap) return off;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf + off, cap - off, fmt, ap);
+    va_end(ap);
+    if (n < 0) return off;
+    off += (size_t)n;
+    return off < cap ? off : cap - 1;
+}
+
+size_t frame_stats_format(FrameStats *fs, char *buf, size_t cap)
+{
+    if (!fs || !buf || cap == 0) return 0;
+    buf[0] = '\0';
+
+    pthread_mutex_lock(&fs->mtx);
+    FrameStatsSnap s = fs->last;
+    uint64_t raised[FS_NCHECKS];
+    memcpy(raised, fs->raised, sizeof(raised));
+    uint64_t total_ns = fs->total_ns;
+    pthread_mutex_unlock(&fs->mtx);
+
+    size_t o = 0;
+    o = fmt_append(buf, cap, o,
+                   "# TYPE rkav_image_luma_mean gauge\n"
+                   "rkav_image_luma_mean %.2f\n"
+                   "# TYPE rkav_image_luma_stddev gauge\n"
+                   "rkav_image_luma_stddev %.2f\n"
+                   "# TYPE rkav_image_dark_ratio gauge\n"
+                   "rkav_image_dark_ratio %.4f\n"
+                   "# TYPE rkav_image_clipped_ratio gauge\n"
+                   "rkav_image_clipped_ratio %.4f\n"
+                   "# TYPE rkav_image_sharpness gauge\n"
+                   "rkav_image_sharpness %.3f\n"
+                   "# TYPE rkav_image_sharpness_baseline gauge\n"
+                   "rkav_image_sharpness_baseline %.3f\n"
+                   "# TYPE rkav_image_change_ratio gauge\n"
+                   "rkav_image_change_ratio %.4f\n"
+                   "# TYPE rkav_image_analysis_seconds_total counter\n"
+                   "rkav_image_analysis_seconds_total %.6f\n",
+                   s.mean, s.stddev, s.dark_ratio, s.clip_ratio, s.sharpness, s.sharp_base,
+                   s.change, (double)total_ns / 1e9);
+
+    /* 直方图按 16 档输出占比，够看出曝光分布又不至于让抓取正文过长 */
+    o = fmt_append(buf, cap, o, "# TYPE rkav_image_luma_share gauge\n");
+    for (int b = 0; b < 16; b++) {
+        uint32_t n = 0;
+        for (int i = 0; i < FS_HIST_BINS / 16; i++) n += s.hist[b * (FS_HIST_BINS / 16) + i];
+        o = fmt_append(buf, cap, o, "rkav_image_luma_share{bin=\"%d-%d\"} %.4f\n",
+                       b * 16, b * 16 + 15, s.samples ? (double)n / s.samples : 0.0);
+    }
+
+    o = fmt_append(buf, cap, o,
+                   "# TYPE rkav_image_alarm gauge\n"
+                   "# TYPE rkav_image_alarms_total counter\n");
+    for (int i = 0; i < FS_NCHECKS; i++) {
+        o = fmt_append(buf, cap, o,
+                       "rkav_image_alarm{kind=\"%s\"} %d\n"
+                       "rkav_image_alarms_total{kind=\"%s\"} %llu\n",
+                       g_check_names[i], (s.alarms & (RKAV_IMG_F_DARK << i)) ? 1 : 0,
+                       g_check_names[i], (unsigned long long)raised[i]);
+    }
+    return o;
+}
+
+void frame_stats_deinit(FrameStats *fs)
+{
+    if (!fs) return;
+    pthread_mutex_destroy(&fs->mtx);
+}
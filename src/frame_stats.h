@@ -0,0 +1,146 @@
+/**
+ * @file frame_stats.h
+ * @brief 帧统计阶段头文件：亮度直方图、曝光与清晰度评分、遮挡 / 篡改检测
+ *
+ * 编码线程每帧送编码器前对 Y 平面做一次只读分析：
+ * - 亮度直方图、均值、标准差，暗部 / 饱和像素占比（曝光）
+ * - 清晰度：4 邻域拉普拉斯响应的 RMS（失焦、镜头脏污或起雾时明显下降）
+ * - 变化量：当前直方图与参考直方图的距离（半 L1，0-1）；参考为数秒时间常数的 EWMA，
+ *   光照缓慢变化会被跟上，镜头被遮挡、转动、喷涂时突变
+ *
+ * 固定预算：行步长按 FS_BUDGET_PX 选取（1080p 每 16 行取 1 行，约 13 万像素），
+ * 采样量与分辨率无关；均值 / 平方和 / 拉普拉斯为 NEON / SSE2 单遍，直方图为 4 份子表标量累加。
+ *
+ * 判断与告警：
+ * - 每帧即时判断写入 VideoFrame::img.flags，连续成立 FS_HOLD_SEC 后成为告警（LOGW 一次），
+ *   连续不成立同样时长后解除；告警状态写入 VideoFrame::img.alarms
+ * - 变化 / 失焦持续 FS_ADOPT_SEC 视为新常态（摄像头被合法调整、场景改变），重新学习基线
+ *
+ * 输出：帧元数据（VideoFrame::img，编码线程内后续环节可直接读取）、每秒 [IMG] 日志、
+ * /metrics（rkav_image_*）、控制通道 img 命令。
+ *
+ * 典型使用流程：
+ * 1. frame_stats_init()
+ * 2. 编码线程: 每帧 frame_stats_process()
+ * 3. 统计线程: frame_stats_tick_print()；任意线程: frame_stats_get() / frame_stats_format()
+ * 4. frame_stats_deinit()
+ */
+#pragma once
+
+#include "rkav/types.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 每帧采样像素预算（决定行步长） */
+#define FS_BUDGET_PX    (128 * 1024)
+
+/** 直方图档数（256 级灰度合并为 64 档） */
+#define FS_HIST_BINS    64
+
+/** 即时判断持续多久成为告警 / 解除告警（秒） */
+#define FS_HOLD_SEC     3
+
+/** 变化 / 失焦持续多久后重新学习基线（秒） */
+#define FS_ADOPT_SEC    30
+
+/** 参考直方图与清晰度基线的 EWMA 时间常数（秒） */
+#define FS_REF_SEC      10
+
+/** 判断项个数（对应 RKAV_IMG_F_DARK ... RKAV_IMG_F_CHANGED） */
+#define FS_NCHECKS      5
+
+/**
+ * @brief 一帧的分析结果
+ */
+typedef struct {
+    uint64_t frame_id;
+    uint64_t pts_us;
+    uint32_t samples;                   /**< 采样像素数 */
+    uint32_t row_step;                  /**< 行步长 */
+    uint32_t hist[FS_HIST_BINS];        /**< 采样像素的亮度直方图 */
+    double   mean;                      /**< 亮度均值 */
+    double   stddev;                    /**< 亮度标准差 */
+    double   dark_ratio;                /**< Y < FS_DARK_Y 的像素占比 */
+    double   clip_ratio;                /**< Y >= FS_CLIP_Y 的像素占比 */
+    double   sharpness;                 /**< 拉普拉斯 RMS */
+    double   sharp_base;                /**< 清晰度基线（EWMA，0 = 尚未建立） */
+    double   change;                    /**< 与参考直方图的距离（0-1） */
+    uint16_t flags;                     /**< 即时判断，RKAV_IMG_F_* */
+    uint16_t alarms;                    /**< 当前告警，RKAV_IMG_F_* */
+} FrameStatsSnap;
+
+/**
+ * @brief 帧统计状态
+ *
+ * 分析状态只由编码线程访问；last / 窗口统计 / 告警计数由 mtx 保护，统计线程与直播服务线程读取。
+ */
+typedef struct {
+    int       fps;
+    uint32_t  budget_px;                /**< 采样预算（init 置为 FS_BUDGET_PX，基准测试可改） */
+    int       hold;                     /**< FS_HOLD_SEC 对应帧数 */
+    int       adopt;                    /**< FS_ADOPT_SEC 对应帧数 */
+    double    alpha;                    /**< 基线 EWMA 系数（每帧） */
+
+    /* 分析状态（编码线程） */
+    uint32_t  sub[4][256];              /**< 直方图子表（交错累加，避免相邻像素同档的写后读停顿） */
+    double    ref[FS_HIST_BINS];        /**< 参考直方图（占比） */
+    bool      have_ref;
+    double    sharp_base;
+    uint64_t  frames;                   /**< 已分析帧数 */
+    int       on_run[FS_NCHECKS];       /**< 各判断连续成立帧数 */
+    int       off_run[FS_NCHECKS];      /**< 各判断连续不成立帧数 */
+    uint16_t  alarms;
+
+    /* 共享结果 */
+    pthread_mutex_t mtx;
+    FrameStatsSnap  last;               /**< 最近一帧结果 */
+    uint64_t  win_frames;               /**< 过去 1 秒分析帧数 */
+    uint64_t  win_ns;                   /**< 过去 1 秒分析耗时 */
+    uint64_t  win_max_ns;               /**< 过去 1 秒单帧最大耗时 */
+    uint64_t  total_ns;                 /**< 累计分析耗时 */
+    uint64_t  raised[FS_NCHECKS];       /**< 各告警累计触发次数 */
+} FrameStats;
+
+/**
+ * @brief 初始化
+ *
+ * @param fs  帧统计状态
+ * @param fps 帧率（换算去抖 / 基线时长）
+ * @return int 0 成功，-1 失败
+ */
+int  frame_stats_init(FrameStats *fs, int fps);
+
+/**
+ * @brief 分析一帧并写入 vf->img（编码线程每帧调用，不改写像素）
+ */
+void frame_stats_process(FrameStats *fs, VideoFrame *vf);
+
+/** 读出最近一帧结果 */
+void frame_stats_get(FrameStats *fs, FrameStatsSnap *out);
+
+/** 判断项名称（dark / overexposed / flat / blur / changed），flag 为单个 RKAV_IMG_F_* */
+const char *frame_stats_flag_name(uint16_t flag);
+
+/** 打印 [IMG] 统计并清零窗口计数（统计线程每秒调用） */
+void frame_stats_tick_print(FrameStats *fs);
+
+/**
+ * @brief 把最近一帧结果与告警计数格式化为 Prometheus 文本格式
+ *
+ * @return size_t 写入的字节数（不含结尾 0，超出 cap 时截断）
+ */
+size_t frame_stats_format(FrameStats *fs, char *buf, size_t cap);
+
+/** 释放 */
+void frame_stats_deinit(FrameStats *fs);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,248 @@
+/**
+ * @file frame_sync.c
+ * @brief 多摄像头帧对齐（同步）模块实现
+ *
+ * 对齐算法（每次 frame_sync_next）：
+ * 1. 非阻塞地为每一路补齐 head 帧
+ * 2. 以所有 head 中 PTS 最早的帧为锚点（anchor）
+ * 3. 仍有输入没有 head 时，最多等到 “锚点取出时刻 + max_wait_us”
+ * 4. 把 PTS ∈ [anchor, anchor + tolerance] 的 head 组成一个 FrameSet 输出
+ *    - head 比窗口更晚的那一路：说明它在该时刻的帧已丢失，直接输出 partial set
+ *    - 超时仍未到的那一路：同样输出 partial set，并计入 timeouts
+ *
+ * 整个过程只移动 VideoFrame 指针，不拷贝帧数据。
+ */
+#include "frame_sync.h"
+#include "log.h"
+
+#include "rkav/time.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** 模块日志标签 */
+#define TAG "sync"
+
+/** 所有输入都为空时单次阻塞等待的上限（微秒），保证能及时发现其他路到帧 */
+#define SYNC_IDLE_POLL_US  5000ULL
+
+/*
+ * 非阻塞地为每一路补齐 head 帧。
+ */
+static void fill_heads(FrameSync *fs)
+{
+    for (int i = 0; i < fs->count; i++) {
+        if (fs->head[i] || fs->closed[i]) continue;
+
+        void *item = NULL;
+        int r = bq_pop_timeout(fs->inputs[i], &item, 0);
+        if (r == 1) {
+            fs->head[i] = (VideoFrame *)item;
+            fs->head_arrival_us[i] = rkav_now_monotonic_us();
+        } else if (r == 0) {
+            fs->closed[i] = 1;
+        }
+    }
+}
+
+/*
+ * 对第 i 路做一次带超时的阻塞取帧。
+ */
+static void wait_head(FrameSync *fs, int i, uint64_t timeout_us)
+{
+    void *item = NULL;
+    int r = bq_pop_timeout(fs->inputs[i], &item, timeout_us);
+    if (r == 1) {
+        fs->head[i] = (VideoFrame *)item;
+        fs->head_arrival_us[i] = rkav_now_monotonic_us();
+    } else if (r == 0) {
+        fs->closed[i] = 1;
+    }
+}
+
+/*
+ * 无锁地更新窗口最大值（stats 线程会 exchange 清零）。
+ */
+static void atomic_max_u64(atomic_uint_fast64_t *a, uint64_t v)
+{
+    uint_fast64_t cur = atomic_load_explicit(a, memory_order_relaxed);
+    while (v > cur &&
+           !atomic_compare_exchange_weak_explicit(a, &cur, v,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
+
+int frame_sync_init(FrameSync *fs, BQueue **inputs, int count,
+                    uint64_t tolerance_us, uint64_t max_wait_us,
+                    FrameReleaseFn release)
+{
+    if (!fs || !inputs || count < 2 || count > FRAME_SYNC_MAX_CAMS || !release)
+        return -1;
+
+    memset(fs, 0, sizeof(*fs));
+    for (int i = 0; i < count; i++) {
+        if (!inputs[i]) return -1;
+        fs->inputs[i] = inputs[i];
+    }
+    fs->count        = count;
+    fs->release      = release;
+    fs->tolerance_us = tolerance_us;
+    fs->max_wait_us  = max_wait_us;
+
+    LOGI("[%s] %d cams, tolerance=%.1fms max_wait=%.1fms", TAG, count,
+         (double)tolerance_us / 1000.0, (double)max_wait_us / 1000.0);
+    return 0;
+}
+
+/*
+ * 取下一组对齐的帧。
+ *
+ * @return 1 成功；0 所有输入已关闭且取空；-1 失败
+ */
+int frame_sync_next(FrameSync *fs, FrameSet **out)
+{
+    if (!fs || !out) return -1;
+    *out = NULL;
+
+    int timed_out = 0;
+
+    for (;;) {
+        fill_heads(fs);
+
+        /* 找到锚点：PTS 最早的 head */
+        int anchor = -1;
+        for (int i = 0; i < fs->count; i++) {
+            if (!fs->head[i]) continue;
+            if (anchor < 0 || fs->head[i]->pts_us < fs->head[anchor]->pts_us)
+                anchor = i;
+        }
+
+        if (anchor < 0) {
+            /* 所有输入都空：全部关闭则结束，否则短暂阻塞等待第一路未关闭的输入 */
+            int open_idx = -1;
+            for (int i = 0; i < fs->count; i++) {
+                if (!fs->closed[i]) { open_idx = i; break; }
+            }
+            if (open_idx < 0) return 0;
+            wait_head(fs, open_idx, SYNC_IDLE_POLL_US);
+            continue;
+        }
+
+        /* 还有输入没 head 且未关闭：在截止时间前等待迟到帧 */
+        uint64_t deadline = fs->head_arrival_us[anchor] + fs->max_wait_us;
+        uint64_t now = rkav_now_monotonic_us();
+        int missing = -1;
+        for (int i = 0; i < fs->count; i++) {
+            if (!fs->head[i] && !fs->closed[i]) { missing = i; break; }
+        }
+        if (missing >= 0) {
+            if (now < deadline) {
+                wait_head(fs, missing, deadline - now);
+                continue;
+            }
+            timed_out = 1;
+        }
+
+        /* 组帧：PTS 在 [anchor, anchor + tolerance] 内的 head */
+        FrameSet *set = (FrameSet *)calloc(1, sizeof(FrameSet));
+        if (!set) return -1;
+
+        uint64_t base = fs->head[anchor]->pts_us;
+        uint64_t last = base;
+        set->count  = fs->count;
+        set->pts_us = base;
+        set->set_id = fs->next_set_id++;
+
+        for (int i = 0; i < fs->count; i++) {
+            VideoFrame *vf = fs->head[i];
+            if (!vf || vf->pts_us > base + fs->tolerance_us) continue;
+            set->frames[i] = vf;
+            set->present_mask |= 1u << i;
+            if (vf->pts_us > last) last = vf->pts_us;
+            fs->head[i] = NULL;
+        }
+        set->span_us = last - base;
+
+        /* 更新 skew 统计：组内每一对摄像头 */
+        for (int i = 0; i < fs->count; i++) {
+            if (!set->frames[i]) continue;
+            for (int j = i + 1; j < fs->count; j++) {
+                if (!set->frames[j]) continue;
+                uint64_t a = set->frames[i]->pts_us;
+                uint64_t b = set->frames[j]->pts_us;
+                uint64_t d = a > b ? a - b : b - a;
+                FrameSyncPairStats *ps = &fs->pairs[i][j];
+                atomic_fetch_add_explicit(&ps->sum_us, d, memory_order_relaxed);
+                atomic_fetch_add_explicit(&ps->samples, 1, memory_order_relaxed);
+                atomic_max_u64(&ps->max_us, d);
+            }
+        }
+
+        uint32_t all = (1u << fs->count) - 1u;
+        if (set->present_mask == all) {
+            atomic_fetch_add_explicit(&fs->sets_complete, 1, memory_order_relaxed);
+        } else {
+            atomic_fetch_add_explicit(&fs->sets_partial, 1, memory_order_relaxed);
+            if (timed_out)
+                atomic_fetch_add_explicit(&fs->timeouts, 1, memory_order_relaxed);
+        }
+
+        *out = set;
+        return 1;
+    }
+}
+
+void frame_set_free(FrameSet *set, FrameReleaseFn release)
+{
+    if (!set) return;
+    for (int i = 0; i < set->count && i < FRAME_SYNC_MAX_CAMS; i++) {
+        if (set->frames[i] && release) release(set->frames[i]);
+        set->frames[i] = NULL;
+    }
+    free(set);
+}
+
+/*
+ * 每秒打印一次同步统计：
+ * - [SYNC] 完整/不完整帧组数、超时次数
+ * - [SKEW] 每对摄像头的平均/最大 PTS 偏差
+ */
+void frame_sync_tick_print(FrameSync *fs)
+{
+    if (!fs || fs->count == 0) return;
+
+    uint64_t full    = atomic_exchange(&fs->sets_complete, 0);
+    uint64_t partial = atomic_exchange(&fs->sets_partial, 0);
+    uint64_t tmo     = atomic_exchange(&fs->timeouts, 0);
+
+    LOGI("[SYNC] sets=%llu partial=%llu timeout=%llu",
+         (unsigned long long)full, (unsigned long long)partial,
+         (unsigned long long)tmo);
+
+    for (int i = 0; i < fs->count; i++) {
+        for (int j = i + 1; j < fs->count; j++) {
+            FrameSyncPairStats *ps = &fs->pairs[i][j];
+            uint64_t sum = atomic_exchange(&ps->sum_us, 0);
+            uint64_t mx  = atomic_exchange(&ps->max_us, 0);
+            uint64_t n   = atomic_exchange(&ps->samples, 0);
+            if (n) {
+                LOGI("[SKEW] cam%d-cam%d avg=%.3fms max=%.3fms n=%llu", i, j,
+                     (double)sum / (double)n / 1000.0, (double)mx / 1000.0,
+                     (unsigned long long)n);
+            } else {
+                LOGI("[SKEW] cam%d-cam%d n/a", i, j);
+            }
+        }
+    }
+}
+
+void frame_sync_deinit(FrameSync *fs)
+{
+    if (!fs) return;
+    for (int i = 0; i < fs->count; i++) {
+        if (fs->head[i] && fs->release) fs->release(fs->head[i]);
+        fs->head[i] = NULL;
+    }
+    fs->count = 0;
+}
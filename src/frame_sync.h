@@ -0,0 +1,135 @@
+/**
+ * @file frame_sync.h
+ * @brief 多摄像头帧对齐（同步）模块头文件
+ *
+ * 多路摄像头各自在采集线程中独立打 PTS，立体视觉/拼接/分析等下游
+ * 需要“同一时刻”的一组帧。本模块从多个 raw 视频队列中取帧，
+ * 将 PTS 落在容差窗口内的帧组合成一个 FrameSet。
+ *
+ * 特性：
+ * - 只搬运 VideoFrame 指针，不拷贝任何帧数据
+ * - 迟到帧（straggler）有上限地等待，超时后输出不完整的帧组（partial set）
+ * - 统计每对摄像头之间的 PTS 偏差（skew），每秒打印
+ *
+ * 典型使用流程：
+ * 1. frame_sync_init()     - 绑定 N 个输入队列，设置容差/等待时长
+ * 2. 循环: frame_sync_next() -> 处理 FrameSet -> frame_set_free()
+ * 3. frame_sync_deinit()   - 释放尚未输出的帧
+ */
+#pragma once
+
+#include "rkav/bqueue.h"
+#include "rkav/types.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 最大同步摄像头数 */
+#define FRAME_SYNC_MAX_CAMS  4
+
+/** 帧释放回调（由调用者提供，模块本身不关心帧的内存来源） */
+typedef void (*FrameReleaseFn)(VideoFrame *vf);
+
+/**
+ * @brief 一组对齐后的帧
+ *
+ * frames[i] 为第 i 路摄像头的帧，缺失时为 NULL（partial set）。
+ * 帧的所有权随 FrameSet 一起转移给调用者。
+ */
+typedef struct {
+    int         count;                          /**< 摄像头路数 */
+    VideoFrame *frames[FRAME_SYNC_MAX_CAMS];    /**< 各路帧指针，缺失为 NULL */
+    uint32_t    present_mask;                   /**< 实际到齐的摄像头位图 */
+    uint64_t    pts_us;                         /**< 帧组参考 PTS（组内最早帧） */
+    uint64_t    span_us;                        /**< 组内最大 PTS 差 */
+    uint64_t    set_id;                         /**< 帧组序号 */
+} FrameSet;
+
+/**
+ * @brief 一对摄像头之间的 skew 统计（每秒窗口）
+ */
+typedef struct {
+    atomic_uint_fast64_t sum_us;    /**< |pts_i - pts_j| 累加 */
+    atomic_uint_fast64_t max_us;    /**< 窗口内最大 skew */
+    atomic_uint_fast64_t samples;   /**< 样本数 */
+} FrameSyncPairStats;
+
+/**
+ * @brief 帧同步上下文
+ */
+typedef struct {
+    int             count;                          /**< 输入路数 */
+    BQueue         *inputs[FRAME_SYNC_MAX_CAMS];    /**< 各路 raw 队列 */
+    FrameReleaseFn  release;                        /**< 帧释放回调 */
+
+    uint64_t        tolerance_us;                   /**< 同组 PTS 容差 */
+    uint64_t        max_wait_us;                    /**< 迟到帧最长等待时间 */
+
+    VideoFrame     *head[FRAME_SYNC_MAX_CAMS];      /**< 各路已取出但尚未成组的帧 */
+    uint64_t        head_arrival_us[FRAME_SYNC_MAX_CAMS]; /**< head 取出时刻（monotonic） */
+    int             closed[FRAME_SYNC_MAX_CAMS];    /**< 该路队列是否已关闭且取空 */
+
+    uint64_t        next_set_id;
+
+    /* 统计（每秒窗口，stats 线程读取并清零） */
+    atomic_uint_fast64_t sets_complete;             /**< 完整帧组数 */
+    atomic_uint_fast64_t sets_partial;              /**< 不完整帧组数 */
+    atomic_uint_fast64_t timeouts;                  /**< 因等待超时而输出的帧组数 */
+    FrameSyncPairStats   pairs[FRAME_SYNC_MAX_CAMS][FRAME_SYNC_MAX_CAMS]; /**< 仅使用 i<j */
+} FrameSync;
+
+/**
+ * @brief 初始化帧同步器
+ *
+ * @param fs            同步上下文
+ * @param inputs        输入队列数组（元素为 VideoFrame*）
+ * @param count         输入路数（2..FRAME_SYNC_MAX_CAMS）
+ * @param tolerance_us  同组 PTS 容差（微秒）
+ * @param max_wait_us   迟到帧最长等待（微秒）
+ * @param release       帧释放回调（deinit 时释放残留帧）
+ * @return int          0 成功，-1 失败
+ */
+int  frame_sync_init(FrameSync *fs, BQueue **inputs, int count,
+                     uint64_t tolerance_us, uint64_t max_wait_us,
+                     FrameReleaseFn release);
+
+/**
+ * @brief 取下一组对齐的帧（阻塞，最长等待由 max_wait_us 约束）
+ *
+ * @param fs  同步上下文
+ * @param out 输出：帧组（调用者负责 frame_set_free）
+ * @return int 1 成功，0 所有输入已关闭且取空，-1 失败
+ */
+int  frame_sync_next(FrameSync *fs, FrameSet **out);
+
+/**
+ * @brief 释放帧组及其中剩余的帧
+ *
+ * 调用者可以先把某些 frames[i] 取走并置 NULL（转移所有权），再调用本函数。
+ *
+ * @param set     帧组
+ * @param release 帧释放回调
+ */
+void frame_set_free(FrameSet *set, FrameReleaseFn release);
+
+/**
+ * @brief 打印并重置同步统计（每秒调用一次）
+ *
+ * @param fs 同步上下文
+ */
+void frame_sync_tick_print(FrameSync *fs);
+
+/**
+ * @brief 释放同步器内部残留的帧
+ *
+ * @param fs 同步上下文
+ */
+void frame_sync_deinit(FrameSync *fs);
+
+#ifdef __cplusplus
+}
+#endif
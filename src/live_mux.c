@@ -0,0 +1,583 @@
+/**
+ * @file live_mux.c
+ * @brief 直播预览封装模块实现（HTTP-FLV / fMP4 over WebSocket）
+ *
+ * 每个包的分片结构（单样本）：
+ * - FLV：  "<hex>\r\n" | tag 头(11) | 0x17/0x27 01 000000 | [len][NAL]... | PreviousTagSize | "\r\n"
+ * - fMP4： WS 帧头 | moof(mfhd + traf(tfhd + tfdt + trun)) | mdat 头 | [len][NAL]...
+ *
+ * 时间戳相对于第一个包的 DTS：FLV 为毫秒，fMP4 为 90kHz。
+ * 包按解码顺序到达，tag 时间戳 / baseMediaDecodeTime 取 DTS，PTS 以合成时间偏移（PTS - DTS）
+ * 写入 FLV CompositionTime / trun sample_composition_time_offset；无 B 帧时偏移为 0。
+ */
+#include "live_mux.h"
+#include "rkav/packet.h"
+#include "log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** 模块日志标签 */
+#define TAG "live_mux"
+
+/** fMP4 时间刻度（90kHz） */
+#define MP4_TIMESCALE   90000u
+
+/** moof 固定长度：8 + mfhd(16) + traf(8 + tfhd(16) + tfdt(20) + trun(36)) */
+#define MOOF_SIZE       104u
+
+/** 写入 FLV tag 头的 AVC 视频头长度（FrameType/CodecID + AVCPacketType + CTS） */
+#define FLV_AVC_HDR     5u
+
+/* ============================================================================
+ * 字节写入辅助
+ * ============================================================================ */
+
+typedef struct {
+    uint8_t *p;
+    size_t   cap;
+    size_t   len;
+    int      err;
+} ByteWriter;
+
+static void bw_bytes(ByteWriter *b, const void *src, size_t n)
+{
+    if (b->err || b->len + n > b->cap) {
+        b->err = 1;
+        return;
+    }
+    memcpy(b->p + b->len, src, n);
+    b->len += n;
+}
+
+static void bw_u8(ByteWriter *b, uint32_t v)
+{
+    uint8_t x = (uint8_t)v;
+    bw_bytes(b, &x, 1);
+}
+
+static void bw_u16(ByteWriter *b, uint32_t v)
+{
+    uint8_t x[2] = { (uint8_t)(v >> 8), (uint8_t)v };
+    bw_bytes(b, x, 2);
+}
+
+static void bw_u24(ByteWriter *b, uint32_t v)
+{
+    uint8_t x[3] = { (uint8_t)(v >> 16), (uint8_t)(v >> 8), (uint8_t)v };
+    bw_bytes(b, x, 3);
+}
+
+static void bw_u32(ByteWriter *b, uint32_t v)
+{
+    uint8_t x[4] = { (uint8_t)(v >> 24), (uint8_t)(v >> 16), (uint8_t)(v >> 8), (uint8_t)v };
+    bw_bytes(b, x, 4);
+}
+
+static void bw_u64(ByteWriter *b, uint64_t v)
+{
+    bw_u32(b, (uint32_t)(v >> 32));
+    bw_u32(b, (uint32_t)v);
+}
+
+static void bw_zero(ByteWriter *b, size_t n)
+{
+    while (n--) bw_u8(b, 0);
+}
+
+/* 开始一个 box，返回其起始位置（大小在 bw_box_end 时回填） */
+static size_t bw_box_begin(ByteWriter *b, const char *type)
+{
+    size_t at = b->len;
+    bw_u32(b, 0);
+    bw_bytes(b, type, 4);
+    return at;
+}
+
+/* full box：额外写 version + flags */
+static size_t bw_fullbox_begin(ByteWriter *b, const char *type, uint32_t version, uint32_t flags)
+{
+    size_t at = bw_box_begin(b, type);
+    bw_u8(b, version);
+    bw_u24(b, flags);
+    return at;
+}
+
+static void bw_box_end(ByteWriter *b, size_t at)
+{
+    if (b->err) return;
+    uint32_t sz = (uint32_t)(b->len - at);
+    b->p[at]     = (uint8_t)(sz >> 24);
+    b->p[at + 1] = (uint8_t)(sz >> 16);
+    b->p[at + 2] = (uint8_t)(sz >> 8);
+    b->p[at + 3] = (uint8_t)sz;
+}
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/* ============================================================================
+ * Annex-B 解析
+ * ============================================================================ */
+
+/* 从 from 开始查找下一个 00 00 01，返回其位置（找不到返回 n） */
+static size_t find_start_code(const uint8_t *d, size_t n, size_t from)
+{
+    for (size_t i = from; i + 3 <= n; i++) {
+        if (d[i + 2] > 1) {
+            i += 2;     /* d[i+2] 不可能是起始码的任何一个字节 */
+            continue;
+        }
+        if (d[i] == 0 && d[i + 1] == 0 && d[i + 2] == 1)
+            return i;
+    }
+    return n;
+}
+
+/* ============================================================================
+ * 公共接口
+ * ============================================================================ */
+
+void live_mux_init(LiveMux *m, int fps, int width, int height)
+{
+    if (!m) return;
+    memset(m, 0, sizeof(*m));
+    m->fps    = fps > 0 ? fps : 30;
+    m->width  = width;
+    m->height = height;
+}
+
+bool live_mux_ready(const LiveMux *m)
+{
+    return m && m->sps_len >= 4 && m->pps_len > 0;
+}
+
+const char *live_proto_name(LiveProto proto)
+{
+    switch (proto) {
+    case LIVE_PROTO_FLV: return "flv";
+    case LIVE_PROTO_WS:  return "ws";
+    default:             return "unknown";
+    }
+}
+
+size_t live_ws_frame_header(uint8_t *hdr, int opcode, uint64_t len)
+{
+    hdr[0] = (uint8_t)(0x80 | (opcode & 0x0F));     /* FIN + opcode */
+    if (len < 126) {
+        hdr[1] = (uint8_t)len;
+        return 2;
+    }
+    if (len <= 0xFFFF) {
+        hdr[1] = 126;
+        hdr[2] = (uint8_t)(len >> 8);
+        hdr[3] = (uint8_t)len;
+        return 4;
+    }
+    hdr[1] = 127;
+    for (int i = 0; i < 8; i++)
+        hdr[2 + i] = (uint8_t)(len >> (56 - 8 * i));
+    return 10;
+}
+
+/* 生成 FLV 预封装头/尾 */
+static void build_flv(const LiveMux *m, LiveItem *it)
+{
+    uint64_t rel_ms = (it->dts_us - m->base_dts_us) / 1000u;
+    uint32_t cts_ms = (uint32_t)((it->pts_us - it->dts_us) / 1000u);
+    uint32_t data_size = (uint32_t)(FLV_AVC_HDR + it->payload);
+    uint32_t tag_size  = 11u + data_size;
+    size_t   chunk     = (size_t)tag_size + 4u;     /* tag + PreviousTagSize */
+
+    int n = snprintf((char *)it->flv_hdr, sizeof(it->flv_hdr), "%zx\r\n", chunk);
+    ByteWriter b = { it->flv_hdr, sizeof(it->flv_hdr), (size_t)n, 0 };
+    bw_u8(&b, 9);                               /* TagType = video */
+    bw_u24(&b, data_size);
+    bw_u24(&b, (uint32_t)rel_ms & 0xFFFFFFu);   /* Timestamp（低 24 位） */
+    bw_u8(&b, (uint32_t)(rel_ms >> 24) & 0xFFu);/* TimestampExtended */
+    bw_u24(&b, 0);                              /* StreamID */
+    bw_u8(&b, it->key ? 0x17 : 0x27);           /* FrameType | CodecID(7=AVC) */
+    bw_u8(&b, 1);                               /* AVCPacketType = NALU */
+    bw_u24(&b, cts_ms & 0xFFFFFFu);             /* CompositionTime = PTS - DTS（毫秒） */
+    it->flv_hdr_len = (uint8_t)b.len;
+
+    put_be32(it->flv_tail, tag_size);
+    it->flv_tail[4] = '\r';
+    it->flv_tail[5] = '\n';
+    it->flv_tail_len = 6;
+
+    it->total[LIVE_PROTO_FLV] = it->flv_hdr_len + it->payload + it->flv_tail_len;
+}
+
+/* 生成 WS 帧头 + moof + mdat 头 */
+static void build_ws(const LiveMux *m, LiveItem *it)
+{
+    uint64_t rel_us = it->dts_us - m->base_dts_us;
+    uint64_t dts    = rel_us * (MP4_TIMESCALE / 1000u) / 1000u;
+    uint32_t cto    = (uint32_t)((it->pts_us - it->dts_us) * (MP4_TIMESCALE / 1000u) / 1000u);
+    uint32_t dur    = MP4_TIMESCALE / (uint32_t)m->fps;
+    uint32_t mdat   = (uint32_t)(8u + it->payload);
+
+    size_t wl = live_ws_frame_header(it->ws_hdr, 2, (uint64_t)MOOF_SIZE + mdat);
+    ByteWriter b = { it->ws_hdr, sizeof(it->ws_hdr), wl, 0 };
+
+    size_t moof = bw_box_begin(&b, "moof");
+    size_t mfhd = bw_fullbox_begin(&b, "mfhd", 0, 0);
+    bw_u32(&b, (uint32_t)it->seq + 1u);             /* sequence_number（从 1 开始） */
+    bw_box_end(&b, mfhd);
+
+    size_t traf = bw_box_begin(&b, "traf");
+    size_t tfhd = bw_fullbox_begin(&b, "tfhd", 0, 0x020000);   /* default-base-is-moof */
+    bw_u32(&b, 1);                                  /* track_ID */
+    bw_box_end(&b, tfhd);
+
+    size_t tfdt = bw_fullbox_begin(&b, "tfdt", 1, 0);
+    bw_u64(&b, dts);                                /* baseMediaDecodeTime */
+    bw_box_end(&b, tfdt);
+
+    /* 0x000F01：data-offset | sample-duration | sample-size | sample-flags | composition-time-offset */
+    size_t trun = bw_fullbox_begin(&b, "trun", 1, 0x000F01);
+    bw_u32(&b, 1);                                  /* sample_count */
+    bw_u32(&b, MOOF_SIZE + 8u);                     /* data_offset：跳过 moof 与 mdat 头 */
+    bw_u32(&b, dur);
+    bw_u32(&b, (uint32_t)it->payload);
+    /* 关键帧：depends_on=2(不依赖)；非关键帧：depends_on=1 + is_non_sync */
+    bw_u32(&b, it->key ? 0x02000000u : 0x01010000u);
+    bw_u32(&b, cto);                                /* PTS - DTS（version 1：有符号，这里恒 >= 0） */
+    bw_box_end(&b, trun);
+    bw_box_end(&b, traf);
+    bw_box_end(&b, moof);
+
+    bw_u32(&b, mdat);
+    bw_bytes(&b, "mdat", 4);
+    it->ws_hdr_len = (uint8_t)b.len;
+
+    it->total[LIVE_PROTO_WS] = it->ws_hdr_len + it->payload;
+}
+
+LiveItem *live_item_create(LiveMux *m, EncodedPacket *ep, uint64_t seq, uint64_t arrival_us)
+{
+    if (!m || !ep) return NULL;
+    if (!ep->data || ep->size == 0 || ep->size > UINT32_MAX) {
+        encoded_packet_unref(ep);
+        return NULL;
+    }
+
+    LiveItem *it = (LiveItem *)calloc(1, sizeof(LiveItem));
+    if (!it) {
+        encoded_packet_unref(ep);
+        return NULL;
+    }
+    it->ep         = ep;
+    it->seq        = seq;
+    it->pts_us     = ep->pts_us;
+    it->dts_us     = ep->dts_us > ep->pts_us ? ep->pts_us : ep->dts_us;
+    it->arrival_us = arrival_us;
+    it->key        = ep->is_keyframe;
+    it->tlayer     = ep->temporal_id;
+
+    const uint8_t *d = ep->data;
+    size_t n = ep->size;
+    size_t sc = find_start_code(d, n, 0);
+    while (sc < n) {
+        size_t start = sc + 3;
+        size_t next  = find_start_code(d, n, start);
+        size_t end   = next;
+        while (end > start && d[end - 1] == 0)      /* 4 字节起始码的前导 0 / trailing zero */
+            end--;
+        sc = next;
+        if (end <= start) continue;
+
+        size_t len  = end - start;
+        int    type = d[start] & 0x1F;
+        if (type == 7 || type == 8) {
+            /* SPS/PPS：进入初始化段，不进入分片 */
+            if (len <= LIVE_MAX_PS) {
+                if (type == 7) {
+                    memcpy(m->sps, d + start, len);
+                    m->sps_len = len;
+                } else {
+                    memcpy(m->pps, d + start, len);
+                    m->pps_len = len;
+                }
+            }
+            continue;
+        }
+        if (type == 9) continue;                    /* AUD */
+        if (type == 5) it->key = true;              /* IDR（MPP 不一定给出 INTRA 标志） */
+
+        if (it->nal_count >= LIVE_MAX_NALS) {
+            LOGW("[%s] too many NALs in packet seq=%llu", TAG, (unsigned long long)seq);
+            live_item_free(it);
+            return NULL;
+        }
+        int k = it->nal_count++;
+        it->nal_off[k] = (uint32_t)start;
+        it->nal_len[k] = (uint32_t)len;
+        put_be32(it->nal_pfx[k], (uint32_t)len);
+        it->payload += 4u + len;
+    }
+
+    if (it->nal_count == 0) {
+        live_item_free(it);
+        return NULL;
+    }
+
+    if (!m->have_base) {
+        m->have_base   = true;
+        m->base_dts_us = it->dts_us;
+    }
+    if (it->dts_us < m->base_dts_us)
+        it->dts_us = m->base_dts_us;
+    if (it->pts_us < it->dts_us)
+        it->pts_us = it->dts_us;
+
+    build_flv(m, it);
+    build_ws(m, it);
+    return it;
+}
+
+void live_item_free(LiveItem *it)
+{
+    if (!it) return;
+    encoded_packet_unref(it->ep);
+    free(it);
+}
+
+int live_item_iov(const LiveItem *it, LiveProto proto, size_t skip, struct iovec *iov)
+{
+    if (!it || skip >= it->total[proto]) return 0;
+
+    int cnt = 0;
+#define IOV_ADD(ptr, len) do {                                  \
+        size_t l_ = (len);                                      \
+        if (skip >= l_) {                                       \
+            skip -= l_;                                         \
+        } else {                                                \
+            iov[cnt].iov_base = (uint8_t *)(ptr) + skip;        \
+            iov[cnt].iov_len  = l_ - skip;                      \
+            cnt++;                                              \
+            skip = 0;                                           \
+        }                                                       \
+    } while (0)
+
+    if (proto == LIVE_PROTO_FLV)
+        IOV_ADD(it->flv_hdr, it->flv_hdr_len);
+    else
+        IOV_ADD(it->ws_hdr, it->ws_hdr_len);
+
+    for (int i = 0; i < it->nal_count; i++) {
+        IOV_ADD(it->nal_pfx[i], 4);
+        IOV_ADD(it->ep->data + it->nal_off[i], it->nal_len[i]);
+    }
+
+    if (proto == LIVE_PROTO_FLV)
+        IOV_ADD(it->flv_tail, it->flv_tail_len);
+#undef IOV_ADD
+    return cnt;
+}
+
+/* AVCDecoderConfigurationRecord */
+static void write_avcc(ByteWriter *b, const LiveMux *m)
+{
+    bw_u8(b, 1);                /* configurationVersion */
+    bw_u8(b, m->sps[1]);        /* AVCProfileIndication */
+    bw_u8(b, m->sps[2]);        /* profile_compatibility */
+    bw_u8(b, m->sps[3]);        /* AVCLevelIndication */
+    bw_u8(b, 0xFF);             /* lengthSizeMinusOne = 3 */
+    bw_u8(b, 0xE1);             /* numOfSequenceParameterSets = 1 */
+    bw_u16(b, (uint32_t)m->sps_len);
+    bw_bytes(b, m->sps, m->sps_len);
+    bw_u8(b, 1);                /* numOfPictureParameterSets */
+    bw_u16(b, (uint32_t)m->pps_len);
+    bw_bytes(b, m->pps, m->pps_len);
+}
+
+size_t live_mux_flv_init(const LiveMux *m, uint8_t *buf, size_t cap)
+{
+    if (!live_mux_ready(m) || !buf) return 0;
+
+    uint8_t body[LIVE_INIT_MAX];
+    ByteWriter b = { body, sizeof(body), 0, 0 };
+
+    /* FLV 文件头：仅视频 */
+    bw_bytes(&b, "FLV", 3);
+    bw_u8(&b, 1);               /* version */
+    bw_u8(&b, 0x01);            /* TypeFlags：video */
+    bw_u32(&b, 9);              /* DataOffset */
+    bw_u32(&b, 0);              /* PreviousTagSize0 */
+
+    /* AVC sequence header tag */
+    size_t tag = b.len;
+    bw_u8(&b, 9);
+    size_t size_at = b.len;
+    bw_u24(&b, 0);              /* DataSize，稍后回填 */
+    bw_u24(&b, 0);
+    bw_u8(&b, 0);
+    bw_u24(&b, 0);
+    size_t data = b.len;
+    bw_u8(&b, 0x17);
+    bw_u8(&b, 0);               /* AVCPacketType = sequence header */
+    bw_u24(&b, 0);
+    write_avcc(&b, m);
+    if (b.err) return 0;
+    uint32_t data_size = (uint32_t)(b.len - data);
+    body[size_at]     = (uint8_t)(data_size >> 16);
+    body[size_at + 1] = (uint8_t)(data_size >> 8);
+    body[size_at + 2] = (uint8_t)data_size;
+    bw_u32(&b, (uint32_t)(b.len - tag));
+    if (b.err) return 0;
+
+    /* chunked 编码 */
+    int n = snprintf((char *)buf, cap, "%zx\r\n", b.len);
+    if (n < 0 || (size_t)n + b.len + 2 > cap) return 0;
+    memcpy(buf + n, body, b.len);
+    memcpy(buf + n + b.len, "\r\n", 2);
+    return (size_t)n + b.len + 2;
+}
+
+size_t live_mux_mp4_init(const LiveMux *m, uint8_t *buf, size_t cap)
+{
+    if (!live_mux_ready(m) || !buf) return 0;
+
+    static const uint32_t matrix[9] = {
+        0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000
+    };
+    ByteWriter b = { buf, cap, 0, 0 };
+
+    size_t ftyp = bw_box_begin(&b, "ftyp");
+    bw_bytes(&b, "isom", 4);
+    bw_u32(&b, 0x200);
+    bw_bytes(&b, "isomiso6avc1mp41", 16);
+    bw_box_end(&b, ftyp);
+
+    size_t moov = bw_box_begin(&b, "moov");
+
+    size_t mvhd = bw_fullbox_begin(&b, "mvhd", 0, 0);
+    bw_u32(&b, 0);              /* creation_time */
+    bw_u32(&b, 0);              /* modification_time */
+    bw_u32(&b, 1000);           /* timescale */
+    bw_u32(&b, 0);              /* duration（直播未知） */
+    bw_u32(&b, 0x00010000);     /* rate 1.0 */
+    bw_u16(&b, 0x0100);         /* volume 1.0 */
+    bw_zero(&b, 10);
+    for (int i = 0; i < 9; i++) bw_u32(&b, matrix[i]);
+    bw_zero(&b, 24);            /* pre_defined */
+    bw_u32(&b, 2);              /* next_track_ID */
+    bw_box_end(&b, mvhd);
+
+    size_t trak = bw_box_begin(&b, "trak");
+    size_t tkhd = bw_fullbox_begin(&b, "tkhd", 0, 0x000003);  /* enabled | in_movie */
+    bw_u32(&b, 0);
+    bw_u32(&b, 0);
+    bw_u32(&b, 1);              /* track_ID */
+    bw_u32(&b, 0);
+    bw_u32(&b, 0);              /* duration */
+    bw_zero(&b, 8);
+    bw_u16(&b, 0);              /* layer */
+    bw_u16(&b, 0);              /* alternate_group */
+    bw_u16(&b, 0);              /* volume（视频轨为 0） */
+    bw_u16(&b, 0);
+    for (int i = 0; i < 9; i++) bw_u32(&b, matrix[i]);
+    bw_u32(&b, (uint32_t)m->width << 16);
+    bw_u32(&b, (uint32_t)m->height << 16);
+    bw_box_end(&b, tkhd);
+
+    size_t mdia = bw_box_begin(&b, "mdia");
+    size_t mdhd = bw_fullbox_begin(&b, "mdhd", 0, 0);
+    bw_u32(&b, 0);
+    bw_u32(&b, 0);
+    bw_u32(&b, MP4_TIMESCALE);
+    bw_u32(&b, 0);
+    bw_u16(&b, 0x55C4);         /* language = "und" */
+    bw_u16(&b, 0);
+    bw_box_end(&b, mdhd);
+
+    size_t hdlr = bw_fullbox_begin(&b, "hdlr", 0, 0);
+    bw_u32(&b, 0);
+    bw_bytes(&b, "vide", 4);
+    bw_zero(&b, 12);
+    bw_bytes(&b, "VideoHandler", 13);
+    bw_box_end(&b, hdlr);
+
+    size_t minf = bw_box_begin(&b, "minf");
+    size_t vmhd = bw_fullbox_begin(&b, "vmhd", 0, 1);
+    bw_zero(&b, 8);             /* graphicsmode + opcolor */
+    bw_box_end(&b, vmhd);
+
+    size_t dinf = bw_box_begin(&b, "dinf");
+    size_t dref = bw_fullbox_begin(&b, "dref", 0, 0);
+    bw_u32(&b, 1);
+    size_t url = bw_fullbox_begin(&b, "url ", 0, 1);          /* self-contained */
+    bw_box_end(&b, url);
+    bw_box_end(&b, dref);
+    bw_box_end(&b, dinf);
+
+    size_t stbl = bw_box_begin(&b, "stbl");
+    size_t stsd = bw_fullbox_begin(&b, "stsd", 0, 0);
+    bw_u32(&b, 1);
+    size_t avc1 = bw_box_begin(&b, "avc1");
+    bw_zero(&b, 6);
+    bw_u16(&b, 1);              /* data_reference_index */
+    bw_zero(&b, 16);            /* pre_defined / reserved */
+    bw_u16(&b, (uint32_t)m->width);
+    bw_u16(&b, (uint32_t)m->height);
+    bw_u32(&b, 0x00480000);     /* 72 dpi */
+    bw_u32(&b, 0x00480000);
+    bw_u32(&b, 0);
+    bw_u16(&b, 1);              /* frame_count */
+    bw_zero(&b, 32);            /* compressorname */
+    bw_u16(&b, 0x0018);         /* depth */
+    bw_u16(&b, 0xFFFF);         /* pre_defined = -1 */
+    size_t avcc = bw_box_begin(&b, "avcC");
+    write_avcc(&b, m);
+    bw_box_end(&b, avcc);
+    bw_box_end(&b, avc1);
+    bw_box_end(&b, stsd);
+
+    /* 分片模式下 sample table 为空 */
+    size_t stts = bw_fullbox_begin(&b, "stts", 0, 0);
+    bw_u32(&b, 0);
+    bw_box_end(&b, stts);
+    size_t stsc = bw_fullbox_begin(&b, "stsc", 0, 0);
+    bw_u32(&b, 0);
+    bw_box_end(&b, stsc);
+    size_t stsz = bw_fullbox_begin(&b, "stsz", 0, 0);
+    bw_u32(&b, 0);
+    bw_u32(&b, 0);
+    bw_box_end(&b, stsz);
+    size_t stco = bw_fullbox_begin(&b, "stco", 0, 0);
+    bw_u32(&b, 0);
+    bw_box_end(&b, stco);
+    bw_box_end(&b, stbl);
+    bw_box_end(&b, minf);
+    bw_box_end(&b, mdia);
+    bw_box_end(&b, trak);
+
+    size_t mvex = bw_box_begin(&b, "mvex");
+    size_t trex = bw_fullbox_begin(&b, "trex", 0, 0);
+    bw_u32(&b, 1);              /* track_ID */
+    bw_u32(&b, 1);              /* default_sample_description_index */
+    bw_u32(&b, 0);
+    bw_u32(&b, 0);
+    bw_u32(&b, 0);
+    bw_box_end(&b, trex);
+    bw_box_end(&b, mvex);
+
+    bw_box_end(&b, moov);
+    return b.err ? 0 : b.len;
+}
+
+int live_mux_mime(const LiveMux *m, char *buf, size_t cap)
+{
+    if (!live_mux_ready(m) || !buf) return -1;
+    int n = snprintf(buf, cap, "video/mp4; codecs=\"avc1.%02x%02x%02x\"",
+                     m->sps[1], m->sps[2], m->sps[3]);
+    return (n < 0 || (size_t)n >= cap) ? -1 : 0;
+}
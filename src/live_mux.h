@@ -0,0 +1,159 @@
+/**
+ * @file live_mux.h
+ * @brief 直播预览封装模块头文件（HTTP-FLV / fMP4 over WebSocket）
+ *
+ * 把编码线程输出的 H.264 Annex-B 包转换为浏览器可直接播放的两种流：
+ * - HTTP-FLV（chunked 传输，flv.js 等播放器）
+ * - fMP4 分片，以 WebSocket 二进制帧承载（MSE 播放）
+ *
+ * 零拷贝思路：
+ * 每个包只在入库时解析一次 NAL 边界，并预先生成两种协议的“包头”（chunk 行 + FLV tag 头 /
+ * WS 帧头 + moof + mdat 头）和每个 NAL 的 4 字节长度前缀。发送时用 writev 把
+ * 包头、长度前缀与 EncodedPacket::data 中的 NAL 负载拼成 iovec，所有客户端共享同一份数据。
+ *
+ * SPS/PPS 不进入分片，而是从关键帧中提取后写入初始化段（FLV AVC sequence header / avcC）。
+ */
+#pragma once
+
+#include "rkav/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 单个包内最多的 NAL 数（含 SEI / 多 slice） */
+#define LIVE_MAX_NALS   32
+
+/** SPS / PPS 最大长度 */
+#define LIVE_MAX_PS     256
+
+/** 初始化段缓冲大小（FLV 头 + sequence header / ftyp + moov） */
+#define LIVE_INIT_MAX   1024
+
+/** 单个 LiveItem 发送时最多需要的 iovec 数 */
+#define LIVE_ITEM_IOV   (2 + 2 * LIVE_MAX_NALS)
+
+/**
+ * @brief 直播协议
+ */
+typedef enum {
+    LIVE_PROTO_FLV = 0,     /**< HTTP-FLV（chunked） */
+    LIVE_PROTO_WS  = 1,     /**< WebSocket 二进制帧承载 fMP4 分片 */
+    LIVE_PROTO_COUNT
+} LiveProto;
+
+/**
+ * @brief 一个已预封装的视频包（环形缓冲中的一项）
+ *
+ * 持有 EncodedPacket 的一个引用；nal_off/nal_len 指向 ep->data 内部。
+ */
+typedef struct {
+    EncodedPacket *ep;                      /**< 共享的编码包（持有一个引用） */
+    uint64_t       seq;                     /**< 入库序号（单调递增） */
+    uint64_t       pts_us;                  /**< 包 PTS */
+    uint64_t       dts_us;                  /**< 包 DTS（封装时间戳以此为准，PTS 以合成时间偏移表示） */
+    uint64_t       arrival_us;              /**< 入库时刻（monotonic），用于计算客户端滞后 */
+    bool           key;                     /**< 是否为 IDR */
+    uint8_t        tlayer;                  /**< 时间层 ID（见 svc_shed.h） */
+
+    int            nal_count;               /**< 负载 NAL 数（已去掉 SPS/PPS/AUD） */
+    uint32_t       nal_off[LIVE_MAX_NALS];  /**< NAL 在 ep->data 中的偏移 */
+    uint32_t       nal_len[LIVE_MAX_NALS];  /**< NAL 长度 */
+    uint8_t        nal_pfx[LIVE_MAX_NALS][4]; /**< 大端 4 字节长度前缀 */
+    size_t         payload;                 /**< Σ(4 + nal_len) */
+
+    uint8_t        flv_hdr[32];             /**< chunk 行 + FLV tag 头 + AVC 视频头 */
+    uint8_t        flv_tail[8];             /**< PreviousTagSize + chunk 结尾 CRLF */
+    uint8_t        ws_hdr[128];             /**< WS 帧头 + moof + mdat 头 */
+    uint8_t        flv_hdr_len;
+    uint8_t        flv_tail_len;
+    uint8_t        ws_hdr_len;
+
+    size_t         total[LIVE_PROTO_COUNT]; /**< 各协议下序列化后的总字节数 */
+} LiveItem;
+
+/**
+ * @brief 封装上下文（参数集 + 时间基）
+ */
+typedef struct {
+    int       fps;                  /**< 标称帧率（fMP4 默认样本时长） */
+    int       width;                /**< 视频宽 */
+    int       height;               /**< 视频高 */
+
+    uint8_t   sps[LIVE_MAX_PS];
+    size_t    sps_len;
+    uint8_t   pps[LIVE_MAX_PS];
+    size_t    pps_len;
+
+    bool      have_base;            /**< 是否已确定时间基 */
+    uint64_t  base_dts_us;          /**< 流时间基（第一个包的 DTS），FLV/fMP4 时间戳均相对于此 */
+} LiveMux;
+
+/** 初始化封装上下文 */
+void live_mux_init(LiveMux *m, int fps, int width, int height);
+
+/** 是否已拿到 SPS/PPS（可以生成初始化段） */
+bool live_mux_ready(const LiveMux *m);
+
+/**
+ * @brief 解析并预封装一个编码包
+ *
+ * 解析 Annex-B 起始码，记录 SPS/PPS，生成 LiveItem。
+ * 无论成功与否，ep 的这个引用都归本函数处理（失败时释放）。
+ *
+ * @param m          封装上下文
+ * @param ep         编码包（转移一个引用）
+ * @param seq        入库序号
+ * @param arrival_us 入库时刻
+ * @return LiveItem* 成功返回新项；包内无可用 NAL / NAL 过多 / 内存不足返回 NULL
+ */
+LiveItem *live_item_create(LiveMux *m, EncodedPacket *ep, uint64_t seq, uint64_t arrival_us);
+
+/** 释放 LiveItem 并归还 EncodedPacket 引用 */
+void live_item_free(LiveItem *it);
+
+/**
+ * @brief 为发送生成 iovec（跳过已发送的前 skip 字节）
+ *
+ * @return int iovec 个数；skip >= total 时返回 0
+ */
+int live_item_iov(const LiveItem *it, LiveProto proto, size_t skip, struct iovec *iov);
+
+/**
+ * @brief 生成 HTTP-FLV 初始化数据（FLV 头 + AVC sequence header），已按 chunked 编码
+ *
+ * @return size_t 字节数，参数集未就绪或缓冲不足返回 0
+ */
+size_t live_mux_flv_init(const LiveMux *m, uint8_t *buf, size_t cap);
+
+/**
+ * @brief 生成 fMP4 初始化段（ftyp + moov），未加 WS 帧头
+ *
+ * @return size_t 字节数，参数集未就绪或缓冲不足返回 0
+ */
+size_t live_mux_mp4_init(const LiveMux *m, uint8_t *buf, size_t cap);
+
+/** MSE 使用的 MIME 字符串，例如 video/mp4; codecs="avc1.64001f" */
+int live_mux_mime(const LiveMux *m, char *buf, size_t cap);
+
+/**
+ * @brief 写 WebSocket 帧头（服务端帧不加掩码）
+ *
+ * @param hdr     输出缓冲（至少 10 字节）
+ * @param opcode  1=文本，2=二进制
+ * @param len     负载长度
+ * @return size_t 帧头字节数（2 / 4 / 10）
+ */
+size_t live_ws_frame_header(uint8_t *hdr, int opcode, uint64_t len);
+
+/** 协议名称（"flv" / "ws"） */
+const char *live_proto_name(LiveProto proto);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,890 @@
+/**
+ * @file live_server.c
+ * @brief 局域网直播预览服务实现
+ *
+ * 线程模型：
+ * - 环形缓冲与所有客户端状态只由服务线程访问，无需加锁
+ * - 编码线程只通过收件箱（BQueue + eventfd 唤醒）与服务线程交互
+ * - 统计快照由 stat_mtx 保护，供统计线程每秒打印
+ *
+ * 发送：每个客户端记录 (next_seq, item_off)，socket 写满（EAGAIN）时注册 EPOLLOUT，
+ * 可写后从断点继续；写空后注销 EPOLLOUT，等待新包入库时再主动推送。
+ */
+#include "live_server.h"
+#include "rkav/packet.h"
+#include "rkav/time.h"
+#include "log.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/** 模块日志标签 */
+#define TAG "live"
+
+/** epoll 事件键：监听 socket / eventfd（客户端为 gen<<32 | slot） */
+#define KEY_LISTEN  UINT64_MAX
+#define KEY_EVENT   (UINT64_MAX - 1)
+
+/** WebSocket 握手 GUID（RFC 6455） */
+#define WS_GUID     "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+/** 内置预览页：WebSocket 收 fMP4，MSE 播放，落后超过 1 秒时追到最新 */
+static const char s_index_html[] =
+    "<!doctype html><html><head><meta charset=\"utf-8\"><title>rkav live</title></head>\n"
+    "<body style=\"margin:0;background:#000\">\n"
+    "<video id=\"v\" autoplay muted playsinline style=\"width:100%;height:100vh\"></video>\n"
+    "<script>\n"
+    "const v=document.getElementById('v'),ms=new MediaSource();let sb=null,q=[];\n"
+    "v.src=URL.createObjectURL(ms);\n"
+    "ms.addEventListener('sourceopen',()=>{\n"
+    " const ws=new WebSocket('ws://'+location.host+'/live.mp4');ws.binaryType='arraybuffer';\n"
+    " ws.onmessage=e=>{if(typeof e.data==='string'){sb=ms.addSourceBuffer(e.data);\n"
+    "  sb.mode='segments';sb.onupdateend=feed;return;}q.push(e.data);feed();};});\n"
+    "function feed(){if(!sb||sb.updating)return;const b=v.buffered;\n"
+    " if(!q.length){if(b.length&&v.currentTime-b.start(0)>30)sb.remove(b.start(0),v.currentTime-10);return;}\n"
+    " sb.appendBuffer(q.shift());\n"
+    " if(b.length){const end=b.end(b.length-1);\n"
+    "  if(end-v.currentTime>1||v.currentTime<b.start(0))v.currentTime=end-0.1;}}\n"
+    "</script></body></html>\n";
+
+/* ============================================================================
+ * SHA-1 / Base64（仅用于 WebSocket 握手）
+ * ============================================================================ */
+
+static uint32_t rol32(uint32_t v, int n)
+{
+    return (v << n) | (v >> (32 - n));
+}
+
+static void sha1_block(uint32_t h[5], const uint8_t *p)
+{
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++)
+        w[i] = ((uint32_t)p[4 * i] << 24) | ((uint32_t)p[4 * i + 1] << 16) |
+               ((uint32_t)p[4 * i + 2] << 8) | p[4 * i + 3];
+    for (int i = 16; i < 80; i++)
+        w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+        else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+        else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+        else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+        uint32_t t = rol32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rol32(b, 30);
+        b = a;
+        a = t;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+}
+
+static void sha1(const void *data, size_t len, uint8_t out[20])
+{
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    const uint8_t *p = (const uint8_t *)data;
+    size_t left = len;
+    while (left >= 64) {
+        sha1_block(h, p);
+        p    += 64;
+        left -= 64;
+    }
+
+    uint8_t tail[128];
+    memset(tail, 0, sizeof(tail));
+    memcpy(tail, p, left);
+    tail[left] = 0x80;
+    size_t tlen = (left < 56) ? 64 : 128;
+    uint64_t bits = (uint64_t)len * 8u;
+    for (int i = 0; i < 8; i++)
+        tail[tlen - 1 - i] = (uint8_t)(bits >> (8 * i));
+    sha1_block(h, tail);
+    if (tlen == 128) sha1_block(h, tail + 64);
+
+    for (int i = 0; i < 5; i++) {
+        out[4 * i]     = (uint8_t)(h[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(h[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(h[i] >> 8);
+        out[4 * i + 3] = (uint8_t)h[i];
+    }
+}
+
+static void base64_encode(const uint8_t *in, size_t len, char *out)
+{
+    static const char tbl[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t o = 0;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)in[i + 1] << 8;
+        if (i + 2 < len) v |= in[i + 2];
+        out[o++] = tbl[(v >> 18) & 0x3F];
+        out[o++] = tbl[(v >> 12) & 0x3F];
+        out[o++] = (i + 1 < len) ? tbl[(v >> 6) & 0x3F] : '=';
+        out[o++] = (i + 2 < len) ? tbl[v & 0x3F] : '=';
+    }
+    out[o] = '\0';
+}
+
+/* ============================================================================
+ * 客户端管理
+ * ============================================================================ */
+
+static uint64_t client_key(const LiveServer *srv, const LiveClient *c)
+{
+    return ((uint64_t)c->gen << 32) | (uint64_t)(c - srv->clients);
+}
+
+static void client_set_out(LiveServer *srv, LiveClient *c, bool on)
+{
+    if (c->want_out == on) return;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events   = EPOLLIN | EPOLLRDHUP | (on ? EPOLLOUT : 0);
+    ev.data.u64 = client_key(srv, c);
+    if (epoll_ctl(srv->epfd, EPOLL_CTL_MOD, c->fd, &ev) == 0)
+        c->want_out = on;
+}
+
+static void client_close(LiveServer *srv, LiveClient *c, const char *reason)
+{
+    if (c->state == LIVE_CLIENT_FREE) return;
+
+    if (c->state == LIVE_CLIENT_STREAM)
+        LOGI("[%s] #%u %s %s closed: %s", TAG, c->id, c->addr,
+             live_proto_name(c->proto), reason);
+
+    epoll_ctl(srv->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    free(c->obuf);
+
+    uint32_t gen = c->gen + 1;
+    memset(c, 0, sizeof(*c));
+    c->fd  = -1;
+    c->gen = gen;
+
+    int slot = (int)(c - srv->clients);
+    pthread_mutex_lock(&srv->stat_mtx);
+    srv->stat[slot].active = false;
+    pthread_mutex_unlock(&srv->stat_mtx);
+}
+
+static int obuf_append(LiveClient *c, const void *data, size_t len)
+{
+    if (c->olen + len > c->ocap) {
+        size_t cap = c->ocap ? c->ocap : 1024;
+        while (cap < c->olen + len) cap *= 2;
+        uint8_t *p = (uint8_t *)realloc(c->obuf, cap);
+        if (!p) return -1;
+        c->obuf = p;
+        c->ocap = cap;
+    }
+    memcpy(c->obuf + c->olen, data, len);
+    c->olen += len;
+    return 0;
+}
+
+/* 一次性响应：写入响应头与正文，发完后关闭 */
+static int respond(LiveClient *c, const char *status, const char *type,
+                   const char *body, size_t body_len)
+{
+    char hdr[256];
+    int n = snprintf(hdr, sizeof(hdr),
+                     "HTTP/1.1 %s\r\n"
+                     "Content-Type: %s\r\n"
+                     "Content-Length: %zu\r\n"
+                     "Access-Control-Allow-Origin: *\r\n"
+                     "Cache-Control: no-cache\r\n"
+                     "Connection: close\r\n\r\n",
+                     status, type, body_len);
+    c->state = LIVE_CLIENT_RESPONSE;
+    if (obuf_append(c, hdr, (size_t)n) != 0) return -1;
+    return obuf_append(c, body, body_len);
+}
+
+/*
+ * 参数集与关键帧都就绪时：发初始化段，从 GOP 缓存起点开始推流。
+ * 缓存的关键帧过旧时先请求新关键帧，等不到再从旧关键帧起播。
+ */
+static int client_start(LiveServer *srv, LiveClient *c)
+{
+    if (c->started) return 0;
+
+    uint64_t now = rkav_now_monotonic_us();
+    bool stale = srv->have_gop &&
+                 now - srv->ring[srv->gop_seq % LIVE_RING_SIZE]->arrival_us > LIVE_STALE_GOP_US;
+    if (!srv->have_gop || stale) {
+        atomic_store(&srv->want_key, 1);
+        if (!srv->have_gop || now - c->wait_us < LIVE_STALE_GOP_US) return 0;
+    }
+
+    uint8_t init[LIVE_INIT_MAX + 16];
+    if (c->proto == LIVE_PROTO_FLV) {
+        size_t n = live_mux_flv_init(&srv->mux, init, sizeof(init));
+        if (n == 0 || obuf_append(c, init, n) != 0) return -1;
+    } else {
+        char mime[64];
+        uint8_t hdr[10];
+        if (live_mux_mime(&srv->mux, mime, sizeof(mime)) != 0) return -1;
+        size_t hl = live_ws_frame_header(hdr, 1, strlen(mime));
+        if (obuf_append(c, hdr, hl) != 0 || obuf_append(c, mime, strlen(mime)) != 0)
+            return -1;
+
+        size_t n = live_mux_mp4_init(&srv->mux, init, sizeof(init));
+        if (n == 0) return -1;
+        hl = live_ws_frame_header(hdr, 2, n);
+        if (obuf_append(c, hdr, hl) != 0 || obuf_append(c, init, n) != 0)
+            return -1;
+    }
+
+    c->started  = true;
+    c->next_seq = srv->gop_seq;
+    c->item_off = 0;
+    c->join_us  = now;
+    svc_shed_init(&c->shed, srv->svc_layers);
+
+    int slot = (int)(c - srv->clients);
+    pthread_mutex_lock(&srv->stat_mtx);
+    srv->stat[slot].since_us = c->join_us;
+    pthread_mutex_unlock(&srv->stat_mtx);
+
+    atomic_fetch_add(&srv->served, 1);
+    LOGI("[%s] #%u %s %s start at seq=%llu (gop %llu pkts)", TAG, c->id, c->addr,
+         live_proto_name(c->proto), (unsigned long long)c->next_seq,
+         (unsigned long long)(srv->head_seq - c->next_seq));
+    return 0;
+}
+
+static void stat_add_bytes(LiveServer *srv, LiveClient *c, size_t n)
+{
+    int slot = (int)(c - srv->clients);
+    pthread_mutex_lock(&srv->stat_mtx);
+    srv->stat[slot].bytes_win   += n;
+    srv->stat[slot].bytes_total += n;
+    pthread_mutex_unlock(&srv->stat_mtx);
+}
+
+/**
+ * 尽量多地发送：控制数据 -> 分片（从 next_seq 的 item_off 处继续）。
+ * 返回 -1 表示连接已关闭。
+ */
+static int client_pump(LiveServer *srv, LiveClient *c)
+{
+    size_t sent = 0;
+    for (;;) {
+        ssize_t w;
+        if (c->ooff < c->olen) {
+            w = send(c->fd, c->obuf + c->ooff, c->olen - c->ooff, MSG_NOSIGNAL);
+            if (w > 0) {
+                c->ooff += (size_t)w;
+                sent    += (size_t)w;
+                if (c->ooff == c->olen) c->ooff = c->olen = 0;
+                continue;
+            }
+        } else if (c->state == LIVE_CLIENT_RESPONSE) {
+            client_close(srv, c, "done");
+            return -1;
+        } else if (c->started && c->next_seq < srv->head_seq) {
+            const LiveItem *it = srv->ring[c->next_seq % LIVE_RING_SIZE];
+            /* 包边界处按滞后丢时间层：落后越多，允许的最高层越低 */
+            if (c->item_off == 0 && srv->max_lag_us &&
+                svc_shed_drop(&c->shed, it->tlayer, (double)c->lag_us / (double)srv->max_lag_us)) {
+                c->next_seq++;
+                continue;
+            }
+            struct iovec iov[LIVE_ITEM_IOV];
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov    = iov;
+            msg.msg_iovlen = (size_t)live_item_iov(it, c->proto, c->item_off, iov);
+            w = sendmsg(c->fd, &msg, MSG_NOSIGNAL);
+            if (w > 0) {
+                c->item_off += (size_t)w;
+                sent        += (size_t)w;
+                if (c->item_off >= it->total[c->proto]) {
+                    c->next_seq++;
+                    c->item_off = 0;
+                }
+                continue;
+            }
+        } else {
+            client_set_out(srv, c, false);
+            break;
+        }
+
+        /* w <= 0 */
+        if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            client_set_out(srv, c, true);
+            break;
+        }
+        if (w < 0 && errno == EINTR) continue;
+        if (sent) stat_add_bytes(srv, c, sent);
+        client_close(srv, c, w < 0 ? strerror(errno) : "send returned 0");
+        return -1;
+    }
+    if (sent) stat_add_bytes(srv, c, sent);
+    return 0;
+}
+
+/* 解析 HTTP 请求并路由 */
+static int handle_request(LiveServer *srv, LiveClient *c)
+{
+    char method[8], path[256];
+    if (sscanf(c->rbuf, "%7s %255s", method, path) != 2) {
+        static const char msg[] = "bad request\n";
+        return respond(c, "400 Bad Request", "text/plain", msg, sizeof(msg) - 1);
+    }
+    char *q = strchr(path, '?');
+    if (q) *q = '\0';
+
+    if (strcmp(method, "GET") != 0) {
+        static const char msg[] = "method not allowed\n";
+        return respond(c, "405 Method Not Allowed", "text/plain", msg, sizeof(msg) - 1);
+    }
+
+    if (strcmp(path, "/live.flv") == 0) {
+        static const char hdr[] =
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: video/x-flv\r\n"
+            "Transfer-Encoding: chunked\r\n"
+            "Access-Control-Allow-Origin: *\r\n"
+            "Cache-Control: no-cache\r\n"
+            "Connection: close\r\n\r\n";
+        c->state = LIVE_CLIENT_STREAM;
+        c->proto = LIVE_PROTO_FLV;
+        if (obuf_append(c, hdr, sizeof(hdr) - 1) != 0) return -1;
+    } else if (strcmp(path, "/live.mp4") == 0) {
+        const char *up  = strcasestr(c->rbuf, "\nUpgrade:");
+        const char *key = strcasestr(c->rbuf, "\nSec-WebSocket-Key:");
+        if (!up || !strcasestr(up, "websocket") || !key) {
+            static const char msg[] = "websocket upgrade required\n";
+            return respond(c, "426 Upgrade Required", "text/plain", msg, sizeof(msg) - 1);
+        }
+        key += strlen("\nSec-WebSocket-Key:");
+        while (*key == ' ' || *key == '\t') key++;
+        size_t klen = strcspn(key, " \t\r\n");
+
+        char    src[128];
+        uint8_t digest[20];
+        char    accept[32];
+        if (klen == 0 || klen + sizeof(WS_GUID) > sizeof(src)) return -1;
+        memcpy(src, key, klen);
+        memcpy(src + klen, WS_GUID, sizeof(WS_GUID));
+        sha1(src, strlen(src), digest);
+        base64_encode(digest, sizeof(digest), accept);
+
+        char hdr[256];
+        int n = snprintf(hdr, sizeof(hdr),
+                         "HTTP/1.1 101 Switching Protocols\r\n"
+                         "Upgrade: websocket\r\n"
+                         "Connection: Upgrade\r\n"
+                         "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+        c->state = LIVE_CLIENT_STREAM;
+        c->proto = LIVE_PROTO_WS;
+        if (obuf_append(c, hdr, (size_t)n) != 0) return -1;
+    } else if (strcmp(path, "/stats") == 0) {
+        char body[1024];
+        int off = snprintf(body, sizeof(body),
+                           "seq=%llu gop=%s clients_served=%llu kicked=%llu inbox_drops=%llu\n",
+                           (unsigned long long)srv->head_seq, srv->have_gop ? "yes" : "no",
+                           (unsigned long long)atomic_load(&srv->served),
+                           (unsigned long long)atomic_load(&srv->kicked),
+                           (unsigned long long)atomic_load(&srv->inbox_drops));
+        pthread_mutex_lock(&srv->stat_mtx);
+        for (int i = 0; i < LIVE_MAX_CLIENTS && off < (int)sizeof(body); i++) {
+            const LiveClientStat *s = &srv->stat[i];
+            if (!s->active) continue;
+            off += snprintf(body + off, sizeof(body) - (size_t)off,
+                            "#%u %s %s total=%lluB lag=%.1fms\n", s->id, s->addr,
+                            live_proto_name(s->proto), (unsigned long long)s->bytes_total,
+                            (double)s->lag_us / 1000.0);
+        }
+        pthread_mutex_unlock(&srv->stat_mtx);
+        if (off >= (int)sizeof(body)) off = (int)sizeof(body) - 1;
+        return respond(c, "200 OK", "text/plain", body, (size_t)off);
+    } else if (strcmp(path, "/metrics") == 0 && srv->metrics_fn) {
+        char *body = (char *)malloc(LIVE_METRICS_MAX);
+        if (!body) return -1;
+        size_t len = srv->metrics_fn(srv->metrics_ud, body, LIVE_METRICS_MAX);
+        int r = respond(c, "200 OK", "text/plain; version=0.0.4", body, len);
+        free(body);
+        return r;
+    } else if (strcmp(path, "/") == 0 || strcmp(path, "/index.html") == 0) {
+        return respond(c, "200 OK", "text/html; charset=utf-8",
+                       s_index_html, sizeof(s_index_html) - 1);
+    } else {
+        static const char msg[] = "not found\n";
+        return respond(c, "404 Not Found", "text/plain", msg, sizeof(msg) - 1);
+    }
+
+    /* 推流连接 */
+    int slot = (int)(c - srv->clients);
+    pthread_mutex_lock(&srv->stat_mtx);
+    memset(&srv->stat[slot], 0, sizeof(srv->stat[slot]));
+    srv->stat[slot].active = true;
+    srv->stat[slot].id     = c->id;
+    srv->stat[slot].proto  = c->proto;
+    memcpy(srv->stat[slot].addr, c->addr, sizeof(c->addr));
+    pthread_mutex_unlock(&srv->stat_mtx);
+
+    LOGI("[%s] #%u %s %s connected", TAG, c->id, c->addr, live_proto_name(c->proto));
+    c->wait_us = rkav_now_monotonic_us();
+    return client_start(srv, c);
+}
+
+/* 解析客户端发来的 WebSocket 帧：只关心 close，其余丢弃 */
+static int ws_consume(LiveClient *c)
+{
+    size_t pos = 0;
+    while (c->rlen - pos >= 2) {
+        const uint8_t *p = (const uint8_t *)c->rbuf + pos;
+        int      op  = p[0] & 0x0F;
+        uint64_t len = p[1] & 0x7F;
+        size_t   hl  = 2;
+        if (len == 126) {
+            if (c->rlen - pos < 4) break;
+            len = ((uint64_t)p[2] << 8) | p[3];
+            hl  = 4;
+        } else if (len == 127) {
+            if (c->rlen - pos < 10) break;
+            len = 0;
+            for (int i = 0; i < 8; i++) len = (len << 8) | p[2 + i];
+            hl  = 10;
+        }
+        if (p[1] & 0x80) hl += 4;   /* masking key */
+        if (op == 8) return -1;     /* close */
+        if (hl + len > sizeof(c->rbuf)) return -1;
+        if (c->rlen - pos < hl + len) break;
+        pos += hl + (size_t)len;
+    }
+    memmove(c->rbuf, c->rbuf + pos, c->rlen - pos);
+    c->rlen -= pos;
+    return 0;
+}
+
+static void client_on_readable(LiveServer *srv, LiveClient *c)
+{
+    for (;;) {
+        size_t room = sizeof(c->rbuf) - 1 - c->rlen;
+        if (room == 0) {
+            if (c->state == LIVE_CLIENT_REQUEST) {
+                client_close(srv, c, "request too large");
+                return;
+            }
+            c->rlen = 0;    /* FLV 客户端不应再发数据，直接丢弃 */
+            room = sizeof(c->rbuf) - 1;
+        }
+        ssize_t r = recv(c->fd, c->rbuf + c->rlen, room, 0);
+        if (r == 0) {
+            client_close(srv, c, "peer closed");
+            return;
+        }
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            client_close(srv, c, strerror(errno));
+            return;
+        }
+        c->rlen += (size_t)r;
+        c->rbuf[c->rlen] = '\0';
+
+        if (c->state == LIVE_CLIENT_REQUEST) {
+            if (!strstr(c->rbuf, "\r\n\r\n")) continue;
+            if (handle_request(srv, c) != 0) {
+                client_close(srv, c, "request failed");
+                return;
+            }
+            c->rlen = 0;
+            if (client_pump(srv, c) != 0) return;
+        } else if (c->state == LIVE_CLIENT_STREAM && c->proto == LIVE_PROTO_WS) {
+            if (ws_consume(c) != 0) {
+                client_close(srv, c, "ws close");
+                return;
+            }
+        } else {
+            c->rlen = 0;
+        }
+    }
+}
+
+static void accept_clients(LiveServer *srv)
+{
+    for (;;) {
+        struct sockaddr_in sa;
+        socklen_t sl = sizeof(sa);
+        int fd = accept4(srv->listen_fd, (struct sockaddr *)&sa, &sl,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                LOGW("[%s] accept failed: %s", TAG, strerror(errno));
+            return;
+        }
+
+        LiveClient *c = NULL;
+        for (int i = 0; i < LIVE_MAX_CLIENTS; i++) {
+            if (srv->clients[i].state == LIVE_CLIENT_FREE) {
+                c = &srv->clients[i];
+                break;
+            }
+        }
+        if (!c) {
+            static const char busy[] =
+                "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n"
+                "Connection: close\r\n\r\n";
+            ssize_t w = send(fd, busy, sizeof(busy) - 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+            (void)w;
+            close(fd);
+            LOGW("[%s] too many clients, rejected", TAG);
+            continue;
+        }
+
+        int one = 1;
+        int sndbuf = LIVE_SNDBUF;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+        c->state = LIVE_CLIENT_REQUEST;
+        c->fd    = fd;
+        c->id    = ++srv->next_id;
+        char ip[INET_ADDRSTRLEN] = "?";
+        inet_ntop(AF_INET, &sa.sin_addr, ip, sizeof(ip));
+        snprintf(c->addr, sizeof(c->addr), "%s:%u", ip, (unsigned)ntohs(sa.sin_port));
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events   = EPOLLIN | EPOLLRDHUP;
+        ev.data.u64 = client_key(srv, c);
+        if (epoll_ctl(srv->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            LOGW("[%s] epoll add failed: %s", TAG, strerror(errno));
+            close(fd);
+            c->state = LIVE_CLIENT_FREE;
+            c->fd    = -1;
+        }
+    }
+}
+
+/* ============================================================================
+ * 入库与慢客户端处理
+ * ============================================================================ */
+
+static void ingest(LiveServer *srv, EncodedPacket *ep, uint64_t now_us)
+{
+    LiveItem *it = live_item_create(&srv->mux, ep, srv->head_seq, now_us);
+    if (!it) return;
+
+    /* 缓冲满：淘汰最老的一项，仍停留在该项上的客户端已跟不上，断开 */
+    if (srv->head_seq - srv->tail_seq >= LIVE_RING_SIZE) {
+        for (int i = 0; i < LIVE_MAX_CLIENTS; i++) {
+            LiveClient *c = &srv->clients[i];
+            if (c->state == LIVE_CLIENT_STREAM && c->started && c->next_seq <= srv->tail_seq) {
+                atomic_fetch_add(&srv->kicked, 1);
+                client_close(srv, c, "fell out of buffer");
+            }
+        }
+        if (srv->have_gop && srv->gop_seq == srv->tail_seq)
+            srv->have_gop = false;
+        LiveItem **slot = &srv->ring[srv->tail_seq % LIVE_RING_SIZE];
+        live_item_free(*slot);
+        *slot = NULL;
+        srv->tail_seq++;
+    }
+
+    srv->ring[srv->head_seq % LIVE_RING_SIZE] = it;
+    if (it->key && live_mux_ready(&srv->mux)) {
+        srv->gop_seq  = srv->head_seq;
+        srv->have_gop = true;
+    }
+    srv->head_seq++;
+
+    for (int i = 0; i < LIVE_MAX_CLIENTS; i++) {
+        LiveClient *c = &srv->clients[i];
+        if (c->state != LIVE_CLIENT_STREAM) continue;
+        if (!c->started && client_start(srv, c) != 0) {
+            client_close(srv, c, "init segment failed");
+            continue;
+        }
+        /* 已在等 EPOLLOUT 的客户端由可写事件驱动 */
+        if (!c->want_out)
+            client_pump(srv, c);
+    }
+}
+
+/*
+ * 滞后 = 当前时刻 - 下一个待发包的入库时刻；GOP 缓存中的旧包以开始推流时刻为准，
+ * 新客户端有 max_lag 的时间消化首个 GOP 的突发。
+ */
+static void check_clients(LiveServer *srv, uint64_t now_us)
+{
+    for (int i = 0; i < LIVE_MAX_CLIENTS; i++) {
+        LiveClient *c = &srv->clients[i];
+        if (c->state != LIVE_CLIENT_STREAM || !c->started) continue;
+
+        uint64_t lag = 0;
+        if (c->next_seq < srv->head_seq) {
+            const LiveItem *it = srv->ring[c->next_seq % LIVE_RING_SIZE];
+            uint64_t ref = it->arrival_us > c->join_us ? it->arrival_us : c->join_us;
+            lag = now_us > ref ? now_us - ref : 0;
+        }
+        c->lag_us = lag;
+
+        pthread_mutex_lock(&srv->stat_mtx);
+        srv->stat[i].lag_us   = lag;
+        srv->stat[i].shed_total = c->shed.shed;
+        srv->stat[i].max_tid  = c->shed.max_tid;
+        pthread_mutex_unlock(&srv->stat_mtx);
+
+        if (srv->max_lag_us && lag > srv->max_lag_us) {
+            LOGW("[%s] #%u %s lag %.0fms > %.0fms, disconnecting", TAG, c->id, c->addr,
+                 (double)lag / 1000.0, (double)srv->max_lag_us / 1000.0);
+            atomic_fetch_add(&srv->kicked, 1);
+            client_close(srv, c, "too slow");
+        }
+    }
+}
+
+/* ============================================================================
+ * 公共接口
+ * ============================================================================ */
+
+int live_server_init(LiveServer *srv, int port, int fps, int width, int height,
+                     uint64_t max_lag_us, int svc_layers)
+{
+    if (!srv || port <= 0 || port > 65535) return -1;
+
+    memset(srv, 0, sizeof(*srv));
+    srv->listen_fd  = -1;
+    srv->epfd       = -1;
+    srv->evfd       = -1;
+    srv->port       = port;
+    srv->max_lag_us = max_lag_us;
+    srv->svc_layers = svc_layers > 0 ? svc_layers : 1;
+    svc_shed_init(&srv->pub_shed, srv->svc_layers);
+    for (int i = 0; i < LIVE_MAX_CLIENTS; i++)
+        srv->clients[i].fd = -1;
+    live_mux_init(&srv->mux, fps, width, height);
+    pthread_mutex_init(&srv->stat_mtx, NULL);
+
+    if (bq_init(&srv->inbox, LIVE_INBOX_SIZE) != 0) {
+        LOGE("[%s] inbox init failed", TAG);
+        pthread_mutex_destroy(&srv->stat_mtx);
+        return -1;
+    }
+
+    srv->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (srv->listen_fd < 0) {
+        LOGE("[%s] socket failed: %s", TAG, strerror(errno));
+        goto fail;
+    }
+    int one = 1;
+    setsockopt(srv->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family      = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_ANY);
+    sa.sin_port        = htons((uint16_t)port);
+    if (bind(srv->listen_fd, (struct sockaddr *)&sa, sizeof(sa)) != 0 ||
+        listen(srv->listen_fd, 16) != 0) {
+        LOGE("[%s] bind/listen :%d failed: %s", TAG, port, strerror(errno));
+        goto fail;
+    }
+
+    srv->epfd = epoll_create1(EPOLL_CLOEXEC);
+    srv->evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (srv->epfd < 0 || srv->evfd < 0) {
+        LOGE("[%s] epoll/eventfd failed: %s", TAG, strerror(errno));
+        goto fail;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events   = EPOLLIN;
+    ev.data.u64 = KEY_LISTEN;
+    if (epoll_ctl(srv->epfd, EPOLL_CTL_ADD, srv->listen_fd, &ev) != 0)
+        goto fail;
+    ev.data.u64 = KEY_EVENT;
+    if (epoll_ctl(srv->epfd, EPOLL_CTL_ADD, srv->evfd, &ev) != 0)
+        goto fail;
+
+    LOGI("[%s] listening on :%d (/live.flv, /live.mp4 websocket, /stats, /metrics) max_lag=%llums",
+         TAG, port, (unsigned long long)(max_lag_us / 1000u));
+    return 0;
+
+fail:
+    if (srv->listen_fd >= 0) close(srv->listen_fd);
+    if (srv->epfd >= 0) close(srv->epfd);
+    if (srv->evfd >= 0) close(srv->evfd);
+    srv->listen_fd = srv->epfd = srv->evfd = -1;
+    bq_destroy(&srv->inbox);
+    pthread_mutex_destroy(&srv->stat_mtx);
+    return -1;
+}
+
+void live_server_set_metrics(LiveServer *srv, LiveMetricsFn fn, void *ud)
+{
+    if (!srv) return;
+    srv->metrics_fn = fn;
+    srv->metrics_ud = ud;
+}
+
+void live_server_run(LiveServer *srv)
+{
+    if (!srv || srv->epfd < 0) return;
+
+    struct epoll_event evs[16];
+    while (!atomic_load(&srv->stop)) {
+        int n = epoll_wait(srv->epfd, evs, 16, 100);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOGE("[%s] epoll_wait failed: %s", TAG, strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            uint64_t key = evs[i].data.u64;
+            if (key == KEY_LISTEN) {
+                accept_clients(srv);
+            } else if (key == KEY_EVENT) {
+                uint64_t cnt;
+                ssize_t r = read(srv->evfd, &cnt, sizeof(cnt));
+                (void)r;
+                uint64_t now = rkav_now_monotonic_us();
+                void *item = NULL;
+                while (bq_pop_timeout(&srv->inbox, &item, 0) == 1)
+                    ingest(srv, (EncodedPacket *)item, now);
+            } else {
+                uint32_t slot = (uint32_t)key;
+                uint32_t gen  = (uint32_t)(key >> 32);
+                if (slot >= LIVE_MAX_CLIENTS) continue;
+                LiveClient *c = &srv->clients[slot];
+                if (c->state == LIVE_CLIENT_FREE || c->gen != gen) continue;
+
+                if (evs[i].events & EPOLLIN)
+                    client_on_readable(srv, c);
+                if (c->state == LIVE_CLIENT_FREE || c->gen != gen) continue;
+                if (evs[i].events & (EPOLLERR | EPOLLHUP)) {
+                    client_close(srv, c, "socket error");
+                    continue;
+                }
+                if (evs[i].events & EPOLLOUT)
+                    client_pump(srv, c);
+            }
+        }
+
+        check_clients(srv, rkav_now_monotonic_us());
+    }
+}
+
+void live_server_stop(LiveServer *srv)
+{
+    if (!srv) return;
+    atomic_store(&srv->stop, 1);
+    bq_close(&srv->inbox);
+    if (srv->evfd >= 0) {
+        uint64_t one = 1;
+        ssize_t w = write(srv->evfd, &one, sizeof(one));
+        (void)w;
+    }
+}
+
+void live_server_publish(LiveServer *srv, EncodedPacket *ep)
+{
+    if (!srv || !ep) return;
+
+    /* 丢过参考帧后，后续包在下一个关键帧之前都无法解码，不必入库 */
+    if (srv->pub_wait_key && !ep->is_keyframe) {
+        atomic_fetch_add(&srv->inbox_drops, 1);
+        atomic_store(&srv->want_key, 1);
+        return;
+    }
+    srv->pub_wait_key = false;
+
+    double fill = (double)bq_size(&srv->inbox) / (double)bq_capacity(&srv->inbox);
+    if (svc_shed_drop(&srv->pub_shed, ep->temporal_id, fill)) {
+        atomic_fetch_add(&srv->inbox_drops, 1);
+        return;
+    }
+
+    encoded_packet_ref(ep);
+    if (bq_try_push(&srv->inbox, ep) != 0) {
+        encoded_packet_unref(ep);
+        atomic_fetch_add(&srv->inbox_drops, 1);
+        /* 最高时间层不被参考，其余层（含不分层时的 P 帧）丢了就得等关键帧 */
+        if (ep->temporal_id + 1 < srv->svc_layers || srv->svc_layers == 1) {
+            srv->pub_wait_key = true;
+            atomic_store(&srv->want_key, 1);
+        }
+        return;
+    }
+    uint64_t one = 1;
+    ssize_t w = write(srv->evfd, &one, sizeof(one));
+    (void)w;
+}
+
+bool live_server_take_key_request(LiveServer *srv)
+{
+    return srv && atomic_exchange(&srv->want_key, 0) != 0;
+}
+
+void live_server_tick_print(LiveServer *srv)
+{
+    if (!srv) return;
+
+    int active = 0;
+    pthread_mutex_lock(&srv->stat_mtx);
+    for (int i = 0; i < LIVE_MAX_CLIENTS; i++) {
+        LiveClientStat *s = &srv->stat[i];
+        if (!s->active) continue;
+        active++;
+        LOGI("[LIVE] #%u %s %s %.0fkbps lag=%.1fms tl<=%d shed=%llu", s->id, s->addr,
+             live_proto_name(s->proto), (double)s->bytes_win * 8.0 / 1000.0,
+             (double)s->lag_us / 1000.0, s->max_tid, (unsigned long long)s->shed_total);
+        s->bytes_win = 0;
+    }
+    pthread_mutex_unlock(&srv->stat_mtx);
+
+    LOGI("[LIVE] clients=%d served=%llu kicked=%llu inbox=%zu/%zu drops=%llu",
+         active,
+         (unsigned long long)atomic_load(&srv->served),
+         (unsigned long long)atomic_load(&srv->kicked),
+         bq_size(&srv->inbox), bq_capacity(&srv->inbox),
+         (unsigned long long)atomic_load(&srv->inbox_drops));
+}
+
+void live_server_deinit(LiveServer *srv)
+{
+    if (!srv || srv->epfd < 0) return;
+
+    for (int i = 0; i < LIVE_MAX_CLIENTS; i++)
+        client_close(srv, &srv->clients[i], "server stopped");
+
+    void *item = NULL;
+    bq_close(&srv->inbox);
+    while (bq_pop_timeout(&srv->inbox, &item, 0) == 1)
+        encoded_packet_unref((EncodedPacket *)item);
+    bq_destroy(&srv->inbox);
+
+    for (uint64_t s = srv->tail_seq; s < srv->head_seq; s++) {
+        live_item_free(srv->ring[s % LIVE_RING_SIZE]);
+        srv->ring[s % LIVE_RING_SIZE] = NULL;
+    }
+
+    close(srv->listen_fd);
+    close(srv->epfd);
+    close(srv->evfd);
+    srv->listen_fd = srv->epfd = srv->evfd = -1;
+    pthread_mutex_destroy(&srv->stat_mtx);
+}
@@ -0,0 +1,212 @@
+/**
+ * @file live_server.h
+ * @brief 局域网直播预览服务（HTTP-FLV / WebSocket fMP4）头文件
+ *
+ * 单线程 epoll HTTP 服务，浏览器无需 RTSP 插件即可低延迟预览：
+ * - GET /live.flv   chunked HTTP-FLV（flv.js / mpegts.js）
+ * - GET /live.mp4   WebSocket Upgrade，先发 MIME 文本帧，再发 fMP4 初始化段与分片（MSE）
+ * - GET /stats      纯文本客户端统计
+ * - GET /metrics    Prometheus 文本格式指标（由 live_server_set_metrics() 提供，见 proc_mon.h / frame_stats.h）
+ * - GET /           内置 MSE 预览页
+ *
+ * 数据流：
+ * 编码线程调用 live_server_publish() 为包增加一个引用并非阻塞地投入收件箱；
+ * 服务线程把包预封装后放进环形缓冲（GOP 缓存，按引用持有），
+ * 新客户端从最近一个关键帧开始发送，所有客户端共享同一份包数据（writev，无拷贝）。
+ * 缓存中没有关键帧或关键帧已超过 LIVE_STALE_GOP_US（长 GOP 模式），服务向编码线程请求 IDR
+ * （live_server_take_key_request），最多再等 LIVE_STALE_GOP_US 后从旧关键帧起播。
+ *
+ * 慢客户端不会反压管线：
+ * - 时间分层编码时，收件箱与每个客户端都按压力先丢最高时间层（帧率逐级减半，画面不花）
+ * - 收件箱满时丢弃本包（只影响直播，不影响录像）；丢的是参考帧时，直到下一个关键帧前都不再入库
+ * - 客户端待发送的包已被环形缓冲淘汰，或滞后超过 max_lag，直接断开
+ *
+ * 典型使用流程：
+ * 1. live_server_init()      - 监听端口
+ * 2. 服务线程: live_server_run()
+ * 3. 编码线程: live_server_publish()
+ * 4. 统计线程: live_server_tick_print()
+ * 5. live_server_stop() -> join -> live_server_deinit()
+ */
+#pragma once
+
+#include "live_mux.h"
+#include "svc_shed.h"
+#include "rkav/bqueue.h"
+#include "rkav/types.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 最大同时在线客户端数 */
+#define LIVE_MAX_CLIENTS    8
+
+/** 环形缓冲（GOP 缓存）容量，需大于一个 GOP 的包数 */
+#define LIVE_RING_SIZE      256
+
+/** 编码线程 -> 服务线程收件箱容量 */
+#define LIVE_INBOX_SIZE     64
+
+/** 客户端 socket 发送缓冲：限制内核中积压的数据，让滞后在用户态可见 */
+#define LIVE_SNDBUF         (256 * 1024)
+
+/** GOP 缓存起点超过该时长视为过旧：新客户端请求新关键帧 */
+#define LIVE_STALE_GOP_US   2000000u
+
+/** HTTP 请求 / WS 控制帧读缓冲 */
+#define LIVE_RBUF_SIZE      2048
+
+/**
+ * @brief 客户端连接状态
+ */
+typedef enum {
+    LIVE_CLIENT_FREE = 0,   /**< 空闲槽位 */
+    LIVE_CLIENT_REQUEST,    /**< 正在读 HTTP 请求头 */
+    LIVE_CLIENT_RESPONSE,   /**< 一次性响应（/stats、/、404），发完即关闭 */
+    LIVE_CLIENT_STREAM,     /**< 推流中 */
+} LiveClientState;
+
+/**
+ * @brief 客户端连接（仅服务线程访问）
+ */
+typedef struct {
+    LiveClientState state;
+    int             fd;
+    uint32_t        gen;            /**< 槽位代数，防止 epoll 事件命中已复用的槽位 */
+    uint32_t        id;             /**< 连接编号（日志与统计） */
+    LiveProto       proto;
+    char            addr[48];       /**< 对端地址 ip:port */
+
+    char            rbuf[LIVE_RBUF_SIZE];
+    size_t          rlen;
+
+    uint8_t        *obuf;           /**< 控制数据（响应头 / 初始化段），先于分片发送 */
+    size_t          olen;
+    size_t          ooff;
+    size_t          ocap;
+
+    bool            started;        /**< 是否已发初始化段并开始发分片 */
+    uint64_t        next_seq;       /**< 下一个待发送的包序号 */
+    size_t          item_off;       /**< next_seq 包已发送的字节数（部分写） */
+    uint64_t        join_us;        /**< 开始推流的时刻（GOP 缓存突发不计入滞后） */
+    uint64_t        wait_us;        /**< 请求推流的时刻（等待关键帧的起点） */
+    bool            want_out;       /**< 是否已注册 EPOLLOUT */
+    uint64_t        lag_us;         /**< 当前滞后 */
+    SvcShed         shed;           /**< 按滞后丢时间层 */
+} LiveClient;
+
+/**
+ * @brief 客户端统计快照（服务线程写，统计线程读，stat_mtx 保护）
+ */
+typedef struct {
+    bool      active;
+    uint32_t  id;
+    LiveProto proto;
+    char      addr[48];
+    uint64_t  bytes_win;            /**< 本统计窗口发送字节 */
+    uint64_t  bytes_total;          /**< 累计发送字节 */
+    uint64_t  lag_us;               /**< 最近一次计算的滞后 */
+    uint64_t  shed_total;           /**< 累计按时间层跳过的包 */
+    int       max_tid;              /**< 当前允许的最高时间层 */
+    uint64_t  since_us;             /**< 连接开始推流时刻 */
+} LiveClientStat;
+
+/**
+ * @brief /metrics 正文生成回调：写入 buf（最多 cap 字节），返回长度
+ */
+typedef size_t (*LiveMetricsFn)(void *ud, char *buf, size_t cap);
+
+/** /metrics 正文缓冲大小 */
+#define LIVE_METRICS_MAX    16384
+
+/**
+ * @brief 直播服务上下文
+ */
+typedef struct {
+    int             listen_fd;
+    int             epfd;
+    int             evfd;           /**< 收件箱非空 / 停止通知 */
+    int             port;
+    uint64_t        max_lag_us;     /**< 客户端最大允许滞后 */
+    int             svc_layers;     /**< 码流时间层数（1 = 不分层） */
+    atomic_int      stop;
+
+    BQueue          inbox;          /**< EncodedPacket*（每个持有一个引用） */
+    SvcShed         pub_shed;       /**< 发布侧（编码线程）按收件箱占用丢时间层 */
+    bool            pub_wait_key;   /**< 发布侧丢过参考帧，等待下一个关键帧 */
+    atomic_int      want_key;       /**< 需要关键帧（新客户端 / 丢过参考帧），编码线程取走 */
+    LiveMux         mux;
+
+    LiveItem       *ring[LIVE_RING_SIZE];
+    uint64_t        head_seq;       /**< 下一个入库序号 */
+    uint64_t        tail_seq;       /**< 最老的仍在缓冲中的序号 */
+    uint64_t        gop_seq;        /**< 最近关键帧序号 */
+    bool            have_gop;       /**< gop_seq 是否有效（关键帧仍在缓冲中且参数集就绪） */
+
+    LiveClient      clients[LIVE_MAX_CLIENTS];
+    uint32_t        next_id;
+
+    /* 统计 */
+    pthread_mutex_t stat_mtx;
+    LiveClientStat  stat[LIVE_MAX_CLIENTS];
+    atomic_uint_fast64_t inbox_drops;   /**< 收件箱满丢弃的包（累计） */
+    atomic_uint_fast64_t kicked;        /**< 因慢被断开的客户端（累计） */
+    atomic_uint_fast64_t served;        /**< 累计推流连接数 */
+
+    LiveMetricsFn   metrics_fn;     /**< /metrics 回调（NULL = 404） */
+    void           *metrics_ud;
+} LiveServer;
+
+/**
+ * @brief 初始化服务并开始监听（0.0.0.0:port）
+ *
+ * @param srv        服务上下文
+ * @param port       TCP 端口
+ * @param fps        标称帧率
+ * @param width      视频宽
+ * @param height     视频高
+ * @param max_lag_us 客户端最大允许滞后（超过即断开）
+ * @param svc_layers 码流时间层数（1 = 不分层）
+ * @return int       0 成功，-1 失败
+ */
+int  live_server_init(LiveServer *srv, int port, int fps, int width, int height,
+                      uint64_t max_lag_us, int svc_layers);
+
+/** 设置 /metrics 回调，须在服务线程启动前调用；回调在服务线程中执行 */
+void live_server_set_metrics(LiveServer *srv, LiveMetricsFn fn, void *ud);
+
+/** 服务线程主循环，直到 live_server_stop() */
+void live_server_run(LiveServer *srv);
+
+/** 请求服务线程退出（任意线程可调用） */
+void live_server_stop(LiveServer *srv);
+
+/**
+ * @brief 发布一个编码包（编码线程调用，从不阻塞）
+ *
+ * 内部增加一个引用；收件箱满时丢弃并计数。只能由单一线程调用。
+ */
+void live_server_publish(LiveServer *srv, EncodedPacket *ep);
+
+/**
+ * @brief 取走关键帧请求（编码线程每帧调用）
+ *
+ * @return true 有客户端在等关键帧，编码器应尽快插入 IDR
+ */
+bool live_server_take_key_request(LiveServer *srv);
+
+/** 打印每个客户端的吞吐与滞后（统计线程每秒调用） */
+void live_server_tick_print(LiveServer *srv);
+
+/** 关闭所有连接并释放缓冲（服务线程退出后调用） */
+void live_server_deinit(LiveServer *srv);
+
+#ifdef __cplusplus
+}
+#endif
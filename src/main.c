@@ -15,6 +15,8 @@
  * │ (麦克风)    │     │ (g_aud_q)    │
  * └─────────────┘     └──────────────┘
  *
+ * 多麦克风（--mic-dev）：每路 ALSA 采集 ──> g_mic_q[i] ──> 对齐/混音 ──> g_aud_q
+ *
  * 线程模型：
  * - signal_thread:        捕获 SIGINT/SIGTERM 实现优雅退出
  * - timer_thread:         定时器线程，到达指定时长后触发停止
@@ -24,6 +26,17 @@
  * - audio_capture_thread: ALSA 音频采集，打时间戳后推入音频队列
  * - h264_sink_thread:     从 H264 队列取数据，写入文件
  * - pcm_sink_thread:      从音频队列取数据，写入 PCM 文件
+ * - frame_sync_thread:    （可选，--sync-dev）多摄像头帧对齐，主摄像头帧转交编码，其余各路只做同步统计
+ * - audio_mix_thread:     （可选，--mic-dev）多路采集按 PTS 对齐、混音后推入音频队列
+ * - live_server_thread:   （可选，--live-port）浏览器预览服务，编码包按引用共享给所有客户端
+ * - rtp_out_thread:       （可选，--rtp）RTP/UDP 输出，按帧类别附加 FEC 修复包
+ * - ctl_thread:           （可选，--ctl）运行时控制通道，执行 mask 等控制命令
+ *
+ * 启动顺序（首帧时间直接决定事件触发录像漏录多少）：
+ * 队列等采集线程依赖的状态就绪后，摄像头（open / S_FMT / REQBUFS / STREAMON）、麦克风与
+ * MPP 编码器（enc_boot 线程）立即并行初始化，主线程同时完成其余服务（控制通道、预览、RTP、
+ * 录像目录 WAL 重放等），之后汇合编码器并启动其余线程。各阶段耗时由 boot_trace 记录，
+ * 首次写盘后输出一次 [BOOT] 报告；--boot-serial 退回逐个启动，用于对照。
  *
  * PTS（Presentation Time Stamp）策略：
  * - 视频：每帧在采集点使用 CLOCK_MONOTONIC 打时间戳
@@ -31,22 +44,44 @@
  */
 
 #include "app_config.h"
+#include "boot_trace.h"
 #include "log.h"
 #include "v4l2_capture.h"
 #include "audio_capture.h"
 #include "encoder_mpp.h"
 #include "av_stats.h"
+#include "frame_sync.h"
+#include "audio_mix.h"
+#include "crc32c.h"
+#include "rec_index.h"
+#include "rec_catalog.h"
+#include "rec_crypt.h"
+#include "live_server.h"
+#include "rtp.h"
+#include "svc_shed.h"
+#include "smart_gop.h"
+#include "frame_pacer.h"
+#include "proc_mon.h"
+#include "privacy_mask.h"
+#include "frame_stats.h"
+#include "ctl.h"
+#include "timing_trace.h"
+#include "storage.h"
 
 #include "rkav/bqueue.h"
+#include "rkav/packet.h"
 #include "rkav/types.h"
 #include "rkav/time.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include <signal.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdatomic.h>
+#include <time.h>
 
 /* ============================================================================
  * 全局变量定义
@@ -92,6 +127,172 @@ static BQueue g_h264_q;
  */
 static BQueue g_aud_q;
 
+/**
+ * @brief 多摄像头模式下各路摄像头的 raw 队列
+ * 
+ * 仅在配置了 --sync-dev 时使用：每路采集线程推入自己的队列，
+ * 由 frame_sync_thread 对齐后把主摄像头（cam0）的帧转交 g_raw_vq，其余各路帧只用于同步统计。
+ */
+static BQueue g_cam_q[FRAME_SYNC_MAX_CAMS];
+
+/** 参与同步的摄像头总数（0 表示未启用多摄像头同步） */
+static int g_cam_count;
+
+/** 多摄像头帧同步器 */
+static FrameSync g_sync;
+
+/**
+ * @brief 多麦克风模式下各路采集设备的音频队列
+ * 
+ * 仅在配置了 --mic-dev 时使用：每路采集线程推入自己的队列，
+ * 由 audio_mix_thread 对齐混音后推入 g_aud_q。
+ */
+static BQueue g_mic_q[AUDIO_MIX_MAX_DEVS];
+
+/** 参与混音的采集设备总数（0 表示未启用多麦克风混音） */
+static int g_mic_count;
+
+/** 多麦克风混音器 */
+static AudioMixer g_mixer;
+
+/**
+ * @brief 浏览器直播预览服务
+ * 
+ * 仅在配置了 --live-port 时启用：编码线程把每个包的一个引用发布给它，
+ * 满了就丢，不会阻塞编码与写盘。
+ */
+static LiveServer g_live;
+
+/** 直播预览服务是否已启动 */
+static int g_live_on;
+
+/**
+ * @brief RTP/UDP 输出（--rtp）
+ *
+ * 与直播预览相同：编码线程发布每个包的一个引用，发送线程打包并附加修复包，满了就丢。
+ */
+static RtpOut g_rtp;
+
+/** RTP 输出是否已启动 */
+static int g_rtp_on;
+
+/**
+ * @brief 关键帧策略（编码线程使用）
+ *
+ * 固定 GOP 时只负责按需 IDR 的限频；--smart-gop 时还做场景/运动分析与节省统计。
+ */
+static SmartGop g_gop;
+
+/** 是否启用智能 GOP */
+static int g_gop_smart;
+
+/**
+ * @brief 采集帧率目标（实时切换）
+ *
+ * 由编码线程的空闲降帧（--idle-fps）或控制命令 fps 修改；各采集线程每帧检查，变化时重设
+ * 传感器帧间隔，传感器帧率仍高于目标时按 PTS 软件抽帧。帧上标注标称帧率，编码线程据此
+ * 同步节拍器与码控。
+ */
+static atomic_int g_fps_target;
+
+/**
+ * @brief 时序轨迹记录器（--trace）
+ *
+ * 采集 / 编码 / 写盘线程追加事件（只拷贝进内存缓冲），统计线程每秒写盘。
+ */
+static TimingTrace g_trace;
+
+/** 是否记录时序轨迹 */
+static int g_trace_on;
+
+/**
+ * @brief 回放轨迹（--replay）
+ *
+ * 采集线程换成按轨迹产生帧 / 音频块的合成源，编码线程换成模拟编码器，
+ * 写盘线程按记录补足写出耗时；队列与其余线程照常运行。
+ */
+static TimingReplay g_replay;
+
+/** 是否处于回放模式 */
+static int g_replay_on;
+
+/** 回放时间零点（CLOCK_MONOTONIC 微秒），事件在 g_replay_t0 + t_us 时刻重现 */
+static uint64_t g_replay_t0;
+
+/** 尚未放完的回放源数，最后一路结束后停止管线 */
+static atomic_int g_replay_left;
+
+/** 控制命令固定的帧率（0 = 自动，空闲降帧生效） */
+static atomic_int g_fps_pinned;
+
+/** cam0 传感器实际帧率（x100，0 = 未知），控制命令 fps 查询用 */
+static atomic_int g_sensor_fps_x100;
+
+/**
+ * @brief 进程 / 线程资源自监控（--no-procmon 关闭）
+ *
+ * 主线程登记每个工作线程，统计线程每秒采样并输出 [CPU] / [MEM]，直播服务经 /metrics 导出。
+ */
+static ProcMon g_mon;
+
+/** 是否启用自监控 */
+static int g_mon_on;
+
+/**
+ * @brief 录像目录（--catalog）
+ *
+ * 两个 sink 线程在开段 / 关键帧 / 关段时更新，关段后执行保留策略（目录内部加锁）。
+ */
+static RecCatalog g_cat;
+
+/** 是否启用录像目录 */
+static int g_cat_on;
+
+/** 落盘加密密钥（--encrypt-key，启动时加载，sink 线程只读共享） */
+static RecCryptKey g_crypt_key;
+
+/** 是否加密录像 */
+static int g_crypt_on;
+
+/**
+ * @brief 多存储目标（--store）
+ *
+ * 两个 sink 线程开段时选目标、每次写后登记耗时与成败；统计线程每秒探测空间 / 掉线设备并输出 [STORE]。
+ */
+static Storage g_store;
+
+/** 是否启用多存储目标（未启用时直接写输出路径，写失败即停止录像） */
+static int g_store_on;
+
+/** 视频 sink 迁移存储目标时置位，编码线程下一帧编成 IDR，新段尽快从关键帧开始 */
+static atomic_int g_store_idr;
+
+/**
+ * @brief 隐私遮挡（--mask，或启用 --ctl 后可随时添加）
+ *
+ * 编码线程每帧编码前原地施加；控制线程替换遮挡表，下一帧生效。
+ */
+static PrivacyMask g_mask;
+
+/** 是否启用隐私遮挡 */
+static int g_mask_on;
+
+/**
+ * @brief 帧统计（--no-frame-stats 关闭）
+ *
+ * 编码线程每帧只读分析 Y 平面，结果写入帧元数据；统计线程输出 [IMG]，直播服务经 /metrics 导出。
+ */
+static FrameStats g_fstats;
+
+/** 是否启用帧统计 */
+static int g_fstats_on;
+
+/** 运行时控制通道（--ctl） */
+static Ctl g_ctl;
+
+/** 控制通道是否已启动 */
+static int g_ctl_on;
+
 /**
  * @brief 视频帧间 PTS 差值（微秒）
  * 
@@ -106,6 +307,17 @@ static atomic_uint_fast64_t g_video_pts_delta_us;
  */
 static atomic_uint_fast64_t g_audio_pts_delta_us;
 
+/* 通知各服务线程退出（可重复调用） */
+static void stop_services(void)
+{
+    if (g_live_on)
+        live_server_stop(&g_live);
+    if (g_rtp_on)
+        rtp_out_stop(&g_rtp);
+    if (g_ctl_on)
+        ctl_stop(&g_ctl);
+}
+
 /**
  * @brief 请求停止所有线程
  * 
@@ -124,6 +336,11 @@ static void request_stop(void)
         bq_close(&g_raw_vq);
         bq_close(&g_h264_q);
         bq_close(&g_aud_q);
+        for (int i = 0; i < g_cam_count; i++)
+            bq_close(&g_cam_q[i]);
+        for (int i = 0; i < g_mic_count; i++)
+            bq_close(&g_mic_q[i]);
+        stop_services();
     }
 }
 
@@ -166,15 +383,15 @@ static void free_audio_chunk(AudioChunk *ac)
 }
 
 /**
- * @brief 释放编码后数据包结构体及其数据
+ * @brief 释放编码后数据包的一个引用
+ * 
+ * 包可能同时被直播预览服务持有，最后一个引用释放时才真正 free。
  * 
  * @param p 数据包指针，可为 NULL（安全）
  */
 static void free_encoded_packet(EncodedPacket *p)
 {
-    if (!p) return;
-    if (p->data) free(p->data);
-    free(p);
+    encoded_packet_unref(p);
 }
 
 /* ============================================================================
@@ -190,6 +407,56 @@ typedef struct {
     const AppConfig *cfg;  /**< 应用配置指针（只读） */
 } ThreadArgs;
 
+/**
+ * @brief 视频采集线程参数
+ * 
+ * 多摄像头时每路采集线程各有一份：设备节点与输出队列不同。
+ */
+typedef struct {
+    const AppConfig *cfg;     /**< 应用配置指针（只读） */
+    int              cam;     /**< 摄像头序号（0 为主摄像头） */
+    const char      *device;  /**< V4L2 设备节点 */
+    BQueue          *out_q;   /**< 输出 raw 队列 */
+    char             name[16];/**< 线程名（自监控 / 启动计时） */
+} CaptureArgs;
+
+/**
+ * @brief 音频采集线程参数
+ * 
+ * 多麦克风时每路采集线程各有一份：设备、声道数与输出队列不同。
+ */
+typedef struct {
+    const AppConfig *cfg;      /**< 应用配置指针（只读） */
+    int              index;    /**< 设备序号（0 为主设备，决定混音时钟） */
+    const char      *device;   /**< ALSA 设备名或 synth:<hz>[@<ppm>] */
+    int              channels; /**< 采集声道数 */
+    BQueue          *out_q;    /**< 输出音频队列 */
+    char             name[16]; /**< 线程名（自监控 / 启动计时） */
+} AudioArgs;
+
+/**
+ * @brief 编码器预初始化结果
+ *
+ * MPP 初始化由 enc_boot 线程与摄像头启动并行完成，编码线程创建前汇合，
+ * 编码线程直接接管已配置好的编码器。
+ */
+typedef struct {
+    EncoderMPP       enc;     /**< 已初始化的编码器 */
+    bool             sliced;  /**< 已开启按 slice 低延迟输出 */
+    int              rc;      /**< 0 成功，-1 失败 */
+} EncoderBoot;
+
+/** 编码器预初始化（enc_boot 线程写，汇合后编码线程读） */
+static EncoderBoot g_enc_boot;
+
+/* 记录一个时序事件（未启用 --trace 时为空操作） */
+static void trace_event(TimingEv ev, int stream, uint32_t flags, uint64_t bytes, uint64_t dur_us,
+                        uint64_t at_us)
+{
+    if (g_trace_on)
+        timing_trace_event(&g_trace, ev, stream, flags, bytes, dur_us, at_us);
+}
+
 /**
  * @brief 信号处理线程函数
  * 
@@ -266,6 +533,7 @@ static void *timer_thread(void *arg)
  * 1. 调用 av_stats_tick_print() 打印帧率、码率、丢帧等指标
  * 2. 打印三个队列的当前深度/容量
  * 3. 打印视频/音频的 PTS 间隔（用于监控稳定性）
+ * 4. 自监控采样：每线程 CPU / 上下文切换、进程内存与缺页（[CPU] / [MEM]）
  * 
  * @param arg 未使用
  * @return void* 始终返回 NULL
@@ -277,9 +545,17 @@ static void *stats_thread(void *arg)
     while (!should_stop()) {
         sleep(1);
         
+        /* 先取本秒编码帧数（tick_print 会清零），用于每帧 CPU 开销 */
+        uint64_t frames = atomic_load(&g_stats.video_frames);
+
         /* 打印帧率、码率等核心指标 */
         av_stats_tick_print(&g_stats);
 
+        if (g_mon_on) {
+            proc_mon_sample(&g_mon, frames);
+            proc_mon_tick_print(&g_mon);
+        }
+
         /* 获取各队列当前深度 */
         size_t vq = bq_size(&g_raw_vq);
         size_t hq = bq_size(&g_h264_q);
@@ -289,6 +565,46 @@ static void *stats_thread(void *arg)
              hq, bq_capacity(&g_h264_q),
              aq, bq_capacity(&g_aud_q));
 
+        if (g_cam_count > 0) {
+            char line[160];
+            int off = 0;
+            for (int i = 0; i < g_cam_count && off < (int)sizeof(line); i++) {
+                off += snprintf(line + off, sizeof(line) - (size_t)off, " cam%d=%zu/%zu",
+                                i, bq_size(&g_cam_q[i]), bq_capacity(&g_cam_q[i]));
+            }
+            LOGI("[Q]%s", line);
+            frame_sync_tick_print(&g_sync);
+        }
+
+        if (g_mic_count > 0) {
+            char line[160];
+            int off = 0;
+            for (int i = 0; i < g_mic_count && off < (int)sizeof(line); i++) {
+                off += snprintf(line + off, sizeof(line) - (size_t)off, " mic%d=%zu/%zu",
+                                i, bq_size(&g_mic_q[i]), bq_capacity(&g_mic_q[i]));
+            }
+            LOGI("[Q]%s", line);
+            audio_mixer_tick_print(&g_mixer);
+        }
+
+        if (g_live_on)
+            live_server_tick_print(&g_live);
+        if (g_rtp_on)
+            rtp_out_tick_print(&g_rtp);
+        if (g_gop_smart)
+            smart_gop_tick_print(&g_gop);
+        if (g_mask_on)
+            privacy_mask_tick_print(&g_mask);
+        if (g_fstats_on)
+            frame_stats_tick_print(&g_fstats);
+        if (g_trace_on)
+            timing_trace_flush(&g_trace);
+        if (g_store_on) {
+            storage_probe(&g_store);
+            storage_tick_print(&g_store);
+        }
+        boot_trace_tick_print();
+
         /* 打印 PTS 间隔，用于检测帧间隔是否稳定 */
         uint64_t vdu = atomic_load(&g_video_pts_delta_us);
         uint64_t adu = atomic_load(&g_audio_pts_delta_us);
@@ -306,6 +622,23 @@ static void *stats_thread(void *arg)
     return NULL;
 }
 
+/*
+ * 软件抽帧：传感器帧率高于目标时按 PTS 只保留落在 1/fps 节拍上的帧。
+ * 容差取半个采集周期，时间戳抖动不会造成多抽或少抽；长时间无帧后重新对齐。
+ *
+ * @return bool true 表示丢弃本帧
+ */
+static bool video_decimate(uint64_t *next_us, uint64_t pts_us, unsigned int fps, double sensor_fps)
+{
+    uint64_t period = 1000000ull / fps;
+    uint64_t slack  = sensor_fps > 0.0 ? (uint64_t)(500000.0 / sensor_fps) : period / 4;
+
+    if (*next_us && pts_us + slack < *next_us)
+        return true;
+    *next_us = (*next_us && pts_us < *next_us + period) ? *next_us + period : pts_us + period;
+    return false;
+}
+
 /**
  * @brief 视频采集线程函数
  * 
@@ -323,18 +656,25 @@ static void *stats_thread(void *arg)
  * 队列满策略：
  * 使用 bq_try_push（非阻塞），队列满时直接丢帧，保证采集实时性。
  * 
- * @param arg 指向 ThreadArgs 的指针
+ * 多摄像头：每路一个线程，各自推入 CaptureArgs::out_q。
+ * 
+ * 帧率：打开时按 --fps 协商传感器帧间隔；g_fps_target 变化时重新协商，传感器不支持或
+ * 仍高于目标时在拷贝前软件抽帧（被抽掉的帧直接归还驱动，不计丢帧）。
+ * 
+ * @param arg 指向 CaptureArgs 的指针
  * @return void* 始终返回 NULL
  */
 static void *video_capture_thread(void *arg)
 {
-    ThreadArgs *ta = (ThreadArgs *)arg;
-    const AppConfig *cfg = ta->cfg;
+    CaptureArgs *ca = (CaptureArgs *)arg;
+    const AppConfig *cfg = ca->cfg;
+    boot_trace_thread(ca->name, ca->cam);
 
     /* 初始化 V4L2 采集 */
     V4L2Capture cap;
-    if (v4l2_capture_open(&cap, cfg->video_device, cfg->width, cfg->height) != 0) {
-        LOGE("[video_cap] open failed");
+    if (v4l2_capture_open(&cap, ca->device, cfg->width, cfg->height, (unsigned int)cfg->fps,
+                          (V4L2MapMode)cfg->cap_map) != 0) {
+        LOGE("[video_cap] cam%d open failed: %s", ca->cam, ca->device);
         request_stop();
         return NULL;
     }
@@ -351,6 +691,14 @@ static void *video_capture_thread(void *arg)
     int has_seq = 0;        /* 是否已记录过首帧 sequence */
     uint32_t last_seq = 0;  /* 上一帧的 sequence */
 
+    /* 帧率：当前标称帧率、传感器实际帧率（0 = 未知）、抽帧节拍 */
+    unsigned int cur_fps = (unsigned int)cfg->fps;
+    double sensor_fps = v4l2_capture_fps(&cap);
+    uint64_t keep_next_us = 0;
+    uint64_t decimated = 0;
+    if (ca->cam == 0)
+        atomic_store(&g_sensor_fps_x100, (int)(sensor_fps * 100.0 + 0.5));
+
     while (!should_stop()) {
         int index = -1;
         void *data = NULL;
@@ -370,8 +718,10 @@ static void *video_capture_thread(void *arg)
             usleep(1000);
             continue;
         }
+        boot_trace_mark(BOOT_FIRST_DQBUF);
 
         /* 丢帧检测：sequence 应该连续递增 */
+        uint32_t gap = 0;
         if (!has_seq) {
             last_seq = cap.last_sequence;
             has_seq = 1;
@@ -379,18 +729,41 @@ static void *video_capture_thread(void *arg)
             uint32_t cur = cap.last_sequence;
             if (cur > last_seq + 1) {
                 /* 检测到驱动层丢帧 */
-                av_stats_add_drop(&g_stats, (uint64_t)(cur - last_seq - 1));
+                gap = cur - last_seq - 1;
+                av_stats_add_drop(&g_stats, (uint64_t)gap);
             }
             last_seq = cur;
         }
+        av_stats_add_cap_copy(&g_stats, len, cap.last_copy_ns);
 
         /* 关键：在采集点打上 monotonic 时间戳 */
         uint64_t pts_us = rkav_now_monotonic_us();
 
+        /* 帧率切换：先让传感器降 / 升帧率，做不到的部分由软件抽帧补足 */
+        int want = atomic_load(&g_fps_target);
+        if (want > 0 && (unsigned int)want != cur_fps) {
+            if (v4l2_capture_set_fps(&cap, (unsigned int)want) == 0)
+                sensor_fps = v4l2_capture_fps(&cap);
+            if (ca->cam == 0)
+                atomic_store(&g_sensor_fps_x100, (int)(sensor_fps * 100.0 + 0.5));
+            LOGI("[video_cap] cam%d fps %u -> %d (sensor %.2f fps)", ca->cam, cur_fps, want, sensor_fps);
+            cur_fps = (unsigned int)want;
+            keep_next_us = 0;
+        }
+        double src_fps = sensor_fps > 0.0 ? sensor_fps : (double)cfg->fps;
+        if ((double)cur_fps < src_fps - 0.5 &&
+            video_decimate(&keep_next_us, pts_us, cur_fps, sensor_fps)) {
+            decimated++;
+            v4l2_capture_qbuf(&cap, index);
+            continue;
+        }
+        trace_event(TT_EV_CAPTURE, ca->cam, gap, len, cap.last_copy_ns / 1000u, pts_us);
+
         /* 分配视频帧结构体 */
         VideoFrame *vf = (VideoFrame *)calloc(1, sizeof(VideoFrame));
         if (!vf) {
             av_stats_add_drop(&g_stats, 1);
+            trace_event(TT_EV_DROP, ca->cam, TT_DROP_NOMEM, len, 0, pts_us);
             v4l2_capture_qbuf(&cap, index);
             continue;
         }
@@ -399,6 +772,7 @@ static void *video_capture_thread(void *arg)
         if (!vf->data) {
             free(vf);
             av_stats_add_drop(&g_stats, 1);
+            trace_event(TT_EV_DROP, ca->cam, TT_DROP_NOMEM, len, 0, pts_us);
             v4l2_capture_qbuf(&cap, index);
             continue;
         }
@@ -411,12 +785,14 @@ static void *video_capture_thread(void *arg)
         vf->stride = cfg->width;  /* 简化处理，实际可从 VIDIOC_G_FMT 获取准确 stride */
         vf->pts_us = pts_us;
         vf->frame_id = frame_id++;
+        vf->fps = (uint16_t)cur_fps;
 
         /* 非阻塞推入 raw 队列：满就丢帧，保证采集实时性 */
-        int pr = bq_try_push(&g_raw_vq, vf);
+        int pr = bq_try_push(ca->out_q, vf);
         if (pr == 1) {
             /* 队列满：丢弃当前帧 */
             av_stats_add_drop(&g_stats, 1);
+            trace_event(TT_EV_DROP, ca->cam, TT_DROP_QFULL, len, 0, pts_us);
             free_video_frame(vf);
         } else if (pr < 0) {
             /* 队列已关闭：退出循环 */
@@ -429,179 +805,1446 @@ static void *video_capture_thread(void *arg)
         v4l2_capture_qbuf(&cap, index);
     }
 
+    if (decimated)
+        LOGI("[video_cap] cam%d decimated %llu frames", ca->cam, (unsigned long long)decimated);
     v4l2_capture_close(&cap);
     return NULL;
 }
 
-/**
- * @brief 视频编码线程函数
- * 
- * 工作流程：
- * 1. 初始化 MPP 硬编码器（H.264）
- * 2. 循环：从 raw 队列取帧 -> 编码 -> 封装成 EncodedPacket -> 推入 H264 队列
- * 3. 退出时释放编码器资源
- * 
- * 编码结果：
- * - out_data: 编码后的 H.264 NAL 数据（需要 free）
- * - out_keyframe: 是否为关键帧（I 帧）
- * 
- * @param arg 指向 ThreadArgs 的指针
- * @return void* 始终返回 NULL
+/*
+ * 回放源放完：最后一路结束后等队列排空（最多约 2 秒），再停止管线。
  */
-static void *video_encode_thread(void *arg)
+static void replay_source_done(void)
 {
-    ThreadArgs *ta = (ThreadArgs *)arg;
-    const AppConfig *cfg = ta->cfg;
-
-    /* 初始化 MPP 硬编码器 */
-    EncoderMPP enc;
-    if (encoder_mpp_init(&enc, cfg->width, cfg->height, cfg->fps,
-                         cfg->bitrate, MPP_VIDEO_CodingAVC) != 0) {
-        LOGE("[video_enc] encoder init failed");
+    if (atomic_fetch_sub(&g_replay_left, 1) != 1)
+        return;
+    for (int i = 0; i < 200 && !should_stop(); i++) {
+        if (bq_size(&g_raw_vq) == 0 && bq_size(&g_h264_q) == 0 && bq_size(&g_aud_q) == 0)
+            break;
+        usleep(10000);
+    }
+    usleep(200000);     /* 让编码 / 写盘线程处理完手上的最后一项 */
+    if (!should_stop()) {
+        LOGI("[replay] trace finished, stopping...");
         request_stop();
-        return NULL;
     }
+}
 
-    while (!should_stop()) {
-        void *item = NULL;
-        
-        /* 阻塞等待取帧 */
-        int r = bq_pop(&g_raw_vq, &item);
-        if (r == 0) break;  /* 队列关闭且为空 */
-        if (r < 0) {
-            av_stats_add_drop(&g_stats, 1);
-            continue;
-        }
+/**
+ * @brief 回放采集线程函数（--replay 时替代 video_capture_thread）
+ *
+ * 按轨迹中本路 CAPTURE 事件的相对时刻产生同样大小的中灰 NV12 帧，记录的驱动丢帧数照常计入统计；
+ * 之后与真实采集完全相同：非阻塞推入队列，满则丢帧。因此队列积压导致的丢帧会原样重现，
+ * 结束时与记录中的丢帧数对比。
+ *
+ * @param arg 指向 CaptureArgs 的指针
+ * @return void* 始终返回 NULL
+ */
+static void *replay_capture_thread(void *arg)
+{
+    CaptureArgs *ca = (CaptureArgs *)arg;
+    const AppConfig *cfg = ca->cfg;
+    size_t min_len = (size_t)cfg->width * (size_t)cfg->height * 3u / 2u;
 
-        VideoFrame *vf = (VideoFrame *)item;
+    TimingCursor cur;
+    timing_cursor_init(&cur, &g_replay, TT_EV_CAPTURE, ca->cam);
+    uint64_t frame_id = 0, drops = 0;
+    const TimingEvent *ev;
 
-        /* 调用 MPP 编码，输出为独立的内存块 */
-        uint8_t *pkt_data = NULL;
-        size_t pkt_size = 0;
-        bool key = false;
+    while (!should_stop() && (ev = timing_cursor_next(&cur)) != NULL) {
+        timing_sleep_until(g_replay_t0 + ev->t_us);
+        if (should_stop()) break;
+
+        uint64_t pts_us = rkav_now_monotonic_us();
+        size_t len = ev->bytes > min_len ? ev->bytes : min_len;
+        if (ev->flags)
+            av_stats_add_drop(&g_stats, ev->flags);
+        av_stats_add_cap_copy(&g_stats, len, (uint64_t)ev->dur_us * 1000u);
+        trace_event(TT_EV_CAPTURE, ca->cam, ev->flags, len, ev->dur_us, pts_us);
 
-        int er = encoder_mpp_encode_packet(&enc, vf->data, vf->size,
-                                           &pkt_data, &pkt_size, &key);
-        if (er != 0) {
+        VideoFrame *vf = (VideoFrame *)calloc(1, sizeof(VideoFrame));
+        if (vf) vf->data = (uint8_t *)malloc(len);
+        if (!vf || !vf->data) {
+            free(vf);
             av_stats_add_drop(&g_stats, 1);
-            free_video_frame(vf);
+            trace_event(TT_EV_DROP, ca->cam, TT_DROP_NOMEM, len, 0, pts_us);
             continue;
         }
+        memset(vf->data, 0x80, len);
+        vf->size     = len;
+        vf->w        = cfg->width;
+        vf->h        = cfg->height;
+        vf->stride   = cfg->width;
+        vf->pts_us   = pts_us;
+        vf->frame_id = frame_id++;
 
-        /* 编码成功且有输出数据 */
-        if (pkt_data && pkt_size > 0) {
-            /* 封装成 EncodedPacket */
-            EncodedPacket *ep = (EncodedPacket *)calloc(1, sizeof(EncodedPacket));
-            if (!ep) {
-                free(pkt_data);
-                av_stats_add_drop(&g_stats, 1);
-            } else {
-                ep->data = pkt_data;
-                ep->size = pkt_size;
-                ep->pts_us = vf->pts_us;      /* 继承原始帧的时间戳 */
-                ep->is_keyframe = key;
-
-                /* 阻塞推入 H264 队列 */
-                int pr = bq_push(&g_h264_q, ep);
-                if (pr != 0) {
-                    free_encoded_packet(ep);
-                    break;
-                }
-
-                /* 更新统计 */
-                av_stats_inc_video_frame(&g_stats);
-                av_stats_add_enc_bytes(&g_stats, (uint64_t)pkt_size);
-            }
+        int pr = bq_try_push(ca->out_q, vf);
+        if (pr == 1) {
+            av_stats_add_drop(&g_stats, 1);
+            trace_event(TT_EV_DROP, ca->cam, TT_DROP_QFULL, len, 0, pts_us);
+            free_video_frame(vf);
+            drops++;
+        } else if (pr < 0) {
+            free_video_frame(vf);
+            break;
         }
-
-        free_video_frame(vf);
     }
 
-    encoder_mpp_deinit(&enc);
+    LOGI("[replay] cam%d done: %llu frames, queue drops %llu (recorded %zu)", ca->cam,
+         (unsigned long long)frame_id, (unsigned long long)drops,
+         timing_replay_count(&g_replay, TT_EV_DROP, ca->cam));
+    replay_source_done();
     return NULL;
 }
 
 /**
- * @brief 音频采集线程函数
- * 
- * 工作流程：
- * 1. 打开 ALSA 采集设备
- * 2. 循环：读取 PCM 数据 -> 打时间戳 -> 封装成 AudioChunk -> 推入队列
- * 3. 退出时关闭设备
+ * @brief 多摄像头帧同步线程函数
  * 
- * PTS 策略：
- * - 起始时刻使用 CLOCK_MONOTONIC 获取
- * - 后续每块的 PTS 按采样帧数累加推算：pts += frames * 1000000 / sample_rate
- * - 这样保证 PTS 连续且与实际采样时长一致
+ * 从各路 g_cam_q 取帧并按 PTS 对齐成 FrameSet（只移动指针，不拷贝帧）：
+ * - 主摄像头（cam0）的帧转交 g_raw_vq，继续走编码/录制链路
+ * - 其余各路帧不会交给任何下游：本仓库还没有立体/拼接/分析等消费帧组的模块，
+ *   帧组只用于 [SYNC] / [SKEW] 统计，成组后随即释放。接入下游时在此处取走
+ *   set->frames[1..]（置 NULL 转移所有权）再调用 frame_set_free()
  * 
- * @param arg 指向 ThreadArgs 的指针
+ * @param arg 未使用
  * @return void* 始终返回 NULL
  */
-static void *audio_capture_thread(void *arg)
+static void *frame_sync_thread(void *arg)
 {
-    ThreadArgs *ta = (ThreadArgs *)arg;
-    const AppConfig *cfg = ta->cfg;
-
-    /* 初始化 ALSA 采集 */
-    AudioCapture ac;
-    if (audio_capture_open(&ac, cfg->audio_device, cfg->sample_rate, (int)cfg->channels) != 0) {
-        LOGE("[audio_cap] open failed");
-        request_stop();
-        return NULL;
-    }
-
-    /* 起始 PTS 用 monotonic 时钟，后续靠采样计数推进 */
-    uint64_t pts_us = rkav_now_monotonic_us();
-
-    /* 每次读取的字节数 = period 帧数 × 每帧字节数 */
-    size_t chunk_bytes = (size_t)ac.frames_per_period * ac.bytes_per_frame;
+    (void)arg;
 
     while (!should_stop()) {
-        /* 分配缓冲区 */
-        uint8_t *buf = (uint8_t *)malloc(chunk_bytes);
-        if (!buf) {
-            av_stats_add_drop(&g_stats, 1);
+        FrameSet *set = NULL;
+        int r = frame_sync_next(&g_sync, &set);
+        if (r == 0) break;  /* 所有输入已关闭且取空 */
+        if (r < 0) {
             usleep(1000);
             continue;
         }
 
-        /* 从 ALSA 读取 PCM 数据（阻塞） */
-        ssize_t n = audio_capture_read(&ac, buf, chunk_bytes);
-        if (n <= 0) {
-            free(buf);
-            if (!should_stop()) usleep(1000);
-            continue;
-        }
-
-        /* 计算实际读取的采样帧数 */
-        uint32_t frames = (uint32_t)(n / ac.bytes_per_frame);
-
-        AudioChunk *chunk = (AudioChunk *)calloc(1, sizeof(AudioChunk));
-        if (!chunk) {
-            free(buf);
-            av_stats_add_drop(&g_stats, 1);
-            continue;
+        /* 主摄像头帧：转移所有权给编码队列，满则丢帧 */
+        VideoFrame *primary = set->frames[0];
+        if (primary) {
+            set->frames[0] = NULL;
+            int pr = bq_try_push(&g_raw_vq, primary);
+            if (pr != 0) {
+                if (pr == 1) av_stats_add_drop(&g_stats, 1);
+                free_video_frame(primary);
+            }
         }
 
-        chunk->data = buf;
-        chunk->bytes = (size_t)n;
-        chunk->sample_rate = (int)ac.sample_rate;
-        chunk->channels = ac.channels;
-        chunk->bytes_per_sample = 2; // S16LE
-        chunk->frames = frames;
-        chunk->pts_us = pts_us;
-
-        // 推进 pts：frames 是“每声道帧数”
-        pts_us += (uint64_t)frames * 1000000ULL / (uint64_t)ac.sample_rate;
-
-        int pr = bq_push(&g_aud_q, chunk);
-        if (pr != 0) {
-            free_audio_chunk(chunk);
-            break;
-        }
+        /* 非主摄像头的帧没有消费者，只参与了对齐统计 */
+        frame_set_free(set, free_video_frame);
     }
 
-    audio_capture_close(&ac);
+    frame_sync_deinit(&g_sync);
+    return NULL;
+}
+
+/**
+ * @brief 编码线程内跨 slice 的状态
+ *
+ * 整帧输出时每帧只有一个“slice”；低延迟模式下同一帧的多个 slice 共享丢层决定与统计。
+ */
+typedef struct {
+    SvcShed   shed;         /**< H264 队列拥塞时按时间层丢帧 */
+    uint16_t  slice_idx;    /**< 当前帧已下发的 slice 数 */
+    bool      shed_frame;   /**< 当前帧是否整帧丢弃（首片决定） */
+    size_t    frame_bytes;  /**< 当前帧已输出字节 */
+    bool      frame_key;    /**< 当前帧是否关键帧（首片决定） */
+    uint8_t  *asm_buf;      /**< 直播预览整帧拼装缓冲（预览按整帧封装） */
+    size_t    asm_len;
+    size_t    asm_cap;
+} VideoEncState;
+
+/* 低延迟模式：把 slice 拼成整帧后再发布给直播预览 */
+static void video_live_assemble(VideoEncState *st, const EncodedPacket *ep, bool eoi)
+{
+    if (st->asm_len + ep->size > st->asm_cap) {
+        size_t cap = st->asm_cap ? st->asm_cap : 64 * 1024;
+        while (cap < st->asm_len + ep->size) cap *= 2;
+        uint8_t *nb = (uint8_t *)realloc(st->asm_buf, cap);
+        if (!nb) {
+            st->asm_len = 0;
+            return;
+        }
+        st->asm_buf = nb;
+        st->asm_cap = cap;
+    }
+    memcpy(st->asm_buf + st->asm_len, ep->data, ep->size);
+    st->asm_len += ep->size;
+    if (!eoi) return;
+
+    EncodedPacket *whole = encoded_packet_alloc();
+    uint8_t *data = whole ? (uint8_t *)malloc(st->asm_len) : NULL;
+    if (data) {
+        memcpy(data, st->asm_buf, st->asm_len);
+        whole->data        = data;
+        whole->size        = st->asm_len;
+        whole->pts_us      = ep->pts_us;
+        whole->dts_us      = ep->dts_us;
+        whole->is_keyframe = ep->is_keyframe;
+        whole->crc32c      = crc32c(data, st->asm_len);
+        whole->temporal_id = ep->temporal_id;
+        whole->enc_us      = ep->enc_us;
+        live_server_publish(&g_live, whole);
+    }
+    if (whole) free_encoded_packet(whole);
+    st->asm_len = 0;
+}
+
+/*
+ * 下发一个编码输出（整帧或 slice），接管 data 的所有权。
+ * PTS / DTS 取自编码器输出包（enc->frame_pts_us / frame_dts_us），而不是当前输入帧：
+ * 编码器有多帧在途或重排序时，吐出的包未必对应刚投递的那一帧。
+ * 返回 -1 表示 H264 队列已关闭，编码线程应退出。
+ */
+static int video_emit(VideoEncState *st, const EncoderMPP *enc, uint8_t *data, size_t size,
+                      bool key, uint32_t crc, uint8_t tid, bool eoi)
+{
+    bool first = st->slice_idx == 0;
+    if (first) {
+        /*
+         * 队列占用越高，允许通过的时间层越低：最高层帧无人参考，丢掉后码流仍可解码，
+         * 帧率平滑下降；基础层仍阻塞推入（与不分层时行为一致）。同一帧的所有 slice 同进同出。
+         */
+        double fill = (double)bq_size(&g_h264_q) / (double)bq_capacity(&g_h264_q);
+        st->shed_frame  = svc_shed_drop(&st->shed, tid, fill);
+        st->frame_bytes = 0;
+        st->frame_key   = key;
+    }
+
+    /* 封装成 EncodedPacket（引用计数 1，归写盘线程） */
+    EncodedPacket *ep = encoded_packet_alloc();
+    if (!ep) {
+        free(data);
+        av_stats_add_drop(&g_stats, 1);
+        if (eoi) st->slice_idx = 0;
+        return 0;
+    }
+    ep->data = data;
+    ep->size = size;
+    ep->pts_us = enc->frame_pts_us;
+    ep->dts_us = enc->frame_dts_us;
+    ep->is_keyframe = key;
+    ep->crc32c = crc;             /* 编码输出拷贝时已融合计算 */
+    ep->temporal_id = tid;
+    ep->flags = eoi ? 0 : RKAV_PKT_F_PARTIAL;
+    ep->slice_idx = st->slice_idx;
+    ep->enc_us = rkav_now_monotonic_us();
+    boot_trace_mark(BOOT_FIRST_PACKET);
+
+    /* 先发布给直播预览与 RTP 输出（非阻塞，内部加引用），再交给写盘线程 */
+    if (g_live_on) {
+        if (first && eoi)
+            live_server_publish(&g_live, ep);
+        else
+            video_live_assemble(st, ep, eoi);
+    }
+    if (g_rtp_on)
+        rtp_out_publish(&g_rtp, ep);   /* RTP 按 slice 直接打包，不必拼帧 */
+
+    av_stats_add_enc_bytes(&g_stats, (uint64_t)size);
+    st->frame_bytes += size;
+    if (eoi) {
+        av_stats_inc_video_frame(&g_stats);
+        av_stats_inc_tlayer(&g_stats, tid, st->shed_frame);
+        smart_gop_on_packet(&g_gop, st->frame_bytes, key, enc->frame_dts_us);
+        st->slice_idx = 0;
+    } else {
+        st->slice_idx++;
+    }
+
+    if (st->shed_frame) {
+        free_encoded_packet(ep);
+        return 0;
+    }
+    if (bq_push(&g_h264_q, ep) != 0) {
+        free_encoded_packet(ep);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * 取出已投递帧的全部输出（低延迟模式逐片取出，每片编完立即下发；整帧模式只有一片）。
+ * 返回 true 表示 H264 队列已关闭。
+ */
+static bool video_drain(EncoderMPP *enc, VideoEncState *st)
+{
+    uint8_t *pkt_data = NULL;
+    size_t pkt_size = 0;
+    bool key = false;
+    uint32_t crc = 0;
+    uint8_t tid = 0;
+    bool eoi = false;
+    bool closed = false;
+    int  n = 0;
+
+    while (!eoi && n++ < ENC_MAX_SLICES * 4) {
+        int gr = encoder_mpp_get_slice(enc, &pkt_data, &pkt_size, &key, &crc, &tid, &eoi);
+        if (gr <= 0) {
+            if (gr < 0) av_stats_add_drop(&g_stats, 1);
+            break;
+        }
+        if (!pkt_data || pkt_size == 0) {
+            free(pkt_data);
+            continue;
+        }
+        if (video_emit(st, enc, pkt_data, pkt_size, key, crc, tid, eoi) != 0) {
+            closed = true;
+            break;
+        }
+    }
+    /* 帧没有正常结束（编码器出错）：下一帧重新计片 */
+    if (!eoi) {
+        st->slice_idx = 0;
+        st->asm_len   = 0;
+    }
+    return closed;
+}
+
+/*
+ * CFR：按节拍器判定本帧去留，并先用编码器重复上一帧填补之前空出的槽位。
+ * 保留时把 vf->pts_us 改写为网格 PTS 并返回 1；应丢弃返回 0；H264 队列已关闭返回 -1。
+ */
+static int video_pace(FramePacer *pacer, EncoderMPP *enc, VideoEncState *st, VideoFrame *vf)
+{
+    uint64_t slot = 0;
+    uint32_t fill = 0;
+    if (!frame_pacer_place(pacer, vf->pts_us, &slot, &fill)) {
+        av_stats_add_cfr(&g_stats, 0, 1);
+        return 0;
+    }
+
+    for (uint32_t i = fill; i > 0; i--) {
+        if (encoder_mpp_put_repeat(enc, frame_pacer_slot_pts(pacer, slot - i)) != 0) {
+            av_stats_add_drop(&g_stats, 1);
+            break;
+        }
+        if (video_drain(enc, st)) return -1;
+    }
+    av_stats_add_cfr(&g_stats, fill, 0);
+    vf->pts_us = frame_pacer_slot_pts(pacer, slot);
+    return 1;
+}
+
+/*
+ * 采集端切换了帧率：码控按新帧率重设（码率随帧率线性缩放，每帧比特数不变），
+ * CFR 节拍器从当前槽位起换成新网格。
+ */
+static void video_switch_fps(EncoderMPP *enc, FramePacer *pacer, const AppConfig *cfg, int fps)
+{
+    int bps = (int)((int64_t)cfg->bitrate * fps / cfg->fps);
+    if (encoder_mpp_set_fps(enc, fps, bps) != 0)
+        LOGW("[video_enc] rate control update to %d fps failed", fps);
+    if (cfg->cfr)
+        frame_pacer_set_fps(pacer, fps);
+    LOGI("[video_enc] now encoding %d fps at %d bps", fps, bps);
+}
+
+/*
+ * 空闲降帧（--idle-fps）：画面连续静止 --idle-sec 秒后把采集帧率降到 idle_fps，
+ * 出现运动立即恢复 --fps。运动判定复用智能 GOP 的亮度网格分析；控制命令固定帧率时不干预。
+ */
+static void video_idle_update(const AppConfig *cfg, int cur_fps)
+{
+    if (atomic_load(&g_fps_pinned) || !g_gop.have_grid)
+        return;
+
+    int target = atomic_load(&g_fps_target);
+    if (target != cfg->idle_fps && g_gop.still_frames >= cur_fps * (int)cfg->idle_sec) {
+        LOGI("[video_enc] scene still for %us, fps -> %d", cfg->idle_sec, cfg->idle_fps);
+        atomic_store(&g_fps_target, cfg->idle_fps);
+    } else if (target == cfg->idle_fps && g_gop.still_frames == 0) {
+        LOGI("[video_enc] motion, fps -> %d", cfg->fps);
+        atomic_store(&g_fps_target, cfg->fps);
+    }
+}
+
+/*
+ * 回放模式的模拟编码器：取轨迹中下一条 ENCODE 事件，按记录的耗时占用编码线程，
+ * 输出同样大小、同样关键帧标志的包，经 video_emit 走真实的下发路径。
+ * 包内容为一个 filler NAL（类型 12），输出文件仍是播放器可跳过的合法 Annex-B 流。
+ * 轨迹中的编码事件用完后（回放比现场少丢帧时）沿用最后一条。
+ * *done_us 为模拟编码结束（下发之前）的时刻。返回 -1 表示 H264 队列已关闭。
+ */
+static int video_replay_encode(EncoderMPP *enc, VideoEncState *st, TimingCursor *cur,
+                               TimingEvent *last, const VideoFrame *vf, uint64_t t0,
+                               uint64_t *done_us)
+{
+    const TimingEvent *ev = timing_cursor_next(cur);
+    if (ev) *last = *ev;
+
+    if (last->flags & TT_F_ERR) {
+        timing_sleep_until(t0 + last->dur_us);
+        *done_us = rkav_now_monotonic_us();
+        av_stats_add_drop(&g_stats, 1);
+        return 0;
+    }
+
+    size_t size = last->bytes > 6 ? last->bytes : 6;
+    uint8_t *data = (uint8_t *)malloc(size);
+    if (!data) {
+        *done_us = rkav_now_monotonic_us();
+        av_stats_add_drop(&g_stats, 1);
+        return 0;
+    }
+    static const uint8_t filler[5] = { 0x00, 0x00, 0x00, 0x01, 0x0c };
+    memcpy(data, filler, sizeof(filler));
+    memset(data + sizeof(filler), 0xff, size - sizeof(filler) - 1);
+    data[size - 1] = 0x80;
+    uint32_t crc = crc32c(data, size);
+
+    enc->frame_pts_us = vf->pts_us;
+    enc->frame_dts_us = vf->pts_us;
+    timing_sleep_until(t0 + last->dur_us);
+    *done_us = rkav_now_monotonic_us();
+    return video_emit(st, enc, data, size, (last->flags & TT_F_KEY) != 0, crc, 0, true);
+}
+
+/*
+ * 初始化 MPP 硬编码器并应用时间分层、智能 GOP 与切片输出（结果写入 g_enc_boot）。
+ * 失败时告警并请求停止。
+ */
+static void video_encoder_boot(const AppConfig *cfg)
+{
+    EncoderBoot *eb = &g_enc_boot;
+    EncoderMPP *enc = &eb->enc;
+
+    eb->sliced = false;
+    if (encoder_mpp_init(enc, cfg->width, cfg->height, cfg->fps,
+                         cfg->bitrate, MPP_VIDEO_CodingAVC) != 0) {
+        LOGE("[video_enc] encoder init failed");
+        eb->rc = -1;
+        request_stop();
+        return;
+    }
+    if (cfg->svc_layers > 1 && encoder_mpp_set_temporal_layers(enc, cfg->svc_layers) != 0)
+        LOGW("[video_enc] temporal layers unavailable, falling back to IPPP");
+    if (g_gop_smart &&
+        encoder_mpp_set_smart_gop(enc, g_gop.idr_interval, g_gop.base_gop, cfg->bitrate) != 0)
+        LOGW("[video_enc] smart gop unavailable, using fixed gop");
+    eb->sliced = cfg->low_latency && encoder_mpp_set_low_latency(enc, cfg->slices) == 0;
+    if (cfg->low_latency && !eb->sliced)
+        LOGW("[video_enc] slice output unavailable, using whole-frame output");
+    boot_trace_end(BOOT_MPP_CFG);
+    eb->rc = 0;
+}
+
+/**
+ * @brief 编码器预初始化线程函数：与摄像头启动并行执行 video_encoder_boot()
+ *
+ * @param arg 指向 AppConfig 的指针
+ * @return void* 始终返回 NULL
+ */
+static void *encoder_boot_thread(void *arg)
+{
+    boot_trace_thread("enc_boot", 0);
+    video_encoder_boot((const AppConfig *)arg);
+    return NULL;
+}
+
+/**
+ * @brief 视频编码线程函数
+ * 
+ * 工作流程：
+ * 1. 接管 enc_boot 预初始化的 MPP 硬编码器（H.264）
+ * 2. 循环：从 raw 队列取帧 -> 编码 -> 封装成 EncodedPacket -> 推入 H264 队列
+ * 3. 退出时释放编码器资源
+ * 
+ * 编码结果：
+ * - out_data: 编码后的 H.264 NAL 数据（需要 free）
+ * - out_keyframe: 是否为关键帧（I 帧）
+ * 
+ * 低延迟模式（--low-latency）：每帧拆成多个 slice，编完一片就推一片，
+ * 写盘线程不必等整帧编完即可开始输出。
+ * 
+ * 恒定帧率（--cfr）：编码前经 FramePacer 把 PTS 吸附到 1/fps 网格，
+ * 空出的槽位由编码器重复上一帧（P_Skip）填补，重复占用的槽位直接丢帧。
+ * 
+ * 帧率切换：帧上的标称帧率（VideoFrame::fps）变化时先同步码控与节拍器再编码该帧；
+ * --idle-fps 的静止 / 运动判定也在本线程，结果经 g_fps_target 交给采集线程。
+ * 
+ * @param arg 指向 ThreadArgs 的指针
+ * @return void* 始终返回 NULL
+ */
+static void *video_encode_thread(void *arg)
+{
+    ThreadArgs *ta = (ThreadArgs *)arg;
+    const AppConfig *cfg = ta->cfg;
+    boot_trace_thread("video_enc", 0);
+
+    /* 接管 enc_boot 初始化好的 MPP 硬编码器；回放时不打开硬件，模拟编码器只用到 PTS / 层数字段 */
+    EncoderMPP enc;
+    TimingCursor replay_cur;
+    TimingEvent replay_last;
+    bool sliced = false;
+    if (g_replay_on) {
+        memset(&enc, 0, sizeof(enc));
+        enc.tsvc_layers = 1;
+        timing_cursor_init(&replay_cur, &g_replay, TT_EV_ENCODE, 0);
+        memset(&replay_last, 0, sizeof(replay_last));
+    } else {
+        /* 编码器已由 enc_boot 初始化（失败时已告警并请求停止） */
+        if (g_enc_boot.rc != 0)
+            return NULL;
+        enc = g_enc_boot.enc;
+        sliced = g_enc_boot.sliced;
+    }
+
+    VideoEncState st;
+    memset(&st, 0, sizeof(st));
+    svc_shed_init(&st.shed, enc.tsvc_layers);
+
+    FramePacer pacer;
+    frame_pacer_init(&pacer, cfg->fps);
+    int enc_fps = cfg->fps;
+
+    while (!should_stop()) {
+        void *item = NULL;
+        
+        /* 阻塞等待取帧 */
+        int r = bq_pop(&g_raw_vq, &item);
+        if (r == 0) break;  /* 队列关闭且为空 */
+        if (r < 0) {
+            av_stats_add_drop(&g_stats, 1);
+            continue;
+        }
+
+        VideoFrame *vf = (VideoFrame *)item;
+
+        if (vf->fps && vf->fps != enc_fps) {
+            video_switch_fps(&enc, &pacer, cfg, vf->fps);
+            enc_fps = vf->fps;
+        }
+
+        if (cfg->cfr) {
+            int pr = video_pace(&pacer, &enc, &st, vf);
+            if (pr <= 0) {
+                free_video_frame(vf);
+                if (pr < 0) break;
+                continue;
+            }
+        }
+
+        /* 帧统计：只读，先于隐私遮挡，反映镜头实际看到的画面 */
+        if (g_fstats_on)
+            frame_stats_process(&g_fstats, vf);
+
+        /* 隐私遮挡：原地改写，先于场景分析（遮挡区内的变化不触发 IDR） */
+        if (g_mask_on)
+            privacy_mask_apply(&g_mask, vf);
+
+        /* 场景切换 / 运动起始 / 直播客户端或 RTP 输出等关键帧 / 录像迁移存储目标时，本帧编成 IDR */
+        bool want_key = atomic_exchange(&g_store_idr, 0) != 0;
+        if (g_live_on && live_server_take_key_request(&g_live))
+            want_key = true;
+        if (g_rtp_on && rtp_out_take_key_request(&g_rtp))
+            want_key = true;
+        bool analyze = g_gop_smart || cfg->idle_fps > 0;
+        if (smart_gop_decide(&g_gop, analyze ? vf->data : NULL, vf->w, vf->h,
+                             vf->stride, want_key) != SG_IDR_NONE && !g_replay_on)
+            encoder_mpp_request_idr(&enc);
+        if (cfg->idle_fps > 0)
+            video_idle_update(cfg, enc_fps);
+
+        /* 调用 MPP 编码，输出为独立的内存块 */
+        uint8_t *pkt_data = NULL;
+        size_t pkt_size = 0;
+        bool key = false;
+        uint32_t crc = 0;
+        uint8_t tid = 0;
+        bool closed = false;
+        /* 轨迹中的编码耗时不含整帧下发时在 H264 队列上的阻塞（那是写盘侧的时序） */
+        uint64_t t0 = rkav_now_monotonic_us(), t1 = 0;
+        uint32_t tflags = 0;
+
+        if (g_replay_on) {
+            closed = video_replay_encode(&enc, &st, &replay_cur, &replay_last, vf, t0, &t1) != 0;
+            pkt_size = replay_last.bytes;
+            tflags   = replay_last.flags;
+        } else if (!sliced) {
+            int er = encoder_mpp_encode_packet(&enc, vf->data, vf->size, vf->pts_us,
+                                               &pkt_data, &pkt_size, &key, &crc, &tid);
+            t1 = rkav_now_monotonic_us();
+            if (er != 0) {
+                av_stats_add_drop(&g_stats, 1);
+                tflags = TT_F_ERR;
+            } else if (pkt_data && pkt_size > 0) {
+                tflags = key ? TT_F_KEY : 0;
+                closed = video_emit(&st, &enc, pkt_data, pkt_size, key, crc, tid, true) != 0;
+            }
+        } else if (encoder_mpp_put_frame(&enc, vf->data, vf->size, vf->pts_us) != 0) {
+            av_stats_add_drop(&g_stats, 1);
+            tflags = TT_F_ERR;
+        } else {
+            closed   = video_drain(&enc, &st);
+            pkt_size = st.frame_bytes;
+            tflags   = st.frame_key ? TT_F_KEY : 0;
+        }
+        if (!t1) t1 = rkav_now_monotonic_us();
+        trace_event(TT_EV_ENCODE, 0, tflags, pkt_size, t1 - t0, t0);
+
+        free_video_frame(vf);
+        if (closed) break;
+    }
+
+    if (cfg->cfr) {
+        LOGI("[video_enc] cfr total: repeat=%llu drop=%llu resync=%llu",
+             (unsigned long long)pacer.repeated, (unsigned long long)pacer.dropped,
+             (unsigned long long)pacer.resyncs);
+    }
+    free(st.asm_buf);
+    if (!g_replay_on)
+        encoder_mpp_deinit(&enc);
+    return NULL;
+}
+
+/** overrun 缺口补静音的上限：更长的缺口只补这么多，其余由 PTS 跳过 */
+#define AUDIO_XRUN_FILL_MAX_US  2000000ULL
+
+/**
+ * @brief 推入 frames 帧静音（按 period 切块，PTS 连续推进）
+ *
+ * @return int 0 成功；-1 队列已关闭
+ */
+static int audio_push_silence(AudioArgs *aa, const AudioCapture *ac, uint64_t frames,
+                              uint64_t *pts_us)
+{
+    while (frames > 0) {
+        uint32_t n = frames > ac->frames_per_period ? (uint32_t)ac->frames_per_period
+                                                    : (uint32_t)frames;
+        size_t bytes = (size_t)n * ac->bytes_per_frame;
+        frames -= n;
+
+        /* 全零在 S16 / S32 / F32 下都是静音 */
+        AudioChunk *chunk = (AudioChunk *)calloc(1, sizeof(AudioChunk));
+        uint8_t *buf = (uint8_t *)calloc(1, bytes);
+        if (!chunk || !buf) {
+            free(chunk);
+            free(buf);
+            av_stats_add_drop(&g_stats, 1);
+            *pts_us += (uint64_t)n * 1000000ULL / (uint64_t)ac->sample_rate;
+            continue;
+        }
+        chunk->data = buf;
+        chunk->bytes = bytes;
+        chunk->sample_rate = (int)ac->sample_rate;
+        chunk->channels = ac->channels;
+        chunk->bytes_per_sample = (int)(ac->bytes_per_frame / (size_t)ac->channels);
+        chunk->sample_fmt = ac->sample_fmt;
+        chunk->frames = n;
+        chunk->pts_us = *pts_us;
+        chunk->crc32c = crc32c(buf, bytes);
+        *pts_us += (uint64_t)n * 1000000ULL / (uint64_t)ac->sample_rate;
+
+        if (bq_push(aa->out_q, chunk) != 0) {
+            free_audio_chunk(chunk);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 音频采集线程函数
+ * 
+ * 工作流程：
+ * 1. 打开 ALSA 采集设备
+ * 2. 循环：读取 PCM 数据 -> 打时间戳 -> 封装成 AudioChunk -> 推入队列
+ * 3. 退出时关闭设备
+ * 
+ * PTS 策略：
+ * - 起始时刻使用 CLOCK_MONOTONIC 获取
+ * - 后续每块的 PTS 按采样帧数累加推算：pts += frames * 1000000 / sample_rate
+ * - 这样保证 PTS 连续且与实际采样时长一致
+ * 
+ * overrun：采集模块测出恢复前后丢失的帧数（audio_capture_take_gap），
+ * --audio-xrun fill 时补同样长度的静音块（最多 AUDIO_XRUN_FILL_MAX_US），其余时长让 PTS 直接跳过，
+ * 两种方式下后续块的 PTS 都与真实采集时刻对齐，音画不会因一次 overrun 永久错位。
+ * 
+ * 多麦克风：每路一个线程，各自推入 AudioArgs::out_q，并把 xrun 累计值上报给混音器。
+ * 
+ * @param arg 指向 AudioArgs 的指针
+ * @return void* 始终返回 NULL
+ */
+static void *audio_capture_thread(void *arg)
+{
+    AudioArgs *aa = (AudioArgs *)arg;
+    const AppConfig *cfg = aa->cfg;
+    boot_trace_thread(aa->name, aa->index);
+
+    /* 初始化 ALSA 采集（设备格式自动协商，读出后转换为管线格式） */
+    AudioCapture ac;
+    AudioCaptureOpts aopts = {
+        .sample_fmt = cfg->audio_sample_fmt,
+        .dither     = cfg->audio_dither,
+        .period_us  = cfg->audio_period_us,
+        .buffer_us  = cfg->audio_buffer_us,
+    };
+    if (audio_capture_open(&ac, aa->device, cfg->sample_rate,
+                           aa->channels, &aopts) != 0) {
+        LOGE("[audio_cap] mic%d open failed: %s", aa->index, aa->device);
+        request_stop();
+        return NULL;
+    }
+
+    /* 起始 PTS 用 monotonic 时钟，后续靠采样计数推进 */
+    uint64_t pts_us = rkav_now_monotonic_us();
+
+    /* 每次读取的字节数 = period 帧数 × 每帧字节数 */
+    size_t chunk_bytes = (size_t)ac.frames_per_period * ac.bytes_per_frame;
+    uint64_t xruns_seen = 0;
+
+    while (!should_stop()) {
+        /* 分配缓冲区 */
+        uint8_t *buf = (uint8_t *)malloc(chunk_bytes);
+        if (!buf) {
+            av_stats_add_drop(&g_stats, 1);
+            usleep(1000);
+            continue;
+        }
+
+        /* 从 ALSA 读取 PCM 数据（阻塞） */
+        uint64_t r0 = rkav_now_monotonic_us();
+        ssize_t n = audio_capture_read(&ac, buf, chunk_bytes);
+        uint64_t gap = n > 0 ? audio_capture_take_gap(&ac) : 0;
+        if (g_mic_count > 0) {
+            /* 丢失的帧同样占用了真实时长，计入实测速率 */
+            uint32_t got = n > 0 ? (uint32_t)(n / ac.bytes_per_frame + gap) : 0;
+            audio_mixer_note_capture(&g_mixer, aa->index, got, ac.xrun_count,
+                                     rkav_now_monotonic_us());
+        }
+        if (n <= 0) {
+            free(buf);
+            if (!should_stop()) usleep(1000);
+            continue;
+        }
+
+        boot_trace_mark(BOOT_FIRST_AUDIO);
+
+        /* overrun 恢复后的首块之前：补静音 / 跳过丢失的时长，让本块 PTS 对齐真实采集时刻 */
+        if (gap || ac.xrun_count != xruns_seen) {
+            uint64_t fill = 0;
+            if (cfg->audio_xrun_fill) {
+                uint64_t cap = AUDIO_XRUN_FILL_MAX_US * ac.sample_rate / 1000000ULL;
+                fill = gap < cap ? gap : cap;
+            }
+            uint64_t lost_us = gap * 1000000ULL / ac.sample_rate;
+            uint64_t fill_us = fill * 1000000ULL / ac.sample_rate;
+            xruns_seen = ac.xrun_count;
+            LOGW("[audio_cap] mic%d overrun #%llu: lost %.1fms (fill %.1fms, skip %.1fms)",
+                 aa->index, (unsigned long long)ac.xrun_count, (double)lost_us / 1000.0,
+                 (double)fill_us / 1000.0, (double)(lost_us - fill_us) / 1000.0);
+            av_stats_add_xrun(&g_stats, lost_us, fill_us);
+
+            if (fill && audio_push_silence(aa, &ac, fill, &pts_us) != 0) {
+                free(buf);
+                break;
+            }
+            pts_us += (gap - fill) * 1000000ULL / ac.sample_rate;
+        }
+
+        /* 计算实际读取的采样帧数 */
+        uint32_t frames = (uint32_t)(n / ac.bytes_per_frame);
+        uint64_t r1 = rkav_now_monotonic_us();
+        trace_event(TT_EV_AUDIO, aa->index, 0, (uint64_t)n, r1 - r0, r1);
+
+        AudioChunk *chunk = (AudioChunk *)calloc(1, sizeof(AudioChunk));
+        if (!chunk) {
+            free(buf);
+            av_stats_add_drop(&g_stats, 1);
+            continue;
+        }
+
+        chunk->data = buf;
+        chunk->bytes = (size_t)n;
+        chunk->sample_rate = (int)ac.sample_rate;
+        chunk->channels = ac.channels;
+        chunk->bytes_per_sample = (int)(ac.bytes_per_frame / (size_t)ac.channels);
+        chunk->sample_fmt = ac.sample_fmt;
+        chunk->frames = frames;
+        chunk->pts_us = pts_us;
+
+        /* 完整性标签：刚读出的数据仍在缓存中，单独一遍 CRC 的开销很小 */
+        uint64_t t0 = rkav_now_monotonic_ns();
+        chunk->crc32c = crc32c(buf, (size_t)n);
+        av_stats_add_crc(&g_stats, (uint64_t)n, rkav_now_monotonic_ns() - t0);
+
+        // 推进 pts：frames 是“每声道帧数”
+        pts_us += (uint64_t)frames * 1000000ULL / (uint64_t)ac.sample_rate;
+
+        int pr = bq_push(aa->out_q, chunk);
+        if (pr != 0) {
+            free_audio_chunk(chunk);
+            break;
+        }
+    }
+
+    if (ac.xrun_count) {
+        LOGI("[audio_cap] mic%d overruns=%llu lost=%.1fms", aa->index,
+             (unsigned long long)ac.xrun_count,
+             (double)ac.xrun_lost_frames * 1000.0 / (double)ac.sample_rate);
+    }
+    audio_capture_close(&ac);
+    return NULL;
+}
+
+/**
+ * @brief 回放音频采集线程函数（--replay 时替代 audio_capture_thread）
+ *
+ * 按轨迹中本路 AUDIO 事件的相对时刻产生同样大小的静音块（格式取自轨迹文件头），
+ * PTS 与真实采集一样按采样数推进，阻塞推入队列。
+ *
+ * @param arg 指向 AudioArgs 的指针
+ * @return void* 始终返回 NULL
+ */
+static void *replay_audio_thread(void *arg)
+{
+    AudioArgs *aa = (AudioArgs *)arg;
+    const AppConfig *cfg = aa->cfg;
+    int bps = cfg->audio_sample_fmt == RKAV_SAMPLE_S16 ? 2 : 4;
+    size_t frame_bytes = (size_t)aa->channels * (size_t)bps;
+
+    TimingCursor cur;
+    timing_cursor_init(&cur, &g_replay, TT_EV_AUDIO, aa->index);
+    uint64_t pts_us = 0, chunks = 0;
+    const TimingEvent *ev;
+
+    while (!should_stop() && (ev = timing_cursor_next(&cur)) != NULL) {
+        timing_sleep_until(g_replay_t0 + ev->t_us);
+        if (should_stop()) break;
+
+        uint64_t now = rkav_now_monotonic_us();
+        size_t bytes = ev->bytes - ev->bytes % frame_bytes;
+        if (bytes == 0) continue;
+        uint32_t frames = (uint32_t)(bytes / frame_bytes);
+        if (!pts_us) pts_us = now;
+        trace_event(TT_EV_AUDIO, aa->index, 0, bytes, ev->dur_us, now);
+        if (g_mic_count > 0)
+            audio_mixer_note_capture(&g_mixer, aa->index, frames, 0, now);
+
+        AudioChunk *chunk = (AudioChunk *)calloc(1, sizeof(AudioChunk));
+        uint8_t *buf = chunk ? (uint8_t *)calloc(1, bytes) : NULL;
+        if (!buf) {
+            free(chunk);
+            av_stats_add_drop(&g_stats, 1);
+            continue;
+        }
+        chunk->data             = buf;
+        chunk->bytes            = bytes;
+        chunk->sample_rate      = (int)cfg->sample_rate;
+        chunk->channels         = aa->channels;
+        chunk->bytes_per_sample = bps;
+        chunk->sample_fmt       = cfg->audio_sample_fmt;
+        chunk->frames           = frames;
+        chunk->pts_us           = pts_us;
+        chunk->crc32c           = crc32c(buf, bytes);
+        pts_us += (uint64_t)frames * 1000000ULL / (uint64_t)cfg->sample_rate;
+        chunks++;
+
+        if (bq_push(aa->out_q, chunk) != 0) {
+            free_audio_chunk(chunk);
+            break;
+        }
+    }
+
+    LOGI("[replay] mic%d done: %llu chunks", aa->index, (unsigned long long)chunks);
+    replay_source_done();
+    return NULL;
+}
+
+/**
+ * @brief 多麦克风混音线程函数
+ * 
+ * 以主设备（mic0）队列为节拍：阻塞等待 mic0 的块，随后非阻塞取空其它队列，
+ * 全部投递给混音器，再把能输出的混音块推入 g_aud_q。
+ * 混音器内部按 PTS 对齐起点、以 dev0 为时钟做漂移补偿（见 audio_mix.c）。
+ * 
+ * mic0 队列关闭且取空后退出。
+ * 
+ * @param arg 未使用
+ * @return void* 始终返回 NULL
+ */
+static void *audio_mix_thread(void *arg)
+{
+    (void)arg;
+
+    /* mic0 暂无数据时单次阻塞的上限，保证次设备数据也能及时被取走 */
+    const uint64_t poll_us = 5000;
+    int master_open = 1;
+
+    while (master_open) {
+        void *item = NULL;
+        int r = bq_pop_timeout(&g_mic_q[0], &item, poll_us);
+        if (r == 0) master_open = 0;
+        if (r < 0) continue;
+
+        uint64_t now = rkav_now_monotonic_us();
+        if (r == 1) {
+            audio_mixer_feed(&g_mixer, 0, (AudioChunk *)item, now);
+            free_audio_chunk((AudioChunk *)item);
+        }
+        for (int i = 1; i < g_mic_count; i++) {
+            while (bq_pop_timeout(&g_mic_q[i], &item, 0) == 1) {
+                audio_mixer_feed(&g_mixer, i, (AudioChunk *)item, now);
+                free_audio_chunk((AudioChunk *)item);
+            }
+        }
+
+        AudioChunk *out = NULL;
+        while (audio_mixer_pull(&g_mixer, now, &out) == 1) {
+            out->crc32c = crc32c(out->data, out->bytes);
+            if (bq_push(&g_aud_q, out) != 0) {
+                free_audio_chunk(out);
+                master_open = 0;
+                break;
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 复核数据的 CRC32C（与产生处计算的值比对）
+ * 
+ * 不一致说明数据在进入 sink 之前就已损坏，返回 RECIDX_F_PREWRITE_BAD；
+ * 索引里始终保存产生处的 CRC，事后校验即可判断损坏发生在写盘前还是写盘后。
+ * 
+ * @param data    数据（明文）
+ * @param size    字节数
+ * @param crc     产生处计算的 CRC32C
+ * @param offset  当前段内偏移（仅用于日志）
+ * @param tag     日志标签
+ * @return uint32_t 需要追加的 RECIDX_F_* 标志
+ */
+static uint32_t prewrite_check(const uint8_t *data, size_t size, uint32_t crc, uint64_t offset,
+                               const char *tag)
+{
+    uint64_t t0 = rkav_now_monotonic_ns();
+    uint32_t now_crc = crc32c(data, size);
+    av_stats_add_crc(&g_stats, size, rkav_now_monotonic_ns() - t0);
+    if (now_crc == crc) return 0;
+
+    av_stats_inc_crc_error(&g_stats);
+    LOGW("[%s] pre-write CRC mismatch at offset %llu: %08x != %08x", tag,
+         (unsigned long long)offset, now_crc, crc);
+    return RECIDX_F_PREWRITE_BAD;
+}
+
+/**
+ * @brief 写入一个包/音频块，并追加索引记录
+ * 
+ * @param fp      媒体文件
+ * @param ri      索引（ri->fp 为 NULL 表示未启用）
+ * @param offset  当前文件偏移（明文偏移，加密文件不含文件头），由调用方推进
+ * @param wire    实际写出的字节（未加密时即数据本身，加密时为暂存缓冲中的密文）
+ * @param size    字节数
+ * @param crc     产生处计算的 CRC32C
+ * @param pts_us  PTS
+ * @param flags   RECIDX_F_* 标志
+ * @param tag     日志标签
+ * @return int    0 成功，-1 写失败
+ */
+static int write_indexed(FILE *fp, RecIndex *ri, uint64_t offset, const uint8_t *wire,
+                         size_t size, uint32_t crc, uint64_t pts_us, uint32_t flags,
+                         const char *tag)
+{
+    size_t w = fwrite(wire, 1, size, fp);
+    if (w != size) {
+        LOGW("[%s] partial write: %zu/%zu", tag, w, size);
+        return -1;
+    }
+
+    if (ri->fp)
+        rec_index_append(ri, offset, (uint32_t)size, crc, pts_us, flags);
+    return 0;
+}
+
+/** 音频在目录中的关键点间隔（PCM 任意块都可作为起点，只需控制目录密度） */
+#define REC_AUDIO_KEY_GAP_US  1000000ull
+
+/**
+ * @brief 一个段在一个存储目标上的文件（镜像模式下一段有多份，内容与偏移相同）
+ */
+typedef struct {
+    FILE        *fp;
+    RecIndex     ri;
+    int          target;        /**< 存储目标序号，-1 表示未启用 --store */
+    int64_t      seg_id;        /**< 目录段号，-1 表示未登记 */
+    char         path[REC_CATALOG_MAX_PATH];
+} RecLeg;
+
+/**
+ * @brief 一路录像输出（按 --segment-sec 分段，每段一个媒体文件 + .idx，并登记到目录）
+ *
+ * 启用 --store 时每段按存储模式写到一个或多个目标上；某个目标写失败只关闭它那一份，
+ * 全部失败时立即在其他目标上开新段，存储状态变化时在下一个起点处迁移。
+ */
+typedef struct {
+    const AppConfig *cfg;
+    const char  *tag;           /**< 日志标签 */
+    RecIndexKind kind;
+    const char  *base;          /**< 配置的输出路径 */
+    uint64_t     key_gap_us;    /**< 目录关键点最小间隔，0 表示每个关键帧都登记 */
+
+    RecLeg       legs[STORAGE_MAX_TARGETS];
+    int          nlegs;         /**< 当前段仍在写的文件数，0 表示没有打开的段 */
+    uint64_t     offset;        /**< 当前段内偏移 */
+    char         path[REC_CATALOG_MAX_PATH]; /**< 段文件名（--store 时只取文件名，写到各目标目录下） */
+    uint64_t     start_pts;     /**< 段首 PTS */
+    uint64_t     last_pts;      /**< 最近写入的 PTS */
+    uint64_t     last_key_pts;  /**< 最近登记的目录关键点 PTS */
+    uint32_t     segments;      /**< 已打开的段数 */
+    unsigned     store_gen;     /**< 已处理的存储状态代次 */
+    bool         move_pending;  /**< 存储状态变化，下一个起点处换目标开新段 */
+
+    RecCryptHeader crypt;       /**< 当前段的加密文件头（g_crypt_on 时有效，各份相同） */
+    uint8_t     *stage;         /**< 加密暂存缓冲（包数据与直播共享，不能原地加密） */
+    size_t       stage_cap;
+} RecFile;
+
+/* 段文件名：不分段时即输出路径，否则在扩展名前插入本地时间 "_YYYYmmdd-HHMMSS" */
+static int rec_file_make_path(RecFile *rf)
+{
+    if (!rf->cfg->segment_sec) {
+        int n = snprintf(rf->path, sizeof(rf->path), "%s", rf->base);
+        return (n < 0 || (size_t)n >= sizeof(rf->path)) ? -1 : 0;
+    }
+
+    char stamp[32];
+    time_t now = time(NULL);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+
+    const char *slash = strrchr(rf->base, '/');
+    const char *dot   = strrchr(rf->base, '.');
+    if (dot && slash && dot < slash) dot = NULL;
+    int stem = dot ? (int)(dot - rf->base) : (int)strlen(rf->base);
+    int n = snprintf(rf->path, sizeof(rf->path), "%.*s_%s%s", stem, rf->base, stamp, dot ? dot : "");
+    return (n < 0 || (size_t)n >= sizeof(rf->path)) ? -1 : 0;
+}
+
+/** 段文件重名时追加的 "_N" 后缀上限 */
+#define REC_NAME_MAX_DUP  1000
+
+/*
+ * 一份段文件的路径：--store 时为 <目标目录>/<段文件名>，否则即段文件名；
+ * dup > 0 时在扩展名前插入 "_<dup>"。
+ */
+static int rec_leg_make_path(const RecFile *rf, RecLeg *leg, int target, unsigned dup)
+{
+    const char *slash = strrchr(rf->path, '/');
+    const char *name  = slash ? slash + 1 : rf->path;
+    const char *dot   = strrchr(name, '.');
+    int stem = dot ? (int)(dot - name) : (int)strlen(name);
+    char suffix[16] = "";
+    if (dup) snprintf(suffix, sizeof(suffix), "_%u", dup);
+
+    int n;
+    if (target >= 0)
+        n = snprintf(leg->path, sizeof(leg->path), "%s/%.*s%s%s", storage_root(&g_store, target),
+                     stem, name, suffix, dot ? dot : "");
+    else
+        n = snprintf(leg->path, sizeof(leg->path), "%.*s%s%s", (int)(name - rf->path) + stem,
+                     rf->path, suffix, dot ? dot : "");
+    return (n < 0 || (size_t)n >= sizeof(leg->path)) ? -1 : 0;
+}
+
+/**
+ * @brief 在一个存储目标上创建段文件：独占创建媒体文件，登记目录，再创建索引
+ *
+ * 分段或启用 --store 时每一份都是新文件（O_EXCL）：主备切换、切回恢复的目标、同一秒内
+ * 开的两段都可能落到已写过的同名文件上，此时在扩展名前加 "_N"，从不截断已有录像。
+ * 只有不分段、不用 --store 的单个输出文件保持每次运行覆盖。
+ *
+ * @param target 存储目标序号，-1 表示直接写段文件名
+ * @return int 0 成功，-1 打开失败
+ */
+static int rec_leg_open(RecFile *rf, RecLeg *leg, int target, uint64_t pts_us)
+{
+    memset(leg, 0, sizeof(*leg));
+    leg->target = target;
+    leg->seg_id = -1;
+
+    bool exclusive = target >= 0 || rf->cfg->segment_sec;
+    int fd = -1;
+    unsigned dup = 0;
+    for (; dup < REC_NAME_MAX_DUP; dup++) {
+        if (rec_leg_make_path(rf, leg, target, dup) != 0) {
+            LOGE("[%s] output path too long: %s", rf->tag, rf->path);
+            return -1;
+        }
+        fd = open(leg->path, O_WRONLY | O_CREAT | O_CLOEXEC | (exclusive ? O_EXCL : O_TRUNC), 0644);
+        if (fd >= 0 || errno != EEXIST || !exclusive) break;
+    }
+    leg->fp = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (!leg->fp) {
+        LOGE("[%s] open file failed: %s (%s)", rf->tag, leg->path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+            unlink(leg->path);
+        }
+        return -1;
+    }
+    if (dup) LOGW("[%s] name in use, writing %s instead", rf->tag, leg->path);
+
+    /* 镜像的每一份各成一条目录流（流序号 = 目标序号），同一条流内的段互不重叠 */
+    int index = (g_store_on && g_store.mode == STORAGE_MIRROR) ? target : 0;
+    leg->seg_id = g_cat_on ? rec_catalog_seg_open(&g_cat, rf->kind, index, leg->path, pts_us) : -1;
+    LOGI("[%s] opened: %s%s", rf->tag, leg->path, g_crypt_on ? " (aes-256-ctr)" : "");
+
+    /* 加密：文件头先写，之后的偏移都按明文计 */
+    if (g_crypt_on && fwrite(&rf->crypt, sizeof(rf->crypt), 1, leg->fp) != 1) {
+        LOGE("[%s] write crypt header failed: %s", rf->tag, leg->path);
+        fclose(leg->fp);
+        leg->fp = NULL;
+        if (leg->seg_id >= 0) rec_catalog_seg_close(&g_cat, (uint32_t)leg->seg_id, pts_us, 0);
+        return -1;
+    }
+
+    /* 低延迟模式：不经 stdio 缓冲，每个 slice 直接 write 到内核 */
+    if (rf->kind == REC_INDEX_H264 && rf->cfg->low_latency)
+        setvbuf(leg->fp, NULL, _IONBF, 0);
+
+    /* 索引 sidecar：<段文件>.idx，每包/块一条（偏移/长度/PTS/CRC32C） */
+    if (rf->cfg->rec_index && rec_index_open(&leg->ri, leg->path, rf->kind) != 0)
+        LOGW("[%s] index disabled", rf->tag);
+    return 0;
+}
+
+/* 关闭一份段文件：登记结束时间与大小，归还存储目标（关闭时刷出缓冲失败也记为写失败） */
+static void rec_leg_close(RecFile *rf, RecLeg *leg)
+{
+    if (fclose(leg->fp) != 0) {
+        LOGW("[%s] close failed: %s", rf->tag, leg->path);
+        if (leg->target >= 0) storage_note_write(&g_store, leg->target, 0, 0, false);
+    }
+    leg->fp = NULL;
+    rec_index_close(&leg->ri);
+
+    if (leg->seg_id >= 0) {
+        rec_catalog_seg_close(&g_cat, (uint32_t)leg->seg_id, rf->last_pts, rf->offset);
+        leg->seg_id = -1;
+    }
+    if (leg->target >= 0) storage_release(&g_store, leg->target);
+}
+
+/**
+ * @brief 打开一个新段：按存储模式选目标，在每个目标上创建段文件
+ *
+ * 启用 --store 时某个目标打开失败即判为 DOWN，换下一个目标重选。
+ *
+ * @return int 0 成功（至少打开一份），-1 全部失败
+ */
+static int rec_file_open(RecFile *rf, uint64_t pts_us)
+{
+    if (rec_file_make_path(rf) != 0) {
+        LOGE("[%s] output path too long: %s", rf->tag, rf->base);
+        return -1;
+    }
+
+    /* 加密：每段一个随机 nonce，镜像的各份文件头相同 */
+    if (g_crypt_on && rec_crypt_new_header(&g_crypt_key, &rf->crypt) != 0) {
+        LOGE("[%s] crypt header failed: %s", rf->tag, rf->path);
+        return -1;
+    }
+
+    rf->nlegs = 0;
+    rf->move_pending = false;
+    for (int attempt = 0; attempt < STORAGE_MAX_TARGETS && rf->nlegs == 0; attempt++) {
+        int targets[STORAGE_MAX_TARGETS] = { -1 };
+        int n = 1;
+        if (g_store_on) {
+            rf->store_gen = storage_generation(&g_store);
+            n = storage_select(&g_store, targets, STORAGE_MAX_TARGETS);
+            if (n == 0) {
+                LOGE("[%s] no storage target available", rf->tag);
+                return -1;
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            if (rec_leg_open(rf, &rf->legs[rf->nlegs], targets[i], pts_us) == 0) {
+                rf->nlegs++;
+            } else if (targets[i] >= 0) {
+                storage_note_write(&g_store, targets[i], 0, 0, false);
+                storage_release(&g_store, targets[i]);
+            }
+        }
+        if (!g_store_on) break;
+    }
+    if (rf->nlegs == 0) return -1;
+
+    rf->offset       = 0;
+    rf->start_pts    = pts_us;
+    rf->last_pts     = pts_us;
+    rf->last_key_pts = 0;
+    rf->segments++;
+    return 0;
+}
+
+/* 关闭当前段，登记结束时间与大小，然后执行保留策略 */
+static void rec_file_close(RecFile *rf)
+{
+    if (rf->nlegs == 0) return;
+    for (int i = 0; i < rf->nlegs; i++)
+        rec_leg_close(rf, &rf->legs[i]);
+    rf->nlegs = 0;
+
+    if (g_cat_on)
+        rec_catalog_retain(&g_cat, rf->cfg->retain_sec, (uint64_t)rf->cfg->retain_mb << 20);
+}
+
+/* 存储状态有变化时判断是否迁移：在下一个起点处换目标开新段，视频同时请求 IDR 让起点尽快到来 */
+static void rec_file_check_store(RecFile *rf)
+{
+    unsigned gen = storage_generation(&g_store);
+    if (gen == rf->store_gen || rf->nlegs == 0 || rf->move_pending) return;
+    rf->store_gen = gen;
+
+    int cur[STORAGE_MAX_TARGETS];
+    for (int i = 0; i < rf->nlegs; i++)
+        cur[i] = rf->legs[i].target;
+    if (!storage_should_move(&g_store, cur, rf->nlegs)) return;
+
+    rf->move_pending = true;
+    LOGI("[%s] storage state changed, moving at next %s", rf->tag,
+         rf->kind == REC_INDEX_H264 ? "keyframe" : "chunk");
+    if (rf->kind == REC_INDEX_H264)
+        atomic_store(&g_store_idr, 1);
+}
+
+/**
+ * @brief 写入一个包/块
+ *
+ * @param key  该数据是否可作为随机访问起点（视频：关键帧首片；音频：任意块）。
+ *             分段与存储迁移只在起点处切段；启用目录时起点登记为关键点。
+ * @return int 0 成功（启用 --store 时所有目标都不可用也返回 0，数据计入丢失），
+ *             -1 写失败或新段打开失败
+ */
+static int rec_file_write(RecFile *rf, const uint8_t *data, size_t size, uint32_t crc,
+                          uint64_t pts_us, uint32_t flags, bool key)
+{
+    if (g_store_on)
+        rec_file_check_store(rf);
+
+    if (key && rf->nlegs > 0 &&
+        (rf->move_pending || (rf->cfg->segment_sec &&
+                              pts_us >= rf->start_pts + (uint64_t)rf->cfg->segment_sec * 1000000ull))) {
+        rec_file_close(rf);
+        if (rec_file_open(rf, pts_us) != 0 && !g_store_on) return -1;
+    }
+
+    /* 启用索引时复核 CRC（各份索引共用结果） */
+    if (rf->cfg->rec_index)
+        flags |= prewrite_check(data, size, crc, rf->offset, rf->tag);
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        /* 没有可写的段：未启用 --store 时即失败；否则立即在其他目标上开新段（不等起点，视频请求 IDR） */
+        if (rf->nlegs == 0) {
+            if (!g_store_on || rec_file_open(rf, pts_us) != 0) break;
+            if (rf->kind == REC_INDEX_H264 && !key)
+                atomic_store(&g_store_idr, 1);
+        }
+
+        if (key && (rf->offset == 0 || pts_us >= rf->last_key_pts + rf->key_gap_us)) {
+            for (int i = 0; i < rf->nlegs; i++) {
+                if (rf->legs[i].seg_id >= 0)
+                    rec_catalog_key(&g_cat, (uint32_t)rf->legs[i].seg_id, pts_us, rf->offset);
+            }
+            rf->last_key_pts = pts_us;
+        }
+
+        /* 加密到暂存缓冲：计数器按明文偏移，任意块可单独解密 */
+        const uint8_t *wire = data;
+        if (g_crypt_on) {
+            if (size > rf->stage_cap) {
+                uint8_t *p = realloc(rf->stage, size);
+                if (!p) {
+                    LOGE("[%s] stage alloc failed: %zu", rf->tag, size);
+                    return -1;
+                }
+                rf->stage     = p;
+                rf->stage_cap = size;
+            }
+            uint64_t t0 = rkav_now_monotonic_ns();
+            rec_crypt_apply(&g_crypt_key, &rf->crypt, rf->offset, data, rf->stage, size);
+            av_stats_add_aes(&g_stats, size, rkav_now_monotonic_ns() - t0);
+            wire = rf->stage;
+        }
+
+        /* 逐份写出；写失败的一份关闭，其余照常 */
+        for (int i = 0; i < rf->nlegs; i++) {
+            RecLeg *leg = &rf->legs[i];
+            uint64_t t0 = rkav_now_monotonic_us();
+            int r = write_indexed(leg->fp, &leg->ri, rf->offset, wire, size, crc, pts_us, flags,
+                                  rf->tag);
+            if (leg->target >= 0)
+                storage_note_write(&g_store, leg->target, size, rkav_now_monotonic_us() - t0, r == 0);
+            if (r == 0) continue;
+
+            LOGW("[%s] dropping failed copy: %s", rf->tag, leg->path);
+            rec_leg_close(rf, leg);
+            rf->legs[i--] = rf->legs[--rf->nlegs];
+        }
+        if (rf->nlegs > 0) {
+            rf->offset  += size;
+            rf->last_pts = pts_us;
+            return 0;
+        }
+    }
+
+    if (!g_store_on) return -1;
+    storage_note_lost(&g_store, size);
+    return 0;
+}
+
+/* 回放：写出按轨迹中下一条写事件的耗时补足（本机写得更慢时不再等待） */
+static void replay_pad(TimingCursor *cur, uint64_t start_us)
+{
+    const TimingEvent *ev = timing_cursor_next(cur);
+    if (ev)
+        timing_sleep_until(start_us + ev->dur_us);
+}
+
+/**
+ * @brief 运行时控制线程函数
+ *
+ * 串行处理控制套接字上的命令，request_stop() 时由 ctl_stop() 唤醒退出。
+ *
+ * @param arg 未使用
+ * @return void* 始终返回 NULL
+ */
+static void *ctl_thread(void *arg)
+{
+    (void)arg;
+    ctl_run(&g_ctl);
+    return NULL;
+}
+
+/* 控制命令 mask：查看 / 替换 / 追加 / 清除隐私遮挡 */
+static int mask_ctl(void *ud, const char *args, char *reply, size_t cap)
+{
+    PrivacyMask *pm = (PrivacyMask *)ud;
+    int r;
+
+    if (args[0] == '\0') {
+        r = 0;
+    } else if (strncmp(args, "set ", 4) == 0) {
+        r = privacy_mask_set(pm, args + 4, reply, cap);
+    } else if (strcmp(args, "clear") == 0) {
+        r = privacy_mask_set(pm, "", reply, cap);
+    } else if (strncmp(args, "add ", 4) == 0) {
+        char spec[PM_SPEC_MAX];
+        size_t n = privacy_mask_get(pm, spec, sizeof(spec));
+        if (n + 1 + strlen(args + 4) >= sizeof(spec)) {
+            snprintf(reply, cap, "spec too long (max %d)", PM_SPEC_MAX - 1);
+            return -1;
+        }
+        snprintf(spec + n, sizeof(spec) - n, "%s%s", n ? ";" : "", args + 4);
+        r = privacy_mask_set(pm, spec, reply, cap);
+    } else {
+        snprintf(reply, cap, "usage: mask [set <spec> | add <region> | clear]");
+        return -1;
+    }
+    if (r != 0) return -1;
+
+    /* 回显当前生效的描述 */
+    if (privacy_mask_get(pm, reply, cap) == 0)
+        snprintf(reply, cap, "(none)");
+    return 0;
+}
+
+/* 控制命令 img：最近一帧的帧统计与当前告警 */
+static int img_ctl(void *ud, const char *args, char *reply, size_t cap)
+{
+    (void)args;
+    FrameStatsSnap s;
+    frame_stats_get((FrameStats *)ud, &s);
+    if (!(s.flags & RKAV_IMG_F_VALID)) {
+        snprintf(reply, cap, "no frame analysed yet");
+        return -1;
+    }
+
+    char alarms[64] = "";
+    size_t a = 0;
+    for (uint16_t bit = RKAV_IMG_F_DARK; bit <= RKAV_IMG_F_CHANGED && a < sizeof(alarms); bit <<= 1) {
+        if (s.alarms & bit)
+            a += (size_t)snprintf(alarms + a, sizeof(alarms) - a, "%s%s", a ? "," : "",
+                                  frame_stats_flag_name(bit));
+    }
+    int off = snprintf(reply, cap,
+                       "frame=%llu mean=%.1f std=%.1f dark=%.1f%% clip=%.1f%% sharp=%.2f/%.2f "
+                       "change=%.2f alarms=%s\nhist16(%%)",
+                       (unsigned long long)s.frame_id, s.mean, s.stddev, s.dark_ratio * 100.0,
+                       s.clip_ratio * 100.0, s.sharpness, s.sharp_base, s.change,
+                       alarms[0] ? alarms : "none");
+    /* 16 档亮度分布 */
+    for (int b = 0; b < 16 && off > 0 && (size_t)off < cap; b++) {
+        uint32_t n = 0;
+        for (int i = 0; i < FS_HIST_BINS / 16; i++) n += s.hist[b * (FS_HIST_BINS / 16) + i];
+        off += snprintf(reply + off, cap - (size_t)off, " %.0f", s.samples ? n * 100.0 / s.samples : 0.0);
+    }
+    return 0;
+}
+
+/* 控制命令 fps：查看帧率状态，固定帧率（1..--fps）或恢复自动 */
+static int fps_ctl(void *ud, const char *args, char *reply, size_t cap)
+{
+    const AppConfig *cfg = (const AppConfig *)ud;
+
+    if (strcmp(args, "auto") == 0) {
+        atomic_store(&g_fps_pinned, 0);
+        atomic_store(&g_fps_target, cfg->fps);
+    } else if (args[0] != '\0') {
+        char *end = NULL;
+        long v = strtol(args, &end, 10);
+        if (*end != '\0' || v < 1 || v > cfg->fps) {
+            snprintf(reply, cap, "usage: fps [<1-%d> | auto]", cfg->fps);
+            return -1;
+        }
+        atomic_store(&g_fps_pinned, 1);
+        atomic_store(&g_fps_target, (int)v);
+    }
+
+    int sx100 = atomic_load(&g_sensor_fps_x100);
+    snprintf(reply, cap, "target=%d mode=%s nominal=%d idle=%d sensor=%d.%02d%s",
+             atomic_load(&g_fps_target), atomic_load(&g_fps_pinned) ? "pinned" : "auto",
+             cfg->fps, cfg->idle_fps, sx100 / 100, sx100 % 100, sx100 ? "" : " (unknown)");
+    return 0;
+}
+
+/**
+ * @brief 直播预览服务线程函数
+ * 
+ * epoll 循环：接受连接、把编码包封装成 HTTP-FLV / fMP4 分片推给各客户端，
+ * 断开跟不上的慢客户端。request_stop() 时由 live_server_stop() 唤醒退出。
+ * 
+ * @param arg 未使用
+ * @return void* 始终返回 NULL
+ */
+static void *live_server_thread(void *arg)
+{
+    (void)arg;
+    live_server_run(&g_live);
+    return NULL;
+}
+
+/**
+ * @brief RTP 输出线程函数
+ *
+ * 从收件箱取编码包，按 RFC 6184 打包发出，并按帧类别的冗余比例编码修复包。
+ * request_stop() 时 rtp_out_stop() 关闭收件箱，发完剩余的包后退出。
+ *
+ * @param arg 未使用
+ * @return void* 始终返回 NULL
+ */
+static void *rtp_out_thread(void *arg)
+{
+    (void)arg;
+    rtp_out_run(&g_rtp);
     return NULL;
 }
 
@@ -610,11 +2253,11 @@ static void *audio_capture_thread(void *arg)
  * 
  * 工作流程：
  * 1. 打开输出文件（.h264 裸流）
- * 2. 循环：从 H264 队列取出编码包 -> 写入文件
+ * 2. 循环：从 H264 队列取出编码包 -> 写入文件（--segment-sec 时在到期后的第一个关键帧处切段）
  * 3. 退出时关闭文件
  * 
  * PTS Delta 计算：
- * 记录相邻两帧的 PTS 差值，用于统计线程输出帧间隔。
+ * 记录相邻两帧的 DTS 差值（包按解码顺序到达，重排序时 PTS 不单调），用于统计线程输出帧间隔。
  * 
  * @param arg 指向 ThreadArgs 的指针
  * @return void* 始终返回 NULL
@@ -624,16 +2267,23 @@ static void *h264_sink_thread(void *arg)
     ThreadArgs *ta = (ThreadArgs *)arg;
     const AppConfig *cfg = ta->cfg;
 
-    /* 打开 H.264 输出文件 */
-    FILE *fp = fopen(cfg->output_path_h264, "wb");
-    if (!fp) {
-        LOGE("[h264_sink] open file failed: %s", cfg->output_path_h264);
+    /* 打开 H.264 输出文件（分段时为第一段） */
+    boot_trace_thread("h264_sink", 0);
+    RecFile rf = { .cfg = cfg, .tag = "h264_sink", .kind = REC_INDEX_H264,
+                   .base = cfg->output_path_h264 };
+    boot_trace_begin(BOOT_FILE_OPEN);
+    if (rec_file_open(&rf, rkav_now_monotonic_us()) != 0) {
         request_stop();
         return NULL;
     }
-    LOGI("[h264_sink] opened: %s", cfg->output_path_h264);
+    boot_trace_end(BOOT_FILE_OPEN);
+
+    uint64_t last_dts = 0;  /* 上一帧 DTS，用于计算帧间隔 */
+    uint64_t first_enc_us = 0, first_out_us = 0;  /* 本帧首片：采集->编出 / 采集->写出 */
 
-    uint64_t last_pts = 0;  /* 上一帧 PTS，用于计算帧间隔 */
+    /* 回放：每次写出按记录的耗时补足，重现现场存储的卡顿 */
+    TimingCursor replay_cur;
+    timing_cursor_init(&replay_cur, &g_replay, TT_EV_WRITE, 0);
 
     while (!should_stop()) {
         void *item = NULL;
@@ -645,26 +2295,46 @@ static void *h264_sink_thread(void *arg)
 
         EncodedPacket *ep = (EncodedPacket *)item;
         
-        /* 计算并更新 PTS delta（供统计线程输出） */
-        if (last_pts && ep->pts_us > last_pts) {
-            atomic_store(&g_video_pts_delta_us, ep->pts_us - last_pts);
+        /* 计算并更新帧间隔（供统计线程输出）；同帧各片 DTS 相同，不计入 */
+        if (last_dts && ep->dts_us > last_dts) {
+            atomic_store(&g_video_pts_delta_us, ep->dts_us - last_dts);
+        } else if (ep->dts_us < last_dts) {
+            LOGW("[h264_sink] dts went backwards: %llu < %llu",
+                 (unsigned long long)ep->dts_us, (unsigned long long)last_dts);
         }
-        last_pts = ep->pts_us;
+        last_dts = ep->dts_us;
 
-        /* 写入 H.264 数据 */
+        /* 写入 H.264 数据（关键帧标志只打在首片上，索引、分段与目录都定位到帧起点） */
         if (ep->data && ep->size) {
-            size_t w = fwrite(ep->data, 1, ep->size, fp);
-            if (w != ep->size) {
-                LOGW("[h264_sink] partial write: %zu/%zu", w, ep->size);
+            bool key = ep->is_keyframe && ep->slice_idx == 0;
+            uint32_t fl = key ? RECIDX_F_KEYFRAME : 0;
+            if (ep->flags & RKAV_PKT_F_PARTIAL) fl |= RECIDX_F_PARTIAL;
+            uint64_t w0 = rkav_now_monotonic_us();
+            if (rec_file_write(&rf, ep->data, ep->size, ep->crc32c, ep->pts_us, fl, key) != 0)
                 request_stop();
-            }
+            boot_trace_mark(BOOT_FIRST_WRITE);
+            if (g_replay_on)
+                replay_pad(&replay_cur, w0);
+            trace_event(TT_EV_WRITE, 0, ep->is_keyframe ? TT_F_KEY : 0, ep->size,
+                        rkav_now_monotonic_us() - w0, w0);
+        }
+
+        /* 分段延迟：采集时间戳 -> 编码器吐出首片 -> 首片写出 -> 整帧写出 */
+        uint64_t now = rkav_now_monotonic_us();
+        if (ep->slice_idx == 0) {
+            first_enc_us = ep->enc_us > ep->pts_us ? ep->enc_us - ep->pts_us : 0;
+            first_out_us = now > ep->pts_us ? now - ep->pts_us : 0;
         }
+        if (!(ep->flags & RKAV_PKT_F_PARTIAL))
+            av_stats_add_latency(&g_stats, first_enc_us, first_out_us,
+                                 now > ep->pts_us ? now - ep->pts_us : 0);
 
         free_encoded_packet(ep);
     }
 
-    fclose(fp);
-    LOGI("[h264_sink] closed");
+    rec_file_close(&rf);
+    free(rf.stage);
+    LOGI("[h264_sink] closed (%u segment%s)", rf.segments, rf.segments == 1 ? "" : "s");
     return NULL;
 }
 
@@ -673,7 +2343,7 @@ static void *h264_sink_thread(void *arg)
  * 
  * 工作流程：
  * 1. 打开输出文件（.pcm 裸 PCM 数据）
- * 2. 循环：从音频队列取出 AudioChunk -> 写入文件
+ * 2. 循环：从音频队列取出 AudioChunk -> 写入文件（--segment-sec 时在块边界切段）
  * 3. 退出时关闭文件
  * 
  * @param arg 指向 ThreadArgs 的指针
@@ -684,17 +2354,22 @@ static void *pcm_sink_thread(void *arg)
     ThreadArgs *ta = (ThreadArgs *)arg;
     const AppConfig *cfg = ta->cfg;
 
-    /* 打开 PCM 输出文件 */
-    FILE *fp = fopen(cfg->output_path_pcm, "wb");
-    if (!fp) {
-        LOGE("[pcm_sink] open file failed: %s", cfg->output_path_pcm);
+    /* 打开 PCM 输出文件（分段时为第一段） */
+    boot_trace_thread("pcm_sink", 1);
+    RecFile rf = { .cfg = cfg, .tag = "pcm_sink", .kind = REC_INDEX_PCM,
+                   .base = cfg->output_path_pcm, .key_gap_us = REC_AUDIO_KEY_GAP_US };
+    boot_trace_begin(BOOT_FILE_OPEN);
+    if (rec_file_open(&rf, rkav_now_monotonic_us()) != 0) {
         request_stop();
         return NULL;
     }
-    LOGI("[pcm_sink] opened: %s", cfg->output_path_pcm);
+    boot_trace_end(BOOT_FILE_OPEN);
 
     uint64_t last_pts = 0;  /* 上一块 PTS，用于计算帧间隔 */
 
+    TimingCursor replay_cur;
+    timing_cursor_init(&replay_cur, &g_replay, TT_EV_AWRITE, 0);
+
     while (!should_stop()) {
         void *item = NULL;
         
@@ -704,6 +2379,12 @@ static void *pcm_sink_thread(void *arg)
         if (r < 0) continue;
 
         AudioChunk *ac = (AudioChunk *)item;
+
+        /* 首块：打印实际格式，便于 ffplay/ffmpeg 指定 -f/-ar/-ac */
+        if (!last_pts) {
+            LOGI("[pcm_sink] format: %s %dHz ch=%d",
+                 rkav_sample_fmt_name(ac->sample_fmt), ac->sample_rate, ac->channels);
+        }
         
         /* 计算并更新 PTS delta */
         if (last_pts && ac->pts_us > last_pts) {
@@ -713,26 +2394,140 @@ static void *pcm_sink_thread(void *arg)
 
         /* 写入 PCM 数据 */
         if (ac->data && ac->bytes) {
-            size_t w = fwrite(ac->data, 1, ac->bytes, fp);
-            if (w != ac->bytes) {
-                LOGW("[pcm_sink] partial write: %zu/%zu", w, ac->bytes);
+            uint64_t w0 = rkav_now_monotonic_us();
+            if (rec_file_write(&rf, ac->data, ac->bytes, ac->crc32c, ac->pts_us, 0, true) != 0)
                 request_stop();
-            }
+            if (g_replay_on)
+                replay_pad(&replay_cur, w0);
+            trace_event(TT_EV_AWRITE, 0, 0, ac->bytes, rkav_now_monotonic_us() - w0, w0);
         }
 
         av_stats_inc_audio_chunk(&g_stats);
         free_audio_chunk(ac);
     }
 
-    fclose(fp);
-    LOGI("[pcm_sink] closed");
+    rec_file_close(&rf);
+    free(rf.stage);
+    LOGI("[pcm_sink] closed (%u segment%s)", rf.segments, rf.segments == 1 ? "" : "s");
     return NULL;
 }
 
+/* 登记工作线程到自监控（未启用时为空操作） */
+static void mon_add(pthread_t th, const char *name)
+{
+    if (g_mon_on) proc_mon_add(&g_mon, th, name);
+}
+
+/* 直播服务 /metrics 回调（在服务线程中执行）：自监控与帧统计依次拼接 */
+static size_t metrics_format(void *ud, char *buf, size_t cap)
+{
+    (void)ud;
+    size_t o = 0;
+    if (g_mon_on)
+        o += proc_mon_format(&g_mon, buf, cap);
+    if (g_fstats_on && o + 1 < cap)
+        o += frame_stats_format(&g_fstats, buf + o, cap - o);
+    return o;
+}
+
 /* ============================================================================
  *                              主函数
  * ============================================================================ */
 
+/*
+ * 回放：按轨迹记录时的参数重建管线（分辨率、帧率、码率、音频格式），
+ * 路数与当前命令行不一致时只告警（多出的路没有事件，缺少的路不回放）。
+ */
+static void replay_apply_config(AppConfig *cfg, const TimingTraceHeader *h)
+{
+    cfg->video_enabled = h->cams > 0;
+    if (h->width && h->height) {
+        cfg->width  = (int)h->width;
+        cfg->height = (int)h->height;
+    }
+    if (h->fps) cfg->fps = (int)h->fps;
+    if (h->bitrate) cfg->bitrate = (int)h->bitrate;
+    if (h->sample_rate) cfg->sample_rate = h->sample_rate;
+    if (h->channels) cfg->channels = h->channels;
+    cfg->audio_sample_fmt = (RkavSampleFmt)h->sample_fmt;
+
+    if (h->cams > 1 && h->cams != (uint32_t)cfg->sync_device_count + 1)
+        LOGW("[replay] trace has %u cameras, replaying %d (pass matching --sync-dev)",
+             h->cams, cfg->sync_device_count + 1);
+    if (h->mics > 1 && h->mics != (uint32_t)cfg->mic_device_count + 1)
+        LOGW("[replay] trace has %u microphones, replaying %d (pass matching --mic-dev)",
+             h->mics, cfg->mic_device_count + 1);
+    if (cfg->cfr) {
+        LOGW("[replay] --cfr ignored (the mock encoder cannot repeat frames)");
+        cfg->cfr = 0;
+    }
+    cfg->idle_fps     = 0;      /* 合成源不响应帧率切换 */
+    cfg->duration_sec = 0;      /* 放完轨迹即停止 */
+    LOGI("[replay] %dx%d@%d %dbps audio=%s %uHz ch=%u", cfg->width, cfg->height, cfg->fps,
+         cfg->bitrate, rkav_sample_fmt_name(cfg->audio_sample_fmt), cfg->sample_rate, cfg->channels);
+}
+
+/*
+ * 主线程上的非致命服务：帧统计、控制通道、直播预览、RTP 输出与录像目录（含 WAL 重放）。
+ * 采集线程不依赖这些服务，默认与设备启动并行执行；失败只告警。
+ */
+static void setup_services(AppConfig *cfg)
+{
+    /* 帧统计：初始化失败只告警，不影响录像 */
+    if (cfg->video_enabled && cfg->frame_stats) {
+        if (frame_stats_init(&g_fstats, cfg->fps) == 0)
+            g_fstats_on = 1;
+        else
+            LOGW("[main] frame stats disabled");
+    }
+
+    /* 控制通道：创建失败只告警，已配置的遮挡照常生效 */
+    if (cfg->ctl_path) {
+        if (ctl_init(&g_ctl, cfg->ctl_path) == 0) {
+            g_ctl_on = 1;
+            if (g_mask_on)
+                ctl_register(&g_ctl, "mask", "[set <spec> | add <region> | clear]  隐私遮挡",
+                             mask_ctl, &g_mask);
+            if (g_fstats_on)
+                ctl_register(&g_ctl, "img", "最近一帧的亮度 / 清晰度统计与告警", img_ctl, &g_fstats);
+            if (cfg->video_enabled)
+                ctl_register(&g_ctl, "fps", "[<n> | auto]  采集帧率（固定 / 自动）", fps_ctl, cfg);
+        } else {
+            LOGW("[main] control socket disabled");
+        }
+    }
+
+    /* 直播预览：监听失败只告警，不影响录像 */
+    if (cfg->live_port > 0) {
+        if (live_server_init(&g_live, cfg->live_port, cfg->fps, cfg->width, cfg->height,
+                             (uint64_t)cfg->live_max_lag_ms * 1000u, cfg->svc_layers) == 0)
+            g_live_on = 1;
+        else
+            LOGW("[main] live preview disabled");
+    }
+
+    /* RTP 输出：地址无效 / socket 失败只告警，不影响录像 */
+    if (cfg->rtp_dest) {
+        if (rtp_out_init(&g_rtp, cfg->rtp_dest, cfg->fec, cfg->fec_prot, cfg->svc_layers) == 0)
+            g_rtp_on = 1;
+        else
+            LOGW("[main] rtp output disabled");
+    }
+
+    /* 录像目录：打开失败只告警（不影响录像，保留策略随之失效） */
+    if (cfg->catalog_path) {
+        if (rec_catalog_open(&g_cat, cfg->catalog_path, true) == 0) {
+            g_cat_on = 1;
+            rec_catalog_retain(&g_cat, cfg->retain_sec, (uint64_t)cfg->retain_mb << 20);
+        } else {
+            LOGW("[main] recording catalog disabled");
+        }
+    }
+
+    if (g_live_on && (g_mon_on || g_fstats_on))
+        live_server_set_metrics(&g_live, metrics_format, NULL);
+}
+
 /**
  * @brief 程序入口函数
  * 
@@ -740,19 +2535,26 @@ static void *pcm_sink_thread(void *arg)
  * 1. 配置信号处理（阻塞 SIGINT/SIGTERM 以便用 sigwait 同步处理）
  * 2. 解析命令行参数
  * 3. 初始化统计和队列
- * 4. 创建 8 个工作线程
- * 5. 等待线程结束
- * 6. 清理资源
+ * 4. 启动采集线程与编码器初始化线程，主线程同时完成其余服务（setup_services）
+ * 5. 汇合编码器后创建编码 / 写盘等工作线程
+ * 6. 等待线程结束
+ * 7. 清理资源
  * 
  * 线程列表：
  * - th_sig:       信号处理线程（等待 SIGINT/SIGTERM）
  * - th_timer:     定时器线程（可选，按时长自动停止）
  * - th_stat:      统计输出线程（每秒打印一次）
- * - th_vcap:      视频采集线程（V4L2）
+ * - th_vcap:      视频采集线程（V4L2，每路摄像头一个）
+ * - th_sync:      多摄像头帧同步线程（可选）
+ * - th_enc_boot:  编码器初始化线程（与设备启动并行，汇合后再启动编码 / 写盘线程）
  * - th_venc:      视频编码线程（MPP H.264）
- * - th_acap:      音频采集线程（ALSA）
+ * - th_acap:      音频采集线程（ALSA，每路采集设备一个）
+ * - th_mix:       多麦克风混音线程（可选）
  * - th_h264sink:  H.264 输出线程
  * - th_pcmsink:   PCM 输出线程
+ * - th_live:      直播预览服务线程（可选）
+ * - th_rtp:       RTP 输出线程（可选）
+ * - th_ctl:       运行时控制线程（可选）
  * 
  * @param argc 命令行参数个数
  * @param argv 命令行参数数组
@@ -760,6 +2562,9 @@ static void *pcm_sink_thread(void *arg)
  */
 int main(int argc, char **argv)
 {
+    /* 启动计时的零点：之后各阶段都相对此刻记录 */
+    boot_trace_init();
+
     /* 
      * 信号处理策略：
      * 使用 sigwait() 同步等待信号，而非异步 signal handler。
@@ -772,6 +2577,7 @@ int main(int argc, char **argv)
     pthread_sigmask(SIG_BLOCK, &set, NULL);
 
     /* 加载默认配置并解析命令行参数 */
+    boot_trace_begin(BOOT_CONFIG);
     AppConfig cfg;
     app_config_load_default(&cfg);
     if (app_config_parse_args(&cfg, argc, argv) != 0) {
@@ -781,10 +2587,28 @@ int main(int argc, char **argv)
 
     app_config_print_summary(&cfg);
 
+    /* 回放：轨迹不可用直接退出，不退回真实采集 */
+    if (cfg.replay_path) {
+        if (timing_replay_load(&g_replay, cfg.replay_path) != 0)
+            return -1;
+        replay_apply_config(&cfg, &g_replay.hdr);
+        g_replay_on = 1;
+    }
+    boot_trace_end(BOOT_CONFIG);
+    if (!cfg.video_enabled)
+        boot_trace_set_goal(BOOT_FIRST_AUDIO);
+
+    /*
+     * 主线程初始化分两段：采集线程依赖的状态（统计、队列、同步 / 混音、GOP、时序轨迹）与
+     * 致命检查（遮挡、密钥、存储目标）先完成，之后设备立即启动；其余服务与设备启动并行。
+     */
+    boot_trace_begin(BOOT_SETUP);
+
     /* 初始化全局统计计数器和 PTS delta 变量 */
     av_stats_init(&g_stats);
     atomic_store(&g_video_pts_delta_us, 0);
     atomic_store(&g_audio_pts_delta_us, 0);
+    atomic_store(&g_fps_target, cfg.fps);
 
     /*
      * 初始化三个阻塞队列：
@@ -792,21 +2616,197 @@ int main(int argc, char **argv)
      * - g_h264_q:  编码后 H.264 包队列
      * - g_aud_q:   音频块队列（容量大，容纳更多音频数据）
      */
-    if (bq_init(&g_raw_vq, 8) != 0 ||
-        bq_init(&g_h264_q, 64) != 0 ||
+    /* 低延迟模式：raw 队列只留 2 帧，H264 队列只留 2 帧的 slice，积压即丢（采集侧）或反压 */
+    /* 视频交接（采集 -> 编码 -> 写盘）按 --queue-wait 选等待策略，音频保持睡眠等待以省电 */
+    if (bq_init_wait(&g_raw_vq, cfg.low_latency ? 2 : 8, cfg.video_q_wait) != 0 ||
+        bq_init_wait(&g_h264_q, cfg.low_latency ? (size_t)(2 * cfg.slices) : 64, cfg.video_q_wait) != 0 ||
         bq_init(&g_aud_q, 256) != 0) {
         LOGE("[main] queue init failed");
         return -1;
     }
 
+    /* 多摄像头同步：每路一个小队列，由同步线程对齐后转交 g_raw_vq */
+    if (cfg.sync_device_count > 0) {
+        BQueue *inputs[FRAME_SYNC_MAX_CAMS];
+        g_cam_count = cfg.sync_device_count + 1;
+        for (int i = 0; i < g_cam_count; i++) {
+            if (bq_init(&g_cam_q[i], 8) != 0) {
+                LOGE("[main] cam queue init failed");
+                return -1;
+            }
+            inputs[i] = &g_cam_q[i];
+        }
+        if (frame_sync_init(&g_sync, inputs, g_cam_count,
+                            cfg.sync_tolerance_us, cfg.sync_max_wait_us,
+                            free_video_frame) != 0) {
+            LOGE("[main] frame sync init failed");
+            return -1;
+        }
+    }
+
+    /* 多麦克风混音：每路一个队列，由混音线程对齐混音后推入 g_aud_q */
+    if (cfg.mic_device_count > 0) {
+        int dev_ch[AUDIO_MIX_MAX_DEVS];
+        g_mic_count = cfg.mic_device_count + 1;
+        for (int i = 0; i < g_mic_count; i++) {
+            if (bq_init(&g_mic_q[i], 64) != 0) {
+                LOGE("[main] mic queue init failed");
+                return -1;
+            }
+            dev_ch[i] = (int)cfg.mic_channels;
+        }
+        uint32_t period = cfg.sample_rate * cfg.audio_chunk_ms / 1000u;
+        if (audio_mixer_init(&g_mixer, g_mic_count, dev_ch, (int)cfg.channels,
+                             (int)cfg.sample_rate, cfg.audio_sample_fmt,
+                             period, cfg.mic_map) != 0) {
+            LOGE("[main] audio mixer init failed");
+            return -1;
+        }
+    }
+
+    smart_gop_init(&g_gop, cfg.fps, (int)cfg.idr_interval_sec * cfg.fps);
+    g_gop_smart = cfg.smart_gop && cfg.video_enabled;
+    g_gop.scene_idr = g_gop_smart;     /* 固定 GOP 下运动分析只服务于 --idle-fps */
+
+    /* 隐私遮挡：描述非法直接退出，不能录下本应遮挡的区域；只开控制通道时从空遮挡开始 */
+    if (cfg.video_enabled && (cfg.privacy_mask || cfg.ctl_path)) {
+        if (privacy_mask_init(&g_mask, cfg.width, cfg.height, cfg.privacy_mask) != 0) {
+            LOGE("[main] privacy mask unusable, refusing to record");
+            return -1;
+        }
+        g_mask_on = 1;
+    }
+
+    /* 落盘加密：密钥加载失败直接退出，不能退化为明文录像 */
+    if (cfg.encrypt_key_path) {
+        if (rec_crypt_load_key(&g_crypt_key, cfg.encrypt_key_path) != 0) {
+            LOGE("[main] encryption key unusable, refusing to record in plaintext");
+            return -1;
+        }
+        g_crypt_on = 1;
+    }
+
+    /* 多存储目标：启动时不可用的目标先判为 DOWN，之后按间隔探测恢复 */
+    if (cfg.store_dir_count > 0) {
+        if (storage_init(&g_store, cfg.store_dirs, cfg.store_dir_count, cfg.store_mode,
+                         cfg.store_slow_ms, cfg.store_min_free_mb) != 0) {
+            LOGE("[main] storage targets unusable");
+            return -1;
+        }
+        g_store_on = 1;
+    }
+
+    g_mon_on = cfg.procmon;
+    if (g_mon_on)
+        proc_mon_init(&g_mon);
+
+    /* 时序轨迹：打开失败只告警（采集线程启动前打开，首帧事件也能记录） */
+    if (cfg.trace_path) {
+        TimingTraceHeader info = {
+            .width       = (uint32_t)cfg.width,
+            .height      = (uint32_t)cfg.height,
+            .fps         = (uint32_t)cfg.fps,
+            .bitrate     = (uint32_t)cfg.bitrate,
+            .sample_rate = cfg.sample_rate,
+            .channels    = cfg.channels,
+            .sample_fmt  = (uint32_t)cfg.audio_sample_fmt,
+            .cams        = cfg.video_enabled ? (uint32_t)cfg.sync_device_count + 1 : 0,
+            .mics        = (uint32_t)cfg.mic_device_count + 1,
+        };
+        if (timing_trace_open(&g_trace, cfg.trace_path, &info) == 0)
+            g_trace_on = 1;
+        else
+            LOGW("[main] timing trace disabled");
+    }
+
     /* 准备线程参数 */
     ThreadArgs ta = { .cfg = &cfg };
     TimerArgs  targs = { .sec = cfg.duration_sec };
 
-    /* 8 个工作线程句柄 */
-    pthread_t th_sig, th_timer, th_stat;
-    pthread_t th_vcap, th_venc;
-    pthread_t th_acap, th_h264sink, th_pcmsink;
+    /* 采集线程参数：单摄像头时 cam0 直接推入 g_raw_vq */
+    CaptureArgs cargs[FRAME_SYNC_MAX_CAMS];
+    int ncap = g_cam_count > 0 ? g_cam_count : 1;
+    for (int i = 0; i < ncap; i++) {
+        cargs[i].cfg    = &cfg;
+        cargs[i].cam    = i;
+        cargs[i].device = (i == 0) ? cfg.video_device : cfg.sync_devices[i - 1];
+        cargs[i].out_q  = (g_cam_count > 0) ? &g_cam_q[i] : &g_raw_vq;
+        snprintf(cargs[i].name, sizeof(cargs[i].name), "video_cap%d", i);
+    }
+    if (!cfg.video_enabled) ncap = 0;
+
+    /* 音频采集线程参数：单设备时直接推入 g_aud_q */
+    AudioArgs aargs[AUDIO_MIX_MAX_DEVS];
+    int nacap = g_mic_count > 0 ? g_mic_count : 1;
+    for (int i = 0; i < nacap; i++) {
+        aargs[i].cfg      = &cfg;
+        aargs[i].index    = i;
+        aargs[i].device   = (i == 0) ? cfg.audio_device : cfg.mic_devices[i - 1];
+        aargs[i].channels = (g_mic_count > 0) ? (int)cfg.mic_channels : (int)cfg.channels;
+        aargs[i].out_q    = (g_mic_count > 0) ? &g_mic_q[i] : &g_aud_q;
+        snprintf(aargs[i].name, sizeof(aargs[i].name), "audio_cap%d", i);
+    }
+
+    /* 回放：合成源替代设备采集线程，100ms 后开始重现第一个事件 */
+    void *(*vcap_fn)(void *) = video_capture_thread;
+    void *(*acap_fn)(void *) = audio_capture_thread;
+    if (g_replay_on) {
+        vcap_fn = replay_capture_thread;
+        acap_fn = replay_audio_thread;
+        atomic_store(&g_replay_left, ncap + nacap);
+        g_replay_t0 = rkav_now_monotonic_us() + 100000u;
+    }
+
+    /* 工作线程句柄 */
+    pthread_t th_sig, th_timer, th_stat, th_enc_boot;
+    pthread_t th_vcap[FRAME_SYNC_MAX_CAMS], th_venc, th_sync;
+    pthread_t th_acap[AUDIO_MIX_MAX_DEVS], th_mix, th_h264sink, th_pcmsink;
+    pthread_t th_live, th_rtp, th_ctl;
+
+    /* --boot-serial：其余服务先于设备初始化（设备启动前的串行路径，用于对照） */
+    if (cfg.boot_serial)
+        setup_services(&cfg);
+
+    /*
+     * 设备启动：MPP 编码器（enc_boot 线程）与各路摄像头、麦克风采集线程同时开始初始化，
+     * 采集线程完成 open / S_FMT / REQBUFS / STREAMON 后直接进入取帧循环，
+     * 帧的时间戳仍取自出队时刻，不会在驱动里积压。
+     */
+    int enc_boot_running = 0;
+    if (cfg.video_enabled && !g_replay_on) {
+        if (!cfg.boot_serial &&
+            pthread_create(&th_enc_boot, NULL, encoder_boot_thread, &cfg) == 0)
+            enc_boot_running = 1;
+        else
+            video_encoder_boot(&cfg);   /* 逐个启动，或线程创建失败时就地初始化 */
+    }
+    for (int i = 0; i < ncap; i++) {
+        if (pthread_create(&th_vcap[i], NULL, vcap_fn, &cargs[i]) != 0) {
+            LOGE("[main] pthread_create video_cap%d failed", i);
+            request_stop();
+        } else {
+            mon_add(th_vcap[i], cargs[i].name);
+        }
+    }
+    for (int i = 0; i < nacap; i++) {
+        if (pthread_create(&th_acap[i], NULL, acap_fn, &aargs[i]) != 0) {
+            LOGE("[main] pthread_create audio_cap%d failed", i);
+            request_stop();
+        } else {
+            mon_add(th_acap[i], aargs[i].name);
+        }
+    }
+
+    /* 其余服务与设备启动并行，最后汇合编码器 */
+    if (!cfg.boot_serial)
+        setup_services(&cfg);
+    if (enc_boot_running)
+        pthread_join(th_enc_boot, NULL);
+    boot_trace_end(BOOT_SETUP);
+
+    /* 设备启动失败时已请求停止，此后才启用的服务须补停 */
+    if (should_stop())
+        stop_services();
 
     /* 创建信号处理线程 */
     if (pthread_create(&th_sig, NULL, signal_thread, NULL) != 0) {
@@ -826,47 +2826,138 @@ int main(int argc, char **argv)
     if (pthread_create(&th_stat, NULL, stats_thread, NULL) != 0) {
         LOGE("[main] pthread_create stats failed");
         request_stop();
+    } else {
+        mon_add(th_stat, "stats");
     }
 
-    /* 创建视频采集和编码线程 */
-    if (pthread_create(&th_vcap, NULL, video_capture_thread, &ta) != 0) {
-        LOGE("[main] pthread_create video_cap failed");
-        request_stop();
+    /* 创建帧同步和编码线程（采集线程已在设备启动时创建） */
+    if (g_cam_count > 0) {
+        if (pthread_create(&th_sync, NULL, frame_sync_thread, NULL) != 0) {
+            LOGE("[main] pthread_create frame_sync failed");
+            request_stop();
+        } else {
+            mon_add(th_sync, "frame_sync");
+        }
     }
-    if (pthread_create(&th_venc, NULL, video_encode_thread, &ta) != 0) {
-        LOGE("[main] pthread_create video_enc failed");
-        request_stop();
+    if (cfg.video_enabled) {
+        if (pthread_create(&th_venc, NULL, video_encode_thread, &ta) != 0) {
+            LOGE("[main] pthread_create video_enc failed");
+            request_stop();
+        } else {
+            mon_add(th_venc, "video_enc");
+        }
     }
 
-    /* 创建音频采集线程 */
-    if (pthread_create(&th_acap, NULL, audio_capture_thread, &ta) != 0) {
-        LOGE("[main] pthread_create audio_cap failed");
-        request_stop();
+    /* 创建混音线程 */
+    if (g_mic_count > 0) {
+        if (pthread_create(&th_mix, NULL, audio_mix_thread, NULL) != 0) {
+            LOGE("[main] pthread_create audio_mix failed");
+            request_stop();
+        } else {
+            mon_add(th_mix, "audio_mix");
+        }
     }
 
     /* 创建输出 Sink 线程 */
-    if (pthread_create(&th_h264sink, NULL, h264_sink_thread, &ta) != 0) {
-        LOGE("[main] pthread_create h264_sink failed");
-        request_stop();
+    if (cfg.video_enabled) {
+        if (pthread_create(&th_h264sink, NULL, h264_sink_thread, &ta) != 0) {
+            LOGE("[main] pthread_create h264_sink failed");
+            request_stop();
+        } else {
+            mon_add(th_h264sink, "h264_sink");
+        }
     }
     if (pthread_create(&th_pcmsink, NULL, pcm_sink_thread, &ta) != 0) {
         LOGE("[main] pthread_create pcm_sink failed");
         request_stop();
+    } else {
+        mon_add(th_pcmsink, "pcm_sink");
+    }
+
+    /* 创建直播预览服务线程 */
+    int live_running = 0;
+    if (g_live_on) {
+        if (pthread_create(&th_live, NULL, live_server_thread, NULL) == 0) {
+            live_running = 1;
+            mon_add(th_live, "live_server");
+        } else {
+            /* 编码线程可能已在发布：只停收件箱，资源仍在最后统一释放 */
+            LOGW("[main] pthread_create live_server failed, preview disabled");
+            live_server_stop(&g_live);
+        }
+    }
+
+    /* 创建 RTP 输出线程 */
+    int rtp_running = 0;
+    if (g_rtp_on) {
+        if (pthread_create(&th_rtp, NULL, rtp_out_thread, NULL) == 0) {
+            rtp_running = 1;
+            mon_add(th_rtp, "rtp_out");
+        } else {
+            LOGW("[main] pthread_create rtp_out failed, rtp output disabled");
+            rtp_out_stop(&g_rtp);
+        }
+    }
+
+    /* 创建控制线程 */
+    int ctl_running = 0;
+    if (g_ctl_on) {
+        if (pthread_create(&th_ctl, NULL, ctl_thread, NULL) == 0) {
+            ctl_running = 1;
+            mon_add(th_ctl, "ctl");
+        } else {
+            LOGW("[main] pthread_create ctl failed, control disabled");
+        }
     }
 
     /* 
      * 等待采集和处理线程结束
      * 顺序：先等采集线程，再等编码/输出线程
      */
-    pthread_join(th_vcap, NULL);
-    pthread_join(th_acap, NULL);
-    pthread_join(th_venc, NULL);
-    pthread_join(th_h264sink, NULL);
+    for (int i = 0; i < ncap; i++)
+        pthread_join(th_vcap[i], NULL);
+    if (g_cam_count > 0)
+        pthread_join(th_sync, NULL);
+    for (int i = 0; i < nacap; i++)
+        pthread_join(th_acap[i], NULL);
+    if (g_mic_count > 0)
+        pthread_join(th_mix, NULL);
+    if (cfg.video_enabled) {
+        pthread_join(th_venc, NULL);
+        pthread_join(th_h264sink, NULL);
+    }
     pthread_join(th_pcmsink, NULL);
 
     /* 通知其他线程停止 */
     request_stop();
     pthread_join(th_stat, NULL);
+    if (live_running)
+        pthread_join(th_live, NULL);
+    if (g_live_on)
+        live_server_deinit(&g_live);
+    if (rtp_running)
+        pthread_join(th_rtp, NULL);
+    if (g_rtp_on)
+        rtp_out_deinit(&g_rtp);
+    if (ctl_running)
+        pthread_join(th_ctl, NULL);
+    if (g_ctl_on)
+        ctl_deinit(&g_ctl);
+    if (g_mask_on)
+        privacy_mask_deinit(&g_mask);
+    if (g_fstats_on)
+        frame_stats_deinit(&g_fstats);
+    if (g_mon_on)
+        proc_mon_deinit(&g_mon);
+    if (g_cat_on)
+        rec_catalog_close(&g_cat);
+    if (g_store_on)
+        storage_deinit(&g_store);
+    if (g_trace_on)
+        timing_trace_close(&g_trace);
+    if (g_replay_on)
+        timing_replay_free(&g_replay);
+    boot_trace_report();
 
     /*
      * 信号线程默认阻塞在 sigwait()，这里发送 SIGTERM 唤醒它。
@@ -883,6 +2974,21 @@ int main(int argc, char **argv)
     bq_destroy(&g_raw_vq);
     bq_destroy(&g_h264_q);
     bq_destroy(&g_aud_q);
+    for (int i = 0; i < g_cam_count; i++) {
+        /* 残留帧在队列关闭后由此释放 */
+        void *item = NULL;
+        while (bq_pop_timeout(&g_cam_q[i], &item, 0) == 1)
+            free_video_frame((VideoFrame *)item);
+        bq_destroy(&g_cam_q[i]);
+    }
+    for (int i = 0; i < g_mic_count; i++) {
+        void *item = NULL;
+        while (bq_pop_timeout(&g_mic_q[i], &item, 0) == 1)
+            free_audio_chunk((AudioChunk *)item);
+        bq_destroy(&g_mic_q[i]);
+    }
+    if (g_mic_count > 0)
+        audio_mixer_deinit(&g_mixer);
 
     LOGI("[main] done. video=%s audio=%s", cfg.output_path_h264, cfg.output_path_pcm);
     return 0;
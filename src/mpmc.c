@@ -0,0 +1,397 @@
+/**
+ * @file mpmc.c
+ * @brief 有界无锁 MPMC 队列实现
+ *
+ * 算法（Dmitry Vyukov 的 bounded MPMC queue）：
+ * - 环形数组，每个槽位带一个序号 seq；初始 seq = 下标
+ * - 入队：在 enq_pos 处看到 seq == pos 表示槽位空闲，CAS enq_pos 占位，写入元素后 seq = pos + 1 发布
+ * - 出队：在 deq_pos 处看到 seq == pos + 1 表示有元素，CAS deq_pos 占位，取出后 seq = pos + 容量 归还
+ * 生产者只争 enq_pos、消费者只争 deq_pos，两侧互不干扰；没有锁，持有者被抢占也不会挡住别人。
+ *
+ * 关闭：把 enq_pos 最高位置 1。之后所有入队 CAS 都会看到该位而失败（返回 -1），
+ * 入队游标从此冻结；消费者取到 deq_pos == 冻结的 enq_pos 即说明已排空。
+ * 已占位但尚未发布的元素（关闭前一瞬间的入队）仍会被取到，与 BQueue 的语义一致。
+ *
+ * 阻塞等待（futex，事件字 = 高 32 位等待者数 | 低 32 位序号，futex 只看低 32 位）：
+ * - 等待者原子地登记（等待者数 +1）并取得当前序号，复查队列，确认仍不可用才 FUTEX_WAIT(序号)
+ * - 另一侧完成操作后只在等待者数 > 0 时 CAS“认领”一个等待者（等待者数 -1、序号 +1）并 FUTEX_WAKE 1 个，
+ *   无人等待时不进内核；被唤醒的线程还没来得及运行时，后续操作不会重复唤醒它
+ * - 等待者返回后，仅当序号自登记以来未变（未被认领）才自行注销；序号变过则视为已被认领。
+ *   计数只可能偏大（多一次空唤醒），不会偏小，因此不丢唤醒
+ * 登记与复查之间、发布与检查等待者之间各有一个 seq_cst fence。
+ *
+ * 等待策略（rkav/wait.h）：登记前先自旋，消费者监视 enq_pos、生产者监视 deq_pos（wfe/pause）；
+ * SPIN_PARK 自旋预算用完再走上面的 futex 流程，SPIN 从不进内核。
+ */
+#include "rkav/mpmc.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "mpmc: futex on the low half of the event word assumes little-endian"
+#endif
+
+/** enq_pos 最高位：队列已关闭 */
+#define MPMC_CLOSED  ((size_t)1 << (sizeof(size_t) * 8 - 1))
+
+/** 截止时间：0 = 不等待，UINT64_MAX = 无限等待 */
+#define MPMC_FOREVER UINT64_MAX
+
+/** 事件字：一个等待者 */
+#define EV_WAITER    (1ull << 32)
+#define EV_SEQ(w)    ((uint32_t)(w))
+#define EV_WAITERS(w) ((uint32_t)((w) >> 32))
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t deadline_after(uint64_t timeout_us)
+{
+    return timeout_us == 0 ? 0 : now_ns() + timeout_us * 1000ull;
+}
+
+/* 事件字的 futex 部分（低 32 位） */
+static unsigned *ev_futex(atomic_uint_least64_t *ev)
+{
+    return (unsigned *)ev;
+}
+
+/*
+ * 在序号仍等于 seq 时睡眠，直到被唤醒或截止时间。
+ * @return 0 被唤醒 / 值已变化 / 信号打断；ETIMEDOUT 已到截止时间
+ */
+static int futex_wait_until(atomic_uint_least64_t *ev, uint32_t seq, uint64_t deadline)
+{
+    struct timespec rel, *tp = NULL;
+    if (deadline != MPMC_FOREVER) {
+        uint64_t now = now_ns();
+        if (now >= deadline) return ETIMEDOUT;
+        uint64_t d = deadline - now;
+        rel.tv_sec  = (time_t)(d / 1000000000ull);
+        rel.tv_nsec = (long)(d % 1000000000ull);
+        tp = &rel;
+    }
+    if (syscall(SYS_futex, ev_futex(ev), FUTEX_WAIT_PRIVATE, seq, tp, NULL, 0) != 0 &&
+        errno == ETIMEDOUT)
+        return ETIMEDOUT;
+    return 0;
+}
+
+static void futex_wake(atomic_uint_least64_t *ev, int n)
+{
+    syscall(SYS_futex, ev_futex(ev), FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+/* 登记为等待者；@return 登记时的序号 */
+static uint32_t ev_register(atomic_uint_least64_t *ev)
+{
+    uint64_t w = atomic_fetch_add_explicit(ev, EV_WAITER, memory_order_seq_cst);
+    atomic_thread_fence(memory_order_seq_cst);
+    return EV_SEQ(w);
+}
+
+/* 等待结束：序号未变说明没被认领，自行注销 */
+static void ev_unregister(atomic_uint_least64_t *ev, uint32_t seq)
+{
+    uint64_t w = atomic_load_explicit(ev, memory_order_relaxed);
+    while (EV_SEQ(w) == seq && EV_WAITERS(w) > 0 &&
+           !atomic_compare_exchange_weak_explicit(ev, &w, w - EV_WAITER,
+                                                  memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+
+/* 另一侧有未被认领的等待者时才唤醒（快路径只有一个 fence 和一次读） */
+static void wake_one(atomic_uint_least64_t *ev)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    uint64_t w = atomic_load_explicit(ev, memory_order_relaxed);
+    while (EV_WAITERS(w) > 0) {
+        uint64_t nw = (w - EV_WAITER) & ~0xffffffffull;
+        nw |= (uint32_t)(EV_SEQ(w) + 1u);
+        if (atomic_compare_exchange_weak_explicit(ev, &w, nw,
+                                                  memory_order_release, memory_order_relaxed)) {
+            futex_wake(ev, 1);
+            return;
+        }
+    }
+}
+
+/* 关闭：序号 +1（所有等待者视为已认领）并唤醒全部 */
+static void wake_all(atomic_uint_least64_t *ev)
+{
+    uint64_t w = atomic_load_explicit(ev, memory_order_relaxed);
+    uint64_t nw;
+    do {
+        nw = (w & ~0xffffffffull) | (uint32_t)(EV_SEQ(w) + 1u);
+    } while (!atomic_compare_exchange_weak_explicit(ev, &w, nw,
+                                                    memory_order_release, memory_order_relaxed));
+    futex_wake(ev, INT_MAX);
+}
+
+/* @return 0 成功；1 满；-1 已关闭 */
+static int enqueue(MpmcQueue *q, void *item)
+{
+    size_t pos = atomic_load_explicit(&q->enq_pos, memory_order_relaxed);
+    MpmcCell *c;
+    for (;;) {
+        if (pos & MPMC_CLOSED) return -1;
+        c = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->enq_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return 1;
+        } else {
+            pos = atomic_load_explicit(&q->enq_pos, memory_order_relaxed);
+        }
+    }
+    c->item = item;
+    atomic_store_explicit(&c->seq, pos + 1, memory_order_release);
+    return 0;
+}
+
+/* @return 1 取到；0 当前为空 */
+static int dequeue(MpmcQueue *q, void **out)
+{
+    size_t pos = atomic_load_explicit(&q->deq_pos, memory_order_relaxed);
+    MpmcCell *c;
+    for (;;) {
+        c = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->deq_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&q->deq_pos, memory_order_relaxed);
+        }
+    }
+    *out = c->item;
+    atomic_store_explicit(&c->seq, pos + q->mask + 1, memory_order_release);
+    return 1;
+}
+
+/* 复查：入队会立即成功或失败（不需要睡眠） */
+static int can_push(MpmcQueue *q)
+{
+    size_t pos = atomic_load_explicit(&q->enq_pos, memory_order_relaxed);
+    if (pos & MPMC_CLOSED) return 1;
+    size_t seq = atomic_load_explicit(&q->cells[pos & q->mask].seq, memory_order_acquire);
+    return (intptr_t)seq - (intptr_t)pos >= 0;
+}
+
+/* 复查：出队会立即成功，或队列已关闭 */
+static int can_pop(MpmcQueue *q)
+{
+    if (atomic_load_explicit(&q->enq_pos, memory_order_relaxed) & MPMC_CLOSED) return 1;
+    size_t pos = atomic_load_explicit(&q->deq_pos, memory_order_relaxed);
+    size_t seq = atomic_load_explicit(&q->cells[pos & q->mask].seq, memory_order_acquire);
+    return (intptr_t)seq - (intptr_t)(pos + 1) >= 0;
+}
+
+/*
+ * 登记前的自旋阶段。
+ * @return 1 可能已就绪；0 自旋预算或截止时间已到
+ */
+static int mpmc_spin(MpmcQueue *q, int pop, uint64_t deadline)
+{
+    uint64_t end = q->wait == RKAV_WAIT_SPIN_PARK ? now_ns() + RKAV_SPIN_NS : MPMC_FOREVER;
+    if (deadline < end) end = deadline;
+
+    /* 对端游标每次操作都会前进，监视它即可 */
+    atomic_size_t *watch = pop ? &q->enq_pos : &q->deq_pos;
+    for (unsigned i = 1;; i++) {
+        size_t v = atomic_load_explicit(watch, memory_order_relaxed);
+        if (pop ? can_pop(q) : can_push(q)) return 1;
+        rkav_spin_wait((const size_t *)watch, v);
+        if ((i & 15) == 0 && end != MPMC_FOREVER && now_ns() >= end) return 0;
+        if (q->wait == RKAV_WAIT_SPIN && i % RKAV_SPIN_YIELD_EVERY == 0) sched_yield();
+    }
+}
+
+static int do_push(MpmcQueue *q, void *item, uint64_t deadline)
+{
+    for (;;) {
+        int r = enqueue(q, item);
+        if (r == 0) {
+            wake_one(&q->not_empty);
+            return 0;
+        }
+        if (r < 0 || deadline == 0) return r;
+        if (q->wait != RKAV_WAIT_PARK) {
+            if (mpmc_spin(q, 0, deadline)) continue;
+            if (q->wait == RKAV_WAIT_SPIN) { deadline = 0; continue; }
+        }
+
+        uint32_t seq = ev_register(&q->not_full);
+        int to = can_push(q) ? 0 : futex_wait_until(&q->not_full, seq, deadline);
+        ev_unregister(&q->not_full, seq);
+        if (to == ETIMEDOUT) deadline = 0;   /* 最后再试一次 */
+    }
+}
+
+static int do_pop(MpmcQueue *q, void **out, uint64_t deadline)
+{
+    for (;;) {
+        if (dequeue(q, out)) {
+            wake_one(&q->not_full);
+            return 1;
+        }
+
+        size_t end = atomic_load_explicit(&q->enq_pos, memory_order_acquire);
+        if (end & MPMC_CLOSED) {
+            if (atomic_load_explicit(&q->deq_pos, memory_order_acquire) >= (end & ~MPMC_CLOSED))
+                return 0;
+            /* 关闭前已占位、尚未发布的元素：马上可见 */
+            if (deadline == 0) return 2;
+            sched_yield();
+            continue;
+        }
+        if (deadline == 0) return 2;
+        if (q->wait != RKAV_WAIT_PARK) {
+            if (mpmc_spin(q, 1, deadline)) continue;
+            if (q->wait == RKAV_WAIT_SPIN) { deadline = 0; continue; }
+        }
+
+        uint32_t seq = ev_register(&q->not_empty);
+        int to = can_pop(q) ? 0 : futex_wait_until(&q->not_empty, seq, deadline);
+        ev_unregister(&q->not_empty, seq);
+        if (to == ETIMEDOUT) deadline = 0;
+    }
+}
+
+/**
+ * @brief 初始化队列（PARK 策略）
+ */
+int mpmc_init(MpmcQueue *q, size_t capacity)
+{
+    return mpmc_init_wait(q, capacity, RKAV_WAIT_PARK);
+}
+
+/**
+ * @brief 初始化队列并指定等待策略
+ *
+ * @param q        队列指针
+ * @param capacity 容量，向上取 2 的幂（至少 2）
+ * @param wait     等待策略
+ * @return int     0 成功，-1 失败
+ */
+int mpmc_init_wait(MpmcQueue *q, size_t capacity, RkavWait wait)
+{
+    if (!q || capacity == 0 || capacity > (MPMC_CLOSED >> 1))
+        return -1;
+
+    memset(q, 0, sizeof(*q));
+
+    size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+
+    q->cells = (MpmcCell *)calloc(cap, sizeof(MpmcCell));
+    if (!q->cells)
+        return -1;
+    for (size_t i = 0; i < cap; i++)
+        atomic_init(&q->cells[i].seq, i);
+
+    q->mask = cap - 1;
+    q->wait = wait;
+    atomic_init(&q->enq_pos, 0);
+    atomic_init(&q->deq_pos, 0);
+    atomic_init(&q->not_empty, 0);
+    atomic_init(&q->not_full, 0);
+    return 0;
+}
+
+/**
+ * @brief 关闭队列
+ *
+ * 之后 push 立即返回 -1；pop 取完剩余元素后返回 0。唤醒所有等待线程。
+ */
+void mpmc_close(MpmcQueue *q)
+{
+    if (!q || !q->cells) return;
+
+    atomic_fetch_or_explicit(&q->enq_pos, MPMC_CLOSED, memory_order_seq_cst);
+    wake_all(&q->not_empty);
+    wake_all(&q->not_full);
+}
+
+/**
+ * @brief 销毁队列
+ *
+ * 不会 free 残留元素；调用前所有线程须已退出，调用者应先 drain。
+ */
+void mpmc_destroy(MpmcQueue *q)
+{
+    if (!q) return;
+    free(q->cells);
+    memset(q, 0, sizeof(*q));
+}
+
+int mpmc_push(MpmcQueue *q, void *item)
+{
+    if (!q || !q->cells) return -1;
+    return do_push(q, item, MPMC_FOREVER);
+}
+
+int mpmc_try_push(MpmcQueue *q, void *item)
+{
+    if (!q || !q->cells) return -1;
+    return do_push(q, item, 0);
+}
+
+int mpmc_push_timeout(MpmcQueue *q, void *item, uint64_t timeout_us)
+{
+    if (!q || !q->cells) return -1;
+    return do_push(q, item, deadline_after(timeout_us));
+}
+
+int mpmc_pop(MpmcQueue *q, void **out)
+{
+    if (!q || !q->cells || !out) return -1;
+    return do_pop(q, out, MPMC_FOREVER);
+}
+
+int mpmc_try_pop(MpmcQueue *q, void **out)
+{
+    if (!q || !q->cells || !out) return -1;
+    return do_pop(q, out, 0);
+}
+
+int mpmc_pop_timeout(MpmcQueue *q, void **out, uint64_t timeout_us)
+{
+    if (!q || !q->cells || !out) return -1;
+    return do_pop(q, out, deadline_after(timeout_us));
+}
+
+size_t mpmc_size(MpmcQueue *q)
+{
+    if (!q || !q->cells) return 0;
+    size_t d = atomic_load_explicit(&q->deq_pos, memory_order_relaxed);
+    size_t e = atomic_load_explicit(&q->enq_pos, memory_order_relaxed) & ~MPMC_CLOSED;
+    if (e <= d) return 0;
+    return e - d > q->mask + 1 ? q->mask + 1 : e - d;
+}
+
+size_t mpmc_capacity(MpmcQueue *q)
+{
+    if (!q || !q->cells) return 0;
+    return q->mask + 1;
+}
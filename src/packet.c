@@ -0,0 +1,33 @@
+/**
+ * @file packet.c
+ * @brief 编码包引用计数实现
+ *
+ * 编码线程产出的一个包会同时交给写盘线程和直播服务（多个客户端），
+ * 各方只持有引用而不拷贝数据，最后一个 unref 的线程负责释放。
+ */
+#include "rkav/packet.h"
+
+#include <stdlib.h>
+
+EncodedPacket *encoded_packet_alloc(void)
+{
+    EncodedPacket *p = (EncodedPacket *)calloc(1, sizeof(EncodedPacket));
+    if (p) atomic_init(&p->refs, 1);
+    return p;
+}
+
+EncodedPacket *encoded_packet_ref(EncodedPacket *p)
+{
+    if (p) atomic_fetch_add_explicit(&p->refs, 1, memory_order_relaxed);
+    return p;
+}
+
+void encoded_packet_unref(EncodedPacket *p)
+{
+    if (!p) return;
+    /* acq_rel：保证其他持有者对包的读取都发生在释放之前 */
+    if (atomic_fetch_sub_explicit(&p->refs, 1, memory_order_acq_rel) != 1)
+        return;
+    free(p->data);
+    free(p);
+}
@@ -0,0 +1,622 @@
+/**
+ * @file privacy_mask.c
+ * @brief NV12 隐私遮挡模块实现
+ *
+ * 编译：描述 -> 区域（样式 + 包围盒）-> 亮度行区间 + 色度行区间（按行有序）
+ * 施加：
+ * - 填充：每个区间一次批量写（Y 单字节、UV 双字节图样）
+ * - 马赛克：按块行处理，先求出该块行内各块的 Y / U / V 均值并展开成一行图样（各块均值重复块宽次），
+ *   块行内每个区间只需从图样拷贝一段，不必按块切段
+ * 各内核都是“向量主循环 + 标量尾部”。
+ */
+#include "privacy_mask.h"
+#include "log.h"
+
+#include "rkav/time.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#  include <arm_neon.h>
+#  define PM_NEON 1
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#  define PM_SSE2 1
+#endif
+
+/** 模块日志标签 */
+#define TAG "mask"
+
+/** 默认马赛克块大小 */
+#define PM_DEFAULT_BLOCK  16
+
+/** 一行亮度区间（poly 奇偶规则下每行最多 PM_MAX_VERTS / 2 段） */
+typedef struct {
+    uint16_t y;     /**< 行号（色度区间为色度行） */
+    uint16_t x0;    /**< 起点（色度区间为 UV 对序号） */
+    uint16_t x1;    /**< 终点（不含） */
+} PmSpan;
+
+typedef enum {
+    PM_STYLE_FILL = 0,
+    PM_STYLE_PIX,
+} PmStyle;
+
+typedef struct {
+    PmStyle  style;
+    uint8_t  fy, fu, fv;        /**< 填充值 */
+    int      block;             /**< 马赛克块大小 */
+    int      bx0, by0, bx1, by1;/**< 亮度包围盒（已裁剪，右下不含） */
+    uint32_t span_off, span_cnt;
+    uint32_t cspan_off, cspan_cnt;
+} PmRegion;
+
+struct PmPlan {
+    int       n;
+    PmRegion  reg[PM_MAX_MASKS];
+    PmSpan   *spans;            /**< 各区域亮度区间依次排列 */
+    uint32_t  nspans, cap_spans;
+    PmSpan   *cspans;           /**< 各区域色度区间依次排列 */
+    uint32_t  ncspans, cap_cspans;
+    uint8_t  *line;             /**< 马赛克块行图样暂存：Y 与 UV 各 max_line 字节 */
+    int       max_line;
+    uint64_t  pixels;           /**< 遮挡的亮度像素数 */
+};
+
+/* ============================================================================
+ * 向量内核
+ * ============================================================================ */
+
+static void pm_fill_u8(uint8_t *d, uint8_t v, size_t n)
+{
+#if PM_NEON
+    uint8x16_t vv = vdupq_n_u8(v);
+    for (; n >= 32; n -= 32, d += 32) {
+        vst1q_u8(d, vv);
+        vst1q_u8(d + 16, vv);
+    }
+    for (; n >= 16; n -= 16, d += 16) vst1q_u8(d, vv);
+#elif PM_SSE2
+    __m128i vv = _mm_set1_epi8((char)v);
+    for (; n >= 32; n -= 32, d += 32) {
+        _mm_storeu_si128((__m128i *)d, vv);
+        _mm_storeu_si128((__m128i *)(d + 16), vv);
+    }
+    for (; n >= 16; n -= 16, d += 16) _mm_storeu_si128((__m128i *)d, vv);
+#endif
+    while (n--) *d++ = v;
+}
+
+/* 写 pairs 个 (u, v) 对 */
+static void pm_fill_uv(uint8_t *d, uint8_t u, uint8_t v, size_t pairs)
+{
+#if PM_NEON
+    uint8x16_t vv = vreinterpretq_u8_u16(vdupq_n_u16((uint16_t)(u | v << 8)));
+    for (; pairs >= 8; pairs -= 8, d += 16) vst1q_u8(d, vv);
+#elif PM_SSE2
+    __m128i vv = _mm_set1_epi16((short)(u | v << 8));
+    for (; pairs >= 8; pairs -= 8, d += 16) _mm_storeu_si128((__m128i *)d, vv);
+#endif
+    for (; pairs; pairs--, d += 2) {
+        d[0] = u;
+        d[1] = v;
+    }
+}
+
+/* 一个 bw×bh 亮度块的像素和：累加器跨行保留在寄存器中，每块只做一次水平归约 */
+static uint32_t pm_block_sum_y(const uint8_t *s, size_t stride, int bw, int bh)
+{
+    uint32_t sum = 0;
+    int vw = bw & ~15;
+#if PM_NEON
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (int r = 0; r < bh; r++)
+        for (int i = 0; i < vw; i += 16)
+            acc = vpadalq_u16(acc, vpaddlq_u8(vld1q_u8(s + r * stride + i)));
+    sum = vaddvq_u32(acc);
+#elif PM_SSE2
+    __m128i acc = _mm_setzero_si128(), zero = _mm_setzero_si128();
+    for (int r = 0; r < bh; r++)
+        for (int i = 0; i < vw; i += 16)
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(s + r * stride + i)), zero));
+    sum = (uint32_t)_mm_cvtsi128_si32(acc) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+#else
+    vw = 0;
+#endif
+    for (int r = 0; r < bh; r++)
+        for (int i = vw; i < bw; i++) sum += s[r * stride + i];
+    return sum;
+}
+
+/* 一个 pairs×rows 色度块中 U 与 V 的和 */
+static void pm_block_sum_uv(const uint8_t *s, size_t stride, int pairs, int rows,
+                            uint32_t *su, uint32_t *sv)
+{
+    uint32_t u = 0, v = 0;
+#if PM_NEON
+    int vp = pairs & ~15;
+    uint32x4_t au = vdupq_n_u32(0), av = vdupq_n_u32(0);
+    for (int r = 0; r < rows; r++) {
+        for (int i = 0; i < vp; i += 16) {
+            uint8x16x2_t x = vld2q_u8(s + r * stride + 2 * i);
+            au = vpadalq_u16(au, vpaddlq_u8(x.val[0]));
+            av = vpadalq_u16(av, vpaddlq_u8(x.val[1]));
+        }
+    }
+    u = vaddvq_u32(au);
+    v = vaddvq_u32(av);
+#elif PM_SSE2
+    int vp = pairs & ~7;
+    __m128i au = _mm_setzero_si128(), av = _mm_setzero_si128(), zero = _mm_setzero_si128();
+    __m128i lo = _mm_set1_epi16(0x00ff);
+    for (int r = 0; r < rows; r++) {
+        for (int i = 0; i < vp; i += 8) {
+            __m128i x = _mm_loadu_si128((const __m128i *)(s + r * stride + 2 * i));
+            au = _mm_add_epi64(au, _mm_sad_epu8(_mm_and_si128(x, lo), zero));
+            av = _mm_add_epi64(av, _mm_sad_epu8(_mm_srli_epi16(x, 8), zero));
+        }
+    }
+    u = (uint32_t)_mm_cvtsi128_si32(au) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(au, 8));
+    v = (uint32_t)_mm_cvtsi128_si32(av) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(av, 8));
+#else
+    int vp = 0;
+#endif
+    for (int r = 0; r < rows; r++) {
+        for (int i = vp; i < pairs; i++) {
+            u += s[r * stride + 2 * i];
+            v += s[r * stride + 2 * i + 1];
+        }
+    }
+    *su = u;
+    *sv = v;
+}
+
+/* ============================================================================
+ * 编译
+ * ============================================================================ */
+
+static void pm_plan_free(PmPlan *p)
+{
+    if (!p) return;
+    free(p->spans);
+    free(p->cspans);
+    free(p->line);
+    free(p);
+}
+
+static int pm_push(PmSpan **arr, uint32_t *n, uint32_t *cap, int y, int x0, int x1)
+{
+    if (*n == *cap) {
+        uint32_t nc = *cap ? *cap * 2 : 256;
+        PmSpan *na = (PmSpan *)realloc(*arr, nc * sizeof(PmSpan));
+        if (!na) return -1;
+        *arr = na;
+        *cap = nc;
+    }
+    (*arr)[(*n)++] = (PmSpan){ (uint16_t)y, (uint16_t)x0, (uint16_t)x1 };
+    return 0;
+}
+
+static int cmp_span_x(const void *a, const void *b)
+{
+    const PmSpan *x = (const PmSpan *)a, *y = (const PmSpan *)b;
+    return (int)x->x0 - (int)y->x0;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* 一个已解析、未编译的区域 */
+typedef struct {
+    bool poly;
+    int  nv;
+    int  pt[PM_MAX_VERTS][2];   /* rect: pt[0] = (x, y), pt[1] = (w, h) */
+    PmStyle style;
+    uint8_t fy, fu, fv;
+    int  block;
+} PmShape;
+
+static int pm_parse_style(const char *s, PmShape *sh)
+{
+    sh->style = PM_STYLE_FILL;
+    sh->fy = 16;
+    sh->fu = sh->fv = 128;
+    sh->block = PM_DEFAULT_BLOCK;
+    if (!s || strcmp(s, "black") == 0) return 0;
+    if (strcmp(s, "gray") == 0) {
+        sh->fy = 128;
+        return 0;
+    }
+    if (strncmp(s, "pix", 3) == 0) {
+        sh->style = PM_STYLE_PIX;
+        if (s[3] == '\0') return 0;
+        char *end = NULL;
+        long n = strtol(s + 3, &end, 10);
+        if (*end != '\0' || n < 4 || n > 128 || (n & 1)) return -1;
+        sh->block = (int)n;
+        return 0;
+    }
+    return -1;
+}
+
+/* 解析一个区域：rect:X,Y,W,H[@样式] / poly:X1,Y1,...[@样式]（entry 会被修改） */
+static int pm_parse_entry(char *entry, PmShape *sh, char *err, size_t errlen, int idx)
+{
+    memset(sh, 0, sizeof(*sh));
+    char *at = strchr(entry, '@');
+    if (at) *at++ = '\0';
+    if (pm_parse_style(at, sh) != 0) {
+        snprintf(err, errlen, "region %d: bad style '%s' (black|gray|pix<4-128 even>)", idx, at);
+        return -1;
+    }
+
+    char *body;
+    if (strncmp(entry, "rect:", 5) == 0)      { sh->poly = false; body = entry + 5; }
+    else if (strncmp(entry, "poly:", 5) == 0) { sh->poly = true;  body = entry + 5; }
+    else {
+        snprintf(err, errlen, "region %d: expected rect: or poly:", idx);
+        return -1;
+    }
+
+    int vals[PM_MAX_VERTS * 2], nv = 0;
+    char *p = body;
+    while (*p) {
+        char *end = NULL;
+        long v = strtol(p, &end, 10);
+        if (end == p || v < 0 || v > 65535 || nv >= PM_MAX_VERTS * 2) {
+            snprintf(err, errlen, "region %d: bad coordinates", idx);
+            return -1;
+        }
+        vals[nv++] = (int)v;
+        p = end;
+        if (*p == ',') p++;
+        else if (*p) {
+            snprintf(err, errlen, "region %d: bad coordinates", idx);
+            return -1;
+        }
+    }
+
+    if (!sh->poly) {
+        if (nv != 4 || vals[2] == 0 || vals[3] == 0) {
+            snprintf(err, errlen, "region %d: rect needs X,Y,W,H with W,H > 0", idx);
+            return -1;
+        }
+        sh->pt[0][0] = vals[0]; sh->pt[0][1] = vals[1];
+        sh->pt[1][0] = vals[2]; sh->pt[1][1] = vals[3];
+        return 0;
+    }
+    if (nv < 6 || (nv & 1)) {
+        snprintf(err, errlen, "region %d: poly needs 3-%d X,Y vertices", idx, PM_MAX_VERTS);
+        return -1;
+    }
+    sh->nv = nv / 2;
+    for (int i = 0; i < sh->nv; i++) {
+        sh->pt[i][0] = vals[2 * i];
+        sh->pt[i][1] = vals[2 * i + 1];
+    }
+    return 0;
+}
+
+/* 生成一个区域的亮度区间（行有序），返回 0 成功，1 完全在画面外，-1 内存不足 */
+static int pm_raster(PmPlan *p, PmRegion *r, const PmShape *sh, int w, int h)
+{
+    r->span_off = p->nspans;
+    if (!sh->poly) {
+        int x0 = sh->pt[0][0], y0 = sh->pt[0][1];
+        int x1 = x0 + sh->pt[1][0], y1 = y0 + sh->pt[1][1];
+        if (x1 > w) x1 = w;
+        if (y1 > h) y1 = h;
+        for (int y = y0; y < y1 && x0 < x1; y++)
+            if (pm_push(&p->spans, &p->nspans, &p->cap_spans, y, x0, x1) != 0) return -1;
+    } else {
+        int ymin = 65535, ymax = 0;
+        for (int i = 0; i < sh->nv; i++) {
+            if (sh->pt[i][1] < ymin) ymin = sh->pt[i][1];
+            if (sh->pt[i][1] > ymax) ymax = sh->pt[i][1];
+        }
+        if (ymax > h) ymax = h;
+        /* 扫描线取像素中心 y + 0.5；区间为中心落在 [xa, xb) 内的像素 */
+        for (int y = ymin; y < ymax; y++) {
+            double yc = y + 0.5, xs[PM_MAX_VERTS];
+            int nx = 0;
+            for (int i = 0, j = sh->nv - 1; i < sh->nv; j = i++) {
+                double yi = sh->pt[i][1], yj = sh->pt[j][1];
+                if ((yi <= yc) == (yj <= yc)) continue;
+                double xi = sh->pt[i][0], xj = sh->pt[j][0];
+                xs[nx++] = xi + (yc - yi) * (xj - xi) / (yj - yi);
+            }
+            qsort(xs, (size_t)nx, sizeof(double), cmp_double);
+            for (int k = 0; k + 1 < nx; k += 2) {
+                int xa = (int)ceil(xs[k] - 0.5), xb = (int)ceil(xs[k + 1] - 0.5);
+                if (xb > w) xb = w;
+                if (xa < xb && pm_push(&p->spans, &p->nspans, &p->cap_spans, y, xa, xb) != 0)
+                    return -1;
+            }
+        }
+    }
+    r->span_cnt = p->nspans - r->span_off;
+    if (r->span_cnt == 0) return 1;
+
+    /* 包围盒 */
+    const PmSpan *s = p->spans + r->span_off;
+    r->bx0 = w; r->bx1 = 0;
+    r->by0 = s[0].y;
+    r->by1 = s[r->span_cnt - 1].y + 1;
+    for (uint32_t i = 0; i < r->span_cnt; i++) {
+        if (s[i].x0 < r->bx0) r->bx0 = s[i].x0;
+        if (s[i].x1 > r->bx1) r->bx1 = s[i].x1;
+        p->pixels += (uint64_t)(s[i].x1 - s[i].x0);
+    }
+
+    /* 色度区间：上下两行亮度区间的并集，换算到 UV 对后向外取整 */
+    r->cspan_off = p->ncspans;
+    uint32_t cur = 0;
+    for (int cy = r->by0 / 2; cy <= (r->by1 - 1) / 2; cy++) {
+        PmSpan tmp[PM_MAX_VERTS];
+        int nt = 0;
+        while (cur < r->span_cnt && s[cur].y < 2 * cy) cur++;
+        for (uint32_t k = cur; k < r->span_cnt && s[k].y <= 2 * cy + 1 && nt < PM_MAX_VERTS; k++) {
+            tmp[nt] = s[k];
+            tmp[nt].x0 = (uint16_t)(s[k].x0 / 2);
+            tmp[nt].x1 = (uint16_t)((s[k].x1 + 1) / 2);
+            nt++;
+        }
+        if (nt == 0) continue;
+        qsort(tmp, (size_t)nt, sizeof(PmSpan), cmp_span_x);
+        int a = tmp[0].x0, b = tmp[0].x1;
+        for (int k = 1; k <= nt; k++) {
+            if (k < nt && tmp[k].x0 <= b) {
+                if (tmp[k].x1 > b) b = tmp[k].x1;
+                continue;
+            }
+            if (pm_push(&p->cspans, &p->ncspans, &p->cap_cspans, cy, a, b) != 0) return -1;
+            if (k < nt) {
+                a = tmp[k].x0;
+                b = tmp[k].x1;
+            }
+        }
+    }
+    r->cspan_cnt = p->ncspans - r->cspan_off;
+    return 0;
+}
+
+static PmPlan *pm_compile(const char *spec, int w, int h, char *err, size_t errlen)
+{
+    PmPlan *p = (PmPlan *)calloc(1, sizeof(PmPlan));
+    if (!p) {
+        snprintf(err, errlen, "out of memory");
+        return NULL;
+    }
+    if (!spec) spec = "";
+    if (strlen(spec) >= PM_SPEC_MAX) {
+        snprintf(err, errlen, "spec too long (max %d)", PM_SPEC_MAX - 1);
+        pm_plan_free(p);
+        return NULL;
+    }
+
+    char buf[PM_SPEC_MAX];
+    snprintf(buf, sizeof(buf), "%s", spec);
+    char *save = NULL;
+    int idx = 0;
+    for (char *tok = strtok_r(buf, ";", &save); tok; tok = strtok_r(NULL, ";", &save)) {
+        while (*tok == ' ') tok++;
+        if (*tok == '\0') continue;
+        idx++;
+        if (p->n >= PM_MAX_MASKS) {
+            snprintf(err, errlen, "too many regions (max %d)", PM_MAX_MASKS);
+            pm_plan_free(p);
+            return NULL;
+        }
+        PmShape sh;
+        if (pm_parse_entry(tok, &sh, err, errlen, idx) != 0) {
+            pm_plan_free(p);
+            return NULL;
+        }
+        PmRegion *r = &p->reg[p->n];
+        r->style = sh.style;
+        r->fy = sh.fy; r->fu = sh.fu; r->fv = sh.fv;
+        r->block = sh.block;
+        int rr = pm_raster(p, r, &sh, w, h);
+        if (rr < 0) {
+            snprintf(err, errlen, "out of memory");
+            pm_plan_free(p);
+            return NULL;
+        }
+        if (rr > 0) {
+            snprintf(err, errlen, "region %d: outside %dx%d frame", idx, w, h);
+            pm_plan_free(p);
+            return NULL;
+        }
+        if (r->style == PM_STYLE_PIX) {
+            int nb = (r->bx1 + r->block - 1) / r->block - r->bx0 / r->block;
+            if (nb * r->block > p->max_line) p->max_line = nb * r->block;
+        }
+        p->n++;
+    }
+
+    if (p->max_line > 0) {
+        p->line = (uint8_t *)malloc((size_t)p->max_line * 2);
+        if (!p->line) {
+            snprintf(err, errlen, "out of memory");
+            pm_plan_free(p);
+            return NULL;
+        }
+    }
+    return p;
+}
+
+/* ============================================================================
+ * 施加
+ * ============================================================================ */
+
+static void pm_apply_fill(const PmPlan *p, const PmRegion *r, uint8_t *y, uint8_t *uv, size_t stride)
+{
+    const PmSpan *s = p->spans + r->span_off;
+    for (uint32_t i = 0; i < r->span_cnt; i++)
+        pm_fill_u8(y + s[i].y * stride + s[i].x0, r->fy, (size_t)(s[i].x1 - s[i].x0));
+    const PmSpan *c = p->cspans + r->cspan_off;
+    for (uint32_t i = 0; i < r->cspan_cnt; i++)
+        pm_fill_uv(uv + c[i].y * stride + 2u * c[i].x0, r->fu, r->fv, (size_t)(c[i].x1 - c[i].x0));
+}
+
+static void pm_apply_pix(PmPlan *p, const PmRegion *r, uint8_t *y, uint8_t *uv, size_t stride,
+                         int w, int h)
+{
+    int bs = r->block;
+    int c0 = r->bx0 / bs, c1 = (r->bx1 + bs - 1) / bs;
+    int lx = c0 * bs;                       /* 图样起点（亮度列 / UV 字节偏移相同） */
+    uint8_t *ly = p->line, *luv = p->line + p->max_line;
+
+    const PmSpan *ls = p->spans + r->span_off, *le = ls + r->span_cnt;
+    const PmSpan *cs = p->cspans + r->cspan_off, *ce = cs + r->cspan_cnt;
+
+    for (int ry = r->by0 / bs * bs; ry < r->by1; ry += bs) {
+        int bh = ry + bs <= h ? bs : h - ry;
+
+        /* 先求整行块的均值并展开成图样（回写会覆盖源像素） */
+        for (int k = 0; k < c1 - c0; k++) {
+            int x = (c0 + k) * bs;
+            int bw = x + bs <= w ? bs : w - x;
+            uint32_t su, sv;
+            uint32_t sy = pm_block_sum_y(y + (size_t)ry * stride + x, stride, bw, bh);
+            pm_block_sum_uv(uv + (size_t)(ry / 2) * stride + x, stride, bw / 2, bh / 2, &su, &sv);
+            uint32_t n = (uint32_t)(bw * bh), cn = (uint32_t)((bw / 2) * (bh / 2));
+            pm_fill_u8(ly + x - lx, (uint8_t)((sy + n / 2) / n), (size_t)bw);
+            pm_fill_uv(luv + x - lx, cn ? (uint8_t)((su + cn / 2) / cn) : 128,
+                       cn ? (uint8_t)((sv + cn / 2) / cn) : 128, (size_t)(bw / 2));
+        }
+
+        for (; ls < le && ls->y < ry + bh; ls++)
+            memcpy(y + ls->y * stride + ls->x0, ly + ls->x0 - lx, (size_t)(ls->x1 - ls->x0));
+        for (; cs < ce && cs->y < (ry + bh) / 2; cs++)
+            memcpy(uv + cs->y * stride + 2u * cs->x0, luv + 2 * cs->x0 - lx,
+                   2u * (size_t)(cs->x1 - cs->x0));
+    }
+}
+
+/* ============================================================================
+ * 接口
+ * ============================================================================ */
+
+int privacy_mask_init(PrivacyMask *pm, int w, int h, const char *spec)
+{
+    if (!pm) return -1;
+    memset(pm, 0, sizeof(*pm));
+    if (w <= 0 || h <= 0 || (w & 1) || (h & 1) || w > 65535 || h > 65535) {
+        LOGE("[%s] unsupported frame size %dx%d (NV12 needs even size)", TAG, w, h);
+        return -1;
+    }
+    pm->w = w;
+    pm->h = h;
+    pthread_mutex_init(&pm->mtx, NULL);
+    atomic_init(&pm->pending, NULL);
+
+    char err[128];
+    if (privacy_mask_set(pm, spec ? spec : "", err, sizeof(err)) != 0) {
+        LOGE("[%s] invalid mask: %s", TAG, err);
+        pthread_mutex_destroy(&pm->mtx);
+        return -1;
+    }
+    return 0;
+}
+
+void privacy_mask_deinit(PrivacyMask *pm)
+{
+    if (!pm) return;
+    pm_plan_free(atomic_exchange(&pm->pending, NULL));
+    pm_plan_free(pm->active);
+    pm->active = NULL;
+    pthread_mutex_destroy(&pm->mtx);
+}
+
+int privacy_mask_set(PrivacyMask *pm, const char *spec, char *err, size_t errlen)
+{
+    char dummy[8];
+    if (!err) {
+        err = dummy;
+        errlen = sizeof(dummy);
+    }
+    if (!pm) return -1;
+
+    PmPlan *p = pm_compile(spec, pm->w, pm->h, err, errlen);
+    if (!p) return -1;
+
+    pthread_mutex_lock(&pm->mtx);
+    snprintf(pm->spec, sizeof(pm->spec), "%s", spec ? spec : "");
+    pthread_mutex_unlock(&pm->mtx);
+
+    /* 编码线程尚未取走的上一份直接作废 */
+    pm_plan_free(atomic_exchange(&pm->pending, p));
+    LOGI("[%s] %d region(s), %.1f%% of frame: %s", TAG, p->n,
+         (double)p->pixels * 100.0 / ((double)pm->w * (double)pm->h),
+         p->n ? spec : "(none)");
+    return 0;
+}
+
+size_t privacy_mask_get(PrivacyMask *pm, char *buf, size_t cap)
+{
+    if (!pm || !buf || cap == 0) return 0;
+    pthread_mutex_lock(&pm->mtx);
+    int n = snprintf(buf, cap, "%s", pm->spec);
+    pthread_mutex_unlock(&pm->mtx);
+    return n < 0 ? 0 : ((size_t)n < cap ? (size_t)n : cap - 1);
+}
+
+void privacy_mask_apply(PrivacyMask *pm, VideoFrame *vf)
+{
+    if (!pm || !vf || !vf->data) return;
+
+    PmPlan *np = atomic_exchange(&pm->pending, NULL);
+    if (np) {
+        pm_plan_free(pm->active);
+        pm->active = np;
+        atomic_store(&pm->stat_masks, np->n);
+        atomic_store(&pm->stat_pixels, np->pixels);
+    }
+    PmPlan *p = pm->active;
+    if (!p || p->n == 0) return;
+
+    size_t stride = (size_t)vf->stride;
+    if (vf->w != pm->w || vf->h != pm->h || vf->size < stride * (size_t)vf->h * 3 / 2) {
+        atomic_fetch_add_explicit(&pm->stat_skipped, 1, memory_order_relaxed);
+        return;
+    }
+
+    uint64_t t0 = rkav_now_monotonic_ns();
+    uint8_t *y = vf->data, *uv = vf->data + stride * (size_t)vf->h;
+    for (int i = 0; i < p->n; i++) {
+        const PmRegion *r = &p->reg[i];
+        if (r->style == PM_STYLE_PIX)
+            pm_apply_pix(p, r, y, uv, stride, vf->w, vf->h);
+        else
+            pm_apply_fill(p, r, y, uv, stride);
+    }
+    uint64_t ns = rkav_now_monotonic_ns() - t0;
+
+    atomic_fetch_add_explicit(&pm->stat_frames, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&pm->stat_ns, ns, memory_order_relaxed);
+    if (ns > atomic_load_explicit(&pm->stat_max_ns, memory_order_relaxed))
+        atomic_store_explicit(&pm->stat_max_ns, ns, memory_order_relaxed);
+}
+
+void privacy_mask_tick_print(PrivacyMask *pm)
+{
+    if (!pm) return;
+    uint64_t frames  = atomic_exchange(&pm->stat_frames, 0);
+    uint64_t ns      = atomic_exchange(&pm->stat_ns, 0);
+    uint64_t max_ns  = atomic_exchange(&pm->stat_max_ns, 0);
+    uint64_t skipped = atomic_exchange(&pm->stat_skipped, 0);
+    int      masks   = atomic_load(&pm->stat_masks);
+    if (masks == 0 && skipped == 0) return;
+
+    LOGI("[MASK] regions=%d cover=%.1f%% frames=%llu avg=%.3fms max=%.3fms skipped=%llu",
+         masks, (double)atomic_load(&pm->stat_pixels) * 100.0 / ((double)pm->w * (double)pm->h),
+         (unsigned long long)frames, frames ? (double)ns / (double)frames / 1e6 : 0.0,
+         (double)max_ns / 1e6, (unsigned long long)skipped);
+}
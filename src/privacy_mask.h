@@ -0,0 +1,108 @@
+/**
+ * @file privacy_mask.h
+ * @brief NV12 隐私遮挡模块头文件
+ *
+ * 部分安装位置不允许录下某些区域（邻居窗户、密码键盘）。编码线程在送编码器之前，
+ * 直接在 VideoFrame 的 Y / UV 平面上原地填充或马赛克化配置的矩形 / 多边形区域：
+ * 不多一次帧拷贝，录像与直播预览看到的都是遮挡后的画面。
+ *
+ * 遮挡描述（--mask 与控制命令 mask set 使用同一语法，多个区域以 ';' 分隔）：
+ *   rect:X,Y,W,H[@样式]
+ *   poly:X1,Y1,X2,Y2,X3,Y3[,...][@样式]     最多 PM_MAX_VERTS 个顶点，奇偶规则填充
+ * 样式：black（默认，Y=16 UV=128）| gray（Y=128 UV=128）| pix<N>（N×N 马赛克，N 为 4-128 的偶数，默认 16）
+ * 例：rect:0,0,320,180;poly:900,400,1100,380,1120,600,880,620@pix24
+ *
+ * 实现：
+ * - 描述先编译成行区间表（每个区域按行列出 [x0, x1)，色度行另算一份，取上下两行亮度区间的并集并向外取整），
+ *   逐帧只按区间做 NEON / SSE2 批量写入，不做逐像素判断
+ * - 马赛克按帧坐标对齐的 N×N 网格取块均值（SAD / 成对累加求和），先算完一整行块再回写
+ * - 运行时更新（控制通道 mask 命令）：控制线程编译新表后原子交换到 pending，
+ *   编码线程在下一帧开始前取走并释放旧表，编码线程无锁
+ */
+#pragma once
+
+#include "rkav/types.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 最多遮挡区域数 */
+#define PM_MAX_MASKS   16
+
+/** 多边形最多顶点数 */
+#define PM_MAX_VERTS   16
+
+/** 遮挡描述最大长度 */
+#define PM_SPEC_MAX    1024
+
+/** 编译后的遮挡表（内部结构） */
+typedef struct PmPlan PmPlan;
+
+/**
+ * @brief 隐私遮挡状态
+ *
+ * active 只由编码线程访问；pending / spec 由控制线程更新；stat_* 为原子计数，统计线程读取。
+ */
+typedef struct {
+    int                w;                   /**< 帧宽（遮挡表按此尺寸编译） */
+    int                h;                   /**< 帧高 */
+    _Atomic(PmPlan *)  pending;             /**< 新编译的遮挡表，编码线程下一帧取走 */
+    PmPlan            *active;              /**< 当前生效的遮挡表（编码线程） */
+
+    pthread_mutex_t    mtx;                 /**< 保护 spec */
+    char               spec[PM_SPEC_MAX];   /**< 当前生效的描述（控制命令回显） */
+
+    atomic_uint_fast64_t stat_frames;       /**< 过去 1 秒遮挡的帧数 */
+    atomic_uint_fast64_t stat_ns;           /**< 过去 1 秒遮挡耗时（纳秒） */
+    atomic_uint_fast64_t stat_max_ns;       /**< 过去 1 秒单帧最大耗时 */
+    atomic_uint_fast64_t stat_skipped;      /**< 过去 1 秒因尺寸不符跳过的帧数 */
+    atomic_int           stat_masks;        /**< 当前区域数 */
+    atomic_uint_fast64_t stat_pixels;       /**< 当前遮挡的亮度像素数（区域重叠时重复计） */
+} PrivacyMask;
+
+/**
+ * @brief 初始化并编译初始遮挡
+ *
+ * @param pm   遮挡状态
+ * @param w    帧宽
+ * @param h    帧高（NV12，需为偶数）
+ * @param spec 初始描述，NULL 或 "" 表示暂无遮挡
+ * @return int 0 成功，-1 描述非法或内存不足
+ */
+int  privacy_mask_init(PrivacyMask *pm, int w, int h, const char *spec);
+
+/** 释放遮挡表 */
+void privacy_mask_deinit(PrivacyMask *pm);
+
+/**
+ * @brief 替换全部遮挡（控制线程调用，下一帧生效）
+ *
+ * @param spec   新描述，"" 表示清除全部遮挡
+ * @param err    出错时写入原因（可为 NULL）
+ * @param errlen err 容量
+ * @return int   0 成功，-1 描述非法（原遮挡保持不变）
+ */
+int  privacy_mask_set(PrivacyMask *pm, const char *spec, char *err, size_t errlen);
+
+/** 读出当前描述，返回长度 */
+size_t privacy_mask_get(PrivacyMask *pm, char *buf, size_t cap);
+
+/**
+ * @brief 对一帧原地施加遮挡（编码线程每帧调用）
+ *
+ * 帧尺寸与编译尺寸不符时跳过并计数。
+ */
+void privacy_mask_apply(PrivacyMask *pm, VideoFrame *vf);
+
+/** 打印 [MASK] 统计并清零窗口计数（统计线程每秒调用，无遮挡时不打印） */
+void privacy_mask_tick_print(PrivacyMask *pm);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,336 @@
+/**
+ * @file proc_mon.c
+ * @brief 进程 / 线程资源自监控实现
+ */
+#include "proc_mon.h"
+#include "log.h"
+
+#include <dirent.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+/** 日志标签 */
+#define TAG "procmon"
+
+static uint64_t mono_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t tv_ns(const struct timeval *tv)
+{
+    return (uint64_t)tv->tv_sec * 1000000000ull + (uint64_t)tv->tv_usec * 1000ull;
+}
+
+/* 计数器差值（计数器回绕 / 线程换号时按 0 处理） */
+static uint64_t delta(uint64_t now, uint64_t prev)
+{
+    return now >= prev ? now - prev : 0;
+}
+
+int proc_mon_init(ProcMon *m)
+{
+    if (!m) return -1;
+    memset(m, 0, sizeof(*m));
+    pthread_mutex_init(&m->mtx, NULL);
+    return 0;
+}
+
+void proc_mon_deinit(ProcMon *m)
+{
+    if (!m) return;
+    pthread_mutex_destroy(&m->mtx);
+}
+
+int proc_mon_add(ProcMon *m, pthread_t th, const char *name)
+{
+    if (!m || !name) return -1;
+
+    pthread_mutex_lock(&m->mtx);
+    if (m->count >= PROC_MON_MAX_THREADS) {
+        pthread_mutex_unlock(&m->mtx);
+        LOGW("[%s] too many threads, %s not monitored", TAG, name);
+        return -1;
+    }
+    ProcMonThread *t = &m->th[m->count];
+    memset(t, 0, sizeof(*t));
+    snprintf(t->name, sizeof(t->name), "%s", name);
+    if (pthread_getcpuclockid(th, &t->cpu_clock) != 0) {
+        pthread_mutex_unlock(&m->mtx);
+        LOGW("[%s] pthread_getcpuclockid failed for %s", TAG, name);
+        return -1;
+    }
+    pthread_setname_np(th, t->name);
+    t->alive = true;
+    m->count++;
+    pthread_mutex_unlock(&m->mtx);
+    return 0;
+}
+
+/* 读 /proc 下的小文件到 buf（以 0 结尾），返回长度，失败返回 -1 */
+static int read_small(const char *path, char *buf, size_t cap)
+{
+    FILE *fp = fopen(path, "re");
+    if (!fp) return -1;
+    size_t n = fread(buf, 1, cap - 1, fp);
+    fclose(fp);
+    buf[n] = '\0';
+    return (int)n;
+}
+
+/* 按线程名在 /proc/self/task 中查找尚未定位的线程 tid */
+static void resolve_tids(ProcMon *m)
+{
+    int pending = 0;
+    for (int i = 0; i < m->count; i++)
+        if (m->th[i].alive && m->th[i].tid == 0) pending++;
+    if (!pending) return;
+
+    DIR *d = opendir("/proc/self/task");
+    if (!d) return;
+    struct dirent *de;
+    while (pending && (de = readdir(d)) != NULL) {
+        if (de->d_name[0] < '0' || de->d_name[0] > '9') continue;
+        char path[300], comm[32];
+        snprintf(path, sizeof(path), "/proc/self/task/%s/comm", de->d_name);
+        int n = read_small(path, comm, sizeof(comm));
+        if (n <= 0) continue;
+        if (comm[n - 1] == '\n') comm[n - 1] = '\0';
+        for (int i = 0; i < m->count; i++) {
+            ProcMonThread *t = &m->th[i];
+            if (t->alive && t->tid == 0 && strcmp(t->name, comm) == 0) {
+                t->tid = (pid_t)atoi(de->d_name);
+                pending--;
+                break;
+            }
+        }
+    }
+    closedir(d);
+}
+
+/* 读取一个线程的上下文切换与缺页计数；失败（线程已退出）返回 -1 */
+static int read_task(pid_t tid, uint64_t *vcsw, uint64_t *ivcsw, uint64_t *minflt, uint64_t *majflt)
+{
+    char path[64], buf[2048];
+
+    snprintf(path, sizeof(path), "/proc/self/task/%d/stat", (int)tid);
+    if (read_small(path, buf, sizeof(buf)) <= 0) return -1;
+    /* comm 可能含空格，从最后一个 ')' 之后解析：state ppid pgrp session tty tpgid flags minflt cminflt majflt */
+    char *p = strrchr(buf, ')');
+    unsigned long long mi = 0, ma = 0;
+    if (!p || sscanf(p + 1, " %*c %*d %*d %*d %*d %*d %*u %llu %*u %llu", &mi, &ma) != 2)
+        return -1;
+    *minflt = mi;
+    *majflt = ma;
+
+    snprintf(path, sizeof(path), "/proc/self/task/%d/status", (int)tid);
+    if (read_small(path, buf, sizeof(buf)) <= 0) return -1;
+    const char *v  = strstr(buf, "\nvoluntary_ctxt_switches:");
+    const char *nv = strstr(buf, "\nnonvoluntary_ctxt_switches:");
+    if (v)  *vcsw  = strtoull(strchr(v + 1, ':') + 1, NULL, 10);
+    if (nv) *ivcsw = strtoull(strchr(nv + 1, ':') + 1, NULL, 10);
+    return 0;
+}
+
+/* RSS / PSS（kB）：优先 smaps_rollup（4.14+），否则只从 statm 取 RSS */
+static void read_mem(uint64_t *rss_kb, uint64_t *pss_kb)
+{
+    char buf[2048];
+    *rss_kb = 0;
+    *pss_kb = 0;
+    if (read_small("/proc/self/smaps_rollup", buf, sizeof(buf)) > 0) {
+        const char *r = strstr(buf, "\nRss:");
+        const char *p = strstr(buf, "\nPss:");
+        if (r) *rss_kb = strtoull(r + 5, NULL, 10);
+        if (p) *pss_kb = strtoull(p + 5, NULL, 10);
+        if (*rss_kb) return;
+    }
+    unsigned long long size = 0, res = 0;
+    if (read_small("/proc/self/statm", buf, sizeof(buf)) > 0 &&
+        sscanf(buf, "%llu %llu", &size, &res) == 2)
+        *rss_kb = res * (uint64_t)sysconf(_SC_PAGESIZE) / 1024u;
+}
+
+void proc_mon_sample(ProcMon *m, uint64_t frames)
+{
+    if (!m) return;
+
+    pthread_mutex_lock(&m->mtx);
+    uint64_t now = mono_ns();
+    uint64_t dt  = m->primed ? delta(now, m->last_ns) : 0;
+
+    resolve_tids(m);
+    for (int i = 0; i < m->count; i++) {
+        ProcMonThread *t = &m->th[i];
+        if (!t->alive) continue;
+
+        struct timespec ts;
+        if (clock_gettime(t->cpu_clock, &ts) != 0) {
+            t->alive   = false;
+            t->cpu_pct = 0.0;
+            continue;
+        }
+        uint64_t cpu = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+        uint64_t vcsw = t->vcsw, ivcsw = t->ivcsw, minflt = t->minflt, majflt = t->majflt;
+        if (t->tid && read_task(t->tid, &vcsw, &ivcsw, &minflt, &majflt) != 0)
+            t->tid = 0;     /* 线程名被改写或已退出：下次重新查找 */
+
+        if (dt && t->primed) {
+            uint64_t dc     = delta(cpu, t->cpu_ns);
+            t->cpu_pct      = (double)dc * 100.0 / (double)dt;
+            t->ns_per_frame = frames ? dc / frames : 0;
+            t->d_vcsw       = delta(vcsw, t->vcsw);
+            t->d_ivcsw      = delta(ivcsw, t->ivcsw);
+            t->d_minflt     = delta(minflt, t->minflt);
+            t->d_majflt     = delta(majflt, t->majflt);
+        }
+        t->cpu_ns = cpu;
+        t->vcsw   = vcsw;
+        t->ivcsw  = ivcsw;
+        t->minflt = minflt;
+        t->majflt = majflt;
+        t->primed = true;
+    }
+
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        uint64_t cpu = tv_ns(&ru.ru_utime) + tv_ns(&ru.ru_stime);
+        if (dt) {
+            uint64_t dc = delta(cpu, m->cpu_ns);
+            m->cpu_pct      = (double)dc * 100.0 / (double)dt;
+            m->ns_per_frame = frames ? dc / frames : 0;
+            m->d_minflt     = delta((uint64_t)ru.ru_minflt, m->minflt);
+            m->d_majflt     = delta((uint64_t)ru.ru_majflt, m->majflt);
+            m->d_vcsw       = delta((uint64_t)ru.ru_nvcsw, m->vcsw);
+            m->d_ivcsw      = delta((uint64_t)ru.ru_nivcsw, m->ivcsw);
+        }
+        m->cpu_ns = cpu;
+        m->minflt = (uint64_t)ru.ru_minflt;
+        m->majflt = (uint64_t)ru.ru_majflt;
+        m->vcsw   = (uint64_t)ru.ru_nvcsw;
+        m->ivcsw  = (uint64_t)ru.ru_nivcsw;
+    }
+    read_mem(&m->rss_kb, &m->pss_kb);
+
+    m->frames  = frames;
+    m->last_ns = now;
+    m->primed  = true;
+    m->samples++;
+    pthread_mutex_unlock(&m->mtx);
+}
+
+void proc_mon_tick_print(ProcMon *m)
+{
+    if (!m) return;
+
+    pthread_mutex_lock(&m->mtx);
+    if (m->samples < 2) {          /* 第一次采样只有基线 */
+        pthread_mutex_unlock(&m->mtx);
+        return;
+    }
+
+    char line[1024];
+    int off = 0;
+    for (int i = 0; i < m->count && off < (int)sizeof(line); i++) {
+        const ProcMonThread *t = &m->th[i];
+        if (!t->alive) continue;
+        off += snprintf(line + off, sizeof(line) - (size_t)off, " %s=%.1f%%", t->name, t->cpu_pct);
+        if (off < (int)sizeof(line) && t->ns_per_frame)
+            off += snprintf(line + off, sizeof(line) - (size_t)off, "/%.2fms",
+                            (double)t->ns_per_frame / 1e6);
+        if (off < (int)sizeof(line) && (t->d_vcsw || t->d_ivcsw))
+            off += snprintf(line + off, sizeof(line) - (size_t)off, "(cs %llu/%llu)",
+                            (unsigned long long)t->d_vcsw, (unsigned long long)t->d_ivcsw);
+    }
+    if (off >= (int)sizeof(line)) off = (int)sizeof(line) - 1;
+    line[off > 0 ? off : 0] = '\0';
+
+    LOGI("[CPU] proc=%.1f%% %.2fms/frame cs=%llu/%llu%s%s",
+         m->cpu_pct, (double)m->ns_per_frame / 1e6,
+         (unsigned long long)m->d_vcsw, (unsigned long long)m->d_ivcsw,
+         off > 0 ? " |" : "", line);
+    LOGI("[MEM] rss=%.1fMB pss=%.1fMB minflt=%llu/s majflt=%llu/s",
+         (double)m->rss_kb / 1024.0, (double)m->pss_kb / 1024.0,
+         (unsigned long long)m->d_minflt, (unsigned long long)m->d_majflt);
+    pthread_mutex_unlock(&m->mtx);
+}
+
+/* 追加格式化文本，超出容量时截断（返回值始终 <= cap - 1） */
+static size_t fmt_append(char *buf, size_t cap, size_t off, const char *fmt, ...)
+{
+    if (off + 1 >= cap) return off;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf + off, cap - off, fmt, ap);
+    va_end(ap);
+    if (n < 0) return off;
+    off += (size_t)n;
+    return off < cap ? off : cap - 1;
+}
+
+size_t proc_mon_format(ProcMon *m, char *buf, size_t cap)
+{
+    if (!m || !buf || cap == 0) return 0;
+    buf[0] = '\0';
+
+    pthread_mutex_lock(&m->mtx);
+    size_t o = 0;
+    o = fmt_append(buf, cap, o,
+                   "# TYPE rkav_process_cpu_seconds_total counter\n"
+                   "rkav_process_cpu_seconds_total %.6f\n"
+                   "# TYPE rkav_process_cpu_percent gauge\n"
+                   "rkav_process_cpu_percent %.2f\n"
+                   "# TYPE rkav_process_cpu_ns_per_frame gauge\n"
+                   "rkav_process_cpu_ns_per_frame %llu\n"
+                   "# TYPE rkav_video_frames_per_second gauge\n"
+                   "rkav_video_frames_per_second %llu\n"
+                   "# TYPE rkav_process_rss_bytes gauge\n"
+                   "rkav_process_rss_bytes %llu\n"
+                   "# TYPE rkav_process_pss_bytes gauge\n"
+                   "rkav_process_pss_bytes %llu\n"
+                   "# TYPE rkav_process_page_faults_total counter\n"
+                   "rkav_process_page_faults_total{kind=\"minor\"} %llu\n"
+                   "rkav_process_page_faults_total{kind=\"major\"} %llu\n"
+                   "# TYPE rkav_process_context_switches_total counter\n"
+                   "rkav_process_context_switches_total{kind=\"voluntary\"} %llu\n"
+                   "rkav_process_context_switches_total{kind=\"involuntary\"} %llu\n",
+                   (double)m->cpu_ns / 1e9, m->cpu_pct, (unsigned long long)m->ns_per_frame,
+                   (unsigned long long)m->frames,
+                   (unsigned long long)m->rss_kb * 1024ull, (unsigned long long)m->pss_kb * 1024ull,
+                   (unsigned long long)m->minflt, (unsigned long long)m->majflt,
+                   (unsigned long long)m->vcsw, (unsigned long long)m->ivcsw);
+
+    o = fmt_append(buf, cap, o,
+                   "# TYPE rkav_thread_cpu_seconds_total counter\n"
+                   "# TYPE rkav_thread_cpu_percent gauge\n"
+                   "# TYPE rkav_thread_cpu_ns_per_frame gauge\n"
+                   "# TYPE rkav_thread_context_switches_total counter\n"
+                   "# TYPE rkav_thread_page_faults_total counter\n");
+    for (int i = 0; i < m->count; i++) {
+        const ProcMonThread *t = &m->th[i];
+        if (!t->alive) continue;
+        o = fmt_append(buf, cap, o,
+                       "rkav_thread_cpu_seconds_total{thread=\"%s\"} %.6f\n"
+                       "rkav_thread_cpu_percent{thread=\"%s\"} %.2f\n"
+                       "rkav_thread_cpu_ns_per_frame{thread=\"%s\"} %llu\n"
+                       "rkav_thread_context_switches_total{thread=\"%s\",kind=\"voluntary\"} %llu\n"
+                       "rkav_thread_context_switches_total{thread=\"%s\",kind=\"involuntary\"} %llu\n"
+                       "rkav_thread_page_faults_total{thread=\"%s\",kind=\"minor\"} %llu\n"
+                       "rkav_thread_page_faults_total{thread=\"%s\",kind=\"major\"} %llu\n",
+                       t->name, (double)t->cpu_ns / 1e9,
+                       t->name, t->cpu_pct,
+                       t->name, (unsigned long long)t->ns_per_frame,
+                       t->name, (unsigned long long)t->vcsw,
+                       t->name, (unsigned long long)t->ivcsw,
+                       t->name, (unsigned long long)t->minflt,
+                       t->name, (unsigned long long)t->majflt);
+    }
+    pthread_mutex_unlock(&m->mtx);
+    return o;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file proc_mon.h
+ * @brief 进程 / 线程资源自监控头文件
+ *
+ * top 只能看到进程总 CPU，无法区分采集、编码、写盘、统计各自的开销。本模块每秒采样：
+ * - 每线程：CPU 时间（pthread_getcpuclockid，纳秒精度）、主动 / 被动上下文切换、缺页 / 主缺页
+ *   （/proc/self/task/<tid>/status、stat）
+ * - 进程：CPU 时间、缺页 / 主缺页、上下文切换（getrusage(RUSAGE_SELF)），RSS / PSS（/proc/self/smaps_rollup）
+ *
+ * 结合每秒编码帧数给出“每帧 CPU 开销”（总计与每线程），单帧成本的回归在线上遥测中直接可见。
+ * 结果随 [STAT] 每秒输出 [CPU] / [MEM]，并可格式化为 Prometheus 文本（直播服务 GET /metrics）。
+ *
+ * 典型使用流程：
+ * 1. proc_mon_init()
+ * 2. 主线程: 每创建一个线程调用 proc_mon_add()（同时设置线程名，便于 top -H / perf 对照）
+ * 3. 统计线程: proc_mon_sample() + proc_mon_tick_print()
+ * 4. 任意线程: proc_mon_format()（读取最近一次采样）
+ * 5. proc_mon_deinit()
+ */
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 最多监控的线程数 */
+#define PROC_MON_MAX_THREADS  24
+
+/**
+ * @brief 单个线程的采样状态
+ */
+typedef struct {
+    char      name[16];         /**< 线程名（同时写入内核 comm） */
+    clockid_t cpu_clock;        /**< 线程 CPU 时钟 */
+    pid_t     tid;              /**< 内核线程 ID（按 comm 在 /proc/self/task 中查得，0 = 尚未找到） */
+    bool      alive;            /**< 线程是否仍在运行（CPU 时钟读取失败即视为已退出） */
+    bool      primed;           /**< 是否已有基线（登记后的第一次采样只记基线） */
+
+    uint64_t  cpu_ns;           /**< 累计 CPU 时间 */
+    uint64_t  vcsw, ivcsw;      /**< 累计主动 / 被动上下文切换 */
+    uint64_t  minflt, majflt;   /**< 累计缺页 / 主缺页 */
+
+    double    cpu_pct;          /**< 最近 1 秒 CPU 占用（单核百分比） */
+    uint64_t  ns_per_frame;     /**< 最近 1 秒每编码帧 CPU 时间（无帧时为 0） */
+    uint64_t  d_vcsw, d_ivcsw;  /**< 最近 1 秒上下文切换 */
+    uint64_t  d_minflt, d_majflt; /**< 最近 1 秒缺页 */
+} ProcMonThread;
+
+/**
+ * @brief 自监控上下文
+ */
+typedef struct {
+    pthread_mutex_t mtx;                /**< 保护采样结果（统计线程写，服务线程读） */
+    int             count;
+    ProcMonThread   th[PROC_MON_MAX_THREADS];
+
+    bool      primed;                   /**< 是否已有基线（第一次采样只记基线） */
+    uint64_t  samples;                  /**< 已完成的采样次数 */
+    uint64_t  last_ns;                  /**< 上次采样时刻（monotonic） */
+    uint64_t  cpu_ns;                   /**< 进程累计 CPU 时间 */
+    uint64_t  minflt, majflt, vcsw, ivcsw;
+
+    double    cpu_pct;                  /**< 最近 1 秒进程 CPU 占用（单核百分比，多核可超过 100） */
+    uint64_t  frames;                   /**< 最近 1 秒编码帧数 */
+    uint64_t  ns_per_frame;             /**< 最近 1 秒每编码帧进程 CPU 时间 */
+    uint64_t  d_minflt, d_majflt, d_vcsw, d_ivcsw;
+    uint64_t  rss_kb, pss_kb;           /**< 当前 RSS / PSS（无 smaps_rollup 时 PSS 为 0） */
+} ProcMon;
+
+/** 初始化 */
+int  proc_mon_init(ProcMon *m);
+
+/**
+ * @brief 登记一个线程（由创建者在 pthread_create 成功后调用）
+ *
+ * 设置线程名（超过 15 字符截断）并取得其 CPU 时钟。
+ *
+ * @return int 0 成功，-1 已满或取时钟失败
+ */
+int  proc_mon_add(ProcMon *m, pthread_t th, const char *name);
+
+/**
+ * @brief 采样一次（统计线程每秒调用）
+ *
+ * @param m      自监控上下文
+ * @param frames 距上次采样编码输出的视频帧数，用于计算每帧 CPU 开销
+ */
+void proc_mon_sample(ProcMon *m, uint64_t frames);
+
+/** 打印最近一次采样：[CPU] 进程 + 每线程，[MEM] 内存与缺页 */
+void proc_mon_tick_print(ProcMon *m);
+
+/**
+ * @brief 把最近一次采样格式化为 Prometheus 文本格式
+ *
+ * @return size_t 写入的字节数（不含结尾 0，超出 cap 时截断）
+ */
+size_t proc_mon_format(ProcMon *m, char *buf, size_t cap);
+
+/** 释放 */
+void proc_mon_deinit(ProcMon *m);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,745 @@
+/**
+ * @file rec_catalog.c
+ * @brief 录像目录（catalog）模块实现
+ *
+ * 记录按结构体原样写出（目标平台与开发主机均为小端）。目录以 O_APPEND 打开，每条记录一次 write()；
+ * 段打开 / 关闭 / 删除之后 fdatasync，关键帧记录只进页缓存，掉电最多丢失最近一个段的尾部关键帧。
+ */
+#include "rec_catalog.h"
+#include "crc32c.h"
+#include "log.h"
+
+#include "rkav/time.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/** 模块日志标签 */
+#define TAG "catalog"
+
+/** 墓碑数达到该值且超过存活段数时压实目录 */
+#define COMPACT_MIN_DEAD  16
+
+/** 重放时的读缓冲大小 */
+#define REPLAY_CHUNK      (256u << 10)
+
+_Static_assert(sizeof(RecCatalogHeader) == 16, "RecCatalogHeader must be 16 bytes");
+_Static_assert(sizeof(RecCatalogRecord) == 32, "RecCatalogRecord must be 32 bytes");
+
+uint64_t rec_catalog_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000ull;
+}
+
+/* ============================================================================
+ * 内存索引
+ * ============================================================================ */
+
+/* 按段号二分查找（段号单调递增） */
+static RecCatalogSeg *seg_by_id(RecCatalog *cat, uint32_t id)
+{
+    uint32_t lo = 0, hi = cat->nsegs;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (cat->segs[mid].id < id) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo < cat->nsegs && cat->segs[lo].id == id) return &cat->segs[lo];
+    return NULL;
+}
+
+static RecCatalogStream *stream_get(RecCatalog *cat, int kind, int index, bool create)
+{
+    for (int i = 0; i < cat->nstreams; i++) {
+        RecCatalogStream *st = &cat->streams[i];
+        if (st->kind == (uint16_t)kind && st->index == (uint16_t)index) return st;
+    }
+    if (!create || cat->nstreams >= REC_CATALOG_MAX_STREAMS) return NULL;
+    RecCatalogStream *st = &cat->streams[cat->nstreams++];
+    memset(st, 0, sizeof(*st));
+    st->kind  = (uint16_t)kind;
+    st->index = (uint16_t)index;
+    return st;
+}
+
+static int stream_push(RecCatalogStream *st, uint32_t seg_idx)
+{
+    if (st->nsegs == st->cap) {
+        uint32_t cap = st->cap ? st->cap * 2 : 64;
+        uint32_t *p = realloc(st->segs, cap * sizeof(*p));
+        if (!p) return -1;
+        st->segs = p;
+        st->cap  = cap;
+    }
+    st->segs[st->nsegs++] = seg_idx;
+    return 0;
+}
+
+/* 追加一个段到内存索引 */
+static RecCatalogSeg *seg_add(RecCatalog *cat, uint32_t id, int kind, int index,
+                              const char *path, uint64_t t_us)
+{
+    RecCatalogStream *st = stream_get(cat, kind, index, true);
+    if (!st) {
+        LOGW("[%s] too many streams, segment %u ignored", TAG, id);
+        return NULL;
+    }
+    if (cat->nsegs == cat->cap_segs) {
+        uint32_t cap = cat->cap_segs ? cat->cap_segs * 2 : 64;
+        RecCatalogSeg *p = realloc(cat->segs, cap * sizeof(*p));
+        if (!p) return NULL;
+        cat->segs     = p;
+        cat->cap_segs = cap;
+    }
+    char *dup = strdup(path);
+    if (!dup || stream_push(st, cat->nsegs) != 0) {
+        free(dup);
+        return NULL;
+    }
+
+    RecCatalogSeg *s = &cat->segs[cat->nsegs++];
+    memset(s, 0, sizeof(*s));
+    s->id      = id;
+    s->kind    = (uint16_t)kind;
+    s->index   = (uint16_t)index;
+    s->path    = dup;
+    s->t_start = t_us;
+    s->t_end   = t_us;
+    s->open    = true;
+    cat->live++;
+    if (id >= cat->next_id) cat->next_id = id + 1;
+    return s;
+}
+
+static void seg_add_key(RecCatalog *cat, RecCatalogSeg *s, uint64_t t_us, uint64_t offset)
+{
+    if (s->nkeys == s->cap_keys) {
+        uint32_t cap = s->cap_keys ? s->cap_keys * 2 : 64;
+        RecCatalogKey *p = realloc(s->keys, cap * sizeof(*p));
+        if (!p) return;
+        s->keys     = p;
+        s->cap_keys = cap;
+    }
+    s->keys[s->nkeys].t_us   = t_us;
+    s->keys[s->nkeys].offset = offset;
+    s->nkeys++;
+    if (t_us > s->t_end) s->t_end = t_us;
+    if (!s->deleted && offset > s->bytes) {
+        cat->live_bytes += offset - s->bytes;
+        s->bytes = offset;
+    }
+}
+
+static void seg_set_closed(RecCatalog *cat, RecCatalogSeg *s, uint64_t t_us, uint64_t bytes)
+{
+    if (!s->deleted) cat->live_bytes = cat->live_bytes - s->bytes + bytes;
+    s->bytes = bytes;
+    if (t_us > s->t_end) s->t_end = t_us;
+    s->open = false;
+}
+
+static void seg_set_deleted(RecCatalog *cat, RecCatalogSeg *s)
+{
+    if (s->deleted) return;
+    s->deleted = true;
+    s->open    = false;
+    cat->live--;
+    cat->dead++;
+    cat->live_bytes -= s->bytes;
+}
+
+static void index_free(RecCatalog *cat)
+{
+    for (uint32_t i = 0; i < cat->nsegs; i++) {
+        free(cat->segs[i].path);
+        free(cat->segs[i].keys);
+    }
+    free(cat->segs);
+    for (int i = 0; i < cat->nstreams; i++) free(cat->streams[i].segs);
+    cat->segs = NULL;
+    cat->nsegs = cat->cap_segs = 0;
+    cat->nstreams = 0;
+}
+
+/* ============================================================================
+ * 记录读写
+ * ============================================================================ */
+
+static uint32_t record_crc(const RecCatalogRecord *r, const char *path)
+{
+    uint32_t crc = crc32c(r, offsetof(RecCatalogRecord, rec_crc));
+    if (r->path_len) crc = crc32c_update(crc, path, r->path_len);
+    return crc;
+}
+
+/* 路径补齐到 8 字节 */
+static size_t path_pad(size_t len)
+{
+    return (len + 7u) & ~(size_t)7u;
+}
+
+/* 编码一条记录到 buf，返回字节数 */
+static size_t record_build(uint8_t *buf, RecCatalogRecType type, uint32_t seg_id, uint64_t t_us,
+                           uint64_t val, uint32_t aux, const char *path)
+{
+    RecCatalogRecord r;
+    memset(&r, 0, sizeof(r));
+    r.type     = (uint16_t)type;
+    r.path_len = (uint16_t)(path ? strlen(path) : 0);
+    r.seg_id   = seg_id;
+    r.t_us     = t_us;
+    r.val      = val;
+    r.aux      = aux;
+    r.rec_crc  = record_crc(&r, path);
+
+    memcpy(buf, &r, sizeof(r));
+    size_t n = sizeof(r);
+    if (r.path_len) {
+        size_t padded = path_pad(r.path_len);
+        memset(buf + n, 0, padded);
+        memcpy(buf + n, path, r.path_len);
+        n += padded;
+    }
+    return n;
+}
+
+static int write_all(int fd, const uint8_t *buf, size_t len)
+{
+    while (len) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/* 追加一条记录（调用方持锁） */
+static int append_rec(RecCatalog *cat, RecCatalogRecType type, uint32_t seg_id, uint64_t t_us,
+                      uint64_t val, uint32_t aux, const char *path)
+{
+    if (cat->fd < 0) return -1;
+    uint8_t buf[sizeof(RecCatalogRecord) + REC_CATALOG_MAX_PATH + 8];
+    size_t n = record_build(buf, type, seg_id, t_us, val, aux, path);
+    if (write_all(cat->fd, buf, n) != 0) {
+        LOGW("[%s] append failed: %s (%s)", TAG, cat->path, strerror(errno));
+        return -1;
+    }
+    cat->log_bytes += n;
+    return 0;
+}
+
+static int write_header(int fd)
+{
+    RecCatalogHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, REC_CATALOG_MAGIC, 4);
+    hdr.version  = REC_CATALOG_VERSION;
+    hdr.rec_size = (uint16_t)sizeof(RecCatalogRecord);
+    hdr.hdr_crc  = crc32c(&hdr, offsetof(RecCatalogHeader, hdr_crc));
+    return write_all(fd, (const uint8_t *)&hdr, sizeof(hdr));
+}
+
+static int check_header(const RecCatalogHeader *hdr)
+{
+    if (memcmp(hdr->magic, REC_CATALOG_MAGIC, 4) != 0) return -1;
+    if (hdr->hdr_crc != crc32c(hdr, offsetof(RecCatalogHeader, hdr_crc))) return -1;
+    if (hdr->version != REC_CATALOG_VERSION) return -1;
+    if (hdr->rec_size != sizeof(RecCatalogRecord)) return -1;
+    return 0;
+}
+
+/* 把一条已校验的记录应用到内存索引；不合法返回 -1（按撕裂尾部处理） */
+static int apply_rec(RecCatalog *cat, const RecCatalogRecord *r, const char *path)
+{
+    RecCatalogSeg *s;
+    switch (r->type) {
+    case RECCAT_SEG_OPEN: {
+        if (r->seg_id < cat->next_id || r->path_len == 0) return -1;
+        char p[REC_CATALOG_MAX_PATH];
+        memcpy(p, path, r->path_len);
+        p[r->path_len] = '\0';
+        if (!seg_add(cat, r->seg_id, (int)(r->aux >> 16), (int)(r->aux & 0xFFFFu), p, r->t_us))
+            cat->next_id = r->seg_id + 1;   /* 无法索引（流太多）：跳过该段的后续记录 */
+        return 0;
+    }
+    case RECCAT_KEY:
+        if ((s = seg_by_id(cat, r->seg_id)) != NULL) seg_add_key(cat, s, r->t_us, r->val);
+        return 0;
+    case RECCAT_SEG_CLOSE:
+        if ((s = seg_by_id(cat, r->seg_id)) != NULL) seg_set_closed(cat, s, r->t_us, r->val);
+        return 0;
+    case RECCAT_SEG_DELETE:
+        if ((s = seg_by_id(cat, r->seg_id)) != NULL) seg_set_deleted(cat, s);
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+/*
+ * 顺序重放目录文件。
+ * @param valid_end 输出：最后一条完整记录之后的偏移
+ * @return 0 成功（含尾部撕裂），-1 文件头无效或读失败
+ */
+static int replay(RecCatalog *cat, int fd, uint64_t *valid_end)
+{
+    RecCatalogHeader hdr;
+    if (pread(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) || check_header(&hdr) != 0)
+        return -1;
+
+    uint8_t *buf = malloc(REPLAY_CHUNK);
+    if (!buf) return -1;
+
+    uint64_t file_off = sizeof(hdr);    /* buf[0] 对应的文件偏移 */
+    size_t   len = 0, pos = 0;
+    bool     eof = false;
+    *valid_end = sizeof(hdr);
+
+    for (;;) {
+        /* 保证缓冲里至少有一条最长的记录 */
+        if (!eof && len - pos < sizeof(RecCatalogRecord) + REC_CATALOG_MAX_PATH + 8) {
+            memmove(buf, buf + pos, len - pos);
+            file_off += pos;
+            len -= pos;
+            pos = 0;
+            ssize_t n = pread(fd, buf + len, REPLAY_CHUNK - len, (off_t)(file_off + len));
+            if (n < 0) {
+                free(buf);
+                return -1;
+            }
+            if (n == 0) eof = true;
+            len += (size_t)n;
+        }
+        if (len - pos < sizeof(RecCatalogRecord)) break;
+
+        RecCatalogRecord r;
+        memcpy(&r, buf + pos, sizeof(r));
+        if (r.path_len >= REC_CATALOG_MAX_PATH) break;
+        size_t rec_len = sizeof(r) + (r.path_len ? path_pad(r.path_len) : 0);
+        if (len - pos < rec_len) break;
+
+        const char *path = (const char *)(buf + pos + sizeof(r));
+        if (r.rec_crc != record_crc(&r, path)) break;
+        if (apply_rec(cat, &r, path) != 0) break;
+
+        pos += rec_len;
+        *valid_end = file_off + pos;
+    }
+
+    free(buf);
+    return 0;
+}
+
+static int fsync_dir_of(const char *path)
+{
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char *slash = strrchr(dir, '/');
+    if (slash) {
+        if (slash == dir) slash[1] = '\0';
+        else *slash = '\0';
+    } else {
+        strcpy(dir, ".");
+    }
+    int dfd = open(dir, O_RDONLY | O_DIRECTORY);
+    if (dfd < 0) return -1;
+    int r = fsync(dfd);
+    close(dfd);
+    return r;
+}
+
+/* 删除段文件及其索引 sidecar（文件不存在不算错误） */
+static void unlink_segment(const char *path)
+{
+    char idx[REC_CATALOG_MAX_PATH + 8];
+    if (unlink(path) != 0 && errno != ENOENT)
+        LOGW("[%s] unlink failed: %s (%s)", TAG, path, strerror(errno));
+    snprintf(idx, sizeof(idx), "%s.idx", path);
+    unlink(idx);
+}
+
+/*
+ * 压实：只保留存活段，写入临时文件后原子替换（调用方持锁）。
+ * 失败时保持原目录不变。
+ */
+static int compact(RecCatalog *cat)
+{
+    char tmp[520];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", cat->path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOGW("[%s] compact: open %s failed: %s", TAG, tmp, strerror(errno));
+        return -1;
+    }
+
+    int      rc = write_header(fd);
+    uint64_t bytes = sizeof(RecCatalogHeader);
+    uint8_t  buf[sizeof(RecCatalogRecord) + REC_CATALOG_MAX_PATH + 8];
+    for (uint32_t i = 0; i < cat->nsegs && rc == 0; i++) {
+        const RecCatalogSeg *s = &cat->segs[i];
+        if (s->deleted) continue;
+        size_t n = record_build(buf, RECCAT_SEG_OPEN, s->id, s->t_start, 0,
+                                ((uint32_t)s->kind << 16) | s->index, s->path);
+        rc = write_all(fd, buf, n);
+        bytes += n;
+        for (uint32_t k = 0; k < s->nkeys && rc == 0; k++) {
+            n = record_build(buf, RECCAT_KEY, s->id, s->keys[k].t_us, s->keys[k].offset, 0, NULL);
+            rc = write_all(fd, buf, n);
+            bytes += n;
+        }
+        if (!s->open && rc == 0) {
+            n = record_build(buf, RECCAT_SEG_CLOSE, s->id, s->t_end, s->bytes, 0, NULL);
+            rc = write_all(fd, buf, n);
+            bytes += n;
+        }
+    }
+    if (rc == 0) rc = fdatasync(fd);
+    close(fd);
+    if (rc == 0) rc = rename(tmp, cat->path);
+    if (rc != 0) {
+        LOGW("[%s] compact failed: %s", TAG, strerror(errno));
+        unlink(tmp);
+        return -1;
+    }
+    fsync_dir_of(cat->path);
+
+    int nfd = open(cat->path, O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (nfd < 0) {
+        LOGE("[%s] reopen after compact failed: %s", TAG, strerror(errno));
+        return -1;
+    }
+    if (cat->fd >= 0) close(cat->fd);
+    cat->fd = nfd;
+
+    /* 内存索引同步去掉墓碑段，重建各流的段下标 */
+    uint32_t w = 0;
+    for (int i = 0; i < cat->nstreams; i++) cat->streams[i].nsegs = 0;
+    for (uint32_t i = 0; i < cat->nsegs; i++) {
+        RecCatalogSeg *s = &cat->segs[i];
+        if (s->deleted) {
+            free(s->path);
+            free(s->keys);
+            continue;
+        }
+        cat->segs[w] = *s;
+        stream_push(stream_get(cat, s->kind, s->index, true), w);
+        w++;
+    }
+    LOGI("[%s] compacted: %u dead segments dropped, %llu -> %llu bytes", TAG, cat->dead,
+         (unsigned long long)cat->log_bytes, (unsigned long long)bytes);
+    cat->nsegs     = w;
+    cat->dead      = 0;
+    cat->log_bytes = bytes;
+    return 0;
+}
+
+static void maybe_compact(RecCatalog *cat)
+{
+    if (cat->dead >= COMPACT_MIN_DEAD && cat->dead > cat->live)
+        compact(cat);
+}
+
+/*
+ * 崩溃恢复（可写打开时）：补记未关闭段、重做删除。
+ */
+static void recover(RecCatalog *cat)
+{
+    int closed = 0;
+    for (uint32_t i = 0; i < cat->nsegs; i++) {
+        RecCatalogSeg *s = &cat->segs[i];
+        if (s->deleted) {
+            unlink_segment(s->path);    /* 删除记录已落盘而文件可能还在 */
+            continue;
+        }
+        if (!s->open) continue;
+        struct stat st;
+        uint64_t bytes = stat(s->path, &st) == 0 ? (uint64_t)st.st_size : s->bytes;
+        seg_set_closed(cat, s, s->t_end, bytes);
+        append_rec(cat, RECCAT_SEG_CLOSE, s->id, s->t_end, bytes, 0, NULL);
+        closed++;
+    }
+    if (closed) {
+        fdatasync(cat->fd);
+        LOGW("[%s] closed %d segment(s) left open by an unclean shutdown", TAG, closed);
+    }
+}
+
+/* ============================================================================
+ * 对外接口
+ * ============================================================================ */
+
+int rec_catalog_open(RecCatalog *cat, const char *path, bool writable)
+{
+    if (!cat || !path) return -1;
+
+    memset(cat, 0, sizeof(*cat));
+    cat->fd       = -1;
+    cat->writable = writable;
+    pthread_mutex_init(&cat->mtx, NULL);
+    int n = snprintf(cat->path, sizeof(cat->path), "%s", path);
+    if (n < 0 || (size_t)n >= sizeof(cat->path)) {
+        LOGE("[%s] path too long: %s", TAG, path);
+        pthread_mutex_destroy(&cat->mtx);
+        return -1;
+    }
+
+    int fd = open(path, writable ? (O_RDWR | O_CREAT | O_CLOEXEC) : (O_RDONLY | O_CLOEXEC), 0644);
+    if (fd < 0) {
+        LOGE("[%s] open failed: %s (%s)", TAG, path, strerror(errno));
+        pthread_mutex_destroy(&cat->mtx);
+        return -1;
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+    if (writable && st.st_size == 0) {
+        if (write_header(fd) != 0 || fdatasync(fd) != 0) {
+            LOGE("[%s] write header failed: %s", TAG, path);
+            close(fd);
+            pthread_mutex_destroy(&cat->mtx);
+            return -1;
+        }
+        st.st_size = sizeof(RecCatalogHeader);
+    }
+
+    uint64_t t0 = rkav_now_monotonic_us();
+    uint64_t valid_end = 0;
+    if (replay(cat, fd, &valid_end) != 0) {
+        LOGE("[%s] not a catalog (bad header): %s", TAG, path);
+        index_free(cat);
+        close(fd);
+        pthread_mutex_destroy(&cat->mtx);
+        return -1;
+    }
+
+    if (!writable) {
+        close(fd);
+    } else {
+        if (valid_end < (uint64_t)st.st_size) {
+            LOGW("[%s] dropped %llu byte(s) of torn tail", TAG,
+                 (unsigned long long)((uint64_t)st.st_size - valid_end));
+            if (ftruncate(fd, (off_t)valid_end) != 0)
+                LOGW("[%s] truncate failed: %s", TAG, strerror(errno));
+        }
+        close(fd);
+        cat->fd = open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+        if (cat->fd < 0) {
+            LOGE("[%s] reopen failed: %s (%s)", TAG, path, strerror(errno));
+            index_free(cat);
+            pthread_mutex_destroy(&cat->mtx);
+            return -1;
+        }
+        cat->log_bytes = valid_end;
+        recover(cat);
+        maybe_compact(cat);
+    }
+
+    LOGI("[%s] opened: %s segments=%u streams=%d bytes=%.1fMB replay=%.1fms", TAG, path,
+         cat->live, cat->nstreams, (double)cat->live_bytes / (1024.0 * 1024.0),
+         (double)(rkav_now_monotonic_us() - t0) / 1000.0);
+    return 0;
+}
+
+int64_t rec_catalog_seg_open(RecCatalog *cat, int kind, int index, const char *path, uint64_t pts_us)
+{
+    if (!cat || !path || cat->fd < 0) return -1;
+    if (strlen(path) >= REC_CATALOG_MAX_PATH) {
+        LOGW("[%s] segment path too long: %s", TAG, path);
+        return -1;
+    }
+
+    pthread_mutex_lock(&cat->mtx);
+    cat->wall_off_us = (int64_t)rec_catalog_now_us() - (int64_t)rkav_now_monotonic_us();
+    uint64_t t_us = (uint64_t)((int64_t)pts_us + cat->wall_off_us);
+
+    /* 同路径的旧段即将被覆盖 */
+    int over = 0;
+    for (uint32_t i = 0; i < cat->nsegs; i++) {
+        RecCatalogSeg *s = &cat->segs[i];
+        if (s->deleted || strcmp(s->path, path) != 0) continue;
+        if (append_rec(cat, RECCAT_SEG_DELETE, s->id, t_us, 0, 0, NULL) == 0) {
+            seg_set_deleted(cat, s);
+            over++;
+        }
+    }
+
+    uint32_t id = cat->next_id;
+    int64_t  ret = -1;
+    if (append_rec(cat, RECCAT_SEG_OPEN, id, t_us, 0,
+                   ((uint32_t)kind << 16) | ((uint32_t)index & 0xFFFFu), path) == 0 &&
+        fdatasync(cat->fd) == 0 &&
+        seg_add(cat, id, kind, index, path, t_us) != NULL) {
+        ret = id;
+    }
+    cat->next_id = id + 1;
+    if (over) maybe_compact(cat);
+    pthread_mutex_unlock(&cat->mtx);
+
+    if (ret < 0) LOGW("[%s] segment open failed: %s", TAG, path);
+    return ret;
+}
+
+int rec_catalog_key(RecCatalog *cat, uint32_t seg_id, uint64_t pts_us, uint64_t offset)
+{
+    if (!cat || cat->fd < 0) return -1;
+
+    pthread_mutex_lock(&cat->mtx);
+    uint64_t t_us = (uint64_t)((int64_t)pts_us + cat->wall_off_us);
+    int rc = append_rec(cat, RECCAT_KEY, seg_id, t_us, offset, 0, NULL);
+    RecCatalogSeg *s = seg_by_id(cat, seg_id);
+    if (rc == 0 && s) seg_add_key(cat, s, t_us, offset);
+    pthread_mutex_unlock(&cat->mtx);
+    return rc;
+}
+
+int rec_catalog_seg_close(RecCatalog *cat, uint32_t seg_id, uint64_t pts_us, uint64_t bytes)
+{
+    if (!cat || cat->fd < 0) return -1;
+
+    pthread_mutex_lock(&cat->mtx);
+    uint64_t t_us = (uint64_t)((int64_t)pts_us + cat->wall_off_us);
+    int rc = append_rec(cat, RECCAT_SEG_CLOSE, seg_id, t_us, bytes, 0, NULL);
+    if (rc == 0) rc = fdatasync(cat->fd);
+    RecCatalogSeg *s = seg_by_id(cat, seg_id);
+    if (rc == 0 && s) seg_set_closed(cat, s, t_us, bytes);
+    pthread_mutex_unlock(&cat->mtx);
+    return rc;
+}
+
+int rec_catalog_retain(RecCatalog *cat, uint32_t max_age_sec, uint64_t max_bytes)
+{
+    if (!cat || cat->fd < 0) return -1;
+    if (!max_age_sec && !max_bytes) return 0;
+
+    pthread_mutex_lock(&cat->mtx);
+    uint64_t now = rec_catalog_now_us();
+    uint64_t cutoff = max_age_sec && now > (uint64_t)max_age_sec * 1000000ull
+                    ? now - (uint64_t)max_age_sec * 1000000ull : 0;
+
+    /* 先写墓碑并落盘，再删文件：崩溃后重放会重做删除 */
+    uint32_t first = 0, last = 0;
+    int      count = 0, rc = 0;
+    uint64_t bytes = cat->live_bytes;
+    for (uint32_t i = 0; i < cat->nsegs; i++) {
+        RecCatalogSeg *s = &cat->segs[i];
+        if (s->deleted || s->open) continue;
+        bool old  = cutoff && s->t_end < cutoff;
+        bool full = max_bytes && bytes > max_bytes;
+        if (!old && !full) break;
+        if (append_rec(cat, RECCAT_SEG_DELETE, s->id, now, 0, 0, NULL) != 0) {
+            rc = -1;
+            break;
+        }
+        if (!count) first = i;
+        last = i;
+        bytes -= s->bytes;
+        count++;
+    }
+    if (count && fdatasync(cat->fd) != 0) rc = -1;
+
+    uint64_t freed = 0;
+    for (uint32_t i = first; count && rc == 0 && i <= last; i++) {
+        RecCatalogSeg *s = &cat->segs[i];
+        if (s->deleted || s->open) continue;
+        freed += s->bytes;
+        unlink_segment(s->path);
+        seg_set_deleted(cat, s);
+    }
+    if (count && rc == 0) {
+        LOGI("[%s] retention removed %d segment(s), %.1fMB (live=%u %.1fMB)", TAG, count,
+             (double)freed / (1024.0 * 1024.0), cat->live,
+             (double)cat->live_bytes / (1024.0 * 1024.0));
+        maybe_compact(cat);
+    }
+    pthread_mutex_unlock(&cat->mtx);
+    return rc == 0 ? count : -1;
+}
+
+/* 段内最后一个 t_us <= t 的关键帧下标，没有返回 -1 */
+static int64_t key_at_or_before(const RecCatalogSeg *s, uint64_t t)
+{
+    uint32_t lo = 0, hi = s->nkeys;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (s->keys[mid].t_us <= t) lo = mid + 1;
+        else hi = mid;
+    }
+    return (int64_t)lo - 1;
+}
+
+int rec_catalog_query(RecCatalog *cat, int kind, int index, uint64_t t0_us, uint64_t t1_us,
+                      RecCatalogHit *hits, int max)
+{
+    if (!cat || t1_us < t0_us) return 0;
+
+    pthread_mutex_lock(&cat->mtx);
+    RecCatalogStream *st = stream_get(cat, kind, index, false);
+    int count = 0;
+    if (st) {
+        /* 流内段按时间排列且互不重叠：找第一个结束时间 >= t0 的段（写入中的段视为无限长） */
+        uint32_t lo = 0, hi = st->nsegs;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            const RecCatalogSeg *s = &cat->segs[st->segs[mid]];
+            if (!s->open && s->t_end < t0_us) lo = mid + 1;
+            else hi = mid;
+        }
+
+        for (uint32_t i = lo; i < st->nsegs; i++) {
+            const RecCatalogSeg *s = &cat->segs[st->segs[i]];
+            if (s->t_start > t1_us) break;
+            if (s->deleted) continue;
+            if (count < max && hits) {
+                RecCatalogHit *h = &hits[count];
+                h->path         = s->path;
+                h->seg_id       = s->id;
+                h->seg_start_us = s->t_start;
+                h->seg_end_us   = s->t_end;
+                h->open         = s->open;
+                h->key_us       = s->t_start;
+                h->off_begin    = 0;
+                h->off_end      = s->bytes;
+
+                int64_t k = key_at_or_before(s, t0_us);
+                if (t0_us > s->t_start && k >= 0) {
+                    h->key_us    = s->keys[k].t_us;
+                    h->off_begin = s->keys[k].offset;
+                }
+                int64_t e = key_at_or_before(s, t1_us) + 1;
+                if (!s->open && e < (int64_t)s->nkeys) h->off_end = s->keys[e].offset;
+            }
+            count++;
+        }
+    }
+    pthread_mutex_unlock(&cat->mtx);
+    return count;
+}
+
+void rec_catalog_close(RecCatalog *cat)
+{
+    if (!cat) return;
+    pthread_mutex_lock(&cat->mtx);
+    if (cat->fd >= 0) {
+        fdatasync(cat->fd);
+        close(cat->fd);
+        cat->fd = -1;
+        LOGI("[%s] closed: %s segments=%u bytes=%.1fMB", TAG, cat->path, cat->live,
+             (double)cat->live_bytes / (1024.0 * 1024.0));
+    }
+    index_free(cat);
+    pthread_mutex_unlock(&cat->mtx);
+    pthread_mutex_destroy(&cat->mtx);
+}
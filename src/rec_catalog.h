@@ -0,0 +1,219 @@
+/**
+ * @file rec_catalog.h
+ * @brief 录像目录（catalog）模块头文件
+ *
+ * 录像按 --segment-sec 分段、多路流各写各的文件之后，“h264 流 14:03~14:05 在哪些文件、从哪个字节开始”
+ * 不应靠遍历目录回答。本模块维护一个只追加的二进制目录文件，由各 sink 在写盘时更新：
+ *
+ *   (流, 时间区间) -> (段文件, 关键帧偏移)
+ *
+ * 目录文件同时是预写日志（WAL）：每条记录自带 CRC32C，打开时顺序重放，撕裂的尾部截断丢弃。
+ * - SEG_OPEN  在创建段文件之前写入并 fdatasync
+ * - KEY       每个关键帧（音频约每秒一个）一条，写入页缓存，随下一次 fdatasync 落盘
+ * - SEG_CLOSE 段文件关闭后写入并 fdatasync（崩溃遗留的未关闭段在下次打开时按文件实际大小补记）
+ * - SEG_DELETE 在删除段文件之前写入并 fdatasync（崩溃后重放时重做删除）
+ *
+ * 记录按写入时间排列，因此每条流的段天然按起始时间有序，段内关键帧按时间有序（sorted run）：
+ * 打开时重建内存索引，查询为两次二分查找（流内段 -> 段内关键帧），与目录大小无关，远低于 1ms。
+ * 保留策略删除段时只追加墓碑，不扫描文件系统；墓碑超过存活段数时整体重写（压实）目录并原子替换。
+ *
+ * 时间均为墙钟微秒（CLOCK_REALTIME），由各段打开时刻的 墙钟 - 单调时钟 差值从 PTS 换算。
+ *
+ * 文件布局（小端）：RecCatalogHeader + N × (RecCatalogRecord [+ 路径，补齐到 8 字节])
+ */
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 目录文件魔数 */
+#define REC_CATALOG_MAGIC    "RKCT"
+
+/** 目录格式版本 */
+#define REC_CATALOG_VERSION  1
+
+/** 段文件路径最大长度（含结尾 0） */
+#define REC_CATALOG_MAX_PATH 256
+
+/** 最多区分的流数（媒体类型 × 序号） */
+#define REC_CATALOG_MAX_STREAMS 16
+
+/**
+ * @brief 记录类型
+ */
+typedef enum {
+    RECCAT_SEG_OPEN   = 1,  /**< 新段：t_us = 起始时间，aux = 流，路径跟随其后 */
+    RECCAT_KEY        = 2,  /**< 关键帧：t_us = 时间，val = 段内字节偏移 */
+    RECCAT_SEG_CLOSE  = 3,  /**< 段结束：t_us = 结束时间，val = 段文件字节数 */
+    RECCAT_SEG_DELETE = 4,  /**< 段删除（墓碑）：t_us = 删除时间 */
+} RecCatalogRecType;
+
+/**
+ * @brief 目录文件头（16 字节）
+ */
+typedef struct {
+    char     magic[4];      /**< "RKCT" */
+    uint16_t version;       /**< REC_CATALOG_VERSION */
+    uint16_t rec_size;      /**< sizeof(RecCatalogRecord) */
+    uint32_t reserved;
+    uint32_t hdr_crc;       /**< 前 12 字节的 CRC32C */
+} RecCatalogHeader;
+
+/**
+ * @brief 目录记录定长部分（32 字节）
+ *
+ * rec_crc 覆盖前 28 字节及随后的 path_len 字节路径。
+ */
+typedef struct {
+    uint16_t type;          /**< RecCatalogRecType */
+    uint16_t path_len;      /**< 路径字节数（仅 SEG_OPEN，不含结尾 0） */
+    uint32_t seg_id;        /**< 段号（目录内单调递增） */
+    uint64_t t_us;          /**< 墙钟时间（微秒） */
+    uint64_t val;           /**< 偏移 / 字节数 */
+    uint32_t aux;           /**< SEG_OPEN：低 16 位流序号，高 16 位媒体类型（RecIndexKind） */
+    uint32_t rec_crc;
+} RecCatalogRecord;
+
+/**
+ * @brief 段内关键帧点
+ */
+typedef struct {
+    uint64_t t_us;          /**< 墙钟时间 */
+    uint64_t offset;        /**< 段内字节偏移 */
+} RecCatalogKey;
+
+/**
+ * @brief 一个段（内存索引）
+ */
+typedef struct {
+    uint32_t       id;
+    uint16_t       kind;        /**< 媒体类型（RecIndexKind） */
+    uint16_t       index;       /**< 同类型流的序号 */
+    char          *path;        /**< 段文件路径 */
+    uint64_t       t_start;     /**< 起始时间 */
+    uint64_t       t_end;       /**< 结束时间（未关闭时为最后一个关键帧时间） */
+    uint64_t       bytes;       /**< 段文件字节数（未关闭时为最后一个关键帧偏移） */
+    bool           open;        /**< 尚未关闭 */
+    bool           deleted;     /**< 已删除（墓碑） */
+    RecCatalogKey *keys;
+    uint32_t       nkeys, cap_keys;
+} RecCatalogSeg;
+
+/**
+ * @brief 一条流：按起始时间排列的段下标
+ */
+typedef struct {
+    uint16_t  kind;
+    uint16_t  index;
+    uint32_t *segs;             /**< RecCatalog::segs 下标 */
+    uint32_t  nsegs, cap;
+} RecCatalogStream;
+
+/**
+ * @brief 目录上下文（多个 sink 线程共享，内部加锁）
+ */
+typedef struct {
+    pthread_mutex_t  mtx;
+    int              fd;            /**< 目录文件（只读打开时为 -1） */
+    bool             writable;
+    char             path[512];
+
+    RecCatalogSeg   *segs;          /**< 按段号（即创建时间）排列 */
+    uint32_t         nsegs, cap_segs;
+    RecCatalogStream streams[REC_CATALOG_MAX_STREAMS];
+    int              nstreams;
+
+    uint32_t         next_id;       /**< 下一个段号 */
+    uint32_t         live;          /**< 存活段数 */
+    uint32_t         dead;          /**< 墓碑段数（压实后清零） */
+    uint64_t         live_bytes;    /**< 存活段总字节数 */
+    uint64_t         log_bytes;     /**< 目录文件当前长度 */
+    int64_t          wall_off_us;   /**< 墙钟 - 单调时钟（最近一次段打开时采样） */
+} RecCatalog;
+
+/**
+ * @brief 查询结果：一个段内的字节区间
+ */
+typedef struct {
+    const char *path;           /**< 段文件路径（指向目录内部，目录关闭前有效） */
+    uint32_t    seg_id;
+    uint64_t    seg_start_us;   /**< 段起始时间 */
+    uint64_t    seg_end_us;     /**< 段结束时间 */
+    uint64_t    key_us;         /**< 起点关键帧时间（<= 查询起点，段首之前为段起始时间） */
+    uint64_t    off_begin;      /**< 从该偏移开始读（关键帧起点） */
+    uint64_t    off_end;        /**< 读到该偏移为止（查询终点之后的第一个关键帧或段尾） */
+    bool        open;           /**< 段尚在写入 */
+} RecCatalogHit;
+
+/**
+ * @brief 打开目录并重放
+ *
+ * 可写打开时：文件不存在则创建；截断撕裂的尾部，补记崩溃遗留的未关闭段，重做未完成的删除，
+ * 墓碑过多时压实。只读打开（查询工具）不修改任何文件。
+ *
+ * @return int 0 成功，-1 失败
+ */
+int  rec_catalog_open(RecCatalog *cat, const char *path, bool writable);
+
+/**
+ * @brief 登记一个新段（在创建段文件之前调用）
+ *
+ * 同路径的存活段视为被覆盖，先记为删除。
+ *
+ * @param kind   媒体类型（RecIndexKind）
+ * @param index  同类型流的序号
+ * @param path   段文件路径
+ * @param pts_us 段内首个数据的 PTS（单调时钟）
+ * @return int64_t 段号，-1 失败
+ */
+int64_t rec_catalog_seg_open(RecCatalog *cat, int kind, int index, const char *path, uint64_t pts_us);
+
+/**
+ * @brief 记录一个关键帧（段内可随机访问的起点）
+ *
+ * @return int 0 成功，-1 写失败
+ */
+int  rec_catalog_key(RecCatalog *cat, uint32_t seg_id, uint64_t pts_us, uint64_t offset);
+
+/**
+ * @brief 段文件关闭后登记结束时间与大小
+ *
+ * @return int 0 成功，-1 写失败
+ */
+int  rec_catalog_seg_close(RecCatalog *cat, uint32_t seg_id, uint64_t pts_us, uint64_t bytes);
+
+/**
+ * @brief 保留策略：从最早的已关闭段开始删除（段文件及其 .idx）
+ *
+ * @param max_age_sec 结束时间早于 now - max_age_sec 的段删除，0 不限
+ * @param max_bytes   存活段总字节数超过该值时删除最早的段，0 不限
+ * @return int 删除的段数，-1 写目录失败
+ */
+int  rec_catalog_retain(RecCatalog *cat, uint32_t max_age_sec, uint64_t max_bytes);
+
+/**
+ * @brief 查询一条流在 [t0_us, t1_us] 内的录像
+ *
+ * 首段从 t0 之前最近的关键帧开始，末段截止到 t1 之后的第一个关键帧。
+ *
+ * @param hits 输出数组
+ * @param max  数组容量
+ * @return int 命中的段数（可能大于 max，只填前 max 个）
+ */
+int  rec_catalog_query(RecCatalog *cat, int kind, int index, uint64_t t0_us, uint64_t t1_us,
+                       RecCatalogHit *hits, int max);
+
+/** 关闭目录并释放内存索引 */
+void rec_catalog_close(RecCatalog *cat);
+
+/** 当前墙钟时间（微秒） */
+uint64_t rec_catalog_now_us(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,98 @@
+/**
+ * @file rec_crypt.h
+ * @brief 录像落盘加密模块头文件
+ *
+ * 可拔插 SD 卡上的录像必须加密。sink 在写盘前把数据加密到暂存缓冲再写出（编码包与直播共享，
+ * 不能原地改写），不经外部进程、不多一次拷贝。
+ *
+ * 加密文件布局：RecCryptHeader（32 字节）+ 密文
+ * - 算法 AES-256-CTR，计数器块 = 文件头中的 8 字节随机 nonce || 64 位大端块号
+ * - 块号按明文偏移计算（offset / 16）：.idx 与录像目录中的偏移仍是明文偏移，
+ *   文件位置 = 明文偏移 + sizeof(RecCryptHeader)；任意 16 字节块都可单独解密，支持随机定位
+ * - 每个文件（每个分段）各自生成 nonce，同一密钥下计数器流不会复用
+ * - 文件头带密钥校验值（AES_k(0) 前 8 字节），解密前即可发现密钥不符
+ *
+ * CTR 不带认证：完整性由 .idx 中每包明文 CRC32C 校验（tools/rkav_verify -k）。
+ * .idx 与录像目录本身不加密（只含偏移 / 时间 / CRC）。
+ */
+#pragma once
+
+#include "aes256.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 加密文件魔数 */
+#define REC_CRYPT_MAGIC    "RKEN"
+
+/** 加密文件格式版本 */
+#define REC_CRYPT_VERSION  1
+
+/** 算法：AES-256-CTR */
+#define REC_CRYPT_AES256_CTR  1
+
+/**
+ * @brief 加密文件头（32 字节，位于文件起始）
+ */
+typedef struct {
+    char     magic[4];      /**< "RKEN" */
+    uint16_t version;       /**< REC_CRYPT_VERSION */
+    uint16_t alg;           /**< REC_CRYPT_AES256_CTR */
+    uint8_t  nonce[8];      /**< 本文件的随机 nonce */
+    uint8_t  key_check[8];  /**< 密钥校验值：AES_k(0^128) 前 8 字节 */
+    uint32_t reserved;
+    uint32_t hdr_crc;       /**< 前 28 字节的 CRC32C */
+} RecCryptHeader;
+
+/**
+ * @brief 已加载的密钥（只读，可被多个 sink 线程共享）
+ */
+typedef struct {
+    Aes256Key key;
+    uint8_t   key_check[8];
+} RecCryptKey;
+
+/**
+ * @brief 从文件加载 256 位密钥
+ *
+ * 文件内容为 32 字节原始密钥（原样使用，末字节可以是任意值），或 64 个十六进制字符（可带结尾换行）。
+ *
+ * @return int 0 成功，-1 读失败或格式不符
+ */
+int  rec_crypt_load_key(RecCryptKey *k, const char *path);
+
+/**
+ * @brief 为一个新文件生成文件头（随机 nonce）
+ *
+ * @return int 0 成功，-1 取随机数失败
+ */
+int  rec_crypt_new_header(const RecCryptKey *k, RecCryptHeader *hdr);
+
+/**
+ * @brief 校验文件头
+ *
+ * @param k 密钥（NULL 时只校验格式）
+ * @return int 0 有效，-1 不是加密文件或头损坏，-2 密钥不符
+ */
+int  rec_crypt_check_header(const RecCryptKey *k, const RecCryptHeader *hdr);
+
+/**
+ * @brief 加 / 解密一段数据
+ *
+ * @param offset in[0] 的明文偏移（不含文件头）
+ * @param in     输入
+ * @param out    输出（可与 in 相同）
+ */
+static inline void rec_crypt_apply(const RecCryptKey *k, const RecCryptHeader *hdr, uint64_t offset,
+                                   const uint8_t *in, uint8_t *out, size_t len)
+{
+    aes256_ctr(&k->key, hdr->nonce, offset, in, out, len);
+}
+
+#ifdef __cplusplus
+}
+#endif
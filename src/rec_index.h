@@ -0,0 +1,117 @@
+/**
+ * @file rec_index.h
+ * @brief 录像索引（sidecar）模块头文件
+ *
+ * 每个录像文件旁边写一个 "<媒体文件>.idx"，每写入一个包/音频块追加一条定长记录：
+ * 偏移、长度、PTS、数据 CRC32C、标志。记录本身也带 CRC32C，索引损坏可被识别。
+ *
+ * 用 tools/rkav_verify 顺序扫描媒体文件并逐条比对 CRC，即可定位损坏区间；
+ * 结合 RECIDX_F_PREWRITE_BAD（写盘前复核失败）可区分“写入前已损坏”与“落盘后损坏”。
+ *
+ * 记录顺序即写盘顺序（视频为解码顺序）；编码器重排序时视频记录的 PTS 可能不单调。
+ *
+ * 文件布局（小端）：RecIndexHeader + N × RecIndexEntry
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 索引文件魔数 */
+#define REC_INDEX_MAGIC    "RKIX"
+
+/** 索引格式版本 */
+#define REC_INDEX_VERSION  1
+
+/** 记录标志：关键帧 */
+#define RECIDX_F_KEYFRAME      0x1u
+/** 记录标志：写盘前复核 CRC 不一致（数据在进入 sink 之前已损坏） */
+#define RECIDX_F_PREWRITE_BAD  0x2u
+/** 记录标志：低延迟模式下的帧内分片，且不是该帧最后一片（同帧各片 PTS 相同） */
+#define RECIDX_F_PARTIAL       0x4u
+
+/**
+ * @brief 被索引的媒体类型
+ */
+typedef enum {
+    REC_INDEX_H264 = 1,     /**< H.264 Annex-B 裸流，一条记录 = 一个 EncodedPacket */
+    REC_INDEX_PCM  = 2,     /**< 交错 PCM，一条记录 = 一个 AudioChunk */
+} RecIndexKind;
+
+/**
+ * @brief 索引文件头（16 字节）
+ */
+typedef struct {
+    char     magic[4];      /**< "RKIX" */
+    uint16_t version;       /**< REC_INDEX_VERSION */
+    uint16_t kind;          /**< RecIndexKind */
+    uint32_t rec_size;      /**< sizeof(RecIndexEntry) */
+    uint32_t hdr_crc;       /**< 前 12 字节的 CRC32C */
+} RecIndexHeader;
+
+/**
+ * @brief 索引记录（32 字节）
+ */
+typedef struct {
+    uint64_t offset;        /**< 在媒体文件中的字节偏移 */
+    uint64_t pts_us;        /**< 包/块 PTS */
+    uint32_t size;          /**< 字节数 */
+    uint32_t crc32c;        /**< 数据 CRC32C（在数据产生处计算） */
+    uint32_t flags;         /**< RECIDX_F_* */
+    uint32_t rec_crc;       /**< 本记录前 28 字节的 CRC32C */
+} RecIndexEntry;
+
+/**
+ * @brief 索引写入器
+ */
+typedef struct {
+    FILE        *fp;        /**< 索引文件 */
+    RecIndexKind kind;      /**< 媒体类型 */
+    uint64_t     entries;   /**< 已写记录数 */
+    char         path[512]; /**< 索引文件路径 */
+} RecIndex;
+
+/**
+ * @brief 创建 "<media_path>.idx" 并写入文件头
+ *
+ * @return int 0 成功，-1 失败
+ */
+int  rec_index_open(RecIndex *ri, const char *media_path, RecIndexKind kind);
+
+/**
+ * @brief 追加一条记录
+ *
+ * @param ri     索引写入器
+ * @param offset 数据在媒体文件中的偏移
+ * @param size   数据长度
+ * @param crc    数据 CRC32C
+ * @param pts_us PTS
+ * @param flags  RECIDX_F_*
+ * @return int   0 成功，-1 写失败
+ */
+int  rec_index_append(RecIndex *ri, uint64_t offset, uint32_t size, uint32_t crc,
+                      uint64_t pts_us, uint32_t flags);
+
+/** 刷新并关闭索引文件 */
+void rec_index_close(RecIndex *ri);
+
+/**
+ * @brief 读取并校验索引文件头
+ *
+ * @return int 0 成功，-1 读失败或格式不符
+ */
+int  rec_index_read_header(FILE *fp, RecIndexHeader *hdr);
+
+/** 校验记录自身的 rec_crc，1 有效，0 损坏 */
+int  rec_index_entry_valid(const RecIndexEntry *e);
+
+/** 媒体类型名称（"h264" / "pcm"） */
+const char *rec_index_kind_name(RecIndexKind kind);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,637 @@
+/**
+ * @file rtp.c
+ * @brief RTP/UDP H.264 输出与 FEC 修复包实现
+ */
+#include "rtp.h"
+#include "rkav/packet.h"
+#include "rkav/time.h"
+#include "log.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define TAG "rtp"
+
+/** FU-A 分片每片负载（去掉 FU indicator / header） */
+#define RTP_FU_CHUNK    (RTP_MAX_PAYLOAD - 2)
+
+static void put_be16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static uint16_t get_be16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t get_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+/* 从 from 开始查找下一个 00 00 01，返回其位置（找不到返回 n） */
+static size_t find_start_code(const uint8_t *d, size_t n, size_t from)
+{
+    for (size_t i = from; i + 3 <= n; i++) {
+        if (d[i + 2] > 1) {
+            i += 2;
+            continue;
+        }
+        if (d[i] == 0 && d[i + 1] == 0 && d[i + 2] == 1)
+            return i;
+    }
+    return n;
+}
+
+/* 媒体包 -> 符号，返回符号长度 */
+static size_t sym_from_pkt(uint8_t *sym, const uint8_t *pkt, size_t len)
+{
+    size_t plen = len - RTP_HDR_LEN;
+    put_be16(sym, (uint16_t)plen);
+    sym[2] = pkt[0];
+    sym[3] = pkt[1];
+    memcpy(sym + 4, pkt + 4, 4);
+    memcpy(sym + RTP_SYM_HDR_LEN, pkt + RTP_HDR_LEN, plen);
+    return RTP_SYM_HDR_LEN + plen;
+}
+
+/* 符号 -> 媒体包，返回包长（符号内容不合法返回 0） */
+static size_t pkt_from_sym(uint8_t *pkt, const uint8_t *sym, size_t sym_len, uint16_t seq,
+                           uint32_t ssrc)
+{
+    size_t plen = get_be16(sym);
+    if (plen > RTP_MAX_PAYLOAD || RTP_SYM_HDR_LEN + plen > sym_len) return 0;
+    pkt[0] = sym[2];
+    pkt[1] = sym[3];
+    put_be16(pkt + 2, seq);
+    memcpy(pkt + 4, sym + 4, 4);
+    put_be32(pkt + 8, ssrc);
+    memcpy(pkt + RTP_HDR_LEN, sym + RTP_SYM_HDR_LEN, plen);
+    return RTP_HDR_LEN + plen;
+}
+
+/* ============================================================================
+ * 发送端
+ * ============================================================================ */
+
+static void tx_send(RtpSender *s, const uint8_t *buf, size_t len)
+{
+    if (send(s->fd, buf, len, 0) < 0) {
+        /* 对端未监听时 connect 过的 UDP socket 会报 ECONNREFUSED，不影响后续发送 */
+        atomic_fetch_add(&s->send_errs, 1);
+    }
+}
+
+/* 编码并发出当前组的修复包 */
+static void tx_flush_block(RtpSender *s)
+{
+    int k = s->blk_n;
+    s->blk_n = 0;
+    if (k == 0) return;
+
+    int m = 1;
+    if (s->scheme == FEC_RS) {
+        m = (k * s->blk_pct + 99) / 100;
+        if (m < 1) m = 1;
+        if (m > FEC_MAX_M) m = FEC_MAX_M;
+    }
+
+    size_t len = 0;
+    for (int i = 0; i < k; i++)
+        if (s->sym_len[i] > len) len = s->sym_len[i];
+    for (int i = 0; i < k; i++)
+        memset(s->sym[i] + s->sym_len[i], 0, len - s->sym_len[i]);
+
+    uint64_t t0 = rkav_now_monotonic_ns();
+    if (fec_encode(s->scheme, k, m, (const uint8_t *const *)s->sym, s->par, len) != 0)
+        return;
+    atomic_fetch_add(&s->fec_ns, rkav_now_monotonic_ns() - t0);
+    atomic_fetch_add(&s->fec_in_bytes, (uint64_t)k * len);
+
+    for (int j = 0; j < m; j++) {
+        uint8_t *p = s->pkt;
+        p[0] = 0x80;
+        p[1] = RTP_PT_FEC;
+        put_be16(p + 2, s->fec_seq++);
+        put_be32(p + 4, s->blk_ts);
+        put_be32(p + 8, s->fec_ssrc);
+
+        uint8_t *h = p + RTP_HDR_LEN;
+        put_be16(h, s->blk_base);
+        h[2] = (uint8_t)k;
+        h[3] = (uint8_t)m;
+        h[4] = (uint8_t)j;
+        h[5] = (uint8_t)s->scheme;
+        put_be16(h + 6, (uint16_t)len);
+        put_be32(h + 8, s->ssrc);
+        memcpy(h + RTP_FEC_HDR_LEN, s->par[j], len);
+
+        size_t total = RTP_HDR_LEN + RTP_FEC_HDR_LEN + len;
+        tx_send(s, p, total);
+        atomic_fetch_add(&s->fec_pkts, 1);
+        atomic_fetch_add(&s->fec_bytes, total);
+    }
+}
+
+/* 发出一个媒体包：负载为 pre（0 ~ 2 字节 FU 头）+ body */
+static void tx_media(RtpSender *s, const uint8_t *pre, size_t pre_len, const uint8_t *body,
+                     size_t body_len, bool marker, uint32_t ts)
+{
+    uint8_t *p = s->pkt;
+    p[0] = 0x80;
+    p[1] = (uint8_t)((marker ? 0x80 : 0) | RTP_PT_H264);
+    put_be16(p + 2, s->seq);
+    put_be32(p + 4, ts);
+    put_be32(p + 8, s->ssrc);
+    if (pre_len) memcpy(p + RTP_HDR_LEN, pre, pre_len);
+    memcpy(p + RTP_HDR_LEN + pre_len, body, body_len);
+
+    size_t total = RTP_HDR_LEN + pre_len + body_len;
+    tx_send(s, p, total);
+    atomic_fetch_add(&s->media_pkts, 1);
+    atomic_fetch_add(&s->media_bytes, total);
+
+    if (s->blk_k > 0) {
+        if (s->blk_n == 0) {
+            s->blk_base = s->seq;
+            s->blk_ts   = ts;
+        }
+        s->sym_len[s->blk_n] = sym_from_pkt(s->sym[s->blk_n], p, total);
+        if (++s->blk_n == s->blk_k)
+            tx_flush_block(s);
+    }
+    s->seq++;
+}
+
+int rtp_sender_init(RtpSender *s, int fd, FecScheme scheme, const uint8_t *prot)
+{
+    if (!s) return -1;
+    memset(s, 0, sizeof(*s));
+    s->fd     = fd;
+    s->scheme = scheme;
+    if (prot) memcpy(s->prot, prot, sizeof(s->prot));
+
+    uint32_t seed = (uint32_t)rkav_now_monotonic_ns() ^ ((uint32_t)getpid() << 16);
+    s->ssrc     = seed * 2654435761u;
+    s->fec_ssrc = s->ssrc ^ 0x5a5a5a5au;
+    s->seq      = (uint16_t)(seed >> 7);
+    s->fec_seq  = (uint16_t)(seed >> 13);
+
+    if (scheme == FEC_NONE) return 0;
+    uint8_t *mem = (uint8_t *)malloc((size_t)(FEC_MAX_K + FEC_MAX_M) * RTP_SYM_MAX);
+    if (!mem) return -1;
+    for (int i = 0; i < FEC_MAX_K; i++)
+        s->sym[i] = mem + (size_t)i * RTP_SYM_MAX;
+    for (int j = 0; j < FEC_MAX_M; j++)
+        s->par[j] = mem + (size_t)(FEC_MAX_K + j) * RTP_SYM_MAX;
+    return 0;
+}
+
+void rtp_sender_frame(RtpSender *s, const uint8_t *data, size_t size, uint64_t pts_us,
+                      RtpClass cls, bool eoi)
+{
+    if (!s || !data) return;
+
+    /* 帧的第一片决定本帧的分组参数 */
+    if (!s->in_frame) {
+        int pct = (s->scheme != FEC_NONE && cls < RTP_CLS_COUNT) ? s->prot[cls] : 0;
+        s->blk_pct = pct;
+        if (pct == 0)
+            s->blk_k = 0;
+        else if (s->scheme == FEC_XOR)
+            s->blk_k = 100 / pct < 1 ? 1 : (100 / pct > FEC_MAX_K ? FEC_MAX_K : 100 / pct);
+        else
+            s->blk_k = RTP_RS_BLOCK;
+        s->in_frame = true;
+    }
+
+    uint32_t ts = (uint32_t)(pts_us * (RTP_CLOCK_HZ / 1000) / 1000);
+    size_t sc = find_start_code(data, size, 0);
+    while (sc < size) {
+        size_t start = sc + 3;
+        size_t next  = find_start_code(data, size, start);
+        size_t end   = next;
+        while (end > start && data[end - 1] == 0)   /* 下一个 4 字节起始码的前导 0 */
+            end--;
+        sc = next;
+        if (end <= start) continue;
+
+        const uint8_t *nal = data + start;
+        size_t nal_len = end - start;
+        bool last = eoi && next >= size;
+
+        if (nal_len <= RTP_MAX_PAYLOAD) {
+            tx_media(s, NULL, 0, nal, nal_len, last, ts);
+            continue;
+        }
+        /* FU-A：去掉 NAL 头，各片带 FU indicator（NRI + 28）与 FU header（S/E + 类型） */
+        uint8_t fu[2];
+        fu[0] = (uint8_t)((nal[0] & 0xe0) | 28);
+        size_t off = 1;
+        while (off < nal_len) {
+            size_t n = nal_len - off > RTP_FU_CHUNK ? RTP_FU_CHUNK : nal_len - off;
+            bool end_frag = off + n == nal_len;
+            fu[1] = (uint8_t)((off == 1 ? 0x80 : 0) | (end_frag ? 0x40 : 0) | (nal[0] & 0x1f));
+            tx_media(s, fu, 2, nal + off, n, last && end_frag, ts);
+            off += n;
+        }
+    }
+
+    if (eoi) {
+        if (s->blk_k > 0) tx_flush_block(s);
+        s->in_frame = false;
+    }
+}
+
+void rtp_sender_deinit(RtpSender *s)
+{
+    if (!s) return;
+    free(s->sym[0]);
+    memset(s->sym, 0, sizeof(s->sym));
+    memset(s->par, 0, sizeof(s->par));
+}
+
+/* ============================================================================
+ * 输出服务
+ * ============================================================================ */
+
+int rtp_out_init(RtpOut *o, const char *dest, FecScheme scheme, const uint8_t *prot,
+                 int svc_layers)
+{
+    if (!o || !dest) return -1;
+    memset(o, 0, sizeof(*o));
+    o->fd = -1;
+    o->svc_layers = svc_layers > 0 ? svc_layers : 1;
+    snprintf(o->dest, sizeof(o->dest), "%s", dest);
+
+    char host[64];
+    const char *colon = strrchr(dest, ':');
+    if (!colon || colon == dest || (size_t)(colon - dest) >= sizeof(host) || !colon[1]) {
+        LOGE("[%s] invalid destination '%s' (want host:port)", TAG, dest);
+        return -1;
+    }
+    memcpy(host, dest, (size_t)(colon - dest));
+    host[colon - dest] = '\0';
+
+    struct addrinfo hints, *ai = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    int gr = getaddrinfo(host, colon + 1, &hints, &ai);
+    if (gr != 0 || !ai) {
+        LOGE("[%s] resolve '%s' failed: %s", TAG, dest, gai_strerror(gr));
+        return -1;
+    }
+    o->fd = socket(ai->ai_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (o->fd < 0 || connect(o->fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+        LOGE("[%s] socket/connect %s failed: %s", TAG, dest, strerror(errno));
+        freeaddrinfo(ai);
+        if (o->fd >= 0) close(o->fd);
+        o->fd = -1;
+        return -1;
+    }
+    freeaddrinfo(ai);
+
+    if (rtp_sender_init(&o->tx, o->fd, scheme, prot) != 0 ||
+        bq_init(&o->inbox, RTP_INBOX_SIZE) != 0) {
+        LOGE("[%s] out of memory", TAG);
+        rtp_sender_deinit(&o->tx);
+        close(o->fd);
+        o->fd = -1;
+        return -1;
+    }
+
+    LOGI("[%s] sending to %s ssrc=%08x fec=%s (%s)", TAG, dest, o->tx.ssrc,
+         fec_scheme_name(scheme), fec_impl_name());
+    return 0;
+}
+
+void rtp_out_publish(RtpOut *o, EncodedPacket *ep)
+{
+    if (!o || !ep) return;
+
+    /* 丢过参考帧后，后续包在下一个关键帧之前都无法解码，不必发送 */
+    if (o->pub_wait_key && !ep->is_keyframe) {
+        atomic_fetch_add(&o->inbox_drops, 1);
+        atomic_store(&o->want_key, 1);
+        return;
+    }
+    o->pub_wait_key = false;
+
+    encoded_packet_ref(ep);
+    if (bq_try_push(&o->inbox, ep) != 0) {
+        encoded_packet_unref(ep);
+        atomic_fetch_add(&o->inbox_drops, 1);
+        /* 最高时间层不被参考，其余层（含不分层时的 P 帧）丢了就得等关键帧 */
+        if (ep->temporal_id + 1 < o->svc_layers || o->svc_layers == 1) {
+            o->pub_wait_key = true;
+            atomic_store(&o->want_key, 1);
+        }
+    }
+}
+
+void rtp_out_run(RtpOut *o)
+{
+    if (!o) return;
+    void *item = NULL;
+    while (bq_pop(&o->inbox, &item) == 1) {
+        EncodedPacket *ep = (EncodedPacket *)item;
+        rtp_sender_frame(&o->tx, ep->data, ep->size, ep->pts_us,
+                         rtp_class_of(ep->is_keyframe, ep->temporal_id),
+                         !(ep->flags & RKAV_PKT_F_PARTIAL));
+        encoded_packet_unref(ep);
+    }
+}
+
+void rtp_out_stop(RtpOut *o)
+{
+    if (o) bq_close(&o->inbox);
+}
+
+bool rtp_out_take_key_request(RtpOut *o)
+{
+    return o && atomic_exchange(&o->want_key, 0) != 0;
+}
+
+void rtp_out_tick_print(RtpOut *o)
+{
+    if (!o) return;
+    RtpSender *s = &o->tx;
+
+    uint64_t media  = atomic_load(&s->media_bytes);
+    uint64_t fec    = atomic_load(&s->fec_bytes);
+    uint64_t fec_in = atomic_load(&s->fec_in_bytes);
+    uint64_t fec_ns = atomic_load(&s->fec_ns);
+    uint64_t dm = media - o->win_media, df = fec - o->win_fec;
+    uint64_t din = fec_in - o->win_fec_in, dns = fec_ns - o->win_fec_ns;
+    o->win_media  = media;
+    o->win_fec    = fec;
+    o->win_fec_in = fec_in;
+    o->win_fec_ns = fec_ns;
+
+    /* 编码吞吐：参与编码的媒体字节 / 编码耗时，即单核可保护的码率上限 */
+    LOGI("[RTP] %s %.2fMbps fec=%s +%.1f%% enc=%.0fMbps/core pkts=%llu+%llu inbox=%zu/%zu drops=%llu err=%llu",
+         o->dest, (double)(dm + df) * 8.0 / 1e6, fec_scheme_name(s->scheme),
+         dm ? (double)df * 100.0 / (double)dm : 0.0,
+         dns ? (double)din * 8.0 * 1e3 / (double)dns : 0.0,
+         (unsigned long long)atomic_load(&s->media_pkts),
+         (unsigned long long)atomic_load(&s->fec_pkts),
+         bq_size(&o->inbox), bq_capacity(&o->inbox),
+         (unsigned long long)atomic_load(&o->inbox_drops),
+         (unsigned long long)atomic_load(&s->send_errs));
+}
+
+void rtp_out_deinit(RtpOut *o)
+{
+    if (!o || o->fd < 0) return;
+
+    void *item = NULL;
+    while (bq_pop_timeout(&o->inbox, &item, 0) == 1)
+        encoded_packet_unref((EncodedPacket *)item);
+    bq_destroy(&o->inbox);
+    rtp_sender_deinit(&o->tx);
+    close(o->fd);
+    o->fd = -1;
+}
+
+/* ============================================================================
+ * 接收端
+ * ============================================================================ */
+
+int rtp_rx_init(RtpRx *rx)
+{
+    if (!rx) return -1;
+    memset(rx, 0, sizeof(*rx));
+    rx->slot    = (RtpRxSlot *)calloc(RTP_RX_SLOTS, sizeof(RtpRxSlot));
+    rx->scratch = (uint8_t *)malloc((size_t)FEC_MAX_K * RTP_SYM_MAX);
+    rx->par_mem = (uint8_t *)malloc((size_t)RTP_RX_BLOCKS * FEC_MAX_M * RTP_SYM_MAX);
+    if (!rx->slot || !rx->scratch || !rx->par_mem) {
+        rtp_rx_deinit(rx);
+        return -1;
+    }
+    for (int b = 0; b < RTP_RX_BLOCKS; b++)
+        for (int j = 0; j < FEC_MAX_M; j++)
+            rx->blk[b].par[j] = rx->par_mem + ((size_t)b * FEC_MAX_M + j) * RTP_SYM_MAX;
+    return 0;
+}
+
+static RtpRxSlot *rx_slot(const RtpRx *rx, uint16_t seq)
+{
+    RtpRxSlot *sl = &rx->slot[seq % RTP_RX_SLOTS];
+    return (sl->have && sl->seq == seq) ? sl : NULL;
+}
+
+/* 组内缺失的媒体包不多于收到的修复包时还原 */
+static void rx_try_recover(RtpRx *rx, RtpRxBlock *b)
+{
+    bool have[FEC_MAX_K];
+    uint8_t *data[FEC_MAX_K];
+    int missing = 0, repair = 0;
+
+    for (int i = 0; i < b->k; i++) {
+        have[i] = rx_slot(rx, (uint16_t)(b->base + i)) != NULL;
+        if (!have[i]) missing++;
+    }
+    if (missing == 0) {
+        b->done = true;
+        return;
+    }
+    for (int j = 0; j < b->m; j++)
+        if (b->phave[j]) repair++;
+    if (repair < missing) return;
+
+    for (int i = 0; i < b->k; i++) {
+        data[i] = rx->scratch + (size_t)i * RTP_SYM_MAX;
+        if (!have[i]) continue;
+        const RtpRxSlot *sl = rx_slot(rx, (uint16_t)(b->base + i));
+        if (sl->len - RTP_HDR_LEN + RTP_SYM_HDR_LEN > b->sym_len) {
+            rx->bad++;      /* 媒体包比修复符号长：不属于这一组 */
+            b->done = true;
+            return;
+        }
+        size_t n = sym_from_pkt(data[i], sl->pkt, sl->len);
+        memset(data[i] + n, 0, b->sym_len - n);
+    }
+
+    b->done = true;
+    if (fec_decode(b->scheme, b->k, b->m, data, have, b->par, b->phave, b->sym_len) < 0)
+        return;
+
+    for (int i = 0; i < b->k; i++) {
+        if (have[i]) continue;
+        uint16_t seq = (uint16_t)(b->base + i);
+        RtpRxSlot *sl = &rx->slot[seq % RTP_RX_SLOTS];
+        size_t n = pkt_from_sym(sl->pkt, data[i], b->sym_len, seq, b->media_ssrc);
+        if (n == 0) {
+            rx->bad++;
+            continue;
+        }
+        sl->have      = true;
+        sl->recovered = true;
+        sl->seq       = seq;
+        sl->len       = (uint16_t)n;
+        rx->recovered++;
+    }
+}
+
+void rtp_rx_input(RtpRx *rx, const uint8_t *pkt, size_t len)
+{
+    if (!rx || !pkt) return;
+    if (len < RTP_HDR_LEN || (pkt[0] >> 6) != 2) {
+        rx->bad++;
+        return;
+    }
+
+    int pt = pkt[1] & 0x7f;
+    if (pt == RTP_PT_H264) {
+        if (len > RTP_HDR_LEN + RTP_MAX_PAYLOAD) {
+            rx->bad++;
+            return;
+        }
+        uint16_t seq = get_be16(pkt + 2);
+        RtpRxSlot *sl = &rx->slot[seq % RTP_RX_SLOTS];
+        memcpy(sl->pkt, pkt, len);
+        sl->have      = true;
+        sl->recovered = false;
+        sl->seq       = seq;
+        sl->len       = (uint16_t)len;
+        rx->media_pkts++;
+        return;
+    }
+    if (pt != RTP_PT_FEC) {
+        rx->bad++;
+        return;
+    }
+
+    const uint8_t *h = pkt + RTP_HDR_LEN;
+    if (len < RTP_HDR_LEN + RTP_FEC_HDR_LEN + RTP_SYM_HDR_LEN) {
+        rx->bad++;
+        return;
+    }
+    uint16_t base = get_be16(h);
+    int k = h[2], m = h[3], idx = h[4];
+    FecScheme scheme = (FecScheme)h[5];
+    size_t sym_len = get_be16(h + 6);
+    uint32_t mssrc = get_be32(h + 8);
+    if (k < 1 || k > FEC_MAX_K || m < 1 || m > FEC_MAX_M || idx >= m ||
+        (scheme != FEC_XOR && scheme != FEC_RS) || (scheme == FEC_XOR && m != 1) ||
+        sym_len > RTP_SYM_MAX || sym_len != len - RTP_HDR_LEN - RTP_FEC_HDR_LEN) {
+        rx->bad++;
+        return;
+    }
+    rx->fec_pkts++;
+
+    RtpRxBlock *b = NULL;
+    for (int i = 0; i < RTP_RX_BLOCKS; i++) {
+        RtpRxBlock *c = &rx->blk[i];
+        if (c->used && c->base == base && c->k == k && c->m == m && c->media_ssrc == mssrc) {
+            b = c;
+            break;
+        }
+    }
+    if (!b) {
+        b = &rx->blk[rx->blk_next];
+        rx->blk_next = (rx->blk_next + 1) % RTP_RX_BLOCKS;
+        b->used       = true;
+        b->done       = false;
+        b->base       = base;
+        b->k          = (uint8_t)k;
+        b->m          = (uint8_t)m;
+        b->scheme     = scheme;
+        b->sym_len    = (uint16_t)sym_len;
+        b->media_ssrc = mssrc;
+        memset(b->phave, 0, sizeof(b->phave));
+    }
+    if (b->done || b->sym_len != sym_len) return;
+
+    memcpy(b->par[idx], h + RTP_FEC_HDR_LEN, sym_len);
+    b->phave[idx] = true;
+    rx_try_recover(rx, b);
+}
+
+const uint8_t *rtp_rx_get(const RtpRx *rx, uint16_t seq, size_t *len, bool *recovered)
+{
+    if (!rx) return NULL;
+    const RtpRxSlot *sl = rx_slot(rx, seq);
+    if (!sl) return NULL;
+    if (len) *len = sl->len;
+    if (recovered) *recovered = sl->recovered;
+    return sl->pkt;
+}
+
+void rtp_rx_deinit(RtpRx *rx)
+{
+    if (!rx) return;
+    free(rx->slot);
+    free(rx->scratch);
+    free(rx->par_mem);
+    rx->slot    = NULL;
+    rx->scratch = NULL;
+    rx->par_mem = NULL;
+}
+
+/* ============================================================================
+ * 配置
+ * ============================================================================ */
+
+RtpClass rtp_class_of(bool key, int temporal_id)
+{
+    if (key) return RTP_CLS_KEY;
+    if (temporal_id < 0) temporal_id = 0;
+    if (temporal_id > 3) temporal_id = 3;
+    return (RtpClass)(RTP_CLS_T0 + temporal_id);
+}
+
+const char *rtp_class_name(RtpClass cls)
+{
+    static const char *const names[RTP_CLS_COUNT] = { "key", "t0", "t1", "t2", "t3" };
+    return (unsigned)cls < RTP_CLS_COUNT ? names[cls] : "?";
+}
+
+int rtp_parse_prot(const char *spec, uint8_t *prot)
+{
+    if (!spec || !prot) return -1;
+
+    uint8_t tmp[RTP_CLS_COUNT];
+    memcpy(tmp, prot, sizeof(tmp));
+    const char *p = spec;
+    while (*p) {
+        const char *eq = strchr(p, '=');
+        if (!eq) return -1;
+        int cls = -1;
+        for (int c = 0; c < RTP_CLS_COUNT; c++) {
+            size_t n = strlen(rtp_class_name((RtpClass)c));
+            if ((size_t)(eq - p) == n && strncmp(p, rtp_class_name((RtpClass)c), n) == 0)
+                cls = c;
+        }
+        if (cls < 0) return -1;
+        char *end = NULL;
+        long v = strtol(eq + 1, &end, 10);
+        if (end == eq + 1 || v < 0 || v > 100 || (*end && *end != ',')) return -1;
+        tmp[cls] = (uint8_t)v;
+        p = *end ? end + 1 : end;
+    }
+    memcpy(prot, tmp, sizeof(tmp));
+    return 0;
+}
+
+void rtp_default_prot(uint8_t *prot)
+{
+    static const uint8_t def[RTP_CLS_COUNT] = { 50, 25, 10, 5, 0 };
+    if (prot) memcpy(prot, def, sizeof(def));
+}
@@ -0,0 +1,284 @@
+/**
+ * @file rtp.h
+ * @brief RTP/UDP H.264 输出（RFC 6184 打包）与带内 FEC 修复包
+ *
+ * 面向无线回传的低延迟输出：编码包按 RFC 6184 打成 RTP 包（单 NAL / FU-A），直接 UDP 发给 --rtp 目标。
+ * 可选为媒体包附加修复包（--fec xor|rs），接收端在一组内丢包不超过修复包数时原地还原，
+ * 不需要重传往返。修复包使用独立的 SSRC 与负载类型（RTP_PT_FEC），不认识的接收端直接忽略。
+ *
+ * 保护强度按帧类别配置（--fec-prot key=50,t0=25,t1=10）：
+ * - key：关键帧，丢失后直到下一个关键帧都无法解码，通常保护最强
+ * - t0 ~ t3：时间层（SVC-T），越高的层被参考得越少，最高层丢失只影响该帧
+ * 数值为冗余百分比：XOR 每 100 / pct 个媒体包一个修复包；RS 每 RTP_RS_BLOCK 个媒体包
+ * ceil(k × pct / 100) 个修复包。一组不跨帧（帧尾不足一组时按实际包数编码），修复包紧跟在组后发出，
+ * 保护不增加帧延迟。
+ *
+ * 修复包负载（RTP 头之后）：
+ *   base_seq(16) k(8) m(8) idx(8) scheme(8) sym_len(16) media_ssrc(32)，随后 sym_len 字节修复符号
+ * 修复符号由组内媒体包的“符号”编码得到，符号 = payload_len(16) + RTP 头第 0/1 字节 + 时间戳(32) + 负载，
+ * 补零到组内最长；还原时据此重建完整 RTP 包（序号 = base_seq + 序号，SSRC = media_ssrc）。
+ *
+ * 典型使用流程：
+ * 1. rtp_out_init()         - 解析目标地址，创建 UDP socket
+ * 2. 发送线程: rtp_out_run()
+ * 3. 编码线程: rtp_out_publish()
+ * 4. 统计线程: rtp_out_tick_print()
+ * 5. rtp_out_stop() -> join -> rtp_out_deinit()
+ *
+ * 接收端（自测工具 rkav_fec）：rtp_rx_init() -> rtp_rx_input() -> rtp_rx_get() -> rtp_rx_deinit()
+ */
+#pragma once
+
+#include "fec.h"
+#include "rkav/bqueue.h"
+#include "rkav/types.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 单个 UDP 负载上限（避开隧道 / VPN 封装后的分片） */
+#define RTP_MTU             1200
+
+/** RTP 固定头（不带 CSRC / 扩展） */
+#define RTP_HDR_LEN         12
+
+/** 修复包在 RTP 头之后的 FEC 头 */
+#define RTP_FEC_HDR_LEN     12
+
+/** 修复符号头：payload_len + RTP 头第 0/1 字节 + 时间戳 */
+#define RTP_SYM_HDR_LEN     8
+
+/** 媒体包负载上限：保证对应的修复包（多出 FEC 头与符号头）也不超过 RTP_MTU */
+#define RTP_MAX_PAYLOAD     (RTP_MTU - RTP_HDR_LEN - RTP_FEC_HDR_LEN - RTP_SYM_HDR_LEN)
+
+/** 符号最大长度 */
+#define RTP_SYM_MAX         (RTP_SYM_HDR_LEN + RTP_MAX_PAYLOAD)
+
+/** H.264 动态负载类型 */
+#define RTP_PT_H264         96
+
+/** 修复包负载类型 */
+#define RTP_PT_FEC          127
+
+/** 视频时钟 */
+#define RTP_CLOCK_HZ        90000
+
+/** RS 每组媒体包数 */
+#define RTP_RS_BLOCK        16
+
+/** 编码线程 -> 发送线程收件箱容量 */
+#define RTP_INBOX_SIZE      64
+
+/** 接收端按序号缓存的媒体包数（须整除 65536） */
+#define RTP_RX_SLOTS        1024
+
+/** 接收端同时跟踪的修复组数 */
+#define RTP_RX_BLOCKS       32
+
+/**
+ * @brief 保护类别
+ */
+typedef enum {
+    RTP_CLS_KEY = 0,    /**< 关键帧 */
+    RTP_CLS_T0,         /**< 时间层 0（不分层时所有非关键帧） */
+    RTP_CLS_T1,
+    RTP_CLS_T2,
+    RTP_CLS_T3,
+    RTP_CLS_COUNT
+} RtpClass;
+
+/**
+ * @brief 发送端：打包 + 分组编码修复包（单线程使用）
+ */
+typedef struct {
+    int         fd;                     /**< 已 connect 的 UDP socket（不归发送端所有） */
+    FecScheme   scheme;
+    uint8_t     prot[RTP_CLS_COUNT];    /**< 各类别冗余百分比（0 = 不保护） */
+    uint32_t    ssrc;
+    uint32_t    fec_ssrc;
+    uint16_t    seq;
+    uint16_t    fec_seq;
+
+    /* 当前组 */
+    bool        in_frame;               /**< 已发出本帧的前几片，等待 eoi */
+    int         blk_k;                  /**< 本帧每组媒体包数（0 = 本帧不保护） */
+    int         blk_pct;
+    int         blk_n;                  /**< 已收入当前组的媒体包数 */
+    uint16_t    blk_base;
+    uint32_t    blk_ts;
+    uint8_t    *sym[FEC_MAX_K];
+    size_t      sym_len[FEC_MAX_K];
+    uint8_t    *par[FEC_MAX_M];
+    uint8_t     pkt[RTP_MTU];
+
+    /* 统计（发送线程写，统计线程读） */
+    atomic_uint_fast64_t media_pkts;
+    atomic_uint_fast64_t media_bytes;   /**< 含 RTP 头 */
+    atomic_uint_fast64_t fec_pkts;
+    atomic_uint_fast64_t fec_bytes;
+    atomic_uint_fast64_t fec_in_bytes;  /**< 参与编码的媒体符号字节 */
+    atomic_uint_fast64_t fec_ns;        /**< 编码耗时 */
+    atomic_uint_fast64_t send_errs;
+} RtpSender;
+
+/**
+ * @brief 初始化发送端
+ *
+ * @param fd      已 connect 的 UDP socket
+ * @param scheme  FEC_NONE 表示不发修复包
+ * @param prot    各类别冗余百分比（RTP_CLS_COUNT 项，可为 NULL 表示不保护）
+ * @return int 0 成功，-1 内存不足
+ */
+int  rtp_sender_init(RtpSender *s, int fd, FecScheme scheme, const uint8_t *prot);
+
+/**
+ * @brief 发送一个编码包（整帧或帧内分片，AnnexB）
+ *
+ * @param pts_us  显示时间戳（换算成 90kHz RTP 时间戳）
+ * @param cls     保护类别（同一帧的各片须相同）
+ * @param eoi     是否帧的最后一片（置 marker 位并发出帧尾的修复包）
+ */
+void rtp_sender_frame(RtpSender *s, const uint8_t *data, size_t size, uint64_t pts_us,
+                      RtpClass cls, bool eoi);
+
+/** 释放 */
+void rtp_sender_deinit(RtpSender *s);
+
+/**
+ * @brief RTP 输出服务（发送线程 + 收件箱）
+ */
+typedef struct {
+    int         fd;
+    char        dest[64];
+    int         svc_layers;
+    RtpSender   tx;
+
+    BQueue      inbox;                  /**< EncodedPacket*（每个持有一个引用） */
+    bool        pub_wait_key;           /**< 发布侧丢过参考帧，等待下一个关键帧 */
+    atomic_int  want_key;
+    atomic_uint_fast64_t inbox_drops;
+
+    /* 统计窗口（统计线程独占） */
+    uint64_t    win_media;
+    uint64_t    win_fec;
+    uint64_t    win_fec_in;
+    uint64_t    win_fec_ns;
+} RtpOut;
+
+/**
+ * @brief 初始化输出服务
+ *
+ * @param dest        目标 host:port（IPv4 地址或主机名）
+ * @param scheme      纠错方式
+ * @param prot        各类别冗余百分比
+ * @param svc_layers  码流时间层数（1 = 不分层）
+ * @return int 0 成功，-1 地址无效 / socket 失败
+ */
+int  rtp_out_init(RtpOut *o, const char *dest, FecScheme scheme, const uint8_t *prot,
+                  int svc_layers);
+
+/**
+ * @brief 发布一个编码包（编码线程调用，从不阻塞）
+ *
+ * 内部增加一个引用；收件箱满时丢弃并计数，丢的是被参考的包时直到下一个关键帧前都不再入队。
+ * 只能由单一线程调用。
+ */
+void rtp_out_publish(RtpOut *o, EncodedPacket *ep);
+
+/** 发送线程主循环，直到 rtp_out_stop() */
+void rtp_out_run(RtpOut *o);
+
+/** 请求发送线程退出（任意线程可调用） */
+void rtp_out_stop(RtpOut *o);
+
+/** 取走关键帧请求（编码线程每帧调用） */
+bool rtp_out_take_key_request(RtpOut *o);
+
+/** 打印码率、修复包开销与编码吞吐（统计线程每秒调用） */
+void rtp_out_tick_print(RtpOut *o);
+
+/** 释放（发送线程退出后调用） */
+void rtp_out_deinit(RtpOut *o);
+
+/**
+ * @brief 接收端：按序号缓存媒体包，收到修复包时还原组内缺失的媒体包
+ *
+ * 修复包总在组内媒体包之后发出，因此只在修复包到达时尝试还原（乱序晚到的媒体包不会触发重试）。
+ */
+typedef struct {
+    bool        have;
+    bool        recovered;      /**< 由修复包还原 */
+    uint16_t    seq;
+    uint16_t    len;
+    uint8_t     pkt[RTP_MTU];
+} RtpRxSlot;
+
+typedef struct {
+    bool        used;
+    bool        done;           /**< 已完整（或已还原） */
+    uint16_t    base;
+    uint8_t     k;
+    uint8_t     m;
+    FecScheme   scheme;
+    uint16_t    sym_len;
+    uint32_t    media_ssrc;
+    bool        phave[FEC_MAX_M];
+    uint8_t    *par[FEC_MAX_M];
+} RtpRxBlock;
+
+typedef struct {
+    RtpRxSlot  *slot;           /**< RTP_RX_SLOTS 项 */
+    RtpRxBlock  blk[RTP_RX_BLOCKS];
+    int         blk_next;       /**< 下一个被复用的组 */
+    uint8_t    *scratch;        /**< FEC_MAX_K 个符号 */
+    uint8_t    *par_mem;        /**< 各组修复符号缓冲 */
+
+    uint64_t    media_pkts;
+    uint64_t    fec_pkts;
+    uint64_t    recovered;      /**< 还原的媒体包 */
+    uint64_t    bad;            /**< 格式不符的包 */
+} RtpRx;
+
+/** 初始化接收端，-1 内存不足 */
+int  rtp_rx_init(RtpRx *rx);
+
+/** 输入一个收到的 UDP 负载（媒体包或修复包） */
+void rtp_rx_input(RtpRx *rx, const uint8_t *pkt, size_t len);
+
+/**
+ * @brief 取序号为 seq 的媒体包
+ *
+ * @param len        输出：包长
+ * @param recovered  输出：是否由修复包还原（可为 NULL）
+ * @return const uint8_t* 包数据，不在缓存中返回 NULL
+ */
+const uint8_t *rtp_rx_get(const RtpRx *rx, uint16_t seq, size_t *len, bool *recovered);
+
+/** 释放 */
+void rtp_rx_deinit(RtpRx *rx);
+
+/** 由编码包的关键帧标志与时间层得到保护类别 */
+RtpClass rtp_class_of(bool key, int temporal_id);
+
+/** 类别名称（key / t0 ~ t3） */
+const char *rtp_class_name(RtpClass cls);
+
+/**
+ * @brief 解析保护配置 "key=50,t0=25,t1=10"（未列出的类别保持原值）
+ *
+ * @return int 0 成功，-1 格式错误 / 数值不在 0 ~ 100
+ */
+int  rtp_parse_prot(const char *spec, uint8_t *prot);
+
+/** 默认保护：key=50,t0=25,t1=10,t2=5,t3=0 */
+void rtp_default_prot(uint8_t *prot);
+
+#ifdef __cplusplus
+}
+#endif
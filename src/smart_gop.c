@@ -0,0 +1,166 @@
+/**
+ * @file smart_gop.c
+ * @brief 智能 GOP：场景/运动触发 IDR 与码率节省统计实现
+ */
+#include "smart_gop.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** 模块日志标签 */
+#define TAG "smart_gop"
+
+/** 块均值平均绝对差超过该值（0-255 灰度）视为画面切换 */
+#define SG_SCENE_MAD        24
+
+/** 单块均值变化超过该值视为运动块 */
+#define SG_BLOCK_DIFF       6
+
+/** 运动块占比超过该值（千分比）视为有运动 */
+#define SG_MOTION_PERMILLE  20
+
+/** 连续静止超过该时长后出现运动才算“运动起始” */
+#define SG_STILL_SEC        2
+
+/** 块内采样步长（像素），只需粗略均值 */
+#define SG_SAMPLE_STEP      4
+
+/** 帧大小 EWMA 系数 */
+#define SG_EWMA_ALPHA       0.125
+
+void smart_gop_init(SmartGop *g, int fps, int idr_interval)
+{
+    if (!g) return;
+    memset(g, 0, sizeof(*g));
+    g->fps          = fps > 0 ? fps : 30;
+    g->base_gop     = g->fps * 2;
+    g->idr_interval = idr_interval > g->base_gop ? idr_interval : g->base_gop;
+    g->min_idr_gap  = g->fps;
+    g->scene_idr    = true;
+    g->since_idr    = UINT64_MAX / 2;   /* 第一帧由编码器自己出 IDR */
+}
+
+const char *smart_gop_reason_name(SmartGopReason r)
+{
+    switch (r) {
+    case SG_IDR_SCENE:  return "scene";
+    case SG_IDR_MOTION: return "motion";
+    case SG_IDR_DEMAND: return "demand";
+    default:            return "none";
+    }
+}
+
+/* 计算块均值网格（x16 定点，保留小数以便检测微小变化） */
+static void compute_grid(const uint8_t *y, int width, int height, int stride, uint16_t *grid)
+{
+    int bw = width / SG_GRID_W;
+    int bh = height / SG_GRID_H;
+    for (int gy = 0; gy < SG_GRID_H; gy++) {
+        for (int gx = 0; gx < SG_GRID_W; gx++) {
+            const uint8_t *blk = y + (size_t)gy * (size_t)bh * (size_t)stride + (size_t)gx * (size_t)bw;
+            uint32_t sum = 0, n = 0;
+            for (int j = 0; j < bh; j += SG_SAMPLE_STEP) {
+                const uint8_t *row = blk + (size_t)j * (size_t)stride;
+                for (int i = 0; i < bw; i += SG_SAMPLE_STEP) {
+                    sum += row[i];
+                    n++;
+                }
+            }
+            grid[gy * SG_GRID_W + gx] = (uint16_t)(n ? (sum * 16u) / n : 0);
+        }
+    }
+}
+
+SmartGopReason smart_gop_decide(SmartGop *g, const uint8_t *y, int width, int height,
+                                int stride, bool demand)
+{
+    if (!g) return SG_IDR_NONE;
+
+    SmartGopReason why = SG_IDR_NONE;
+    if (y && width >= SG_GRID_W * SG_SAMPLE_STEP && height >= SG_GRID_H * SG_SAMPLE_STEP) {
+        uint16_t cur[SG_GRID_W * SG_GRID_H];
+        compute_grid(y, width, height, stride > 0 ? stride : width, cur);
+
+        if (g->have_grid) {
+            uint32_t sad = 0, moving = 0;
+            for (int i = 0; i < SG_GRID_W * SG_GRID_H; i++) {
+                uint32_t d = (uint32_t)abs((int)cur[i] - (int)g->grid[i]);
+                sad += d;
+                if (d > SG_BLOCK_DIFF * 16u) moving++;
+            }
+            uint32_t mad = sad / (SG_GRID_W * SG_GRID_H * 16u);
+            bool motion  = moving * 1000u > (uint32_t)(SG_GRID_W * SG_GRID_H) * SG_MOTION_PERMILLE;
+
+            if (mad > SG_SCENE_MAD)
+                why = SG_IDR_SCENE;
+            else if (motion && g->still_frames >= g->fps * SG_STILL_SEC)
+                why = SG_IDR_MOTION;
+            g->still_frames = motion ? 0 : g->still_frames + 1;
+        }
+        memcpy(g->grid, cur, sizeof(cur));
+        g->have_grid = true;
+        if (!g->scene_idr) why = SG_IDR_NONE;
+    }
+    if (why == SG_IDR_NONE && demand)
+        why = SG_IDR_DEMAND;
+
+    /* 刚出过 IDR：不必重复；按需请求由调用方在后续帧继续提出 */
+    if (why != SG_IDR_NONE && g->since_idr < (uint64_t)g->min_idr_gap)
+        return SG_IDR_NONE;
+    if (why != SG_IDR_NONE) {
+        atomic_fetch_add_explicit(&g->stat_forced[why], 1, memory_order_relaxed);
+        LOGI("[%s] force IDR (%s) after %llu frames", TAG, smart_gop_reason_name(why),
+             (unsigned long long)g->since_idr);
+    }
+    return why;
+}
+
+void smart_gop_on_packet(SmartGop *g, size_t bytes, bool key, uint64_t pts_us)
+{
+    if (!g) return;
+    if (g->frame_idx == 0) g->start_us = pts_us;
+
+    double x = (double)bytes;
+    if (key) {
+        g->avg_idr_bytes = g->avg_idr_bytes > 0.0 ? g->avg_idr_bytes + (x - g->avg_idr_bytes) * SG_EWMA_ALPHA : x;
+        g->since_idr = 0;
+        atomic_fetch_add_explicit(&g->stat_idr, 1, memory_order_relaxed);
+    } else if (++g->since_idr % (uint64_t)g->base_gop == 0) {
+        atomic_fetch_add_explicit(&g->stat_vi, 1, memory_order_relaxed);
+    } else {
+        g->avg_p_bytes = g->avg_p_bytes > 0.0 ? g->avg_p_bytes + (x - g->avg_p_bytes) * SG_EWMA_ALPHA : x;
+    }
+
+    /* 基线在本位置的代价：固定 GOP 的 IDR 位置按 IDR 均值，其余按普通 P 帧均值 */
+    bool   base_key = (g->frame_idx % (uint64_t)g->base_gop) == 0;
+    double base     = base_key ? g->avg_idr_bytes : g->avg_p_bytes;
+    if (base <= 0.0) base = x;
+    g->frame_idx++;
+
+    atomic_fetch_add_explicit(&g->stat_bytes, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g->stat_saved, (int64_t)(base - x), memory_order_relaxed);
+    atomic_store_explicit(&g->stat_elapsed_us, pts_us - g->start_us, memory_order_relaxed);
+}
+
+void smart_gop_tick_print(SmartGop *g)
+{
+    if (!g || ++g->ticks % SG_PRINT_EVERY != 0) return;
+
+    uint64_t elapsed = atomic_load_explicit(&g->stat_elapsed_us, memory_order_relaxed);
+    if (elapsed == 0) return;
+
+    uint64_t bytes = atomic_load_explicit(&g->stat_bytes, memory_order_relaxed);
+    int64_t  saved = atomic_load_explicit(&g->stat_saved, memory_order_relaxed);
+    double   hours = (double)elapsed / 3.6e9;
+    double   base  = (double)bytes + (double)saved;
+
+    LOGI("[GOP] idr=%llu (scene=%llu motion=%llu demand=%llu) vi=%llu | %.1fMB/h, saved %.1fMB/h (%.1f%%) vs fixed gop=%d",
+         (unsigned long long)atomic_load(&g->stat_idr),
+         (unsigned long long)atomic_load(&g->stat_forced[SG_IDR_SCENE]),
+         (unsigned long long)atomic_load(&g->stat_forced[SG_IDR_MOTION]),
+         (unsigned long long)atomic_load(&g->stat_forced[SG_IDR_DEMAND]),
+         (unsigned long long)atomic_load(&g->stat_vi),
+         (double)bytes / 1e6 / hours, (double)saved / 1e6 / hours,
+         base > 0.0 ? (double)saved * 100.0 / base : 0.0, g->base_gop);
+}
@@ -0,0 +1,124 @@
+/**
+ * @file smart_gop.h
+ * @brief 监控场景“智能 GOP”：场景/运动触发 IDR 与码率节省统计
+ *
+ * 固定 GOP（fps*2）下，静止画面每 2 秒仍要付一个 IDR 的代价，24 小时录像中这是主要开销。
+ * 智能 GOP 模式下编码器使用长期参考帧（LTR）+ 虚拟 I 帧（见 encoder_mpp_set_smart_gop）：
+ * - IDR 间隔拉长到 --idr-sec（默认 60 秒），IDR 同时成为 LTR
+ * - 每 fps*2 帧一个虚拟 I 帧（只参考 LTR 的 P 帧），随机访问 = LTR + 虚拟 I 帧
+ * - 画面切换（遮挡、开关灯、红外切换）或静止后出现运动时立即插入 IDR
+ * - 直播新客户端等需要关键帧的场合按需请求 IDR
+ *
+ * 本模块在编码线程中运行：
+ * 1. smart_gop_decide()    每帧编码前分析亮度网格，决定是否强制 IDR
+ * 2. smart_gop_on_packet() 每包编码后累计字节，估算相对固定 GOP 节省的字节
+ * 3. smart_gop_tick_print() 统计线程每秒调用（每 SG_PRINT_EVERY 秒打印一次 [GOP]）
+ */
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 亮度分析网格（块均值） */
+#define SG_GRID_W       32
+#define SG_GRID_H       18
+
+/** [GOP] 日志打印周期（秒） */
+#define SG_PRINT_EVERY  10
+
+/**
+ * @brief 强制 IDR 的原因
+ */
+typedef enum {
+    SG_IDR_NONE = 0,
+    SG_IDR_SCENE,       /**< 画面切换 */
+    SG_IDR_MOTION,      /**< 静止后出现运动 */
+    SG_IDR_DEMAND,      /**< 下游按需请求（直播新客户端等） */
+} SmartGopReason;
+
+/**
+ * @brief 智能 GOP 状态
+ *
+ * 分析与计费字段只由编码线程访问；stat_* 为原子计数，统计线程读取。
+ */
+typedef struct {
+    int       fps;
+    int       base_gop;         /**< 对比基线：固定 GOP 长度（fps*2），也是虚拟 I 帧间隔 */
+    int       idr_interval;     /**< 最长 IDR 间隔（帧） */
+    int       min_idr_gap;      /**< 两次强制 IDR 的最小间隔（帧），防止抖动画面连续出 IDR */
+
+    /* 场景分析 */
+    uint16_t  grid[SG_GRID_W * SG_GRID_H];  /**< 上一帧块均值（x16 定点） */
+    bool      have_grid;
+    int       still_frames;     /**< 连续静止帧数 */
+    bool      scene_idr;        /**< 场景 / 运动是否触发 IDR（init 置 true；只借用运动分析时置 false） */
+
+    /* 编码状态 */
+    uint64_t  frame_idx;        /**< 已编码帧序号 */
+    uint64_t  since_idr;        /**< 距上一个 IDR 的帧数 */
+    double    avg_idr_bytes;    /**< IDR 大小 EWMA */
+    double    avg_p_bytes;      /**< P 帧大小 EWMA */
+    uint64_t  start_us;         /**< 第一个包的 PTS */
+
+    /* 统计（原子，累计值） */
+    atomic_uint_fast64_t stat_bytes;        /**< 实际编码字节 */
+    atomic_int_fast64_t  stat_saved;        /**< 相对固定 GOP 估算节省的字节（可为负） */
+    atomic_uint_fast64_t stat_idr;          /**< IDR 数 */
+    atomic_uint_fast64_t stat_vi;           /**< 虚拟 I 帧数 */
+    atomic_uint_fast64_t stat_forced[4];    /**< 按 SmartGopReason 统计的强制 IDR 数 */
+    atomic_uint_fast64_t stat_elapsed_us;   /**< 已编码时长 */
+    unsigned             ticks;             /**< tick_print 计数（统计线程） */
+} SmartGop;
+
+/**
+ * @brief 初始化
+ *
+ * @param g            状态
+ * @param fps          帧率
+ * @param idr_interval 最长 IDR 间隔（帧）
+ */
+void smart_gop_init(SmartGop *g, int fps, int idr_interval);
+
+/**
+ * @brief 分析一帧并决定是否强制 IDR（编码前调用）
+ *
+ * 场景与运动判定基于 Y 平面的块均值网格：
+ * - 块均值平均绝对差超过阈值 -> 画面切换
+ * - 连续静止 2 秒后运动块占比超过阈值 -> 运动起始
+ * 两次强制 IDR 至少间隔 1 秒（按需请求也受此限制，未满足时下一帧继续请求）。
+ *
+ * @param g       状态
+ * @param y       Y 平面
+ * @param width   宽
+ * @param height  高
+ * @param stride  Y 平面行跨度
+ * @param demand  下游是否请求关键帧
+ * @return SmartGopReason 需要强制 IDR 的原因，SG_IDR_NONE 表示不需要
+ */
+SmartGopReason smart_gop_decide(SmartGop *g, const uint8_t *y, int width, int height,
+                                int stride, bool demand);
+
+/**
+ * @brief 累计一个编码包（编码后调用）
+ *
+ * 节省估算：逐帧累加“固定 GOP 在该位置的代价 - 实际大小”。固定 GOP 的 IDR 位置
+ * （frame_idx % base_gop == 0）按 IDR 大小均值计，其余位置按普通 P 帧大小均值计；
+ * 虚拟 I 帧与强制 IDR 的额外开销都在实际大小中，自然抵扣。
+ */
+void smart_gop_on_packet(SmartGop *g, size_t bytes, bool key, uint64_t pts_us);
+
+/** 打印累计码率与节省（统计线程每秒调用，每 SG_PRINT_EVERY 次打印一行） */
+void smart_gop_tick_print(SmartGop *g);
+
+/** 原因名称 */
+const char *smart_gop_reason_name(SmartGopReason r);
+
+#ifdef __cplusplus
+}
+#endif
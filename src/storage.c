@@ -0,0 +1,346 @@
+/**
+ * @file storage.c
+ * @brief 多存储目标管理
+ *
+ * 写盘线程只在锁内更新计数与状态；statvfs 与探测写都在统计线程的锁外进行，
+ * 掉线设备上阻塞的系统调用不会拖住写盘线程。目标目录在初始化后只读，可无锁访问。
+ */
+#include "storage.h"
+#include "log.h"
+
+#include "rkav/time.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+/** 模块日志标签 */
+#define TAG "store"
+
+/** 探测文件大小（一页，确认能真正落盘而不只是目录可见） */
+#define PROBE_BYTES 4096
+
+static const char *state_name(StorageState st)
+{
+    switch (st) {
+    case STORAGE_OK:   return "ok";
+    case STORAGE_SLOW: return "slow";
+    case STORAGE_FULL: return "full";
+    case STORAGE_DOWN: return "down";
+    default:           return "?";
+    }
+}
+
+/* 锁内调用：切换状态并推进代次 */
+static void set_state(Storage *s, int i, StorageState st, uint64_t until_us)
+{
+    StorageTarget *t = &s->t[i];
+    t->until_us = until_us;
+    if (t->state == st) return;
+    t->state = st;
+    atomic_fetch_add(&s->gen, 1u);
+}
+
+int storage_init(Storage *s, const char *const *roots, int n, StorageMode mode,
+                 unsigned slow_ms, unsigned min_free_mb)
+{
+    if (!s || !roots || n < 1 || n > STORAGE_MAX_TARGETS) return -1;
+
+    memset(s, 0, sizeof(*s));
+    s->mode     = mode;
+    s->n        = n;
+    s->slow_us  = (uint64_t)slow_ms * 1000ull;
+    s->min_free = (uint64_t)min_free_mb << 20;
+    for (int i = 0; i < n; i++) {
+        int len = snprintf(s->t[i].root, sizeof(s->t[i].root), "%s", roots[i]);
+        if (len < 0 || (size_t)len >= sizeof(s->t[i].root)) {
+            LOGE("[%s] path too long: %s", TAG, roots[i]);
+            return -1;
+        }
+        /* 去掉结尾的 '/'，拼文件名时统一补 */
+        while (len > 1 && s->t[i].root[len - 1] == '/')
+            s->t[i].root[--len] = '\0';
+    }
+    pthread_mutex_init(&s->mtx, NULL);
+    atomic_init(&s->gen, 0u);
+
+    /* 启动时先探测一遍：不存在的目录直接判为 DOWN，之后按间隔重试 */
+    uint64_t now = rkav_now_monotonic_us();
+    for (int i = 0; i < n; i++) {
+        struct statvfs vfs;
+        if (statvfs(s->t[i].root, &vfs) != 0 || access(s->t[i].root, W_OK) != 0) {
+            LOGW("[%s] target %d unavailable: %s (%s)", TAG, i, s->t[i].root, strerror(errno));
+            s->t[i].state    = STORAGE_DOWN;
+            s->t[i].until_us = now + STORAGE_RETRY_SEC * 1000000ull;
+            continue;
+        }
+        s->t[i].free_bytes = (uint64_t)vfs.f_bavail * (uint64_t)vfs.f_frsize;
+        if (s->t[i].free_bytes < s->min_free)
+            s->t[i].state = STORAGE_FULL;
+        LOGI("[%s] target %d: %s %s free=%.1fGB", TAG, i, s->t[i].root,
+             state_name(s->t[i].state), (double)s->t[i].free_bytes / (1024.0 * 1024.0 * 1024.0));
+    }
+    LOGI("[%s] mode=%s targets=%d slow=%ums min_free=%uMB", TAG, storage_mode_name(mode), n,
+         slow_ms, min_free_mb);
+    return 0;
+}
+
+int storage_select(Storage *s, int *idx, int max)
+{
+    if (!s || !idx || max < 1) return 0;
+
+    int cnt = 0;
+    pthread_mutex_lock(&s->mtx);
+    switch (s->mode) {
+    case STORAGE_MIRROR:
+        for (int i = 0; i < s->n && cnt < max; i++)
+            if (s->t[i].state == STORAGE_OK) idx[cnt++] = i;
+        break;
+    case STORAGE_STRIPE: {
+        /* 打开文件最少的健康目标；同数时取累计字节少的，长时间看各设备写入量接近 */
+        int best = -1;
+        for (int i = 0; i < s->n; i++) {
+            if (s->t[i].state != STORAGE_OK) continue;
+            if (best < 0 || s->t[i].open_files < s->t[best].open_files ||
+                (s->t[i].open_files == s->t[best].open_files && s->t[i].bytes < s->t[best].bytes))
+                best = i;
+        }
+        if (best >= 0) idx[cnt++] = best;
+        break;
+    }
+    case STORAGE_FAILOVER:
+        for (int i = 0; i < s->n && cnt == 0; i++)
+            if (s->t[i].state == STORAGE_OK) idx[cnt++] = i;
+        break;
+    }
+
+    /* 没有健康目标：退而求其次 */
+    for (int i = 0; i < s->n && cnt == 0; i++)
+        if (s->t[i].state != STORAGE_DOWN) idx[cnt++] = i;
+
+    for (int k = 0; k < cnt; k++)
+        s->t[idx[k]].open_files++;
+    pthread_mutex_unlock(&s->mtx);
+    return cnt;
+}
+
+void storage_release(Storage *s, int idx)
+{
+    if (!s || idx < 0 || idx >= s->n) return;
+    pthread_mutex_lock(&s->mtx);
+    if (s->t[idx].open_files > 0) s->t[idx].open_files--;
+    pthread_mutex_unlock(&s->mtx);
+}
+
+void storage_note_write(Storage *s, int idx, size_t bytes, uint64_t lat_us, bool ok)
+{
+    if (!s || idx < 0 || idx >= s->n) return;
+
+    uint64_t now = rkav_now_monotonic_us();
+    pthread_mutex_lock(&s->mtx);
+    StorageTarget *t = &s->t[idx];
+    t->lat_ewma_us += ((double)lat_us - t->lat_ewma_us) / 8.0;
+    if (lat_us > t->win_max_us) t->win_max_us = lat_us;
+
+    if (!ok) {
+        t->errors++;
+        if (t->state != STORAGE_DOWN)
+            LOGW("[%s] target %d write failed, marking down: %s", TAG, idx, t->root);
+        set_state(s, idx, STORAGE_DOWN, now + STORAGE_RETRY_SEC * 1000000ull);
+    } else {
+        t->win_bytes += bytes;
+        t->bytes     += bytes;
+        if (s->slow_us && lat_us > s->slow_us && t->state != STORAGE_DOWN) {
+            if (t->state != STORAGE_SLOW)
+                LOGW("[%s] target %d slow write %.1fms, degrading for %ds: %s", TAG, idx,
+                     (double)lat_us / 1000.0, STORAGE_SLOW_HOLD_SEC, t->root);
+            set_state(s, idx, STORAGE_SLOW, now + STORAGE_SLOW_HOLD_SEC * 1000000ull);
+        }
+    }
+    pthread_mutex_unlock(&s->mtx);
+}
+
+void storage_note_lost(Storage *s, size_t bytes)
+{
+    if (!s) return;
+    pthread_mutex_lock(&s->mtx);
+    s->lost_pkts++;
+    s->lost_bytes += bytes;
+    pthread_mutex_unlock(&s->mtx);
+}
+
+unsigned storage_generation(Storage *s)
+{
+    return s ? atomic_load(&s->gen) : 0u;
+}
+
+bool storage_should_move(Storage *s, const int *idx, int n)
+{
+    if (!s) return false;
+
+    bool move = false;
+    pthread_mutex_lock(&s->mtx);
+    int healthy = 0, first = -1;
+    for (int i = 0; i < s->n; i++) {
+        if (s->t[i].state != STORAGE_OK) continue;
+        if (first < 0) first = i;
+        healthy++;
+    }
+    if (healthy > 0) {
+        switch (s->mode) {
+        case STORAGE_MIRROR:
+            /* 集合比较：当前目标都健康且数量相同即一致 */
+            move = n != healthy;
+            for (int k = 0; k < n && !move; k++)
+                move = s->t[idx[k]].state != STORAGE_OK;
+            break;
+        case STORAGE_STRIPE:
+            for (int k = 0; k < n && !move; k++)
+                move = s->t[idx[k]].state != STORAGE_OK;
+            break;
+        case STORAGE_FAILOVER:
+            move = n != 1 || idx[0] != first;
+            break;
+        }
+    }
+    if (move) s->moves++;
+    pthread_mutex_unlock(&s->mtx);
+    return move;
+}
+
+const char *storage_root(const Storage *s, int idx)
+{
+    return (s && idx >= 0 && idx < s->n) ? s->t[idx].root : "";
+}
+
+/* 写一页探测文件并 fsync：挂载点重新出现但设备只读 / 已满时也判为失败 */
+static int probe_write(const char *root)
+{
+    char path[300];
+    snprintf(path, sizeof(path), "%s/.rkav_probe", root);
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    static const uint8_t page[PROBE_BYTES];
+    int ok = write(fd, page, sizeof(page)) == (ssize_t)sizeof(page) && fsync(fd) == 0;
+    close(fd);
+    unlink(path);
+    return ok ? 0 : -1;
+}
+
+void storage_probe(Storage *s)
+{
+    if (!s) return;
+
+    for (int i = 0; i < s->n; i++) {
+        StorageTarget *t = &s->t[i];
+        uint64_t now = rkav_now_monotonic_us();
+
+        pthread_mutex_lock(&s->mtx);
+        StorageState st = t->state;
+        bool due = now >= t->until_us;
+        pthread_mutex_unlock(&s->mtx);
+
+        /* 锁外做可能阻塞的 I/O */
+        struct statvfs vfs;
+        bool vfs_ok = statvfs(t->root, &vfs) == 0;
+        uint64_t free_bytes = vfs_ok ? (uint64_t)vfs.f_bavail * (uint64_t)vfs.f_frsize : 0;
+        bool probe_ok = false;
+        if (st == STORAGE_DOWN && due && vfs_ok)
+            probe_ok = probe_write(t->root) == 0;
+
+        pthread_mutex_lock(&s->mtx);
+        if (vfs_ok) t->free_bytes = free_bytes;
+        switch (t->state) {
+        case STORAGE_OK:
+            if (!vfs_ok) {
+                LOGW("[%s] target %d unreachable, marking down: %s", TAG, i, t->root);
+                set_state(s, i, STORAGE_DOWN, now + STORAGE_RETRY_SEC * 1000000ull);
+            } else if (free_bytes < s->min_free) {
+                LOGW("[%s] target %d low on space (%.0fMB), marking full: %s", TAG, i,
+                     (double)free_bytes / (1024.0 * 1024.0), t->root);
+                set_state(s, i, STORAGE_FULL, 0);
+            }
+            break;
+        case STORAGE_SLOW:
+            if (now >= t->until_us) {
+                LOGI("[%s] target %d back from slow: %s", TAG, i, t->root);
+                set_state(s, i, STORAGE_OK, 0);
+            }
+            break;
+        case STORAGE_FULL:
+            if (vfs_ok && free_bytes >= s->min_free) {
+                LOGI("[%s] target %d has space again: %s", TAG, i, t->root);
+                set_state(s, i, STORAGE_OK, 0);
+            }
+            break;
+        case STORAGE_DOWN:
+            if (probe_ok) {
+                LOGI("[%s] target %d back online: %s", TAG, i, t->root);
+                set_state(s, i, free_bytes >= s->min_free ? STORAGE_OK : STORAGE_FULL, 0);
+            } else if (due) {
+                t->until_us = now + STORAGE_RETRY_SEC * 1000000ull;
+            }
+            break;
+        }
+        pthread_mutex_unlock(&s->mtx);
+    }
+}
+
+void storage_tick_print(Storage *s)
+{
+    if (!s) return;
+
+    char line[512];
+    int off = 0;
+    pthread_mutex_lock(&s->mtx);
+    for (int i = 0; i < s->n && off < (int)sizeof(line); i++) {
+        StorageTarget *t = &s->t[i];
+        off += snprintf(line + off, sizeof(line) - (size_t)off,
+                        " | t%d %s files=%d lat=%.1f/%.1fms %.2fMB/s free=%.1fG err=%llu", i,
+                        state_name(t->state), t->open_files, t->lat_ewma_us / 1000.0,
+                        (double)t->win_max_us / 1000.0, (double)t->win_bytes / (1024.0 * 1024.0),
+                        (double)t->free_bytes / (1024.0 * 1024.0 * 1024.0),
+                        (unsigned long long)t->errors);
+        t->win_max_us = 0;
+        t->win_bytes  = 0;
+    }
+    uint64_t lost = s->lost_pkts, moves = s->moves;
+    pthread_mutex_unlock(&s->mtx);
+
+    LOGI("[STORE] %s moves=%llu lost=%llu%s", storage_mode_name(s->mode),
+         (unsigned long long)moves, (unsigned long long)lost, line);
+}
+
+void storage_deinit(Storage *s)
+{
+    if (!s || s->n == 0) return;
+    LOGI("[%s] done: moves=%llu lost=%llu pkts (%.1fKB)", TAG, (unsigned long long)s->moves,
+         (unsigned long long)s->lost_pkts, (double)s->lost_bytes / 1024.0);
+    pthread_mutex_destroy(&s->mtx);
+    s->n = 0;
+}
+
+int storage_parse_mode(const char *name, StorageMode *mode)
+{
+    if (!name || !mode) return -1;
+    if (strcmp(name, "mirror") == 0)        *mode = STORAGE_MIRROR;
+    else if (strcmp(name, "stripe") == 0)   *mode = STORAGE_STRIPE;
+    else if (strcmp(name, "failover") == 0) *mode = STORAGE_FAILOVER;
+    else return -1;
+    return 0;
+}
+
+const char *storage_mode_name(StorageMode mode)
+{
+    switch (mode) {
+    case STORAGE_MIRROR:   return "mirror";
+    case STORAGE_STRIPE:   return "stripe";
+    case STORAGE_FAILOVER: return "failover";
+    default:               return "?";
+    }
+}
@@ -0,0 +1,166 @@
+/**
+ * @file storage.h
+ * @brief 多存储目标管理：镜像 / 按段轮换 / 主备切换，按写延迟与剩余空间判断健康
+ *
+ * 设备通常有板载 eMMC，另可插 USB 盘或 SD 卡。只写一个路径时，任何一次写失败都会终止录像。
+ * 本模块维护若干存储目标（--store 指定的目录，各自挂在不同设备上），供录像输出选择写到哪里：
+ * - mirror：每段同时写到所有健康目标
+ * - stripe：每段写一个健康目标，按当前打开的文件数均衡负载（多条流、多段轮流分到各设备）
+ * - failover：写优先级最高的健康目标（--store 的顺序），主目标恢复后切回
+ *
+ * 健康状态：
+ * - OK：可用
+ * - SLOW：单次写耗时超过阈值（SD 卡垃圾回收、USB 盘掉速），保持 STORAGE_SLOW_HOLD_SEC 秒后恢复
+ * - FULL：剩余空间低于阈值（统计线程每秒 statvfs），空间回升后恢复
+ * - DOWN：写失败 / 目录不可访问，每 STORAGE_RETRY_SEC 秒写一个探测文件，成功即恢复
+ *
+ * 任一目标状态变化时代次（generation）加一；写盘线程发现代次变化后询问 storage_should_move()，
+ * 需要迁移时在下一个随机访问起点（视频关键帧）换到新的目标组合开新段，流本身不中断。
+ *
+ * 典型使用流程：
+ * storage_init() -> 写盘线程 storage_select() / storage_note_write() / storage_release()
+ * -> 统计线程每秒 storage_probe() + storage_tick_print() -> storage_deinit()
+ */
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 最多存储目标数 */
+#define STORAGE_MAX_TARGETS   4
+
+/** 慢写后保持 SLOW 的秒数（期间流量留在其他目标上） */
+#define STORAGE_SLOW_HOLD_SEC 30
+
+/** DOWN 目标的探测间隔（秒） */
+#define STORAGE_RETRY_SEC     5
+
+/**
+ * @brief 多目标写入模式
+ */
+typedef enum {
+    STORAGE_MIRROR = 0,     /**< 每段写到所有健康目标 */
+    STORAGE_STRIPE,         /**< 每段写一个目标，按打开文件数均衡 */
+    STORAGE_FAILOVER,       /**< 写优先级最高的健康目标 */
+} StorageMode;
+
+/**
+ * @brief 目标健康状态
+ */
+typedef enum {
+    STORAGE_OK = 0,
+    STORAGE_SLOW,
+    STORAGE_FULL,
+    STORAGE_DOWN,
+} StorageState;
+
+/**
+ * @brief 一个存储目标
+ */
+typedef struct {
+    char         root[256];     /**< 目标目录 */
+    StorageState state;
+    uint64_t     until_us;      /**< SLOW：恢复时刻；DOWN：下次探测时刻 */
+    int          open_files;    /**< 当前写在该目标上的文件数 */
+
+    double       lat_ewma_us;   /**< 单次写耗时的指数滑动平均 */
+    uint64_t     win_max_us;    /**< 本秒最大单次写耗时 */
+    uint64_t     win_bytes;     /**< 本秒写入字节 */
+    uint64_t     bytes;         /**< 累计写入字节 */
+    uint64_t     errors;        /**< 累计写失败次数 */
+    uint64_t     free_bytes;    /**< 最近一次 statvfs 的可用空间 */
+} StorageTarget;
+
+/**
+ * @brief 存储管理器（多个写盘线程共享，内部加锁）
+ */
+typedef struct {
+    StorageMode   mode;
+    int           n;
+    StorageTarget t[STORAGE_MAX_TARGETS];
+    uint64_t      slow_us;      /**< 单次写耗时超过该值即判为 SLOW */
+    uint64_t      min_free;     /**< 可用空间低于该值即判为 FULL（字节） */
+
+    pthread_mutex_t mtx;
+    atomic_uint   gen;          /**< 状态代次，任一目标状态变化时加一 */
+    uint64_t      lost_pkts;    /**< 所有目标都不可用期间丢弃的包 / 块数 */
+    uint64_t      lost_bytes;
+    uint64_t      moves;        /**< 状态变化引起的迁移次数 */
+} Storage;
+
+/**
+ * @brief 初始化
+ *
+ * @param roots        目标目录（按优先级排列），须已存在
+ * @param n            目标数（1 ~ STORAGE_MAX_TARGETS）
+ * @param slow_ms      慢写阈值（毫秒）
+ * @param min_free_mb  最小可用空间（MiB）
+ * @return int 0 成功，-1 参数错误
+ */
+int  storage_init(Storage *s, const char *const *roots, int n, StorageMode mode,
+                  unsigned slow_ms, unsigned min_free_mb);
+
+/**
+ * @brief 为一个新文件选择目标（对选中的目标计入打开文件数）
+ *
+ * 没有 OK 目标时退而选优先级最高的非 DOWN 目标（慢或将满也好过丢数据）。
+ *
+ * @param idx  输出：目标序号
+ * @param max  idx 容量
+ * @return int 选中的目标数，0 表示全部 DOWN
+ */
+int  storage_select(Storage *s, int *idx, int max);
+
+/** 文件关闭（或放弃）后释放 storage_select() 计入的打开数 */
+void storage_release(Storage *s, int idx);
+
+/**
+ * @brief 登记一次写入（写盘线程每次写后调用）
+ *
+ * @param lat_us  本次写耗时
+ * @param ok      false 表示写失败，目标立即判为 DOWN
+ */
+void storage_note_write(Storage *s, int idx, size_t bytes, uint64_t lat_us, bool ok);
+
+/** 登记所有目标都不可用时丢弃的数据 */
+void storage_note_lost(Storage *s, size_t bytes);
+
+/** 当前状态代次（无锁读） */
+unsigned storage_generation(Storage *s);
+
+/**
+ * @brief 正在写的目标组合是否应迁移（代次变化后调用）
+ *
+ * mirror：健康目标集合与当前不同；failover：最高优先级的健康目标不是当前目标；
+ * stripe：当前目标不再健康。没有任何健康目标时不迁移。
+ */
+bool storage_should_move(Storage *s, const int *idx, int n);
+
+/** 目标目录 */
+const char *storage_root(const Storage *s, int idx);
+
+/** 每秒探测：刷新可用空间，SLOW 到期恢复，DOWN 到期写探测文件（统计线程调用，可能阻塞） */
+void storage_probe(Storage *s);
+
+/** 每秒输出 [STORE] 各目标状态、写耗时、吞吐与可用空间，并清零本秒窗口 */
+void storage_tick_print(Storage *s);
+
+/** 释放 */
+void storage_deinit(Storage *s);
+
+/** 解析模式名（mirror / stripe / failover），失败返回 -1 */
+int  storage_parse_mode(const char *name, StorageMode *mode);
+
+/** 模式名 */
+const char *storage_mode_name(StorageMode mode);
+
+#ifdef __cplusplus
+}
+#endif
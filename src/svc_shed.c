@@ -0,0 +1,33 @@
+/**
+ * @file svc_shed.c
+ * @brief 时间分层（SVC-T）丢层策略实现
+ */
+#include "svc_shed.h"
+
+void svc_shed_init(SvcShed *s, int layers)
+{
+    if (!s) return;
+    s->layers  = layers > 0 ? layers : 1;
+    s->max_tid = s->layers - 1;
+    s->shed    = 0;
+}
+
+bool svc_shed_drop(SvcShed *s, int tid, double pressure)
+{
+    if (!s || s->layers <= 1) return false;
+
+    if (pressure < 0.0) pressure = 0.0;
+    int target = s->layers - 1 - (int)(pressure * (double)s->layers);
+    if (target < 0) target = 0;
+
+    if (target < s->max_tid)
+        s->max_tid = target;                /* 降级：立即生效 */
+    else if (tid == 0 && target > s->max_tid)
+        s->max_tid = target;                /* 升级：只在基础层帧处 */
+
+    if (tid > s->max_tid) {
+        s->shed++;
+        return true;
+    }
+    return false;
+}
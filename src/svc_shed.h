@@ -0,0 +1,50 @@
+/**
+ * @file svc_shed.h
+ * @brief 时间分层（SVC-T）丢层策略头文件
+ *
+ * 码流按时间层编码后（见 encoder_mpp_set_temporal_layers），最高层帧不被参考，
+ * 丢掉“最高若干层”后剩余码流仍可完整解码，帧率逐级减半（30 -> 15 -> 7.5）。
+ *
+ * 本模块根据下游压力（0 = 空闲，1 = 满）决定当前允许通过的最高层：
+ * - 压力上升：立即降低允许层（被丢层的后续帧也一并被丢，不会引用缺失帧）
+ * - 压力下降：只在基础层（L0）帧处恢复，保证恢复后第一帧的参考帧齐全
+ * - 基础层（含 IDR）从不丢弃
+ *
+ * 编码队列（main.c）与直播预览的每个客户端（live_server.c）各持有一个 SvcShed。
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 丢层状态
+ */
+typedef struct {
+    int      layers;    /**< 时间层数（1 = 不分层，从不丢弃） */
+    int      max_tid;   /**< 当前允许通过的最高层 */
+    uint64_t shed;      /**< 累计丢弃包数 */
+} SvcShed;
+
+/** 初始化：不丢任何层 */
+void svc_shed_init(SvcShed *s, int layers);
+
+/**
+ * @brief 判断一个包是否应丢弃
+ *
+ * 压力 p 映射到允许层：max_tid = layers-1 - floor(p * layers)，下限 0。
+ *
+ * @param s        丢层状态
+ * @param tid      包的时间层 ID
+ * @param pressure 下游压力（队列占用比 / 滞后占上限比），0..1
+ * @return true    应丢弃（已计入 shed）
+ */
+bool svc_shed_drop(SvcShed *s, int tid, double pressure);
+
+#ifdef __cplusplus
+}
+#endif
@@ -31,3 +31,18 @@ uint64_t rkav_now_monotonic_us(void)
     /* 转换为微秒：秒 × 1000000 + 纳秒 / 1000 */
     return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)(ts.tv_nsec / 1000ULL);
 }
+
+/**
+ * @brief 获取当前单调时钟时间（纳秒）
+ * 
+ * 与 rkav_now_monotonic_us() 同一时钟源，用于测量单次开销在微秒以下的操作
+ * （例如每包 CRC 计算）。
+ * 
+ * @return uint64_t 当前时间（纳秒）
+ */
+uint64_t rkav_now_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
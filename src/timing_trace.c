@@ -0,0 +1,263 @@
+/**
+ * @file timing_trace.c
+ * @brief 管线时序轨迹的记录与回放
+ *
+ * 记录器双缓冲：事件在锁内追加到 buf，flush 在锁内与 spare 交换后于锁外写盘，
+ * 写盘卡顿只影响统计线程。记录按结构体原样写出（目标平台与开发主机均为小端）。
+ */
+#include "timing_trace.h"
+#include "log.h"
+
+#include "rkav/time.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+/** 模块日志标签 */
+#define TAG "trace"
+
+_Static_assert(sizeof(TimingTraceHeader) == 64, "TimingTraceHeader must be 64 bytes");
+_Static_assert(sizeof(TimingRec) == 16, "TimingRec must be 16 bytes");
+
+static uint32_t clamp32(uint64_t v)
+{
+    return v > UINT32_MAX ? UINT32_MAX : (uint32_t)v;
+}
+
+int timing_trace_open(TimingTrace *t, const char *path, const TimingTraceHeader *info)
+{
+    if (!t || !path || !info) return -1;
+
+    memset(t, 0, sizeof(*t));
+    snprintf(t->path, sizeof(t->path), "%s", path);
+    t->buf   = (TimingRec *)malloc(TT_RING_RECS * sizeof(TimingRec));
+    t->spare = (TimingRec *)malloc(TT_RING_RECS * sizeof(TimingRec));
+    if (!t->buf || !t->spare) {
+        LOGE("[%s] buffer alloc failed", TAG);
+        goto fail;
+    }
+
+    t->fp = fopen(path, "wb");
+    if (!t->fp) {
+        LOGE("[%s] open failed: %s (%s)", TAG, path, strerror(errno));
+        goto fail;
+    }
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    t->hdr = *info;
+    memcpy(t->hdr.magic, TT_MAGIC, 4);
+    t->hdr.version       = TT_VERSION;
+    t->hdr.rec_size      = (uint16_t)sizeof(TimingRec);
+    t->hdr.start_unix_us = (uint64_t)tv.tv_sec * 1000000ull + (uint64_t)tv.tv_usec;
+    t->hdr.lost          = 0;
+    t->start_us          = rkav_now_monotonic_us();
+    if (fwrite(&t->hdr, sizeof(t->hdr), 1, t->fp) != 1) {
+        LOGE("[%s] write header failed: %s", TAG, path);
+        fclose(t->fp);
+        goto fail;
+    }
+
+    pthread_mutex_init(&t->mtx, NULL);
+    LOGI("[%s] recording to %s (cams=%u mics=%u)", TAG, path, t->hdr.cams, t->hdr.mics);
+    return 0;
+
+fail:
+    free(t->buf);
+    free(t->spare);
+    t->buf = t->spare = NULL;
+    t->fp = NULL;
+    return -1;
+}
+
+void timing_trace_event(TimingTrace *t, TimingEv ev, int stream, uint32_t flags,
+                        uint64_t bytes, uint64_t dur_us, uint64_t at_us)
+{
+    if (!t || !t->fp) return;
+
+    uint64_t rel = at_us > t->start_us ? at_us - t->start_us : 0;
+    uint32_t hi  = (uint32_t)(rel >> 32);
+
+    pthread_mutex_lock(&t->mtx);
+    t->events++;
+    size_t need = hi != t->epoch ? 2 : 1;
+    if (t->len + need > TT_RING_RECS) {
+        t->lost++;
+        pthread_mutex_unlock(&t->mtx);
+        return;
+    }
+    if (hi != t->epoch) {
+        TimingRec *e = &t->buf[t->len++];
+        memset(e, 0, sizeof(*e));
+        e->ev    = TT_EV_EPOCH;
+        e->bytes = hi;
+        t->epoch = hi;
+    }
+    TimingRec *r = &t->buf[t->len++];
+    r->t_us   = (uint32_t)rel;
+    r->ev     = (uint8_t)ev;
+    r->stream = (uint8_t)stream;
+    r->flags  = flags > UINT16_MAX ? UINT16_MAX : (uint16_t)flags;
+    r->bytes  = clamp32(bytes);
+    r->dur_us = clamp32(dur_us);
+    pthread_mutex_unlock(&t->mtx);
+}
+
+void timing_trace_flush(TimingTrace *t)
+{
+    if (!t || !t->fp) return;
+
+    pthread_mutex_lock(&t->mtx);
+    TimingRec *out = t->buf;
+    size_t n = t->len;
+    t->buf   = t->spare;
+    t->spare = out;
+    t->len   = 0;
+    pthread_mutex_unlock(&t->mtx);
+
+    if (n && fwrite(out, sizeof(TimingRec), n, t->fp) != n)
+        LOGW("[%s] short write: %s", TAG, t->path);
+}
+
+void timing_trace_close(TimingTrace *t)
+{
+    if (!t || !t->fp) return;
+
+    timing_trace_flush(t);
+    t->hdr.lost = t->lost;
+    if (fseek(t->fp, 0, SEEK_SET) != 0 || fwrite(&t->hdr, sizeof(t->hdr), 1, t->fp) != 1)
+        LOGW("[%s] header update failed: %s", TAG, t->path);
+    fclose(t->fp);
+    t->fp = NULL;
+
+    LOGI("[%s] closed %s: %llu events, %llu lost", TAG, t->path,
+         (unsigned long long)t->events, (unsigned long long)t->lost);
+    pthread_mutex_destroy(&t->mtx);
+    free(t->buf);
+    free(t->spare);
+    t->buf = t->spare = NULL;
+}
+
+int timing_replay_load(TimingReplay *r, const char *path)
+{
+    if (!r || !path) return -1;
+    memset(r, 0, sizeof(*r));
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        LOGE("[%s] open failed: %s (%s)", TAG, path, strerror(errno));
+        return -1;
+    }
+    if (fread(&r->hdr, sizeof(r->hdr), 1, fp) != 1 ||
+        memcmp(r->hdr.magic, TT_MAGIC, 4) != 0 || r->hdr.version != TT_VERSION ||
+        r->hdr.rec_size != sizeof(TimingRec)) {
+        LOGE("[%s] not a timing trace (or unsupported version): %s", TAG, path);
+        fclose(fp);
+        return -1;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long end = ftell(fp);
+    fseek(fp, (long)sizeof(r->hdr), SEEK_SET);
+    size_t cap = end > (long)sizeof(r->hdr) ? (size_t)(end - (long)sizeof(r->hdr)) / sizeof(TimingRec) : 0;
+    r->ev = (TimingEvent *)calloc(cap ? cap : 1, sizeof(TimingEvent));
+    if (!r->ev) {
+        fclose(fp);
+        return -1;
+    }
+
+    /* 展开 EPOCH，时间改为相对首个事件 */
+    uint64_t hi = 0, first = 0;
+    TimingRec rec;
+    while (r->n < cap && fread(&rec, sizeof(rec), 1, fp) == 1) {
+        if (rec.ev == TT_EV_EPOCH) {
+            hi = (uint64_t)rec.bytes << 32;
+            continue;
+        }
+        if (rec.ev >= TT_EV_COUNT) continue;
+        TimingEvent *e = &r->ev[r->n];
+        e->t_us   = hi | rec.t_us;
+        e->ev     = rec.ev;
+        e->stream = rec.stream;
+        e->flags  = rec.flags;
+        e->bytes  = rec.bytes;
+        e->dur_us = rec.dur_us;
+        if (r->n == 0 || e->t_us < first) first = e->t_us;
+        r->n++;
+    }
+    fclose(fp);
+
+    for (size_t i = 0; i < r->n; i++) {
+        r->ev[i].t_us -= first;
+        if (r->ev[i].t_us > r->span_us) r->span_us = r->ev[i].t_us;
+    }
+    LOGI("[%s] loaded %s: %zu events over %.1fs (%ux%u@%u, cams=%u mics=%u, %llu lost at record)",
+         TAG, path, r->n, (double)r->span_us / 1e6, r->hdr.width, r->hdr.height, r->hdr.fps,
+         r->hdr.cams, r->hdr.mics, (unsigned long long)r->hdr.lost);
+    return 0;
+}
+
+size_t timing_replay_count(const TimingReplay *r, TimingEv ev, int stream)
+{
+    if (!r) return 0;
+    size_t n = 0;
+    for (size_t i = 0; i < r->n; i++) {
+        if (r->ev[i].ev == ev && (stream < 0 || r->ev[i].stream == stream))
+            n++;
+    }
+    return n;
+}
+
+void timing_replay_free(TimingReplay *r)
+{
+    if (!r) return;
+    free(r->ev);
+    memset(r, 0, sizeof(*r));
+}
+
+void timing_cursor_init(TimingCursor *c, const TimingReplay *r, TimingEv ev, int stream)
+{
+    if (!c) return;
+    c->r      = r;
+    c->pos    = 0;
+    c->ev     = (uint8_t)ev;
+    c->stream = (uint8_t)stream;
+}
+
+const TimingEvent *timing_cursor_next(TimingCursor *c)
+{
+    if (!c || !c->r) return NULL;
+    while (c->pos < c->r->n) {
+        const TimingEvent *e = &c->r->ev[c->pos++];
+        if (e->ev == c->ev && e->stream == c->stream)
+            return e;
+    }
+    return NULL;
+}
+
+void timing_sleep_until(uint64_t t_us)
+{
+    struct timespec ts = {
+        .tv_sec  = (time_t)(t_us / 1000000ull),
+        .tv_nsec = (long)(t_us % 1000000ull) * 1000L,
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+const char *timing_ev_name(TimingEv ev)
+{
+    switch (ev) {
+    case TT_EV_EPOCH:   return "epoch";
+    case TT_EV_CAPTURE: return "capture";
+    case TT_EV_DROP:    return "drop";
+    case TT_EV_ENCODE:  return "encode";
+    case TT_EV_WRITE:   return "write";
+    case TT_EV_AUDIO:   return "audio";
+    case TT_EV_AWRITE:  return "awrite";
+    default:            return "?";
+    }
+}
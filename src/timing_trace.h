@@ -0,0 +1,212 @@
+/**
+ * @file timing_trace.h
+ * @brief 管线时序轨迹：逐事件记录各环节时刻 / 大小 / 耗时，并按轨迹确定性回放
+ *
+ * 现场的性能问题（采集抖动、存储卡顿导致的丢帧）依赖精确的时序，开发机上很难复现。
+ * 记录（--trace）：采集、编码、写盘各环节每个事件一条 16 字节定长记录：
+ * - CAPTURE：视频帧到达（大小、合帧拷贝耗时、驱动丢帧数）
+ * - DROP：帧在进入 raw 队列前被丢弃（队列满 / 内存不足）
+ * - ENCODE：编码一帧（投递时刻、耗时、输出字节、是否关键帧）
+ * - WRITE / AWRITE：写出一个视频包 / 音频块（耗时、字节）
+ * - AUDIO：音频块到达（字节、读阻塞时长）
+ *
+ * 记录只在内存环形缓冲中追加（加锁拷贝 16 字节），统计线程每秒整块写盘，
+ * 不在采集 / 编码 / 写盘线程里做 I/O，不扰动被测时序；缓冲满时丢弃并计数（写入文件头）。
+ *
+ * 回放（--replay）：timing_replay_load() 读入轨迹，各环节按自己的游标依次取事件：
+ * 合成源按记录的相对时刻产生同样大小的帧 / 音频块，模拟编码器按记录耗时占用编码线程并输出
+ * 同样大小的包，写盘线程按记录耗时补足写出时间。队列、线程与丢帧策略都是真实的，
+ * 因此现场的积压与丢帧可以在开发机上复现，修复后用同一条轨迹验证。
+ *
+ * 时间：记录内为相对轨迹起点的微秒数低 32 位；高 32 位变化时先插入一条 EPOCH 记录，
+ * 单条轨迹可覆盖任意时长。
+ *
+ * 文件布局（小端）：TimingTraceHeader + N × TimingRec
+ *
+ * 典型使用流程：
+ * - 记录：timing_trace_open() -> 各线程 timing_trace_event() -> 统计线程 timing_trace_flush()
+ *   -> timing_trace_close()
+ * - 回放：timing_replay_load() -> 每个环节 timing_cursor_init() / timing_cursor_next()
+ *   -> timing_replay_free()
+ */
+#pragma once
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 轨迹文件魔数 */
+#define TT_MAGIC        "RKTT"
+
+/** 轨迹格式版本 */
+#define TT_VERSION      1
+
+/** 内存缓冲记录数（1 MB，按每秒约 300 个事件足够缓冲数分钟的写盘停顿） */
+#define TT_RING_RECS    65536
+
+/** 事件标志：关键帧（ENCODE / WRITE） */
+#define TT_F_KEY        0x1u
+/** 事件标志：编码失败，无输出（ENCODE） */
+#define TT_F_ERR        0x2u
+
+/** DROP 原因：raw 队列满 */
+#define TT_DROP_QFULL   1u
+/** DROP 原因：分配帧内存失败 */
+#define TT_DROP_NOMEM   2u
+
+/**
+ * @brief 事件类型
+ */
+typedef enum {
+    TT_EV_EPOCH = 0,    /**< 之后记录的时间高 32 位（存于 bytes） */
+    TT_EV_CAPTURE,      /**< 视频帧到达：bytes=帧大小，dur=合帧拷贝耗时，flags=此前驱动丢帧数 */
+    TT_EV_DROP,         /**< 视频帧进入队列前被丢弃：flags=TT_DROP_* */
+    TT_EV_ENCODE,       /**< 编码一帧：时刻=投递，dur=编码耗时（整帧模式不含下发阻塞），bytes=输出字节，flags=TT_F_* */
+    TT_EV_WRITE,        /**< 写出一个视频包：dur=写耗时，bytes，flags=TT_F_KEY */
+    TT_EV_AUDIO,        /**< 音频块到达：bytes，dur=读阻塞时长 */
+    TT_EV_AWRITE,       /**< 写出一个音频块：dur=写耗时，bytes */
+    TT_EV_COUNT
+} TimingEv;
+
+/**
+ * @brief 轨迹文件头（64 字节）：记录时的管线参数，回放时据此重建
+ */
+typedef struct {
+    char     magic[4];      /**< "RKTT" */
+    uint16_t version;       /**< TT_VERSION */
+    uint16_t rec_size;      /**< sizeof(TimingRec) */
+    uint32_t width;
+    uint32_t height;
+    uint32_t fps;
+    uint32_t bitrate;
+    uint32_t sample_rate;
+    uint32_t channels;
+    uint32_t sample_fmt;    /**< RkavSampleFmt */
+    uint32_t cams;          /**< 摄像头路数（0 = 无视频） */
+    uint32_t mics;          /**< 麦克风路数 */
+    uint32_t reserved;
+    uint64_t start_unix_us; /**< 轨迹起点的墙钟时间（仅供查看） */
+    uint64_t lost;          /**< 缓冲满丢弃的记录数（关闭时回填） */
+} TimingTraceHeader;
+
+/**
+ * @brief 轨迹记录（16 字节）
+ */
+typedef struct {
+    uint32_t t_us;          /**< 相对轨迹起点的微秒数（低 32 位） */
+    uint8_t  ev;            /**< TimingEv */
+    uint8_t  stream;        /**< 摄像头 / 麦克风序号 */
+    uint16_t flags;         /**< 事件相关，见 TimingEv */
+    uint32_t bytes;
+    uint32_t dur_us;
+} TimingRec;
+
+/**
+ * @brief 轨迹记录器
+ *
+ * timing_trace_event() 可在任意线程调用；flush / close 由同一个线程调用。
+ */
+typedef struct {
+    FILE             *fp;
+    char              path[512];
+    TimingTraceHeader hdr;
+    uint64_t          start_us;     /**< 轨迹起点（CLOCK_MONOTONIC） */
+
+    pthread_mutex_t   mtx;
+    TimingRec        *buf;          /**< 待写记录 */
+    TimingRec        *spare;        /**< 写盘时与 buf 交换 */
+    size_t            len;
+    uint32_t          epoch;        /**< 最近一条记录的时间高 32 位 */
+    uint64_t          events;       /**< 已接收事件数 */
+    uint64_t          lost;         /**< 缓冲满丢弃数 */
+} TimingTrace;
+
+/**
+ * @brief 回放时的一个事件（时间已展开为 64 位并以首个事件为 0）
+ */
+typedef struct {
+    uint64_t t_us;
+    uint8_t  ev;
+    uint8_t  stream;
+    uint16_t flags;
+    uint32_t bytes;
+    uint32_t dur_us;
+} TimingEvent;
+
+/**
+ * @brief 已载入的轨迹（只读，可被多个游标同时遍历）
+ */
+typedef struct {
+    TimingTraceHeader hdr;
+    TimingEvent      *ev;           /**< 按文件顺序（同一线程的事件时间单调） */
+    size_t            n;
+    uint64_t          span_us;      /**< 最后一个事件的时刻 */
+} TimingReplay;
+
+/**
+ * @brief 一个环节在轨迹中的读取位置（只返回指定类型与序号的事件）
+ */
+typedef struct {
+    const TimingReplay *r;
+    size_t              pos;
+    uint8_t             ev;
+    uint8_t             stream;
+} TimingCursor;
+
+/**
+ * @brief 创建轨迹文件并写入文件头
+ *
+ * @param t     记录器
+ * @param path  输出路径
+ * @param info  管线参数（magic / version / rec_size / 时间字段由本函数填写）
+ * @return int 0 成功，-1 失败
+ */
+int  timing_trace_open(TimingTrace *t, const char *path, const TimingTraceHeader *info);
+
+/**
+ * @brief 追加一个事件（任意线程）
+ *
+ * @param at_us  事件时刻（CLOCK_MONOTONIC 微秒）
+ */
+void timing_trace_event(TimingTrace *t, TimingEv ev, int stream, uint32_t flags,
+                        uint64_t bytes, uint64_t dur_us, uint64_t at_us);
+
+/** 把缓冲中的记录写盘（统计线程每秒调用） */
+void timing_trace_flush(TimingTrace *t);
+
+/** 写出剩余记录、回填文件头并关闭 */
+void timing_trace_close(TimingTrace *t);
+
+/**
+ * @brief 读入轨迹文件
+ *
+ * @return int 0 成功，-1 文件不存在 / 格式不符
+ */
+int  timing_replay_load(TimingReplay *r, const char *path);
+
+/** 某类事件的条数（stream < 0 表示不区分序号） */
+size_t timing_replay_count(const TimingReplay *r, TimingEv ev, int stream);
+
+/** 释放 */
+void timing_replay_free(TimingReplay *r);
+
+/** 初始化游标 */
+void timing_cursor_init(TimingCursor *c, const TimingReplay *r, TimingEv ev, int stream);
+
+/** 取下一个匹配事件，轨迹耗尽返回 NULL */
+const TimingEvent *timing_cursor_next(TimingCursor *c);
+
+/** 睡眠到 CLOCK_MONOTONIC 的 t_us 时刻（已过则立即返回） */
+void timing_sleep_until(uint64_t t_us);
+
+/** 事件类型名称 */
+const char *timing_ev_name(TimingEv ev);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,13 +6,18 @@
  * 
  * 实现细节：
  * - 使用多平面（MPLANE）API 支持 NV12M 格式
- * - 使用 MMAP 方式映射内核缓冲区
+ * - 使用 MMAP 方式映射内核缓冲区，或 EXPBUF 导出 dma-buf 后缓存映射 + 显式同步
  * - 非阻塞模式（O_NONBLOCK）避免 DQBUF 阻塞
  * - 自动将 NV12M 两个平面合成为连续 NV12 数据
  */
 #include "v4l2_capture.h"
+#include "boot_trace.h"
+#include "dmabuf.h"
 #include "log.h"
 
+#include "rkav/time.h"
+
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <errno.h>
@@ -61,6 +66,80 @@ static void fourcc_to_str(uint32_t fourcc, char out[5])
     out[4] = '\0';
 }
 
+const char *v4l2_map_mode_name(V4L2MapMode mode)
+{
+    return mode == V4L2_MAP_DMABUF_SYNC ? "dmabuf" : "mmap";
+}
+
+/*
+ * 映射一个 plane。
+ * dma-buf 模式：EXPBUF 导出该 plane 后 mmap 导出的 fd——dma-buf 的 mmap 由分配者
+ * （videobuf2-dma-contig/sg）实现，在 non-coherent 缓冲上得到的是缓存映射；
+ * CPU 读之前必须用 DMA_BUF_IOCTL_SYNC 使缓存失效，由 v4l2_capture_dqbuf() 在合帧拷贝前后成对完成。
+ * mmap 模式：直接映射驱动导出的 offset（RK 上通常为非缓存映射，无需同步）。
+ *
+ * @return 0 成功；-1 失败
+ */
+static int map_plane(V4L2Capture *cap, unsigned int i, unsigned int p,
+                     const struct v4l2_plane *pl)
+{
+    size_t len = pl->length;
+    void *addr;
+
+    if (cap->map_mode == V4L2_MAP_DMABUF_SYNC) {
+        struct v4l2_exportbuffer exp;
+        memset(&exp, 0, sizeof(exp));
+        exp.type  = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+        exp.index = i;
+        exp.plane = p;
+        exp.flags = O_RDONLY | O_CLOEXEC;
+        if (xioctl(cap->fd, VIDIOC_EXPBUF, &exp) < 0) {
+            LOGE("[%s] EXPBUF[%u][%u] failed: %s", TAG, i, p, strerror(errno));
+            return -1;
+        }
+        addr = mmap(NULL, len, PROT_READ, MAP_SHARED, exp.fd, 0);
+        if (addr == MAP_FAILED) {
+            LOGE("[%s] dmabuf mmap[%u][%u] failed: %s", TAG, i, p, strerror(errno));
+            close(exp.fd);
+            return -1;
+        }
+        cap->bufs[i].dmabuf_fd[p] = exp.fd;
+    } else {
+        addr = mmap(NULL, len,
+                    PROT_READ | PROT_WRITE,
+                    MAP_SHARED,
+                    cap->fd,
+                    pl->m.mem_offset);
+        if (addr == MAP_FAILED) {
+            LOGE("[%s] mmap[%u][%u] failed: %s", TAG, i, p, strerror(errno));
+            return -1;
+        }
+    }
+
+    cap->bufs[i].planes[p]  = addr;
+    cap->bufs[i].lengths[p] = len;
+    return 0;
+}
+
+/* 解除所有 plane 的映射并关闭导出的 dma-buf（不关设备 fd） */
+static void unmap_all(V4L2Capture *cap)
+{
+    for (unsigned int i = 0; i < cap->buf_count; i++) {
+        for (int p = 0; p < V4L2_MAX_PLANES; p++) {
+            if (cap->bufs[i].planes[p] && cap->bufs[i].lengths[p]) {
+                munmap(cap->bufs[i].planes[p],
+                       cap->bufs[i].lengths[p]);
+                cap->bufs[i].planes[p]  = NULL;
+                cap->bufs[i].lengths[p] = 0;
+            }
+            if (cap->bufs[i].dmabuf_fd[p] >= 0) {
+                close(cap->bufs[i].dmabuf_fd[p]);
+                cap->bufs[i].dmabuf_fd[p] = -1;
+            }
+        }
+    }
+}
+
 /*
  * 查询并打印当前设备实际生效的视频格式（VIDIOC_G_FMT）。
  *
@@ -96,29 +175,38 @@ void v4l2_capture_dump_format(V4L2Capture *cap)
 /*
  * 打开 V4L2 设备并初始化采集：
  * 1) open 设备节点
- * 2) 设置采集格式（当前实现固定为 NV12M 两平面）
- * 3) 申请 MMAP buffers，逐个 mmap 映射每个 buffer 的各个 plane
+ * 2) 设置采集格式（当前实现固定为 NV12M 两平面）与帧率
+ * 3) 申请 MMAP buffers，逐个映射每个 buffer 的各个 plane（驱动 mmap 或导出 dma-buf）
  * 4) 将所有 buffer 入队（QBUF），为后续 STREAMON + DQBUF 做准备
  *
  * @param cap    采集上下文（输出）
  * @param dev    设备路径（例如 /dev/video0）
  * @param width  期望宽度
  * @param height 期望高度
+ * @param fps    期望帧率（0 = 驱动默认）
+ * @param mode   映射方式
  * @return       0 成功；-1 失败（失败时内部会清理资源）
  */
 int v4l2_capture_open(V4L2Capture *cap, const char *dev,
-                      unsigned int width, unsigned int height)
+                      unsigned int width, unsigned int height,
+                      unsigned int fps, V4L2MapMode mode)
 {
     if (!cap || !dev) return -1;
 
     memset(cap, 0, sizeof(*cap));
     cap->fd = -1;
+    cap->map_mode = mode;
+    for (int i = 0; i < V4L2_MAX_BUFS; i++)
+        for (int p = 0; p < V4L2_MAX_PLANES; p++)
+            cap->bufs[i].dmabuf_fd[p] = -1;
 
+    boot_trace_begin(BOOT_V4L2_OPEN);
     cap->fd = open(dev, O_RDWR | O_NONBLOCK, 0);
     if (cap->fd < 0) {
         LOGE("[%s] open %s failed: %s", TAG, dev, strerror(errno));
         return -1;
     }
+    boot_trace_end(BOOT_V4L2_OPEN);
 
     /*
      * 设置格式：NV12M 多平面（Y/UV 两个 plane）。
@@ -132,6 +220,7 @@ int v4l2_capture_open(V4L2Capture *cap, const char *dev,
     fmt.fmt.pix_mp.pixelformat = V4L2_PIX_FMT_NV12M;
     fmt.fmt.pix_mp.num_planes  = 2;
 
+    boot_trace_begin(BOOT_V4L2_FMT);
     if (xioctl(cap->fd, VIDIOC_S_FMT, &fmt) < 0) {
         LOGE("[%s] VIDIOC_S_FMT failed: %s", TAG, strerror(errno));
         close(cap->fd);
@@ -159,6 +248,11 @@ int v4l2_capture_open(V4L2Capture *cap, const char *dev,
 
     v4l2_capture_dump_format(cap);
 
+    /* 帧间隔依赖格式，须在 S_FMT 之后设置；不支持时传感器按默认帧率输出 */
+    if (fps > 0 && v4l2_capture_set_fps(cap, fps) != 0)
+        LOGW("[%s] frame rate not settable, sensor runs at its default", TAG);
+    boot_trace_end(BOOT_V4L2_FMT);
+
     /*
      * 申请内核侧采集 buffer（MMAP）。驱动会返回实际分配的 count。
      * 一般至少需要 2 个 buffer 才能较平滑地采集。
@@ -168,11 +262,25 @@ int v4l2_capture_open(V4L2Capture *cap, const char *dev,
     req.count  = V4L2_MAX_BUFS;
     req.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
     req.memory = V4L2_MEMORY_MMAP;
+#ifdef V4L2_MEMORY_FLAG_NON_COHERENT
+    /*
+     * 请求 non-coherent 缓冲：vb2 不再为其建立一致性（非缓存）映射，
+     * 缓存维护改由 QBUF/DQBUF 与 DMA_BUF_IOCTL_SYNC 完成。旧内核忽略该字段。
+     */
+    if (mode == V4L2_MAP_DMABUF_SYNC)
+        req.flags = V4L2_MEMORY_FLAG_NON_COHERENT;
+#endif
 
+    boot_trace_begin(BOOT_V4L2_BUFS);
     if (xioctl(cap->fd, VIDIOC_REQBUFS, &req) < 0) {
         LOGE("[%s] REQBUFS failed: %s", TAG, strerror(errno));
         goto fail;
     }
+#ifdef V4L2_BUF_CAP_SUPPORTS_MMAP_CACHE_HINTS
+    cap->non_coherent = mode == V4L2_MAP_DMABUF_SYNC &&
+                        (req.capabilities & V4L2_BUF_CAP_SUPPORTS_MMAP_CACHE_HINTS) &&
+                        (req.flags & V4L2_MEMORY_FLAG_NON_COHERENT);
+#endif
     if (req.count < 2) {
         LOGE("[%s] not enough buffers", TAG);
         goto fail;
@@ -182,6 +290,24 @@ int v4l2_capture_open(V4L2Capture *cap, const char *dev,
     if (cap->buf_count > V4L2_MAX_BUFS)
         cap->buf_count = V4L2_MAX_BUFS;   // 保护一下
 
+    /*
+     * dma-buf 模式先探测一次 EXPBUF：驱动不支持导出（非 vb2 驱动）时整体回退驱动 mmap，
+     * 避免映射到一半再切换。
+     */
+    if (cap->map_mode == V4L2_MAP_DMABUF_SYNC) {
+        struct v4l2_exportbuffer exp;
+        memset(&exp, 0, sizeof(exp));
+        exp.type  = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+        exp.flags = O_RDONLY | O_CLOEXEC;
+        if (xioctl(cap->fd, VIDIOC_EXPBUF, &exp) < 0) {
+            LOGW("[%s] EXPBUF unsupported (%s), falling back to mmap", TAG, strerror(errno));
+            cap->map_mode = V4L2_MAP_MMAP;
+            cap->non_coherent = false;
+        } else {
+            close(exp.fd);
+        }
+    }
+
     /*
      * mmap 每个 buffer 的两个 plane：Y / UV
      * 典型流程：QUERYBUF 获取每个 plane 的 offset/length，然后逐 plane mmap。
@@ -208,20 +334,9 @@ int v4l2_capture_open(V4L2Capture *cap, const char *dev,
          * 映射各 plane 内存。
          * plane 0 通常是 Y，plane 1 通常是 UV（NV12M）。
          */
-        for (unsigned int p = 0; p < buf.length && p < V4L2_MAX_PLANES && p < V4L2_MAX_PLANES; p++) {
-            size_t len = planes[p].length;
-            void *addr = mmap(NULL, len,
-                              PROT_READ | PROT_WRITE,
-                              MAP_SHARED,
-                              cap->fd,
-                              planes[p].m.mem_offset);
-            if (addr == MAP_FAILED) {
-                LOGE("[%s] mmap[%u][%u] failed: %s", TAG, i, p, strerror(errno));
+        for (unsigned int p = 0; p < buf.length && p < V4L2_MAX_PLANES; p++) {
+            if (map_plane(cap, i, p, &planes[p]) != 0)
                 goto fail;
-            }
-
-            cap->bufs[i].planes[p]  = addr;
-            cap->bufs[i].lengths[p] = len;
         }
 
         /* buffer 入队：让驱动可以往该 buffer 里填充下一帧数据 */
@@ -231,7 +346,9 @@ int v4l2_capture_open(V4L2Capture *cap, const char *dev,
         }
     }
 
-    LOGI("[%s] %u buffers prepared", TAG, cap->buf_count);
+    boot_trace_end(BOOT_V4L2_BUFS);
+    LOGI("[%s] %u buffers prepared, map=%s%s", TAG, cap->buf_count,
+         v4l2_map_mode_name(cap->map_mode), cap->non_coherent ? " non-coherent" : "");
     return 0;
 
 fail:
@@ -239,6 +356,102 @@ fail:
     return -1;
 }
 
+/*
+ * 在当前格式的可用帧间隔中为 fps 选一个（写入 *num / *den）。
+ * 返回 0 表示已从枚举结果中选出；-1 表示驱动不支持枚举，调用方直接请求 1/fps。
+ */
+static int pick_interval(V4L2Capture *cap, unsigned int fps, unsigned int *num, unsigned int *den)
+{
+    struct v4l2_frmivalenum iv;
+    memset(&iv, 0, sizeof(iv));
+    iv.pixel_format = V4L2_PIX_FMT_NV12M;
+    iv.width  = cap->width;
+    iv.height = cap->height;
+    if (xioctl(cap->fd, VIDIOC_ENUM_FRAMEINTERVALS, &iv) < 0)
+        return -1;
+
+    if (iv.type != V4L2_FRMIVAL_TYPE_DISCRETE) {
+        /* 连续 / 步进：1/fps 夹到 [min, max] 间隔内（间隔越小帧率越高），步长由驱动对齐 */
+        const struct v4l2_fract *lo = &iv.stepwise.min, *hi = &iv.stepwise.max;
+        *num = 1;
+        *den = fps;
+        if (lo->denominator && (uint64_t)lo->numerator * fps > lo->denominator) {      /* fps 高于上限 */
+            *num = lo->numerator;
+            *den = lo->denominator;
+        } else if (hi->denominator && (uint64_t)hi->numerator * fps < hi->denominator) { /* fps 低于下限 */
+            *num = hi->numerator;
+            *den = hi->denominator;
+        }
+        return 0;
+    }
+
+    /* 离散：不低于 fps 的最低一档；都低于 fps 时取最高档 */
+    double best_ge = 0.0, best_any = 0.0;
+    struct v4l2_fract ge = { 0, 0 }, any = { 0, 0 };
+    char list[128];
+    int off = 0;
+    for (iv.index = 0; xioctl(cap->fd, VIDIOC_ENUM_FRAMEINTERVALS, &iv) == 0; iv.index++) {
+        if (iv.type != V4L2_FRMIVAL_TYPE_DISCRETE || !iv.discrete.numerator) continue;
+        double f = (double)iv.discrete.denominator / (double)iv.discrete.numerator;
+        if (off < (int)sizeof(list))
+            off += snprintf(list + off, sizeof(list) - (size_t)off, "%s%.2f", off ? "," : "", f);
+        if (f + 0.01 >= (double)fps && (best_ge == 0.0 || f < best_ge)) {
+            best_ge = f;
+            ge = iv.discrete;
+        }
+        if (f > best_any) {
+            best_any = f;
+            any = iv.discrete;
+        }
+    }
+    if (best_any == 0.0) return -1;
+    LOGI("[%s] frame rates at %ux%u: %s", TAG, cap->width, cap->height, off ? list : "-");
+
+    const struct v4l2_fract *pick = best_ge > 0.0 ? &ge : &any;
+    *num = pick->numerator;
+    *den = pick->denominator;
+    return 0;
+}
+
+int v4l2_capture_set_fps(V4L2Capture *cap, unsigned int fps)
+{
+    if (!cap || cap->fd < 0 || fps == 0) return -1;
+
+    struct v4l2_streamparm parm;
+    memset(&parm, 0, sizeof(parm));
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+    if (xioctl(cap->fd, VIDIOC_G_PARM, &parm) < 0 ||
+        !(parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME)) {
+        cap->fps_ctl = false;
+        return -1;
+    }
+    cap->fps_ctl = true;
+
+    unsigned int num = 1, den = fps;
+    pick_interval(cap, fps, &num, &den);
+
+    memset(&parm, 0, sizeof(parm));
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+    parm.parm.capture.timeperframe.numerator   = num;
+    parm.parm.capture.timeperframe.denominator = den;
+    if (xioctl(cap->fd, VIDIOC_S_PARM, &parm) < 0) {
+        LOGW("[%s] VIDIOC_S_PARM %u/%u failed: %s", TAG, num, den, strerror(errno));
+        return -1;
+    }
+
+    cap->tpf_num = parm.parm.capture.timeperframe.numerator;
+    cap->tpf_den = parm.parm.capture.timeperframe.denominator;
+    LOGI("[%s] frame interval %u/%u (%.2f fps, requested %u)", TAG,
+         cap->tpf_num, cap->tpf_den, v4l2_capture_fps(cap), fps);
+    return 0;
+}
+
+double v4l2_capture_fps(const V4L2Capture *cap)
+{
+    if (!cap || !cap->tpf_num || !cap->tpf_den) return 0.0;
+    return (double)cap->tpf_den / (double)cap->tpf_num;
+}
+
 /*
  * 启动视频流（VIDIOC_STREAMON）。
  * 需要在 open() 完成并且至少有若干 buffer 已 QBUF 入队后调用。
@@ -248,10 +461,12 @@ int v4l2_capture_start(V4L2Capture *cap)
     if (!cap || cap->fd < 0) return -1;
 
     enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+    boot_trace_begin(BOOT_V4L2_STREAMON);
     if (xioctl(cap->fd, VIDIOC_STREAMON, &type) < 0) {
         LOGE("[%s] STREAMON failed: %s", TAG, strerror(errno));
         return -1;
     }
+    boot_trace_end(BOOT_V4L2_STREAMON);
 
     LOGI("[%s] STREAMON", TAG);
     return 0;
@@ -311,16 +526,34 @@ int v4l2_capture_dqbuf(V4L2Capture *cap, int *index,
         uv_size = planes[1].bytesused;
 
     uint8_t *dst = cap->nv12_frame;
+    V4L2Buf *vb  = &cap->bufs[idx];
+    bool sync    = cap->map_mode == V4L2_MAP_DMABUF_SYNC;
+    uint64_t t0  = rkav_now_monotonic_ns();
+
+    /*
+     * 缓存映射：SYNC_START(READ) 使该 plane 的缓存行失效，读到 DMA 写入的数据；
+     * SYNC_END 必须成对调用。
+     */
+    if (sync) {
+        dmabuf_sync_begin(vb->dmabuf_fd[0], DMABUF_SYNC_READ);
+        dmabuf_sync_begin(vb->dmabuf_fd[1], DMABUF_SYNC_READ);
+    }
 
     /* 合帧：Y 紧跟 UV，组成连续 NV12 */
     memcpy(dst,
-           cap->bufs[idx].planes[0],
+           vb->planes[0],
            y_size);
 
     memcpy(dst + cap->width * cap->height,
-           cap->bufs[idx].planes[1],
+           vb->planes[1],
            uv_size);
 
+    if (sync) {
+        dmabuf_sync_end(vb->dmabuf_fd[0], DMABUF_SYNC_READ);
+        dmabuf_sync_end(vb->dmabuf_fd[1], DMABUF_SYNC_READ);
+    }
+    cap->last_copy_ns = rkav_now_monotonic_ns() - t0;
+
     *data   = cap->nv12_frame;
     *length = cap->frame_size;
 
@@ -361,7 +594,7 @@ int v4l2_capture_qbuf(V4L2Capture *cap, int index)
 /*
  * 关闭采集并释放资源：
  * - 尝试 STREAMOFF
- * - munmap 所有已映射的 plane
+ * - munmap 所有已映射的 plane，关闭导出的 dma-buf
  * - close fd
  * - free 合帧缓冲（nv12_frame）
  */
@@ -375,16 +608,7 @@ void v4l2_capture_close(V4L2Capture *cap)
         xioctl(cap->fd, VIDIOC_STREAMOFF, &type);
     }
 
-    for (unsigned int i = 0; i < cap->buf_count; i++) {
-        for (int p = 0; p < V4L2_MAX_PLANES; p++) {
-            if (cap->bufs[i].planes[p] && cap->bufs[i].lengths[p]) {
-                munmap(cap->bufs[i].planes[p],
-                       cap->bufs[i].lengths[p]);
-                cap->bufs[i].planes[p]  = NULL;
-                cap->bufs[i].lengths[p] = 0;
-            }
-        }
-    }
+    unmap_all(cap);
 
     if (cap->fd >= 0) {
         close(cap->fd);
@@ -6,7 +6,12 @@
  * 
  * 特性：
  * - 使用 MMAP 方式映射内核缓冲区，减少内存拷贝
+ * - 可选 dma-buf 缓存映射（V4L2_MAP_DMABUF_SYNC）：驱动 mmap 在 RK 上通常为非缓存 /
+ *   写合并映射，合帧 memcpy 只有 DRAM 带宽的几分之一；改为 EXPBUF 导出 dma-buf 后
+ *   缓存映射，读前后用 DMA_BUF_IOCTL_SYNC 做缓存失效（见 dmabuf.h）
  * - 支持多平面格式（NV12M），自动合成为连续 NV12
+ * - 打开时按期望帧率协商帧间隔（VIDIOC_ENUM_FRAMEINTERVALS + VIDIOC_S_PARM），
+ *   运行中可再次调用 v4l2_capture_set_fps() 切换
  * - 非阻塞模式采集，适合实时处理场景
  * 
  * 典型使用流程：
@@ -17,6 +22,7 @@
  */
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -26,6 +32,14 @@
 /** 最大平面数（NV12M 使用 2 个平面：Y 和 UV） */
 #define V4L2_MAX_PLANES  2
 
+/**
+ * @brief 采集缓冲区的 CPU 映射方式
+ */
+typedef enum {
+    V4L2_MAP_MMAP = 0,      /**< 驱动 mmap（默认；RK 上通常非缓存/写合并） */
+    V4L2_MAP_DMABUF_SYNC,   /**< EXPBUF 导出 dma-buf 缓存映射，读前后显式同步 */
+} V4L2MapMode;
+
 /**
  * @brief 单个 V4L2 缓冲区结构
  * 
@@ -34,6 +48,7 @@
 typedef struct {
     void  *planes[V4L2_MAX_PLANES];   /**< 各平面的 mmap 起始地址 */
     size_t lengths[V4L2_MAX_PLANES];  /**< 各平面的 mmap 长度 */
+    int    dmabuf_fd[V4L2_MAX_PLANES];/**< 各平面导出的 dma-buf（V4L2_MAP_DMABUF_SYNC），否则 -1 */
 } V4L2Buf;
 
 /**
@@ -56,21 +71,51 @@ typedef struct {
     size_t        frame_size;          /**< 帧大小（字节） = width × height × 3 / 2 */
 
     uint32_t      last_sequence;       /**< 最近一次 DQBUF 的 sequence（用于丢帧检测） */
+
+    V4L2MapMode   map_mode;            /**< 实际生效的映射方式（EXPBUF 不支持时回退 MMAP） */
+    bool          non_coherent;        /**< 驱动接受了 V4L2_MEMORY_FLAG_NON_COHERENT */
+    uint64_t      last_copy_ns;        /**< 最近一次合帧（含缓存同步）耗时 */
+
+    bool          fps_ctl;             /**< 驱动支持 S_PARM 设置帧间隔（V4L2_CAP_TIMEPERFRAME） */
+    unsigned int  tpf_num;             /**< 驱动生效的帧间隔分子（秒），0 = 未知 */
+    unsigned int  tpf_den;             /**< 驱动生效的帧间隔分母 */
 } V4L2Capture;
 
 /**
  * @brief 打开 V4L2 采集设备
  * 
- * 打开设备节点、设置格式、分配缓冲区并入队。
+ * 打开设备节点、设置格式与帧率、分配缓冲区并入队。
+ * 帧率设置失败（驱动不支持 S_PARM）只告警，传感器保持默认帧率。
  * 
  * @param cap    输出：采集上下文
  * @param dev    设备路径，例如 "/dev/video0"
  * @param width  期望宽度
  * @param height 期望高度
+ * @param fps    期望帧率，0 表示保持驱动默认
+ * @param mode   缓冲区映射方式；V4L2_MAP_DMABUF_SYNC 在驱动不支持 EXPBUF 时回退 MMAP
  * @return int   0 成功，-1 失败
  */
 int  v4l2_capture_open (V4L2Capture *cap, const char *dev,
-                        unsigned int width, unsigned int height);
+                        unsigned int width, unsigned int height,
+                        unsigned int fps, V4L2MapMode mode);
+
+/**
+ * @brief 设置采集帧率（VIDIOC_S_PARM）
+ * 
+ * 先用 VIDIOC_ENUM_FRAMEINTERVALS 在当前格式下选帧间隔：离散列表取不低于 fps 的最低一档
+ * （都低于 fps 时取最高档），连续 / 步进范围按 1/fps 夹到范围内；驱动不支持枚举时直接请求 1/fps。
+ * 生效值以 VIDIOC_S_PARM 返回为准（cap->tpf_num / tpf_den）。
+ * 驱动生效帧率可能高于 fps（传感器没有更低档位），多出的帧由调用方按 PTS 抽掉。
+ * 可在采集过程中调用；部分驱动只在 STREAMOFF 时接受，此时返回 -1 且帧率不变。
+ * 
+ * @param cap 采集上下文
+ * @param fps 期望帧率（> 0）
+ * @return int 0 成功，-1 驱动不支持或拒绝
+ */
+int  v4l2_capture_set_fps(V4L2Capture *cap, unsigned int fps);
+
+/** 驱动生效的帧率（未知时返回 0） */
+double v4l2_capture_fps(const V4L2Capture *cap);
 
 /**
  * @brief 启动视频流
@@ -86,6 +131,7 @@ int  v4l2_capture_start(V4L2Capture *cap);
  * @brief 出队一帧
  * 
  * 从驱动获取一帧已填充的数据，并合成为连续 NV12。
+ * 合帧耗时记录在 cap->last_copy_ns。
  * 使用后需调用 v4l2_capture_qbuf() 归还缓冲区。
  * 
  * @param cap    采集上下文
@@ -118,8 +164,11 @@ void v4l2_capture_dump_format(V4L2Capture *cap);
 /**
  * @brief 关闭采集设备
  * 
- * 停止视频流、解除 mmap 映射、关闭文件描述符。
+ * 停止视频流、解除 mmap 映射、关闭 dma-buf 与设备文件描述符。
  * 
  * @param cap 采集上下文
  */
 void v4l2_capture_close(V4L2Capture *cap);
+
+/** 映射方式名称（"mmap" / "dmabuf"） */
+const char *v4l2_map_mode_name(V4L2MapMode mode);
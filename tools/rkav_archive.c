@@ -0,0 +1,180 @@
+/**
+ * @file rkav_archive.c
+ * @brief 离线归档转码工具
+ *
+ * 把较旧的录像（H.264 Annex-B 段文件，带或不带 .idx）在板子上后台重新编码到归档码率：
+ * MPP 解码 -> 可选缩小 -> MPP 编码，输出写到 -o 目录下的同名文件并生成新的 .idx。
+ * 进程默认以 SCHED_IDLE + IO idle 运行，并按吞吐 / CPU 上限限速，不影响实时录像。
+ * 已存在的输出默认跳过，可反复执行（如 cron 每小时一次）；原录像不修改也不删除。
+ *
+ * 每秒输出 [ARCH] 进度；每个文件结束给出帧率、CPU 占用、限速时间与节省的字节数，最后给出总计。
+ *
+ * 用法：
+ *   rkav_archive -o <dir> [--bitrate 500000] [--size WxH] [--fps 30] [--smart-gop]
+ *                [--max-fps 60] [--cpu-pct 25] [--prio idle|low|normal] [--min-age-h 24]
+ *                [--pool 24] [--backend mpp|mock] [--mock-size 1280x720] [--force] <录像>...
+ *
+ * 退出码：0 全部成功（或跳过），1 有文件失败，2 参数错误
+ */
+#include "archive.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s -o <dir> [--bitrate bps] [--size WxH] [--fps N] [--smart-gop]\n"
+            "          [--max-fps N] [--cpu-pct N] [--prio idle|low|normal] [--min-age-h N]\n"
+            "          [--pool N] [--backend mpp|mock] [--mock-size WxH] [--force] <recording>...\n",
+            prog);
+}
+
+static int parse_size(const char *s, int *w, int *h)
+{
+    if (sscanf(s, "%dx%d", w, h) != 2 || *w < 16 || *h < 16) return -1;
+    return 0;
+}
+
+static double mb(uint64_t bytes)
+{
+    return (double)bytes / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    ArchiveOpts o;
+    archive_default_opts(&o);
+    ArchPrio prio = ARCH_PRIO_IDLE;
+    const char *out_dir = NULL;
+    double min_age_h = 24.0;
+    bool force = false;
+    int first = argc;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (a[0] != '-') { first = i; break; }
+        if (strcmp(a, "--smart-gop") == 0) { o.smart_gop = true; continue; }
+        if (strcmp(a, "--force") == 0)     { force = true; continue; }
+
+        const char *v = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!v) { usage(argv[0]); return 2; }
+        i++;
+        if (strcmp(a, "-o") == 0)               out_dir = v;
+        else if (strcmp(a, "--bitrate") == 0)   o.bitrate = atoi(v);
+        else if (strcmp(a, "--size") == 0) {
+            if (parse_size(v, &o.width, &o.height) != 0) { usage(argv[0]); return 2; }
+        } else if (strcmp(a, "--fps") == 0)     o.fps = atoi(v);
+        else if (strcmp(a, "--max-fps") == 0)   o.max_fps = atof(v);
+        else if (strcmp(a, "--cpu-pct") == 0)   o.cpu_pct = atoi(v);
+        else if (strcmp(a, "--prio") == 0) {
+            if (arch_parse_prio(v, &prio) != 0) { usage(argv[0]); return 2; }
+        } else if (strcmp(a, "--min-age-h") == 0) min_age_h = atof(v);
+        else if (strcmp(a, "--pool") == 0)      o.pool_frames = atoi(v);
+        else if (strcmp(a, "--backend") == 0) {
+            if (arch_parse_backend(v, &o.backend) != 0) { usage(argv[0]); return 2; }
+        } else if (strcmp(a, "--mock-size") == 0) {
+            if (parse_size(v, &o.mock_width, &o.mock_height) != 0) { usage(argv[0]); return 2; }
+        } else { usage(argv[0]); return 2; }
+    }
+    if (!out_dir || first >= argc || o.bitrate <= 0 || o.fps <= 0 || o.max_fps < 0.0 ||
+        o.cpu_pct < 0 || o.cpu_pct > 100 || min_age_h < 0.0) {
+        usage(argv[0]);
+        return 2;
+    }
+    struct stat ds;
+    if (stat(out_dir, &ds) != 0) {
+        fprintf(stderr, "output directory %s: %s\n", out_dir, strerror(errno));
+        return 2;
+    }
+    if (!S_ISDIR(ds.st_mode)) {
+        fprintf(stderr, "output directory %s: not a directory\n", out_dir);
+        return 2;
+    }
+
+    /* 须在创建编解码器之前：MPP 内部线程继承调度策略 */
+    archive_set_priority(prio);
+
+    printf("rkav_archive: backend=%s bitrate=%dkbps size=%s fps=%d max_fps=%.0f cpu=%d%% prio=%s\n",
+           arch_backend_name(o.backend), o.bitrate / 1000, o.width ? "scaled" : "source", o.fps,
+           o.max_fps, o.cpu_pct, prio == ARCH_PRIO_IDLE ? "idle" : prio == ARCH_PRIO_LOW ? "low" : "normal");
+
+    time_t now = time(NULL);
+    unsigned done = 0, skipped = 0, failed = 0;
+    ArchiveResult tot;
+    memset(&tot, 0, sizeof(tot));
+
+    for (int i = first; i < argc; i++) {
+        const char *in = argv[i];
+        const char *base = strrchr(in, '/') ? strrchr(in, '/') + 1 : in;
+        size_t blen = strlen(base);
+        if (blen > 4 && strcmp(base + blen - 4, ".idx") == 0) continue;
+
+        struct stat st;
+        if (stat(in, &st) != 0 || !S_ISREG(st.st_mode)) {
+            printf("  skip %s: not a regular file\n", in);
+            skipped++;
+            continue;
+        }
+        if (difftime(now, st.st_mtime) < min_age_h * 3600.0) {
+            printf("  skip %s: younger than %.0fh\n", in, min_age_h);
+            skipped++;
+            continue;
+        }
+
+        char out[PATH_MAX];
+        snprintf(out, sizeof(out), "%s/%s", out_dir, base);
+        char rin[PATH_MAX], rout[PATH_MAX];
+        if (realpath(out, rout) && realpath(in, rin) && strcmp(rin, rout) == 0) {
+            printf("  skip %s: output would overwrite the input\n", in);
+            skipped++;
+            continue;
+        }
+        struct stat os;
+        if (!force && stat(out, &os) == 0) {
+            printf("  skip %s: %s exists\n", in, out);
+            skipped++;
+            continue;
+        }
+
+        ArchiveResult r;
+        if (archive_file(&o, in, out, &r) != 0) {
+            printf("  FAIL %s\n", in);
+            failed++;
+            continue;
+        }
+        double sec = (double)r.wall_us / 1e6;
+        printf("  done %s: %llu frames %dx%d -> %dx%d%s, %.1ffps, cpu=%.1f%% throttled=%.1fs, "
+               "%.2fMB -> %.2fMB saved %.2fMB (%.0f%%)%s\n",
+               in, (unsigned long long)r.frames, r.src_width, r.src_height, r.out_width, r.out_height,
+               r.from_index ? "" : " (no index)", sec > 0 ? (double)r.frames / sec : 0.0,
+               sec > 0 ? (double)r.cpu_us / (double)r.wall_us * 100.0 : 0.0, (double)r.sleep_us / 1e6,
+               mb(r.bytes_in), mb(r.bytes_out),
+               r.bytes_in > r.bytes_out ? mb(r.bytes_in - r.bytes_out) : 0.0,
+               r.bytes_in ? (1.0 - (double)r.bytes_out / (double)r.bytes_in) * 100.0 : 0.0,
+               r.dec_errors ? " [decode errors skipped]" : "");
+        done++;
+        tot.frames    += r.frames;
+        tot.bytes_in  += r.bytes_in;
+        tot.bytes_out += r.bytes_out;
+        tot.wall_us   += r.wall_us;
+        tot.cpu_us    += r.cpu_us;
+        tot.sleep_us  += r.sleep_us;
+    }
+
+    double sec = (double)tot.wall_us / 1e6;
+    printf("total: files=%u skipped=%u failed=%u frames=%llu %.1ffps cpu=%.1f%% throttled=%.1fs "
+           "in=%.2fMB out=%.2fMB saved=%.2fMB (%.0f%%)\n",
+           done, skipped, failed, (unsigned long long)tot.frames,
+           sec > 0 ? (double)tot.frames / sec : 0.0,
+           sec > 0 ? (double)tot.cpu_us / (double)tot.wall_us * 100.0 : 0.0,
+           (double)tot.sleep_us / 1e6, mb(tot.bytes_in), mb(tot.bytes_out),
+           tot.bytes_in > tot.bytes_out ? mb(tot.bytes_in - tot.bytes_out) : 0.0,
+           tot.bytes_in ? (1.0 - (double)tot.bytes_out / (double)tot.bytes_in) * 100.0 : 0.0);
+    return failed ? 1 : 0;
+}
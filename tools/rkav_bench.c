@@ -0,0 +1,1189 @@
+/**
+ * @file rkav_bench.c
+ * @brief 管线微基准工具
+ *
+ * 每个子命令测一个具体问题，输出可直接贴进评审的表格。
+ *
+ * capmap：采集缓冲 CPU 映射方式对合帧拷贝的影响
+ *   同一组 NV12 帧依次放进不同映射的缓冲，测量“读出到普通内存”的单帧耗时与带宽：
+ *   - malloc          普通缓存内存（上限参考）
+ *   - heap-wc         system-uncached / cma-uncached dma-heap（arm64 上为写合并映射）
+ *   - heap-cached     system / cma dma-heap 缓存映射，读前后 DMA_BUF_IOCTL_SYNC
+ *   - v4l2-mmap       驱动 mmap（需 --dev；RK 上通常为非缓存映射）
+ *   - v4l2-dmabuf     EXPBUF 导出后缓存映射 + 同步（需 --dev，即 --cap-map dmabuf）
+ *   dma-heap 目标每次读之前以 CPU 写入 + SYNC_END(WRITE) 模拟设备写入，
+ *   并冲刷缓存，保证读的是 DRAM 而不是缓存中的旧数据；读完逐字节比对。
+ *   指定 --dev 时，heap 目标使用 v4l2-mmap 采到的帧，否则使用合成帧。
+ *
+ * queue：BQueue（互斥锁 + 条件变量）与 MpmcQueue（无锁 + futex）多线程吞吐对比
+ *   线程数一半生产者、一半消费者，容量默认 64，每个元素携带序号用于校验总和；
+ *   生产者全部结束后 close，消费者取到 0 退出。报告每秒传递的元素数（Mops/s）。
+ *   在 4 核（RK3568）与 8 核（RK3588）上分别运行，线程数超过核数时可看到抢占下的表现。
+ *
+ * wake：等待策略（park / spin-park / spin）的唤醒延迟与 CPU 开销
+ *   一个生产者按固定间隔（--gap-us，可多个）推入发送时刻，一个消费者阻塞 pop 并记录
+ *   “推入 -> 取到”的延迟；同时统计消费者线程 CPU 时间占墙钟时间的比例（等待期间的代价）。
+ *   间隔短于自旋预算（RKAV_SPIN_NS）时 spin-park 不进内核，长于预算时退化为 park。
+ *
+ * aes：录像落盘加密（AES-256-CTR）的单核开销
+ *   按典型编码包大小分别测量硬件实现（ARMv8 Crypto / AES-NI）与查表实现的吞吐，并校验两者输出一致；
+ *   同时换算成每 Mbit 耗时，以及 2/4/8 Mbit/s 码率下占用单核 CPU 的百分比。
+ *   另校验密钥文件加载：末字节为换行 / 空格的 32 字节原始密钥、带结尾换行的十六进制密钥。
+ *
+ * mask：隐私遮挡的单帧开销
+ *   在一组 NV12 合成帧（轮流使用 8 帧，超出末级缓存，接近编码线程拿到新帧时的情况）上施加遮挡，
+ *   先测完整描述，再逐个区域单独测，报告遮挡面积与单帧耗时 avg / p99 / max。
+ *
+ * fstats：帧统计阶段的单帧开销
+ *   同样在 8 帧合成画面上轮流分析，分别按默认采样预算（FS_BUDGET_PX）与整帧逐行采样测量，
+ *   报告行步长、采样像素数、单帧耗时 avg / p99 / max，以及平均耗时占 --fps 帧周期的比例。
+ *
+ * fec：RTP 修复包编解码的单核吞吐
+ *   符号长度取 RTP 最大符号（RTP_SYM_MAX），按 XOR（k 个媒体包 1 个修复包）与 RS（k 个媒体包 m 个修复包）
+ *   若干组合编码 --mb 媒体数据，报告查表实现与向量内核（NEON / SSSE3）的 Mbit/s，
+ *   以及丢 m 个媒体包后还原的 Mbit/s（按整组媒体数据计）；每个组合先按随机丢包校验还原结果逐字节一致。
+ *
+ * aconv：音频采样格式转换的单核吞吐
+ *   对每种设备格式 -> 管线格式的组合（不含直通）测量 Msample/s 与 48kHz 立体声下占单核的百分比；
+ *   测量前先校验：一次转换整块数据（向量主循环）与逐样本转换（标量尾部）的结果逐字节一致，
+ *   FLOAT 输入含恰好落在两个整数正中间的样本（舍入方式必须相同）。抖动为随机噪声，不参与校验。
+ *
+ * 用法：
+ *   rkav_bench capmap [--size WxH] [--frames N] [--dev /dev/videoX]
+ *   rkav_bench queue  [--threads 2,4,8] [--items N] [--cap N]
+ *   rkav_bench wake   [--gap-us 20,1000] [--msgs N]
+ *   rkav_bench aes    [--sizes 1500,16384,131072] [--mb N]
+ *   rkav_bench mask   [--size WxH] [--frames N] [--spec <mask spec>]
+ *   rkav_bench fstats [--size WxH] [--frames N] [--fps N]
+ *   rkav_bench fec    [--mb N]
+ *   rkav_bench aconv  [--samples N]
+ */
+#include "aes256.h"
+#include "audio_convert.h"
+#include "dmabuf.h"
+#include "fec.h"
+#include "frame_stats.h"
+#include "privacy_mask.h"
+#include "rec_crypt.h"
+#include "rtp.h"
+#include "v4l2_capture.h"
+
+#include "rkav/bqueue.h"
+#include "rkav/mpmc.h"
+#include "rkav/time.h"
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/** 冲刷缓存用的 scratch 大小，需大于末级缓存 */
+#define EVICT_BYTES   (32u << 20)
+
+/* ============================================================================
+ * 通用
+ * ============================================================================ */
+
+typedef struct {
+    const char *name;
+    const char *note;       /* 不可用原因，或映射说明 */
+    bool        ok;
+    unsigned    n;
+    uint64_t    bytes;
+    uint64_t    sum_ns, min_ns, max_ns;
+    unsigned    bad;        /* 读出数据与源帧不一致的次数 */
+} CopyResult;
+
+static void result_add(CopyResult *r, uint64_t bytes, uint64_t ns)
+{
+    if (r->n == 0 || ns < r->min_ns) r->min_ns = ns;
+    if (ns > r->max_ns) r->max_ns = ns;
+    r->sum_ns += ns;
+    r->bytes  += bytes;
+    r->n++;
+}
+
+static void result_print(const CopyResult *r)
+{
+    if (!r->ok || r->n == 0) {
+        printf("  %-14s %s\n", r->name, r->note ? r->note : "n/a");
+        return;
+    }
+    printf("  %-14s %6u  %7.3f %7.3f %7.3f  %8.0f  %-6s %s\n", r->name, r->n,
+           (double)r->sum_ns / r->n / 1e6, (double)r->min_ns / 1e6, (double)r->max_ns / 1e6,
+           (double)r->bytes * 1e3 / (double)r->sum_ns,
+           r->bad ? "BAD" : "ok", r->note ? r->note : "");
+}
+
+static uint8_t *g_evict;
+
+/* 写一遍大 scratch，把目标缓冲挤出各级缓存 */
+static void evict_caches(void)
+{
+    static uint8_t v;
+    v++;
+    for (size_t i = 0; i < EVICT_BYTES; i += 64) g_evict[i] = v;
+}
+
+/* ============================================================================
+ * capmap
+ * ============================================================================ */
+
+/* 合成帧：每帧内容不同，避免比对时碰巧相等 */
+static void synth_frame(uint8_t *p, size_t len, unsigned idx)
+{
+    uint32_t x = 0x9e3779b9u * (idx + 1);
+    for (size_t i = 0; i < len; i++) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        p[i] = (uint8_t)x;
+    }
+}
+
+/*
+ * 把 frames 逐帧放进 map（fd >= 0 时按 dma-buf 同步），冲刷缓存后计时读出。
+ * sync 为 false 时不调用 DMA_BUF_IOCTL_SYNC（写合并 / 普通内存）。
+ */
+static void bench_mapping(CopyResult *r, uint8_t *map, int fd, bool sync,
+                          uint8_t **frames, unsigned nframes, size_t len,
+                          unsigned rounds, uint8_t *dst)
+{
+    for (unsigned k = 0; k < rounds; k++) {
+        for (unsigned i = 0; i < nframes; i++) {
+            if (sync) dmabuf_sync_begin(fd, DMABUF_SYNC_WRITE);
+            memcpy(map, frames[i], len);
+            if (sync) dmabuf_sync_end(fd, DMABUF_SYNC_WRITE);
+            evict_caches();
+
+            uint64_t t0 = rkav_now_monotonic_ns();
+            if (sync) dmabuf_sync_begin(fd, DMABUF_SYNC_READ);
+            memcpy(dst, map, len);
+            if (sync) dmabuf_sync_end(fd, DMABUF_SYNC_READ);
+            result_add(r, len, rkav_now_monotonic_ns() - t0);
+
+            if (memcmp(dst, frames[i], len) != 0) r->bad++;
+        }
+    }
+    r->ok = true;
+}
+
+/* 依次尝试若干 dma-heap，返回第一个可分配的堆的 fd 与名称 */
+static int heap_alloc_any(const char *const *heaps, size_t len, const char **used)
+{
+    for (; *heaps; heaps++) {
+        int fd = dmabuf_heap_alloc(*heaps, len);
+        if (fd >= 0) {
+            *used = *heaps;
+            return fd;
+        }
+    }
+    return -1;
+}
+
+static void bench_heap(CopyResult *r, const char *const *heaps, bool sync,
+                       uint8_t **frames, unsigned nframes, size_t len,
+                       unsigned rounds, uint8_t *dst)
+{
+    const char *used = NULL;
+    int fd = heap_alloc_any(heaps, len, &used);
+    if (fd < 0) {
+        r->note = errno == ENOSYS ? "n/a (no dma-heap support in headers)" : "n/a (heap not present)";
+        return;
+    }
+    uint8_t *map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        r->note = "n/a (mmap failed)";
+        close(fd);
+        return;
+    }
+    r->note = used;
+    bench_mapping(r, map, fd, sync, frames, nframes, len, rounds, dst);
+    munmap(map, len);
+    close(fd);
+}
+
+/*
+ * 用给定映射方式采集 nframes 帧，统计 v4l2_capture_dqbuf 内部合帧耗时。
+ * keep 非空时保存采到的帧（供 heap 目标复用同一组帧）。
+ */
+static void bench_v4l2(CopyResult *r, const char *dev, unsigned w, unsigned h,
+                       V4L2MapMode mode, unsigned nframes, uint8_t **keep)
+{
+    V4L2Capture cap;
+    if (v4l2_capture_open(&cap, dev, w, h, 0, mode) != 0) {
+        r->note = "n/a (open failed)";
+        return;
+    }
+    if (cap.map_mode != mode) {
+        r->note = "n/a (EXPBUF unsupported)";
+        v4l2_capture_close(&cap);
+        return;
+    }
+    if (v4l2_capture_start(&cap) != 0) {
+        r->note = "n/a (STREAMON failed)";
+        v4l2_capture_close(&cap);
+        return;
+    }
+
+    /* 丢掉前几帧（曝光/缓冲尚未稳定） */
+    unsigned skip = 5, got = 0;
+    uint64_t deadline = rkav_now_monotonic_us() + 10000000ull;
+    while (got < nframes && rkav_now_monotonic_us() < deadline) {
+        int idx;
+        void *data;
+        size_t len;
+        int ret = v4l2_capture_dqbuf(&cap, &idx, &data, &len);
+        if (ret == 1) { usleep(1000); continue; }
+        if (ret != 0) break;
+        if (skip) {
+            skip--;
+        } else {
+            result_add(r, len, cap.last_copy_ns);
+            if (keep) memcpy(keep[got], data, len);
+            got++;
+        }
+        v4l2_capture_qbuf(&cap, idx);
+    }
+    r->ok = got == nframes;
+    if (!r->ok) r->note = "n/a (capture timeout)";
+    else if (cap.non_coherent) r->note = "non-coherent";
+    v4l2_capture_close(&cap);
+}
+
+static int cmd_capmap(int argc, char **argv)
+{
+    unsigned w = 1920, h = 1080, nframes = 30;
+    const char *dev = NULL;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%ux%u", &w, &h) != 2 || !w || !h) return 2;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            nframes = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--dev") == 0 && i + 1 < argc) {
+            dev = argv[++i];
+        } else {
+            return 2;
+        }
+    }
+    if (nframes == 0) nframes = 1;
+
+    size_t len = (size_t)w * h * 3 / 2;
+    uint8_t **frames = calloc(nframes, sizeof(*frames));
+    uint8_t  *dst    = malloc(len);
+    uint8_t  *plain  = malloc(len);
+    g_evict = malloc(EVICT_BYTES);
+    if (!frames || !dst || !plain || !g_evict) return 2;
+    for (unsigned i = 0; i < nframes; i++) {
+        frames[i] = malloc(len);
+        if (!frames[i]) return 2;
+        synth_frame(frames[i], len, i);
+    }
+
+    /* 帧数较少时多轮重复，保证样本量 */
+    unsigned rounds = nframes >= 100 ? 1 : (100 + nframes - 1) / nframes;
+
+    CopyResult res[5] = {
+        { .name = "malloc" },
+        { .name = "heap-wc" },
+        { .name = "heap-cached" },
+        { .name = "v4l2-mmap" },
+        { .name = "v4l2-dmabuf" },
+    };
+
+    if (dev) {
+        bench_v4l2(&res[3], dev, w, h, V4L2_MAP_MMAP, nframes, frames);
+        bench_v4l2(&res[4], dev, w, h, V4L2_MAP_DMABUF_SYNC, nframes, NULL);
+        if (!res[3].ok) {   /* 采集失败：恢复合成帧 */
+            for (unsigned i = 0; i < nframes; i++) synth_frame(frames[i], len, i);
+        }
+    } else {
+        res[3].note = res[4].note = "n/a (no --dev)";
+    }
+
+    static const char *const wc_heaps[]     = { "system-uncached", "cma-uncached", "system-uncached-dma32", NULL };
+    static const char *const cached_heaps[] = { "system", "cma", "linux,cma", "system-dma32", NULL };
+
+    bench_mapping(&res[0], plain, -1, false, frames, nframes, len, rounds, dst);
+    bench_heap(&res[1], wc_heaps, false, frames, nframes, len, rounds, dst);
+    bench_heap(&res[2], cached_heaps, true, frames, nframes, len, rounds, dst);
+
+    printf("capmap: %ux%u NV12 (%zu bytes/frame), %u %s frames, heap rounds=%u\n",
+           w, h, len, nframes, (dev && res[3].ok) ? "captured" : "synthetic", rounds);
+    printf("  %-14s %6s  %7s %7s %7s  %8s  %-6s %s\n",
+           "mapping", "n", "avg_ms", "min_ms", "max_ms", "MB/s", "verify", "note");
+    for (size_t i = 0; i < sizeof(res) / sizeof(res[0]); i++) result_print(&res[i]);
+
+    for (unsigned i = 0; i < nframes; i++) free(frames[i]);
+    free(frames);
+    free(dst);
+    free(plain);
+    free(g_evict);
+    return 0;
+}
+
+/* ============================================================================
+ * queue
+ * ============================================================================ */
+
+/** 队列实现的统一入口（两种队列的返回值约定相同） */
+typedef struct {
+    const char *name;
+    int  (*init)(void *q, size_t cap);
+    int  (*push)(void *q, void *item);
+    int  (*pop)(void *q, void **out);
+    void (*close)(void *q);
+    void (*destroy)(void *q);
+} QueueOps;
+
+/* queue 子命令：PARK；wake 子命令按需改写 */
+static RkavWait g_bench_wait = RKAV_WAIT_PARK;
+
+static int  bq_init_v(void *q, size_t cap)      { return bq_init_wait((BQueue *)q, cap, g_bench_wait); }
+static int  bq_push_v(void *q, void *item)      { return bq_push((BQueue *)q, item); }
+static int  bq_pop_v(void *q, void **out)       { return bq_pop((BQueue *)q, out); }
+static void bq_close_v(void *q)                 { bq_close((BQueue *)q); }
+static void bq_destroy_v(void *q)               { bq_destroy((BQueue *)q); }
+static int  mpmc_init_v(void *q, size_t cap)    { return mpmc_init_wait((MpmcQueue *)q, cap, g_bench_wait); }
+static int  mpmc_push_v(void *q, void *item)    { return mpmc_push((MpmcQueue *)q, item); }
+static int  mpmc_pop_v(void *q, void **out)     { return mpmc_pop((MpmcQueue *)q, out); }
+static void mpmc_close_v(void *q)               { mpmc_close((MpmcQueue *)q); }
+static void mpmc_destroy_v(void *q)             { mpmc_destroy((MpmcQueue *)q); }
+
+static const QueueOps g_queue_ops[] = {
+    { "bqueue", bq_init_v,   bq_push_v,   bq_pop_v,   bq_close_v,   bq_destroy_v },
+    { "mpmc",   mpmc_init_v, mpmc_push_v, mpmc_pop_v, mpmc_close_v, mpmc_destroy_v },
+};
+
+typedef struct {
+    const QueueOps   *ops;
+    void             *q;
+    pthread_barrier_t *start;
+    uint64_t          first, count;     /* 生产者：推入 [first, first + count) */
+    uint64_t          got, sum;         /* 消费者：取到的个数与序号和 */
+} QueueWorker;
+
+static void *queue_producer(void *arg)
+{
+    QueueWorker *w = (QueueWorker *)arg;
+    pthread_barrier_wait(w->start);
+    for (uint64_t i = w->first; i < w->first + w->count; i++)
+        if (w->ops->push(w->q, (void *)(uintptr_t)(i + 1)) != 0) break;
+    return NULL;
+}
+
+static void *queue_consumer(void *arg)
+{
+    QueueWorker *w = (QueueWorker *)arg;
+    void *item;
+    pthread_barrier_wait(w->start);
+    while (w->ops->pop(w->q, &item) == 1) {
+        w->got++;
+        w->sum += (uintptr_t)item;
+    }
+    return NULL;
+}
+
+/*
+ * 运行一轮：nthreads/2 个生产者，其余为消费者。
+ * @return 吞吐（元素/秒），校验失败返回 -1
+ */
+static double queue_round(const QueueOps *ops, int nthreads, uint64_t items, size_t cap)
+{
+    union { BQueue b; MpmcQueue m; } storage;
+    void *q = &storage;
+    if (ops->init(q, cap) != 0) return -1.0;
+
+    int np = nthreads / 2, nc = nthreads - np;
+    QueueWorker w[64];
+    pthread_t   th[64];
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, (unsigned)nthreads + 1);
+
+    uint64_t per = items / (uint64_t)np;
+    for (int i = 0; i < nthreads; i++) {
+        memset(&w[i], 0, sizeof(w[i]));
+        w[i].ops = ops;
+        w[i].q = q;
+        w[i].start = &start;
+        if (i < np) {
+            w[i].first = (uint64_t)i * per;
+            w[i].count = per;
+        }
+        pthread_create(&th[i], NULL, i < np ? queue_producer : queue_consumer, &w[i]);
+    }
+
+    pthread_barrier_wait(&start);
+    uint64_t t0 = rkav_now_monotonic_ns();
+    for (int i = 0; i < np; i++) pthread_join(th[i], NULL);
+    ops->close(q);
+    for (int i = np; i < nthreads; i++) pthread_join(th[i], NULL);
+    uint64_t dt = rkav_now_monotonic_ns() - t0;
+
+    uint64_t got = 0, sum = 0, n = per * (uint64_t)np;
+    for (int i = np; i < nthreads; i++) {
+        got += w[i].got;
+        sum += w[i].sum;
+    }
+    (void)nc;
+    pthread_barrier_destroy(&start);
+    ops->destroy(q);
+
+    if (got != n || sum != n * (n + 1) / 2) return -1.0;
+    return (double)n * 1e9 / (double)dt;
+}
+
+static int cmd_queue(int argc, char **argv)
+{
+    int threads[16] = { 2, 4, 8 }, nt = 3;
+    uint64_t items = 2000000;
+    size_t cap = 64;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            nt = 0;
+            for (char *tok = strtok(argv[++i], ","); tok && nt < 16; tok = strtok(NULL, ",")) {
+                int t = atoi(tok);
+                if (t < 2 || t > 64) return 2;
+                threads[nt++] = t;
+            }
+        } else if (strcmp(argv[i], "--items") == 0 && i + 1 < argc) {
+            items = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--cap") == 0 && i + 1 < argc) {
+            cap = (size_t)atoi(argv[++i]);
+        } else {
+            return 2;
+        }
+    }
+    if (nt == 0 || items == 0 || cap == 0) return 2;
+
+    printf("queue: cpus=%ld items=%llu cap=%zu (producers = threads/2)\n",
+           sysconf(_SC_NPROCESSORS_ONLN), (unsigned long long)items, cap);
+    printf("  %7s  %12s  %12s  %7s\n", "threads", "bqueue Mop/s", "mpmc Mop/s", "speedup");
+    for (int i = 0; i < nt; i++) {
+        double r[2];
+        for (int k = 0; k < 2; k++) r[k] = queue_round(&g_queue_ops[k], threads[i], items, cap);
+        if (r[0] < 0 || r[1] < 0) {
+            printf("  %7d  verify FAILED (%s)\n", threads[i], r[0] < 0 ? "bqueue" : "mpmc");
+            return 1;
+        }
+        printf("  %7d  %12.2f  %12.2f  %6.2fx\n", threads[i], r[0] / 1e6, r[1] / 1e6, r[1] / r[0]);
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * wake
+ * ============================================================================ */
+
+typedef struct {
+    const QueueOps *ops;
+    void           *q;
+    unsigned        msgs;
+    uint64_t        gap_ns;
+    uint64_t       *lat;        /* 消费者：每条消息的延迟 */
+    unsigned        got;
+    uint64_t        cpu_ns, wall_ns;
+} WakeCtx;
+
+static uint64_t thread_cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void *wake_consumer(void *arg)
+{
+    WakeCtx *c = (WakeCtx *)arg;
+    uint64_t c0 = thread_cpu_ns(), w0 = rkav_now_monotonic_ns();
+    void *item;
+    while (c->got < c->msgs && c->ops->pop(c->q, &item) == 1) {
+        uint64_t now = rkav_now_monotonic_ns();
+        c->lat[c->got++] = now - (uint64_t)(uintptr_t)item;
+    }
+    c->cpu_ns  = thread_cpu_ns() - c0;
+    c->wall_ns = rkav_now_monotonic_ns() - w0;
+    return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int wake_round(const QueueOps *ops, RkavWait wait, uint64_t gap_ns, unsigned msgs)
+{
+    union { BQueue b; MpmcQueue m; } storage;
+    WakeCtx c = { .ops = ops, .q = &storage, .msgs = msgs, .gap_ns = gap_ns };
+    c.lat = calloc(msgs, sizeof(uint64_t));
+    g_bench_wait = wait;
+    if (!c.lat || ops->init(c.q, 4) != 0) return -1;
+
+    pthread_t th;
+    pthread_create(&th, NULL, wake_consumer, &c);
+
+    /* 生产者：绝对时刻定时，避免误差累积；先等消费者进入等待 */
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (unsigned i = 0; i < msgs; i++) {
+        uint64_t ns = (uint64_t)next.tv_nsec + (i == 0 ? 10000000ull : gap_ns);
+        next.tv_sec  += (time_t)(ns / 1000000000ull);
+        next.tv_nsec  = (long)(ns % 1000000000ull);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        ops->push(c.q, (void *)(uintptr_t)rkav_now_monotonic_ns());
+    }
+    pthread_join(th, NULL);
+    ops->close(c.q);
+    ops->destroy(c.q);
+
+    qsort(c.lat, c.got, sizeof(uint64_t), cmp_u64);
+    if (c.got) {
+        printf("  %-7s %-10s %7.1f  %7.1f %7.1f %8.1f  %5.1f%%\n", ops->name, rkav_wait_name(wait),
+               (double)gap_ns / 1e3,
+               (double)c.lat[c.got / 2] / 1e3, (double)c.lat[(size_t)c.got * 99 / 100] / 1e3,
+               (double)c.lat[c.got - 1] / 1e3,
+               c.wall_ns ? (double)c.cpu_ns * 100.0 / (double)c.wall_ns : 0.0);
+    }
+    free(c.lat);
+    return 0;
+}
+
+static int cmd_wake(int argc, char **argv)
+{
+    uint64_t gaps[8] = { 20000, 1000000 };
+    int ng = 2;
+    unsigned msgs = 1000;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--gap-us") == 0 && i + 1 < argc) {
+            ng = 0;
+            for (char *tok = strtok(argv[++i], ","); tok && ng < 8; tok = strtok(NULL, ","))
+                gaps[ng++] = strtoull(tok, NULL, 10) * 1000ull;
+        } else if (strcmp(argv[i], "--msgs") == 0 && i + 1 < argc) {
+            msgs = (unsigned)atoi(argv[++i]);
+        } else {
+            return 2;
+        }
+    }
+    if (ng == 0 || msgs == 0) return 2;
+
+    printf("wake: cpus=%ld msgs=%u spin budget=%uus (latency = push -> pop return, cpu = consumer cpu/wall)\n",
+           sysconf(_SC_NPROCESSORS_ONLN), msgs, RKAV_SPIN_NS / 1000u);
+    printf("  %-7s %-10s %7s  %7s %7s %8s  %6s\n",
+           "queue", "wait", "gap_us", "p50_us", "p99_us", "max_us", "cpu");
+    static const RkavWait waits[] = { RKAV_WAIT_PARK, RKAV_WAIT_SPIN_PARK, RKAV_WAIT_SPIN };
+    for (int g = 0; g < ng; g++)
+        for (size_t k = 0; k < sizeof(g_queue_ops) / sizeof(g_queue_ops[0]); k++)
+            for (size_t w = 0; w < sizeof(waits) / sizeof(waits[0]); w++)
+                if (wake_round(&g_queue_ops[k], waits[w], gaps[g], msgs) != 0) return 1;
+    return 0;
+}
+
+/* ============================================================================
+ * aes
+ * ============================================================================ */
+
+typedef void (*CtrFn)(const Aes256Key *, const uint8_t *, uint64_t, const uint8_t *, uint8_t *, size_t);
+
+/* 以 pkt 字节为一包处理 total 字节，返回 MB/s；偏移连续递增，模拟 sink 逐包写盘 */
+static double aes_round(CtrFn fn, const Aes256Key *k, const uint8_t nonce[8],
+                        const uint8_t *in, uint8_t *out, size_t pkt, uint64_t total)
+{
+    uint64_t off = 0, t0 = rkav_now_monotonic_ns();
+    while (off < total) {
+        fn(k, nonce, off, in, out, pkt);
+        off += pkt;
+    }
+    uint64_t ns = rkav_now_monotonic_ns() - t0;
+    return ns ? (double)off * 1e3 / (double)ns : 0.0;
+}
+
+/*
+ * 把 data 写入临时密钥文件后用 rec_crypt_load_key() 加载，校验值须与直接用 key 初始化的一致。
+ */
+static bool key_file_ok(const char *dir, const uint8_t *data, size_t len, const uint8_t key[32])
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/key", dir);
+    FILE *fp = fopen(path, "wb");
+    if (!fp) return false;
+    bool wrote = fwrite(data, 1, len, fp) == len;
+    fclose(fp);
+
+    RecCryptKey k;
+    int r = wrote ? rec_crypt_load_key(&k, path) : -1;
+    unlink(path);
+    if (r != 0) return false;
+
+    Aes256Key want;
+    uint8_t zero[16] = {0}, check[16];
+    aes256_init(&want, key);
+    aes256_encrypt_block(&want, zero, check);
+    return memcmp(k.key_check, check, sizeof(k.key_check)) == 0;
+}
+
+/*
+ * 密钥文件格式校验：原始密钥末字节为空白字符时不能被当作结尾换行去掉。
+ */
+static bool key_load_verify(void)
+{
+    char dir[] = "/tmp/rkav_bench.XXXXXX";
+    if (!mkdtemp(dir)) return false;
+
+    uint8_t key[32], data[65];
+    static const char hex[] = "0123456789abcdef";
+    bool ok = true;
+    for (int i = 0; i < 32; i++) key[i] = (uint8_t)(i * 53 + 3);
+
+    key[31] = '\n';
+    ok = ok && key_file_ok(dir, key, 32, key);
+    key[31] = ' ';
+    ok = ok && key_file_ok(dir, key, 32, key);
+    for (int i = 0; i < 32; i++) {
+        data[2 * i]     = (uint8_t)hex[key[i] >> 4];
+        data[2 * i + 1] = (uint8_t)hex[key[i] & 15];
+    }
+    data[64] = '\n';
+    ok = ok && key_file_ok(dir, data, 65, key);
+
+    rmdir(dir);
+    return ok;
+}
+
+static int cmd_aes(int argc, char **argv)
+{
+    size_t sizes[8] = { 1500, 16384, 131072 };
+    int ns = 3;
+    unsigned mb = 64;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            ns = 0;
+            for (char *tok = strtok(argv[++i], ","); tok && ns < 8; tok = strtok(NULL, ","))
+                sizes[ns++] = (size_t)strtoul(tok, NULL, 10);
+        } else if (strcmp(argv[i], "--mb") == 0 && i + 1 < argc) {
+            mb = (unsigned)atoi(argv[++i]);
+        } else {
+            return 2;
+        }
+    }
+    if (ns == 0 || mb == 0) return 2;
+
+    size_t max = 0;
+    for (int i = 0; i < ns; i++) {
+        if (sizes[i] == 0) return 2;
+        if (sizes[i] > max) max = sizes[i];
+    }
+
+    uint8_t key[32], nonce[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    for (int i = 0; i < 32; i++) key[i] = (uint8_t)(i * 37 + 11);
+    Aes256Key k;
+    aes256_init(&k, key);
+
+    uint8_t *in = malloc(max), *a = malloc(max), *b = malloc(max);
+    if (!in || !a || !b) { free(in); free(a); free(b); return 1; }
+    for (size_t i = 0; i < max; i++) in[i] = (uint8_t)(i * 131u + 7u);
+
+    /* 非对齐偏移下两种实现必须逐字节一致 */
+    aes256_ctr(&k, nonce, 7, in, a, max);
+    aes256_ctr_portable(&k, nonce, 7, in, b, max);
+    bool same = memcmp(a, b, max) == 0;
+    bool key_ok = key_load_verify();
+
+    /* 没有硬件实现时 aes256_ctr 即查表实现，只测一行 */
+    bool hw = strcmp(aes256_impl_name(), "table") != 0;
+    unsigned table_mb = mb / 16 ? mb / 16 : 1;
+    printf("aes: impl=%s verify=%s keyfile=%s work per size: table %uMB, hw %uMB\n",
+           aes256_impl_name(), same ? "ok" : "MISMATCH", key_ok ? "ok" : "FAILED", table_mb,
+           hw ? mb : 0);
+    printf("  %-7s %8s  %8s %9s  %7s %7s %7s\n",
+           "impl", "pkt", "MB/s", "us/Mbit", "2Mbps", "4Mbps", "8Mbps");
+
+    struct { const char *name; CtrFn fn; unsigned mb; } impls[] = {
+        { "table",            aes256_ctr_portable, table_mb },
+        { aes256_impl_name(), aes256_ctr,          mb },
+    };
+    for (int s = 0; s < ns; s++) {
+        for (size_t m = 0; m < (hw ? 2u : 1u); m++) {
+            uint64_t total = (uint64_t)impls[m].mb << 20;
+            aes_round(impls[m].fn, &k, nonce, in, a, sizes[s], total / 16);   /* 预热 */
+            double mbs = aes_round(impls[m].fn, &k, nonce, in, a, sizes[s], total);
+            double us_mbit = mbs > 0 ? 125000.0 / (mbs * 1e6) * 1e6 : 0.0;    /* 1Mbit = 125000 字节 */
+            printf("  %-7s %8zu  %8.0f %9.2f  %6.3f%% %6.3f%% %6.3f%%\n",
+                   impls[m].name, sizes[s], mbs, us_mbit,
+                   us_mbit * 2 / 1e4, us_mbit * 4 / 1e4, us_mbit * 8 / 1e4);
+        }
+    }
+    free(in); free(a); free(b);
+    return same && key_ok ? 0 : 1;
+}
+
+/* ============================================================================
+ * mask
+ * ============================================================================ */
+
+/** 默认遮挡：1080p 上两块填充、两块马赛克、一个多边形 */
+#define MASK_DEFAULT_SPEC \
+    "rect:0,0,480,270;rect:1440,0,480,270@gray;poly:700,300,1200,280,1250,700,650,720@pix16;" \
+    "rect:100,700,400,300@pix32;poly:1500,600,1800,650,1700,1000"
+
+#define MASK_RING  8
+
+/* 在 ring 帧上轮流施加 spec，打印一行结果；返回 0 成功 */
+static int mask_round(const char *label, const char *spec, VideoFrame *ring, unsigned frames)
+{
+    PrivacyMask pm;
+    if (privacy_mask_init(&pm, ring[0].w, ring[0].h, spec) != 0) return -1;
+
+    uint64_t *ns = calloc(frames, sizeof(uint64_t));
+    if (!ns) {
+        privacy_mask_deinit(&pm);
+        return -1;
+    }
+    privacy_mask_apply(&pm, &ring[0]);  /* 取走遮挡表 */
+    for (unsigned i = 0; i < frames; i++) {
+        uint64_t t0 = rkav_now_monotonic_ns();
+        privacy_mask_apply(&pm, &ring[i % MASK_RING]);
+        ns[i] = rkav_now_monotonic_ns() - t0;
+    }
+    qsort(ns, frames, sizeof(uint64_t), cmp_u64);
+    uint64_t sum = 0;
+    for (unsigned i = 0; i < frames; i++) sum += ns[i];
+
+    printf("  %-44.44s %6.2f%%  %7.3f %7.3f %7.3f\n", label,
+           (double)atomic_load(&pm.stat_pixels) * 100.0 / ((double)ring[0].w * ring[0].h),
+           (double)sum / frames / 1e6, (double)ns[(size_t)frames * 99 / 100] / 1e6,
+           (double)ns[frames - 1] / 1e6);
+    free(ns);
+    privacy_mask_deinit(&pm);
+    return 0;
+}
+
+static int cmd_mask(int argc, char **argv)
+{
+    unsigned w = 1920, h = 1080, frames = 300;
+    const char *spec = MASK_DEFAULT_SPEC;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%ux%u", &w, &h) != 2 || !w || !h) return 2;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--spec") == 0 && i + 1 < argc) {
+            spec = argv[++i];
+        } else {
+            return 2;
+        }
+    }
+    if (frames == 0) frames = 1;
+
+    VideoFrame ring[MASK_RING];
+    size_t size = (size_t)w * h * 3 / 2;
+    memset(ring, 0, sizeof(ring));
+    for (int i = 0; i < MASK_RING; i++) {
+        ring[i].data = malloc(size);
+        if (!ring[i].data) {
+            for (int k = 0; k < i; k++) free(ring[k].data);
+            return 1;
+        }
+        for (size_t k = 0; k < size; k++) ring[i].data[k] = (uint8_t)(k * 7 + (size_t)i * 13 + k / w);
+        ring[i].size = size;
+        ring[i].w = (int)w;
+        ring[i].h = (int)h;
+        ring[i].stride = (int)w;
+    }
+
+    printf("mask: %ux%u NV12 frames=%u (ring of %d frames, %.1fMB)\n",
+           w, h, frames, MASK_RING, (double)size * MASK_RING / 1048576.0);
+    printf("  %-44s %7s  %7s %7s %7s\n", "regions", "cover", "avg_ms", "p99_ms", "max_ms");
+
+    int rc = mask_round("all", spec, ring, frames);
+
+    /* 逐个区域 */
+    char buf[PM_SPEC_MAX];
+    snprintf(buf, sizeof(buf), "%s", spec);
+    char *save = NULL;
+    for (char *tok = strtok_r(buf, ";", &save); tok && rc == 0; tok = strtok_r(NULL, ";", &save))
+        rc = mask_round(tok, tok, ring, frames);
+
+    for (int i = 0; i < MASK_RING; i++) free(ring[i].data);
+    return rc == 0 ? 0 : 1;
+}
+
+/* ============================================================================
+ * fstats
+ * ============================================================================ */
+
+/* 按 budget 采样分析 ring 帧，打印一行结果；返回 0 成功 */
+static int fstats_round(const char *label, uint32_t budget, VideoFrame *ring, unsigned frames, unsigned fps)
+{
+    FrameStats fs;
+    if (frame_stats_init(&fs, (int)fps) != 0) return -1;
+    fs.budget_px = budget;
+
+    uint64_t *ns = calloc(frames, sizeof(uint64_t));
+    if (!ns) {
+        frame_stats_deinit(&fs);
+        return -1;
+    }
+    for (unsigned i = 0; i < frames; i++) {
+        uint64_t t0 = rkav_now_monotonic_ns();
+        frame_stats_process(&fs, &ring[i % MASK_RING]);
+        ns[i] = rkav_now_monotonic_ns() - t0;
+    }
+    FrameStatsSnap snap;
+    frame_stats_get(&fs, &snap);
+    qsort(ns, frames, sizeof(uint64_t), cmp_u64);
+    uint64_t sum = 0;
+    for (unsigned i = 0; i < frames; i++) sum += ns[i];
+    double avg = (double)sum / frames;
+
+    printf("  %-8s %5u %9u  %7.3f %7.3f %7.3f  %6.2f%%\n", label, snap.row_step, snap.samples,
+           avg / 1e6, (double)ns[(size_t)frames * 99 / 100] / 1e6, (double)ns[frames - 1] / 1e6,
+           avg * fps / 1e9 * 100.0);
+    free(ns);
+    frame_stats_deinit(&fs);
+    return 0;
+}
+
+static int cmd_fstats(int argc, char **argv)
+{
+    unsigned w = 1920, h = 1080, frames = 300, fps = 30;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%ux%u", &w, &h) != 2 || w < 3 || h < 3) return 2;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            fps = (unsigned)atoi(argv[++i]);
+        } else {
+            return 2;
+        }
+    }
+    if (frames == 0) frames = 1;
+    if (fps == 0) fps = 30;
+
+    VideoFrame ring[MASK_RING];
+    size_t size = (size_t)w * h * 3 / 2;
+    memset(ring, 0, sizeof(ring));
+    for (int i = 0; i < MASK_RING; i++) {
+        ring[i].data = malloc(size);
+        if (!ring[i].data) {
+            for (int k = 0; k < i; k++) free(ring[k].data);
+            return 1;
+        }
+        /* 棋盘格 + 缓慢平移，带边缘与纹理，接近真实画面的拉普拉斯响应 */
+        for (size_t k = 0; k < size; k++) {
+            size_t x = k % w + (size_t)i * 3, y = k / w;
+            ring[i].data[k] = (uint8_t)((((x / 24) + (y / 24)) & 1) ? 170 + (k * 7) % 13 : 60 + (k * 5) % 11);
+        }
+        ring[i].size = size;
+        ring[i].w = (int)w;
+        ring[i].h = (int)h;
+        ring[i].stride = (int)w;
+        ring[i].frame_id = (uint64_t)i;
+    }
+
+    printf("fstats: %ux%u NV12 frames=%u (ring of %d frames, %.1fMB), period=%.1fms @%ufps\n",
+           w, h, frames, MASK_RING, (double)size * MASK_RING / 1048576.0, 1000.0 / fps, fps);
+    printf("  %-8s %5s %9s  %7s %7s %7s  %7s\n",
+           "sampling", "step", "samples", "avg_ms", "p99_ms", "max_ms", "period");
+
+    int rc = fstats_round("budget", FS_BUDGET_PX, ring, frames, fps);
+    if (rc == 0)
+        rc = fstats_round("full", (uint32_t)((uint64_t)w * h), ring, frames, fps);
+
+    for (int i = 0; i < MASK_RING; i++) free(ring[i].data);
+    return rc == 0 ? 0 : 1;
+}
+
+/* ============================================================================
+ * fec
+ * ============================================================================ */
+
+/* 对数表实现的编码，作为向量内核的对照 */
+static void fec_encode_portable(FecScheme sc, int k, int m, uint8_t *const *data,
+                                uint8_t *const *parity, size_t len)
+{
+    for (int j = 0; j < m; j++) {
+        memset(parity[j], 0, len);
+        for (int i = 0; i < k; i++)
+            fec_gf_mul_add_portable(parity[j], data[i], sc == FEC_XOR ? 1 : fec_rs_coef(k, j, i), len);
+    }
+}
+
+/* 随机丢 m 个媒体包（XOR 为 1 个）后还原，逐字节比对；返回 0 一致 */
+static int fec_verify(FecScheme sc, int k, int m, uint8_t *const *data, uint8_t *const *parity,
+                      uint8_t *const *work, size_t len, unsigned seed)
+{
+    bool have[FEC_MAX_K], phave[FEC_MAX_M];
+    uint8_t *pw[FEC_MAX_M];
+    for (int round = 0; round < 64; round++) {
+        for (int i = 0; i < k; i++) have[i] = true;
+        for (int j = 0; j < m; j++) phave[j] = true;
+        int lost = 0;
+        while (lost < m) {
+            /* 丢的总数为 m，可以落在媒体包或修复包上 */
+            seed = seed * 1103515245u + 12345u;
+            int x = (int)((seed >> 8) % (unsigned)(k + m));
+            bool *f = x < k ? &have[x] : &phave[x - k];
+            if (*f) { *f = false; lost++; }
+        }
+        for (int i = 0; i < k; i++) {
+            if (have[i]) memcpy(work[i], data[i], len);
+            else memset(work[i], 0xa5, len);
+        }
+        for (int j = 0; j < m; j++) {
+            pw[j] = work[k + j];
+            memcpy(pw[j], parity[j], len);
+        }
+        if (fec_decode(sc, k, m, work, have, pw, phave, len) < 0) return -1;
+        for (int i = 0; i < k; i++)
+            if (memcmp(work[i], data[i], len) != 0) return -1;
+    }
+    return 0;
+}
+
+static int cmd_fec(int argc, char **argv)
+{
+    unsigned mb = 64;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--mb") == 0 && i + 1 < argc) {
+            mb = (unsigned)atoi(argv[++i]);
+        } else {
+            return 2;
+        }
+    }
+    if (mb == 0) return 2;
+
+    static const struct { FecScheme sc; int k, m; } cases[] = {
+        { FEC_XOR, 2, 1 }, { FEC_XOR, 4, 1 }, { FEC_XOR, 10, 1 },
+        { FEC_RS, 16, 1 }, { FEC_RS, 16, 2 }, { FEC_RS, 16, 4 }, { FEC_RS, 16, 8 },
+        { FEC_RS, 48, 16 },
+    };
+    const size_t len = RTP_SYM_MAX;
+    const int nbuf = FEC_MAX_K * 2 + FEC_MAX_M * 3;    /* data + par + par2 + work */
+    uint8_t *mem = malloc((size_t)nbuf * len);
+    if (!mem) return 1;
+    uint8_t *data[FEC_MAX_K], *par[FEC_MAX_M], *par2[FEC_MAX_M], *work[FEC_MAX_K + FEC_MAX_M];
+    for (int i = 0; i < FEC_MAX_K; i++) data[i] = mem + (size_t)i * len;
+    for (int j = 0; j < FEC_MAX_M; j++) par[j] = mem + (size_t)(FEC_MAX_K + j) * len;
+    for (int j = 0; j < FEC_MAX_M; j++) par2[j] = mem + (size_t)(FEC_MAX_K + FEC_MAX_M + j) * len;
+    for (int i = 0; i < FEC_MAX_K + FEC_MAX_M; i++)
+        work[i] = mem + (size_t)(FEC_MAX_K + FEC_MAX_M * 2 + i) * len;
+    for (size_t i = 0; i < (size_t)FEC_MAX_K * len; i++) data[0][i] = (uint8_t)(i * 131u + (i >> 9) + 7u);
+
+    printf("fec: impl=%s symbol=%zuB work=%uMB media per case (portable %uMB)\n",
+           fec_impl_name(), len, mb, mb / 16 ? mb / 16 : 1);
+    printf("  %-4s %3s %3s %6s  %10s %10s  %10s  %s\n",
+           "fec", "k", "m", "over", "enc_table", "enc_simd", "dec_simd", "verify");
+
+    int rc = 0;
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        FecScheme sc = cases[c].sc;
+        int k = cases[c].k, m = cases[c].m;
+        uint64_t blk = (uint64_t)k * len;
+
+        fec_encode(sc, k, m, (const uint8_t *const *)data, par, len);
+        fec_encode_portable(sc, k, m, data, par2, len);
+        bool same = true;
+        for (int j = 0; j < m; j++)
+            if (memcmp(par[j], par2[j], len) != 0) same = false;
+        bool ok = same && fec_verify(sc, k, m, data, par, work, len, (unsigned)c + 1) == 0;
+        if (!ok) rc = 1;
+
+        /* 吞吐按媒体数据计：Mbit/s 即单核可保护的码率上限 */
+        uint64_t total = (uint64_t)mb << 20, done = 0, t0 = rkav_now_monotonic_ns();
+        for (; done < total; done += blk)
+            fec_encode(sc, k, m, (const uint8_t *const *)data, par, len);
+        double enc = (double)done * 8e3 / (double)(rkav_now_monotonic_ns() - t0);
+
+        uint64_t ptotal = total / 16 ? total / 16 : blk;
+        t0 = rkav_now_monotonic_ns();
+        for (done = 0; done < ptotal; done += blk)
+            fec_encode_portable(sc, k, m, data, par2, len);
+        double enc_p = (double)done * 8e3 / (double)(rkav_now_monotonic_ns() - t0);
+
+        /* 丢前 m 个媒体包，每轮重新拷入修复包（解码会改写） */
+        bool have[FEC_MAX_K], phave[FEC_MAX_M];
+        for (int i = 0; i < k; i++) have[i] = i >= m;
+        for (int j = 0; j < m; j++) phave[j] = true;
+        uint64_t dns = 0;
+        for (done = 0; done < total / 4; done += blk) {
+            for (int j = 0; j < m; j++) memcpy(work[k + j], par[j], len);
+            t0 = rkav_now_monotonic_ns();
+            fec_decode(sc, k, m, data, have, &work[k], phave, len);
+            dns += rkav_now_monotonic_ns() - t0;
+        }
+        double dec = dns ? (double)done * 8e3 / (double)dns : 0.0;
+
+        printf("  %-4s %3d %3d %5.1f%%  %7.0fMbps %7.0fMbps  %7.0fMbps  %s\n",
+               fec_scheme_name(sc), k, m, 100.0 * m / k, enc_p, enc, dec, ok ? "ok" : "MISMATCH");
+    }
+    free(mem);
+    return rc;
+}
+
+/* ============================================================================
+ * aconv
+ * ============================================================================ */
+
+/** 校验缓冲样本数：不是向量宽度的整数倍，整块转换时也会走到标量尾部 */
+#define ACONV_VERIFY_N  1027
+
+/*
+ * 填充 FLOAT 校验数据：随机样本、越界样本，以及乘以 scale 后恰好为 x.5 的样本。
+ */
+static void aconv_fill_f32(float *f, size_t n, float scale, uint32_t seed)
+{
+    size_t i = 0;
+    for (int k = 0; k < 64 && i < n; k++) {
+        /* 在 (k + 0.5) / scale 附近找乘积精确等于 k + 0.5 的 float，正负各一个 */
+        const float want = (float)k + 0.5f;
+        float up = want / scale, dn = up, v = 0.0f;
+        for (int j = 0; j < 4 && v == 0.0f; j++) {
+            if (up * scale == want)      v = up;
+            else if (dn * scale == want) v = dn;
+            up = nextafterf(up, 2.0f);
+            dn = nextafterf(dn, -2.0f);
+        }
+        if (v == 0.0f) continue;
+        f[i++] = v;
+        if (i < n) f[i++] = -v;
+    }
+    for (; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        f[i] = ((float)(int32_t)seed / 2147483648.0f) * 1.1f;   /* 约 10% 越界，测饱和 */
+    }
+}
+
+static bool aconv_verify(AudioRawFmt src, RkavSampleFmt dst, const uint8_t *in)
+{
+    const size_t ib = audio_raw_fmt_bytes(src), ob = rkav_sample_fmt_bytes(dst);
+    uint8_t *a = malloc(ACONV_VERIFY_N * ob), *b = malloc(ACONV_VERIFY_N * ob);
+    if (!a || !b) { free(a); free(b); return false; }
+
+    AudioConverter cv;
+    audio_converter_init(&cv, src, dst, 0);
+    audio_convert(&cv, a, in, ACONV_VERIFY_N);
+    for (size_t i = 0; i < ACONV_VERIFY_N; i++)
+        audio_convert(&cv, b + i * ob, in + i * ib, 1);
+    bool same = memcmp(a, b, ACONV_VERIFY_N * ob) == 0;
+    free(a);
+    free(b);
+    return same;
+}
+
+static int cmd_aconv(int argc, char **argv)
+{
+    size_t samples = 1u << 20;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            samples = (size_t)strtoul(argv[++i], NULL, 10);
+        } else {
+            return 2;
+        }
+    }
+    if (samples < ACONV_VERIFY_N) samples = ACONV_VERIFY_N;
+
+    /* 4 字节 / 样本足够容纳任何设备格式 */
+    uint8_t *in = malloc(samples * 4), *out = malloc(samples * 4);
+    if (!in || !out) { free(in); free(out); return 1; }
+
+    static const AudioRawFmt srcs[] = { AUDIO_RAW_S16, AUDIO_RAW_S24, AUDIO_RAW_S24_3,
+                                        AUDIO_RAW_S32, AUDIO_RAW_F32 };
+    static const RkavSampleFmt dsts[] = { RKAV_SAMPLE_S16, RKAV_SAMPLE_S32, RKAV_SAMPLE_F32 };
+    int rc = 0;
+
+    printf("aconv: simd=%s samples=%zu\n", audio_convert_simd_name(), samples);
+    printf("  %-9s %-6s  %10s  %9s  %s\n", "src", "dst", "Msample/s", "48k/2ch", "verify");
+    for (size_t si = 0; si < sizeof(srcs) / sizeof(srcs[0]); si++) {
+        for (size_t di = 0; di < sizeof(dsts) / sizeof(dsts[0]); di++) {
+            AudioConverter cv;
+            audio_converter_init(&cv, srcs[si], dsts[di], 0);
+            if (audio_converter_is_passthrough(&cv)) continue;
+
+            uint32_t seed = 0x1234567u + (uint32_t)(si * 3 + di);
+            if (srcs[si] == AUDIO_RAW_F32) {
+                float scale = dsts[di] == RKAV_SAMPLE_S16 ? 32767.0f : 2147483648.0f;
+                aconv_fill_f32((float *)in, samples, scale, seed);
+            } else {
+                for (size_t k = 0; k < samples * 4; k++) {
+                    seed = seed * 1664525u + 1013904223u;
+                    in[k] = (uint8_t)(seed >> 24);
+                }
+            }
+            bool ok = aconv_verify(srcs[si], dsts[di], in);
+            if (!ok) rc = 1;
+
+            audio_convert(&cv, out, in, samples);    /* 预热 */
+            unsigned rounds = 0;
+            uint64_t t0 = rkav_now_monotonic_ns(), ns;
+            do {
+                audio_convert(&cv, out, in, samples);
+                rounds++;
+                ns = rkav_now_monotonic_ns() - t0;
+            } while (ns < 200000000ull);
+            double msps = (double)samples * rounds * 1e3 / (double)ns;
+
+            printf("  %-9s %-6s  %10.1f  %8.3f%%  %s\n", audio_raw_fmt_name(srcs[si]),
+                   rkav_sample_fmt_name(dsts[di]), msps, 96000.0 / (msps * 1e6) * 100.0,
+                   ok ? "ok" : "MISMATCH");
+        }
+    }
+    free(in);
+    free(out);
+    return rc;
+}
+
+/* ============================================================================
+ * 入口
+ * ============================================================================ */
+
+typedef struct {
+    const char *name;
+    int (*fn)(int argc, char **argv);
+    const char *args;
+} BenchCmd;
+
+static const BenchCmd g_cmds[] = {
+    { "capmap", cmd_capmap, "[--size WxH] [--frames N] [--dev /dev/videoX]" },
+    { "queue",  cmd_queue,  "[--threads 2,4,8] [--items N] [--cap N]" },
+    { "wake",   cmd_wake,   "[--gap-us 20,1000] [--msgs N]" },
+    { "aes",    cmd_aes,    "[--sizes 1500,16384,131072] [--mb N]" },
+    { "mask",   cmd_mask,   "[--size WxH] [--frames N] [--spec <mask spec>]" },
+    { "fstats", cmd_fstats, "[--size WxH] [--frames N] [--fps N]" },
+    { "fec",    cmd_fec,    "[--mb N]" },
+    { "aconv",  cmd_aconv,  "[--samples N]" },
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage:\n");
+    for (size_t i = 0; i < sizeof(g_cmds) / sizeof(g_cmds[0]); i++)
+        fprintf(stderr, "  %s %s %s\n", prog, g_cmds[i].name, g_cmds[i].args);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 2) {
+        for (size_t i = 0; i < sizeof(g_cmds) / sizeof(g_cmds[0]); i++) {
+            if (strcmp(argv[1], g_cmds[i].name) == 0) {
+                int r = g_cmds[i].fn(argc - 2, argv + 2);
+                if (r == 2) usage(argv[0]);
+                return r;
+            }
+        }
+    }
+    usage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,216 @@
+/**
+ * @file rkav_catalog.c
+ * @brief 录像目录查询工具
+ *
+ * 只读打开 --catalog 写出的目录文件（不修改目录，也不扫描录像目录），
+ * 列出各流的段，或按时间区间给出需要读取的段文件与字节范围（从区间起点之前最近的关键帧开始）。
+ *
+ * 时间格式（本地时区）："YYYY-mm-dd HH:MM[:SS]"、"HH:MM[:SS]"（今天）、"@<Unix 秒>"
+ *
+ * 用法：
+ *   rkav_catalog <catalog>                                       列出所有段
+ *   rkav_catalog <catalog> -s h264 --from 14:03 --to 14:05       查询区间（-s 流：h264 / pcm[:序号]）
+ *   rkav_catalog <catalog> --bench [n]                           随机查询 n 次，报告平均 / 最大耗时
+ */
+#include "rec_catalog.h"
+#include "rec_index.h"
+
+#include "rkav/time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** 单次查询最多列出的段数 */
+#define MAX_HITS  4096
+
+/* 墙钟微秒 -> "YYYY-mm-dd HH:MM:SS.mmm"（本地时区） */
+static const char *fmt_time(uint64_t us, char *buf, size_t cap)
+{
+    time_t sec = (time_t)(us / 1000000ull);
+    struct tm tm;
+    localtime_r(&sec, &tm);
+    size_t n = strftime(buf, cap, "%Y-%m-%d %H:%M:%S", &tm);
+    snprintf(buf + n, cap - n, ".%03u", (unsigned)(us / 1000ull % 1000ull));
+    return buf;
+}
+
+/* 解析时间参数，失败返回 -1 */
+static int parse_time(const char *s, uint64_t *out)
+{
+    if (s[0] == '@') {
+        *out = (uint64_t)strtoull(s + 1, NULL, 10) * 1000000ull;
+        return 0;
+    }
+
+    time_t now = time(NULL);
+    struct tm today, tm;
+    localtime_r(&now, &today);
+    today.tm_sec = 0;
+
+    /* 失败的 strptime 可能已改写部分字段，每种格式都从“今天”重新开始 */
+    tm = today;
+    const char *end = strptime(s, "%Y-%m-%d %H:%M", &tm);
+    if (!end) {
+        tm  = today;
+        end = strptime(s, "%H:%M", &tm);
+    }
+    if (!end) return -1;
+    if (*end == ':') end = strptime(end + 1, "%S", &tm);
+    if (!end || *end) return -1;
+
+    tm.tm_isdst = -1;
+    time_t t = mktime(&tm);
+    if (t == (time_t)-1) return -1;
+    *out = (uint64_t)t * 1000000ull;
+    return 0;
+}
+
+/* "h264" / "pcm" / "h264:1" */
+static int parse_stream(const char *s, int *kind, int *index)
+{
+    size_t n = strcspn(s, ":");
+    if (n == 4 && strncmp(s, "h264", 4) == 0) *kind = REC_INDEX_H264;
+    else if (n == 3 && strncmp(s, "pcm", 3) == 0) *kind = REC_INDEX_PCM;
+    else return -1;
+    *index = s[n] == ':' ? atoi(s + n + 1) : 0;
+    return 0;
+}
+
+static int list(RecCatalog *cat)
+{
+    char a[40], b[40];
+    for (uint32_t i = 0; i < cat->nsegs; i++) {
+        const RecCatalogSeg *s = &cat->segs[i];
+        if (s->deleted) continue;
+        printf("%6u %s:%u  %s ~ %s  %8.1fs %10llu B %5u keys  %s%s\n",
+               s->id, rec_index_kind_name((RecIndexKind)s->kind), s->index,
+               fmt_time(s->t_start, a, sizeof(a)), fmt_time(s->t_end, b, sizeof(b)),
+               (double)(s->t_end - s->t_start) / 1e6, (unsigned long long)s->bytes,
+               s->nkeys, s->path, s->open ? "  (open)" : "");
+    }
+    printf("segments=%u deleted=%u bytes=%.1fMB\n", cat->live, cat->dead,
+           (double)cat->live_bytes / (1024.0 * 1024.0));
+    return 0;
+}
+
+static int query(RecCatalog *cat, int kind, int index, uint64_t t0, uint64_t t1)
+{
+    static RecCatalogHit hits[MAX_HITS];
+    char a[40], b[40], k[40];
+
+    uint64_t q0 = rkav_now_monotonic_ns();
+    int n = rec_catalog_query(cat, kind, index, t0, t1, hits, MAX_HITS);
+    uint64_t q1 = rkav_now_monotonic_ns();
+
+    for (int i = 0; i < n && i < MAX_HITS; i++) {
+        const RecCatalogHit *h = &hits[i];
+        printf("%s  bytes %llu..%llu%s  [%s ~ %s]  from key %s\n", h->path,
+               (unsigned long long)h->off_begin, (unsigned long long)h->off_end,
+               h->open ? "+ (open)" : "",
+               fmt_time(h->seg_start_us, a, sizeof(a)), fmt_time(h->seg_end_us, b, sizeof(b)),
+               fmt_time(h->key_us, k, sizeof(k)));
+    }
+    printf("%d segment(s), lookup %.1fus\n", n, (double)(q1 - q0) / 1000.0);
+    return n > 0 ? 0 : 1;
+}
+
+/* 在目录覆盖的时间范围内随机查询（1 分钟窗口），测单次查询耗时 */
+static int bench(RecCatalog *cat, int iters)
+{
+    uint64_t lo = UINT64_MAX, hi = 0;
+    for (uint32_t i = 0; i < cat->nsegs; i++) {
+        if (cat->segs[i].deleted) continue;
+        if (cat->segs[i].t_start < lo) lo = cat->segs[i].t_start;
+        if (cat->segs[i].t_end > hi)   hi = cat->segs[i].t_end;
+    }
+    if (hi <= lo || cat->nstreams == 0) {
+        fprintf(stderr, "catalog is empty\n");
+        return 1;
+    }
+
+    RecCatalogHit hit[4];
+    uint64_t total = 0, worst = 0, found = 0;
+    uint64_t seed = 88172645463325252ull;
+    for (int i = 0; i < iters; i++) {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        const RecCatalogStream *st = &cat->streams[seed % (uint64_t)cat->nstreams];
+        uint64_t t0 = lo + (seed >> 8) % (hi - lo);
+
+        uint64_t a = rkav_now_monotonic_ns();
+        int n = rec_catalog_query(cat, st->kind, st->index, t0, t0 + 60000000ull, hit, 4);
+        uint64_t d = rkav_now_monotonic_ns() - a;
+        total += d;
+        if (d > worst) worst = d;
+        if (n > 0) found++;
+    }
+    printf("segments=%u queries=%d hit=%llu avg=%.2fus max=%.2fus\n", cat->live, iters,
+           (unsigned long long)found, (double)total / iters / 1000.0, (double)worst / 1000.0);
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "Usage:\n"
+        "  %s <catalog>                                  列出所有段\n"
+        "  %s <catalog> -s <stream> --from <t> [--to <t>] 查询区间内的段与字节范围\n"
+        "  %s <catalog> --bench [n]                      随机查询 n 次（默认 100000）\n"
+        "  stream: h264 | pcm [:序号]\n"
+        "  t: \"YYYY-mm-dd HH:MM[:SS]\" | \"HH:MM[:SS]\"（今天）| @<Unix 秒>\n"
+        "Exit: 0 成功, 1 无结果, 2 参数或 I/O 错误\n", prog, prog, prog);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL, *from = NULL, *to = NULL, *stream = "h264";
+    int bench_n = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)     { stream = argv[++i]; continue; }
+        if (strcmp(argv[i], "--from") == 0 && i + 1 < argc) { from = argv[++i]; continue; }
+        if (strcmp(argv[i], "--to") == 0 && i + 1 < argc)   { to = argv[++i]; continue; }
+        if (strcmp(argv[i], "--bench") == 0) {
+            bench_n = (i + 1 < argc && argv[i + 1][0] != '-') ? atoi(argv[++i]) : 100000;
+            if (bench_n <= 0) bench_n = 100000;
+            continue;
+        }
+        if (argv[i][0] == '-' || path) { usage(argv[0]); return 2; }
+        path = argv[i];
+    }
+    if (!path) { usage(argv[0]); return 2; }
+
+    int kind = 0, index = 0;
+    uint64_t t0 = 0, t1 = 0;
+    if (from) {
+        if (parse_stream(stream, &kind, &index) != 0) {
+            fprintf(stderr, "bad stream: %s\n", stream);
+            return 2;
+        }
+        if (parse_time(from, &t0) != 0) {
+            fprintf(stderr, "bad time: %s\n", from);
+            return 2;
+        }
+        if (!to) t1 = t0;
+        else if (parse_time(to, &t1) != 0) {
+            fprintf(stderr, "bad time: %s\n", to);
+            return 2;
+        }
+        if (t1 < t0) {
+            fprintf(stderr, "--to is before --from\n");
+            return 2;
+        }
+    }
+
+    RecCatalog cat;
+    if (rec_catalog_open(&cat, path, false) != 0) return 2;
+
+    int rc;
+    if (bench_n)   rc = bench(&cat, bench_n);
+    else if (from) rc = query(&cat, kind, index, t0, t1);
+    else           rc = list(&cat);
+
+    rec_catalog_close(&cat);
+    return rc;
+}
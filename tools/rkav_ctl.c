@@ -0,0 +1,75 @@
+/**
+ * @file rkav_ctl.c
+ * @brief 运行时控制通道客户端
+ *
+ * 把命令行参数拼成一条命令发给 s1_rk_queue 的控制套接字（--ctl），打印回复。
+ *
+ * 用法：
+ *   rkav_ctl <socket> help
+ *   rkav_ctl <socket> mask
+ *   rkav_ctl <socket> mask set 'rect:0,0,320,180;poly:900,400,1100,380,1120,600@pix24'
+ *   rkav_ctl <socket> mask add rect:1600,900,320,180@gray
+ *   rkav_ctl <socket> mask clear
+ */
+#include "ctl.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr,
+            "Usage:\n"
+            "  %s <socket> <command> [args...]   发送一条控制命令（help 列出全部命令）\n"
+            "Exit: 0 回复 ok, 1 回复 err, 2 连接 / 参数错误\n", argv[0]);
+        return 2;
+    }
+
+    char msg[CTL_MSG_MAX];
+    size_t off = 0;
+    for (int i = 2; i < argc; i++) {
+        int n = snprintf(msg + off, sizeof(msg) - off, "%s%s", i > 2 ? " " : "", argv[i]);
+        if (n < 0 || (size_t)n >= sizeof(msg) - off) {
+            fprintf(stderr, "command too long (max %d)\n", CTL_MSG_MAX - 1);
+            return 2;
+        }
+        off += (size_t)n;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(argv[1]) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "socket path too long\n");
+        return 2;
+    }
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", argv[1]);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "cannot connect %s: %s\n", argv[1], strerror(errno));
+        if (fd >= 0) close(fd);
+        return 2;
+    }
+    if (send(fd, msg, off, 0) < 0) {
+        fprintf(stderr, "send failed: %s\n", strerror(errno));
+        close(fd);
+        return 2;
+    }
+
+    char reply[CTL_MSG_MAX];
+    ssize_t n = recv(fd, reply, sizeof(reply) - 1, 0);
+    close(fd);
+    if (n <= 0) {
+        fprintf(stderr, "no reply\n");
+        return 2;
+    }
+    reply[n] = '\0';
+    printf("%s\n", reply);
+    return strncmp(reply, "ok", 2) == 0 ? 0 : 1;
+}
@@ -0,0 +1,415 @@
+/**
+ * @file rkav_fec.c
+ * @brief RTP FEC 丢包回环测试
+ *
+ * 发送端与接收端都在本进程内：RtpSender 把帧打成 RTP 包与修复包，经 127.0.0.1 的 UDP 发出，
+ * 本工具收回每个包后先留一份原样副本，再按 Gilbert-Elliott 模型决定是否“丢掉”（不交给接收端），
+ * 未丢的包交给 RtpRx。每帧发完后逐个序号检查：收到的、由修复包还原的（与原样副本逐字节比对），
+ * 以及仍然缺失的；一帧的媒体包全部可用即计为完整帧。
+ *
+ * 丢包模型：好 / 坏两个状态，坏状态下全丢；--loss 为平均丢包率，--burst 为平均连续丢包长度
+ * （1 即独立丢包）。媒体包与修复包经过同一个信道。
+ *
+ * 帧来源：
+ * - 合成（默认）：按 --kbps / --fps / --gop 生成关键帧（约 5 倍平均帧大小）与 P 帧，
+ *   --svc-t 时按时间层标注，大帧切成多个 slice 下发（与低延迟编码输出相同）
+ * - --in <file.h264>：AnnexB 裸流按访问单元切帧（不分层）
+ *
+ * 用法：
+ *   rkav_fec [--fec off|xor|rs] [--fec-prot key=50,t0=25] [--loss 5] [--burst 2] [--frames 600]
+ *            [--fps 30] [--kbps 4000] [--gop 60] [--svc-t 1] [--in file.h264] [--seed 1]
+ *
+ * 退出码：0 所有还原的包都与原包一致，1 有不一致，2 参数 / 环境错误
+ */
+#include "fec.h"
+#include "rtp.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/** 合成帧的 slice 上限（一次下发后立即收回，不让接收缓冲溢出） */
+#define SLICE_MAX    (16 * 1024)
+
+/** 原样副本按序号缓存 */
+#define WIRE_SLOTS   4096
+
+typedef struct {
+    bool     have;
+    uint16_t seq;
+    uint16_t len;
+    uint8_t  pkt[RTP_MTU];
+} WireSlot;
+
+typedef struct {
+    int       rx_fd;
+    RtpRx     rx;
+    WireSlot *wire;
+    uint64_t  rng;
+    double    p_gb;         /* 好 -> 坏 */
+    double    p_bg;         /* 坏 -> 好 */
+    bool      bad;
+
+    uint64_t  wire_media, wire_fec;
+    uint64_t  lost_media, lost_fec;
+} Loop;
+
+static double rnd(Loop *l)
+{
+    /* xorshift64* */
+    l->rng ^= l->rng >> 12;
+    l->rng ^= l->rng << 25;
+    l->rng ^= l->rng >> 27;
+    return (double)((l->rng * 2685821657736338717ull) >> 11) / 9007199254740992.0;
+}
+
+static bool channel_drop(Loop *l)
+{
+    if (l->bad) {
+        if (rnd(l) < l->p_bg) l->bad = false;
+    } else {
+        if (rnd(l) < l->p_gb) l->bad = true;
+    }
+    return l->bad;
+}
+
+/* 收回已发出的所有包：留副本、过信道、交给接收端 */
+static void drain(Loop *l)
+{
+    uint8_t buf[2048];
+    for (;;) {
+        ssize_t n = recv(l->rx_fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n < 0) break;
+        if (n < RTP_HDR_LEN) continue;
+
+        bool media = (buf[1] & 0x7f) == RTP_PT_H264;
+        if (media) {
+            uint16_t seq = (uint16_t)((buf[2] << 8) | buf[3]);
+            WireSlot *w = &l->wire[seq % WIRE_SLOTS];
+            w->have = true;
+            w->seq  = seq;
+            w->len  = (uint16_t)n;
+            memcpy(w->pkt, buf, (size_t)n);
+            l->wire_media++;
+        } else {
+            l->wire_fec++;
+        }
+        if (channel_drop(l)) {
+            if (media) l->lost_media++;
+            else       l->lost_fec++;
+            continue;
+        }
+        rtp_rx_input(&l->rx, buf, (size_t)n);
+    }
+}
+
+/* ============================================================================
+ * 帧来源
+ * ============================================================================ */
+
+typedef struct {
+    uint8_t *data;
+    size_t   size;
+    bool     key;
+    int      tid;
+} Frame;
+
+/* 合成一帧：关键帧带 SPS / PPS，负载为不含起始码的随机字节 */
+static void synth_frame(Frame *f, Loop *l, unsigned n, unsigned gop, int layers, size_t avg)
+{
+    f->key = n % gop == 0;
+    unsigned period = 1u << (layers - 1), pos = n % period;
+    f->tid = 0;
+    if (!f->key && pos) {
+        int tz = 0;
+        while (!(pos & (1u << tz))) tz++;
+        f->tid = layers - 1 - tz;
+    }
+
+    size_t body = f->key ? avg * 5 : (size_t)((double)avg * (0.5 + rnd(l)));
+    if (body < 16) body = 16;
+    size_t nsl = (body + SLICE_MAX - 1) / SLICE_MAX;
+    f->size = (f->key ? 4 + 10 + 4 + 5 : 0) + nsl * 4 + body + nsl;
+    f->data = (uint8_t *)malloc(f->size);
+    if (!f->data) {
+        f->size = 0;
+        return;
+    }
+
+    uint8_t *p = f->data;
+    static const uint8_t sc[4] = { 0, 0, 0, 1 };
+    if (f->key) {
+        static const uint8_t sps[10] = { 0x67, 0x64, 0x00, 0x28, 0xac, 0xd9, 0x40, 0x78, 0x02, 0x27 };
+        static const uint8_t pps[5]  = { 0x68, 0xeb, 0xe3, 0xcb, 0x22 };
+        memcpy(p, sc, 4); p += 4; memcpy(p, sps, 10); p += 10;
+        memcpy(p, sc, 4); p += 4; memcpy(p, pps, 5);  p += 5;
+    }
+    for (size_t s = 0; s < nsl; s++) {
+        size_t len = s + 1 < nsl ? SLICE_MAX : body - s * SLICE_MAX;
+        memcpy(p, sc, 4); p += 4;
+        *p++ = f->key ? 0x65 : (f->tid + 1 < layers || layers == 1 ? 0x41 : 0x01);
+        for (size_t i = 0; i < len; i++)
+            *p++ = (uint8_t)(1 + (rnd(l) * 254.0));
+    }
+    f->size = (size_t)(p - f->data);
+}
+
+/* 从 from 开始查找下一个 00 00 01 */
+static size_t next_sc(const uint8_t *d, size_t n, size_t from)
+{
+    for (size_t i = from; i + 3 <= n; i++)
+        if (d[i] == 0 && d[i + 1] == 0 && d[i + 2] == 1) return i;
+    return n;
+}
+
+/* 起始码起点（含 4 字节起始码的前导 0） */
+static size_t sc_begin(const uint8_t *d, size_t at)
+{
+    return at > 0 && d[at - 1] == 0 ? at - 1 : at;
+}
+
+/* 从 AnnexB 裸流切出下一个访问单元，返回 0 成功，-1 读完 */
+static int file_frame(Frame *f, const uint8_t *d, size_t n, size_t *pos)
+{
+    size_t at = next_sc(d, n, *pos);
+    if (at >= n) return -1;
+    size_t begin = sc_begin(d, at);
+    bool vcl = false, key = false;
+
+    while (at < n) {
+        size_t h = at + 3;
+        if (h >= n) break;
+        int type = d[h] & 0x1f;
+        bool is_vcl = type == 1 || type == 5;
+        /* 已有 VCL 后遇到 AUD / SPS / PPS / SEI，或新一帧的首个 slice（first_mb_in_slice == 0） */
+        if (vcl && (!is_vcl || (h + 1 < n && (d[h + 1] & 0x80))))
+            break;
+        if (is_vcl) vcl = true;
+        if (type == 5) key = true;
+        at = next_sc(d, n, h);
+    }
+    size_t end = at < n ? sc_begin(d, at) : n;
+    f->data = (uint8_t *)malloc(end - begin);
+    if (!f->data) return -1;
+    memcpy(f->data, d + begin, end - begin);
+    f->size = end - begin;
+    f->key  = key;
+    f->tid  = 0;
+    *pos = end;
+    return 0;
+}
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    long sz = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *buf = sz > 0 ? (uint8_t *)malloc((size_t)sz) : NULL;
+    if (buf && fread(buf, 1, (size_t)sz, fp) != (size_t)sz) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+    *len = buf ? (size_t)sz : 0;
+    return buf;
+}
+
+/* ============================================================================
+ * 入口
+ * ============================================================================ */
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [--fec off|xor|rs] [--fec-prot key=50,t0=25] [--loss pct] [--burst n]\n"
+            "          [--frames N] [--fps N] [--kbps N] [--gop N] [--svc-t N] [--in file.h264] [--seed N]\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    FecScheme scheme = FEC_RS;
+    uint8_t prot[RTP_CLS_COUNT];
+    rtp_default_prot(prot);
+    double loss = 5.0, burst = 2.0;
+    unsigned frames = 600, fps = 30, kbps = 4000, gop = 60, seed = 1;
+    int layers = 1;
+    const char *in = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const char *v = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!v) { usage(argv[0]); return 2; }
+        i++;
+        if (strcmp(a, "--fec") == 0) {
+            if (fec_parse_scheme(v, &scheme) != 0) { usage(argv[0]); return 2; }
+        } else if (strcmp(a, "--fec-prot") == 0) {
+            if (rtp_parse_prot(v, prot) != 0) { usage(argv[0]); return 2; }
+        } else if (strcmp(a, "--loss") == 0)   loss = atof(v);
+        else if (strcmp(a, "--burst") == 0)    burst = atof(v);
+        else if (strcmp(a, "--frames") == 0)   frames = (unsigned)atoi(v);
+        else if (strcmp(a, "--fps") == 0)      fps = (unsigned)atoi(v);
+        else if (strcmp(a, "--kbps") == 0)     kbps = (unsigned)atoi(v);
+        else if (strcmp(a, "--gop") == 0)      gop = (unsigned)atoi(v);
+        else if (strcmp(a, "--svc-t") == 0)    layers = atoi(v);
+        else if (strcmp(a, "--in") == 0)       in = v;
+        else if (strcmp(a, "--seed") == 0)     seed = (unsigned)atoi(v);
+        else { usage(argv[0]); return 2; }
+    }
+    if (loss < 0.0 || loss >= 100.0 || burst < 1.0 || frames == 0 || fps == 0 || gop == 0 ||
+        layers < 1 || layers > 4) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    size_t in_len = 0, in_pos = 0;
+    uint8_t *in_buf = NULL;
+    if (in && !(in_buf = read_file(in, &in_len))) {
+        fprintf(stderr, "read %s: %s\n", in, strerror(errno));
+        return 2;
+    }
+
+    /* 接收 socket：127.0.0.1 临时端口，缓冲尽量大，保证一帧的包都能留在内核里等 drain() */
+    Loop l;
+    memset(&l, 0, sizeof(l));
+    l.rng = 0x9e3779b97f4a7c15ull ^ ((uint64_t)seed * 0x100000001b3ull);
+    double pl = loss / 100.0;
+    l.p_bg = 1.0 / burst;
+    l.p_gb = pl > 0.0 ? pl * l.p_bg / (1.0 - pl) : 0.0;
+
+    struct sockaddr_in addr;
+    socklen_t alen = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int rcvbuf = 8 << 20;
+    l.rx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int tx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (l.rx_fd < 0 || tx_fd < 0 ||
+        setsockopt(l.rx_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) != 0 ||
+        bind(l.rx_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        getsockname(l.rx_fd, (struct sockaddr *)&addr, &alen) != 0 ||
+        connect(tx_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "loopback socket: %s\n", strerror(errno));
+        return 2;
+    }
+
+    RtpSender tx;
+    l.wire = (WireSlot *)calloc(WIRE_SLOTS, sizeof(WireSlot));
+    if (!l.wire || rtp_rx_init(&l.rx) != 0 || rtp_sender_init(&tx, tx_fd, scheme, prot) != 0) {
+        fprintf(stderr, "out of memory\n");
+        return 2;
+    }
+
+    printf("rkav_fec: fec=%s (%s) prot key=%u t0=%u t1=%u t2=%u t3=%u loss=%.1f%% burst=%.1f seed=%u\n",
+           fec_scheme_name(scheme), fec_impl_name(), prot[0], prot[1], prot[2], prot[3], prot[4],
+           loss, burst, seed);
+    if (in)
+        printf("  source %s (%zu bytes)\n", in, in_len);
+    else
+        printf("  source synthetic %ukbps@%ufps gop=%u svc-t=%d\n", kbps, fps, gop, layers);
+
+    size_t avg = (size_t)kbps * 1000u / 8u / fps;
+    uint64_t sent_frames = 0, intact[RTP_CLS_COUNT] = { 0 }, total[RTP_CLS_COUNT] = { 0 };
+    uint64_t media_total = 0, residual = 0, recovered = 0, mismatch = 0, unverified = 0;
+
+    for (unsigned n = 0; n < frames; n++) {
+        Frame f;
+        memset(&f, 0, sizeof(f));
+        if (in_buf) {
+            if (file_frame(&f, in_buf, in_len, &in_pos) != 0) break;
+        } else {
+            synth_frame(&f, &l, n, gop, layers, avg);
+            if (!f.data) break;
+        }
+        RtpClass cls = rtp_class_of(f.key, f.tid);
+        uint64_t pts = (uint64_t)n * 1000000u / fps;
+        uint16_t first = tx.seq;
+
+        /* 合成帧按 slice（每个 NAL 一次）下发，模拟低延迟编码输出；文件帧整帧下发 */
+        size_t off = 0;
+        while (off < f.size) {
+            size_t end = f.size;
+            if (!in_buf) {
+                /* 合成帧都用 4 字节起始码；SPS / PPS 与首个 slice 同一次下发 */
+                bool vcl = false;
+                end = off;
+                while (end < f.size && !vcl) {
+                    vcl = (f.data[end + 4] & 0x1f) < 6;
+                    size_t nal = next_sc(f.data, f.size, end + 4);
+                    end = nal < f.size ? sc_begin(f.data, nal) : f.size;
+                }
+            }
+            rtp_sender_frame(&tx, f.data + off, end - off, pts, cls, end == f.size);
+            drain(&l);
+            off = end;
+        }
+        free(f.data);
+
+        bool ok = true;
+        for (uint16_t s = first; s != tx.seq; s++) {
+            size_t len = 0;
+            bool rec = false;
+            const uint8_t *p = rtp_rx_get(&l.rx, s, &len, &rec);
+            media_total++;
+            if (!p) {
+                residual++;
+                ok = false;
+                continue;
+            }
+            if (!rec) continue;
+            recovered++;
+            const WireSlot *w = &l.wire[s % WIRE_SLOTS];
+            if (!w->have || w->seq != s)
+                unverified++;   /* 原包在内核接收缓冲就被丢了，无从比对 */
+            else if (w->len != len || memcmp(w->pkt, p, len) != 0)
+                mismatch++;
+        }
+        total[cls]++;
+        if (ok) intact[cls]++;
+        sent_frames++;
+    }
+
+    uint64_t media_pkts = atomic_load(&tx.media_pkts), fec_pkts = atomic_load(&tx.fec_pkts);
+    uint64_t media_bytes = atomic_load(&tx.media_bytes), fec_bytes = atomic_load(&tx.fec_bytes);
+    uint64_t fec_ns = atomic_load(&tx.fec_ns), fec_in = atomic_load(&tx.fec_in_bytes);
+    uint64_t wire_lost = media_pkts + fec_pkts - l.wire_media - l.wire_fec;
+
+    printf("  sent     frames=%llu media=%llu repair=%llu overhead=+%.1f%% (bytes +%.1f%%)\n",
+           (unsigned long long)sent_frames, (unsigned long long)media_pkts,
+           (unsigned long long)fec_pkts, media_pkts ? 100.0 * fec_pkts / media_pkts : 0.0,
+           media_bytes ? 100.0 * fec_bytes / media_bytes : 0.0);
+    printf("  channel  media lost=%llu (%.2f%%) repair lost=%llu kernel drops=%llu\n",
+           (unsigned long long)l.lost_media,
+           l.wire_media ? 100.0 * l.lost_media / l.wire_media : 0.0,
+           (unsigned long long)l.lost_fec, (unsigned long long)wire_lost);
+    printf("  receiver recovered=%llu mismatch=%llu unverified=%llu residual=%llu (%.3f%%)\n",
+           (unsigned long long)recovered, (unsigned long long)mismatch,
+           (unsigned long long)unverified, (unsigned long long)residual,
+           media_total ? 100.0 * residual / media_total : 0.0);
+    printf("  frames   intact");
+    for (int c = 0; c < RTP_CLS_COUNT; c++) {
+        if (!total[c]) continue;
+        printf(" %s=%llu/%llu", rtp_class_name((RtpClass)c), (unsigned long long)intact[c],
+               (unsigned long long)total[c]);
+    }
+    printf("\n");
+    if (fec_ns)
+        printf("  encode   %.0fMbit/s per core (%llu media bytes in %.2fms)\n",
+               (double)fec_in * 8e3 / (double)fec_ns, (unsigned long long)fec_in, (double)fec_ns / 1e6);
+
+    rtp_sender_deinit(&tx);
+    rtp_rx_deinit(&l.rx);
+    free(l.wire);
+    free(in_buf);
+    close(tx_fd);
+    close(l.rx_fd);
+    return mismatch ? 1 : 0;
+}
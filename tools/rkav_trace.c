@@ -0,0 +1,176 @@
+/**
+ * @file rkav_trace.c
+ * @brief 时序轨迹查看工具
+ *
+ * 读取 --trace 写出的轨迹文件，按环节汇总：事件数、字节、耗时分位数，
+ * 采集 / 音频的到达间隔抖动与迟到次数，丢帧原因；也可逐条列出或只列出慢事件。
+ * 同一场景的现场轨迹与回放轨迹（--replay 同时加 --trace）分别汇总即可对比。
+ *
+ * 用法：
+ *   rkav_trace <trace>                 汇总
+ *   rkav_trace <trace> --slow <ms>     列出耗时不少于 ms 的事件（存储卡顿、编码超时）
+ *   rkav_trace <trace> --dump          逐条列出
+ */
+#include "timing_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** 汇总的最大路数（摄像头 / 麦克风序号） */
+#define MAX_STREAMS  8
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* 已排序数组的分位数 */
+static double pct(const uint32_t *v, size_t n, double p)
+{
+    if (n == 0) return 0.0;
+    size_t i = (size_t)(p * (double)(n - 1) + 0.5);
+    return (double)v[i];
+}
+
+static void print_event(const TimingEvent *e)
+{
+    printf("%12.3fms %-8s %u flags=0x%04x bytes=%-8u dur=%.3fms\n", (double)e->t_us / 1000.0,
+           timing_ev_name((TimingEv)e->ev), e->stream, e->flags, e->bytes, (double)e->dur_us / 1000.0);
+}
+
+/* 一类事件（一路）的汇总：耗时分位数；到达类事件另给间隔分布与迟到次数 */
+static void summarize(const TimingReplay *r, TimingEv ev, int stream, double period_us,
+                      uint32_t *dur, uint32_t *gap)
+{
+    size_t n = 0, ng = 0, late = 0;
+    uint64_t bytes = 0, flagged = 0, key = 0;
+    uint64_t prev = 0;
+
+    for (size_t i = 0; i < r->n; i++) {
+        const TimingEvent *e = &r->ev[i];
+        if (e->ev != ev || e->stream != stream) continue;
+        dur[n++] = e->dur_us;
+        bytes += e->bytes;
+        flagged += ev == TT_EV_CAPTURE ? e->flags : (e->flags & TT_F_ERR ? 1 : 0);
+        if (e->flags & TT_F_KEY && ev != TT_EV_CAPTURE) key++;
+        if (n > 1) {
+            uint64_t d = e->t_us > prev ? e->t_us - prev : 0;
+            gap[ng++] = d > UINT32_MAX ? UINT32_MAX : (uint32_t)d;
+            if (period_us > 0.0 && (double)d > period_us * 1.5) late++;
+        }
+        prev = e->t_us;
+    }
+    if (n == 0) return;
+
+    qsort(dur, n, sizeof(uint32_t), cmp_u32);
+    printf("%-8s %u  n=%-7zu avg=%-8.0fB dur p50=%.3f p99=%.3f max=%.3fms",
+           timing_ev_name(ev), stream, n, (double)bytes / (double)n,
+           pct(dur, n, 0.5) / 1000.0, pct(dur, n, 0.99) / 1000.0, (double)dur[n - 1] / 1000.0);
+    if (ev == TT_EV_CAPTURE)
+        printf(" driver_drops=%llu", (unsigned long long)flagged);
+    else if (flagged)
+        printf(" errors=%llu", (unsigned long long)flagged);
+    if (ev == TT_EV_ENCODE || ev == TT_EV_WRITE)
+        printf(" key=%llu", (unsigned long long)key);
+    printf("\n");
+
+    if (ng && (ev == TT_EV_CAPTURE || ev == TT_EV_AUDIO)) {
+        qsort(gap, ng, sizeof(uint32_t), cmp_u32);
+        printf("           interval p50=%.3f p99=%.3f max=%.3fms late(>1.5x)=%zu\n",
+               pct(gap, ng, 0.5) / 1000.0, pct(gap, ng, 0.99) / 1000.0,
+               (double)gap[ng - 1] / 1000.0, late);
+    }
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "Usage:\n"
+        "  %s <trace>                 按环节汇总\n"
+        "  %s <trace> --slow <ms>     列出耗时不少于 ms 的事件\n"
+        "  %s <trace> --dump          逐条列出\n"
+        "Exit: 0 成功, 2 参数或 I/O 错误\n", prog, prog, prog);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    int dump = 0;
+    double slow_ms = -1.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dump") == 0) { dump = 1; continue; }
+        if (strcmp(argv[i], "--slow") == 0 && i + 1 < argc) { slow_ms = atof(argv[++i]); continue; }
+        if (argv[i][0] == '-' || path) { usage(argv[0]); return 2; }
+        path = argv[i];
+    }
+    if (!path) { usage(argv[0]); return 2; }
+
+    TimingReplay r;
+    if (timing_replay_load(&r, path) != 0) return 2;
+
+    if (dump || slow_ms >= 0.0) {
+        for (size_t i = 0; i < r.n; i++) {
+            if (slow_ms >= 0.0 && (double)r.ev[i].dur_us < slow_ms * 1000.0) continue;
+            print_event(&r.ev[i]);
+        }
+        timing_replay_free(&r);
+        return 0;
+    }
+
+    uint32_t *dur = (uint32_t *)malloc((r.n ? r.n : 1) * sizeof(uint32_t));
+    uint32_t *gap = (uint32_t *)malloc((r.n ? r.n : 1) * sizeof(uint32_t));
+    if (!dur || !gap) {
+        fprintf(stderr, "out of memory\n");
+        free(dur);
+        free(gap);
+        timing_replay_free(&r);
+        return 2;
+    }
+
+    const TimingTraceHeader *h = &r.hdr;
+    printf("trace %s: %ux%u@%u %ubps, audio %uHz ch=%u fmt=%u, cams=%u mics=%u, %.1fs, %zu events, %llu lost\n",
+           path, h->width, h->height, h->fps, h->bitrate, h->sample_rate, h->channels, h->sample_fmt,
+           h->cams, h->mics, (double)r.span_us / 1e6, r.n, (unsigned long long)h->lost);
+
+    double vperiod = h->fps ? 1e6 / (double)h->fps : 0.0;
+    for (int s = 0; s < MAX_STREAMS; s++)
+        summarize(&r, TT_EV_CAPTURE, s, vperiod, dur, gap);
+    for (int s = 0; s < MAX_STREAMS; s++) {
+        size_t qfull = 0, nomem = 0;
+        for (size_t i = 0; i < r.n; i++) {
+            if (r.ev[i].ev != TT_EV_DROP || r.ev[i].stream != s) continue;
+            if (r.ev[i].flags == TT_DROP_QFULL) qfull++;
+            else nomem++;
+        }
+        if (qfull || nomem)
+            printf("drop     %d  queue_full=%zu nomem=%zu\n", s, qfull, nomem);
+    }
+    summarize(&r, TT_EV_ENCODE, 0, 0.0, dur, gap);
+    summarize(&r, TT_EV_WRITE, 0, 0.0, dur, gap);
+
+    /* 音频块周期按首路的平均间隔估计（period 由驱动协商，轨迹里不记录） */
+    for (int s = 0; s < MAX_STREAMS; s++) {
+        size_t n = timing_replay_count(&r, TT_EV_AUDIO, s);
+        double aperiod = 0.0;
+        if (n > 1) {
+            uint64_t first = 0, last = 0;
+            int seen = 0;
+            for (size_t i = 0; i < r.n; i++) {
+                if (r.ev[i].ev != TT_EV_AUDIO || r.ev[i].stream != s) continue;
+                if (!seen++) first = r.ev[i].t_us;
+                last = r.ev[i].t_us;
+            }
+            aperiod = (double)(last - first) / (double)(n - 1);
+        }
+        summarize(&r, TT_EV_AUDIO, s, aperiod, dur, gap);
+    }
+    summarize(&r, TT_EV_AWRITE, 0, 0.0, dur, gap);
+
+    free(dur);
+    free(gap);
+    timing_replay_free(&r);
+    return 0;
+}